@@ -0,0 +1,54 @@
+/*
+ * bench_common.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Helpers shared by the tools of bench/, they're header only, every tool is one translation unit.
+ */
+
+static inline uint64_t bench_random(uint64_t* state)
+{
+    // Note: xorshift64*, same as the benches of ut
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static inline int bench_compare_latency(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ *  @brief bench_print_latency    prints "latency_ns" of sorted samples as a JSON member.
+ */
+static inline void bench_print_latency(const uint32_t* sorted_ns, long count, double sum_ns)
+{
+    if (count == 0) {
+        printf("\"latency_ns\": null");
+        return;
+    }
+    printf("\"latency_ns\": {\"mean\": %.1f, \"p50\": %u, \"p99\": %u, \"p999\": %u, \"max\": %u}",
+            sum_ns / count, sorted_ns[count / 2], sorted_ns[count * 99 / 100],
+            sorted_ns[count * 999 / 1000], sorted_ns[count - 1]);
+}
+
+#endif /* BENCH_COMMON_H_ */
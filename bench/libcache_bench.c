@@ -0,0 +1,556 @@
+/*
+ * libcache_bench.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+// Note: perf_event_open, pthread_barrier_t and getopt are not in C99
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "libcache.h"
+#include "libcache_sharded.h"
+#include "bench_common.h"
+
+/*
+ * Microbenchmark of libcache, one run is one workload, results are printed as one JSON object:
+ *   libcache_bench -w mixed -d zipf -n 1000000 -r 0.8 -t 4 -o 2000000 -p -l $(git rev-parse --short HEAD)
+ * Keys are generated before timing, every operation is timed by clock_gettime, the timer itself
+ * (about 20ns) is measured and reported as timer_ns, it isn't subtracted.
+ */
+
+typedef enum {
+    BENCH_LOOKUP = 0,  /* copy out entries of a preloaded cache */
+    BENCH_ADD,         /* add keys, swaps out when full */
+    BENCH_DELETE,      /* delete keys of a preloaded cache, a deleted key is added back untimed */
+    BENCH_MIXED,       /* lookup, add on miss */
+    BENCH_UPSERT,      /* same as mixed by one lookup_or_add, the entry is written in place and unlocked */
+} bench_workload_e;
+
+typedef enum {
+    BENCH_UNIFORM = 0,
+    BENCH_ZIPF,        /* rank 0 is the hottest key */
+    BENCH_SCAN,        /* every thread walks the key space from its own offset */
+} bench_distribution_e;
+
+static const char* const bench_workload_name[] = { "lookup", "add", "delete", "mixed", "upsert" };
+static const char* const bench_distribution_name[] = { "uniform", "zipf", "scan" };
+static const char* const bench_index_name[] = { "chained", "open", "group", "compact" };
+static const char* const bench_hash_name[] = { "callback", "wy", "crc32c" };
+
+typedef struct bench_config_t {
+    bench_workload_e workload;
+    bench_distribution_e distribution;
+    libcache_scale_t entries;
+    double hit_ratio;        /* preloaded entries / key space, the real ratio of zipf is higher */
+    int threads;
+    long ops;                /* timed operations per thread */
+    long warmup;             /* untimed operations per thread before timing */
+    size_t entry_size;
+    double zipf_s;
+    libcache_engine_e engine;
+    libcache_index_e index_type;
+    libcache_hash_e hash;    /* LIBCACHE_HASH_DEFAULT: bench_key_to_number */
+    int bytewise;            /* no cmp_key, keys are compared by the built-in 8-byte compare */
+    int combining;           /* writes of the sharded cache are flat combined, see libcache_attr_t.combining */
+    int perf;
+    const char* label;       /* e.g. commit id, copied to the result */
+} bench_config_t;
+
+typedef struct bench_key_t {
+    uint64_t id;
+} bench_key_t;
+
+/*
+ * One cache interface for both the plain cache (1 thread) and the sharded cache (threads).
+ */
+typedef struct bench_cache_ops_t {
+    void* (*lookup)(void* cache, const void* key, void* dst_entry);
+    void* (*add)(void* cache, const void* key, const void* src_entry);
+    libcache_ret_t (*delete_by_key)(void* cache, const void* key);
+    libcache_ret_t (*destroy)(void* cache);
+    void* (*lookup_or_add)(void* cache, const void* key, int* inserted);
+    libcache_ret_t (*unlock_entry)(void* cache, void* entry);
+} bench_cache_ops_t;
+
+static const bench_cache_ops_t bench_plain_ops = {
+    libcache_lookup, libcache_add, libcache_delete_by_key, libcache_destroy,
+    libcache_lookup_or_add, libcache_unlock_entry
+};
+
+static const bench_cache_ops_t bench_sharded_ops = {
+    libcache_sharded_lookup, libcache_sharded_add, libcache_sharded_delete_by_key, libcache_sharded_destroy,
+    libcache_sharded_lookup_or_add, libcache_sharded_unlock_entry
+};
+
+typedef struct bench_thread_t {
+    const bench_config_t* config;
+    const bench_cache_ops_t* ops;
+    void* cache;
+    pthread_barrier_t* barrier;
+    uint64_t* keys;          /* warmup + ops keys */
+    uint32_t* latency_ns;    /* one sample per timed operation */
+    long hits;
+    pthread_t thread;
+} bench_thread_t;
+
+static libcache_cmp_ret_t bench_key_cmp(const void* key1, const void* key2)
+{
+    return (((const bench_key_t*) key1)->id == ((const bench_key_t*) key2)->id) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+}
+
+static libcache_scale_t bench_key_to_number(const void* key)
+{
+    uint64_t id = ((const bench_key_t*) key)->id;
+    return (libcache_scale_t) (id ^ (id >> 32));
+}
+
+/*
+ *  @brief bench_zipf_cdf    builds the cumulative distribution of zipf over key_space ranks.
+ */
+static double* bench_zipf_cdf(uint64_t key_space, double s)
+{
+    double* cdf = (double*) malloc(sizeof(double) * key_space);
+    if (NULL == cdf) {
+        return NULL;
+    }
+    double sum = 0;
+    uint64_t i;
+    for (i = 0; i < key_space; i++) {
+        sum += 1.0 / pow((double) (i + 1), s);
+        cdf[i] = sum;
+    }
+    for (i = 0; i < key_space; i++) {
+        cdf[i] /= sum;
+    }
+    return cdf;
+}
+
+static uint64_t bench_zipf_key(const double* cdf, uint64_t key_space, uint64_t* state)
+{
+    double u = (bench_random(state) >> 11) * (1.0 / 9007199254740992.0);
+    uint64_t low = 0;
+    uint64_t high = key_space - 1;
+    while (low < high) {
+        uint64_t middle = (low + high) / 2;
+        if (cdf[middle] < u) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void bench_generate_keys(const bench_config_t* config, const double* cdf, uint64_t key_space,
+        int thread_index, uint64_t* keys, long count)
+{
+    uint64_t state = 0x2545F4914F6CDD1DULL + (uint64_t) thread_index * 0x9E3779B97F4A7C15ULL;
+    uint64_t scan_key = key_space / config->threads * thread_index;
+    long i;
+    for (i = 0; i < count; i++) {
+        switch (config->distribution) {
+        case BENCH_ZIPF:
+            keys[i] = bench_zipf_key(cdf, key_space, &state);
+            break;
+        case BENCH_SCAN:
+            keys[i] = scan_key++ % key_space;
+            break;
+        default:
+            keys[i] = bench_random(&state) % key_space;
+            break;
+        }
+    }
+}
+
+/*
+ *  @brief bench_operate    runs one operation of the workload.
+ *  @return TRUE            it's a hit (lookup found, add added, delete deleted).
+ */
+static inline int bench_operate(bench_thread_t* worker, uint64_t id, void* entry, uint64_t* latency_ns)
+{
+    bench_key_t key = { id };
+    void* cache = worker->cache;
+    int hit = FALSE;
+    uint64_t start = bench_now_ns();
+    switch (worker->config->workload) {
+    case BENCH_LOOKUP:
+        hit = (worker->ops->lookup(cache, &key, entry) != NULL);
+        break;
+    case BENCH_ADD:
+        hit = (worker->ops->add(cache, &key, entry) != NULL);
+        break;
+    case BENCH_DELETE:
+        hit = (worker->ops->delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+        break;
+    case BENCH_MIXED:
+        hit = (worker->ops->lookup(cache, &key, entry) != NULL);
+        if (!hit) {
+            worker->ops->add(cache, &key, entry);
+        }
+        break;
+    case BENCH_UPSERT: {
+        int inserted = FALSE;
+        void* found = worker->ops->lookup_or_add(cache, &key, &inserted);
+        if (NULL != found) {
+            if (inserted) {
+                memcpy(found, entry, worker->config->entry_size);
+            }
+            worker->ops->unlock_entry(cache, found);
+        }
+        hit = (NULL != found && !inserted);
+        break;
+    }
+    }
+    *latency_ns = bench_now_ns() - start;
+
+    // Note: the key space of delete stays preloaded
+    if (worker->config->workload == BENCH_DELETE && hit) {
+        worker->ops->add(cache, &key, entry);
+    }
+    return hit;
+}
+
+static void* bench_worker(void* arg)
+{
+    bench_thread_t* worker = (bench_thread_t*) arg;
+    const bench_config_t* config = worker->config;
+    void* entry = calloc(1, config->entry_size);
+    uint64_t latency_ns = 0;
+    long i;
+    for (i = 0; i < config->warmup; i++) {
+        bench_operate(worker, worker->keys[i], entry, &latency_ns);
+    }
+
+    // Note: the main thread starts the clock and counters between the two barriers
+    pthread_barrier_wait(worker->barrier);
+    pthread_barrier_wait(worker->barrier);
+    const uint64_t* keys = worker->keys + config->warmup;
+    for (i = 0; i < config->ops; i++) {
+        worker->hits += bench_operate(worker, keys[i], entry, &latency_ns);
+        worker->latency_ns[i] = (latency_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t) latency_ns;
+    }
+    free(entry);
+    return NULL;
+}
+
+/*
+ * Perf counters of the process, threads created after they're opened are counted too.
+ */
+typedef struct bench_perf_t {
+    int cache_misses_fd;
+    int dtlb_misses_fd;
+} bench_perf_t;
+
+static int bench_perf_open(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void bench_perf_init(bench_perf_t* perf, int enabled)
+{
+    perf->cache_misses_fd = -1;
+    perf->dtlb_misses_fd = -1;
+    if (!enabled) {
+        return;
+    }
+    perf->cache_misses_fd = bench_perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    perf->dtlb_misses_fd = bench_perf_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+}
+
+static void bench_perf_control(const bench_perf_t* perf, unsigned long request)
+{
+    if (perf->cache_misses_fd >= 0) {
+        ioctl(perf->cache_misses_fd, request, 0);
+    }
+    if (perf->dtlb_misses_fd >= 0) {
+        ioctl(perf->dtlb_misses_fd, request, 0);
+    }
+}
+
+// Note: prints null if the counter can't be opened, e.g. perf_event_paranoid or no PMU in a VM
+static void bench_perf_print(const char* name, int fd, long total_ops, const char* separator)
+{
+    uint64_t count = 0;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+        printf("\"%s\": null%s", name, separator);
+    } else {
+        printf("\"%s\": %.4f%s", name, (double) count / total_ops, separator);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+static void* bench_create_cache(const bench_config_t* config)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = config->entries;
+    attr.entry_size = config->entry_size;
+    attr.key_size = sizeof(bench_key_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = config->bytewise ? NULL : bench_key_cmp;
+    attr.key_to_number = bench_key_to_number;
+    attr.engine = config->engine;
+    attr.index_type = config->index_type;
+    attr.hash = config->hash;
+    attr.combining = config->combining;
+    if (config->threads > 1) {
+        return libcache_sharded_create(&attr, (uint32_t) config->threads * 4);
+    }
+    return libcache_create_ex(&attr);
+}
+
+static void bench_usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-w lookup|add|delete|mixed|upsert] [-d uniform|zipf|scan] [-n entries] [-r hit_ratio]\n"
+            "          [-t threads] [-o ops_per_thread] [-W warmup_per_thread] [-v entry_size] [-s zipf_s]\n"
+            "          [-e pool|compact] [-i chained|open|group|compact] [-H callback|wy|crc32c] [-C] [-F] [-p]\n"
+            "          [-l label]\n", name);
+}
+
+static int bench_parse_name(const char* value, const char* const names[], int count)
+{
+    int i;
+    for (i = 0; i < count; i++) {
+        if (strcmp(value, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int bench_parse(int argc, char* argv[], bench_config_t* config)
+{
+    config->workload = BENCH_MIXED;
+    config->distribution = BENCH_ZIPF;
+    config->entries = 1000000;
+    config->hit_ratio = 0.5;
+    config->threads = 1;
+    config->ops = 2000000;
+    config->warmup = 200000;
+    config->entry_size = 64;
+    config->zipf_s = 0.99;
+    config->engine = LIBCACHE_ENGINE_POOL;
+    config->index_type = LIBCACHE_INDEX_CHAINED;
+    config->hash = LIBCACHE_HASH_DEFAULT;
+    config->bytewise = FALSE;
+    config->combining = FALSE;
+    config->perf = FALSE;
+    config->label = "";
+
+    int option;
+    int value;
+    while ((option = getopt(argc, argv, "w:d:n:r:t:o:W:v:s:e:i:H:CFpl:h")) != -1) {
+        switch (option) {
+        case 'w':
+            if ((value = bench_parse_name(optarg, bench_workload_name, 5)) < 0) {
+                return FALSE;
+            }
+            config->workload = (bench_workload_e) value;
+            break;
+        case 'd':
+            if ((value = bench_parse_name(optarg, bench_distribution_name, 3)) < 0) {
+                return FALSE;
+            }
+            config->distribution = (bench_distribution_e) value;
+            break;
+        case 'n':
+            config->entries = (libcache_scale_t) strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            config->hit_ratio = atof(optarg);
+            break;
+        case 't':
+            config->threads = atoi(optarg);
+            break;
+        case 'o':
+            config->ops = atol(optarg);
+            break;
+        case 'W':
+            config->warmup = atol(optarg);
+            break;
+        case 'v':
+            config->entry_size = (size_t) atol(optarg);
+            break;
+        case 's':
+            config->zipf_s = atof(optarg);
+            break;
+        case 'e':
+            if (strcmp(optarg, "pool") == 0) {
+                config->engine = LIBCACHE_ENGINE_POOL;
+            } else if (strcmp(optarg, "compact") == 0) {
+                config->engine = LIBCACHE_ENGINE_COMPACT;
+            } else {
+                return FALSE;
+            }
+            break;
+        case 'i':
+            if ((value = bench_parse_name(optarg, bench_index_name, 4)) < 0) {
+                return FALSE;
+            }
+            config->index_type = (libcache_index_e) value;
+            break;
+        case 'H':
+            if ((value = bench_parse_name(optarg, bench_hash_name, 3)) < 0) {
+                return FALSE;
+            }
+            config->hash = (libcache_hash_e) value;
+            break;
+        case 'C':
+            config->bytewise = TRUE;
+            break;
+        case 'F':
+            config->combining = TRUE;
+            break;
+        case 'p':
+            config->perf = TRUE;
+            break;
+        case 'l':
+            config->label = optarg;
+            break;
+        default:
+            return FALSE;
+        }
+    }
+    return config->entries > 0 && config->hit_ratio > 0 && config->hit_ratio <= 1 && config->threads > 0
+            && config->ops > 0 && config->warmup >= 0 && config->entry_size > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    bench_config_t config;
+    if (!bench_parse(argc, argv, &config)) {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t key_space = (uint64_t) (config.entries / config.hit_ratio);
+    double* cdf = NULL;
+    if (config.distribution == BENCH_ZIPF && NULL == (cdf = bench_zipf_cdf(key_space, config.zipf_s))) {
+        fprintf(stderr, "failed to build zipf table of %llu keys\n", (unsigned long long) key_space);
+        return 1;
+    }
+
+    void* cache = bench_create_cache(&config);
+    if (NULL == cache) {
+        fprintf(stderr, "failed to create cache\n");
+        return 1;
+    }
+    const bench_cache_ops_t* ops = (config.threads > 1) ? &bench_sharded_ops : &bench_plain_ops;
+
+    // Note: hot ranks of zipf are preloaded, add starts from an empty cache
+    void* entry = calloc(1, config.entry_size);
+    uint64_t id;
+    for (id = 0; config.workload != BENCH_ADD && id < config.entries; id++) {
+        bench_key_t key = { id };
+        ops->add(cache, &key, entry);
+    }
+    free(entry);
+
+    bench_thread_t* workers = (bench_thread_t*) calloc(config.threads, sizeof(bench_thread_t));
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, config.threads + 1);
+    int t;
+    for (t = 0; t < config.threads; t++) {
+        workers[t].config = &config;
+        workers[t].ops = ops;
+        workers[t].cache = cache;
+        workers[t].barrier = &barrier;
+        workers[t].keys = (uint64_t*) malloc(sizeof(uint64_t) * (config.warmup + config.ops));
+        workers[t].latency_ns = (uint32_t*) malloc(sizeof(uint32_t) * config.ops);
+        if (NULL == workers[t].keys || NULL == workers[t].latency_ns) {
+            fprintf(stderr, "failed to allocate %ld keys\n", config.warmup + config.ops);
+            return 1;
+        }
+        bench_generate_keys(&config, cdf, key_space, t, workers[t].keys, config.warmup + config.ops);
+    }
+    free(cdf);
+
+    bench_perf_t perf;
+    bench_perf_init(&perf, config.perf);
+    for (t = 0; t < config.threads; t++) {
+        pthread_create(&workers[t].thread, NULL, bench_worker, &workers[t]);
+    }
+    pthread_barrier_wait(&barrier);
+    bench_perf_control(&perf, PERF_EVENT_IOC_RESET);
+    bench_perf_control(&perf, PERF_EVENT_IOC_ENABLE);
+    uint64_t start = bench_now_ns();
+    pthread_barrier_wait(&barrier);
+    for (t = 0; t < config.threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+    }
+    uint64_t elapsed_ns = bench_now_ns() - start;
+    bench_perf_control(&perf, PERF_EVENT_IOC_DISABLE);
+
+    // Note: all samples are merged, so percentiles are of every operation of every thread
+    long total_ops = config.ops * config.threads;
+    uint32_t* latency_ns = (uint32_t*) malloc(sizeof(uint32_t) * total_ops);
+    long hits = 0;
+    double sum_ns = 0;
+    long i;
+    for (t = 0; t < config.threads; t++) {
+        memcpy(latency_ns + t * config.ops, workers[t].latency_ns, sizeof(uint32_t) * config.ops);
+        hits += workers[t].hits;
+        free(workers[t].keys);
+        free(workers[t].latency_ns);
+    }
+    for (i = 0; i < total_ops; i++) {
+        sum_ns += latency_ns[i];
+    }
+    qsort(latency_ns, total_ops, sizeof(uint32_t), bench_compare_latency);
+
+    uint64_t timer_start = bench_now_ns();
+    for (i = 0; i < 1000; i++) {
+        bench_now_ns();
+    }
+    double timer_ns = (bench_now_ns() - timer_start) / 1000.0;
+
+    printf("{\"label\": \"%s\", \"workload\": \"%s\", \"distribution\": \"%s\", \"engine\": \"%s\", ",
+            config.label, bench_workload_name[config.workload], bench_distribution_name[config.distribution],
+            (config.engine == LIBCACHE_ENGINE_COMPACT) ? "compact" : "pool");
+    printf("\"index\": \"%s\", \"hash\": \"%s\", \"cmp\": \"%s\", \"combining\": %s, ",
+            bench_index_name[config.index_type], bench_hash_name[config.hash],
+            config.bytewise ? "bytes" : "callback", config.combining ? "true" : "false");
+    printf("\"entries\": %u, \"entry_size\": %zu, \"key_space\": %llu, \"threads\": %d, \"ops\": %ld, ",
+            (unsigned) config.entries, config.entry_size, (unsigned long long) key_space, config.threads, total_ops);
+    printf("\"throughput_ops\": %.0f, \"hit_ratio\": %.4f, \"timer_ns\": %.1f, ",
+            total_ops * 1e9 / elapsed_ns, (double) hits / total_ops, timer_ns);
+    bench_print_latency(latency_ns, total_ops, sum_ns);
+    printf(", \"perf\": ");
+    if (config.perf) {
+        printf("{");
+        bench_perf_print("cache_misses_per_op", perf.cache_misses_fd, total_ops, ", ");
+        bench_perf_print("dtlb_misses_per_op", perf.dtlb_misses_fd, total_ops, "");
+        printf("}}\n");
+    } else {
+        printf("null}\n");
+    }
+
+    free(latency_ns);
+    free(workers);
+    pthread_barrier_destroy(&barrier);
+    ops->destroy(cache);
+    return 0;
+}
@@ -0,0 +1,545 @@
+/*
+ * libcache_replay.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+// Note: getopt is not in C99
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "libcache.h"
+#include "libcache_policy.h"
+#include "bench_common.h"
+#include "libcache_trace.h"
+
+/*
+ * Replays an attach/detach trace (see libcache_trace.h) offline, results are printed as one JSON object:
+ *   libcache_replay -i attach.trace -c 100000,200000,400000 -P lru -R 0.01
+ * - "mrc": LRU hit ratio versus cache size of the whole trace in one pass, by Mattson stack distance,
+ *   keys are spatially sampled (SHARDS) with rate -R, 1 means exact.
+ * - "replay": the trace replayed against libcache of every -c size with the -P policy, hit ratio,
+ *   evictions and latency of every operation.
+ * A synthetic trace can be generated for trying it out:
+ *   libcache_replay -g attach.trace -o 2000000 -k 500000
+ */
+
+#define REPLAY_MAX_SIZES 32
+#define REPLAY_SAMPLE_BITS 24
+#define REPLAY_NO_TIME UINT32_MAX
+
+typedef struct replay_config_t {
+    const char* input;
+    const char* generate;
+    long generate_ops;
+    uint64_t generate_keys;
+    double zipf_s;
+    double detach_ratio;     /* of generated records */
+    libcache_scale_t sizes[REPLAY_MAX_SIZES];
+    int size_count;
+    libcache_policy_e policy;
+    libcache_engine_e engine;
+    size_t entry_size;
+    double sample_rate;
+    const char* label;
+} replay_config_t;
+
+static libcache_cmp_ret_t replay_key_cmp(const void* key1, const void* key2)
+{
+    // Note: same as cmp_key_imp of ut/libcache_test.cc, only the IMSI is the key
+    if (((const cache_key_t*) key1)->imsi.val.imsi64bit == ((const cache_key_t*) key2)->imsi.val.imsi64bit) {
+        return LIBCACHE_EQU;
+    }
+    return LIBCACHE_NOT_EQU;
+}
+
+static libcache_scale_t replay_key_to_number(const void* key)
+{
+    uint64_t init_num = 0xE28D709B;
+    uint64_t imsi = ((const cache_key_t*) key)->imsi.val.imsi64bit;
+    init_num ^= (imsi ^ (imsi >> 32));
+    return (libcache_scale_t) init_num;
+}
+
+static uint64_t replay_mix(uint64_t x)
+{
+    // Note: splitmix64 finalizer, IMSIs are dense, sampling needs all bits mixed
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+ * Last access time of every sampled key, open addressing, it never shrinks,
+ * a detached key keeps its slot with REPLAY_NO_TIME.
+ */
+typedef struct replay_map_t {
+    uint64_t* keys;
+    uint32_t* times;
+    uint8_t* used;
+    uint64_t mask;
+    uint64_t count;
+} replay_map_t;
+
+static int replay_map_init(replay_map_t* map, uint64_t max_keys)
+{
+    uint64_t capacity = 16;
+    while (capacity < max_keys * 2) {
+        capacity <<= 1;
+    }
+    map->keys = (uint64_t*) malloc(sizeof(uint64_t) * capacity);
+    map->times = (uint32_t*) malloc(sizeof(uint32_t) * capacity);
+    map->used = (uint8_t*) calloc(capacity, sizeof(uint8_t));
+    map->mask = capacity - 1;
+    map->count = 0;
+    return NULL != map->keys && NULL != map->times && NULL != map->used;
+}
+
+static void replay_map_destroy(replay_map_t* map)
+{
+    free(map->keys);
+    free(map->times);
+    free(map->used);
+}
+
+/*
+ *  @brief replay_map_get    gets the last access time of a key, a new key is inserted with REPLAY_NO_TIME.
+ */
+static uint32_t* replay_map_get(replay_map_t* map, uint64_t key)
+{
+    uint64_t slot = replay_mix(key) & map->mask;
+    while (map->used[slot]) {
+        if (map->keys[slot] == key) {
+            return &map->times[slot];
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    map->used[slot] = TRUE;
+    map->keys[slot] = key;
+    map->times[slot] = REPLAY_NO_TIME;
+    map->count++;
+    return &map->times[slot];
+}
+
+/*
+ * Fenwick tree over access times, a time is 1 while it's the last access of a live key,
+ * the stack distance of an access is the number of 1s after the previous access of its key.
+ */
+typedef struct replay_fenwick_t {
+    int32_t* tree;
+    uint32_t length;
+} replay_fenwick_t;
+
+static void replay_fenwick_add(replay_fenwick_t* fenwick, uint32_t time, int32_t delta)
+{
+    uint32_t i;
+    for (i = time + 1; i <= fenwick->length; i += i & (~i + 1)) {
+        fenwick->tree[i - 1] += delta;
+    }
+}
+
+// Note: sum of times [0, time)
+static int64_t replay_fenwick_prefix(const replay_fenwick_t* fenwick, uint32_t time)
+{
+    int64_t sum = 0;
+    uint32_t i;
+    for (i = time; i > 0; i -= i & (~i + 1)) {
+        sum += fenwick->tree[i - 1];
+    }
+    return sum;
+}
+
+static int replay_compare_scale(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+static inline int replay_sampled(uint64_t imsi, uint64_t threshold)
+{
+    return (replay_mix(imsi) & ((1ULL << REPLAY_SAMPLE_BITS) - 1)) < threshold;
+}
+
+/*
+ *  @brief replay_mrc    prints "mrc" and the estimated distinct keys of the trace, LRU only.
+ *  NOTE:  A sampled key stands for 1 / sample_rate keys, so a sampled distance d is a distance
+ *         of d / sample_rate keys, a cache of size C hits it if d < C * sample_rate.
+ */
+static int replay_mrc(const replay_config_t* config, const libcache_trace_record_t* records, long count)
+{
+    uint64_t threshold = (uint64_t) (config->sample_rate * (1ULL << REPLAY_SAMPLE_BITS));
+    long i;
+    uint32_t sampled_attaches = 0;
+    long sampled_records = 0;
+    for (i = 0; i < count; i++) {
+        if (replay_sampled(trace_record_imsi(&records[i]), threshold)) {
+            sampled_records++;
+            sampled_attaches += (records[i].op == TRACE_OP_ATTACH);
+        }
+    }
+
+    replay_map_t map;
+    replay_fenwick_t fenwick;
+    fenwick.length = sampled_attaches;
+    fenwick.tree = (int32_t*) calloc(sampled_attaches + 1, sizeof(int32_t));
+    uint32_t* distances = (uint32_t*) malloc(sizeof(uint32_t) * (sampled_attaches + 1));
+    if (!replay_map_init(&map, sampled_records) || NULL == fenwick.tree || NULL == distances) {
+        fprintf(stderr, "failed to allocate stack distance of %ld records\n", sampled_records);
+        return FALSE;
+    }
+
+    // Note: a first access and an access after detach are cold misses, they have no distance
+    uint32_t now = 0;
+    uint32_t reuse = 0;
+    for (i = 0; i < count; i++) {
+        uint64_t imsi = trace_record_imsi(&records[i]);
+        if (!replay_sampled(imsi, threshold)) {
+            continue;
+        }
+        uint32_t* last = replay_map_get(&map, imsi);
+        if (*last != REPLAY_NO_TIME) {
+            if (records[i].op == TRACE_OP_ATTACH) {
+                distances[reuse++] = (uint32_t) (replay_fenwick_prefix(&fenwick, now)
+                        - replay_fenwick_prefix(&fenwick, *last + 1));
+            }
+            replay_fenwick_add(&fenwick, *last, -1);
+            *last = REPLAY_NO_TIME;
+        }
+        if (records[i].op == TRACE_OP_ATTACH) {
+            replay_fenwick_add(&fenwick, now, 1);
+            *last = now++;
+        }
+    }
+    qsort(distances, reuse, sizeof(uint32_t), replay_compare_scale);
+
+    // Note: powers of 2 up to the distinct keys and the sizes asked for
+    uint64_t distinct = (uint64_t) (map.count / config->sample_rate);
+    uint32_t points[64 + REPLAY_MAX_SIZES];
+    int point_count = 0;
+    uint64_t size;
+    for (size = 1; size < distinct * 2 && point_count < 64; size <<= 1) {
+        points[point_count++] = (uint32_t) size;
+    }
+    int k;
+    for (k = 0; k < config->size_count; k++) {
+        points[point_count++] = config->sizes[k];
+    }
+    qsort(points, point_count, sizeof(uint32_t), replay_compare_scale);
+
+    printf("\"sample_rate\": %.6f, \"distinct_keys\": %llu, \"mrc_policy\": \"lru\", \"mrc\": [",
+            config->sample_rate, (unsigned long long) distinct);
+    uint32_t hits = 0;
+    for (k = 0; k < point_count; k++) {
+        if (k > 0 && points[k] == points[k - 1]) {
+            continue;
+        }
+        double scaled = points[k] * config->sample_rate;
+        while (hits < reuse && distances[hits] < scaled) {
+            hits++;
+        }
+        printf("%s{\"size\": %u, \"hit_ratio\": %.4f}", (k > 0) ? ", " : "", points[k],
+                (sampled_attaches > 0) ? (double) hits / sampled_attaches : 0.0);
+    }
+    printf("], ");
+
+    free(distances);
+    free(fenwick.tree);
+    replay_map_destroy(&map);
+    return TRUE;
+}
+
+/*
+ *  @brief replay_run    replays the trace against a cache holding size entries, prints one "replay" element.
+ */
+static int replay_run(const replay_config_t* config, const libcache_trace_record_t* records, long count,
+        libcache_scale_t size)
+{
+    // Note: a cache holds one more entry than max_entry_number
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = (size > 0) ? size - 1 : 0;
+    attr.entry_size = config->entry_size;
+    attr.key_size = sizeof(cache_key_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = replay_key_cmp;
+    attr.key_to_number = replay_key_to_number;
+    attr.policy = config->policy;
+    attr.engine = config->engine;
+    void* cache = libcache_create_ex(&attr);
+    uint32_t* latency_ns = (uint32_t*) malloc(sizeof(uint32_t) * (count + 1));
+    void* entry = calloc(1, config->entry_size);
+    if (NULL == cache || NULL == latency_ns || NULL == entry) {
+        fprintf(stderr, "failed to create cache of %u entries\n", (unsigned) size);
+        return FALSE;
+    }
+
+    long attaches = 0;
+    long hits = 0;
+    long added = 0;
+    long deleted = 0;
+    double sum_ns = 0;
+    long i;
+    for (i = 0; i < count; i++) {
+        cache_key_t key;
+        trace_record_to_key(&records[i], &key);
+        uint64_t start = bench_now_ns();
+        if (records[i].op == TRACE_OP_ATTACH) {
+            attaches++;
+            if (libcache_lookup(cache, &key, entry) != NULL) {
+                hits++;
+            } else if (libcache_add(cache, &key, entry) != NULL) {
+                added++;
+            }
+        } else if (libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS) {
+            deleted++;
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        latency_ns[i] = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t) elapsed;
+        sum_ns += latency_ns[i];
+    }
+    qsort(latency_ns, count, sizeof(uint32_t), bench_compare_latency);
+
+    // Note: every entry added is either deleted, swapped out or still in the cache
+    long evictions = added - deleted - (long) libcache_get_entry_number(cache);
+    printf("{\"size\": %u, \"max_entry_number\": %u, \"policy\": \"%s\", \"engine\": \"%s\", "
+            "\"hit_ratio\": %.4f, \"evictions\": %ld, \"deletes\": %ld, ",
+            (unsigned) size, (unsigned) attr.max_entry_number, libcache_policy_get(config->policy)->name,
+            (config->engine == LIBCACHE_ENGINE_COMPACT) ? "compact" : "pool",
+            (attaches > 0) ? (double) hits / attaches : 0.0, evictions, deleted);
+    bench_print_latency(latency_ns, count, sum_ns);
+    printf("}");
+
+    free(entry);
+    free(latency_ns);
+    libcache_destroy(cache);
+    return TRUE;
+}
+
+/*
+ *  @brief replay_generate    writes a synthetic trace, zipf attaches, a detach is of a recently attached key.
+ */
+static int replay_generate(const replay_config_t* config)
+{
+    FILE* file = fopen(config->generate, "wb");
+    double* cdf = (double*) malloc(sizeof(double) * config->generate_keys);
+    if (NULL == file || NULL == cdf) {
+        fprintf(stderr, "failed to generate %s\n", config->generate);
+        return FALSE;
+    }
+    double sum = 0;
+    uint64_t i;
+    for (i = 0; i < config->generate_keys; i++) {
+        sum += 1.0 / pow((double) (i + 1), config->zipf_s);
+        cdf[i] = sum;
+    }
+
+    // Note: IMSIs of ranks are spread by a mix, so hot keys aren't adjacent numbers
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    uint64_t previous = 0;
+    long op;
+    for (op = 0; op < config->generate_ops; op++) {
+        libcache_trace_record_t record;
+        double u = (bench_random(&state) >> 11) * (1.0 / 9007199254740992.0);
+        if (op > 0 && u < config->detach_ratio) {
+            trace_record_init(&record, TRACE_OP_DETACH, previous, 0);
+        } else {
+            u = (bench_random(&state) >> 11) * (1.0 / 9007199254740992.0) * sum;
+            uint64_t low = 0;
+            uint64_t high = config->generate_keys - 1;
+            while (low < high) {
+                uint64_t middle = (low + high) / 2;
+                if (cdf[middle] < u) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            previous = 460000000000000ULL + replay_mix(low) % 1000000000ULL;
+            trace_record_init(&record, TRACE_OP_ATTACH, previous, (uint8_t) (low & 0x3));
+        }
+        if (fwrite(&record, sizeof(record), 1, file) != 1) {
+            fprintf(stderr, "failed to write %s\n", config->generate);
+            fclose(file);
+            free(cdf);
+            return FALSE;
+        }
+    }
+    fclose(file);
+    free(cdf);
+    return TRUE;
+}
+
+static libcache_trace_record_t* replay_load(const char* path, long* count)
+{
+    FILE* file = fopen(path, "rb");
+    if (NULL == file) {
+        fprintf(stderr, "failed to open %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *count = length / (long) sizeof(libcache_trace_record_t);
+    libcache_trace_record_t* records = (libcache_trace_record_t*) malloc(sizeof(libcache_trace_record_t)
+            * (*count + 1));
+    if (NULL == records || (long) fread(records, sizeof(libcache_trace_record_t), *count, file) != *count) {
+        fprintf(stderr, "failed to read %s\n", path);
+        free(records);
+        records = NULL;
+    }
+    fclose(file);
+    return records;
+}
+
+static void replay_usage(const char* name)
+{
+    fprintf(stderr, "usage: %s -i trace [-c size,size,...] [-P lru|clock|fifo|slru|tinylfu] [-e pool|compact]\n"
+            "          [-R sample_rate] [-v entry_size] [-l label]\n"
+            "       %s -g trace [-o records] [-k keys] [-s zipf_s] [-D detach_ratio]\n", name, name);
+}
+
+static int replay_parse_sizes(char* value, replay_config_t* config)
+{
+    char* token;
+    for (token = strtok(value, ","); token != NULL; token = strtok(NULL, ",")) {
+        if (config->size_count == REPLAY_MAX_SIZES) {
+            return FALSE;
+        }
+        config->sizes[config->size_count] = (libcache_scale_t) strtoul(token, NULL, 10);
+        if (config->sizes[config->size_count++] == 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static int replay_parse(int argc, char* argv[], replay_config_t* config)
+{
+    memset(config, 0, sizeof(*config));
+    config->generate_ops = 2000000;
+    config->generate_keys = 500000;
+    config->zipf_s = 0.8;
+    config->detach_ratio = 0.05;
+    config->policy = LIBCACHE_POLICY_LRU;
+    config->engine = LIBCACHE_ENGINE_POOL;
+    config->entry_size = 32;
+    config->sample_rate = 1.0;
+    config->label = "";
+
+    int option;
+    while ((option = getopt(argc, argv, "i:g:o:k:s:D:c:P:e:R:v:l:h")) != -1) {
+        int policy;
+        switch (option) {
+        case 'i':
+            config->input = optarg;
+            break;
+        case 'g':
+            config->generate = optarg;
+            break;
+        case 'o':
+            config->generate_ops = atol(optarg);
+            break;
+        case 'k':
+            config->generate_keys = strtoull(optarg, NULL, 10);
+            break;
+        case 's':
+            config->zipf_s = atof(optarg);
+            break;
+        case 'D':
+            config->detach_ratio = atof(optarg);
+            break;
+        case 'c':
+            if (!replay_parse_sizes(optarg, config)) {
+                return FALSE;
+            }
+            break;
+        case 'P':
+            for (policy = LIBCACHE_POLICY_LRU; policy <= LIBCACHE_POLICY_TINYLFU; policy++) {
+                if (strcmp(optarg, libcache_policy_get((libcache_policy_e) policy)->name) == 0) {
+                    break;
+                }
+            }
+            if (policy > LIBCACHE_POLICY_TINYLFU) {
+                return FALSE;
+            }
+            config->policy = (libcache_policy_e) policy;
+            break;
+        case 'e':
+            if (strcmp(optarg, "pool") == 0) {
+                config->engine = LIBCACHE_ENGINE_POOL;
+            } else if (strcmp(optarg, "compact") == 0) {
+                config->engine = LIBCACHE_ENGINE_COMPACT;
+            } else {
+                return FALSE;
+            }
+            break;
+        case 'R':
+            config->sample_rate = atof(optarg);
+            break;
+        case 'v':
+            config->entry_size = (size_t) atol(optarg);
+            break;
+        case 'l':
+            config->label = optarg;
+            break;
+        default:
+            return FALSE;
+        }
+    }
+    if (NULL != config->generate) {
+        return config->generate_ops > 0 && config->generate_keys > 0;
+    }
+    return NULL != config->input && config->sample_rate > 0 && config->sample_rate <= 1
+            && config->entry_size > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    replay_config_t config;
+    if (!replay_parse(argc, argv, &config)) {
+        replay_usage(argv[0]);
+        return 1;
+    }
+    if (NULL != config.generate) {
+        return replay_generate(&config) ? 0 : 1;
+    }
+
+    long count = 0;
+    libcache_trace_record_t* records = replay_load(config.input, &count);
+    if (NULL == records) {
+        return 1;
+    }
+    long detaches = 0;
+    long i;
+    for (i = 0; i < count; i++) {
+        detaches += (records[i].op == TRACE_OP_DETACH);
+    }
+
+    printf("{\"label\": \"%s\", \"trace\": \"%s\", \"records\": %ld, \"attaches\": %ld, \"detaches\": %ld, ",
+            config.label, config.input, count, count - detaches, detaches);
+    if (!replay_mrc(&config, records, count)) {
+        free(records);
+        return 1;
+    }
+    printf("\"replay\": [");
+    int k;
+    for (k = 0; k < config.size_count; k++) {
+        printf("%s", (k > 0) ? ", " : "");
+        if (!replay_run(&config, records, count, config.sizes[k])) {
+            free(records);
+            return 1;
+        }
+    }
+    printf("]}\n");
+    free(records);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * libcache_trace.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_TRACE_H_
+#define LIBCACHE_TRACE_H_
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Binary trace of GTP-C attach/detach requests, a file is an array of libcache_trace_record_t,
+ * fields are little endian, there is no file header.
+ * An attach looks up its IMSI and adds it on miss, a detach deletes it.
+ */
+#define TRACE_OP_ATTACH 0
+#define TRACE_OP_DETACH 1
+
+typedef struct libcache_trace_record_t {
+    uint8_t op;             /* TRACE_OP_ATTACH or TRACE_OP_DETACH */
+    uint8_t imsi_flags;     /* pres (bit 0), bogus (bit 1), len (bits 4-7), same as ng_imsi_t's */
+    uint8_t service_group;
+    uint8_t reserved[5];
+    uint8_t imsi[8];        /* imsi64bit of imsi_t */
+} libcache_trace_record_t;
+
+/*
+ * Key of the cache, same layout as cache_key_t of ut/libcache_test.cc.
+ */
+#define MAX_IMSI_LEN 8
+
+typedef union {
+    uint8_t  imsi[MAX_IMSI_LEN];
+    uint64_t imsi64bit;
+} imsi_t;
+
+typedef struct {
+#if BYTE_ORDER == LITTLE_ENDIAN
+    uint8_t      pres  : 1; /**< presence bit */
+    uint8_t      bogus : 1; /**< bogus IMSI, used only inside application (TRUE/FALSE) */
+    uint8_t      spare : 2; /**< spare bits for future use */
+    uint8_t      len   : 4; /**< length field, max len of IMSI is MAX_IMSI_LEN */
+#elif BYTE_ORDER == BIG_ENDIAN
+    uint8_t      len   : 4; /**< length field, max len of IMSI is MAX_IMSI_LEN */
+    uint8_t      spare : 2; /**< spare bits for future use */
+    uint8_t      bogus : 1; /**< bogus IMSI, used only inside application (TRUE/FALSE) */
+    uint8_t      pres  : 1; /**< presence bit */
+#endif
+    imsi_t  val;
+} ng_imsi_t;
+
+typedef struct {
+    ng_imsi_t imsi;
+    uint8_t service_group;
+} cache_key_t;
+
+static inline uint64_t trace_record_imsi(const libcache_trace_record_t* record)
+{
+    uint64_t imsi = 0;
+    int i;
+    for (i = MAX_IMSI_LEN - 1; i >= 0; i--) {
+        imsi = (imsi << 8) | record->imsi[i];
+    }
+    return imsi;
+}
+
+static inline void trace_record_init(libcache_trace_record_t* record, uint8_t op, uint64_t imsi, uint8_t service_group)
+{
+    memset(record, 0, sizeof(*record));
+    record->op = op;
+    record->imsi_flags = 0x01 | (MAX_IMSI_LEN << 4);
+    record->service_group = service_group;
+    int i;
+    for (i = 0; i < MAX_IMSI_LEN; i++) {
+        record->imsi[i] = (uint8_t) (imsi >> (8 * i));
+    }
+}
+
+static inline void trace_record_to_key(const libcache_trace_record_t* record, cache_key_t* key)
+{
+    memset(key, 0, sizeof(*key));
+    key->imsi.pres = record->imsi_flags & 0x01;
+    key->imsi.bogus = (record->imsi_flags >> 1) & 0x01;
+    key->imsi.len = record->imsi_flags >> 4;
+    key->imsi.val.imsi64bit = trace_record_imsi(record);
+    key->service_group = record->service_group;
+}
+
+#endif /* LIBCACHE_TRACE_H_ */
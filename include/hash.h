@@ -10,16 +10,32 @@
 
 #include "list.h"
 #include "libcache_def.h"
+#include "libcache_hash.h"
+#include "libcache_filter.h"
 
 #define u32  unsigned int
 
-#define HASH_BITS 16
 #define GOLDEN_RATIO_PRIME_32 0x9e370001UL
 #define HASH_BUCKETS 65536 //2^15 + 1
 
+/* chained: bucket array is the next power of 2 of max entry (load factor under 1),
+ * between 2^HASH_MIN_BUCKET_BITS and 2^HASH_MAX_BUCKET_BITS.
+ */
+#define HASH_MIN_BUCKET_BITS 4
+#define HASH_MAX_BUCKET_BITS 30
+
+/* open addressing: minimal slot array is 2^HASH_MIN_SLOT_BITS,
+ * and the array is sized to keep load factor under 3/4.
+ */
+#define HASH_MIN_SLOT_BITS 4
+
+/* keys of a batch are hashed and prefetched HASH_BATCH_MAX by HASH_BATCH_MAX */
+#define HASH_BATCH_MAX 64
+
 typedef struct hash_data_t {
     void* key;
     char* cache_node_ptr;
+    u32 hash_tag; /* mixed key_to_number result, checked before key compare */
 }__attribute__((aligned(8))) hash_data_t;
 
 typedef struct bucket_t {
@@ -27,23 +43,154 @@ typedef struct bucket_t {
     int list_count;
 }__attribute__((aligned(8))) bucket_t;
 
+/* slot of open addressing index, node == NULL means empty slot */
+typedef struct hash_slot_t {
+    u32 hash_tag;
+    node_t* node;
+}__attribute__((aligned(8))) hash_slot_t;
+
+/* group index: a group of HASH_GROUP_SLOTS slots shares a 16-byte control vector (SwissTable / F14 style).
+ * control byte i is 0 if slot i is empty, otherwise 0x80 | 7-bit fingerprint of the tag, all are compared at once.
+ * byte HASH_GROUP_OVERFLOW counts keys which passed the group full on their probe (saturated at 255),
+ * a lookup stops at the first group without any, so a delete needs no tombstone.
+ * groups are sized to keep load factor under 7/8, a group is 2 cache lines with 64-bit pointers.
+ */
+#define HASH_GROUP_SLOTS 14
+#define HASH_GROUP_OVERFLOW 15
+#define HASH_MIN_GROUP_BITS 1
+
+typedef struct hash_group_t {
+    unsigned char control[16];
+    node_t* nodes[HASH_GROUP_SLOTS];
+}__attribute__((aligned(16))) hash_group_t;
+
+/* compact group index: groups of HASH_GROUP_COMPACT_SLOTS slots with the same control vector in one cache line,
+ * a slot is a 32-bit link instead of a pointer, the offset of its node from the pools in 8-byte units, 0 if empty.
+ * So nodes must be in the first HASH_LINK_MAX_LENGTH bytes of the pools memory, and links don't change
+ * wherever that memory is mapped.
+ */
+#define HASH_GROUP_COMPACT_SLOTS 12
+#define HASH_LINK_SHIFT 3
+#define HASH_LINK_MAX_LENGTH ((size_t) 0xffffffffU << HASH_LINK_SHIFT)
+
+typedef struct hash_group_compact_t {
+    unsigned char control[16];
+    u32 links[HASH_GROUP_COMPACT_SLOTS];
+}__attribute__((aligned(64))) hash_group_compact_t;
+
+/* where hash_find_position stopped for a missing key, hash_add_at adds the key there without hashing it
+ * and probing again. It's checked before use, so a position made stale by adds or deletes in between
+ * is probed again from the tag, a key mustn't be added twice though.
+ */
+#define HASH_POSITION_NONE 0xffffffffU
+
+typedef struct hash_position_t {
+    u32 tag;        /* tag of the key */
+    u32 index;      /* chained: bucket, open: first empty slot, group: first group with an empty slot */
+    u32 step;       /* group: probe steps from the home group to index */
+    u32 deletions;  /* open: deletions of the index when found, a backward shift moves slots */
+} hash_position_t;
+
 typedef struct hash_t {
     bucket_t* bucket_list;
+    hash_slot_t* slot_list;
+    hash_group_t* group_list; /* group compact: the array is of hash_group_compact_t, see hash_group_at */
     LIBCACHE_CMP_KEY* kcmp;
     LIBCACHE_KEY_TO_NUMBER* k2num;
+    libcache_hash_e hasher; /* LIBCACHE_HASH_DEFAULT: k2num, otherwise the built-in one */
+    libcache_key_cmp_e key_cmp; /* LIBCACHE_KEY_CMP_USER: kcmp, otherwise the built-in one of key_size */
+    libcache_index_e index_type;
     int max_buckets;
+    int bucket_bits;
+    int slot_bits;
+    u32 slot_mask;
+    int group_bits;
+    u32 group_mask;
+    u32 group_slots;
+    int group_shift; /* log2 of the size of a group */
+    char* link_base; /* group compact: links are offsets from it, NULL otherwise */
     int entry_count;
     int key_size;
+    u32 deletions; /* open: deletions so far, see hash_position_t */
+    libcache_filter_t* filter; /* NULL, or tags of the keys in the index, consulted before a lookup probes */
 }__attribute__((aligned(8))) hash_t;
 
-static inline u32 key_to_hash(hash_t* hash, const void* key);
+static inline u32 key_to_tag(hash_t* hash, const void* key)
+{
+    if (hash->hasher != LIBCACHE_HASH_DEFAULT) {
+        return libcache_hash_number(hash->hasher, key, hash->key_size) * GOLDEN_RATIO_PRIME_32;
+    }
+    return (hash->k2num(key)) * GOLDEN_RATIO_PRIME_32;
+}
+
+static inline int hash_key_equal(const hash_t* hash, const void* key1, const void* key2)
+{
+    return libcache_key_equal(hash->key_cmp, hash->kcmp, hash->key_size, key1, key2);
+}
+
+static inline u32 tag_to_hash(const hash_t* hash, u32 tag)
+{
+    return tag >> (32 - hash->bucket_bits);
+}
 
 static inline u32 key_to_hash(hash_t* hash, const void* key)
 {
-    u32 val = (hash->k2num(key)) * GOLDEN_RATIO_PRIME_32;
-    return val >> (32 - HASH_BITS);
+    return tag_to_hash(hash, key_to_tag(hash, key));
+}
+
+static inline u32 tag_to_slot(const hash_t* hash, u32 tag)
+{
+    return tag >> (32 - hash->slot_bits);
 }
 
+/**
+ * @fn hash_caculate_slot_bits
+ *
+ * @brief get slot array scale of open addressing index for max_entry entries
+ * @param [in] max_entry - maximum entry number of hash table
+ * @return slot array has 2^bits slots
+ */
+int hash_caculate_slot_bits(size_t max_entry);
+
+/**
+ * @fn hash_caculate_group_bits
+ *
+ * @brief get group array scale of group index for max_entry entries
+ * @param [in] max_entry - maximum entry number of hash table
+ * @return group array has 2^bits groups
+ */
+int hash_caculate_group_bits(size_t max_entry);
+
+/**
+ * @fn hash_caculate_bucket_bits
+ *
+ * @brief get bucket array scale of chained index for max_entry entries
+ * @param [in] max_entry - maximum entry number of hash table
+ * @return bucket array has 2^bits buckets
+ */
+int hash_caculate_bucket_bits(size_t max_entry);
+
+/**
+ * @fn hash_caculate_lists_count
+ *
+ * @brief get the most POOL_TYPE_LIST_T elements a hash table of max_entry entries takes
+ * @param [in] index_type - LIBCACHE_INDEX_CHAINED / LIBCACHE_INDEX_OPEN / LIBCACHE_INDEX_GROUP
+ * @param [in] max_entry - maximum entry number of hash table
+ * @return count, a chained bucket takes a list while it isn't empty
+ */
+size_t hash_caculate_lists_count(libcache_index_e index_type, size_t max_entry);
+
+/**
+ * @fn hash_caculate_buckets_length
+ *
+ * @brief get memory length of bucket (chained), slot (open addressing) or group array
+ * @param [in] index_type - LIBCACHE_INDEX_CHAINED / LIBCACHE_INDEX_OPEN / LIBCACHE_INDEX_GROUP /
+ *                          LIBCACHE_INDEX_GROUP_COMPACT
+ * @param [in] max_entry - maximum entry number of hash table
+ * @return length, bytes
+ */
+size_t hash_caculate_buckets_length(libcache_index_e index_type, size_t max_entry);
+
 /**
  * @fn hash_init
  *
@@ -57,6 +204,46 @@ static inline u32 key_to_hash(hash_t* hash, const void* key)
  */
 void* hash_init(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMBER* key_to_num, void *pool_handle);
 
+/**
+ * @fn hash_init_ex
+ *
+ * @brief create hash table with given index type and initialization
+ * @param [in] key_size - key length
+ * @param [in] key_cmp - callback for compare key value, NULL: keys are compared bytewise
+ * @param [in] key_to_num - callback for convert key to number
+ * @param [in] index_type - LIBCACHE_INDEX_CHAINED: chained buckets sized from max_entry;
+ *                          LIBCACHE_INDEX_OPEN: linear probing slot array sized from max_entry
+ *                          LIBCACHE_INDEX_GROUP: groups of slots sized from max_entry
+ *                          LIBCACHE_INDEX_GROUP_COMPACT: groups of 32-bit links sized from max_entry
+ * @param [in] max_entry - maximum entry number, used by all but LIBCACHE_INDEX_CHAINED
+ * @param [in] pool_handle - memory pool address, the POOL_TYPE_BUCKET_T element should
+ *                           be hash_caculate_buckets_length(index_type, max_entry) bytes,
+ *                           LIBCACHE_INDEX_GROUP_COMPACT: hash nodes added must be in the pools memory
+ *                           within HASH_LINK_MAX_LENGTH bytes of pool_handle
+ * @return NULL  - when out of memory.
+ * @return pointer to hash table
+ */
+void* hash_init_ex(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMBER* key_to_num,
+        libcache_index_e index_type, size_t max_entry, void *pool_handle);
+
+/**
+ * @fn hash_set_hasher
+ *
+ * @brief hash keys with a built-in hasher instead of key_to_num, before any key is added
+ * @param [in] hash - hash table
+ * @param [in] hasher - LIBCACHE_HASH_DEFAULT: key_to_num; otherwise built-in hasher over key_size bytes
+ */
+void hash_set_hasher(void* hash, libcache_hash_e hasher);
+
+/**
+ * @fn hash_set_filter
+ *
+ * @brief keep a filter of the keys added, so lookups of missing keys mostly skip the probe, before any key is added
+ * @param [in] hash - hash table
+ * @param [in] filter - filter initialized for max_entry keys, it's cleared with the index
+ */
+void hash_set_filter(void* hash, libcache_filter_t* filter);
+
 /**
  * @fn hash_add
  *
@@ -64,6 +251,8 @@ void* hash_init(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMB
  * @param [in] hash - hash table
  * @param [in] key
  * @param [in] hash_node - hash node for add. if NULL, hash will allocate internal.
+ *                          otherwise its usr_data is a hash_data_t with a key_size bytes key buffer,
+ *                          they are owned by caller, so use hash_reset instead of hash_free.
  * @param [in] cache_node - cache list node
  * @param [in] pool_handle - memory pool address
  * @return NULL  - when out of memory.
@@ -96,6 +285,73 @@ void* hash_del(void* hash, const void* key, void* hash_node, void* pool_handle);
  */
 void* hash_find(void* hash, const void* key);
 
+/**
+ * @fn hash_find_position
+ *
+ * @brief same as hash_find, it also tells where a missing key is added, see hash_add_at.
+ * So "find, then add if missing" hashes the key once and probes once.
+ * @param [in] hash - hash table
+ * @param [in] key
+ * @param [out] position - position to add the key if it isn't found
+ * @return NULL  - not found
+ * @return pointer to hash list node
+ */
+void* hash_find_position(void* hash, const void* key, hash_position_t* position);
+
+/**
+ * @fn hash_add_at
+ *
+ * @brief same as hash_add, but the key is added where hash_find_position found it missing.
+ * @param [in] hash - hash table
+ * @param [in] position - filled by hash_find_position for the key
+ * @param [in] key
+ * @param [in] hash_node - same as hash_add
+ * @param [in] cache_node - cache list node
+ * @param [in] pool_handle - memory pool address
+ * @return NULL  - when out of memory, or the index is full.
+ * @return pointer to hash list node
+ */
+void* hash_add_at(void* hash, const hash_position_t* position, const void* key, void* hash_node, void* cache_node,
+        void* pool_handle);
+
+/**
+ * @fn hash_find_probed
+ *
+ * @brief same as hash_find, it also counts index nodes, slots or groups examined.
+ * @param [in] hash - hash table
+ * @param [in] key
+ * @param [out] probes - number of nodes (chained) or slots (open) examined
+ * @return NULL  - not found
+ * @return pointer to hash list node
+ */
+void* hash_find_probed(void* hash, const void* key, u32* probes);
+
+/**
+ * @fn hash_find_batch
+ *
+ * @brief find cache list nodes of many keys, same as calling hash_find for every key.
+ * All keys are hashed first, then buckets/slots, lists, nodes are prefetched stage by stage,
+ * keys are compared at last, so cache misses of different keys overlap.
+ * @param [in] hash - hash table
+ * @param [in] keys - keys to find
+ * @param [in] count - number of keys
+ * @param [out] hash_nodes - hash list node of every key, NULL if not found
+ */
+void hash_find_batch(void* hash, const void* const keys[], int count, void* hash_nodes[]);
+
+/**
+ * @fn hash_find_optimistic
+ *
+ * @brief find cache list node by key while another thread may be changing the hash table.
+ * It never writes, every pointer is checked and every walk is bounded, so it always returns,
+ * but the result is valid only if the hash table wasn't changed meanwhile, e.g. checked by a sequence counter.
+ * @param [in] hash - hash table
+ * @param [in] key
+ * @return NULL  - not found
+ * @return pointer to hash list node
+ */
+void* hash_find_optimistic(void* hash, const void* key);
+
 /**
  * @fn hash_get_count
  *
@@ -115,6 +371,24 @@ int hash_get_count(const void* hash);
  */
 void hash_free(void* hash, void* pool_handle);
 
+/**
+ * @fn hash_reset
+ *
+ * @brief empty hash_table, hash nodes are not freed, they're owned by caller
+ * @param [in] hash - hash table
+ * @param [in] pool_handle - memory pool address
+ */
+void hash_reset(void* hash, void* pool_handle);
+
+/**
+ * @fn hash_clear
+ *
+ * @brief empty hash_table by clearing buckets (or slots) at once, neither nodes nor bucket lists
+ *        are walked or freed, caller resets their pools, e.g. pool_reset of POOL_TYPE_LIST_T
+ * @param [in] hash - hash table
+ */
+void hash_clear(void* hash);
+
 /**
  * @fn hash_destroy
  *
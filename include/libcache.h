@@ -9,6 +9,171 @@
 #define LIBCACHE_H_
 #include "libcache_def.h"
 
+#define LIBCACHE_SECONDARY_INDEXES 3
+
+/*
+ *  @brief libcache_index_attr_t  a secondary index of a cache, all zero means it isn't used.
+ *
+ *  @field key_size           size of a secondary key, bytes.
+ *  @field extract_key        gets the secondary key out of an entry, it's called when an entry is added
+ *                            by libcache_add, loaded by libcache_load_end, moved by libcache_resize, or reindexed
+ *                            by libcache_reindex_entry. An entry without a key in the index isn't in it.
+ *  @field cmp_key            same as libcache_attr_t.cmp_key, of secondary keys.
+ *  @field key_to_number      same as libcache_attr_t.key_to_number, of secondary keys, NULL means the built-in
+ *                            hasher of key_size bytes.
+ *  NOTE:  Secondary keys are unique in an index, an add whose secondary key is taken by another entry fails.
+ */
+typedef struct libcache_index_attr_t
+{
+    size_t key_size;
+    LIBCACHE_EXTRACT_KEY* extract_key;
+    LIBCACHE_CMP_KEY* cmp_key;
+    LIBCACHE_KEY_TO_NUMBER* key_to_number;
+} libcache_index_attr_t;
+
+/*
+ *  @brief libcache_attr_t    describes a cache object to create, fields are same as libcache_create's.
+ *                            A zero filled field means default behavior.
+ *
+ *  @field index_type         index of keys, LIBCACHE_INDEX_CHAINED (default), LIBCACHE_INDEX_OPEN or
+ *                            LIBCACHE_INDEX_GROUP, which keeps load factor up to 7/8 at about one probe a lookup.
+ *                            LIBCACHE_INDEX_GROUP_COMPACT links records by 32-bit offsets, 12 slots of a group
+ *                            take one cache line instead of 14 in two, so more of the index stays in L2/L3,
+ *                            the cache's memory is up to 32 GB then.
+ *  @field policy             built-in replacement policy, LIBCACHE_POLICY_LRU (default), CLOCK, FIFO, SLRU, TINYLFU.
+ *  @field policy_ops         customized replacement policy (see libcache_policy.h), it overrides policy when not NULL.
+ *  @field page_type          LIBCACHE_PAGE_USER (default): cache memory is got from allocate_memory,
+ *                            otherwise it's mapped by the cache with the page type, the largest page type
+ *                            which succeeds is used, see libcache_get_page_type.
+ *                            allocate_memory and free_memory can be NULL then.
+ *  @field numa_node_mask     NUMA nodes (bit n for node n) mapped memory is bound to, 0 means no binding.
+ *                            With allocate_memory_on, memory is got on the lowest node of them.
+ *  @field entry_memory_size  0 (default): every entry is entry_size bytes.
+ *                            otherwise entries are of variable size up to entry_size, they share
+ *                            entry_memory_size bytes of size-class slabs, see libcache_add_sized.
+ *  @field shm_name           name of the shared memory segment if page_type is LIBCACHE_PAGE_SHARED,
+ *                            e.g. "/my_cache", shorter than LIBCACHE_SHM_NAME_MAX. The segment mustn't exist.
+ *  @field engine             LIBCACHE_ENGINE_POOL (default) or LIBCACHE_ENGINE_COMPACT, which takes less memory
+ *                            per entry, it supports neither entry_memory_size, policies other than LIBCACHE_POLICY_LRU,
+ *                            LIBCACHE_PAGE_SHARED nor libcache_resize.
+ *  @field stats              LIBCACHE_STATS_NONE (default), COUNTERS or LATENCY, see libcache_get_stats.
+ *                            Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field hash               LIBCACHE_HASH_DEFAULT: key_to_number, or LIBCACHE_HASH_WY if key_to_number is NULL.
+ *                            LIBCACHE_HASH_WY or LIBCACHE_HASH_CRC32C: the built-in hasher of key_size bytes is
+ *                            inlined in the index, key_to_number is ignored, see libcache_hash.h.
+ *  @field release_entry      NULL (default), or called for every entry leaving the cache: swapped out, deleted,
+ *                            cleaned or destroyed (before free_entry), e.g. to destroy a C++ object in the entry.
+ *                            Entries moved by libcache_resize are copied bytewise, they aren't released.
+ *                            Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field ttl                FALSE (default), or TRUE: entries may expire, see libcache_add_ttl, every record
+ *                            takes 32 bytes more. Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field load_entry         NULL (default), or the loader of missing entries, see libcache_lookup_or_load and
+ *                            libcache_sharded_lookup_or_load. Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field flush_entries      NULL (default), or the writer of dirty entries, see libcache_mark_dirty, every record
+ *                            takes 24 bytes more. Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field evicted_entries    NULL (default), or the listener of entries swapped out, expired or deleted, they're
+ *                            copied into a batch of eviction_batch entries, which is given to it once it's full,
+ *                            or by libcache_drain_evictions. Entries cleaned, destroyed or moved by libcache_resize
+ *                            aren't evicted. Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field eviction_batch     0 (default) means 64, or the number of evicted entries delivered at most at a time.
+ *  @field negative_filter    FALSE (default), or TRUE: a cuckoo filter of the keys is kept along with the index,
+ *                            lookups of missing keys mostly return without probing the index, it takes about
+ *                            4 bytes more per entry, adds and deletes update it. Not supported by
+ *                            LIBCACHE_ENGINE_COMPACT.
+ *  @field negative_ttl       0 (default), or the ticks a failed load is remembered for: the key is kept as a
+ *                            negative entry, it's missing for lookups, and libcache_load_begin fails at once instead
+ *                            of loading it again, until it expires or the key is added. It needs ttl.
+ *  @field secondary          secondary indexes, none by default, see libcache_index_attr_t. An entry is stored
+ *                            once and found by its key or by any of its secondary keys, see libcache_lookup_by_index.
+ *                            Not supported by LIBCACHE_ENGINE_COMPACT.
+ *  @field compress_threshold 0 (default), or entries of compress_threshold bytes or more added with src_entry are
+ *                            compressed (LZ4 block format) if that puts them into a smaller size class, it needs
+ *                            entry_memory_size. Copies (dst_entry of lookups, libcache_peek, evicted entries,
+ *                            libcache_save) are decompressed. An entry whose pointer is got by a lookup without
+ *                            dst_entry or libcache_pin is decompressed in place, so entries used by pointer
+ *                            stay uncompressed, such a lookup misses if there's no free memory of its size.
+ *                            The entry returned by an add is the compressed one then, it's only for
+ *                            libcache_unlock_entry and alike. Not supported with LIBCACHE_PAGE_SHARED, free_entry,
+ *                            release_entry, flush_entries, secondary indexes, libcache_scan nor by
+ *                            LIBCACHE_ENGINE_COMPACT.
+ *  @field cold_tier          NULL (default), or a tier of libcache_tier_create whose entry_size isn't larger than
+ *                            the cache's: entries swapped out are demoted into it, except ones which may expire
+ *                            by ttl, libcache_load_begin of a missing key promotes the entry from it before loading,
+ *                            see libcache_lookup_async for reads of its file without blocking. Adds and deletes
+ *                            of a key remove its entry from the tier, libcache_clean doesn't, see libcache_tier.h.
+ *                            Not supported with LIBCACHE_PAGE_SHARED, release_entry nor by LIBCACHE_ENGINE_COMPACT.
+ *  @field hot_keys           0 (default), or up to LIBCACHE_HOT_KEYS_MAX keys of libcache_sharded_create which take
+ *                            the largest shares of lookups, found by sampling them, get a read only replica per core,
+ *                            libcache_sharded_read of such a key copies the replica of its core, it doesn't read the
+ *                            shard, see libcache_sharded.h. Not supported with ttl, ignored by libcache_create_ex.
+ *  @field ordered            FALSE (default), or TRUE to keep keys in a B+tree ordered by cmp_key as well, for
+ *                            libcache_range, cmp_key must return LIBCACHE_SMALLER and LIBCACHE_BIGER then. Lookups
+ *                            still use the hash index, adds and removes also change the tree, about log n compares.
+ *                            Not supported with compress_threshold nor by LIBCACHE_ENGINE_COMPACT.
+ *  @field tags               0 (default), or the number of tags, up to LIBCACHE_TAGS_MAX: every entry has the tag
+ *                            key_to_tag gives its key, modulo tags, e.g. its service group, and libcache_invalidate_tag
+ *                            drops all entries of a tag at once. It takes 4 bytes per tag and 8 bytes more per record.
+ *                            Not supported with cold_tier nor by LIBCACHE_ENGINE_COMPACT.
+ *  @field key_to_tag         the tag of a key, it's needed by tags.
+ *  @field combining          FALSE (default), or TRUE: adds, deletes and unlocks of libcache_sharded_create are
+ *                            delegated by flat combining, a writer posts its request to the slot of its core in the
+ *                            shard, the first one taking the shard does all requests posted, see libcache_sharded.h.
+ *                            Ignored by libcache_create_ex.
+ *  @field allocate_memory_on NULL (default), or it's used instead of allocate_memory with LIBCACHE_PAGE_USER,
+ *                            memory is got aligned to a cache line on the socket of numa_node_mask, -1 if it's 0,
+ *                            e.g. rte_malloc_socket, see libcache_dpdk.h. It's freed by free_memory.
+ *  @field replication        NULL (default), or a ring of libcache_replication_create of the cache's key_size and
+ *                            entry_size: adds with an entry, deletes, evictions, libcache_clean and
+ *                            libcache_invalidate_tag put a record into it, so does libcache_load_end of a loaded
+ *                            entry, an entry filled in place is put by libcache_replicate_entry, see
+ *                            libcache_replication.h. A ring is written by one cache only, it's not supported by
+ *                            libcache_sharded_create, libcache_local_create, with cold_tier nor by
+ *                            LIBCACHE_ENGINE_COMPACT.
+ */
+typedef struct libcache_attr_t
+{
+    libcache_scale_t max_entry_number;
+    size_t entry_size;
+    size_t key_size;
+    LIBCACHE_ALLOCATE_MEMORY* allocate_memory;
+    LIBCACHE_FREE_MEMORY* free_memory;
+    LIBCACHE_FREE_ENTRY* free_entry;
+    LIBCACHE_CMP_KEY* cmp_key;
+    LIBCACHE_KEY_TO_NUMBER* key_to_number;
+    libcache_index_e index_type;
+    libcache_policy_e policy;
+    const struct libcache_policy_ops_t* policy_ops;
+    libcache_page_e page_type;
+    uint64_t numa_node_mask;
+    size_t entry_memory_size;
+    const char* shm_name;
+    libcache_engine_e engine;
+    libcache_stats_e stats;
+    libcache_hash_e hash;
+    LIBCACHE_FREE_ENTRY* release_entry;
+    int ttl;
+    LIBCACHE_LOAD_ENTRY* load_entry;
+    LIBCACHE_FLUSH_ENTRIES* flush_entries;
+    LIBCACHE_EVICTED_ENTRIES* evicted_entries;
+    uint32_t eviction_batch;
+    int negative_filter;
+    uint32_t negative_ttl;
+    libcache_index_attr_t secondary[LIBCACHE_SECONDARY_INDEXES];
+    size_t compress_threshold;
+    void* cold_tier;
+    uint32_t hot_keys;
+    int ordered;
+    uint32_t tags;
+    LIBCACHE_KEY_TO_TAG* key_to_tag;
+    int combining;
+    LIBCACHE_ALLOCATE_MEMORY_ON* allocate_memory_on;
+    void* replication;
+} libcache_attr_t;
+
+#define LIBCACHE_SHM_NAME_MAX 64
+#define LIBCACHE_HOT_KEYS_MAX 16
+#define LIBCACHE_TAGS_MAX 65536
+
 /*
  *  @brief libcache_create    creates a cache object
  *
@@ -19,7 +184,9 @@
  *  @param free_memory           function to free whole cache object, e.g. free().
  *  @param free_entry            function to free entry and key, it can be NULL if there isn't any resource to release.
  *  @param cmp_key               function to compare two keys, e.g. hash table, avl tree can use it.
+ *                               NULL: keys are equal if their key_size bytes are, padding must be zeroed.
  *  @param key_to_number         function to translate key to a number, e.g. hash table can use it.
+ *                               NULL: keys are hashed by the built-in LIBCACHE_HASH_WY.
  *  @return                      pointer of a cache object.
  */
 void* libcache_create(
@@ -32,6 +199,14 @@ void* libcache_create(
         LIBCACHE_CMP_KEY* cmp_key,
         LIBCACHE_KEY_TO_NUMBER* key_to_number);
 
+/*
+ *  @brief libcache_create_ex    creates a cache object with extended attributes
+ *
+ *  @param attr                  attributes of the cache object, see libcache_attr_t.
+ *  @return                      pointer of a cache object.
+ */
+void* libcache_create_ex(const libcache_attr_t* attr);
+
 /*
  *  @brief libcache_lookup   To look up an cache entry with a given key.
  *
@@ -45,6 +220,78 @@ void* libcache_create(
  */
 void* libcache_lookup(void* libcache, const void* key, void* dst_entry);
 
+/*
+ *  @brief libcache_lookup_sized   same as libcache_lookup, it also gets the length of the entry.
+ *
+ *  @param dst_entry         a copy of entry, only entry_length bytes are written. it could be NULL.
+ *  @param entry_length      length of the found entry, as given to libcache_add_sized. it could be NULL.
+ */
+void* libcache_lookup_sized(void* libcache, const void* key, void* dst_entry, size_t* entry_length);
+
+/*
+ *  @brief libcache_lookup_by_index  same as libcache_lookup, but the entry is found by a secondary key.
+ *
+ *  @param index             index of attr.secondary the key is of.
+ *  @param key               secondary key, cannot be NULL.
+ *  @return NULL             no entry has the key, or the cache has no such secondary index.
+ *          pointer          points to the entry, it's locked if dst_entry is NULL.
+ */
+void* libcache_lookup_by_index(void* libcache, uint32_t index, const void* key, void* dst_entry);
+
+/*
+ *  @brief libcache_reindex_entry    extracts the secondary keys of an entry again after it's written in place,
+ *                                   e.g. one added by libcache_lookup_or_add.
+ *
+ *  @param libcache                  cache object, cannot be NULL.
+ *  @param entry                     entry got by libcache_lookup or libcache_lookup_or_add, it's still locked.
+ *  @return LIBCACHE_SUCCESS         the entry is in the secondary indexes by its current keys.
+ *          LIBCACHE_EXISTING        a key is taken by another entry, the entry keeps its old secondary keys.
+ *          LIBCACHE_NOT_FOUND       the entry isn't in the cache.
+ *          LIBCACHE_FAILURE         the cache has no secondary index.
+ */
+libcache_ret_t libcache_reindex_entry(void* libcache, void* entry);
+
+/*
+ *  @brief libcache_lookup_batch   To look up many cache entries, same as calling libcache_lookup for every key.
+ *
+ *  @param libcache          cache object, cannot be NULL.
+ *  @param keys              keys, cannot be NULL.
+ *  @param count             number of keys.
+ *  @param dst_entries       count * entry_size bytes, entries are copied one by one. it could be NULL.
+ *  @param entries           result of every key: NULL if not found, otherwise the same as libcache_lookup.
+ *  @return                  number of entries found.
+ *  NOTE:  All keys are hashed and their hash nodes are prefetched before any key is compared,
+ *         so cache misses of different keys overlap. Every found entry is locked if dst_entries is NULL.
+ */
+int libcache_lookup_batch(void* libcache, const void* const keys[], int count, void* dst_entries, void* entries[]);
+
+#define LIBCACHE_BURST_MAX 64
+
+/*
+ *  @brief libcache_lookup_burst   same as libcache_lookup_batch without dst_entries, for a burst of packets as
+ *                                 rte_hash_lookup_bulk_data of DPDK, bit i of hit_mask is set if keys[i] is found.
+ *
+ *  @param count             number of keys, up to LIBCACHE_BURST_MAX.
+ *  @param hit_mask          output, found keys.
+ *  @return                  number of entries found, every one is locked.
+ */
+int libcache_lookup_burst(void* libcache, const void* const keys[], uint32_t count, uint64_t* hit_mask,
+        void* entries[]);
+
+/*
+ *  @brief libcache_peek     copies out an entry with a given key, it never writes the cache.
+ *
+ *  @param libcache          cache object, cannot be NULL.
+ *  @param key               key, cannot be NULL.
+ *  @param dst_entry         a copy of entry that fetch by key, cannot be NULL.
+ *  @return NULL             didn't find out such entry with the key.
+ *          pointer          dst_entry.
+ *  NOTE:  Replacement policy isn't told about the hit. It can run while another thread is writing the cache,
+ *         it always returns, but then the result is valid only if no write happened meanwhile,
+ *         e.g. libcache_sharded_read validates it with a sequence counter.
+ */
+void* libcache_peek(void* libcache, const void* key, void* dst_entry);
+
 /*
  *  @brief libcache_add         attempts to add an entry with a given key.
  *
@@ -58,6 +305,271 @@ void* libcache_lookup(void* libcache, const void* key, void* dst_entry);
  */
 void* libcache_add(void * libcache, const void* key, const void* src_entry);
 
+/*
+ *  @brief libcache_add_sized   attempts to add an entry of entry_length bytes with a given key.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param key                  key, cannot be NULL.
+ *  @param src_entry            entry_length bytes to add, it could be NULL as libcache_add.
+ *  @param entry_length         length of the entry, it cannot be larger than entry_size.
+ *  @return NULL                an entry with the same key is existing, or there isn't memory for the entry.
+ *          pointer             points to an entry of entry_length bytes.
+ *  NOTE:   If entry_memory_size is set, the entry takes memory of its size class only, entries selected
+ *          by policy are swapped out until the slab memory can hold it. Otherwise it takes entry_size bytes.
+ *          libcache_add adds an entry of entry_size bytes.
+ */
+void* libcache_add_sized(void * libcache, const void* key, const void* src_entry, size_t entry_length);
+
+/*
+ *  @brief libcache_add_ex      same as libcache_add_sized, but it tells why an entry couldn't be added.
+ *
+ *  @param entry                points to the added entry on success. it could be NULL.
+ *  @return
+ *      LIBCACHE_SUCCESS        the entry was added.
+ *      LIBCACHE_EXISTING       an entry with the same key is existing.
+ *      LIBCACHE_FULL           all entries are locked, or there isn't memory for the entry.
+ *      LIBCACHE_FAILURE        invalid parameter.
+ */
+libcache_ret_t libcache_add_ex(void * libcache, const void* key, const void* src_entry, size_t entry_length,
+        void** entry);
+
+/*
+ *  @brief libcache_add_batch   attempts to add many entries, same as calling libcache_add for every key in order.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param keys                 keys, cannot be NULL.
+ *  @param count                number of keys.
+ *  @param src_entries          count * entry_size bytes, entries are added one by one. it could be NULL.
+ *  @param entries              result of every key, the same as libcache_add.
+ *  @return                     number of entries added.
+ */
+int libcache_add_batch(void* libcache, const void* const keys[], int count, const void* src_entries, void* entries[]);
+
+/*
+ *  @brief libcache_lookup_or_add  looks up an entry with a given key, or adds one if it's missing.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param key                  key, cannot be NULL.
+ *  @param inserted             output, TRUE if the entry was added, FALSE if it was found. it could be NULL.
+ *  @return NULL                the entry is missing and couldn't be added, see LIBCACHE_FULL of libcache_add_ex.
+ *          pointer             points to the entry, it's locked either way, an added one is of entry_size bytes
+ *                              and isn't initialized.
+ *  NOTE:   The key is hashed and probed once, a missing key is added where its probe stopped.
+ *          libcache_unlock_entry should be called to unlock the entry when the entry is not being used this time.
+ */
+void* libcache_lookup_or_add(void * libcache, const void* key, int* inserted);
+
+/*
+ *  @brief libcache_lookup_or_add_batch   same as calling libcache_lookup_or_add for every key in order.
+ *
+ *  @param entries              result of every key, the same as libcache_lookup_or_add.
+ *  @param inserted             result of every key, the same as libcache_lookup_or_add. it could be NULL.
+ *  @return                     number of entries found or added.
+ */
+int libcache_lookup_or_add_batch(void* libcache, const void* const keys[], int count, void* entries[],
+        int inserted[]);
+
+/*
+ *  @brief libcache_lookup_or_load  looks up an entry with a given key, or adds one filled by load_entry.
+ *
+ *  @param libcache             cache object created with load_entry, cannot be NULL.
+ *  @param key                  key, cannot be NULL.
+ *  @param loaded               output, TRUE if the entry was loaded, FALSE if it was found. it could be NULL.
+ *  @return NULL                the entry is missing and load_entry failed, or it couldn't be added.
+ *          pointer             points to the entry, it's locked either way.
+ *  NOTE:   load_entry is called while the cache is held by the caller, a thread-safe cache coalescing loads of
+ *          the same key is libcache_sharded_lookup_or_load. A key being loaded by libcache_load_begin of another
+ *          caller is missing. libcache_unlock_entry should be called to unlock the entry.
+ */
+void* libcache_lookup_or_load(void* libcache, const void* key, int* loaded);
+
+/*
+ *  @brief libcache_load_begin  looks up an entry with a given key, or adds a locked placeholder to be loaded.
+ *
+ *  @param libcache             cache object, cannot be NULL, load_entry isn't needed.
+ *  @param key                  key, cannot be NULL.
+ *  @param entry                output, the entry, it's locked unless LIBCACHE_FAILURE is returned.
+ *  @return
+ *      LIBCACHE_SUCCESS        the entry was found, or promoted from cold_tier, whose file is read then.
+ *      LIBCACHE_NOT_FOUND      a placeholder of entry_size bytes was added, the caller loads it without holding
+ *                              the cache, then calls libcache_load_end.
+ *      LIBCACHE_LOCKED         the key is being loaded by another caller, libcache_load_wait waits for it without
+ *                              holding the cache, then the entry is unlocked as a found one.
+ *      LIBCACHE_FAILURE        invalid parameter, a compact or an attached cache, or the key is missing
+ *                              and can't be added, see libcache_lookup_or_add.
+ *  NOTE:   A placeholder is missing for lookups, adds of its key fail as LIBCACHE_EXISTING and deletes as
+ *          LIBCACHE_LOCKED, it's never swapped out, and libcache_save skips it. loads and load_waits of
+ *          libcache_stats_t count the last two results.
+ */
+libcache_ret_t libcache_load_begin(void* libcache, const void* key, void** entry);
+
+/*
+ *  @brief libcache_load_end    ends the load of a placeholder added by libcache_load_begin.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param entry                the placeholder, its entry_size bytes are filled if it's loaded.
+ *  @param entry_length         length loaded, up to entry_size.
+ *  @param loaded               TRUE if the load succeeded.
+ *  @return
+ *      LIBCACHE_SUCCESS        the entry is valid, it's still locked by the loader.
+ *      LIBCACHE_FAILURE        invalid parameter, entry isn't being loaded, loaded is FALSE or entry_length is
+ *                              too large: the placeholder is unlocked, it's freed by the last waiter's unlock.
+ *  NOTE:   It's called while the cache is held, as libcache_load_begin.
+ */
+libcache_ret_t libcache_load_end(void* libcache, void* entry, size_t entry_length, int loaded);
+
+/*
+ *  @brief libcache_load_wait   waits for libcache_load_end of a placeholder locked by libcache_load_begin.
+ *
+ *  @param entry                the placeholder, cannot be NULL.
+ *  @return
+ *      LIBCACHE_SUCCESS        the entry is loaded.
+ *      LIBCACHE_FAILURE        the load failed, the entry is still locked, it's missing.
+ *  NOTE:   It doesn't change the cache, it's called without holding it, so the loader can end the load.
+ *          It spins and yields CPU as libcache_spin_lock does.
+ */
+libcache_ret_t libcache_load_wait(void* entry);
+
+/*
+ *  @brief libcache_add_ttl     same as libcache_add_ex, the entry expires ttl ticks after the clock of the cache.
+ *
+ *  @param libcache             cache object created with ttl, cannot be NULL.
+ *  @param ttl                  time to live in ticks of the clock given to libcache_expire, 0 means never.
+ *  @return                     same as libcache_add_ex's, LIBCACHE_FAILURE if the cache was created without ttl.
+ *  NOTE:   An expired entry is missing for lookups, the first one finding it unlocked deletes it, or
+ *          libcache_expire reclaims it. While it's locked, it stays: adding its key fails as LIBCACHE_EXISTING,
+ *          and libcache_lookup_or_add returns NULL. Once the cache is full, expired entries are swapped out
+ *          before policy is asked for a victim. libcache_add and others add entries which never expire.
+ */
+libcache_ret_t libcache_add_ttl(void* libcache, const void* key, const void* src_entry, size_t entry_length,
+        uint32_t ttl, void** entry);
+
+/*
+ *  @brief libcache_expire      advances the clock of the cache, and reclaims entries expired by it.
+ *
+ *  @param libcache             cache object created with ttl, cannot be NULL.
+ *  @param now                  current time in ticks, e.g. seconds, the clock never goes back.
+ *  @param budget               maximum number of entries to reclaim.
+ *  @return                     number of entries reclaimed, budget means more may be left, call it again.
+ *  NOTE:   It's amortized O(1) per entry, expired entries are found by a hierarchical timing wheel, not by
+ *          walking the cache. Expired entries which are locked are reclaimed once they're unlocked.
+ */
+int libcache_expire(void* libcache, uint32_t now, int budget);
+
+/*
+ *  @brief libcache_invalidate_tag  drops every entry of a tag in O(1), the tag takes a new generation, entries
+ *                                  added before it are stale.
+ *
+ *  @param libcache             cache object created with tags, cannot be NULL.
+ *  @param tag                  tag less than attr.tags.
+ *  @return LIBCACHE_SUCCESS
+ *          LIBCACHE_FAILURE    the cache was created without tags, or it's attached, or tag is invalid.
+ *  NOTE:   A stale entry is missing for lookups, scans and libcache_save as an expired one, the first lookup or add
+ *          of its key finding it unlocked reclaims it as an expiration, others are swapped out by policy in turn.
+ *          While it's locked, it stays: adding its key fails as LIBCACHE_EXISTING. Entries added after it are valid.
+ */
+libcache_ret_t libcache_invalidate_tag(void* libcache, uint32_t tag);
+
+/*
+ *  @brief libcache_mark_dirty  marks an entry changed by its holder to be written back by flush_entries.
+ *
+ *  @param libcache             cache object created with flush_entries, cannot be NULL.
+ *  @param entry                locked entry, cannot be NULL.
+ *  @return LIBCACHE_SUCCESS    the entry is dirty, marking a dirty entry again does nothing, so repeated
+ *                              changes of an entry are written once.
+ *          LIBCACHE_NOT_FOUND  the entry isn't in the cache.
+ *          LIBCACHE_FAILURE    the cache was created without flush_entries.
+ *  NOTE:   A dirty entry swapped out or expired is written alone by flush_entries before it leaves the cache,
+ *          it's never lost by replacement. A dirty entry deleted, cleaned or destroyed is discarded unwritten,
+ *          libcache_flush should be called before libcache_destroy to keep it.
+ */
+libcache_ret_t libcache_mark_dirty(void* libcache, void* entry);
+
+/*
+ *  @brief libcache_replicate_entry  puts an entry into replication as an add, e.g. once it's filled in place
+ *                                   after libcache_add of a NULL src_entry or libcache_lookup_or_add, or changed.
+ *
+ *  @param libcache             cache object created with replication, cannot be NULL.
+ *  @param entry                locked entry, cannot be NULL.
+ *  @return LIBCACHE_SUCCESS    the record is put, or dropped as the ring is full, its ttl is the one left.
+ *          LIBCACHE_NOT_FOUND  the entry isn't in the cache, or it's being loaded.
+ *          LIBCACHE_FAILURE    the cache was created without replication, or it's attached.
+ */
+libcache_ret_t libcache_replicate_entry(void* libcache, void* entry);
+
+/*
+ *  @brief libcache_flush       writes dirty entries back by flush_entries in batches, they're clean then.
+ *
+ *  @param libcache             cache object created with flush_entries, cannot be NULL.
+ *  @param budget               maximum number of entries to write, 0 means all of them.
+ *  @return                     number of entries written, budget means more may be left, call it again.
+ *  NOTE:   Entries are taken in the order they became dirty, up to 64 of them are given to flush_entries
+ *          at a time, sorted by cmp_key if it orders keys, so a backend writes them sequentially.
+ *          flush_entries is called while the cache is held by the caller, it can't call the cache.
+ *          It reads locked entries as well, their holders shouldn't write them meanwhile.
+ */
+int libcache_flush(void* libcache, int budget);
+
+/*
+ *  @brief libcache_drain_evictions  gives entries evicted since the last delivery to evicted_entries.
+ *
+ *  @param libcache             cache object created with evicted_entries, cannot be NULL.
+ *  @return                     number of entries delivered.
+ *  NOTE:   An evicted entry is copied, its record is reused at once, the copy stays in the batch until it's
+ *          delivered. A full batch is delivered by the add, lookup or delete which evicts one more, so
+ *          evicted_entries is called while the cache is held by the caller, it can't call the cache. It's called
+ *          once per batch, not per entry. Entries still in the batch are delivered by libcache_destroy.
+ */
+int libcache_drain_evictions(void* libcache);
+
+/*
+ *  @brief libcache_scan_entry_t   an entry returned by libcache_scan, read only.
+ *
+ *  @field key                     key of the entry.
+ *  @field entry                   the entry.
+ *  @field entry_length            bytes of the entry.
+ *  NOTE:  key and entry point into the cache, they're valid until the cache is changed, e.g. by an add.
+ */
+typedef struct libcache_scan_entry_t
+{
+    const void* key;
+    const void* entry;
+    size_t entry_length;
+} libcache_scan_entry_t;
+
+/*
+ *  @brief libcache_scan        returns entries from where the cursor stopped, records are walked in memory order.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param cursor               0 starts a scan, every call moves it on, it's 0 again once the scan is done.
+ *  @param batch                maximum number of entries returned, at most 10 times as many records are walked.
+ *  @param out                  output, batch entries at most.
+ *  @return                     number of entries in out, it may be 0 before the scan is done.
+ *  NOTE:   Adds, deletes and resizes may go on between calls, like Redis SCAN: an entry which is in the cache
+ *          from the start to the end of a scan is returned at least once, one added or removed meanwhile
+ *          may or may not be. An entry may be returned twice if libcache_resize moves it during the scan.
+ *          Expired entries and entries being loaded are skipped, locked entries aren't.
+ *          Replacement policy isn't told, it's not supported by LIBCACHE_ENGINE_COMPACT, attached caches nor
+ *          caches created with compress_threshold.
+ */
+int libcache_scan(void* libcache, uint64_t* cursor, int batch, libcache_scan_entry_t out[]);
+
+/*
+ *  @brief libcache_range       calls callback with the entries from key lo to key hi, both included, in key order.
+ *
+ *  @param libcache             cache object created with libcache_attr_t.ordered, cannot be NULL.
+ *  @param lo                   NULL from the smallest key.
+ *  @param hi                   NULL up to the largest key, e.g. lo and hi of a prefix give the keys of it.
+ *  @param callback             takes every entry, returns FALSE to stop, it mustn't change the cache.
+ *  @param arg                  given to callback.
+ *  @return -1                  invalid parameter, or the cache has no ordered index.
+ *          count               number of entries given to callback.
+ *  NOTE:   Expired entries and entries being loaded are skipped, locked entries aren't. While the cache is
+ *          resized, the entries not moved yet are given first, in order of their own.
+ *          Replacement policy isn't told, it's not supported by LIBCACHE_ENGINE_COMPACT nor attached caches.
+ */
+int libcache_range(void* libcache, const void* lo, const void* hi, LIBCACHE_RANGE_ENTRY* callback, void* arg);
+
 /*
  *  @brief libcache_delete_by_key attempts to delete an entry with a given key.
  *
@@ -94,6 +606,151 @@ libcache_ret_t  libcache_delete_entry(void * libcache, void* entry);
  */
 libcache_ret_t libcache_unlock_entry(void * libcache, void* entry);
 
+/*
+ *  @brief libcache_try_unlock_entry    attempts to unlock an entry which is locked more than once.
+ *
+ *  @param entry                        entry (returned by libcache_lookup/libcache_add) in a cache.
+ *  @return
+ *          LIBCACHE_SUCCESS            the entry was unlocked once, it's still locked by others.
+ *          LIBCACHE_FAILURE            it's the last lock or entry isn't locked, libcache_unlock_entry should be called.
+ *  NOTE:  It doesn't change the cache, so in LIBCACHE_CONCURRENT build it can be called by any thread
+ *         without locking the cache, this is what libcache_sharded_unlock_entry does.
+ */
+libcache_ret_t libcache_try_unlock_entry(void* entry);
+
+/*
+ *  @brief libcache_handle_t       a pinned entry, filled by libcache_pin, read only for users.
+ *
+ *  @field entry                   the entry, it can be read and written in place while it's pinned.
+ *  @field entry_length            length of the entry, as given to libcache_add_sized.
+ *  @field node                    record of the entry, it's unlocked without looking the entry up.
+ *  @field generation              generation of the entry, it's changed once the entry leaves the cache,
+ *                                 so a handle of a swapped out, deleted or cleaned entry is known to be stale.
+ */
+typedef struct libcache_handle_t
+{
+    void* entry;
+    size_t entry_length;
+    void* node;
+    uint64_t generation;
+} libcache_handle_t;
+
+/*
+ *  @brief libcache_pin            looks up an entry with a given key and locks it, same as libcache_lookup
+ *                                 with a NULL dst_entry, but the entry is unlocked by libcache_unpin.
+ *
+ *  @param libcache                cache object, cannot be NULL.
+ *  @param key                     key, cannot be NULL.
+ *  @param handle                  output, the pinned entry, it's zeroed if the entry isn't found.
+ *  @return
+ *          LIBCACHE_SUCCESS       the entry was found and locked once.
+ *          LIBCACHE_NOT_FOUND     entry wasn't found.
+ *          LIBCACHE_FAILURE       invalid parameter, a compact or an attached cache.
+ */
+libcache_ret_t libcache_pin(void* libcache, const void* key, libcache_handle_t* handle);
+
+/*
+ *  @brief libcache_unpin          unlocks the entry of a handle once, in O(1) without looking the entry up.
+ *
+ *  @param libcache                cache object, cannot be NULL.
+ *  @param handle                  handle filled by libcache_pin, it's kept for libcache_repin.
+ *  @return
+ *          LIBCACHE_SUCCESS       the entry was unlocked successfully once.
+ *          LIBCACHE_UNLOCKED      the entry is already unlocked.
+ *          LIBCACHE_NOT_FOUND     the handle is stale, e.g. the entry was cleaned while it was pinned.
+ *          LIBCACHE_FAILURE       invalid parameter, a compact or an attached cache.
+ */
+libcache_ret_t libcache_unpin(void* libcache, libcache_handle_t* handle);
+
+/*
+ *  @brief libcache_repin          locks the entry of an unpinned handle again if it's still in the cache,
+ *                                 in O(1) without looking the key up.
+ *
+ *  @param libcache                cache object, cannot be NULL.
+ *  @param handle                  handle filled by libcache_pin.
+ *  @return
+ *          LIBCACHE_SUCCESS       the entry is in the cache, it was locked once.
+ *          LIBCACHE_NOT_FOUND     the handle is stale: the entry was swapped out, deleted, cleaned,
+ *                                 or moved by libcache_resize. libcache_pin looks it up again.
+ *          LIBCACHE_FAILURE       invalid parameter, a compact or an attached cache.
+ *  NOTE:  A stale handle is detected while the cache exists, handle.node is read only if it's
+ *         in memory of the cache, so it's safe after the memory of the entry is freed by a resize.
+ *         Policy isn't told about the hit.
+ */
+libcache_ret_t libcache_repin(void* libcache, libcache_handle_t* handle);
+
+/*
+ *  @brief libcache_load_waiter_t  an asynchronous lookup, see libcache_lookup_async, it belongs to the caller,
+ *                                 and it must stay until its load ends.
+ *
+ *  @field done              NULL, or called once the load the lookup waits for ends, e.g. to resume a coroutine.
+ *                           It's called by libcache_load_notify, it may free the waiter.
+ *  @field eventfd           0: none, otherwise a file descriptor 8 bytes of 1 are written to once the load ends,
+ *                           after done, e.g. an eventfd an io_uring or epoll reactor reads.
+ *  @field data              user's.
+ *  @field result            LIBCACHE_SUCCESS: handle pins the entry, LIBCACHE_FAILURE: the load failed.
+ *  @field handle            the pinned entry, libcache_unpin or libcache_unlock_entry of handle.entry unpins it.
+ *  @field tier_offset       -1, or the offset of the entry in the file of cold_tier, given LIBCACHE_NOT_FOUND:
+ *                           tier_length bytes read there, e.g. by io_uring, are the entry to load.
+ *  @field tier_length       bytes of the entry in the file of cold_tier.
+ *  @field entry, next       internal, of a waiter being queued.
+ */
+typedef struct libcache_load_waiter_t libcache_load_waiter_t;
+typedef void LIBCACHE_LOAD_DONE(libcache_load_waiter_t* waiter);
+struct libcache_load_waiter_t
+{
+    LIBCACHE_LOAD_DONE* done;
+    int eventfd;
+    void* data;
+    libcache_ret_t result;
+    libcache_handle_t handle;
+    int64_t tier_offset;
+    size_t tier_length;
+    void* entry;
+    libcache_load_waiter_t* next;
+};
+
+/*
+ *  @brief libcache_lookup_async   looks up an entry with a given key without waiting for a load.
+ *
+ *  @param libcache                cache object, cannot be NULL.
+ *  @param key                     key, cannot be NULL.
+ *  @param waiter                  the lookup, done, eventfd and data are set by the caller, cannot be NULL.
+ *  @return
+ *          LIBCACHE_SUCCESS       the entry was found, waiter.handle pins it, nothing is called.
+ *          LIBCACHE_NOT_FOUND     the caller loads the key: waiter.handle pins a placeholder of entry_size bytes,
+ *                                 it's filled, e.g. by an asynchronous request, then libcache_load_complete
+ *                                 is called with the waiter. The entry is read from waiter.tier_offset of the
+ *                                 file of cold_tier instead of the backend if it isn't -1, a read which fails
+ *                                 or ends after the log wrapped onto it falls back to the backend. An entry of
+ *                                 cold_tier in memory is promoted at once, LIBCACHE_SUCCESS then.
+ *          LIBCACHE_LOCKED        the key is being loaded by another caller, the waiter is queued until
+ *                                 libcache_load_complete of that load, result and handle are set then.
+ *          LIBCACHE_FAILURE       invalid parameter, see libcache_load_begin.
+ *  NOTE:  Nobody is blocked by a miss, the placeholders are the ones of libcache_load_begin.
+ */
+libcache_ret_t libcache_lookup_async(void* libcache, const void* key, libcache_load_waiter_t* waiter);
+
+/*
+ *  @brief libcache_load_complete  ends the load of a waiter given LIBCACHE_NOT_FOUND, and the waiters queued for it.
+ *
+ *  @param libcache                cache object, cannot be NULL.
+ *  @param loader                  the waiter given LIBCACHE_NOT_FOUND, its handle pins the entry if it's loaded.
+ *  @param entry_length            same as libcache_load_end's.
+ *  @param loaded                  same as libcache_load_end's.
+ *  @param waiters                 output, waiters of the load in the order they came, given to libcache_load_notify
+ *                                 once the cache isn't held any more. NULL: they're notified before it returns.
+ *  @return                        same as libcache_load_end's, result of every waiter is the same.
+ *  NOTE:  Waiters are pinned before they're notified, one lock each, whatever thread they run on.
+ */
+libcache_ret_t libcache_load_complete(void* libcache, libcache_load_waiter_t* loader, size_t entry_length,
+        int loaded, libcache_load_waiter_t** waiters);
+
+/*
+ *  @brief libcache_load_notify    calls done and writes eventfd of every waiter of a list by libcache_load_complete.
+ */
+void libcache_load_notify(libcache_load_waiter_t* waiters);
+
 /*
  *  @brief libcache_get_max_entry_number    gets a capacity of the maximum number of entries this cache can store.
  *
@@ -112,6 +769,44 @@ libcache_scale_t libcache_get_max_entry_number(const void * libcache);
  */
 libcache_scale_t libcache_get_entry_number(const void * libcache);
 
+/*
+ *  @brief libcache_get_page_type            gets the page type cache memory is really on.
+ *
+ *  @param libcache                          cache object, cannot be NULL.
+ *  @return
+ *         LIBCACHE_PAGE_USER                memory is got from allocate_memory.
+ *         others                            memory is mapped with the page type, it could be smaller than
+ *                                           libcache_attr_t.page_type if the system has no such free pages.
+ */
+libcache_page_e libcache_get_page_type(const void * libcache);
+
+/*
+ *  @brief libcache_get_entry_key            gets the key of a locked entry.
+ *
+ *  @param entry                             entry returned by libcache_lookup/libcache_add, cannot be NULL.
+ *  @return NULL                             the entry isn't in any cache.
+ *          pointer                          points to the key, it's valid while the entry is locked.
+ */
+const void* libcache_get_entry_key(void* entry);
+
+/*
+ *  @brief libcache_resize        changes the maximum entry number without losing the entries.
+ *
+ *  @param libcache               cache object, cannot be NULL.
+ *  @param max_entry_number       new maximum entry number.
+ *  @return
+ *      LIBCACHE_SUCCESS          new memory is in use, entries are being moved into it.
+ *      LIBCACHE_LOCKED           entries of the previous resize are locked, it can't be finished yet.
+ *      LIBCACHE_FAILURE          failed to get new memory, the cache isn't changed.
+ *  NOTE:  A new cache is created with the same attributes (entry_memory_size scales with max_entry_number),
+ *         every later lookup, add and delete moves a few entries from old memory, a found entry is moved
+ *         at once, and old memory is freed once it's empty. Locked entries stay in old memory until unlocked.
+ *         If it shrinks, entries are swapped out in policy order until the others fit in new memory.
+ *         libcache_lookup_batch looks keys up one by one while entries are being moved.
+ *         A LIBCACHE_PAGE_SHARED cache can't be resized, attached processes map its memory.
+ */
+libcache_ret_t libcache_resize(void * libcache, libcache_scale_t max_entry_number);
+
 /*
  *  @brief libcache_clean         attempts to delete all entries.
  *
@@ -120,6 +815,9 @@ libcache_scale_t libcache_get_entry_number(const void * libcache);
  *      LIBCACHE_LOCKED           this operation aborted while some entries were locked.
  *      LIBCACHE_SUCCESS          all entries were deleted successfully,
  *                                now the cache is empty as fresh as just created.
+ *  NOTE:  Entries aren't walked, memory pools are rewound and the index is cleared at once, so it takes
+ *         time of clearing the index only, unless release_entry is set, which is called for every entry.
+ *         Locked entries are deleted too, free_entry isn't called.
  */
 libcache_ret_t libcache_clean(void * libcache);
 
@@ -130,6 +828,188 @@ libcache_ret_t libcache_clean(void * libcache);
  *  @return
  *      LIBCACHE_LOCKED             this operation aborted while some entries were locked.
  *      LIBCACHE_SUCCESS            all entries were deleted successfully, then cache was also destroyed after that.
+ *  NOTE:  Entries are walked only if free_entry or release_entry is set, which is called for every entry.
  */
 libcache_ret_t libcache_destroy(void * libcache);
+
+/*
+ *  @brief libcache_save            writes an image of all keys and entries to a file, e.g. for a warm restart.
+ *
+ *  @param libcache                 cache object, cannot be NULL.
+ *  @param path                     path of the image, it's replaced if it exists.
+ *  @return
+ *      LIBCACHE_SUCCESS            the image is written.
+ *      LIBCACHE_FAILURE            invalid parameter, a compact or an attached cache, or failed to write the file.
+ *  NOTE:  Entries are written in the order policy swaps them out, coldest first, locked entries last, with
+ *         their entry_length and expiry. The image is written to path.tmp, then renamed, so path always holds
+ *         a whole image. Entries are copied bytewise, so pointers in them aren't valid in another process.
+ *         Unlocked entries are taken out of policy and given back in the same order while writing, so LRU
+ *         and FIFO order are kept, other policies keep the entries but forget their hits.
+ */
+libcache_ret_t libcache_save(void * libcache, const char* path);
+
+/*
+ *  @brief libcache_save_start      writes the same image as libcache_save in a forked child, without stopping writes.
+ *
+ *  @param libcache                 cache object, cannot be NULL.
+ *  @param path                     path of the image, it's replaced if it exists.
+ *  @param pid                      output, the child writing the image, given to libcache_save_wait.
+ *  @return
+ *      LIBCACHE_SUCCESS            the child is writing the image of the cache as it was at the call.
+ *      LIBCACHE_FAILURE            invalid parameter, a compact or an attached cache, or failed to create or fork.
+ *  NOTE:  It's called between writes, by the thread writing the cache, or while writers are stopped, and returns as
+ *         soon as the child is forked. Its cost is fork's, copying the page tables of the process. Pages the
+ *         parent writes while the child runs are copied on their first write, a fault each, 2M or 1G each with
+ *         hugepages, so a cache of hugepages forks faster but writes pay more during the snapshot.
+ *         Tracking dirty pages instead would cost every write of the cache, even with no snapshot running.
+ */
+libcache_ret_t libcache_save_start(void * libcache, const char* path, int* pid);
+
+/*
+ *  @brief libcache_save_wait       reaps the child of libcache_save_start.
+ *
+ *  @param pid                      pid given by libcache_save_start.
+ *  @param block                    TRUE waits for the child to end, FALSE returns at once if it's still writing.
+ *  @return
+ *      LIBCACHE_SUCCESS            the image is written.
+ *      LIBCACHE_LOCKED             the child is still writing, block is FALSE.
+ *      LIBCACHE_FAILURE            the child failed to write the image, or no such child.
+ */
+libcache_ret_t libcache_save_wait(int pid, int block);
+
+/*
+ *  @brief libcache_load            creates a cache filled with the entries of an image written by libcache_save.
+ *
+ *  @param path                     path of the image, cannot be NULL.
+ *  @param attr                     attributes of the cache, same as libcache_create_ex's, entry_size and
+ *                                  key_size must be the image's.
+ *  @return NULL                    invalid parameter, no such image, another version or size, or it's corrupted.
+ *          pointer                 the cache, destroyed by libcache_destroy.
+ *  NOTE:  The image is mapped and read once from its start, entries are added coldest first, so the order
+ *         is the saved one, and a smaller cache keeps the hottest entries. Entries expired by the saved clock
+ *         are skipped, the clock of a cache created with ttl goes on from the saved one.
+ */
+void* libcache_load(const char* path, const libcache_attr_t* attr);
+
+/*
+ *  @brief libcache_attach          maps a cache created with LIBCACHE_PAGE_SHARED by another process, read only.
+ *
+ *  @param shm_name                 shm_name the cache was created with, cannot be NULL.
+ *  @param cmp_key                  same as the creator's, functions can't be shared by processes,
+ *                                  NULL if the creator compares keys bytewise.
+ *  @param key_to_number            same as the creator's, NULL if the creator hashes keys with a built-in hasher.
+ *  @return NULL                    no such cache, or its address is already in use in this process.
+ *          pointer                 an attached cache object, libcache_destroy detaches it.
+ *  NOTE:  The segment is mapped at the address the creator mapped it, so pointers in it are valid as they are.
+ *         An attached cache can only be read by libcache_shm_read/libcache_peek and counted by libcache_get_*,
+ *         only the process which created it writes it. The creator's libcache_destroy unlinks the segment,
+ *         attached processes still read the last entries until they detach.
+ */
+void* libcache_attach(const char* shm_name, LIBCACHE_CMP_KEY* cmp_key, LIBCACHE_KEY_TO_NUMBER* key_to_number);
+
+/*
+ *  @brief libcache_shm_read        copies out an entry of a shared memory cache, validated by a sequence counter.
+ *
+ *  @param libcache                 cache created with LIBCACHE_PAGE_SHARED or attached, cannot be NULL.
+ *  @param key                      key, cannot be NULL.
+ *  @param dst_entry                a copy of entry that fetch by key, cannot be NULL.
+ *  @return NULL                    didn't find out such entry with the key, or the creator kept writing the cache.
+ *          pointer                 dst_entry.
+ *  NOTE:  Adds, deletes and cleans of the creator bump the counter, a read overlapped by them is retried,
+ *         same as libcache_sharded_read. The creator's writes must be serialized by itself.
+ *         An entry locked by the creator and written meanwhile may be copied out partially written.
+ */
+void* libcache_shm_read(void* libcache, const void* key, void* dst_entry);
+
+/*
+ *  @brief libcache_get_pool_stats    gets occupancy of a memory pool of the cache, see pool_stats_t in libpool.h.
+ *
+ *  @param libcache                   cache object, cannot be NULL.
+ *  @param pool_type                  pool_type_e, e.g. POOL_TYPE_DATA for entry records.
+ *  @param stats                      occupancy of the pool, cannot be NULL.
+ *  @return
+ *      LIBCACHE_SUCCESS              stats is filled.
+ *      LIBCACHE_FAILURE              invalid parameter.
+ *  NOTE:  peak of POOL_TYPE_DATA is the most entries the cache has held, max_entry_number can be sized by it.
+ */
+struct pool_stats_t;
+libcache_ret_t libcache_get_pool_stats(void* libcache, int pool_type, struct pool_stats_t* stats);
+
+#define LIBCACHE_STATS_PROBE_BUCKETS 16
+#define LIBCACHE_STATS_LATENCY_BUCKETS 32
+
+/*
+ *  @brief libcache_stats_t    counters of a cache created with libcache_attr_t.stats, they only grow.
+ *
+ *  @field add_full            adds failed because every entry is locked, no entry could be swapped out.
+ *  @field delete_locked       deletes failed because the entry is locked.
+ *  @field expirations         expired entries reclaimed, by libcache_expire, a lookup or an add, and stale ones
+ *                             of invalidated tags reclaimed by a lookup or an add.
+ *  @field loads               misses given to load_entry, see libcache_load_begin.
+ *  @field load_waits          misses which waited for the load of another one instead of loading.
+ *  @field flushes             dirty entries given to flush_entries, by libcache_flush or before they left.
+ *  @field negative_hits       loads skipped because the key was known absent, see negative_ttl.
+ *  @field demotions           entries swapped out into cold_tier.
+ *  @field promotions          missing entries got from cold_tier instead of being loaded, they aren't loads.
+ *  @field replica_hits        libcache_sharded_read served by a replica of a hot key, see hot_keys, only
+ *                             libcache_sharded_get_stats reports them.
+ *  @field probe_histogram     [n] lookups examined n index nodes, slots or groups, the last one is for n or more.
+ *                             Batch lookups aren't counted.
+ *  @field lookup_latency_ns   [i] lookups took [2^i, 2^(i+1)) ns, LIBCACHE_STATS_LATENCY only.
+ *  @field add_latency_ns      [i] adds took [2^i, 2^(i+1)) ns, LIBCACHE_STATS_LATENCY only.
+ */
+typedef struct libcache_stats_t
+{
+    unsigned long long lookup_hits;
+    unsigned long long lookup_misses;
+    unsigned long long adds;
+    unsigned long long add_existing;
+    unsigned long long add_full;
+    unsigned long long evictions;
+    unsigned long long deletes;
+    unsigned long long delete_locked;
+    unsigned long long expirations;
+    unsigned long long loads;
+    unsigned long long load_waits;
+    unsigned long long flushes;
+    unsigned long long negative_hits;
+    unsigned long long demotions;
+    unsigned long long promotions;
+    unsigned long long replica_hits;
+    unsigned long long probe_histogram[LIBCACHE_STATS_PROBE_BUCKETS];
+    unsigned long long lookup_latency_ns[LIBCACHE_STATS_LATENCY_BUCKETS];
+    unsigned long long add_latency_ns[LIBCACHE_STATS_LATENCY_BUCKETS];
+    libcache_scale_t entry_number;
+} libcache_stats_t;
+
+/*
+ *  @brief libcache_get_stats    takes a snapshot of the counters of a cache.
+ *
+ *  @param libcache              cache object, cannot be NULL.
+ *  @param stats                 snapshot, cannot be NULL.
+ *  @return
+ *      LIBCACHE_SUCCESS         stats is filled.
+ *      LIBCACHE_FAILURE         invalid parameter, or the cache was created with LIBCACHE_STATS_NONE.
+ *  NOTE:  Counters are of the cache object, e.g. every shard of a sharded cache has its own ones, they're
+ *         written by the thread holding the cache, so the snapshot must be taken by it as well,
+ *         see libcache_sharded_get_stats.
+ */
+libcache_ret_t libcache_get_stats(const void* libcache, libcache_stats_t* stats);
+
+/*
+ *  @brief libcache_stats_merge    adds counters of src to dst, entry_number too.
+ */
+void libcache_stats_merge(libcache_stats_t* dst, const libcache_stats_t* src);
+
+/*
+ *  @brief libcache_stats_format   formats a snapshot in Prometheus text exposition format.
+ *
+ *  @param stats                   snapshot, cannot be NULL.
+ *  @param name                    prefix of metric names, e.g. "libcache".
+ *  @param buffer                  output, it's always terminated if length > 0.
+ *  @param length                  length of buffer.
+ *  @return                        same as snprintf, length of the whole text, larger than length-1 if truncated.
+ *  NOTE:  Histograms are cumulative "_bucket" series with "le" labels, latencies are in seconds.
+ */
+int libcache_stats_format(const libcache_stats_t* stats, const char* name, char* buffer, size_t length);
 #endif /* LIBCACHE_H_ */
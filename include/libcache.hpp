@@ -0,0 +1,350 @@
+/*
+ * libcache.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_HPP_
+#define LIBCACHE_HPP_
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include "libcache.h"
+#include "libcache_hash.h"
+}
+
+/*
+ * Header-only C++17 front-end of the pool engine, e.g.
+ *
+ *     libcache::Cache<uint64_t, std::string> cache(1000);
+ *     cache.emplace(imsi, "profile");
+ *     if (auto pin = cache.find(imsi)) {
+ *         use(*pin);                       // the entry stays locked until pin goes out of scope
+ *     }
+ *
+ * Values are constructed in place in the entry memory and destroyed by release_entry when they leave the
+ * cache, so non-trivial values need neither free_entry nor memcpy. Keys are copied bytewise by the engine,
+ * so they must be trivially copyable. With the default BytesHash and BytesEqual the engine inlines the
+ * built-in LIBCACHE_HASH_WY and the bytewise compare of sizeof(Key) bytes, other Hash and Eq are called
+ * through one static trampoline each.
+ * libcache_resize isn't exposed: it moves entries bytewise, which is only safe for trivially copyable values.
+ */
+namespace libcache {
+
+/*
+ *  @brief BytesHash    hashes the sizeof(Key) bytes of a key like the engine's built-in LIBCACHE_HASH_WY.
+ */
+template <typename Key>
+struct BytesHash
+{
+    size_t operator()(const Key& key) const noexcept
+    {
+        return libcache_hash_number(LIBCACHE_HASH_WY, &key, sizeof(Key));
+    }
+};
+
+/*
+ *  @brief BytesEqual   compares the sizeof(Key) bytes of two keys like the engine's built-in compare.
+ */
+template <typename Key>
+struct BytesEqual
+{
+    bool operator()(const Key& key1, const Key& key2) const noexcept
+    {
+        return memcmp(&key1, &key2, sizeof(Key)) == 0;
+    }
+};
+
+/*
+ *  @brief Pin    locks an entry while it's alive, it unlocks the entry instead of libcache_unlock_entry.
+ *                An empty Pin (operator bool is false) holds nothing.
+ */
+template <typename Value>
+class Pin
+{
+public:
+    Pin() noexcept : cache_(NULL), entry_(NULL) {}
+    Pin(void* cache, void* entry) noexcept : cache_(cache), entry_(static_cast<Value*>(entry)) {}
+    Pin(Pin&& other) noexcept : cache_(other.cache_), entry_(other.entry_)
+    {
+        other.entry_ = NULL;
+    }
+    Pin& operator=(Pin&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            cache_ = other.cache_;
+            entry_ = other.entry_;
+            other.entry_ = NULL;
+        }
+        return *this;
+    }
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+    ~Pin()
+    {
+        reset();
+    }
+
+    /*
+     *  @brief reset    unlocks the entry now, the Pin is empty then.
+     */
+    void reset() noexcept
+    {
+        if (entry_ != NULL) {
+            (void) libcache_unlock_entry(cache_, entry_);
+            entry_ = NULL;
+        }
+    }
+
+    Value* get() const noexcept { return entry_; }
+    Value& operator*() const noexcept { return *entry_; }
+    Value* operator->() const noexcept { return entry_; }
+    explicit operator bool() const noexcept { return entry_ != NULL; }
+
+private:
+    void* cache_;
+    Value* entry_;
+};
+
+/*
+ *  @brief Cache    a cache of Value objects by Key over libcache_create_ex.
+ *
+ *  @tparam Key     trivially copyable key, key_size is sizeof(Key). With BytesHash/BytesEqual its padding,
+ *                  if any, must be zeroed, so keys with padding are rejected at compile time.
+ *  @tparam Value   nothrow movable and destructible, aligned up to LIBCACHE_CACHE_LINE_SIZE,
+ *                  entry_size is sizeof(Value).
+ *  @tparam Hash    hash of a key, size_t is folded into libcache_scale_t.
+ *  @tparam Eq      equality of two keys.
+ */
+template <typename Key, typename Value, typename Hash = BytesHash<Key>, typename Eq = BytesEqual<Key> >
+class Cache
+{
+    static_assert(std::is_trivially_copyable<Key>::value, "keys are copied bytewise by the engine");
+    static_assert(alignof(Value) <= LIBCACHE_CACHE_LINE_SIZE, "entries are aligned to a cache line only");
+    static_assert(std::is_nothrow_destructible<Value>::value, "values are destroyed by release_entry");
+    static_assert(std::is_nothrow_move_constructible<Value>::value, "values are moved into locked entries");
+
+    static constexpr bool builtin_hash = std::is_same<Hash, BytesHash<Key> >::value;
+    static constexpr bool builtin_equal = std::is_same<Eq, BytesEqual<Key> >::value;
+    static_assert(!(builtin_hash || builtin_equal) || std::has_unique_object_representations<Key>::value,
+            "BytesHash and BytesEqual need keys without padding");
+
+public:
+    /*
+     *  @brief Cache    creates the cache object.
+     *
+     *  @param max_entry_number     maximum entry number that this cache is able to store.
+     *  @param base                 other attributes, e.g. policy or index_type. Sizes, key callbacks,
+     *                              free_entry and release_entry are overridden, memory is malloc()'ed
+     *                              if page_type is LIBCACHE_PAGE_USER and allocate_memory is NULL.
+     *  NOTE:  operator bool tells whether the cache was created.
+     */
+    explicit Cache(libcache_scale_t max_entry_number, const libcache_attr_t& base = libcache_attr_t())
+    {
+        libcache_attr_t attr = base;
+        attr.max_entry_number = max_entry_number;
+        attr.entry_size = sizeof(Value);
+        attr.key_size = sizeof(Key);
+        if (attr.page_type == LIBCACHE_PAGE_USER && attr.allocate_memory == NULL) {
+            attr.allocate_memory = malloc;
+            attr.free_memory = free;
+        }
+        attr.engine = LIBCACHE_ENGINE_POOL;
+        attr.free_entry = NULL;
+        attr.release_entry = std::is_trivially_destructible<Value>::value ? NULL : release_entry;
+        if (builtin_hash) {
+            attr.key_to_number = NULL;
+            attr.hash = LIBCACHE_HASH_WY;
+        } else {
+            attr.key_to_number = key_to_number;
+            attr.hash = LIBCACHE_HASH_DEFAULT;
+        }
+        attr.cmp_key = builtin_equal ? NULL : cmp_key;
+        cache_ = libcache_create_ex(&attr);
+    }
+
+    Cache(Cache&& other) noexcept : cache_(other.cache_)
+    {
+        other.cache_ = NULL;
+    }
+    Cache& operator=(Cache&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            cache_ = other.cache_;
+            other.cache_ = NULL;
+        }
+        return *this;
+    }
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+    ~Cache()
+    {
+        destroy();
+    }
+
+    explicit operator bool() const noexcept { return cache_ != NULL; }
+
+    /*
+     *  @brief handle   the C cache object, e.g. for libcache_get_stats.
+     */
+    void* handle() const noexcept { return cache_; }
+
+    /*
+     *  @brief emplace  constructs a value of args in the entry of key.
+     *
+     *  @return         Pin of the new value, empty if it wasn't added, see insert for why.
+     *  NOTE:  A value whose constructor may throw is constructed before the entry is added, then moved in,
+     *         so an exception leaves the cache unchanged.
+     */
+    template <typename... Args>
+    Pin<Value> emplace(const Key& key, Args&&... args)
+    {
+        void* entry = NULL;
+        return add(key, &entry, std::forward<Args>(args)...) == LIBCACHE_SUCCESS ? Pin<Value>(cache_, entry)
+                : Pin<Value>();
+    }
+
+    /*
+     *  @brief insert   adds a copy of value with key.
+     *
+     *  @return         LIBCACHE_SUCCESS, or why the value wasn't added, see libcache_add_ex.
+     */
+    libcache_ret_t insert(const Key& key, const Value& value)
+    {
+        if constexpr (std::is_trivially_copyable<Value>::value) {
+            // Note: the engine copies sizeof(Value) bytes, the entry isn't locked
+            return libcache_add_ex(cache_, &key, &value, sizeof(Value), NULL);
+        } else {
+            return add(key, NULL, value);
+        }
+    }
+
+    /*
+     *  @brief insert   adds value with key by moving it in.
+     */
+    libcache_ret_t insert(const Key& key, Value&& value)
+    {
+        return add(key, NULL, std::move(value));
+    }
+
+    /*
+     *  @brief find     looks up the value of key and locks it.
+     *
+     *  @return         Pin of the value, empty if it wasn't found.
+     */
+    Pin<Value> find(const Key& key)
+    {
+        return Pin<Value>(cache_, libcache_lookup(cache_, &key, NULL));
+    }
+
+    /*
+     *  @brief get      looks up a copy of the value of key.
+     */
+    std::optional<Value> get(const Key& key)
+    {
+        if constexpr (std::is_trivially_copyable<Value>::value && std::is_default_constructible<Value>::value) {
+            // Note: copied by the engine under its lock, the entry isn't locked
+            std::optional<Value> value(std::in_place);
+            if (libcache_lookup(cache_, &key, &*value) == NULL) {
+                value.reset();
+            }
+            return value;
+        } else {
+            Pin<Value> pin = find(key);
+            return pin ? std::optional<Value>(*pin) : std::optional<Value>();
+        }
+    }
+
+    /*
+     *  @brief erase    deletes the value of key, it's destroyed at once.
+     *
+     *  @return         LIBCACHE_SUCCESS, LIBCACHE_NOT_FOUND, or LIBCACHE_LOCKED while a Pin holds it.
+     */
+    libcache_ret_t erase(const Key& key)
+    {
+        return libcache_delete_by_key(cache_, &key);
+    }
+
+    /*
+     *  @brief clear    deletes all values, every value is destroyed. No Pin must be alive.
+     */
+    libcache_ret_t clear()
+    {
+        return libcache_clean(cache_);
+    }
+
+    libcache_scale_t size() const
+    {
+        return libcache_get_entry_number(cache_);
+    }
+
+    libcache_scale_t max_size() const
+    {
+        return libcache_get_max_entry_number(cache_);
+    }
+
+private:
+    void destroy() noexcept
+    {
+        if (cache_ != NULL) {
+            (void) libcache_destroy(cache_);
+            cache_ = NULL;
+        }
+    }
+
+    // Note: the entry is locked once it's added, it's unlocked here if entry is NULL
+    template <typename... Args>
+    libcache_ret_t add(const Key& key, void** entry, Args&&... args)
+    {
+        void* added = NULL;
+        libcache_ret_t ret = LIBCACHE_SUCCESS;
+        if constexpr (std::is_nothrow_constructible<Value, Args&&...>::value) {
+            ret = libcache_add_ex(cache_, &key, NULL, sizeof(Value), &added);
+            if (ret == LIBCACHE_SUCCESS) {
+                new (added) Value(std::forward<Args>(args)...);
+            }
+        } else {
+            Value value(std::forward<Args>(args)...);
+            ret = libcache_add_ex(cache_, &key, NULL, sizeof(Value), &added);
+            if (ret == LIBCACHE_SUCCESS) {
+                new (added) Value(std::move(value));
+            }
+        }
+        if (ret == LIBCACHE_SUCCESS && entry == NULL) {
+            (void) libcache_unlock_entry(cache_, added);
+        } else if (entry != NULL) {
+            *entry = added;
+        }
+        return ret;
+    }
+
+    static void release_entry(void* key, void* entry)
+    {
+        (void) key;
+        static_cast<Value*>(entry)->~Value();
+    }
+
+    static libcache_scale_t key_to_number(const void* key)
+    {
+        uint64_t number = static_cast<uint64_t>(Hash()(*static_cast<const Key*>(key)));
+        return static_cast<libcache_scale_t>(number ^ (number >> 32));
+    }
+
+    static libcache_cmp_ret_t cmp_key(const void* key1, const void* key2)
+    {
+        return Eq()(*static_cast<const Key*>(key1), *static_cast<const Key*>(key2)) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+    }
+
+    void* cache_;
+};
+
+} // namespace libcache
+
+#endif /* LIBCACHE_HPP_ */
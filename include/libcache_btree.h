@@ -0,0 +1,111 @@
+/*
+ * libcache_btree.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_BTREE_H_
+#define LIBCACHE_BTREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libcache_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * B+tree of keys ordered by cmp_key, it's used by libcache.c only for caches created with libcache_attr_t.ordered,
+ * next to the hash index, which still finds keys by themselves. A node is a few whole cache lines,
+ * | libcache_btree_node_t | pointers | keys |, keys are copied into nodes and packed, so a binary search in a node
+ * reads the lines of its keys only, and a leaf has the item of every key, e.g. the record of an entry.
+ * Nodes are elements of one pool, a node other than the root is at least half full, a remove moves keys from
+ * a sibling or merges the node with it before it could go below that, so max_entry keys take a known number.
+ * Leaves are linked in key order for ranges. Keys are unique, an item is found by its key.
+ */
+#define LIBCACHE_BTREE_NODE_LINES 4     /* lines of a node at least, it takes more for large keys */
+#define LIBCACHE_BTREE_MIN_FANOUT 8
+
+/*
+ *  @brief libcache_btree_node_t  count keys, a leaf has an item of each in pointers, an inner node has count + 1
+ *                                children, the keys of child i + 1 are equal to key i or larger.
+ */
+typedef struct libcache_btree_node_t {
+    uint16_t count;
+    uint16_t leaf;
+    uint32_t reserved;
+    struct libcache_btree_node_t* next;  /* next leaf in key order, NULL for the last one and inner nodes */
+    void* pointers[];
+} libcache_btree_node_t;
+
+typedef struct libcache_btree_t {
+    void* pools;
+    int pool_type;                  /* nodes are elements of it */
+    LIBCACHE_CMP_KEY* cmp_key;
+    size_t key_size;
+    size_t key_stride;              /* from a key to the next one in a node */
+    size_t keys_offset;             /* from node to its keys */
+    uint32_t fanout;                /* keys a node holds */
+    uint32_t height;                /* levels of nodes, 0 if the tree is empty */
+    size_t count;                   /* keys in the tree */
+    libcache_btree_node_t* root;
+} libcache_btree_t;
+
+/* takes an item of the tree whose key is in a range, FALSE stops the range */
+typedef int LIBCACHE_BTREE_VISIT(const void* key, void* item, void* arg);
+
+/*
+ *  @brief libcache_btree_caculate_node_size   gets bytes of a node of keys of key_size, whole cache lines.
+ */
+size_t libcache_btree_caculate_node_size(size_t key_size);
+
+/*
+ *  @brief libcache_btree_caculate_node_count  gets the number of nodes max_entry keys take at most.
+ */
+size_t libcache_btree_caculate_node_count(size_t max_entry, size_t key_size);
+
+/*
+ *  @brief libcache_btree_init      makes an empty tree of nodes of pool_type, which is as large as
+ *                                  libcache_btree_caculate_node_size of key_size.
+ *
+ *  @param cmp_key                  orders keys by LIBCACHE_SMALLER, LIBCACHE_EQU and LIBCACHE_BIGER.
+ */
+void libcache_btree_init(libcache_btree_t* tree, void* pools, int pool_type, size_t key_size,
+        LIBCACHE_CMP_KEY* cmp_key);
+
+/*
+ *  @brief libcache_btree_clear     empties the tree once all its nodes are freed, e.g. by pool_reset.
+ */
+void libcache_btree_clear(libcache_btree_t* tree);
+
+/*
+ *  @brief libcache_btree_insert    adds a key and its item.
+ *
+ *  @return FALSE                   the key is in the tree, or there's no free node, the tree is valid either way.
+ */
+int libcache_btree_insert(libcache_btree_t* tree, const void* key, void* item);
+
+/*
+ *  @brief libcache_btree_remove    removes a key if its item is the one given.
+ *
+ *  @return FALSE                   the key isn't in the tree, or another item has it.
+ */
+int libcache_btree_remove(libcache_btree_t* tree, const void* key, void* item);
+
+/*
+ *  @brief libcache_btree_range     visits keys from lo to hi, both included, in order.
+ *
+ *  @param lo                       NULL from the first key.
+ *  @param hi                       NULL up to the last key.
+ *  @return FALSE                   visit stopped the range.
+ *  NOTE:  visit mustn't change the tree.
+ */
+int libcache_btree_range(const libcache_btree_t* tree, const void* lo, const void* hi, LIBCACHE_BTREE_VISIT* visit,
+        void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_BTREE_H_ */
@@ -0,0 +1,98 @@
+/*
+ * libcache_compact.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_COMPACT_H_
+#define LIBCACHE_COMPACT_H_
+#include "libcache.h"
+#include "libpool.h"
+
+/*
+ * Compact engine (LIBCACHE_ENGINE_COMPACT), it's used by libcache.c only, users choose it by
+ * libcache_attr_t.engine and call the libcache_* functions as usual.
+ * Entries are elements of one array, they're linked by 32 bits index instead of pointers, index buckets
+ * are in the same memory block, so an entry takes 32 bytes besides its entry and key.
+ * Only fixed size entries and LRU policy are supported, it can't be resized or shared.
+ */
+
+/*
+ *  @brief libcache_is_compact    checks if a cache object is made by the compact engine.
+ *  NOTE:  Both libcache_t and the compact handle start with their engine.
+ */
+static inline int libcache_is_compact(const void* libcache)
+{
+    return *(const libcache_engine_e*) libcache == LIBCACHE_ENGINE_COMPACT;
+}
+
+/*
+ *  @brief libcache_compact_create    same as libcache_create_ex.
+ *  @return NULL                      attr asks for what the engine doesn't support, or memory failed.
+ */
+void* libcache_compact_create(const libcache_attr_t* attr);
+
+/*
+ *  @brief libcache_compact_lookup    same as libcache_lookup_sized.
+ */
+void* libcache_compact_lookup(void* libcache, const void* key, void* dst_entry, size_t* entry_length);
+
+/*
+ *  @brief libcache_compact_peek    same as libcache_peek.
+ */
+void* libcache_compact_peek(void* libcache, const void* key, void* dst_entry);
+
+/*
+ *  @brief libcache_compact_add    same as libcache_add_ex, the entry is returned by entry if it isn't NULL.
+ */
+libcache_ret_t libcache_compact_add(void* libcache, const void* key, const void* src_entry, size_t entry_length,
+        void** entry);
+
+/*
+ *  @brief libcache_compact_delete_by_key    same as libcache_delete_by_key.
+ */
+libcache_ret_t libcache_compact_delete_by_key(void* libcache, const void* key);
+
+/*
+ *  @brief libcache_compact_delete_entry     same as libcache_delete_entry.
+ */
+libcache_ret_t libcache_compact_delete_entry(void* libcache, void* entry);
+
+/*
+ *  @brief libcache_compact_unlock_entry     same as libcache_unlock_entry.
+ */
+libcache_ret_t libcache_compact_unlock_entry(void* libcache, void* entry);
+
+/*
+ *  @brief libcache_compact_try_unlock_entry same as libcache_try_unlock_entry.
+ *  @return LIBCACHE_FAILURE                 it isn't the last lock, or the entry isn't in a compact cache.
+ */
+libcache_ret_t libcache_compact_try_unlock_entry(void* entry);
+
+/*
+ *  @brief libcache_compact_get_entry_key    same as libcache_get_entry_key.
+ *  @return NULL                             the entry isn't in a compact cache.
+ */
+const void* libcache_compact_get_entry_key(void* entry);
+
+size_t libcache_compact_get_entry_size(const void* libcache);
+libcache_scale_t libcache_compact_get_max_entry_number(const void* libcache);
+libcache_scale_t libcache_compact_get_entry_number(const void* libcache);
+libcache_page_e libcache_compact_get_page_type(const void* libcache);
+
+/*
+ *  @brief libcache_compact_get_pool_stats   same as libcache_get_pool_stats, elements are POOL_TYPE_DATA.
+ */
+libcache_ret_t libcache_compact_get_pool_stats(void* libcache, int pool_type, pool_stats_t* stats);
+
+/*
+ *  @brief libcache_compact_clean    same as libcache_clean.
+ */
+libcache_ret_t libcache_compact_clean(void* libcache);
+
+/*
+ *  @brief libcache_compact_destroy  same as libcache_destroy.
+ */
+libcache_ret_t libcache_compact_destroy(void* libcache);
+
+#endif /* LIBCACHE_COMPACT_H_ */
@@ -0,0 +1,51 @@
+/*
+ * libcache_compress.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_COMPRESS_H_
+#define LIBCACHE_COMPRESS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libcache_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compression of entries, it's used by libcache.c only for caches created with
+ * libcache_attr_t.compress_threshold. Entries are compressed into the LZ4 block format: sequences of
+ * literals and a match of 4 bytes or more up to 64K back, found by a hash table of 4 bytes prefixes.
+ * The table isn't cleared between entries, a position left by another entry is checked by its bytes,
+ * so compressing an entry only touches the table slots its prefixes hash to.
+ */
+#define LIBCACHE_COMPRESS_HASH_BITS 12
+#define LIBCACHE_COMPRESS_TABLE_LENGTH (sizeof(uint32_t) << LIBCACHE_COMPRESS_HASH_BITS)
+
+/*
+ *  @brief libcache_compress    compresses length bytes of src into dst.
+ *
+ *  @param table                LIBCACHE_COMPRESS_TABLE_LENGTH bytes, kept for the next entry.
+ *  @param capacity             bytes of dst, compressing stops once they're taken.
+ *  @return 0                   it doesn't fit capacity, e.g. it isn't compressible.
+ *          length              bytes of dst written.
+ */
+size_t libcache_compress(const void* src, size_t length, void* dst, size_t capacity, uint32_t* table);
+
+/*
+ *  @brief libcache_decompress  decompresses what libcache_compress wrote into length bytes of dst.
+ *
+ *  @param src_length           bytes of src readable, not less than what libcache_compress wrote.
+ *  @param length               the length compressed.
+ *  @return FALSE               src isn't length bytes compressed, dst is partly written.
+ */
+int libcache_decompress(const void* src, size_t src_length, void* dst, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_COMPRESS_H_ */
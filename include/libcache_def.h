@@ -17,6 +17,8 @@
  */
 typedef  uint32_t libcache_scale_t;
 
+#define LIBCACHE_CACHE_LINE_SIZE 64
+
 #define TRUE 1
 #define FALSE 0 
 
@@ -41,13 +43,83 @@ typedef enum
     LIBCACHE_UNLOCKED,
     LIBCACHE_FULL,
     LIBCACHE_FAILURE,
+    LIBCACHE_EXISTING,
 } libcache_ret_t;
 
+typedef enum
+{
+    LIBCACHE_INDEX_CHAINED = 0,  /* fixed 65536 buckets with chained list */
+    LIBCACHE_INDEX_OPEN,         /* linear probing slot array sized from max entry number */
+    LIBCACHE_INDEX_GROUP,        /* groups of slots probed by 16-byte control vectors, SwissTable / F14 style */
+    LIBCACHE_INDEX_GROUP_COMPACT, /* same groups of 32-bit links instead of pointers, a group is one cache line */
+} libcache_index_e;
+
+typedef enum
+{
+    LIBCACHE_POLICY_LRU = 0,     /* move to front of list on every hit */
+    LIBCACHE_POLICY_CLOCK,       /* set reference bit on hit, clock hand sweeps list when swapping */
+    LIBCACHE_POLICY_FIFO,        /* swap out the oldest added entry */
+    LIBCACHE_POLICY_SLRU,        /* segmented LRU, probation and protected segments */
+    LIBCACHE_POLICY_TINYLFU,     /* W-TinyLFU, LRU window and SLRU main space with frequency admission */
+} libcache_policy_e;
+
+typedef enum
+{
+    LIBCACHE_PAGE_USER = 0,      /* memory from allocate_memory, e.g. malloc() */
+    LIBCACHE_PAGE_NORMAL,        /* built-in mmap memory, normal pages */
+    LIBCACHE_PAGE_TRANSPARENT,   /* built-in mmap memory, madvise(MADV_HUGEPAGE) for transparent huge pages */
+    LIBCACHE_PAGE_HUGE_2M,       /* built-in mmap memory, MAP_HUGETLB with 2M pages */
+    LIBCACHE_PAGE_HUGE_1G,       /* built-in mmap memory, MAP_HUGETLB with 1G pages */
+    LIBCACHE_PAGE_SHARED,        /* built-in named shared memory segment, normal pages, see libcache_attach */
+} libcache_page_e;
+
+typedef enum
+{
+    LIBCACHE_ENGINE_POOL = 0,    /* entries and index nodes from memory pools, all features */
+    LIBCACHE_ENGINE_COMPACT,     /* entries of one array linked by 32 bits index, fixed size and LRU only */
+} libcache_engine_e;
+
+typedef enum
+{
+    LIBCACHE_STATS_NONE = 0,     /* no instrumentation */
+    LIBCACHE_STATS_COUNTERS,     /* operation counters and index probe histogram */
+    LIBCACHE_STATS_LATENCY,      /* counters, and latency histograms of lookups and adds, 2 clock reads per call */
+} libcache_stats_e;
+
+typedef enum
+{
+    LIBCACHE_HASH_DEFAULT = 0,   /* key_to_number, or LIBCACHE_HASH_WY if key_to_number is NULL */
+    LIBCACHE_HASH_WY,            /* built-in wyhash-style hash of key_size bytes */
+    LIBCACHE_HASH_CRC32C,        /* built-in CRC32C of key_size bytes, SSE4.2 / ARMv8 CRC instructions */
+} libcache_hash_e;
+
+typedef enum
+{
+    LIBCACHE_EVICT_SWAPPED = 0,  /* swapped out by policy, or dropped by libcache_resize, to make room */
+    LIBCACHE_EVICT_EXPIRED,      /* expired, see libcache_add_ttl */
+    LIBCACHE_EVICT_DELETED,      /* deleted by libcache_delete_by_key or libcache_delete_entry */
+} libcache_evict_e;
+
 typedef libcache_cmp_ret_t LIBCACHE_CMP_KEY(const void *key1, const void *key2);
 typedef void* LIBCACHE_ALLOCATE_MEMORY(size_t size);
+/* gets size bytes aligned to align on NUMA socket, -1 means any socket, e.g. rte_malloc_socket */
+typedef void* LIBCACHE_ALLOCATE_MEMORY_ON(size_t size, size_t align, int socket);
 typedef void LIBCACHE_FREE_MEMORY(void* addr);
 typedef void LIBCACHE_FREE_ENTRY(void* key, void* entry);
 typedef libcache_scale_t LIBCACHE_KEY_TO_NUMBER(const void* key);
+typedef uint32_t LIBCACHE_KEY_TO_TAG(const void* key);
+/* fills entry of key, entry_length is entry_size on input and the length loaded on output, FALSE if it failed */
+typedef int LIBCACHE_LOAD_ENTRY(const void* key, void* entry, size_t* entry_length);
+/* writes count dirty entries back, keys[i] and entries[i] of entry_lengths[i] bytes, see libcache_flush */
+typedef void LIBCACHE_FLUSH_ENTRIES(const void* const keys[], const void* const entries[],
+        const size_t entry_lengths[], int count);
+/* takes count copies of entries which left the cache, keys[i] and entries[i] of entry_lengths[i] bytes */
+typedef void LIBCACHE_EVICTED_ENTRIES(const void* const keys[], const void* const entries[],
+        const size_t entry_lengths[], const libcache_evict_e reasons[], int count);
+/* writes the secondary key of an entry of entry_length bytes into key, FALSE if the entry has none */
+typedef int LIBCACHE_EXTRACT_KEY(const void* entry, size_t entry_length, void* key);
+/* takes an entry of entry_length bytes in a range of keys, FALSE stops the range, see libcache_range */
+typedef int LIBCACHE_RANGE_ENTRY(const void* key, const void* entry, size_t entry_length, void* arg);
 
 #ifdef DEBUG
 #define DEBUG_INFO(fmt, ...) \
@@ -62,5 +134,6 @@ typedef libcache_scale_t LIBCACHE_KEY_TO_NUMBER(const void* key);
 
 #define likely(x)       __builtin_expect(!!(x), 1)
 #define unlikely(x)     __builtin_expect(!!(x), 0)
+#define prefetch(x)     __builtin_prefetch((x))
 
 #endif /* LIBCACHE_DEF_H_ */
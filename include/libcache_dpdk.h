@@ -0,0 +1,61 @@
+/*
+ * libcache_dpdk.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_DPDK_H_
+#define LIBCACHE_DPDK_H_
+
+/*
+ * Adapter of DPDK, it's included by a DPDK application only, the library itself doesn't depend on DPDK.
+ * Caches get memory from rte_malloc_socket on the socket of their lcore and a set has a cache of every
+ * enabled lcore, indexed by rte_lcore_id(), e.g. for an rx loop:
+ *
+ *     void* cache = libcache_dpdk_lcore_cache(set);
+ *     uint16_t n = rte_eth_rx_burst(port, queue, packets, LIBCACHE_BURST_MAX);
+ *     ... keys[i] of packets[i] ...
+ *     libcache_lookup_burst(cache, keys, n, &hit_mask, entries);
+ */
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include "libcache_local.h"
+
+static inline void* libcache_dpdk_allocate(size_t size, size_t align, int socket)
+{
+    return rte_malloc_socket("libcache", size, (unsigned) align, socket);
+}
+
+static inline void libcache_dpdk_free(void* addr)
+{
+    rte_free(addr);
+}
+
+static inline int libcache_dpdk_lcore_socket(uint32_t lcore)
+{
+    return rte_lcore_is_enabled(lcore) ? (int) rte_lcore_to_socket_id(lcore) : LIBCACHE_WORKER_NONE;
+}
+
+/*
+ *  @brief libcache_dpdk_create     creates a cache of attr for every enabled lcore, its memory is got from
+ *                                  rte_malloc_socket on the socket of the lcore, allocators of attr are ignored.
+ */
+static inline void* libcache_dpdk_create(const libcache_attr_t* attr)
+{
+    libcache_attr_t dpdk_attr = *attr;
+    dpdk_attr.page_type = LIBCACHE_PAGE_USER;
+    dpdk_attr.allocate_memory = NULL;
+    dpdk_attr.allocate_memory_on = libcache_dpdk_allocate;
+    dpdk_attr.free_memory = libcache_dpdk_free;
+    return libcache_local_create(&dpdk_attr, RTE_MAX_LCORE, libcache_dpdk_lcore_socket);
+}
+
+/*
+ *  @brief libcache_dpdk_lcore_cache     gets the cache of the calling lcore, NULL on a thread of no lcore.
+ */
+static inline void* libcache_dpdk_lcore_cache(const void* local)
+{
+    return libcache_local_get(local, rte_lcore_id());
+}
+
+#endif /* LIBCACHE_DPDK_H_ */
@@ -0,0 +1,118 @@
+/*
+ * libcache_filter.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_FILTER_H_
+#define LIBCACHE_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libcache_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cuckoo filter of the keys in an index, it's used by hash.c only for caches created with
+ * libcache_attr_t.negative_filter. A key is known by the 32 bits tag the index hashes it to, it has a 16 bits
+ * fingerprint in one of 2 buckets of LIBCACHE_FILTER_SLOTS, the other bucket is got from the fingerprint,
+ * so a fingerprint is moved (kicked) to it without the key. Unlike a Bloom filter a key can be removed,
+ * entries are swapped out all the time. A missing key is found absent by one or two cache lines,
+ * about 1 in 8000 is found present by a false match, a key which is in the index is never found absent.
+ */
+#define LIBCACHE_FILTER_SLOTS 4
+#define LIBCACHE_FILTER_MAX_KICKS 500
+
+typedef struct libcache_filter_t {
+    uint32_t bucket_mask;
+    uint32_t count;       /* fingerprints in the filter */
+    uint32_t overflowed;  /* an add didn't fit, every key is present until the filter is cleared */
+    uint32_t kick;        /* slot the next kick takes a fingerprint from */
+    uint16_t buckets[][LIBCACHE_FILTER_SLOTS];  /* 0 means an empty slot */
+} libcache_filter_t;
+
+/*
+ *  @brief libcache_filter_caculate_length  gets the length of a filter for max_entry keys, about 4 bytes a key,
+ *                                          buckets are at most half full.
+ */
+size_t libcache_filter_caculate_length(size_t max_entry);
+
+/*
+ *  @brief libcache_filter_init     makes an empty filter in memory of libcache_filter_caculate_length bytes.
+ */
+void libcache_filter_init(libcache_filter_t* filter, size_t max_entry);
+
+/*
+ *  @brief libcache_filter_clear    removes all keys.
+ */
+void libcache_filter_clear(libcache_filter_t* filter);
+
+/*
+ *  @brief libcache_filter_add      adds the tag of a key, a key is added once while it's in the index.
+ *
+ *  @return TRUE                    the tag was added.
+ *          FALSE                   no slot was found in LIBCACHE_FILTER_MAX_KICKS kicks, the filter overflowed.
+ */
+int libcache_filter_add(libcache_filter_t* filter, uint32_t tag);
+
+/*
+ *  @brief libcache_filter_remove   removes the tag of a key which was added.
+ */
+void libcache_filter_remove(libcache_filter_t* filter, uint32_t tag);
+
+static inline uint32_t libcache_filter_mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+// Note: the tag is multiplicative, its high bits are mixed the best, the bucket is got from all bits
+static inline uint16_t libcache_filter_fingerprint(uint32_t tag)
+{
+    uint16_t fingerprint = (uint16_t) (tag >> 16);
+    return (0 == fingerprint) ? 1 : fingerprint;
+}
+
+static inline uint32_t libcache_filter_bucket(const libcache_filter_t* filter, uint32_t tag)
+{
+    return libcache_filter_mix(tag) & filter->bucket_mask;
+}
+
+static inline uint32_t libcache_filter_alternate(const libcache_filter_t* filter, uint32_t bucket,
+        uint16_t fingerprint)
+{
+    return (bucket ^ (fingerprint * 0x5bd1e995U)) & filter->bucket_mask;
+}
+
+static inline int libcache_filter_bucket_has(const libcache_filter_t* filter, uint32_t bucket, uint16_t fingerprint)
+{
+    const uint16_t* slots = filter->buckets[bucket];
+    return slots[0] == fingerprint || slots[1] == fingerprint || slots[2] == fingerprint || slots[3] == fingerprint;
+}
+
+/*
+ *  @brief libcache_filter_contains  checks if the key of a tag may be in the index.
+ *
+ *  @return FALSE                    the key isn't in the index, it needn't be probed.
+ *          TRUE                     the key may be in the index.
+ */
+static inline int libcache_filter_contains(const libcache_filter_t* filter, uint32_t tag)
+{
+    uint16_t fingerprint = libcache_filter_fingerprint(tag);
+    uint32_t bucket = libcache_filter_bucket(filter, tag);
+    return unlikely(filter->overflowed) || libcache_filter_bucket_has(filter, bucket, fingerprint)
+            || libcache_filter_bucket_has(filter, libcache_filter_alternate(filter, bucket, fingerprint), fingerprint);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_FILTER_H_ */
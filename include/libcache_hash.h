@@ -0,0 +1,229 @@
+/*
+ * libcache_hash.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_HASH_H_
+#define LIBCACHE_HASH_H_
+#include <string.h>
+#include "libcache_def.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#include <arm_acle.h>
+#endif
+
+/*
+ * Built-in hashers over the key_size bytes of a key, used when attr.key_to_number is NULL, see libcache_attr_t.
+ * LIBCACHE_HASH_WY is a wyhash-style 64-bit hash: 64x64->128 bit multiplies fold 16 bytes a round,
+ * keys sharing long prefixes, e.g. IMSIs, still spread over all bits.
+ * LIBCACHE_HASH_CRC32C is CRC32C (Castagnoli); it's inlined with SSE4.2 or ARMv8 CRC instructions
+ * if the compiler targets them, otherwise libcache_hash_crc32c_any picks them at run time.
+ */
+#define LIBCACHE_HASH_SEED_0 0xa0761d6478bd642fULL
+#define LIBCACHE_HASH_SEED_1 0xe7037ed1a0b428dbULL
+
+static inline void libcache_hash_mum(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+static inline uint64_t libcache_hash_mix(uint64_t a, uint64_t b)
+{
+    libcache_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t libcache_hash_read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t libcache_hash_read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ *  @brief libcache_hash_wy    64-bit wyhash-style hash of length bytes.
+ */
+static inline uint64_t libcache_hash_wy(const void* key, size_t length, uint64_t seed)
+{
+    const uint8_t* p = (const uint8_t*) key;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    seed ^= libcache_hash_mix(seed ^ LIBCACHE_HASH_SEED_0, LIBCACHE_HASH_SEED_1);
+    if (likely(length <= 16)) {
+        if (length >= 4) {
+            // Note: two overlapping 4-byte reads from each end cover 4..16 bytes
+            size_t shift = (length >> 3) << 2;
+            a = (libcache_hash_read32(p) << 32) | libcache_hash_read32(p + shift);
+            b = (libcache_hash_read32(p + length - 4) << 32) | libcache_hash_read32(p + length - 4 - shift);
+        } else if (length > 0) {
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[length >> 1] << 8) | p[length - 1];
+        }
+    } else {
+        size_t i = length;
+        while (i > 16) {
+            seed = libcache_hash_mix(libcache_hash_read64(p) ^ LIBCACHE_HASH_SEED_1, libcache_hash_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = libcache_hash_read64(p + i - 16);
+        b = libcache_hash_read64(p + i - 8);
+    }
+    a ^= LIBCACHE_HASH_SEED_1;
+    b ^= seed;
+    libcache_hash_mum(&a, &b);
+    return libcache_hash_mix(a ^ LIBCACHE_HASH_SEED_0 ^ length, b ^ LIBCACHE_HASH_SEED_1);
+}
+
+/*
+ *  @brief libcache_hash_crc32c_any    CRC32C of length bytes, hardware instructions if the CPU has them.
+ */
+uint32_t libcache_hash_crc32c_any(const void* key, size_t length);
+
+/*
+ *  @brief libcache_hash_crc32c    CRC32C of length bytes, crc32c("123456789") is 0xe3069283.
+ */
+static inline uint32_t libcache_hash_crc32c(const void* key, size_t length)
+{
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    const uint8_t* p = (const uint8_t*) key;
+    uint64_t crc = 0xffffffffU;
+    for (; length >= 8; length -= 8, p += 8) {
+        crc = _mm_crc32_u64(crc, libcache_hash_read64(p));
+    }
+    for (; length > 0; length--, p++) {
+        crc = _mm_crc32_u8((uint32_t) crc, *p);
+    }
+    return ~(uint32_t) crc;
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    const uint8_t* p = (const uint8_t*) key;
+    uint32_t crc = 0xffffffffU;
+    for (; length >= 8; length -= 8, p += 8) {
+        crc = __crc32cd(crc, libcache_hash_read64(p));
+    }
+    for (; length > 0; length--, p++) {
+        crc = __crc32cb(crc, *p);
+    }
+    return ~crc;
+#else
+    return libcache_hash_crc32c_any(key, length);
+#endif
+}
+
+/*
+ *  @brief libcache_hash_resolve    resolves attr.hash, LIBCACHE_HASH_DEFAULT means key_to_number is called.
+ */
+static inline libcache_hash_e libcache_hash_resolve(libcache_hash_e hash, LIBCACHE_KEY_TO_NUMBER* key_to_number)
+{
+    return (hash == LIBCACHE_HASH_DEFAULT && NULL == key_to_number) ? LIBCACHE_HASH_WY : hash;
+}
+
+/*
+ *  @brief libcache_hash_number    built-in replacement of key_to_number, hasher isn't LIBCACHE_HASH_DEFAULT.
+ */
+static inline libcache_scale_t libcache_hash_number(libcache_hash_e hasher, const void* key, size_t length)
+{
+    if (hasher == LIBCACHE_HASH_CRC32C) {
+        return libcache_hash_crc32c(key, length);
+    }
+    uint64_t h = libcache_hash_wy(key, length, 0);
+    return (libcache_scale_t) (h ^ (h >> 32));
+}
+
+/*
+ * Built-in key compares, used when attr.cmp_key is NULL: keys are equal if their key_size bytes are,
+ * so padding of key structs must be zeroed. 8, 16 and 32-byte keys are compared in registers,
+ * a 128-bit SSE2 compare for 16 bytes and an AVX2 one for 32 bytes if the compiler targets it,
+ * other sizes by memcmp. The compare is chosen once at create, libcache_key_equal inlines it.
+ */
+typedef enum
+{
+    LIBCACHE_KEY_CMP_USER = 0,   /* cmp_key */
+    LIBCACHE_KEY_CMP_BYTES,      /* memcmp of key_size bytes */
+    LIBCACHE_KEY_CMP_8,
+    LIBCACHE_KEY_CMP_16,
+    LIBCACHE_KEY_CMP_32,
+} libcache_key_cmp_e;
+
+/*
+ *  @brief libcache_key_cmp_select    picks the compare of keys of key_size bytes.
+ */
+static inline libcache_key_cmp_e libcache_key_cmp_select(LIBCACHE_CMP_KEY* cmp_key, size_t key_size)
+{
+    if (NULL != cmp_key) {
+        return LIBCACHE_KEY_CMP_USER;
+    }
+    switch (key_size) {
+    case 8:
+        return LIBCACHE_KEY_CMP_8;
+    case 16:
+        return LIBCACHE_KEY_CMP_16;
+    case 32:
+        return LIBCACHE_KEY_CMP_32;
+    default:
+        return LIBCACHE_KEY_CMP_BYTES;
+    }
+}
+
+static inline int libcache_key_equal_16(const uint8_t* key1, const uint8_t* key2)
+{
+#if defined(__SSE2__)
+    __m128i a = _mm_loadu_si128((const __m128i*) key1);
+    __m128i b = _mm_loadu_si128((const __m128i*) key2);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff;
+#else
+    return ((libcache_hash_read64(key1) ^ libcache_hash_read64(key2))
+            | (libcache_hash_read64(key1 + 8) ^ libcache_hash_read64(key2 + 8))) == 0;
+#endif
+}
+
+/*
+ *  @brief libcache_key_equal    tells if 2 keys are equal by the compare of libcache_key_cmp_select.
+ */
+static inline int libcache_key_equal(libcache_key_cmp_e cmp, LIBCACHE_CMP_KEY* cmp_key, size_t key_size,
+        const void* key1, const void* key2)
+{
+    const uint8_t* a = (const uint8_t*) key1;
+    const uint8_t* b = (const uint8_t*) key2;
+    switch (cmp) {
+    case LIBCACHE_KEY_CMP_USER:
+        return cmp_key(key1, key2) == LIBCACHE_EQU;
+    case LIBCACHE_KEY_CMP_8:
+        return libcache_hash_read64(a) == libcache_hash_read64(b);
+    case LIBCACHE_KEY_CMP_16:
+        return libcache_key_equal_16(a, b);
+    case LIBCACHE_KEY_CMP_32:
+#if defined(__AVX2__)
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) a),
+                _mm256_loadu_si256((const __m256i*) b))) == -1;
+#else
+        return libcache_key_equal_16(a, b) & libcache_key_equal_16(a + 16, b + 16);
+#endif
+    default:
+        return memcmp(a, b, key_size) == 0;
+    }
+}
+
+#endif /* LIBCACHE_HASH_H_ */
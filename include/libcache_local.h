@@ -0,0 +1,52 @@
+/*
+ * libcache_local.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_LOCAL_H_
+#define LIBCACHE_LOCAL_H_
+#include "libcache.h"
+
+/*
+ * A local cache set has a cache of its own for every worker, e.g. a DPDK lcore or a thread pinned to a core.
+ * A worker only uses its own cache, so nothing is locked and no line of a cache moves between cores, unlike
+ * a sharded cache every thread may use. A key may be in the caches of several workers, so a set suits workers
+ * which get keys of their own, e.g. flows spread to queues by RSS. Every cache gets its memory on the socket
+ * of its worker, see libcache_attr_t.allocate_memory_on, and libcache_dpdk.h for an lcore set of DPDK memory.
+ */
+#define LIBCACHE_WORKER_NONE (-2)
+
+/* gets the NUMA socket of a worker, -1 means any socket, LIBCACHE_WORKER_NONE means the worker has no cache */
+typedef int LIBCACHE_WORKER_SOCKET(uint32_t worker);
+
+/*
+ *  @brief libcache_local_create    creates a cache of attr for every worker.
+ *
+ *  @param attr                     attributes of every cache, see libcache_attr_t, max_entry_number is a cache's.
+ *  @param workers                  number of workers, worker ids are 0 to workers - 1.
+ *  @param worker_socket            NULL: every cache is on numa_node_mask of attr, otherwise numa_node_mask of
+ *                                  a cache is the socket of its worker, 0 if it's -1.
+ *  @return NULL                    failed to create.
+ *          pointer                 pointer of a local cache set.
+ */
+void* libcache_local_create(const libcache_attr_t* attr, uint32_t workers, LIBCACHE_WORKER_SOCKET* worker_socket);
+
+/*
+ *  @brief libcache_local_get       gets the cache of a worker, it's used by libcache functions.
+ *
+ *  @return NULL                    the worker has no cache, or it isn't a worker of the set.
+ */
+void* libcache_local_get(const void* local, uint32_t worker);
+
+/*
+ *  @brief libcache_local_get_workers       gets the number of workers of the set.
+ */
+uint32_t libcache_local_get_workers(const void* local);
+
+/*
+ *  @brief libcache_local_destroy   destroys the caches of all workers, no worker can use its cache any more.
+ */
+libcache_ret_t libcache_local_destroy(void* local);
+
+#endif /* LIBCACHE_LOCAL_H_ */
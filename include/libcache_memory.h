@@ -0,0 +1,95 @@
+/*
+ * libcache_memory.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_MEMORY_H_
+#define LIBCACHE_MEMORY_H_
+#include "libcache_def.h"
+
+/*
+ * Built-in memory of a cache, it's mapped from the system with normal, transparent huge
+ * or huge pages, and can be bound to NUMA nodes, so the TLB covers more entries and
+ * the memory is local to the cores using the cache.
+ */
+
+/*
+ *  @brief libcache_memory_map      maps memory for a cache.
+ *
+ *  @param length                   length of memory, bytes.
+ *  @param page_type                page type expected, it falls back to smaller pages if it fails.
+ *  @param numa_node_mask           NUMA nodes (bit n for node n) memory is bound to, 0 means no binding.
+ *  @param mapped_page_type         output, page type memory really is on.
+ *  @return NULL                    failed to map or bind the memory.
+ *          pointer                 the memory, it's filled with 0.
+ */
+void* libcache_memory_map(size_t length, libcache_page_e page_type, uint64_t numa_node_mask,
+        libcache_page_e* mapped_page_type);
+
+struct libcache_attr_t;
+
+/*
+ *  @brief libcache_memory_allocator   tells if attr has an allocator, allocate_memory or allocate_memory_on.
+ */
+int libcache_memory_allocator(const struct libcache_attr_t* attr);
+
+/*
+ *  @brief libcache_memory_allocate    gets memory of a cache from allocate_memory_on of attr, aligned to a cache line
+ *                                     on the lowest node of numa_node_mask, -1 if it's 0, or from allocate_memory.
+ *
+ *  @return NULL                       no memory.
+ */
+void* libcache_memory_allocate(const struct libcache_attr_t* attr, size_t length);
+
+/*
+ *  @brief libcache_memory_unmap    unmaps memory got by libcache_memory_map.
+ *
+ *  @param memory                   the memory.
+ *  @param length                   same as libcache_memory_map's.
+ *  @param mapped_page_type         page type got from libcache_memory_map.
+ */
+void libcache_memory_unmap(void* memory, size_t length, libcache_page_e mapped_page_type);
+
+/*
+ *  @brief libcache_memory_map_shared      creates a named shared memory segment and maps it writable.
+ *
+ *  @param name                            name of the segment, see shm_open, it mustn't exist.
+ *  @param length                          length of the segment, bytes.
+ *  @return NULL                           failed to create or map the segment.
+ *          pointer                        the memory, it's filled with 0.
+ */
+void* libcache_memory_map_shared(const char* name, size_t length);
+
+/*
+ *  @brief libcache_memory_attach_shared   maps an existing named shared memory segment read only.
+ *
+ *  @param name                            name of the segment.
+ *  @param address                         address to map it at, NULL means anywhere.
+ *  @param length                          output, length of the segment.
+ *  @return NULL                           no such segment, or address is in use.
+ *          pointer                        the memory.
+ */
+void* libcache_memory_attach_shared(const char* name, void* address, size_t* length);
+
+/*
+ *  @brief libcache_memory_unmap_shared    unmaps a shared memory segment, unlinks it if name isn't NULL.
+ */
+void libcache_memory_unmap_shared(void* memory, size_t length, const char* name);
+
+/*
+ *  @brief libcache_memory_map_file        maps a whole file read only, it's read ahead sequentially.
+ *
+ *  @param path                            path of the file.
+ *  @param length                          output, length of the file.
+ *  @return NULL                           no such file, it's empty, or it failed to map.
+ *          pointer                        the memory.
+ */
+const void* libcache_memory_map_file(const char* path, size_t* length);
+
+/*
+ *  @brief libcache_memory_unmap_file      unmaps a file mapped by libcache_memory_map_file.
+ */
+void libcache_memory_unmap_file(const void* memory, size_t length);
+
+#endif /* LIBCACHE_MEMORY_H_ */
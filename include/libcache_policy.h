@@ -0,0 +1,65 @@
+/*
+ * libcache_policy.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_POLICY_H_
+#define LIBCACHE_POLICY_H_
+
+#include "libcache_def.h"
+#include "list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every unlocked entry of a cache is owned by its replacement policy, the node's usr_data
+ * starts with libcache_policy_entry_t. The node's previous_node / next_node can only be
+ * used by the policy, e.g. to link it into policy lists.
+ */
+typedef struct libcache_policy_entry_t {
+    uint32_t hash;   /* mixed hash of the key, e.g. for frequency sketch */
+    uint32_t state;  /* policy private, it's 0 for a new key and kept while the entry is locked */
+} libcache_policy_entry_t;
+
+#define LIBCACHE_POLICY_ENTRY(node) ((libcache_policy_entry_t*) (node)->usr_data)
+
+/*
+ *  @brief libcache_policy_ops_t   replacement policy of unlocked entries.
+ *
+ *  @field name             name of the policy.
+ *  @field data_size        size of policy data for max_entry_number entries, bytes.
+ *  @field init             init policy data, it's also called by libcache_clean.
+ *  @field on_insert        an entry becomes unlocked: it's new, or the last lock was released.
+ *  @field on_hit           an unlocked entry was looked up.
+ *  @field on_remove        an entry leaves the policy: it's deleted or locked.
+ *  @field select_victim    choose an entry to swap out, NULL when there isn't any entry.
+ *  @field on_evict         the entry returned by select_victim is swapped out.
+ */
+typedef struct libcache_policy_ops_t {
+    const char* name;
+    size_t (*data_size)(libcache_scale_t max_entry_number);
+    void (*init)(void* data, libcache_scale_t max_entry_number);
+    void (*on_insert)(void* data, node_t* node);
+    void (*on_hit)(void* data, node_t* node);
+    void (*on_remove)(void* data, node_t* node);
+    node_t* (*select_victim)(void* data);
+    void (*on_evict)(void* data, node_t* node);
+} libcache_policy_ops_t;
+
+/*
+ *  @brief libcache_policy_get   gets a built-in replacement policy.
+ *
+ *  @param policy                LIBCACHE_POLICY_LRU / CLOCK / FIFO / SLRU / TINYLFU.
+ *  @return NULL                 unknown policy.
+ *          pointer              the policy.
+ */
+const libcache_policy_ops_t* libcache_policy_get(libcache_policy_e policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_POLICY_H_ */
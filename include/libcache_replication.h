@@ -0,0 +1,155 @@
+/*
+ * libcache_replication.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_REPLICATION_H_
+#define LIBCACHE_REPLICATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libcache_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Change log of caches created with libcache_attr_t.replication, e.g. to keep the cache of a standby warm:
+ * the cache puts a record of every add, delete and eviction into a ring, a consumer thread copies records out
+ * of it and ships them, and libcache_replication_apply replays them on the standby's cache.
+ * The ring has one producer, the thread writing the cache, and one consumer, neither waits for the other,
+ * nothing is locked and no memory is got once it's created. A record which doesn't fit in a full ring is
+ * dropped, its sequence number is skipped though, so the standby sees the gap, it then loads an image of
+ * libcache_save taken after libcache_replication_get_sequence, and applies records from that sequence on:
+ *
+ *     primary, by the thread writing the cache     standby
+ *     sequence = get_sequence(ring);
+ *     libcache_save(cache, path);                   cache = libcache_load(path, attr), next = sequence;
+ *     consumer thread
+ *     length = consume(ring, buffer, size);   ->    apply(cache, buffer, length, &next);
+ */
+#define LIBCACHE_REPLICATION_ALIGN 8
+
+typedef enum libcache_replication_e
+{
+    LIBCACHE_REPLICATION_ADD = 1,       /* the entry of the key is added, it replaces one of the same key */
+    LIBCACHE_REPLICATION_DELETE,        /* the entry of the key is gone, why is reason */
+    LIBCACHE_REPLICATION_CLEAN,         /* every entry is gone, see libcache_clean */
+    LIBCACHE_REPLICATION_INVALIDATE_TAG,/* entries of the tag argument are gone, see libcache_invalidate_tag */
+} libcache_replication_e;
+
+/*
+ *  @brief libcache_replication_record_t  a record of the log, key_size bytes of key and entry_length bytes of
+ *                                        entry follow it, an entry of an add only.
+ *
+ *  @field sequence         sequence number, one more than the previous record's, records dropped included.
+ *  @field type             libcache_replication_e.
+ *  @field reason           libcache_evict_e of a delete.
+ *  @field argument         ttl of an add, 0 if it never expires, or the tag of an invalidation.
+ *  @field length           bytes of the record with its key and entry, aligned to LIBCACHE_REPLICATION_ALIGN.
+ */
+typedef struct libcache_replication_record_t
+{
+    uint64_t sequence;
+    uint8_t type;
+    uint8_t reason;
+    uint16_t key_size;
+    uint32_t entry_length;
+    uint32_t argument;
+    uint32_t length;
+} libcache_replication_record_t;
+
+/*
+ *  @brief libcache_replication_create    creates a ring of records of keys and entries up to the given sizes.
+ *
+ *  @param capacity                       records the ring holds, rounded up to a power of 2.
+ *  @param key_size                       key_size of the cache, up to UINT16_MAX.
+ *  @param entry_size                     entry_size of the cache.
+ *  @return NULL                          invalid parameter, or failed to get memory.
+ */
+void* libcache_replication_create(uint32_t capacity, size_t key_size, size_t entry_size);
+
+/*
+ *  @brief libcache_replication_destroy   frees the ring, the cache using it must be destroyed first.
+ */
+void libcache_replication_destroy(void* ring);
+
+/*
+ *  @brief libcache_replication_get_key_size    gets key_size the ring was created with.
+ */
+size_t libcache_replication_get_key_size(const void* ring);
+
+/*
+ *  @brief libcache_replication_get_entry_size  gets entry_size the ring was created with.
+ */
+size_t libcache_replication_get_entry_size(const void* ring);
+
+/*
+ *  @brief libcache_replication_get_sequence    gets the sequence number of the next record, a snapshot taken by
+ *                                              the thread writing the cache right after it has every record before.
+ */
+uint64_t libcache_replication_get_sequence(const void* ring);
+
+/*
+ *  @brief libcache_replication_get_dropped     gets the number of records dropped as the ring was full.
+ */
+uint64_t libcache_replication_get_dropped(const void* ring);
+
+/*
+ *  @brief libcache_replication_get_record_size gets the largest length of a record, the least buffer to consume.
+ */
+size_t libcache_replication_get_record_size(const void* ring);
+
+/*
+ *  @brief libcache_replication_reserve   takes the next sequence number for a record, it's filled and published
+ *                                        by libcache_replication_commit, it's done by the cache.
+ *
+ *  @return NULL                          the ring is full, the record is dropped.
+ *          pointer                       entry_length bytes for the entry, following the key.
+ */
+void* libcache_replication_reserve(void* ring, libcache_replication_e type, libcache_evict_e reason,
+        const void* key, size_t entry_length, uint32_t argument);
+
+/*
+ *  @brief libcache_replication_commit    publishes the record reserved, the consumer may copy it then.
+ */
+void libcache_replication_commit(void* ring);
+
+/*
+ *  @brief libcache_replication_consume   copies the oldest records of the ring into buffer, whole records only.
+ *
+ *  @param buffer                         records are copied back to back, in the order of their sequence numbers.
+ *  @param length                         bytes of buffer.
+ *  @return                               bytes copied, 0 if the ring is empty.
+ *  NOTE:  It's called by one consumer thread, while the thread writing the cache puts records.
+ */
+size_t libcache_replication_consume(void* ring, void* buffer, size_t length);
+
+/*
+ *  @brief libcache_replication_apply     replays records consumed from the ring of a primary on a cache whose
+ *                                        key_size, entry_size, ttl and tags are the primary's, by its functions.
+ *
+ *  @param libcache                       the cache, e.g. a standby's one loaded from an image of the primary.
+ *  @param batch                          records given by libcache_replication_consume, aligned as the buffer
+ *                                        they were copied into, keys and entries are used where they are.
+ *  @param length                         bytes of batch.
+ *  @param next_sequence                  in: sequence number of the next record expected, records before it are
+ *                                        skipped. out: the one after the last record applied.
+ *  @return
+ *      LIBCACHE_SUCCESS                  every record is applied.
+ *      LIBCACHE_NOT_FOUND                records from next_sequence are missing, a new image is loaded then.
+ *      LIBCACHE_LOCKED                   the key of the record next_sequence is locked, it's applied again later.
+ *      LIBCACHE_FULL                     every entry is locked, the add of next_sequence can't take any room.
+ *      LIBCACHE_FAILURE                  invalid parameter, or a record isn't valid for the cache.
+ *  NOTE:  Ttls go on from the cache's clock, not the primary's.
+ */
+libcache_ret_t libcache_replication_apply(void* libcache, const void* batch, size_t length,
+        uint64_t* next_sequence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_REPLICATION_H_ */
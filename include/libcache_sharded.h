@@ -0,0 +1,164 @@
+/*
+ * libcache_sharded.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_SHARDED_H_
+#define LIBCACHE_SHARDED_H_
+#include "libcache.h"
+
+/*
+ * A sharded cache is thread-safe, it's made of independent caches (shards), every shard has
+ * its own memory, replacement policy and lock. A key always goes to the same shard, so threads
+ * working on keys of different shards never contend.
+ * With libcache_attr_t.combining, adds, deletes and unlocks of a contended shard are combined: every
+ * writer posts its request to a slot of its core in the shard, the one taking the shard lock does all
+ * requests posted meanwhile and the others just wait for theirs, so the shard's lock, policy, pools and
+ * buckets are written by one core at a time in a batch instead of bouncing between cores for every write.
+ * A combiner calls evicted_entries and release_entry of entries of other threads' requests.
+ */
+
+/*
+ *  @brief libcache_sharded_create    creates a sharded cache object
+ *
+ *  @param attr                       attributes of the cache object, see libcache_attr_t.
+ *                                    max_entry_number is the total of all shards, it's split evenly.
+ *  @param shard_number               number of shards, it's rounded up to power of 2, 0 means 1.
+ *  @return NULL                      failed to create.
+ *          pointer                   pointer of a sharded cache object.
+ */
+void* libcache_sharded_create(const libcache_attr_t* attr, uint32_t shard_number);
+
+/*
+ *  @brief libcache_sharded_lookup   same as libcache_lookup, but it's thread-safe.
+ *  NOTE:  A locked entry can be read and written without any lock, it won't be swapped out
+ *         or deleted until libcache_sharded_unlock_entry is called, which can be called by any thread.
+ *         A copied out entry is read under the shard lock.
+ */
+void* libcache_sharded_lookup(void* sharded, const void* key, void* dst_entry);
+
+/*
+ *  @brief libcache_sharded_read     copies out an entry with a given key without taking the shard lock.
+ *
+ *  @param sharded                   sharded cache object, cannot be NULL.
+ *  @param key                       key, cannot be NULL.
+ *  @param dst_entry                 a copy of entry that fetch by key, cannot be NULL,
+ *                                   entry_size bytes with libcache_attr_t.hot_keys.
+ *  @return NULL                     didn't find out such entry with the key.
+ *          pointer                  dst_entry.
+ *  NOTE:  Readers never block each other or writers, a read overlapped by an add/delete of the same shard
+ *         is retried, it falls back to libcache_sharded_lookup after several retries.
+ *         Replacement policy isn't told about the hit, so frequently read entries should also be
+ *         looked up by libcache_sharded_lookup from time to time under LRU like policies.
+ *         A locked entry written by its holder may be copied out partially written, same as libcache_sharded_lookup.
+ *         A hot key of libcache_attr_t.hot_keys is copied from the replica of the core, shared by no other core,
+ *         an add, delete or unlock of the key makes its replicas stale, clean and invalidate_tag make them all
+ *         stale. Swap out doesn't, the replica of an entry swapped out is read until the key is written again.
+ */
+void* libcache_sharded_read(void* sharded, const void* key, void* dst_entry);
+
+/*
+ *  @brief libcache_sharded_add      same as libcache_add, but it's thread-safe.
+ */
+void* libcache_sharded_add(void* sharded, const void* key, const void* src_entry);
+
+/*
+ *  @brief libcache_sharded_lookup_or_add   same as libcache_lookup_or_add, but it's thread-safe.
+ *  NOTE:  The entry is locked either way, libcache_sharded_unlock_entry unlocks it.
+ */
+void* libcache_sharded_lookup_or_add(void* sharded, const void* key, int* inserted);
+
+/*
+ *  @brief libcache_sharded_lookup_or_load  same as libcache_lookup_or_load, but it's thread-safe.
+ *  NOTE:  load_entry is called without the shard lock. Threads missing a key being loaded by another thread
+ *         wait for that load instead of calling load_entry themselves, and get the same result, so a key
+ *         is loaded once however many threads miss it at the same time.
+ *         The entry is locked either way, libcache_sharded_unlock_entry unlocks it.
+ */
+void* libcache_sharded_lookup_or_load(void* sharded, const void* key, int* loaded);
+
+/*
+ *  @brief libcache_sharded_lookup_async   same as libcache_lookup_async, but it's thread-safe.
+ *  NOTE:  handle.entry of the waiter is unlocked by libcache_sharded_unlock_entry.
+ */
+libcache_ret_t libcache_sharded_lookup_async(void* sharded, const void* key, libcache_load_waiter_t* waiter);
+
+/*
+ *  @brief libcache_sharded_load_complete  same as libcache_load_complete, but it's thread-safe, waiters are
+ *                                         notified by the calling thread after the shard lock is released.
+ */
+libcache_ret_t libcache_sharded_load_complete(void* sharded, libcache_load_waiter_t* loader, size_t entry_length,
+        int loaded);
+
+/*
+ *  @brief libcache_sharded_delete_by_key    same as libcache_delete_by_key, but it's thread-safe.
+ */
+libcache_ret_t libcache_sharded_delete_by_key(void* sharded, const void* key);
+
+/*
+ *  @brief libcache_sharded_delete_entry     same as libcache_delete_entry, but it's thread-safe.
+ */
+libcache_ret_t libcache_sharded_delete_entry(void* sharded, void* entry);
+
+/*
+ *  @brief libcache_sharded_unlock_entry     same as libcache_unlock_entry, but it's thread-safe.
+ *  NOTE:  Replicas of the key are stale afterwards if it's hot, the holder may have written the entry.
+ */
+libcache_ret_t libcache_sharded_unlock_entry(void* sharded, void* entry);
+
+/*
+ *  @brief libcache_sharded_mark_dirty     same as libcache_mark_dirty, but it's thread-safe.
+ */
+libcache_ret_t libcache_sharded_mark_dirty(void* sharded, void* entry);
+
+/*
+ *  @brief libcache_sharded_flush  same as libcache_flush, every shard is flushed under its lock in turn.
+ *  NOTE:  flush_entries is called under the shard lock, other shards go on meanwhile.
+ */
+int libcache_sharded_flush(void* sharded, int budget);
+
+/*
+ *  @brief libcache_sharded_drain_evictions  same as libcache_drain_evictions, every shard is drained under its lock
+ *                                           in turn.
+ *  NOTE:  A batch is per shard, a full one is delivered by the thread evicting one more from the shard.
+ */
+int libcache_sharded_drain_evictions(void* sharded);
+
+/*
+ *  @brief libcache_sharded_get_shard_number gets the number of shards.
+ */
+uint32_t libcache_sharded_get_shard_number(const void* sharded);
+
+/*
+ *  @brief libcache_sharded_get_max_entry_number    gets the total capacity of all shards.
+ */
+libcache_scale_t libcache_sharded_get_max_entry_number(void* sharded);
+
+/*
+ *  @brief libcache_sharded_get_entry_number        gets the number of entries all shards store.
+ */
+libcache_scale_t libcache_sharded_get_entry_number(void* sharded);
+
+/*
+ *  @brief libcache_sharded_get_stats        sums counters of all shards, every shard is read under its lock,
+ *                                           replica_hits is summed over replicas of every core.
+ */
+libcache_ret_t libcache_sharded_get_stats(void* sharded, libcache_stats_t* stats);
+
+/*
+ *  @brief libcache_sharded_clean    same as libcache_clean, every shard is cleaned under its lock.
+ */
+libcache_ret_t libcache_sharded_clean(void* sharded);
+
+/*
+ *  @brief libcache_sharded_invalidate_tag  same as libcache_invalidate_tag, for every shard under its lock in turn.
+ */
+libcache_ret_t libcache_sharded_invalidate_tag(void* sharded, uint32_t tag);
+
+/*
+ *  @brief libcache_sharded_destroy  destroys all shards, no thread can use the cache any more.
+ */
+libcache_ret_t libcache_sharded_destroy(void* sharded);
+
+#endif /* LIBCACHE_SHARDED_H_ */
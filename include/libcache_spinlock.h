@@ -0,0 +1,61 @@
+/*
+ * libcache_spinlock.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_SPINLOCK_H_
+#define LIBCACHE_SPINLOCK_H_
+#include <sched.h>
+#include "libcache_def.h"
+
+/*
+ * Spin lock: test and test-and-set, a waiter spins on a plain load and yields CPU after a while,
+ * so a preempted holder can get CPU back when threads are more than cores.
+ * NOTE:  sched_yield needs _POSIX_C_SOURCE in C99, define it before any include.
+ */
+#define LIBCACHE_SPIN_COUNT 64
+
+typedef struct libcache_spinlock_t {
+    uint32_t locked;
+} libcache_spinlock_t;
+
+static inline void libcache_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline void libcache_spin_lock(libcache_spinlock_t* lock)
+{
+    uint32_t spin = 0;
+    while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)) {
+            if (likely(++spin < LIBCACHE_SPIN_COUNT)) {
+                libcache_cpu_relax();
+            } else {
+                spin = 0;
+                sched_yield();
+            }
+        }
+    }
+}
+
+/*
+ *  @brief libcache_spin_trylock  takes the lock if it's free, it never waits.
+ *
+ *  @return FALSE           the lock is held by someone else.
+ */
+static inline int libcache_spin_trylock(libcache_spinlock_t* lock)
+{
+    return !__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)
+            && !__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void libcache_spin_unlock(libcache_spinlock_t* lock)
+{
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+#endif /* LIBCACHE_SPINLOCK_H_ */
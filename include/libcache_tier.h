@@ -0,0 +1,126 @@
+/*
+ * libcache_tier.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_TIER_H_
+#define LIBCACHE_TIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libcache_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cold tier of caches created with libcache_attr_t.cold_tier: entries swapped out of a cache are demoted into
+ * it instead of being dropped, a load of a missing key reads it back from there before the backend.
+ * Entries are appended to a log in a file, e.g. on local NVMe or a DAX mapped PMEM file system, the log is
+ * written by whole segments of LIBCACHE_TIER_SEGMENT_SIZE, the one being filled is in memory. It's circular,
+ * once it wraps, the oldest segment is overwritten, so the oldest demoted entries are dropped then.
+ * An entry is in a cache or in its cold tier, never in both: a promoted one is removed from the tier, adds and
+ * deletes of a key remove its copy. The index in memory maps 64 bits fingerprints of keys to log positions,
+ * 24 bytes an entry, keys themselves aren't kept, two keys of the same fingerprint are the same key to it.
+ * One tier can be shared by caches, e.g. the shards of a sharded cache, functions take its lock.
+ */
+#define LIBCACHE_TIER_SEGMENT_SIZE (1024 * 1024)
+
+/*
+ *  @brief libcache_tier_location_t  where an entry is in the log file, see libcache_lookup_async.
+ *
+ *  @field offset           offset of the entry in the file, -1 if the entry isn't in the file.
+ *  @field entry_length     bytes of the entry.
+ */
+typedef struct libcache_tier_location_t
+{
+    int64_t offset;
+    size_t entry_length;
+} libcache_tier_location_t;
+
+/*
+ *  @brief libcache_tier_create    creates a cold tier of entries of up to entry_size bytes.
+ *
+ *  @param path                    file of the log, it's created or truncated, and kept by libcache_tier_destroy.
+ *  @param file_size               bytes of the log, rounded down to segments, 2 segments at least.
+ *  @param max_entry_number        entries the index holds, demotions fail once it's full.
+ *  @return NULL                   invalid parameter, or failed to create the file or to get memory.
+ */
+void* libcache_tier_create(const char* path, size_t file_size, libcache_scale_t max_entry_number,
+        size_t entry_size);
+
+/*
+ *  @brief libcache_tier_destroy   closes the file and frees the index, caches using the tier must be destroyed first.
+ */
+void libcache_tier_destroy(void* tier);
+
+/*
+ *  @brief libcache_tier_get_fd    gets the file descriptor of the log, e.g. to read an entry by io_uring.
+ */
+int libcache_tier_get_fd(const void* tier);
+
+/*
+ *  @brief libcache_tier_get_entry_size    gets entry_size the tier was created with.
+ */
+size_t libcache_tier_get_entry_size(const void* tier);
+
+/*
+ *  @brief libcache_tier_get_entry_number  gets the number of entries in the tier.
+ */
+libcache_scale_t libcache_tier_get_entry_number(void* tier);
+
+/*
+ *  @brief libcache_tier_put       demotes an entry, it replaces the one of the same key.
+ *
+ *  @return FALSE                  the index is full, or the entry is larger than the tier was created for.
+ */
+int libcache_tier_put(void* tier, const void* key, size_t key_size, const void* entry, size_t entry_length);
+
+/*
+ *  @brief libcache_tier_reserve   same as libcache_tier_put, entry_length bytes returned are filled by the caller
+ *                                 before the next call of the tier.
+ *  @return NULL                   same as FALSE of libcache_tier_put.
+ */
+void* libcache_tier_reserve(void* tier, const void* key, size_t key_size, size_t entry_length);
+
+/*
+ *  @brief libcache_tier_read      copies the entry of a key into entry, the file is read if it isn't in memory.
+ *
+ *  @param entry                   entry_size bytes of the tier.
+ *  @param entry_length            output, bytes of the entry.
+ *  @return FALSE                  the key isn't in the tier, or it failed to read, entry may be written then.
+ *  NOTE:  The file is read without the lock.
+ */
+int libcache_tier_read(void* tier, const void* key, size_t key_size, void* entry, size_t* entry_length);
+
+/*
+ *  @brief libcache_tier_locate    finds where the entry of a key is, an entry in memory is copied instead.
+ *
+ *  @param entry                   entry_size bytes, the entry is copied there if it's in memory.
+ *  @param location                output, offset is -1 if the entry is copied.
+ *  @return FALSE                  the key isn't in the tier.
+ *  NOTE:  An entry read from the file by the caller is valid if the read ends before the log wraps onto it,
+ *         i.e. before the file size less one segment of entries are demoted.
+ */
+int libcache_tier_locate(void* tier, const void* key, size_t key_size, void* entry,
+        libcache_tier_location_t* location);
+
+/*
+ *  @brief libcache_tier_remove    removes the entry of a key.
+ *
+ *  @return FALSE                  the key isn't in the tier.
+ */
+int libcache_tier_remove(void* tier, const void* key, size_t key_size);
+
+/*
+ *  @brief libcache_tier_clear     removes every entry.
+ */
+void libcache_tier_clear(void* tier);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_TIER_H_ */
@@ -0,0 +1,89 @@
+/*
+ * libcache_ttl.h
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#ifndef LIBCACHE_TTL_H_
+#define LIBCACHE_TTL_H_
+
+#include "libcache_def.h"
+#include "list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hierarchical timing wheel of expiring entries, it's used by libcache.c only for caches created with
+ * libcache_attr_t.ttl. Times are ticks of the user's clock given to libcache_expire, 32 bits.
+ * Level L has LIBCACHE_TTL_SLOTS slots of 64^L ticks each, an entry is linked in the slot of its expiry
+ * at the lowest level whose range covers it, and moved one level down (cascaded) when the wheel reaches
+ * its slot, so an entry is touched at most LIBCACHE_TTL_LEVELS times before it expires.
+ * Slot bitmaps let the wheel jump over empty slots, the cost doesn't grow with the ticks passed.
+ */
+#define LIBCACHE_TTL_LEVELS 4
+#define LIBCACHE_TTL_SLOT_BITS 6
+#define LIBCACHE_TTL_SLOTS (1U << LIBCACHE_TTL_SLOT_BITS)
+/* entries expiring farther are parked in the top level, then placed again once the wheel reaches them */
+#define LIBCACHE_TTL_RANGE (1U << (LIBCACHE_TTL_SLOT_BITS * LIBCACHE_TTL_LEVELS))
+#define LIBCACHE_TTL_UNLINKED 0xFFFF
+
+/*
+ * Expiry of an entry, embedded in its record.
+ */
+typedef struct libcache_ttl_entry_t {
+    node_t wheel_node;   /* must be the first member, linked in a slot while it's armed, usr_data is the owner's */
+    uint32_t expire_at;  /* 0: never expires */
+    uint16_t slot;       /* level * LIBCACHE_TTL_SLOTS + index, LIBCACHE_TTL_UNLINKED if it isn't armed */
+    uint16_t reserved;
+} libcache_ttl_entry_t;
+
+typedef struct libcache_ttl_wheel_t {
+    uint32_t clock;     /* latest time given, entries expiring up to it are expired */
+    uint32_t now;       /* time the wheel reached, entries expiring up to it are in slot now of level 0 */
+    uint32_t count;     /* armed entries */
+    uint32_t reserved;
+    uint64_t occupied[LIBCACHE_TTL_LEVELS];  /* bit i of level L: slot i of level L isn't empty */
+    list_t slots[LIBCACHE_TTL_LEVELS * LIBCACHE_TTL_SLOTS];
+} libcache_ttl_wheel_t;
+
+/*
+ *  @brief libcache_ttl_init     empties the wheel, both its clock and time are clock.
+ */
+void libcache_ttl_init(libcache_ttl_wheel_t* wheel, uint32_t clock);
+
+/*
+ *  @brief libcache_ttl_arm      links an entry which isn't armed, of a non-zero expire_at, into the wheel.
+ *                               An entry already expired goes to the slot the wheel is at, it's due at once.
+ */
+void libcache_ttl_arm(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t* entry);
+
+/*
+ *  @brief libcache_ttl_disarm   unlinks an entry from the wheel if it's armed.
+ */
+void libcache_ttl_disarm(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t* entry);
+
+/*
+ *  @brief libcache_ttl_advance  moves the wheel towards its clock until an entry is due.
+ *
+ *  @return NULL                 no entry expires up to the clock.
+ *          pointer              wheel_node of an expired entry, it stays armed, the caller disarms it.
+ *  NOTE:  Time stops at the first due entry, so every call takes amortized O(1) per entry expired
+ *         or cascaded, besides O(LIBCACHE_TTL_LEVELS) per slot holding entries.
+ */
+node_t* libcache_ttl_advance(libcache_ttl_wheel_t* wheel);
+
+/*
+ *  @brief libcache_ttl_expired  checks if an entry has expired by the clock of the wheel.
+ */
+static inline int libcache_ttl_expired(const libcache_ttl_wheel_t* wheel, const libcache_ttl_entry_t* entry)
+{
+    return 0 != entry->expire_at && entry->expire_at <= wheel->clock;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHE_TTL_H_ */
@@ -13,21 +13,32 @@ typedef struct pool_cb_t {
     LIBCACHE_FREE_MEMORY* free_memory;
 } pool_cb_t;
 
+/* free elements are a LIFO stack linked by element index, POOL_INDEX_NONE ends it */
+#define POOL_INDEX_NONE 0xFFFFFFFFU
+
 typedef struct element_pool_t {
-    list_t free_list;
-    long long  element_size;
+    long long element_size;
     long long element_acount;
-} __attribute__((packed)) element_pool_t;
+    long long elements_offset; /* from pool head to the first element */
+    long long high_water; /* elements from it on have never been handed out */
+    long long peak;       /* high water before the latest pool_reset */
+    uint32_t free_head; /* index of the last freed element */
+    uint32_t free_count;
+    unsigned long long get_total;  /* elements got since pools_init */
+    unsigned long long free_total; /* elements freed since pools_init */
+    unsigned long long fail_total; /* pool_get_element returned NULL */
+} element_pool_t;
 
 typedef struct element_usr_data_t{
-    node_t* to_node;
     void* reserved_pointer;
-    int check_value;
-} __attribute__((packed)) element_usr_data_t;
+    uint32_t next_free; /* index of next free element, only valid while element is free */
+    uint32_t check_value;
+} element_usr_data_t;
 
 typedef struct pool_attr_t {
     size_t entry_size;
     libcache_scale_t entry_acount;
+    size_t entry_align; /* alignment of every element, 0 means no extra alignment */
 } pool_attr_t;
 
 typedef enum {
@@ -40,15 +51,39 @@ typedef enum {
     POOL_TYPE_HASH_T,
     POOL_TYPE_BUCKET_T,
     POOL_TYPE_HASH_DATA_T,
+    POOL_TYPE_POLICY_DATA,
+    POOL_TYPE_ENTRY_SLAB,
+    POOL_TYPE_TTL_WHEEL,
+    POOL_TYPE_EVICTED_BATCH,
+    POOL_TYPE_FILTER,
+    POOL_TYPE_SECONDARY_KEYS,
+    POOL_TYPE_COMPRESS,
+    POOL_TYPE_BTREE,
+    POOL_TYPE_BTREE_NODE,
+    POOL_TYPE_TAGS,
     POOL_TYPE_MAX,
 } pool_type_e;
 
+/*
+ * Occupancy of a pool. Elements held by magazines are in use from the pool's view.
+ */
+typedef struct pool_stats_t {
+    size_t element_size;       /* bytes every element takes, with header and alignment */
+    unsigned long long capacity;
+    unsigned long long in_use;
+    unsigned long long peak;   /* most elements in use at once, later elements have never been touched */
+    unsigned long long get_total;
+    unsigned long long free_total;
+    unsigned long long fail_total;
+} pool_stats_t;
+
 size_t pool_caculate_total_length(int pool_acount, pool_attr_t pool_attr[]);
 
 /**
  * @fn pools_init
  *
- * @brief Init memory to pool..
+ * @brief Init memory to pool.. Only pool heads are written, an element is initialized
+ *        when it's got the first time, so pages of large_memory are touched on demand.
  * @param [in] large_memory   - a memory pointer
  * @param [in] large_mem_size - size of the memory
  * @param [in] pool_count     - count of pools
@@ -61,7 +96,7 @@ void* pools_init(void* large_memory, size_t large_mem_size, int pool_count, pool
 /**
  * @fn pool_get_element
  *
- * @brief get an unused element memory.
+ * @brief get an unused element memory, a freed one first, then a never used one.
  * @param [in] pools     - pools handle
  * @param [in] pool_type - the type of pool
  * @return -  a point to element memory (NULL for failed)
@@ -97,6 +132,180 @@ return_t pool_set_reserved_pointer(void* element, void* to_set);
  */
 void* pool_get_reserved_pointer(void* element);
 
+/**
+ * @fn pool_get_stats
+ *
+ * @brief get occupancy and counters of a pool
+ * @param [in] pools     - pools handle
+ * @param [in] pool_type - the type of pool
+ * @param [out] stats    - occupancy of the pool
+ * @return -  OK / ERR
+ */
+return_t pool_get_stats(void* pools, int pool_type, pool_stats_t* stats);
+
+/**
+ * @fn pool_get_element_at
+ *
+ * @brief get an element by its index in memory order, it may be in use or free.
+ *        Elements from high water on have never been handed out, they aren't got.
+ * @param [in] pools     - pools handle
+ * @param [in] pool_type - the type of pool
+ * @param [in] index     - index of the element
+ * @return -  a point to element memory (NULL when the element has never been handed out)
+ */
+void* pool_get_element_at(void* pools, int pool_type, uint32_t index);
+
+/**
+ * @fn pool_reset
+ *
+ * @brief free all elements of a pool at once, elements in use are not walked.
+ *        Elements got before become invalid, no magazine may hold elements of the pool.
+ * @param [in] pools     - pools handle
+ * @param [in] pool_type - the type of pool
+ */
+void pool_reset(void* pools, int pool_type);
+
+/*
+ * Slab: variable size elements from size classes, the smallest class is POOL_SLAB_MIN_SIZE bytes,
+ * every class is about POOL_SLAB_GROWTH_FACTOR (1.25) times of the previous one, the largest is
+ * max_element_size. Memory is cut into slabs of POOL_SLAB_SIZE bytes (or larger if the largest class
+ * needs), a class takes a never used slab when it has no free element. Slabs are never given back,
+ * so a freed element can only be got again in the same class.
+ * Elements have same header as pool elements, so pool_set_reserved_pointer / pool_get_reserved_pointer
+ * work on them.
+ */
+#define POOL_SLAB_MIN_SIZE 16
+#define POOL_SLAB_GROWTH_FACTOR 1.25
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_SLAB_MAX_CLASSES 64
+
+/**
+ * @fn pool_slab_caculate_length
+ *
+ * @brief get memory length of a slab allocator
+ * @param [in] memory_size      - bytes of memory to cut into slabs
+ * @param [in] max_element_size - size of the largest element
+ * @return length, bytes
+ */
+size_t pool_slab_caculate_length(size_t memory_size, size_t max_element_size);
+
+/**
+ * @fn pool_slab_init
+ *
+ * @brief init a slab allocator on memory, pages are touched on demand, same as pools_init.
+ * @param [in] memory           - memory of pool_slab_caculate_length bytes, 8 bytes aligned
+ * @param [in] memory_size      - same as pool_slab_caculate_length's
+ * @param [in] max_element_size - same as pool_slab_caculate_length's
+ * @return -  slab handle, return NULL when failed
+ */
+void* pool_slab_init(void* memory, size_t memory_size, size_t max_element_size);
+
+/**
+ * @fn pool_slab_get_element
+ *
+ * @brief get an unused element of the smallest class which is not smaller than size.
+ * @param [in] slab - slab handle
+ * @param [in] size - bytes needed, not larger than max_element_size
+ * @return -  a point to element memory (NULL for failed)
+ */
+void* pool_slab_get_element(void* slab, size_t size);
+
+/**
+ * @fn pool_slab_free_element
+ *
+ * @brief free an element got from pool_slab_get_element.
+ * @param [in] slab    - slab handle
+ * @param [in] element - the element to free
+ */
+void pool_slab_free_element(void* slab, void* element);
+
+/**
+ * @fn pool_slab_get_element_size
+ *
+ * @brief get size of the class an element is in.
+ * @param [in] slab    - slab handle
+ * @param [in] element - the element
+ * @return -  bytes the element can hold
+ */
+size_t pool_slab_get_element_size(const void* slab, const void* element);
+
+/**
+ * @fn pool_slab_reset
+ *
+ * @brief free all elements at once, every slab is never used again, same as pool_reset.
+ * @param [in] slab    - slab handle
+ */
+void pool_slab_reset(void* slab);
+
+/*
+ * Magazines: every thread caches free elements of every pool type in two magazines (stacks)
+ * of its own, so most gets and frees don't touch any shared memory. A thread exchanges a whole
+ * magazine of elements with the depot, i.e. the pool free lists under per pool type locks,
+ * when both of its magazines are empty (get) or full (free).
+ * NOTE:  Once pools are shared by magazines, pool_get_element / pool_free_element can't be used
+ *        on them any more without the caller serializing all threads.
+ */
+#define POOL_MAGAZINE_SIZE 32
+
+/**
+ * @fn pool_depot_create
+ *
+ * @brief create the depot of pools, magazines of all threads exchange elements with it.
+ * @param [in] pools           - pools handle
+ * @param [in] pool_count      - count of pools
+ * @param [in] allocate_memory - function to allocate depot and magazines, e.g. malloc().
+ * @param [in] free_memory     - function to free depot and magazines, e.g. free().
+ * @return -  depot handle (NULL for failed)
+ */
+void* pool_depot_create(void* pools, int pool_count, LIBCACHE_ALLOCATE_MEMORY* allocate_memory,
+        LIBCACHE_FREE_MEMORY* free_memory);
+
+/**
+ * @fn pool_depot_destroy
+ *
+ * @brief destroy the depot, all magazines of it must be destroyed before.
+ * @param [in] depot - depot handle
+ */
+void pool_depot_destroy(void* depot);
+
+/**
+ * @fn pool_magazine_create
+ *
+ * @brief create magazines of a thread, they can only be used by the thread.
+ * @param [in] depot - depot handle
+ * @return -  magazines handle (NULL for failed)
+ */
+void* pool_magazine_create(void* depot);
+
+/**
+ * @fn pool_magazine_destroy
+ *
+ * @brief give elements cached in magazines back to depot, then destroy the magazines.
+ * @param [in] magazine - magazines handle
+ */
+void pool_magazine_destroy(void* magazine);
+
+/**
+ * @fn pool_magazine_get_element
+ *
+ * @brief same as pool_get_element, but it gets element from magazines of the thread.
+ * @param [in] magazine  - magazines handle
+ * @param [in] pool_type - the type of pool
+ * @return -  a point to element memory (NULL for failed)
+ */
+void* pool_magazine_get_element(void* magazine, int pool_type);
+
+/**
+ * @fn pool_magazine_free_element
+ *
+ * @brief same as pool_free_element, but it frees element into magazines of the thread.
+ *        Element got by another thread can be freed.
+ * @param [in] magazine  - magazines handle
+ * @param [in] pool_type - the type of pool
+ * @param [in] element   - the element to free
+ */
+void pool_magazine_free_element(void* magazine, int pool_type, void* element);
+
 #ifdef __cplusplus
 }
 #endif
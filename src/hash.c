@@ -13,6 +13,10 @@
 #include "hash.h"
 #include "libpool.h"
 
+#if !defined(__SSE2__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 void hash_free_node(node_t* node, void* pool_handle)
 {
     hash_data_t* hd = (hash_data_t*) node->usr_data;
@@ -26,18 +30,122 @@ void hash_free_node(node_t* node, void* pool_handle)
     return;
 }
 
+int hash_caculate_slot_bits(size_t max_entry)
+{
+    int bits = HASH_MIN_SLOT_BITS;
+    // Note: keep load factor under 3/4
+    while (((size_t) 1 << bits) * 3 < max_entry * 4) {
+        bits++;
+    }
+    return bits;
+}
+
+static int hash_caculate_groups_bits(u32 group_slots, size_t max_entry)
+{
+    int bits = HASH_MIN_GROUP_BITS;
+    // Note: keep load factor under 7/8
+    while (((size_t) group_slots << bits) * 7 < max_entry * 8) {
+        bits++;
+    }
+    return bits;
+}
+
+int hash_caculate_group_bits(size_t max_entry)
+{
+    return hash_caculate_groups_bits(HASH_GROUP_SLOTS, max_entry);
+}
+
+int hash_caculate_bucket_bits(size_t max_entry)
+{
+    int bits = HASH_MIN_BUCKET_BITS;
+    while (((size_t) 1 << bits) < max_entry && bits < HASH_MAX_BUCKET_BITS) {
+        bits++;
+    }
+    return bits;
+}
+
+size_t hash_caculate_buckets_length(libcache_index_e index_type, size_t max_entry)
+{
+    if (index_type == LIBCACHE_INDEX_OPEN) {
+        return sizeof(hash_slot_t) * ((size_t) 1 << hash_caculate_slot_bits(max_entry));
+    }
+    if (index_type == LIBCACHE_INDEX_GROUP) {
+        return sizeof(hash_group_t) * ((size_t) 1 << hash_caculate_group_bits(max_entry));
+    }
+    if (index_type == LIBCACHE_INDEX_GROUP_COMPACT) {
+        return sizeof(hash_group_compact_t)
+                * ((size_t) 1 << hash_caculate_groups_bits(HASH_GROUP_COMPACT_SLOTS, max_entry));
+    }
+    return sizeof(bucket_t) * ((size_t) 1 << hash_caculate_bucket_bits(max_entry));
+}
+
+size_t hash_caculate_lists_count(libcache_index_e index_type, size_t max_entry)
+{
+    if (index_type != LIBCACHE_INDEX_CHAINED) {
+        return 0;
+    }
+    size_t buckets = (size_t) 1 << hash_caculate_bucket_bits(max_entry);
+    return (max_entry < buckets) ? max_entry : buckets;
+}
+
 void* hash_init(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMBER* key_to_num, void *pool_handle)
+{
+    return hash_init_ex(key_size, key_cmp, key_to_num, LIBCACHE_INDEX_CHAINED, HASH_BUCKETS, pool_handle);
+}
+
+void* hash_init_ex(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMBER* key_to_num,
+        libcache_index_e index_type, size_t max_entry, void *pool_handle)
 {
     hash_t* hash = (hash_t*) pool_get_element(pool_handle, POOL_TYPE_HASH_T);
-    hash->bucket_list = (bucket_t*) pool_get_element(pool_handle, POOL_TYPE_BUCKET_T);
     hash->entry_count = 0;
     hash->key_size = key_size;
     hash->kcmp = key_cmp;
+    hash->key_cmp = libcache_key_cmp_select(key_cmp, key_size);
     hash->k2num = key_to_num;
-    hash->max_buckets = HASH_BUCKETS;
+    hash->hasher = LIBCACHE_HASH_DEFAULT;
+    hash->index_type = index_type;
+    hash->bucket_list = NULL;
+    hash->slot_list = NULL;
+    hash->group_list = NULL;
+    hash->max_buckets = 0;
+    hash->bucket_bits = 0;
+    hash->slot_bits = 0;
+    hash->slot_mask = 0;
+    hash->group_bits = 0;
+    hash->group_mask = 0;
+    hash->group_slots = 0;
+    hash->group_shift = 0;
+    hash->link_base = NULL;
+    hash->deletions = 0;
+    hash->filter = NULL;
+
+    if (index_type == LIBCACHE_INDEX_OPEN) {
+        hash->slot_list = (hash_slot_t*) pool_get_element(pool_handle, POOL_TYPE_BUCKET_T);
+        hash->slot_bits = hash_caculate_slot_bits(max_entry);
+        hash->slot_mask = ((u32) 1 << hash->slot_bits) - 1;
+        memset(hash->slot_list, 0, sizeof(hash_slot_t) * (hash->slot_mask + 1));
+        return hash;
+    }
+    if (index_type == LIBCACHE_INDEX_GROUP || index_type == LIBCACHE_INDEX_GROUP_COMPACT) {
+        int compact = (index_type == LIBCACHE_INDEX_GROUP_COMPACT);
+        // Note: a compact group index is a group one whose link_base is set, every group path takes both
+        hash->index_type = LIBCACHE_INDEX_GROUP;
+        hash->group_list = (hash_group_t*) pool_get_element(pool_handle, POOL_TYPE_BUCKET_T);
+        hash->group_slots = compact ? HASH_GROUP_COMPACT_SLOTS : HASH_GROUP_SLOTS;
+        hash->group_shift = __builtin_ctz(compact ? sizeof(hash_group_compact_t) : sizeof(hash_group_t));
+        hash->link_base = compact ? (char*) pool_handle : NULL;
+        hash->group_bits = hash_caculate_groups_bits(hash->group_slots, max_entry);
+        hash->group_mask = ((u32) 1 << hash->group_bits) - 1;
+        memset(hash->group_list, 0, (size_t) (hash->group_mask + 1) << hash->group_shift);
+        return hash;
+    }
+
+    hash->bucket_list = (bucket_t*) pool_get_element(pool_handle, POOL_TYPE_BUCKET_T);
+    hash->bucket_bits = hash_caculate_bucket_bits(max_entry);
+    hash->max_buckets = 1 << hash->bucket_bits;
 
     int i = 0;
-    while (i < HASH_BUCKETS) {
+    while (i < hash->max_buckets) {
         hash->bucket_list[i].list_count = 0;
         hash->bucket_list[i].list = NULL;
         i++;
@@ -45,44 +153,457 @@ void* hash_init(size_t key_size, LIBCACHE_CMP_KEY* key_cmp, LIBCACHE_KEY_TO_NUMB
     return hash;
 }
 
-void* hash_add(void* hash_table, const void* key, void* hash_node, void* cache_node, void* pool_handle)
+void hash_set_hasher(void* hash, libcache_hash_e hasher)
 {
-    hash_t* hash = (hash_t*) hash_table;
-    u32 hash_code = key_to_hash(hash, key);
-    if (hash_code >= hash->max_buckets) {
-        DEBUG_ERROR("hash key is invalid: %d", hash_code);
-        return NULL;
+    ((hash_t*) hash)->hasher = hasher;
+}
+
+void hash_set_filter(void* hash, libcache_filter_t* filter)
+{
+    ((hash_t*) hash)->filter = filter;
+}
+
+// Note: a key missing from the filter is surely missing from the index, it isn't probed
+static inline int hash_filter_absent(const hash_t* hash, u32 tag)
+{
+    return NULL != hash->filter && !libcache_filter_contains(hash->filter, tag);
+}
+
+static inline void hash_filter_add(hash_t* hash, u32 tag)
+{
+    if (unlikely(NULL != hash->filter)) {
+        libcache_filter_add(hash->filter, tag);
     }
+}
+
+static node_t* hash_new_node(hash_t* hash, const void* key, u32 tag, void* hash_node, void* cache_node, void* pool_handle)
+{
     node_t* node = (node_t*) hash_node;
     if (node == NULL) {
         node = (node_t*) pool_get_element(pool_handle, POOL_TYPE_NODE_T);
-        node->usr_data = (hash_data_t*) pool_get_element(pool_handle, POOL_TYPE_HASH_DATA_T);
-        ((hash_data_t*) node->usr_data)->key = pool_get_element(pool_handle, POOL_TYPE_KEY_SIZE);
+        hash_data_t* hash_data = (hash_data_t*) pool_get_element(pool_handle, POOL_TYPE_HASH_DATA_T);
+        void* key_buffer = pool_get_element(pool_handle, POOL_TYPE_KEY_SIZE);
+        if (unlikely(node == NULL || hash_data == NULL || key_buffer == NULL)) {
+            DEBUG_ERROR("no memory for hash node");
+            pool_free_element(pool_handle, POOL_TYPE_NODE_T, node);
+            pool_free_element(pool_handle, POOL_TYPE_HASH_DATA_T, hash_data);
+            pool_free_element(pool_handle, POOL_TYPE_KEY_SIZE, key_buffer);
+            return NULL;
+        }
+        node->usr_data = hash_data;
+        hash_data->key = key_buffer;
     }
 
     memset(((hash_data_t*) node->usr_data)->key, 0, hash->key_size);
     memcpy(((hash_data_t*) node->usr_data)->key, key, hash->key_size);
 
     ((hash_data_t*) node->usr_data)->cache_node_ptr = cache_node;
+    ((hash_data_t*) node->usr_data)->hash_tag = tag;
     node->next_node = NULL;
     node->previous_node = NULL;
+    return node;
+}
+
+static inline u32 hash_open_empty_slot(const hash_t* hash, u32 tag)
+{
+    u32 i = tag_to_slot(hash, tag);
+    while (hash->slot_list[i].node != NULL) {
+        i = (i + 1) & hash->slot_mask;
+    }
+    return i;
+}
+
+static void* hash_open_insert(hash_t* hash, u32 i, u32 tag, const void* key, void* hash_node, void* cache_node,
+        void* pool_handle)
+{
+    node_t* node = hash_new_node(hash, key, tag, hash_node, cache_node, pool_handle);
+    if (unlikely(node == NULL)) {
+        return NULL;
+    }
+    hash->slot_list[i].hash_tag = tag;
+    hash->slot_list[i].node = node;
+    hash->entry_count++;
+    hash_filter_add(hash, tag);
+    DEBUG_INFO("Add hash key successfully,slot:%d", i);
+    return node;
+}
+
+// Note: one slot is always left empty, it stops the probe of a missing key
+static inline int hash_open_full(const hash_t* hash)
+{
+    if (unlikely((u32) hash->entry_count >= hash->slot_mask)) {
+        DEBUG_ERROR("hash slot array is full: %d", hash->entry_count);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void* hash_open_add(hash_t* hash, const void* key, void* hash_node, void* cache_node, void* pool_handle)
+{
+    if (hash_open_full(hash)) {
+        return NULL;
+    }
+    u32 tag = key_to_tag(hash, key);
+    return hash_open_insert(hash, hash_open_empty_slot(hash, tag), tag, key, hash_node, cache_node, pool_handle);
+}
+
+static void* hash_open_del(hash_t* hash, const void* key, void* hash_node)
+{
+    u32 i = tag_to_slot(hash, key_to_tag(hash, key));
+    while (hash->slot_list[i].node != hash_node) {
+        if (unlikely(hash->slot_list[i].node == NULL)) {
+            DEBUG_ERROR("delete hash fail: hash node isn't in slot array");
+            return NULL;
+        }
+        i = (i + 1) & hash->slot_mask;
+    }
+
+    // Note: backward shift the following slots, so no tombstone is needed
+    u32 j = i;
+    while (1) {
+        j = (j + 1) & hash->slot_mask;
+        hash_slot_t* slot = &hash->slot_list[j];
+        if (slot->node == NULL) {
+            break;
+        }
+        u32 home = tag_to_slot(hash, slot->hash_tag);
+        if (((j - home) & hash->slot_mask) >= ((j - i) & hash->slot_mask)) {
+            hash->slot_list[i] = *slot;
+            i = j;
+        }
+    }
+    hash->slot_list[i].node = NULL;
+    hash->slot_list[i].hash_tag = 0;
+    hash->entry_count--;
+    hash->deletions++;
+    return hash_node;
+}
+
+// Note: probes counts slots examined, callers not asking for it pass a local, it's optimized out,
+//       so is position if it's NULL
+static inline void* hash_open_find(hash_t* hash, const void* key, u32 tag, u32* probes, hash_position_t* position)
+{
+    u32 i = tag_to_slot(hash, tag);
+    hash_slot_t* slot = &hash->slot_list[i];
+    while (slot->node) {
+        (*probes)++;
+        if (slot->hash_tag == tag && hash_key_equal(hash, key, ((hash_data_t*) slot->node->usr_data)->key)) {
+            return slot->node;
+        }
+        i = (i + 1) & hash->slot_mask;
+        slot = &hash->slot_list[i];
+    }
+    if (position != NULL) {
+        position->index = i;
+    }
+    return NULL;
+}
+
+/*
+ * Group index, see hash_group_t and hash_group_compact_t. A match mask has a bit for every slot whose control byte
+ * equals the byte, hash_group_mask_slot gives the lowest slot of a mask, mask & (mask - 1) drops it.
+ */
+#if defined(__SSE2__)
+typedef u32 hash_group_mask_t;
+#define HASH_GROUP_MASK_SHIFT 0
+#define HASH_GROUP_MASK_SLOTS(slots) ((1U << (slots)) - 1)
+
+static inline hash_group_mask_t hash_group_match(const hash_t* hash, const hash_group_t* group, unsigned char byte)
+{
+    __m128i control = _mm_loadu_si128((const __m128i*) group->control);
+    return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char) byte)))
+            & HASH_GROUP_MASK_SLOTS(hash->group_slots);
+}
+#elif defined(__ARM_NEON)
+// Note: NEON has no movemask, narrowing shift leaves a nibble a byte, the top bit of the nibble is kept
+typedef uint64_t hash_group_mask_t;
+#define HASH_GROUP_MASK_SHIFT 2
+#define HASH_GROUP_MASK_SLOTS(slots) (0x8888888888888888ULL >> (64 - 4 * (slots)))
+
+static inline hash_group_mask_t hash_group_match(const hash_t* hash, const hash_group_t* group, unsigned char byte)
+{
+    uint8x16_t equal = vceqq_u8(vld1q_u8(group->control), vdupq_n_u8(byte));
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(equal), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & HASH_GROUP_MASK_SLOTS(hash->group_slots);
+}
+#else
+typedef u32 hash_group_mask_t;
+#define HASH_GROUP_MASK_SHIFT 0
+
+static inline hash_group_mask_t hash_group_match(const hash_t* hash, const hash_group_t* group, unsigned char byte)
+{
+    hash_group_mask_t mask = 0;
+    u32 i;
+    for (i = 0; i < hash->group_slots; i++) {
+        mask |= (hash_group_mask_t) (group->control[i] == byte) << i;
+    }
+    return mask;
+}
+#endif
+
+// Note: a compact group is half the size of a group, groups aren't indexed by type
+static inline hash_group_t* hash_group_at(const hash_t* hash, u32 g)
+{
+    return (hash_group_t*) ((char*) hash->group_list + ((size_t) g << hash->group_shift));
+}
+
+static inline node_t* hash_group_link_node(const hash_t* hash, u32 link)
+{
+    return (link != 0) ? (node_t*) (hash->link_base + ((size_t) link << HASH_LINK_SHIFT)) : NULL;
+}
+
+static inline node_t* hash_group_node(const hash_t* hash, const hash_group_t* group, u32 slot)
+{
+    if (hash->link_base != NULL) {
+        return hash_group_link_node(hash, ((const hash_group_compact_t*) group)->links[slot]);
+    }
+    return group->nodes[slot];
+}
+
+static inline void hash_group_set_node(const hash_t* hash, hash_group_t* group, u32 slot, node_t* node)
+{
+    if (hash->link_base != NULL) {
+        ((hash_group_compact_t*) group)->links[slot] =
+                (node != NULL) ? (u32) (((char*) node - hash->link_base) >> HASH_LINK_SHIFT) : 0;
+        return;
+    }
+    group->nodes[slot] = node;
+}
+
+static inline u32 hash_group_mask_slot(hash_group_mask_t mask)
+{
+    return (u32) __builtin_ctzll(mask) >> HASH_GROUP_MASK_SHIFT;
+}
+
+static inline u32 tag_to_group(const hash_t* hash, u32 tag)
+{
+    return tag >> (32 - hash->group_bits);
+}
+
+// Note: fingerprint takes top bits of another multiply, it doesn't repeat the group bits of the tag
+static inline unsigned char tag_to_fingerprint(u32 tag)
+{
+    return (unsigned char) (0x80 | ((tag * 0x85ebca6bU) >> 25));
+}
+
+// Note: triangular steps visit every group once as group count is a power of 2
+static inline u32 hash_group_next(const hash_t* hash, u32 group, u32 step)
+{
+    return (group + step) & hash->group_mask;
+}
+
+static inline int hash_group_full(const hash_t* hash)
+{
+    if (unlikely((u32) hash->entry_count >= (hash->group_mask + 1) * hash->group_slots)) {
+        DEBUG_ERROR("hash group array is full: %d", hash->entry_count);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// Note: the group array isn't full, step counts groups probed from the home group of tag
+static inline u32 hash_group_empty_group(const hash_t* hash, u32 tag, u32* step)
+{
+    u32 g = tag_to_group(hash, tag);
+    *step = 0;
+    while (0 == hash_group_match(hash, hash_group_at(hash, g), 0)) {
+        g = hash_group_next(hash, g, ++(*step));
+    }
+    return g;
+}
+
+static void* hash_group_insert(hash_t* hash, u32 g, u32 step, u32 tag, const void* key, void* hash_node,
+        void* cache_node, void* pool_handle)
+{
+    node_t* node = hash_new_node(hash, key, tag, hash_node, cache_node, pool_handle);
+    if (unlikely(node == NULL)) {
+        return NULL;
+    }
+    // Note: groups the key passes full count it, see hash_group_del
+    u32 i, h;
+    for (i = 0, h = tag_to_group(hash, tag); i < step; h = hash_group_next(hash, h, ++i)) {
+        unsigned char* overflow = &hash_group_at(hash, h)->control[HASH_GROUP_OVERFLOW];
+        if (*overflow < 255) {
+            (*overflow)++;
+        }
+    }
+    hash_group_t* group = hash_group_at(hash, g);
+    u32 slot = hash_group_mask_slot(hash_group_match(hash, group, 0));
+    hash_group_set_node(hash, group, slot, node);
+    group->control[slot] = tag_to_fingerprint(tag);
+    hash->entry_count++;
+    hash_filter_add(hash, tag);
+    DEBUG_INFO("Add hash key successfully,group:%d slot:%d", g, slot);
+    return node;
+}
+
+static void* hash_group_add(hash_t* hash, const void* key, void* hash_node, void* cache_node, void* pool_handle)
+{
+    if (hash_group_full(hash)) {
+        return NULL;
+    }
+    u32 tag = key_to_tag(hash, key);
+    u32 step = 0;
+    u32 g = hash_group_empty_group(hash, tag, &step);
+    return hash_group_insert(hash, g, step, tag, key, hash_node, cache_node, pool_handle);
+}
+
+static void* hash_group_del(hash_t* hash, const void* key, void* hash_node)
+{
+    u32 tag = key_to_tag(hash, key);
+    unsigned char fingerprint = tag_to_fingerprint(tag);
+    u32 home = tag_to_group(hash, tag);
+    u32 g = home;
+    u32 step;
+    for (step = 0; step <= hash->group_mask; g = hash_group_next(hash, g, ++step)) {
+        hash_group_t* group = hash_group_at(hash, g);
+        hash_group_mask_t mask;
+        for (mask = hash_group_match(hash, group, fingerprint); mask != 0; mask &= mask - 1) {
+            u32 slot = hash_group_mask_slot(mask);
+            if (hash_group_node(hash, group, slot) != hash_node) {
+                continue;
+            }
+            group->control[slot] = 0;
+            hash_group_set_node(hash, group, slot, NULL);
+            // Note: groups the key passed full don't count it any more, saturated counters stay
+            u32 i;
+            for (i = 0, g = home; i < step; g = hash_group_next(hash, g, ++i)) {
+                unsigned char* overflow = &hash_group_at(hash, g)->control[HASH_GROUP_OVERFLOW];
+                if (*overflow < 255) {
+                    (*overflow)--;
+                }
+            }
+            hash->entry_count--;
+            return hash_node;
+        }
+        if (group->control[HASH_GROUP_OVERFLOW] == 0) {
+            break;
+        }
+    }
+    DEBUG_ERROR("delete hash fail: hash node isn't in group array");
+    return NULL;
+}
+
+static inline void* hash_group_find(hash_t* hash, const void* key, u32 tag, u32* probes, hash_position_t* position)
+{
+    unsigned char fingerprint = tag_to_fingerprint(tag);
+    u32 g = tag_to_group(hash, tag);
+    u32 step;
+    for (step = 0; step <= hash->group_mask; g = hash_group_next(hash, g, ++step)) {
+        hash_group_t* group = hash_group_at(hash, g);
+        hash_group_mask_t mask;
+        (*probes)++;
+        // Note: the last line of the group holds most node pointers, load it with the control vector
+        prefetch((char*) group + ((size_t) 1 << hash->group_shift) - sizeof(u32));
+        // Note: only compare keys of slots whose fingerprint and cached tag are same
+        for (mask = hash_group_match(hash, group, fingerprint); mask != 0; mask &= mask - 1) {
+            node_t* node = hash_group_node(hash, group, hash_group_mask_slot(mask));
+            hash_data_t* hd = (hash_data_t*) node->usr_data;
+            if (hd->hash_tag == tag && hash_key_equal(hash, key, hd->key)) {
+                return node;
+            }
+        }
+        // Note: the first group with an empty slot on the probe is where the key is added
+        if (position != NULL && position->index == HASH_POSITION_NONE && hash_group_match(hash, group, 0) != 0) {
+            position->index = g;
+            position->step = step;
+        }
+        if (likely(group->control[HASH_GROUP_OVERFLOW] == 0)) {
+            break;
+        }
+    }
+    // Note: every group probed is full, the empty one is further, it's rare under load factor 7/8
+    if (position != NULL && position->index == HASH_POSITION_NONE && !hash_group_full(hash)) {
+        position->index = hash_group_empty_group(hash, tag, &position->step);
+    }
+    return NULL;
+}
+
+static void* hash_chained_insert(hash_t* hash, u32 hash_code, u32 tag, const void* key, void* hash_node,
+        void* cache_node, void* pool_handle)
+{
+    if (hash_code >= hash->max_buckets) {
+        DEBUG_ERROR("hash key is invalid: %d", hash_code);
+        return NULL;
+    }
     bucket_t* bucket = &(hash->bucket_list[hash_code]);
     if (bucket->list == NULL) {
-        bucket->list = (list_t*) pool_get_element(pool_handle, POOL_TYPE_LIST_T);
+        list_t* list = (list_t*) pool_get_element(pool_handle, POOL_TYPE_LIST_T);
+        if (unlikely(list == NULL)) {
+            DEBUG_ERROR("no memory for hash list, hash_code:%d", hash_code);
+            return NULL;
+        }
+        bucket->list = list;
         bucket->list_count = 0;
         list_init(bucket->list);
     }
+    node_t* node = hash_new_node(hash, key, tag, hash_node, cache_node, pool_handle);
+    if (unlikely(node == NULL)) {
+        return NULL;
+    }
     list_push_back(bucket->list, node);
 
     bucket->list_count++;
     hash->entry_count++;
+    hash_filter_add(hash, tag);
     DEBUG_INFO("Add hash key successfully,hash_code:%d", hash_code);
     return node;
 }
 
-void* hash_del(void* hash_table, const void* key, void* hash_node, void* pool_handle)
+void* hash_add(void* hash_table, const void* key, void* hash_node, void* cache_node, void* pool_handle)
 {
     hash_t* hash = (hash_t*) hash_table;
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        return hash_open_add(hash, key, hash_node, cache_node, pool_handle);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        return hash_group_add(hash, key, hash_node, cache_node, pool_handle);
+    }
+
+    u32 tag = key_to_tag(hash, key);
+    return hash_chained_insert(hash, tag_to_hash(hash, tag), tag, key, hash_node, cache_node, pool_handle);
+}
+
+void* hash_add_at(void* hash_table, const hash_position_t* position, const void* key, void* hash_node,
+        void* cache_node, void* pool_handle)
+{
+    hash_t* hash = (hash_t*) hash_table;
+    u32 tag = position->tag;
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        if (hash_open_full(hash)) {
+            return NULL;
+        }
+        // Note: a delete may shift a slot into the probe of the key, an add may take the empty slot
+        u32 i = position->index;
+        if (unlikely(position->deletions != hash->deletions || hash->slot_list[i].node != NULL)) {
+            i = hash_open_empty_slot(hash, tag);
+        }
+        return hash_open_insert(hash, i, tag, key, hash_node, cache_node, pool_handle);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        if (hash_group_full(hash)) {
+            return NULL;
+        }
+        // Note: deletes only empty slots, the group stays on the probe, adds may fill it
+        u32 g = position->index;
+        u32 step = position->step;
+        if (unlikely(g == HASH_POSITION_NONE || 0 == hash_group_match(hash, hash_group_at(hash, g), 0))) {
+            g = hash_group_empty_group(hash, tag, &step);
+        }
+        return hash_group_insert(hash, g, step, tag, key, hash_node, cache_node, pool_handle);
+    }
+    return hash_chained_insert(hash, position->index, tag, key, hash_node, cache_node, pool_handle);
+}
+
+static void* hash_index_del(hash_t* hash, const void* key, void* hash_node, void* pool_handle)
+{
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        return hash_open_del(hash, key, hash_node);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        return hash_group_del(hash, key, hash_node);
+    }
+
     u32 hash_code = key_to_hash(hash, key);
     if (unlikely(hash_code >= hash->max_buckets)) {
         DEBUG_ERROR("hash key is invalid: %d", hash_code);
@@ -97,15 +618,29 @@ void* hash_del(void* hash_table, const void* key, void* hash_node, void* pool_ha
         node_t* node = (node_t*) hash_node;
         list_remove(bucket->list, node);
     }
+    // Note: release the empty bucket list, or the list pool is exhausted by swapped keys
+    if (list_empty(bucket->list)) {
+        pool_free_element(pool_handle, POOL_TYPE_LIST_T, bucket->list);
+        bucket->list = NULL;
+    }
     bucket->list_count--;
     hash->entry_count--;
     return hash_node;
 }
 
-void* hash_find(void* hash_table, const void* key)
+void* hash_del(void* hash_table, const void* key, void* hash_node, void* pool_handle)
 {
-    hash_t *hash = (hash_t*) hash_table;
-    u32 hash_code = key_to_hash(hash, key);
+    hash_t* hash = (hash_t*) hash_table;
+    void* deleted = hash_index_del(hash, key, hash_node, pool_handle);
+    if (unlikely(NULL != hash->filter) && NULL != deleted) {
+        libcache_filter_remove(hash->filter, ((hash_data_t*) ((node_t*) deleted)->usr_data)->hash_tag);
+    }
+    return deleted;
+}
+
+static inline void* hash_chained_find(hash_t* hash, const void* key, u32 tag, u32* probes)
+{
+    u32 hash_code = tag_to_hash(hash, tag);
     if (unlikely(hash_code >= hash->max_buckets)) {
         DEBUG_ERROR("hash_find failed: hash key[%d] is invalid", hash_code);
         return NULL;
@@ -115,7 +650,10 @@ void* hash_find(void* hash_table, const void* key)
     if (likely(bucket->list)) {
         node = bucket->list->head_node;
         while (node) {
-            if (!hash->kcmp(key, ((hash_data_t*) node->usr_data)->key)) {
+            hash_data_t* hd = (hash_data_t*) node->usr_data;
+            (*probes)++;
+            // Note: only compare keys when the cached tags are same
+            if (hd->hash_tag == tag && hash_key_equal(hash, key, hd->key)) {
                 break;
             }
             node = node->next_node;
@@ -124,22 +662,308 @@ void* hash_find(void* hash_table, const void* key)
     return node;
 }
 
+void* hash_find(void* hash_table, const void* key)
+{
+    hash_t *hash = (hash_t*) hash_table;
+    u32 tag = key_to_tag(hash, key);
+    u32 probes = 0;
+    if (hash_filter_absent(hash, tag)) {
+        return NULL;
+    }
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        return hash_open_find(hash, key, tag, &probes, NULL);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        return hash_group_find(hash, key, tag, &probes, NULL);
+    }
+    return hash_chained_find(hash, key, tag, &probes);
+}
+
+void* hash_find_position(void* hash_table, const void* key, hash_position_t* position)
+{
+    hash_t *hash = (hash_t*) hash_table;
+    u32 tag = key_to_tag(hash, key);
+    u32 probes = 0;
+    position->tag = tag;
+    position->index = HASH_POSITION_NONE;
+    position->step = 0;
+    position->deletions = hash->deletions;
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        return hash_open_find(hash, key, tag, &probes, position);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        return hash_group_find(hash, key, tag, &probes, position);
+    }
+    position->index = tag_to_hash(hash, tag);
+    return hash_chained_find(hash, key, tag, &probes);
+}
+
+void* hash_find_probed(void* hash_table, const void* key, u32* probes)
+{
+    hash_t *hash = (hash_t*) hash_table;
+    u32 tag = key_to_tag(hash, key);
+    *probes = 0;
+    if (hash_filter_absent(hash, tag)) {
+        return NULL;
+    }
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        return hash_open_find(hash, key, tag, probes, NULL);
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        return hash_group_find(hash, key, tag, probes, NULL);
+    }
+    return hash_chained_find(hash, key, tag, probes);
+}
+
+void hash_find_batch(void* hash_table, const void* const keys[], int count, void* hash_nodes[])
+{
+    hash_t *hash = (hash_t*) hash_table;
+    u32 tags[HASH_BATCH_MAX];
+    u32 probes = 0;
+    int base;
+    int i;
+    for (base = 0; base < count; base += HASH_BATCH_MAX) {
+        int n = (count - base < HASH_BATCH_MAX) ? count - base : HASH_BATCH_MAX;
+        const void* const* batch_keys = keys + base;
+        void** batch_nodes = hash_nodes + base;
+
+        if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+            // Note: stage 1, hash all keys and prefetch their home slots
+            for (i = 0; i < n; i++) {
+                tags[i] = key_to_tag(hash, batch_keys[i]);
+                prefetch(&hash->slot_list[tag_to_slot(hash, tags[i])]);
+            }
+            // Note: stage 2, prefetch candidate nodes, its tag is same as the key's
+            for (i = 0; i < n; i++) {
+                hash_slot_t* slot = &hash->slot_list[tag_to_slot(hash, tags[i])];
+                batch_nodes[i] = (slot->hash_tag == tags[i]) ? slot->node : NULL;
+                if (batch_nodes[i] != NULL) {
+                    prefetch(batch_nodes[i]);
+                }
+            }
+            // Note: stage 3, prefetch hash data of candidate nodes
+            for (i = 0; i < n; i++) {
+                if (batch_nodes[i] != NULL) {
+                    prefetch(((node_t*) batch_nodes[i])->usr_data);
+                }
+            }
+            // Note: stage 4, prefetch keys of candidate nodes
+            for (i = 0; i < n; i++) {
+                if (batch_nodes[i] != NULL) {
+                    prefetch(((hash_data_t*) ((node_t*) batch_nodes[i])->usr_data)->key);
+                }
+            }
+            for (i = 0; i < n; i++) {
+                batch_nodes[i] = hash_filter_absent(hash, tags[i]) ? NULL
+                        : hash_open_find(hash, batch_keys[i], tags[i], &probes, NULL);
+            }
+            continue;
+        }
+
+        if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+            // Note: stage 1, hash all keys and prefetch the cache lines of their home groups, a compact one has one
+            int lines = ((size_t) 1 << hash->group_shift) > LIBCACHE_CACHE_LINE_SIZE;
+            for (i = 0; i < n; i++) {
+                tags[i] = key_to_tag(hash, batch_keys[i]);
+                hash_group_t* group = hash_group_at(hash, tag_to_group(hash, tags[i]));
+                prefetch(group);
+                if (lines) {
+                    prefetch((char*) group + LIBCACHE_CACHE_LINE_SIZE);
+                }
+            }
+            // Note: stage 2, prefetch the node of the first fingerprint match
+            for (i = 0; i < n; i++) {
+                hash_group_t* group = hash_group_at(hash, tag_to_group(hash, tags[i]));
+                hash_group_mask_t mask = hash_group_match(hash, group, tag_to_fingerprint(tags[i]));
+                batch_nodes[i] = (mask != 0) ? hash_group_node(hash, group, hash_group_mask_slot(mask)) : NULL;
+                if (batch_nodes[i] != NULL) {
+                    prefetch(batch_nodes[i]);
+                }
+            }
+            // Note: stage 3, prefetch hash data and keys of candidate nodes
+            for (i = 0; i < n; i++) {
+                if (batch_nodes[i] != NULL) {
+                    prefetch(((node_t*) batch_nodes[i])->usr_data);
+                }
+            }
+            for (i = 0; i < n; i++) {
+                if (batch_nodes[i] != NULL) {
+                    prefetch(((hash_data_t*) ((node_t*) batch_nodes[i])->usr_data)->key);
+                }
+            }
+            for (i = 0; i < n; i++) {
+                batch_nodes[i] = hash_filter_absent(hash, tags[i]) ? NULL
+                        : hash_group_find(hash, batch_keys[i], tags[i], &probes, NULL);
+            }
+            continue;
+        }
+
+        // Note: stage 1, hash all keys and prefetch their buckets
+        for (i = 0; i < n; i++) {
+            tags[i] = key_to_tag(hash, batch_keys[i]);
+            prefetch(&hash->bucket_list[tag_to_hash(hash, tags[i])]);
+        }
+        // Note: stage 2, prefetch bucket lists
+        for (i = 0; i < n; i++) {
+            list_t* list = hash->bucket_list[tag_to_hash(hash, tags[i])].list;
+            batch_nodes[i] = list;
+            if (list != NULL) {
+                prefetch(list);
+            }
+        }
+        // Note: stage 3, prefetch first nodes
+        for (i = 0; i < n; i++) {
+            if (batch_nodes[i] != NULL) {
+                batch_nodes[i] = ((list_t*) batch_nodes[i])->head_node;
+                if (batch_nodes[i] != NULL) {
+                    prefetch(batch_nodes[i]);
+                }
+            }
+        }
+        // Note: stage 4, prefetch hash data of first nodes
+        for (i = 0; i < n; i++) {
+            if (batch_nodes[i] != NULL) {
+                prefetch(((node_t*) batch_nodes[i])->usr_data);
+            }
+        }
+        // Note: stage 5, prefetch keys of first nodes
+        for (i = 0; i < n; i++) {
+            if (batch_nodes[i] != NULL) {
+                prefetch(((hash_data_t*) ((node_t*) batch_nodes[i])->usr_data)->key);
+            }
+        }
+        for (i = 0; i < n; i++) {
+            batch_nodes[i] = (batch_nodes[i] == NULL || hash_filter_absent(hash, tags[i])) ? NULL
+                    : hash_chained_find(hash, batch_keys[i], tags[i], &probes);
+        }
+    }
+}
+
+// Note: every shared field is loaded once, so a value checked against NULL is the value used
+#define HASH_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+static inline int hash_optimistic_match(const hash_t* hash, const node_t* node, const void* key, u32 tag)
+{
+    hash_data_t* hd = (hash_data_t*) HASH_LOAD(node->usr_data);
+    if (unlikely(NULL == hd) || HASH_LOAD(hd->hash_tag) != tag) {
+        return FALSE;
+    }
+    void* hd_key = HASH_LOAD(hd->key);
+    return (NULL != hd_key) && hash_key_equal(hash, key, hd_key);
+}
+
+void* hash_find_optimistic(void* hash_table, const void* key)
+{
+    hash_t *hash = (hash_t*) hash_table;
+    u32 tag = key_to_tag(hash, key);
+    u32 steps;
+    // Note: a fingerprint being kicked is in neither bucket for a moment, the reader validates the result anyway
+    if (hash_filter_absent(hash, tag)) {
+        return NULL;
+    }
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        u32 i = tag_to_slot(hash, tag);
+        for (steps = 0; steps <= hash->slot_mask; steps++) {
+            hash_slot_t* slot = &hash->slot_list[i];
+            node_t* node = HASH_LOAD(slot->node);
+            if (NULL == node) {
+                break;
+            }
+            if (HASH_LOAD(slot->hash_tag) == tag && hash_optimistic_match(hash, node, key, tag)) {
+                return node;
+            }
+            i = (i + 1) & hash->slot_mask;
+        }
+        return NULL;
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        // Note: control bytes are loaded one by one as well, a vector load isn't atomic
+        unsigned char fingerprint = tag_to_fingerprint(tag);
+        u32 g = tag_to_group(hash, tag);
+        for (steps = 0; steps <= hash->group_mask; g = hash_group_next(hash, g, ++steps)) {
+            hash_group_t* group = hash_group_at(hash, g);
+            u32 slot;
+            for (slot = 0; slot < hash->group_slots; slot++) {
+                if (HASH_LOAD(group->control[slot]) != fingerprint) {
+                    continue;
+                }
+                node_t* node = (hash->link_base != NULL)
+                        ? hash_group_link_node(hash, HASH_LOAD(((hash_group_compact_t*) group)->links[slot]))
+                        : HASH_LOAD(group->nodes[slot]);
+                if (NULL != node && hash_optimistic_match(hash, node, key, tag)) {
+                    return node;
+                }
+            }
+            if (HASH_LOAD(group->control[HASH_GROUP_OVERFLOW]) == 0) {
+                break;
+            }
+        }
+        return NULL;
+    }
+
+    u32 hash_code = tag_to_hash(hash, tag);
+    if (unlikely(hash_code >= hash->max_buckets)) {
+        return NULL;
+    }
+    list_t* list = HASH_LOAD(hash->bucket_list[hash_code].list);
+    if (NULL == list) {
+        return NULL;
+    }
+    // Note: a node freed meanwhile may link to anywhere, even back to itself
+    u32 max_steps = (u32) HASH_LOAD(hash->entry_count) + 1;
+    node_t* node = HASH_LOAD(list->head_node);
+    for (steps = 0; node != NULL && steps < max_steps; steps++) {
+        if (hash_optimistic_match(hash, node, key, tag)) {
+            return node;
+        }
+        node = HASH_LOAD(node->next_node);
+    }
+    return NULL;
+}
+
 int hash_get_count(const void* hash_table)
 {
     const hash_t* hash = (const hash_t*) hash_table;
     return hash->entry_count;
 }
 
-static void hash_release(void* hash_table, int is_destroy, void* pool_handle)
+static void hash_release(void* hash_table, int is_destroy, int free_nodes, void* pool_handle)
 {
     hash_t* hash = (hash_t*) hash_table;
     int i = 0;
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        for (i = 0; i <= hash->slot_mask; i++) {
+            hash_slot_t* slot = &(hash->slot_list[i]);
+            if (slot->node != NULL) {
+                if (free_nodes) {
+                    hash_free_node(slot->node, pool_handle);
+                }
+                slot->node = NULL;
+                slot->hash_tag = 0;
+            }
+        }
+    }
+    if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        for (i = 0; i <= hash->group_mask; i++) {
+            hash_group_t* group = hash_group_at(hash, i);
+            u32 slot;
+            for (slot = 0; slot < hash->group_slots; slot++) {
+                node_t* node = hash_group_node(hash, group, slot);
+                if (free_nodes && node != NULL) {
+                    hash_free_node(node, pool_handle);
+                }
+            }
+            memset(group, 0, (size_t) 1 << hash->group_shift);
+        }
+    }
     for (i = 0; i < hash->max_buckets; i++) {
         bucket_t* bucket = &(hash->bucket_list[i]);
         node_t *bucket_node;
         if (bucket->list != NULL) {
             while (NULL != (bucket_node = list_pop_front(bucket->list))) {
-                hash_free_node(bucket_node, pool_handle);
+                if (free_nodes) {
+                    hash_free_node(bucket_node, pool_handle);
+                }
             }
             (void) pool_free_element(pool_handle, POOL_TYPE_LIST_T, bucket->list);
             bucket->list = NULL;
@@ -147,19 +971,45 @@ static void hash_release(void* hash_table, int is_destroy, void* pool_handle)
         }
     }
     if (is_destroy) {
-        pool_free_element(pool_handle, POOL_TYPE_BUCKET_T, hash->bucket_list);
+        void* buckets = (hash->index_type == LIBCACHE_INDEX_OPEN) ? (void*) hash->slot_list
+                : (hash->index_type == LIBCACHE_INDEX_GROUP) ? (void*) hash->group_list : (void*) hash->bucket_list;
+        pool_free_element(pool_handle, POOL_TYPE_BUCKET_T, buckets);
         pool_free_element(pool_handle, POOL_TYPE_HASH_T, hash);
     } else {
         hash->entry_count = 0;
+        if (NULL != hash->filter) {
+            libcache_filter_clear(hash->filter);
+        }
     }
 }
 
 void hash_free(void* hash, void* pool_handle)
 {
-    hash_release(hash, FALSE, pool_handle);
+    hash_release(hash, FALSE, TRUE, pool_handle);
+}
+
+void hash_reset(void* hash, void* pool_handle)
+{
+    hash_release(hash, FALSE, FALSE, pool_handle);
+}
+
+void hash_clear(void* hash_table)
+{
+    hash_t* hash = (hash_t*) hash_table;
+    if (hash->index_type == LIBCACHE_INDEX_OPEN) {
+        memset(hash->slot_list, 0, sizeof(hash_slot_t) * (hash->slot_mask + 1));
+    } else if (hash->index_type == LIBCACHE_INDEX_GROUP) {
+        memset(hash->group_list, 0, (size_t) (hash->group_mask + 1) << hash->group_shift);
+    } else {
+        memset(hash->bucket_list, 0, sizeof(bucket_t) * hash->max_buckets);
+    }
+    hash->entry_count = 0;
+    if (NULL != hash->filter) {
+        libcache_filter_clear(hash->filter);
+    }
 }
 
 void hash_destroy(void* hash, void* pool_handle)
 {
-    hash_release(hash, TRUE, pool_handle);
+    hash_release(hash, TRUE, TRUE, pool_handle);
 }
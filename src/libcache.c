@@ -1,32 +1,326 @@
+// Note: sched_yield of libcache_spinlock.h isn't in C99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include <assert.h>
+#include <limits.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "libcache.h"
 #include "libcache_def.h"
 #include "libpool.h"
 #include "hash.h"
+#include "libcache_policy.h"
+#include "libcache_memory.h"
+#include "libcache_spinlock.h"
+#include "libcache_compact.h"
+#include "libcache_ttl.h"
+#include "libcache_compress.h"
+#include "libcache_tier.h"
+#include "libcache_btree.h"
+#include "libcache_replication.h"
 
 typedef struct libcache_node_usr_data_t
 {
-    void* key;
-    node_t* hash_node_ptr;
-    void* pool_element_ptr;
-    uint32_t lock_counter;
-}libcache_node_usr_data_t;
+    libcache_policy_entry_t policy_entry; /* must be the first member */
+    uint32_t lock_counter;  /* atomic in LIBCACHE_CONCURRENT build */
+    uint32_t entry_length;  /* atomic while it's LIBCACHE_ENTRY_LOADING, see libcache_load_begin */
+}__attribute__((aligned(8))) libcache_node_usr_data_t;
+
+/*
+ * entry_length of an entry added by libcache_load_begin until libcache_load_end, such an entry is locked
+ * by its loader and waiters, it's missing for lookups. A failed one is freed by its last unlock, or it's
+ * kept as a negative entry if the cache is created with negative_ttl: it stays in policy as missing
+ * until it expires or its key is added. None of them has a valid entry, they're neither released nor copied.
+ */
+#define LIBCACHE_ENTRY_LOADING ((uint32_t) -1)
+#define LIBCACHE_ENTRY_LOAD_FAILED ((uint32_t) -2)
+#define LIBCACHE_ENTRY_NEGATIVE ((uint32_t) -3)
+
+/*
+ * An entry is stored in one element of POOL_TYPE_DATA, elements are aligned to LIBCACHE_RECORD_ALIGN:
+ * | entry | key | record |
+ * In variable size entry mode, the entry is an element of POOL_TYPE_ENTRY_SLAB instead:
+ * | key | record |
+ * If the cache is created with ttl, libcache_ttl_entry_t follows the record, then libcache_dirty_entry_t
+ * if it's created with flush_entries, then libcache_tag_entry_t if it's created with tags,
+ * then | libcache_secondary_entry_t | key | of every secondary index.
+ * hash_data.key points to the key of the element, it's the only copy of the key.
+ * Reserved pointer of the entry (a pool or slab element) points to cache_node.
+ */
+typedef struct libcache_record_t
+{
+    hash_data_t hash_data;
+    node_t hash_node;   /* usr_data points to hash_data */
+    libcache_node_usr_data_t cache_data;
+    node_t cache_node;  /* linked by policy or lock_list, usr_data points to cache_data */
+    void* entry;
+    uint64_t generation;  /* set when the entry is added, 0 once it's freed, see libcache_handle_t */
+}__attribute__((aligned(8))) libcache_record_t;
+
+/*
+ * dirty_node is linked in dirty_list of the cache while the entry is dirty, its usr_data points to the record then,
+ * it's NULL while the entry is clean.
+ */
+typedef struct libcache_dirty_entry_t
+{
+    node_t dirty_node;
+}__attribute__((aligned(8))) libcache_dirty_entry_t;
+
+/*
+ * generation is the one of the tag when the entry was added, the entry is stale once the tag's is another,
+ * see libcache_invalidate_tag. It'd be valid again after 2^32 invalidations of the tag, if it's still in the cache.
+ */
+typedef struct libcache_tag_entry_t
+{
+    uint32_t tag;  /* key_to_tag of the key, modulo attr.tags */
+    uint32_t generation;
+}__attribute__((aligned(8))) libcache_tag_entry_t;
+
+/*
+ * hash_node is in a secondary index of the cache while indexed is TRUE, the key of the index follows it.
+ * hash_data.cache_node_ptr points to cache_node of the record.
+ */
+typedef struct libcache_secondary_entry_t
+{
+    hash_data_t hash_data;
+    node_t hash_node;   /* usr_data points to hash_data */
+    uint32_t indexed;
+}__attribute__((aligned(8))) libcache_secondary_entry_t;
+
+/*
+ * Copies of entries evicted since the last delivery to attr.evicted_entries, in one element of
+ * POOL_TYPE_EVICTED_BATCH: | libcache_evicted_batch_t | keys | entries | entry_lengths | reasons | slots |
+ * A slot is | key | entry |, both padded to 8 bytes, keys[i] and entries[i] point into slot i.
+ */
+typedef struct libcache_evicted_batch_t
+{
+    uint32_t capacity;
+    uint32_t count;
+    char* slots;
+    size_t slot_size;
+    size_t entry_offset;  /* from slot to entry */
+    const void** keys;
+    const void** entries;
+    size_t* entry_lengths;
+    libcache_evict_e* reasons;
+}__attribute__((aligned(8))) libcache_evicted_batch_t;
+
+#define LIBCACHE_EVICTION_BATCH 64
+#define LIBCACHE_EVICTED_ARRAYS_LENGTH(capacity) ((size_t) (capacity) \
+        * ((sizeof(void*) * 2 + sizeof(size_t) + sizeof(libcache_evict_e) + 7) / 8 * 8))
+
+#define LIBCACHE_RECORD_ALIGN 64
+
+#define LIBCACHE_NODE_RECORD(node) ((libcache_record_t*) ((char*) (node) - offsetof(libcache_record_t, cache_node)))
+#define LIBCACHE_HASH_NODE_RECORD(node) ((libcache_record_t*) ((char*) (node) - offsetof(libcache_record_t, hash_node)))
+#define LIBCACHE_RECORD_TTL(record) ((libcache_ttl_entry_t*) ((libcache_record_t*) (record) + 1))
+#define LIBCACHE_RECORD_DIRTY(libcache_ptr, record) \
+    ((libcache_dirty_entry_t*) ((char*) (record) + (libcache_ptr)->dirty_offset))
+#define LIBCACHE_RECORD_TAG(libcache_ptr, record) \
+    ((libcache_tag_entry_t*) ((char*) (record) + (libcache_ptr)->tag_offset))
+#define LIBCACHE_RECORD_SECONDARY(libcache_ptr, record, i) \
+    ((libcache_secondary_entry_t*) ((char*) (record) + (libcache_ptr)->secondary_offsets[i]))
+#define LIBCACHE_SECONDARY_NODE_RECORD(node) \
+    LIBCACHE_NODE_RECORD(((hash_data_t*) ((node_t*) (node))->usr_data)->cache_node_ptr)
+#define LIBCACHE_RECORD_ABSENT(record) \
+    (__atomic_load_n(&(record)->cache_data.entry_length, __ATOMIC_RELAXED) >= LIBCACHE_ENTRY_NEGATIVE)
+
+/*
+ * In LIBCACHE_CONCURRENT build, lock_counter can be decreased by libcache_try_unlock_entry
+ * from any thread without the cache being locked, it never becomes 0 there. Other changes,
+ * including 0 to 1 and 1 to 0, still need the cache to be locked by its user.
+ */
+#ifdef LIBCACHE_CONCURRENT
+#define LOCK_COUNTER_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_ACQUIRE)
+#define LOCK_COUNTER_STORE(counter, value) __atomic_store_n(&(counter), (value), __ATOMIC_RELEASE)
+#define LOCK_COUNTER_INC(counter) __atomic_add_fetch(&(counter), 1, __ATOMIC_ACQ_REL)
+#define LOCK_COUNTER_DEC(counter) __atomic_sub_fetch(&(counter), 1, __ATOMIC_ACQ_REL)
+#else
+#define LOCK_COUNTER_LOAD(counter) (counter)
+#define LOCK_COUNTER_STORE(counter, value) ((counter) = (value))
+#define LOCK_COUNTER_INC(counter) (++(counter))
+#define LOCK_COUNTER_DEC(counter) (--(counter))
+#endif
 
 typedef struct libcache_t
 {
+    libcache_engine_e engine;  /* LIBCACHE_ENGINE_POOL, must be the first member, see libcache_is_compact */
     void* pool;
     void* hash_table;
-    list_t* list;
+    void* policy_data;  /* unlocked entries are kept by policy */
+    const libcache_policy_ops_t* policy_ops;
+    list_t* lock_list;  /* locked entries, never be swapped out */
     size_t entry_size;
     size_t key_size;
+    size_t key_offset;     /* from element to key */
+    size_t record_offset;  /* from element to record */
+    void* entry_slab;      /* entries of variable size, NULL if every entry is entry_size bytes */
     libcache_scale_t max_entry_number;
+    libcache_page_e page_type;  /* page type memory is really on */
+    size_t memory_length;
     LIBCACHE_FREE_MEMORY* free_memory;
     LIBCACHE_FREE_ENTRY* free_entry;
+    LIBCACHE_FREE_ENTRY* release_entry;
+    libcache_attr_t attr;  /* attributes it was created with, policy_ops is resolved */
+    struct libcache_t* resize_from;  /* cache being resized, its entries are moved here step by step */
+    struct libcache_shm_t* shm;      /* header of the shared memory segment, NULL if not LIBCACHE_PAGE_SHARED */
+    libcache_stats_t stats;          /* written only if attr.stats isn't LIBCACHE_STATS_NONE */
+    uint64_t generation;        /* generation of the last added record */
+    uint64_t generation_floor;  /* records of generations up to it are stale, e.g. cleaned by pool_reset */
+    uint32_t memory_epoch;      /* resizes of the handle, the cache being resized is one less, see libcache_scan */
+    libcache_ttl_wheel_t* ttl_wheel;  /* expiry of entries, NULL if attr.ttl is FALSE */
+    libcache_load_waiter_t* load_waiters;  /* asynchronous lookups waiting for loads, newest first */
+    size_t dirty_offset;  /* from record to libcache_dirty_entry_t, 0 if attr.flush_entries is NULL */
+    list_t dirty_list;    /* dirty entries, the oldest first */
+    size_t tag_offset;    /* from record to libcache_tag_entry_t, 0 if attr.tags is 0 */
+    uint32_t* tag_generations;  /* current generation of every tag, in POOL_TYPE_TAGS, NULL if attr.tags is 0 */
+    libcache_evicted_batch_t* evicted_batch;  /* NULL if attr.evicted_entries is NULL */
+    int secondary_number;  /* secondary indexes used */
+    void* secondary_tables[LIBCACHE_SECONDARY_INDEXES];  /* NULL if attr.secondary[i] isn't used */
+    size_t secondary_offsets[LIBCACHE_SECONDARY_INDEXES];  /* from record to its libcache_secondary_entry_t */
+    size_t secondary_key_offsets[LIBCACHE_SECONDARY_INDEXES];  /* from secondary_keys to key i */
+    char* secondary_keys;  /* keys extracted from an entry being indexed, in POOL_TYPE_SECONDARY_KEYS */
+    uint32_t* compress_table;  /* | table | buffer | in POOL_TYPE_COMPRESS, NULL if attr.compress_threshold is 0 */
+    char* compress_buffer;     /* an entry being compressed or decompressed, entry_size bytes */
+    libcache_btree_t* ordered_index;  /* records by key order, in POOL_TYPE_BTREE, NULL if attr.ordered is FALSE */
 }libcache_t;
 
+/*
+ * A LIBCACHE_PAGE_SHARED cache is one named shared memory segment:
+ * | libcache_shm_t | pools |
+ * The creator's handle is in the header. Other processes map the segment at the same address,
+ * so every pointer in it is valid there, they read it with a handle of their own (libcache_attached_t).
+ */
+typedef struct libcache_shm_t
+{
+    uint64_t magic;        /* LIBCACHE_SHM_MAGIC once the cache is created */
+    void* base;            /* address the segment is mapped at in every process */
+    size_t length;         /* length of the segment */
+    uint32_t handle_size;  /* sizeof(libcache_t) of the creator */
+    uint32_t sequence;     /* odd while the creator is writing the cache, see libcache_shm_read */
+    char name[LIBCACHE_SHM_NAME_MAX];
+    libcache_t cache;
+}libcache_shm_t;
+
+#define LIBCACHE_SHM_MAGIC 0x6c69626361636865ULL  /* "libcache" */
+#define LIBCACHE_SHM_HEADER_LENGTH ((sizeof(libcache_shm_t) + LIBCACHE_RECORD_ALIGN - 1) \
+        / LIBCACHE_RECORD_ALIGN * LIBCACHE_RECORD_ALIGN)
+#define LIBCACHE_SHM_READ_RETRY 16
+
+/*
+ * A cache image written by libcache_save, it has no pointer, so it's loaded anywhere:
+ * | libcache_image_header_t | image entry | image entry | ... |
+ * An image entry is | libcache_image_entry_t | key | entry |, padded to 8 bytes. Entries are in the order
+ * policy swaps them out, coldest first, locked entries are the hottest.
+ */
+typedef struct libcache_image_header_t
+{
+    uint64_t magic;         /* LIBCACHE_IMAGE_MAGIC */
+    uint32_t version;       /* LIBCACHE_IMAGE_VERSION, an image of another version is rejected */
+    uint32_t header_size;   /* sizeof(libcache_image_header_t) */
+    uint64_t length;        /* length of the image, a truncated one is rejected */
+    uint64_t entry_number;
+    uint64_t entry_size;
+    uint64_t key_size;
+    uint32_t ttl;           /* TRUE: expire_at of entries are set, see libcache_add_ttl */
+    uint32_t clock;         /* clock of the cache, see libcache_expire */
+}libcache_image_header_t;
+
+typedef struct libcache_image_entry_t
+{
+    uint32_t entry_length;
+    uint32_t expire_at;     /* 0: never expires */
+}libcache_image_entry_t;
+
+#define LIBCACHE_IMAGE_MAGIC 0x6c6962696d616765ULL  /* "libimage" */
+#define LIBCACHE_IMAGE_VERSION 1
+#define LIBCACHE_IMAGE_ENTRY_LENGTH(key_size, entry_length) \
+    ((sizeof(libcache_image_entry_t) + (key_size) + (entry_length) + 7) / 8 * 8)
+
+/*
+ * Handle of an attached process, key functions and the copy of hash_t are its own,
+ * entry_count of the copy is refreshed by every read.
+ */
+typedef struct libcache_attached_t
+{
+    libcache_t cache;  /* must be the first member */
+    hash_t hash;
+}libcache_attached_t;
+
+static inline int libcache_is_attached(const libcache_t* libcache_ptr)
+{
+    return NULL != libcache_ptr->shm && libcache_ptr != &libcache_ptr->shm->cache;
+}
+
+static inline void libcache_shm_write_begin(libcache_t* libcache_ptr)
+{
+    if (unlikely(NULL != libcache_ptr->shm)) {
+        __atomic_store_n(&libcache_ptr->shm->sequence, libcache_ptr->shm->sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+}
+
+static inline void libcache_shm_write_end(libcache_t* libcache_ptr)
+{
+    if (unlikely(NULL != libcache_ptr->shm)) {
+        __atomic_store_n(&libcache_ptr->shm->sequence, libcache_ptr->shm->sequence + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Instrumentation of attr.stats, counters are plain, the cache is written by one thread at a time anyway.
+ */
+#define LIBCACHE_STATS_ON(libcache_ptr) unlikely((libcache_ptr)->attr.stats != LIBCACHE_STATS_NONE)
+#define LIBCACHE_STATS_INC(libcache_ptr, counter) \
+    do { if (LIBCACHE_STATS_ON(libcache_ptr)) { (libcache_ptr)->stats.counter++; } } while (0)
+
+static inline uint64_t libcache_stats_begin(const libcache_t* libcache_ptr)
+{
+    if (likely(libcache_ptr->attr.stats != LIBCACHE_STATS_LATENCY)) {
+        return 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+// Note: bucket i is [2^i, 2^(i+1)) ns, 0 ns goes to bucket 0
+static inline void libcache_stats_end(const libcache_t* libcache_ptr, unsigned long long histogram[], uint64_t start)
+{
+    if (likely(libcache_ptr->attr.stats != LIBCACHE_STATS_LATENCY)) {
+        return;
+    }
+    uint64_t elapsed = libcache_stats_begin(libcache_ptr) - start;
+    int bucket = 63 - __builtin_clzll(elapsed | 1);
+    histogram[(bucket < LIBCACHE_STATS_LATENCY_BUCKETS) ? bucket : LIBCACHE_STATS_LATENCY_BUCKETS - 1]++;
+}
+
+static inline void libcache_stats_lookup(libcache_t* libcache_ptr, const void* entry, uint64_t start)
+{
+    if (LIBCACHE_STATS_ON(libcache_ptr)) {
+        if (NULL != entry) {
+            libcache_ptr->stats.lookup_hits++;
+        } else {
+            libcache_ptr->stats.lookup_misses++;
+        }
+        libcache_stats_end(libcache_ptr, libcache_ptr->stats.lookup_latency_ns, start);
+    }
+}
+
+/* entries moved from the cache being resized by every lookup, add and delete */
+#define LIBCACHE_RESIZE_STEP 4
+
+/* dirty entries given to flush_entries at a time by libcache_flush */
+#define LIBCACHE_FLUSH_BATCH 64
+
 /*
  *  @brief libcache_create    creates a cache object
  *
@@ -50,199 +344,2646 @@ void* libcache_create(
         LIBCACHE_CMP_KEY* cmp_key,
         LIBCACHE_KEY_TO_NUMBER* key_to_number)
 {
-    if (allocate_memory == NULL || free_memory == NULL) {
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = entry_size;
+    attr.key_size = key_size;
+    attr.allocate_memory = allocate_memory;
+    attr.free_memory = free_memory;
+    attr.free_entry = free_entry;
+    attr.cmp_key = cmp_key;
+    attr.key_to_number = key_to_number;
+
+    return libcache_create_ex(&attr);
+}
+
+/*
+ *  @brief libcache_new_handle   allocates a cache object, it's apart from the pools of the cache.
+ */
+static libcache_t* libcache_new_handle(const libcache_attr_t* attr, void* large_memory)
+{
+    if (attr->page_type == LIBCACHE_PAGE_SHARED) {
+        return &((libcache_shm_t*) large_memory)->cache;
+    }
+    if (attr->page_type == LIBCACHE_PAGE_USER) {
+        return (libcache_t*) libcache_memory_allocate(attr, sizeof(libcache_t));
+    }
+    libcache_page_e page_type;
+    return (libcache_t*) libcache_memory_map(sizeof(libcache_t), LIBCACHE_PAGE_NORMAL, attr->numa_node_mask,
+            &page_type);
+}
+
+/*
+ *  @brief libcache_free_handle  frees a cache object got from libcache_new_handle.
+ */
+static void libcache_free_handle(libcache_t* libcache_ptr)
+{
+    if (libcache_ptr->attr.page_type == LIBCACHE_PAGE_USER) {
+        libcache_ptr->free_memory(libcache_ptr);
+    } else {
+        libcache_memory_unmap(libcache_ptr, sizeof(libcache_t), LIBCACHE_PAGE_NORMAL);
+    }
+}
+
+/*
+ *  @brief libcache_create_ex    creates a cache object with extended attributes
+ *
+ *  @param attr                  attributes of the cache object, see libcache_attr_t.
+ *  @return                      pointer of a cache object.
+ */
+void* libcache_create_ex(const libcache_attr_t* attr)
+{
+    if (attr == NULL) {
+        DEBUG_ERROR("argument %s can not be NULL.", "attr");
+        return NULL;
+    }
+    if (attr->engine == LIBCACHE_ENGINE_COMPACT) {
+        return libcache_compact_create(attr);
+    }
+    if (attr->page_type == LIBCACHE_PAGE_USER && (!libcache_memory_allocator(attr) || attr->free_memory == NULL)) {
         DEBUG_ERROR("argument %s and %s can not be NULL.", "allocate_memory", "free_memory");
         return NULL;
     }
-    int max_entry = max_entry_number + 1;
+    const libcache_policy_ops_t* policy_ops = attr->policy_ops ? attr->policy_ops : libcache_policy_get(attr->policy);
+    if (policy_ops == NULL) {
+        DEBUG_ERROR("argument %s is invalid.", "policy");
+        return NULL;
+    }
+    size_t shm_header_length = 0;
+    if (attr->page_type == LIBCACHE_PAGE_SHARED) {
+        if (attr->shm_name == NULL || strlen(attr->shm_name) >= LIBCACHE_SHM_NAME_MAX) {
+            DEBUG_ERROR("argument %s is invalid.", "shm_name");
+            return NULL;
+        }
+        shm_header_length = LIBCACHE_SHM_HEADER_LENGTH;
+    }
+    if (attr->negative_ttl && !attr->ttl) {
+        DEBUG_ERROR("argument %s needs %s.", "negative_ttl", "ttl");
+        return NULL;
+    }
+    int max_entry = attr->max_entry_number + 1;
+    size_t entry_size = attr->entry_size;
+    size_t key_size = attr->key_size;
+    size_t entry_memory_size = attr->entry_memory_size;
+    size_t key_offset = (entry_memory_size > 0) ? 0 : (entry_size + 7) / 8 * 8;
+    size_t record_offset = (key_offset + key_size + 7) / 8 * 8;
+    size_t dirty_offset = sizeof(libcache_record_t) + (attr->ttl ? sizeof(libcache_ttl_entry_t) : 0);
+    size_t record_size = dirty_offset + (attr->flush_entries ? sizeof(libcache_dirty_entry_t) : 0);
+    size_t tag_offset = attr->tags ? record_size : 0;
+    record_size += attr->tags ? sizeof(libcache_tag_entry_t) : 0;
+    // Note: a secondary index takes a hash node and a key in every record, and an index of max_entry keys
+    size_t secondary_offsets[LIBCACHE_SECONDARY_INDEXES];
+    size_t secondary_key_offsets[LIBCACHE_SECONDARY_INDEXES];
+    size_t secondary_keys_length = 0;
+    int secondary_number = 0;
+    int secondary;
+    for (secondary = 0; secondary < LIBCACHE_SECONDARY_INDEXES; secondary++) {
+        const libcache_index_attr_t* index_attr = &attr->secondary[secondary];
+        secondary_offsets[secondary] = 0;
+        secondary_key_offsets[secondary] = secondary_keys_length;
+        if (NULL == index_attr->extract_key) {
+            continue;
+        }
+        if (0 == index_attr->key_size) {
+            DEBUG_ERROR("argument %s is invalid.", "secondary key_size");
+            return NULL;
+        }
+        secondary_offsets[secondary] = record_size;
+        record_size += sizeof(libcache_secondary_entry_t) + (index_attr->key_size + 7) / 8 * 8;
+        secondary_keys_length += (index_attr->key_size + 7) / 8 * 8;
+        secondary_number++;
+    }
+    if (attr->compress_threshold > 0 && (0 == entry_memory_size || attr->page_type == LIBCACHE_PAGE_SHARED
+            || attr->free_entry || attr->release_entry || attr->flush_entries || secondary_number > 0)) {
+        DEBUG_ERROR("argument %s needs entry_memory_size and isn't supported with shared memory, free_entry, "
+                "release_entry, flush_entries or secondary indexes.", "compress_threshold");
+        return NULL;
+    }
+    if (NULL != attr->cold_tier && (attr->page_type == LIBCACHE_PAGE_SHARED || attr->release_entry
+            || libcache_tier_get_entry_size(attr->cold_tier) > entry_size)) {
+        DEBUG_ERROR("argument %s of entries larger than the cache's isn't supported with shared memory or "
+                "release_entry.", "cold_tier");
+        return NULL;
+    }
+    if (attr->ordered && (NULL == attr->cmp_key || attr->compress_threshold > 0)) {
+        DEBUG_ERROR("argument %s needs cmp_key and isn't supported with compress_threshold.", "ordered");
+        return NULL;
+    }
+    // Note: the cold tier and images keep no tags, entries of an invalidated tag would come back from them
+    if (attr->tags > LIBCACHE_TAGS_MAX || (attr->tags && (NULL == attr->key_to_tag || NULL != attr->cold_tier))) {
+        DEBUG_ERROR("argument %s needs key_to_tag and isn't supported with cold_tier.", "tags");
+        return NULL;
+    }
+    if (NULL != attr->replication && (NULL != attr->cold_tier
+            || libcache_replication_get_key_size(attr->replication) != key_size
+            || libcache_replication_get_entry_size(attr->replication) < entry_size)) {
+        DEBUG_ERROR("argument %s of other key_size or smaller entry_size isn't supported with cold_tier.",
+                "replication");
+        return NULL;
+    }
+    uint32_t eviction_batch = attr->eviction_batch ? attr->eviction_batch : LIBCACHE_EVICTION_BATCH;
+    size_t evicted_slot_size = (key_size + 7) / 8 * 8 + (entry_size + 7) / 8 * 8;
 
+    // Note: nodes, hash data and keys are all in records, their own pools are empty
     pool_attr_t pool_attr[] = {
-            { entry_size, max_entry },
-            { sizeof(libcache_t), 1 } ,
-            { sizeof(list_t), max_entry + 1},
-            { sizeof(node_t), max_entry * 2},
-            { sizeof(libcache_node_usr_data_t), max_entry },
-            { key_size, max_entry * 2},
-            { sizeof(hash_t), 1 }, // POOL_TYPE_HASH_T
-            { sizeof(bucket_t)*HASH_BUCKETS, 1 }, // POOL_TYPE_BUCKET_T
-            { sizeof(hash_data_t), max_entry},
+            { record_offset + record_size, max_entry, LIBCACHE_RECORD_ALIGN },
+            { sizeof(libcache_t), 0 } , // the handle isn't in pools, it's kept by user across resize
+            { sizeof(list_t), hash_caculate_lists_count(attr->index_type, max_entry) * (1 + secondary_number)
+                    + 1 }, // lock_list and buckets
+            { sizeof(node_t), 0 },
+            { sizeof(libcache_node_usr_data_t), 0 },
+            { key_size, 0 },
+            { sizeof(hash_t), 1 + secondary_number }, // POOL_TYPE_HASH_T
+            { hash_caculate_buckets_length(attr->index_type, max_entry), 1 + secondary_number,
+                    LIBCACHE_CACHE_LINE_SIZE }, // POOL_TYPE_BUCKET_T, a group is 1 or 2 lines
+            { sizeof(hash_data_t), 0 },
+            { policy_ops->data_size(max_entry), 1 }, // POOL_TYPE_POLICY_DATA
+            { pool_slab_caculate_length(entry_memory_size, entry_size), (entry_memory_size > 0) ? 1 : 0 },
+            { sizeof(libcache_ttl_wheel_t), attr->ttl ? 1 : 0 }, // POOL_TYPE_TTL_WHEEL
+            { sizeof(libcache_evicted_batch_t) + LIBCACHE_EVICTED_ARRAYS_LENGTH(eviction_batch)
+                    + eviction_batch * evicted_slot_size, attr->evicted_entries ? 1 : 0 }, // POOL_TYPE_EVICTED_BATCH
+            { libcache_filter_caculate_length(max_entry), attr->negative_filter ? 1 : 0,
+                    LIBCACHE_CACHE_LINE_SIZE }, // POOL_TYPE_FILTER
+            { secondary_keys_length, (secondary_number > 0) ? 1 : 0 }, // POOL_TYPE_SECONDARY_KEYS
+            { LIBCACHE_COMPRESS_TABLE_LENGTH + entry_size, attr->compress_threshold ? 1 : 0 }, // POOL_TYPE_COMPRESS
+            { sizeof(libcache_btree_t), attr->ordered ? 1 : 0 }, // POOL_TYPE_BTREE
+            { libcache_btree_caculate_node_size(key_size), attr->ordered
+                    ? libcache_btree_caculate_node_count(max_entry, key_size) : 0,
+                    LIBCACHE_CACHE_LINE_SIZE }, // POOL_TYPE_BTREE_NODE
+            { sizeof(uint32_t) * attr->tags, attr->tags ? 1 : 0 }, // POOL_TYPE_TAGS
             };
 
 
     size_t large_mem_size = pool_caculate_total_length(POOL_TYPE_MAX, pool_attr);
+    // Note: links of a compact group index reach the records from the pools by 32-bit offsets
+    if (attr->index_type == LIBCACHE_INDEX_GROUP_COMPACT && large_mem_size > HASH_LINK_MAX_LENGTH) {
+        DEBUG_ERROR("argument %s LIBCACHE_INDEX_GROUP_COMPACT takes less than %zu bytes of memory: %zu.",
+                "index_type", HASH_LINK_MAX_LENGTH, large_mem_size);
+        return NULL;
+    }
 
-    void *large_memory = allocate_memory(large_mem_size);
+    libcache_page_e page_type = LIBCACHE_PAGE_USER;
+    void *large_memory = NULL;
+    if (attr->page_type == LIBCACHE_PAGE_USER) {
+        large_memory = libcache_memory_allocate(attr, large_mem_size);
+    } else if (attr->page_type == LIBCACHE_PAGE_SHARED) {
+        large_memory = libcache_memory_map_shared(attr->shm_name, shm_header_length + large_mem_size);
+        page_type = LIBCACHE_PAGE_SHARED;
+    } else {
+        large_memory = libcache_memory_map(large_mem_size, attr->page_type, attr->numa_node_mask, &page_type);
+    }
     if (unlikely(large_memory == NULL)) {
         DEBUG_ERROR("Memory malloc failed!")
+        return NULL;
     }
 
-    void * pools = pools_init(large_memory, large_mem_size, POOL_TYPE_MAX, pool_attr);
+    libcache_t* libcache = libcache_new_handle(attr, large_memory);
+    if (unlikely(libcache == NULL)) {
+        DEBUG_ERROR("Memory malloc failed!")
+        if (page_type == LIBCACHE_PAGE_USER) {
+            attr->free_memory(large_memory);
+        } else {
+            libcache_memory_unmap(large_memory, large_mem_size, page_type);
+        }
+        return NULL;
+    }
 
-    libcache_t* libcache = (libcache_t*) pool_get_element(pools, POOL_TYPE_LIBCACHE_T);
+    void * pools = pools_init((char*) large_memory + shm_header_length, large_mem_size, POOL_TYPE_MAX, pool_attr);
+    libcache->engine = LIBCACHE_ENGINE_POOL;
     libcache->pool = pools;
 
-    libcache->hash_table = hash_init(key_size, cmp_key, key_to_number, libcache->pool);
+    libcache->hash_table = hash_init_ex(key_size, attr->cmp_key, attr->key_to_number,
+            attr->index_type, max_entry, libcache->pool);
+    hash_set_hasher(libcache->hash_table, libcache_hash_resolve(attr->hash, attr->key_to_number));
+    if (attr->negative_filter) {
+        libcache_filter_t* filter = (libcache_filter_t*) pool_get_element(pools, POOL_TYPE_FILTER);
+        libcache_filter_init(filter, max_entry);
+        hash_set_filter(libcache->hash_table, filter);
+    }
+    libcache->secondary_number = secondary_number;
+    for (secondary = 0; secondary < LIBCACHE_SECONDARY_INDEXES; secondary++) {
+        const libcache_index_attr_t* index_attr = &attr->secondary[secondary];
+        libcache->secondary_offsets[secondary] = secondary_offsets[secondary];
+        libcache->secondary_key_offsets[secondary] = secondary_key_offsets[secondary];
+        libcache->secondary_tables[secondary] = NULL;
+        if (0 != secondary_offsets[secondary]) {
+            libcache->secondary_tables[secondary] = hash_init_ex(index_attr->key_size, index_attr->cmp_key,
+                    index_attr->key_to_number, attr->index_type, max_entry, libcache->pool);
+            hash_set_hasher(libcache->secondary_tables[secondary],
+                    libcache_hash_resolve(LIBCACHE_HASH_DEFAULT, index_attr->key_to_number));
+        }
+    }
+    libcache->secondary_keys = (secondary_number > 0)
+            ? (char*) pool_get_element(pools, POOL_TYPE_SECONDARY_KEYS) : NULL;
+    libcache->compress_table = NULL;
+    libcache->compress_buffer = NULL;
+    if (attr->compress_threshold > 0) {
+        libcache->compress_table = (uint32_t*) pool_get_element(pools, POOL_TYPE_COMPRESS);
+        libcache->compress_buffer = (char*) libcache->compress_table + LIBCACHE_COMPRESS_TABLE_LENGTH;
+    }
+    libcache->ordered_index = NULL;
+    if (attr->ordered) {
+        libcache->ordered_index = (libcache_btree_t*) pool_get_element(pools, POOL_TYPE_BTREE);
+        libcache_btree_init(libcache->ordered_index, pools, POOL_TYPE_BTREE_NODE, key_size, attr->cmp_key);
+    }
+
+    libcache->policy_ops = policy_ops;
+    libcache->policy_data = pool_get_element(pools, POOL_TYPE_POLICY_DATA);
+    policy_ops->init(libcache->policy_data, max_entry);
+
+    libcache->lock_list = (list_t*) pool_get_element(pools, POOL_TYPE_LIST_T);
+    list_init(libcache->lock_list);
+
+    libcache->entry_slab = NULL;
+    if (entry_memory_size > 0) {
+        libcache->entry_slab = pool_slab_init(pool_get_element(pools, POOL_TYPE_ENTRY_SLAB),
+                entry_memory_size, entry_size);
+    }
+
+    libcache->ttl_wheel = NULL;
+    libcache->load_waiters = NULL;
+    if (attr->ttl) {
+        libcache->ttl_wheel = (libcache_ttl_wheel_t*) pool_get_element(pools, POOL_TYPE_TTL_WHEEL);
+        libcache_ttl_init(libcache->ttl_wheel, 0);
+    }
+
+    libcache->entry_size = entry_size;
+    libcache->key_size = key_size;
+    libcache->key_offset = key_offset;
+    libcache->record_offset = record_offset;
+    libcache->max_entry_number = max_entry;
+    libcache->page_type = page_type;
+    libcache->memory_length = large_mem_size;
+    libcache->free_memory = attr->free_memory;
+    libcache->free_entry = attr->free_entry;
+    libcache->release_entry = attr->release_entry;
+    libcache->attr = *attr;
+    libcache->attr.policy_ops = policy_ops;
+    libcache->resize_from = NULL;
+    libcache->shm = NULL;
+    memset(&libcache->stats, 0, sizeof(libcache_stats_t));
+    libcache->generation = 0;
+    libcache->generation_floor = 0;
+    libcache->memory_epoch = 0;
+    libcache->dirty_offset = attr->flush_entries ? dirty_offset : 0;
+    list_init(&libcache->dirty_list);
+    libcache->tag_offset = tag_offset;
+    libcache->tag_generations = NULL;
+    if (attr->tags) {
+        libcache->tag_generations = (uint32_t*) pool_get_element(pools, POOL_TYPE_TAGS);
+        memset(libcache->tag_generations, 0, sizeof(uint32_t) * attr->tags);
+    }
+    libcache->evicted_batch = NULL;
+    if (attr->evicted_entries) {
+        libcache_evicted_batch_t* batch = (libcache_evicted_batch_t*) pool_get_element(pools,
+                POOL_TYPE_EVICTED_BATCH);
+        char* arrays = (char*) (batch + 1);
+        char* slot = arrays + LIBCACHE_EVICTED_ARRAYS_LENGTH(eviction_batch);
+        batch->capacity = eviction_batch;
+        batch->count = 0;
+        batch->slots = slot;
+        batch->slot_size = evicted_slot_size;
+        batch->entry_offset = (key_size + 7) / 8 * 8;
+        batch->keys = (const void**) arrays;
+        batch->entries = batch->keys + eviction_batch;
+        batch->entry_lengths = (size_t*) (batch->entries + eviction_batch);
+        batch->reasons = (libcache_evict_e*) (batch->entry_lengths + eviction_batch);
+        uint32_t i;
+        for (i = 0; i < eviction_batch; i++, slot += evicted_slot_size) {
+            batch->keys[i] = slot;
+            batch->entries[i] = slot + batch->entry_offset;
+        }
+        libcache->evicted_batch = batch;
+    }
+
+    // Note: attaching processes check magic, it's set after the cache is ready
+    if (page_type == LIBCACHE_PAGE_SHARED) {
+        libcache_shm_t* shm = (libcache_shm_t*) large_memory;
+        shm->base = large_memory;
+        shm->length = shm_header_length + large_mem_size;
+        shm->handle_size = sizeof(libcache_t);
+        shm->sequence = 0;
+        strcpy(shm->name, attr->shm_name);
+        libcache->attr.shm_name = shm->name;
+        libcache->shm = shm;
+        __atomic_store_n(&shm->magic, LIBCACHE_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    return libcache;
+}
+
+/*
+ *  @brief libcache_lock_node  lock the node once, the first lock moves node from policy to lock_list.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param node             node in policy or lock_list.
+ */
+static inline void libcache_lock_node(libcache_t* libcache_ptr, node_t* node)
+{
+    libcache_node_usr_data_t* cache_data = (libcache_node_usr_data_t*) node->usr_data;
+    if (0 == LOCK_COUNTER_LOAD(cache_data->lock_counter)) {
+        libcache_ptr->policy_ops->on_remove(libcache_ptr->policy_data, node);
+        list_push_front(libcache_ptr->lock_list, node);
+    }
+    LOCK_COUNTER_INC(cache_data->lock_counter);
+}
+
+/*
+ *  @brief libcache_unindex_record  removes the record from the ordered index and every secondary index it's in.
+ */
+static inline void libcache_unindex_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    // Note: a record which isn't in the ordered index, e.g. it failed to be added, is left by its key
+    if (unlikely(NULL != libcache_ptr->ordered_index)) {
+        libcache_btree_remove(libcache_ptr->ordered_index, record->hash_data.key, record);
+    }
+    if (likely(0 == libcache_ptr->secondary_number)) {
+        return;
+    }
+    int i;
+    for (i = 0; i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (NULL == libcache_ptr->secondary_tables[i]) {
+            continue;
+        }
+        libcache_secondary_entry_t* secondary = LIBCACHE_RECORD_SECONDARY(libcache_ptr, record, i);
+        if (secondary->indexed) {
+            hash_del(libcache_ptr->secondary_tables[i], secondary->hash_data.key, &secondary->hash_node,
+                    libcache_ptr->pool);
+            secondary->indexed = FALSE;
+        }
+    }
+}
+
+/*
+ *  @brief libcache_free_node  release the record of the node and its entry to pool.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param node             node which is already removed from policy and lock_list.
+ */
+static inline void libcache_free_node(libcache_t* libcache_ptr, node_t* node)
+{
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    record->generation = 0;
+    libcache_unindex_record(libcache_ptr, record);
+    if (unlikely(NULL != libcache_ptr->ttl_wheel)) {
+        libcache_ttl_disarm(libcache_ptr->ttl_wheel, LIBCACHE_RECORD_TTL(record));
+    }
+    // Note: a dirty entry which isn't flushed before, e.g. a deleted one, is discarded
+    if (unlikely(0 != libcache_ptr->dirty_offset)) {
+        libcache_dirty_entry_t* dirty = LIBCACHE_RECORD_DIRTY(libcache_ptr, record);
+        if (NULL != dirty->dirty_node.usr_data) {
+            list_remove(&libcache_ptr->dirty_list, &dirty->dirty_node);
+            dirty->dirty_node.usr_data = NULL;
+        }
+    }
+    if (NULL != libcache_ptr->entry_slab) {
+        pool_slab_free_element(libcache_ptr->entry_slab, record->entry);
+    }
+    pool_free_element(libcache_ptr->pool, POOL_TYPE_DATA, (char*) record - libcache_ptr->record_offset);
+}
+
+/*
+ *  @brief libcache_unlock_node  unlock the node once, the last unlock gives node back to policy.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param node             node in lock_list.
+ */
+static inline void libcache_unlock_node(libcache_t* libcache_ptr, node_t* node)
+{
+    libcache_node_usr_data_t* cache_data = (libcache_node_usr_data_t*) node->usr_data;
+    if (0 == LOCK_COUNTER_DEC(cache_data->lock_counter)) {
+        list_remove(libcache_ptr->lock_list, node);
+        // Note: nobody waits for a failed load any more, its entry was never valid, it isn't released
+        libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+        if (unlikely(LIBCACHE_ENTRY_LOAD_FAILED == cache_data->entry_length)) {
+            libcache_shm_write_begin(libcache_ptr);
+            hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+            libcache_free_node(libcache_ptr, node);
+            libcache_shm_write_end(libcache_ptr);
+            return;
+        }
+        libcache_ptr->policy_ops->on_insert(libcache_ptr->policy_data, node);
+        // Note: an entry found expired while it was locked left the wheel, it's due at once now
+        libcache_ttl_entry_t* ttl = unlikely(NULL != libcache_ptr->ttl_wheel) ? LIBCACHE_RECORD_TTL(record) : NULL;
+        if (unlikely(NULL != ttl && LIBCACHE_TTL_UNLINKED == ttl->slot && 0 != ttl->expire_at)) {
+            libcache_ttl_arm(libcache_ptr->ttl_wheel, ttl);
+        }
+    }
+}
+
+/*
+ *  @brief libcache_release_record  tells release_entry the entry of the record is leaving the cache.
+ */
+static inline void libcache_release_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    if (unlikely(NULL != libcache_ptr->release_entry) && likely(!LIBCACHE_RECORD_ABSENT(record))) {
+        libcache_ptr->release_entry(record->hash_data.key, record->entry);
+    }
+}
+
+/*
+ *  @brief libcache_flush_record  writes the entry of the record alone by flush_entries if it's dirty, it's clean then.
+ *                                It's called for every entry swapped out or expired, before it's released.
+ */
+static inline void libcache_flush_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    if (likely(0 == libcache_ptr->dirty_offset)) {
+        return;
+    }
+    libcache_dirty_entry_t* dirty = LIBCACHE_RECORD_DIRTY(libcache_ptr, record);
+    if (NULL == dirty->dirty_node.usr_data) {
+        return;
+    }
+    list_remove(&libcache_ptr->dirty_list, &dirty->dirty_node);
+    dirty->dirty_node.usr_data = NULL;
+    if (unlikely(LIBCACHE_RECORD_ABSENT(record))) {
+        return;
+    }
+    const void* key = record->hash_data.key;
+    const void* entry = record->entry;
+    size_t entry_length = record->cache_data.entry_length;
+    libcache_ptr->attr.flush_entries(&key, &entry, &entry_length, 1);
+    LIBCACHE_STATS_INC(libcache_ptr, flushes);
+}
+
+/*
+ *  @brief libcache_entry_compressed  tells whether an entry of entry_length bytes is stored compressed,
+ *                                    i.e. its slab element is smaller than the entry.
+ */
+static inline int libcache_entry_compressed(const libcache_t* libcache_ptr, const void* entry, uint32_t entry_length)
+{
+    return unlikely(NULL != libcache_ptr->compress_table) && entry_length <= libcache_ptr->entry_size
+            && pool_slab_get_element_size(libcache_ptr->entry_slab, entry) < entry_length;
+}
+
+/*
+ *  @brief libcache_copy_entry  copies an entry of entry_length bytes into dst_entry, a compressed one
+ *                              is decompressed.
+ */
+static inline void libcache_copy_entry(const libcache_t* libcache_ptr, const void* entry, uint32_t entry_length,
+        void* dst_entry)
+{
+    if (likely(!libcache_entry_compressed(libcache_ptr, entry, entry_length))) {
+        memcpy(dst_entry, entry, entry_length);
+    } else if (unlikely(!libcache_decompress(entry, pool_slab_get_element_size(libcache_ptr->entry_slab, entry),
+            dst_entry, entry_length))) {
+        DEBUG_ERROR("compressed entry of %u bytes is corrupted", entry_length);
+    }
+}
+
+/*
+ *  @brief libcache_inflate_record  decompresses the entry of a record into an element of its size class, so its
+ *                                  pointer can be given out, it isn't compressed again.
+ *
+ *  @return FALSE           there's no free memory of its size class, nothing is swapped out for it.
+ */
+static int libcache_inflate_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    void* entry = pool_slab_get_element(libcache_ptr->entry_slab, record->cache_data.entry_length);
+    if (unlikely(NULL == entry)) {
+        DEBUG_INFO("no memory to decompress entry of %u bytes", record->cache_data.entry_length);
+        return FALSE;
+    }
+    libcache_copy_entry(libcache_ptr, record->entry, record->cache_data.entry_length, entry);
+    pool_slab_free_element(libcache_ptr->entry_slab, record->entry);
+    record->entry = entry;
+    pool_set_reserved_pointer(entry, (void*) &record->cache_node);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_deliver_evictions  gives the evicted entries in the batch to evicted_entries, it's empty then.
+ */
+static int libcache_deliver_evictions(libcache_t* libcache_ptr)
+{
+    libcache_evicted_batch_t* batch = libcache_ptr->evicted_batch;
+    int count = (int) batch->count;
+    if (count > 0) {
+        batch->count = 0;
+        libcache_ptr->attr.evicted_entries(batch->keys, batch->entries, batch->entry_lengths, batch->reasons, count);
+    }
+    return count;
+}
+
+/*
+ *  @brief libcache_demote_record  copies the entry of a record swapped out into cold_tier, unless it may expire.
+ */
+static void libcache_demote_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    if (unlikely(LIBCACHE_RECORD_ABSENT(record))
+            || (NULL != libcache_ptr->ttl_wheel && 0 != LIBCACHE_RECORD_TTL(record)->expire_at)) {
+        return;
+    }
+    uint32_t entry_length = record->cache_data.entry_length;
+    void* entry = libcache_tier_reserve(libcache_ptr->attr.cold_tier, record->hash_data.key, libcache_ptr->key_size,
+            entry_length);
+    if (likely(NULL != entry)) {
+        libcache_copy_entry(libcache_ptr, record->entry, entry_length, entry);
+        LIBCACHE_STATS_INC(libcache_ptr, demotions);
+    }
+}
+
+/*
+ *  @brief libcache_tier_forget  removes the entry of a key from cold_tier, e.g. once the key is added.
+ *
+ *  @return FALSE           there's no cold_tier, or the key isn't in it.
+ */
+static inline int libcache_tier_forget(const libcache_t* libcache_ptr, const void* key)
+{
+    return unlikely(NULL != libcache_ptr->attr.cold_tier)
+            && libcache_tier_remove(libcache_ptr->attr.cold_tier, key, libcache_ptr->key_size);
+}
+
+/*
+ *  @brief libcache_replicate  puts a record of no entry into replication, it's dropped if the ring is full.
+ */
+static inline void libcache_replicate(const libcache_t* libcache_ptr, libcache_replication_e type,
+        libcache_evict_e reason, const void* key, uint32_t argument)
+{
+    if (likely(NULL == libcache_ptr->attr.replication)) {
+        return;
+    }
+    if (NULL != libcache_replication_reserve(libcache_ptr->attr.replication, type, reason, key, 0, argument)) {
+        libcache_replication_commit(libcache_ptr->attr.replication);
+    }
+}
+
+/*
+ *  @brief libcache_replicate_add  puts an add of an entry into replication, it's dropped if the ring is full.
+ */
+static inline void libcache_replicate_add(const libcache_t* libcache_ptr, const void* key, const void* src_entry,
+        size_t entry_length, uint32_t ttl)
+{
+    if (likely(NULL == libcache_ptr->attr.replication)) {
+        return;
+    }
+    void* entry = libcache_replication_reserve(libcache_ptr->attr.replication, LIBCACHE_REPLICATION_ADD,
+            LIBCACHE_EVICT_SWAPPED, key, entry_length, ttl);
+    if (NULL != entry) {
+        memcpy(entry, src_entry, entry_length);
+        libcache_replication_commit(libcache_ptr->attr.replication);
+    }
+}
+
+/*
+ *  @brief libcache_replicate_record  puts an add of the entry of a record into replication, with the ttl left.
+ */
+static void libcache_replicate_record(const libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    uint32_t ttl = 0;
+    if (NULL != libcache_ptr->ttl_wheel && 0 != LIBCACHE_RECORD_TTL(record)->expire_at) {
+        uint32_t expire_at = LIBCACHE_RECORD_TTL(record)->expire_at;
+        ttl = (expire_at > libcache_ptr->ttl_wheel->clock) ? expire_at - libcache_ptr->ttl_wheel->clock : 1;
+    }
+    void* entry = libcache_replication_reserve(libcache_ptr->attr.replication, LIBCACHE_REPLICATION_ADD,
+            LIBCACHE_EVICT_SWAPPED, record->hash_data.key, record->cache_data.entry_length, ttl);
+    if (NULL != entry) {
+        libcache_copy_entry(libcache_ptr, record->entry, record->cache_data.entry_length, entry);
+        libcache_replication_commit(libcache_ptr->attr.replication);
+    }
+}
+
+/*
+ *  @brief libcache_evict_record  copies the entry of the record into the batch of evicted entries, before
+ *                                it's released, a full batch is delivered first. An entry swapped out is
+ *                                demoted into cold_tier too, and every one leaving is put into replication.
+ */
+static inline void libcache_evict_record(libcache_t* libcache_ptr, libcache_record_t* record, libcache_evict_e reason)
+{
+    if (unlikely(NULL != libcache_ptr->attr.replication) && !LIBCACHE_RECORD_ABSENT(record)) {
+        libcache_replicate(libcache_ptr, LIBCACHE_REPLICATION_DELETE, reason, record->hash_data.key, 0);
+    }
+    if (unlikely(NULL != libcache_ptr->attr.cold_tier) && LIBCACHE_EVICT_SWAPPED == reason) {
+        libcache_demote_record(libcache_ptr, record);
+    }
+    libcache_evicted_batch_t* batch = libcache_ptr->evicted_batch;
+    if (likely(NULL == batch) || unlikely(LIBCACHE_RECORD_ABSENT(record))) {
+        return;
+    }
+    if (unlikely(batch->count == batch->capacity)) {
+        libcache_deliver_evictions(libcache_ptr);
+    }
+    uint32_t i = batch->count++;
+    char* slot = batch->slots + i * batch->slot_size;
+    memcpy(slot, record->hash_data.key, libcache_ptr->key_size);
+    libcache_copy_entry(libcache_ptr, record->entry, record->cache_data.entry_length, slot + batch->entry_offset);
+    batch->entry_lengths[i] = record->cache_data.entry_length;
+    batch->reasons[i] = reason;
+}
+
+/*
+ *  @brief libcache_dirty_set  marks the entry of the record dirty, a dirty one stays where it is in dirty_list.
+ */
+static inline void libcache_dirty_set(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    libcache_dirty_entry_t* dirty = LIBCACHE_RECORD_DIRTY(libcache_ptr, record);
+    if (NULL == dirty->dirty_node.usr_data) {
+        dirty->dirty_node.usr_data = record;
+        list_push_back(&libcache_ptr->dirty_list, &dirty->dirty_node);
+    }
+}
+
+/*
+ *  @brief libcache_record_stale  checks if the tag of a record was invalidated after its entry was added.
+ */
+static inline int libcache_record_stale(const libcache_t* libcache_ptr, const libcache_record_t* record)
+{
+    if (likely(NULL == libcache_ptr->tag_generations)) {
+        return FALSE;
+    }
+    const libcache_tag_entry_t* tag = (const libcache_tag_entry_t*) ((const char*) record + libcache_ptr->tag_offset);
+    return libcache_ptr->tag_generations[tag->tag] != tag->generation;
+}
+
+/*
+ *  @brief libcache_node_missing  checks if the entry of a hash node is missing for lookups, it has expired
+ *                                by the clock of the cache or by an invalidation of its tag, or it's being loaded,
+ *                                or its load failed, or it's a negative entry.
+ */
+static inline int libcache_node_missing(const libcache_t* libcache_ptr, node_t* hash_node)
+{
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    return (unlikely(NULL != libcache_ptr->ttl_wheel)
+            && libcache_ttl_expired(libcache_ptr->ttl_wheel, LIBCACHE_RECORD_TTL(record)))
+            || unlikely(LIBCACHE_RECORD_ABSENT(record)) || unlikely(libcache_record_stale(libcache_ptr, record));
+}
+
+/*
+ *  @brief libcache_node_negative  checks if the entry of a hash node is a negative entry which hasn't expired.
+ */
+static inline int libcache_node_negative(const libcache_t* libcache_ptr, node_t* hash_node)
+{
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    return unlikely(LIBCACHE_ENTRY_NEGATIVE == __atomic_load_n(&record->cache_data.entry_length, __ATOMIC_RELAXED))
+            && !libcache_ttl_expired(libcache_ptr->ttl_wheel, LIBCACHE_RECORD_TTL(record))
+            && !libcache_record_stale(libcache_ptr, record);
+}
+
+/*
+ *  @brief libcache_expire_record  frees an unlocked expired entry, which is still in policy.
+ */
+static void libcache_expire_record(libcache_t* libcache_ptr, libcache_record_t* record)
+{
+    libcache_ptr->policy_ops->on_remove(libcache_ptr->policy_data, &record->cache_node);
+    libcache_flush_record(libcache_ptr, record);
+    libcache_evict_record(libcache_ptr, record, LIBCACHE_EVICT_EXPIRED);
+    libcache_release_record(libcache_ptr, record);
+    hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+    libcache_free_node(libcache_ptr, &record->cache_node);
+    LIBCACHE_STATS_INC(libcache_ptr, expirations);
+}
+
+/*
+ *  @brief libcache_try_expire  frees the entry of a hash node if it has expired and it isn't locked.
+ *
+ *  @param replace          TRUE if the key is being added, a negative entry is freed as well.
+ *  @return TRUE            the entry was freed, the hash node is gone.
+ *          FALSE           the entry is valid, or it's expired but locked, or it's a negative entry kept.
+ */
+static inline int libcache_try_expire(libcache_t* libcache_ptr, node_t* hash_node, int replace)
+{
+    if (likely(!libcache_node_missing(libcache_ptr, hash_node))) {
+        return FALSE;
+    }
+    // Note: an entry being loaded is always locked, only expired ones are freed
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    if (LOCK_COUNTER_LOAD(record->cache_data.lock_counter) > 0) {
+        return FALSE;
+    }
+    if (unlikely(libcache_node_negative(libcache_ptr, hash_node))) {
+        if (!replace) {
+            return FALSE;
+        }
+        // Note: the key is in the backend now, the negative entry is replaced, it didn't expire
+        libcache_ptr->policy_ops->on_remove(libcache_ptr->policy_data, &record->cache_node);
+        hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+        libcache_free_node(libcache_ptr, &record->cache_node);
+        return TRUE;
+    }
+    libcache_expire_record(libcache_ptr, record);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_ttl_victim  takes an unlocked expired entry the wheel has reached out of policy.
+ *
+ *  @return NULL            no expired entry to swap out, policy is asked then.
+ *          pointer         cache node of the entry, it's neither in policy nor in the wheel.
+ *  NOTE:  Expired entries which are locked leave the wheel, they're armed again once they're unlocked.
+ */
+static node_t* libcache_ttl_victim(libcache_t* libcache_ptr)
+{
+    if (likely(NULL == libcache_ptr->ttl_wheel)) {
+        return NULL;
+    }
+    node_t* wheel_node = NULL;
+    while (NULL != (wheel_node = libcache_ttl_advance(libcache_ptr->ttl_wheel))) {
+        libcache_record_t* record = (libcache_record_t*) wheel_node->usr_data;
+        libcache_ttl_disarm(libcache_ptr->ttl_wheel, LIBCACHE_RECORD_TTL(record));
+        if (0 == LOCK_COUNTER_LOAD(record->cache_data.lock_counter)) {
+            libcache_ptr->policy_ops->on_remove(libcache_ptr->policy_data, &record->cache_node);
+            LIBCACHE_STATS_INC(libcache_ptr, expirations);
+            return &record->cache_node;
+        }
+    }
+    return NULL;
+}
+
+/*
+ *  @brief libcache_new_record  gets a free record, and its entry if every entry is entry_size bytes.
+ *
+ *  @param libcache_ptr     cache object, it isn't full.
+ *  @return NULL            no free record.
+ *          pointer         the record, its lock counter is 0.
+ */
+static libcache_record_t* libcache_new_record(libcache_t* libcache_ptr)
+{
+    char* element = (char*) pool_get_element(libcache_ptr->pool, POOL_TYPE_DATA);
+    if (unlikely(NULL == element)) {
+        DEBUG_ERROR("no memory for record");
+        return NULL;
+    }
+    libcache_record_t* record = (libcache_record_t*) (element + libcache_ptr->record_offset);
+    record->cache_node.usr_data = &record->cache_data;
+    record->hash_node.usr_data = &record->hash_data;
+    record->hash_data.key = element + libcache_ptr->key_offset;
+    LOCK_COUNTER_STORE(record->cache_data.lock_counter, 0);
+    if (unlikely(NULL != libcache_ptr->ttl_wheel)) {
+        libcache_ttl_entry_t* ttl = LIBCACHE_RECORD_TTL(record);
+        ttl->wheel_node.usr_data = record;
+        ttl->expire_at = 0;
+        ttl->slot = LIBCACHE_TTL_UNLINKED;
+    }
+    if (unlikely(0 != libcache_ptr->dirty_offset)) {
+        LIBCACHE_RECORD_DIRTY(libcache_ptr, record)->dirty_node.usr_data = NULL;
+    }
+    int i;
+    for (i = 0; unlikely(0 != libcache_ptr->secondary_number) && i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (NULL != libcache_ptr->secondary_tables[i]) {
+            libcache_secondary_entry_t* secondary = LIBCACHE_RECORD_SECONDARY(libcache_ptr, record, i);
+            secondary->hash_node.usr_data = &secondary->hash_data;
+            secondary->hash_data.key = secondary + 1;
+            secondary->indexed = FALSE;
+        }
+    }
+
+    if (NULL == libcache_ptr->entry_slab) {
+        record->entry = element;
+        pool_set_reserved_pointer(record->entry, (void*) &record->cache_node);
+    }
+    return record;
+}
+
+/*
+ *  @brief libcache_swap_out  frees an unlocked entry selected by policy.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @return FALSE           all entries are locked.
+ *          TRUE            an entry was swapped out.
+ */
+static int libcache_swap_out(libcache_t* libcache_ptr)
+{
+    libcache_evict_e reason = LIBCACHE_EVICT_EXPIRED;
+    node_t* node = libcache_ttl_victim(libcache_ptr);
+    if (likely(NULL == node)) {
+        node = libcache_ptr->policy_ops->select_victim(libcache_ptr->policy_data);
+        if (unlikely(NULL == node)) {
+            return FALSE;
+        }
+        libcache_ptr->policy_ops->on_evict(libcache_ptr->policy_data, node);
+        LIBCACHE_STATS_INC(libcache_ptr, evictions);
+        reason = LIBCACHE_EVICT_SWAPPED;
+    }
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    libcache_flush_record(libcache_ptr, record);
+    libcache_evict_record(libcache_ptr, record, reason);
+    libcache_release_record(libcache_ptr, record);
+    hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+    libcache_free_node(libcache_ptr, node);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_new_sized_record  gets a free record and entry_length bytes for its entry,
+ *                                    entries selected by policy are swapped out if there isn't enough memory.
+ *
+ *  @param libcache_ptr     cache object in variable size entry mode.
+ *  @param entry_length     length of the entry.
+ *  @return NULL            all entries are locked, or no free record.
+ *          pointer         the record, its lock counter is 0.
+ */
+static libcache_record_t* libcache_new_sized_record(libcache_t* libcache_ptr, size_t entry_length)
+{
+    if (libcache_ptr->max_entry_number <= hash_get_count(libcache_ptr->hash_table)
+            && !libcache_swap_out(libcache_ptr)) {
+        return NULL;
+    }
+
+    // Note: slabs aren't moved between size classes, entries of other classes could be swapped out in vain
+    void* entry = NULL;
+    while (NULL == (entry = pool_slab_get_element(libcache_ptr->entry_slab, entry_length))) {
+        if (!libcache_swap_out(libcache_ptr)) {
+            DEBUG_INFO("no memory for entry of %zu bytes", entry_length);
+            return NULL;
+        }
+    }
+
+    libcache_record_t* record = libcache_new_record(libcache_ptr);
+    if (unlikely(NULL == record)) {
+        pool_slab_free_element(libcache_ptr->entry_slab, entry);
+        return NULL;
+    }
+    record->entry = entry;
+    pool_set_reserved_pointer(entry, (void*) &record->cache_node);
+    return record;
+}
+
+/*
+ *  @brief libcache_entry_to_node  gets the cache node of an entry.
+ *
+ *  @param entry            entry returned by libcache_lookup/libcache_add.
+ *  @return NULL            the entry isn't in any cache.
+ *          pointer         the cache node.
+ */
+static inline node_t* libcache_entry_to_node(void* entry)
+{
+    return (node_t*) pool_get_reserved_pointer(entry);
+}
+
+/*
+ *  @brief libcache_ttl_set  sets the expiry of an entry just added to a cache created with ttl, and arms it.
+ */
+static inline void libcache_ttl_set(libcache_t* libcache_ptr, void* entry, uint32_t expire_at)
+{
+    libcache_ttl_entry_t* ttl = LIBCACHE_RECORD_TTL(LIBCACHE_NODE_RECORD(libcache_entry_to_node(entry)));
+    ttl->expire_at = expire_at;
+    libcache_ttl_arm(libcache_ptr->ttl_wheel, ttl);
+}
+
+/*
+ *  @brief libcache_lookup_node  locks or copies out the entry of a hash node found by key.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param hash_node        hash node found, it could be NULL.
+ *  @param dst_entry        same as libcache_lookup's.
+ *  @return                 same as libcache_lookup's.
+ */
+static inline void* libcache_lookup_node(libcache_t* libcache_ptr, node_t* hash_node, void* dst_entry)
+{
+    if (unlikely(NULL == hash_node)) {
+        return NULL;
+    }
+
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    if (NULL == dst_entry) {
+        // Note: an entry used by pointer stays uncompressed, nodes found by a batch lookup aren't swapped out for it
+        if (unlikely(libcache_entry_compressed(libcache_ptr, record->entry, record->cache_data.entry_length))
+                && !libcache_inflate_record(libcache_ptr, record)) {
+            return NULL;
+        }
+        // Note: lock should be added here, locked node is moved into lock_list
+        libcache_lock_node(libcache_ptr, &record->cache_node);
+        return record->entry;
+    }
+
+    // Note: copy into dst_entry, no lock added
+    libcache_copy_entry(libcache_ptr, record->entry, record->cache_data.entry_length, dst_entry);
+
+    // Note: tell policy the node is used, locked node is given back to policy when unlocked.
+    if (0 == LOCK_COUNTER_LOAD(record->cache_data.lock_counter)) {
+        libcache_ptr->policy_ops->on_hit(libcache_ptr->policy_data, &record->cache_node);
+    }
+    return dst_entry;
+}
+
+/*
+ *  @brief libcache_extract_keys  extracts the secondary keys of an entry into secondary_keys, a key taken by
+ *                                an expired entry is freed, in the cache or the one being resized.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param self             record of the entry if it's in the cache, NULL for an entry being added.
+ *  @param indexes          output, bit i is set if the entry has a key in secondary index i.
+ *  @return LIBCACHE_SUCCESS    no key is taken by another entry.
+ *          LIBCACHE_EXISTING   a key is taken.
+ */
+static libcache_ret_t libcache_extract_keys(libcache_t* libcache_ptr, const void* entry, size_t entry_length,
+        const libcache_record_t* self, uint32_t* indexes)
+{
+    *indexes = 0;
+    int i;
+    for (i = 0; i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (NULL == libcache_ptr->secondary_tables[i]) {
+            continue;
+        }
+        char* key = libcache_ptr->secondary_keys + libcache_ptr->secondary_key_offsets[i];
+        if (!libcache_ptr->attr.secondary[i].extract_key(entry, entry_length, key)) {
+            continue;
+        }
+        libcache_t* cache = NULL;
+        for (cache = libcache_ptr; NULL != cache; cache = (cache == libcache_ptr) ? libcache_ptr->resize_from : NULL) {
+            node_t* hash_node = (node_t*) hash_find(cache->secondary_tables[i], key);
+            libcache_record_t* other = (NULL == hash_node) ? NULL : LIBCACHE_SECONDARY_NODE_RECORD(hash_node);
+            if (NULL != other && other != self && !libcache_try_expire(cache, &other->hash_node, TRUE)) {
+                DEBUG_INFO("the secondary key of index %d is existed in cache", i);
+                return LIBCACHE_EXISTING;
+            }
+        }
+        *indexes |= 1U << i;
+    }
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_index_record  adds the record to the secondary indexes by the keys libcache_extract_keys got.
+ *
+ *  @param libcache_ptr     cache object which extracted the keys.
+ *  @param owner            cache object the record is in.
+ */
+static void libcache_index_record(libcache_t* libcache_ptr, libcache_t* owner, libcache_record_t* record,
+        uint32_t indexes)
+{
+    int i;
+    for (i = 0; i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (0 == (indexes & (1U << i))) {
+            continue;
+        }
+        libcache_secondary_entry_t* secondary = LIBCACHE_RECORD_SECONDARY(owner, record, i);
+        if (unlikely(NULL == hash_add(owner->secondary_tables[i],
+                libcache_ptr->secondary_keys + libcache_ptr->secondary_key_offsets[i], &secondary->hash_node,
+                &record->cache_node, owner->pool))) {
+            DEBUG_ERROR("failed to add the secondary key of index %d", i);
+            continue;
+        }
+        secondary->indexed = TRUE;
+    }
+}
+
+/*
+ *  @brief libcache_insert_record  adds an entry of a missing key, see libcache_add_ex.
+ *
+ *  @param libcache_ptr     cache object, it isn't being resized.
+ *  @param position         where hash_find_position found the key missing, the key isn't hashed again.
+ */
+static libcache_ret_t libcache_insert_record(libcache_t* libcache_ptr, const void* key, const void* src_entry,
+        size_t entry_length, void** entry, const hash_position_t* position)
+{
+    node_t* unlock_node = NULL;
+    libcache_record_t* record;
+
+    // Note: secondary keys are checked first, an add whose key is taken changes nothing
+    uint32_t indexes = 0;
+    if (unlikely(0 != libcache_ptr->secondary_number) && NULL != src_entry
+            && LIBCACHE_SUCCESS != libcache_extract_keys(libcache_ptr, src_entry, entry_length, NULL, &indexes)) {
+        return LIBCACHE_EXISTING;
+    }
+
+    const void* stored_entry = src_entry;
+    size_t stored_length = entry_length;
+    if (unlikely(NULL != libcache_ptr->compress_table) && NULL != src_entry
+            && entry_length >= libcache_ptr->attr.compress_threshold) {
+        size_t compressed_length = libcache_compress(src_entry, entry_length, libcache_ptr->compress_buffer,
+                entry_length - 1, libcache_ptr->compress_table);
+        if (0 != compressed_length) {
+            stored_entry = libcache_ptr->compress_buffer;
+            stored_length = compressed_length;
+        }
+    }
+
+    if (NULL != libcache_ptr->entry_slab) {
+        // Note: entries of variable size, the record and its entry are replaced separately
+        record = libcache_new_sized_record(libcache_ptr, stored_length);
+        if (unlikely(NULL == record)) {
+            DEBUG_INFO("all data are in use, swap failed!");
+            return LIBCACHE_FULL;
+        }
+        // Note: compressed into the size class of the entry, it's kept uncompressed for the same memory
+        if (stored_entry != src_entry
+                && pool_slab_get_element_size(libcache_ptr->entry_slab, record->entry) >= entry_length) {
+            stored_entry = src_entry;
+            stored_length = entry_length;
+        }
+        unlock_node = &record->cache_node;
+    } else if (unlikely(libcache_ptr->max_entry_number <= hash_get_count(libcache_ptr->hash_table))) {
+        // Note: if cache pool is full, swap out an expired node, or an unlocked node selected by policy,
+        //       and reuse its record
+        DEBUG_INFO("the cache is full, try to swap old data out");
+        libcache_evict_e reason = LIBCACHE_EVICT_EXPIRED;
+        unlock_node = libcache_ttl_victim(libcache_ptr);
+        if (likely(NULL == unlock_node)) {
+            unlock_node = libcache_ptr->policy_ops->select_victim(libcache_ptr->policy_data);
+            if (unlikely(NULL == unlock_node)) {
+                DEBUG_INFO("all data are in use, swap failed!");
+                return LIBCACHE_FULL;
+            }
+            LIBCACHE_STATS_INC(libcache_ptr, evictions);
+            libcache_ptr->policy_ops->on_evict(libcache_ptr->policy_data, unlock_node);
+            reason = LIBCACHE_EVICT_SWAPPED;
+        }
+        DEBUG_INFO("swap data successfully!");
+        record = LIBCACHE_NODE_RECORD(unlock_node);
+        libcache_flush_record(libcache_ptr, record);
+        libcache_evict_record(libcache_ptr, record, reason);
+        libcache_release_record(libcache_ptr, record);
+        if (unlikely(NULL != libcache_ptr->ttl_wheel)) {
+            libcache_ttl_disarm(libcache_ptr->ttl_wheel, LIBCACHE_RECORD_TTL(record));
+            LIBCACHE_RECORD_TTL(record)->expire_at = 0;
+        }
+
+        hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+        libcache_unindex_record(libcache_ptr, record);
+    } else { // Note: if cache pool is not full, create new record
+        record = libcache_new_record(libcache_ptr);
+        if (unlikely(NULL == record)) {
+            return LIBCACHE_FULL;
+        }
+        unlock_node = &record->cache_node;
+    }
+
+    // Note: add node into hash, the key is copied into the record by hash
+    if (unlikely(NULL == hash_add_at(libcache_ptr->hash_table, position, key, &record->hash_node, unlock_node,
+            libcache_ptr->pool))) {
+        libcache_free_node(libcache_ptr, unlock_node);
+        return LIBCACHE_FULL;
+    }
+    if (unlikely(NULL != libcache_ptr->ordered_index)
+            && unlikely(!libcache_btree_insert(libcache_ptr->ordered_index, record->hash_data.key, record))) {
+        DEBUG_ERROR("failed to add the key to the ordered index");
+        hash_del(libcache_ptr->hash_table, record->hash_data.key, &record->hash_node, libcache_ptr->pool);
+        libcache_free_node(libcache_ptr, unlock_node);
+        return LIBCACHE_FULL;
+    }
+    record->cache_data.policy_entry.hash = record->hash_data.hash_tag;
+    record->cache_data.policy_entry.state = 0;
+    record->cache_data.entry_length = (uint32_t) entry_length;
+    // Note: a swapped out record is reused at once, its new generation makes handles of the old entry stale
+    record->generation = ++libcache_ptr->generation;
+    if (unlikely(NULL != libcache_ptr->tag_generations)) {
+        libcache_tag_entry_t* tag = LIBCACHE_RECORD_TAG(libcache_ptr, record);
+        tag->tag = libcache_ptr->attr.key_to_tag(record->hash_data.key) % libcache_ptr->attr.tags;
+        tag->generation = libcache_ptr->tag_generations[tag->tag];
+    }
+
+    if (NULL != src_entry) {
+        memcpy(record->entry, stored_entry, stored_length);
+        libcache_index_record(libcache_ptr, libcache_ptr, record, indexes);
+        libcache_ptr->policy_ops->on_insert(libcache_ptr->policy_data, unlock_node);
+    } else {
+        LOCK_COUNTER_STORE(record->cache_data.lock_counter, 1);
+        list_push_front(libcache_ptr->lock_list, unlock_node);
+    }
+    if (NULL != entry) {
+        *entry = record->entry;
+    }
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_add_record  adds an entry of entry_length bytes, see libcache_add_ex.
+ *
+ *  @param libcache_ptr     cache object, it isn't being resized.
+ */
+static libcache_ret_t libcache_add_record(libcache_t* libcache_ptr, const void* key, const void* src_entry,
+        size_t entry_length, void** entry)
+{
+    // Note: find node from hash by key, so not add the data, the key is added where its probe stopped
+    hash_position_t position;
+    node_t* hash_node = (node_t*) hash_find_position(libcache_ptr->hash_table, key, &position);
+    if (unlikely(NULL != hash_node)) {
+        if (likely(!libcache_try_expire(libcache_ptr, hash_node, TRUE))) {
+            DEBUG_INFO("the key is existed in cache");
+            return LIBCACHE_EXISTING;
+        }
+        // Note: the expired entry was freed, its key is probed again
+        hash_find_position(libcache_ptr->hash_table, key, &position);
+    }
+    return libcache_insert_record(libcache_ptr, key, src_entry, entry_length, entry, &position);
+}
+
+
+/*
+ *  @brief libcache_resize_move  moves an unlocked entry of the cache being resized into the cache.
+ *
+ *  @param libcache_ptr     cache object being resized.
+ *  @param node             node of resize_from, which is already removed from its policy.
+ */
+static void libcache_resize_move(libcache_t* libcache_ptr, node_t* node)
+{
+    libcache_t* old_cache = libcache_ptr->resize_from;
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    hash_del(old_cache->hash_table, record->hash_data.key, &record->hash_node, old_cache->pool);
+    // Note: its secondary keys are extracted again by the new cache, they mustn't be found taken by itself
+    libcache_unindex_record(old_cache, record);
+    // Note: a negative entry isn't moved, the key is loaded again by its next miss
+    if (unlikely(LIBCACHE_RECORD_ABSENT(record))) {
+        libcache_free_node(old_cache, node);
+        return;
+    }
+    // Note: an entry of an invalidated tag isn't moved, it's reclaimed as an expired one
+    if (unlikely(libcache_record_stale(old_cache, record))) {
+        libcache_flush_record(old_cache, record);
+        libcache_evict_record(old_cache, record, LIBCACHE_EVICT_EXPIRED);
+        libcache_release_record(old_cache, record);
+        libcache_free_node(old_cache, node);
+        LIBCACHE_STATS_INC(libcache_ptr, expirations);
+        return;
+    }
+
+    // Note: it's added as a new entry, if the cache shrinks, its own victims are swapped out for it
+    const void* src_entry = record->entry;
+    if (unlikely(libcache_entry_compressed(old_cache, record->entry, record->cache_data.entry_length))) {
+        libcache_copy_entry(old_cache, record->entry, record->cache_data.entry_length, old_cache->compress_buffer);
+        src_entry = old_cache->compress_buffer;
+    }
+    void* entry = NULL;
+    if (LIBCACHE_SUCCESS != libcache_add_record(libcache_ptr, record->hash_data.key, src_entry,
+            record->cache_data.entry_length, &entry)) {
+        // Note: the entry is dropped, it's written first if it's dirty
+        libcache_flush_record(old_cache, record);
+        libcache_evict_record(old_cache, record, LIBCACHE_EVICT_SWAPPED);
+        libcache_release_record(old_cache, record);
+        libcache_free_node(old_cache, node);
+        return;
+    }
+    if (unlikely(NULL != libcache_ptr->ttl_wheel && 0 != LIBCACHE_RECORD_TTL(record)->expire_at)) {
+        libcache_ttl_set(libcache_ptr, entry, LIBCACHE_RECORD_TTL(record)->expire_at);
+    }
+    // Note: a dirty entry is still dirty in the new cache, it's written once by either cache
+    if (unlikely(0 != old_cache->dirty_offset)
+            && NULL != LIBCACHE_RECORD_DIRTY(old_cache, record)->dirty_node.usr_data) {
+        libcache_dirty_set(libcache_ptr, LIBCACHE_NODE_RECORD(libcache_entry_to_node(entry)));
+    }
+    libcache_free_node(old_cache, node);
+}
+
+/*
+ *  @brief libcache_resize_step  moves a few entries of the cache being resized in the order policy swaps out,
+ *                               they're swapped out instead while all entries can't fit in the new cache.
+ *                               The old cache is destroyed once it's empty.
+ *
+ *  @param libcache_ptr     cache object being resized.
+ */
+static void libcache_resize_step(libcache_t* libcache_ptr)
+{
+    libcache_t* old_cache = libcache_ptr->resize_from;
+    int i;
+    for (i = 0; i < LIBCACHE_RESIZE_STEP; i++) {
+        // Note: locked entries are moved after they're unlocked
+        node_t* node = old_cache->policy_ops->select_victim(old_cache->policy_data);
+        if (NULL == node) {
+            break;
+        }
+        old_cache->policy_ops->on_evict(old_cache->policy_data, node);
+        if (likely(hash_get_count(libcache_ptr->hash_table) + hash_get_count(old_cache->hash_table)
+                <= libcache_ptr->max_entry_number)) {
+            libcache_resize_move(libcache_ptr, node);
+        } else {
+            // Note: if it shrinks, the coldest entries are swapped out until the others fit in the new cache
+            libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+            libcache_flush_record(old_cache, record);
+            libcache_evict_record(old_cache, record, LIBCACHE_EVICT_SWAPPED);
+            libcache_release_record(old_cache, record);
+            hash_del(old_cache->hash_table, record->hash_data.key, &record->hash_node, old_cache->pool);
+            libcache_free_node(old_cache, node);
+            LIBCACHE_STATS_INC(libcache_ptr, evictions);
+        }
+    }
+
+    if (0 == hash_get_count(old_cache->hash_table)) {
+        if (LIBCACHE_STATS_ON(libcache_ptr)) {
+            libcache_stats_merge(&libcache_ptr->stats, &old_cache->stats);
+            libcache_ptr->stats.entry_number = 0;
+        }
+        libcache_destroy(old_cache);
+        libcache_ptr->resize_from = NULL;
+    }
+}
+
+/*
+ *  @brief libcache_resize_owns  tells whether an entry is in the cache being resized.
+ */
+static inline int libcache_resize_owns(const libcache_t* libcache_ptr, const void* entry)
+{
+    const libcache_t* old_cache = libcache_ptr->resize_from;
+    return NULL != old_cache && (const char*) entry >= (const char*) old_cache->pool
+            && (const char*) entry < (const char*) old_cache->pool + old_cache->memory_length;
+}
+
+/*
+ *  @brief libcache_lazy_expire  takes an expired entry as missing, it's freed unless it's locked.
+ *
+ *  @return NULL            hash_node is NULL, or its entry has expired.
+ *          pointer         hash_node.
+ */
+static inline node_t* libcache_lazy_expire(libcache_t* libcache_ptr, node_t* hash_node)
+{
+    if (likely(NULL == hash_node || !libcache_node_missing(libcache_ptr, hash_node))) {
+        return hash_node;
+    }
+    libcache_try_expire(libcache_ptr, hash_node, FALSE);
+    return NULL;
+}
+
+/*
+ *  @brief libcache_find    finds the hash node of a key, an unlocked entry found in the cache being resized
+ *                          is moved at once, a locked one stays there. Expired entries are missing.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param key              key.
+ *  @param owner            output, cache object the found entry is in.
+ *  @return NULL            didn't find out such entry with the key.
+ *          pointer         the hash node.
+ */
+static inline node_t* libcache_find(libcache_t* libcache_ptr, const void* key, libcache_t** owner)
+{
+    *owner = libcache_ptr;
+    node_t* hash_node = NULL;
+    if (LIBCACHE_STATS_ON(libcache_ptr)) {
+        u32 probes = 0;
+        hash_node = (node_t*) hash_find_probed(libcache_ptr->hash_table, key, &probes);
+        libcache_ptr->stats.probe_histogram[(probes < LIBCACHE_STATS_PROBE_BUCKETS) ? probes
+                : LIBCACHE_STATS_PROBE_BUCKETS - 1]++;
+    } else {
+        hash_node = (node_t*) hash_find(libcache_ptr->hash_table, key);
+    }
+    hash_node = libcache_lazy_expire(libcache_ptr, hash_node);
+    if (likely(NULL != hash_node || NULL == libcache_ptr->resize_from)) {
+        return hash_node;
+    }
+
+    libcache_t* old_cache = libcache_ptr->resize_from;
+    hash_node = libcache_lazy_expire(old_cache, (node_t*) hash_find(old_cache->hash_table, key));
+    if (NULL == hash_node) {
+        return NULL;
+    }
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    if (LOCK_COUNTER_LOAD(record->cache_data.lock_counter) > 0) {
+        *owner = old_cache;
+        return hash_node;
+    }
+    old_cache->policy_ops->on_remove(old_cache->policy_data, &record->cache_node);
+    libcache_resize_move(libcache_ptr, &record->cache_node);
+    return (node_t*) hash_find(libcache_ptr->hash_table, key);
+}
+
+/*
+ *  @brief libcache_lookup   To look up an cache entry with a given key.
+ *
+ *  @param libcache          cache object, cannot be NULL.
+ *  @param key               key, cannot be NULL.
+ *  @param dst_entry         a copy of entry that fetch by key. it could be NULL.
+ *  @return NULL             didn't find out such entry with the key.
+ *          pointer          points to an entry with the key.
+ *  NOTE:  The entry in cache will be locked if dst_entry is NULL, one entry can be locked many times.
+ *         libcache_unlock_entry should be called to unlock the entry when the entry is not being used this time.
+ */
+void* libcache_lookup(void* libcache, const void* key, void* dst_entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return NULL;
+    }
+
+    if (unlikely(NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "key");
+        return NULL;
+    }
+
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_lookup(libcache_ptr, key, dst_entry, NULL);
+    }
+
+    // Note: a lookup locks the entry or tells policy, an attached cache reads by libcache_shm_read
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return NULL;
+    }
+
+    uint64_t start = libcache_stats_begin(libcache_ptr);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+    }
+
+    // Note: find the entry according to key
+    libcache_t* owner = NULL;
+    node_t* hash_node = libcache_find(libcache_ptr, key, &owner);
+    void* entry = libcache_lookup_node(owner, hash_node, dst_entry);
+    libcache_stats_lookup(libcache_ptr, entry, start);
+    return entry;
+}
+
+/*
+ *  @brief libcache_lookup_sized  same as libcache_lookup, it also gets the length of the entry.
+ */
+void* libcache_lookup_sized(void* libcache, const void* key, void* dst_entry, size_t* entry_length)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return NULL;
+    }
+
+    if (unlikely(NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "key");
+        return NULL;
+    }
+
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_lookup(libcache_ptr, key, dst_entry, entry_length);
+    }
+
+    // Note: a lookup locks the entry or tells policy, an attached cache reads by libcache_shm_read
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return NULL;
+    }
+
+    uint64_t start = libcache_stats_begin(libcache_ptr);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+    }
+
+    libcache_t* owner = NULL;
+    node_t* hash_node = libcache_find(libcache_ptr, key, &owner);
+    void* entry = libcache_lookup_node(owner, hash_node, dst_entry);
+    if (NULL != entry && NULL != entry_length) {
+        *entry_length = LIBCACHE_HASH_NODE_RECORD(hash_node)->cache_data.entry_length;
+    }
+    libcache_stats_lookup(libcache_ptr, entry, start);
+    return entry;
+}
+
+/*
+ *  @brief libcache_secondary_check  checks a cache has secondary index i, and it can be used.
+ */
+static inline int libcache_secondary_check(const libcache_t* libcache_ptr, uint32_t index)
+{
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return FALSE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr)
+            || index >= LIBCACHE_SECONDARY_INDEXES || NULL == libcache_ptr->secondary_tables[index])) {
+        DEBUG_ERROR("the cache has no secondary index %u, or it's attached", index);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void* libcache_lookup_by_index(void* libcache, uint32_t index, const void* key, void* dst_entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(!libcache_secondary_check(libcache_ptr, index))) {
+        return NULL;
+    }
+    if (unlikely(NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "key");
+        return NULL;
+    }
+
+    uint64_t start = libcache_stats_begin(libcache_ptr);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+    }
+
+    // Note: the secondary key gives the record, its own key is looked up then, expired or moving entries alike
+    libcache_t* owner = NULL;
+    node_t* hash_node = NULL;
+    for (owner = libcache_ptr; NULL != owner && NULL == hash_node;
+            owner = (owner == libcache_ptr) ? libcache_ptr->resize_from : NULL) {
+        hash_node = (node_t*) hash_find(owner->secondary_tables[index], key);
+    }
+    if (NULL != hash_node) {
+        hash_node = libcache_find(libcache_ptr, LIBCACHE_SECONDARY_NODE_RECORD(hash_node)->hash_data.key, &owner);
+    }
+    void* entry = libcache_lookup_node(owner, hash_node, dst_entry);
+    libcache_stats_lookup(libcache_ptr, entry, start);
+    return entry;
+}
+
+libcache_ret_t libcache_reindex_entry(void* libcache, void* entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or entry");
+        return LIBCACHE_FAILURE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr)
+            || 0 == libcache_ptr->secondary_number)) {
+        DEBUG_ERROR("the cache has no secondary index, or it's attached");
+        return LIBCACHE_FAILURE;
+    }
+
+    node_t* node = libcache_entry_to_node(entry);
+    if (unlikely(NULL == node || LIBCACHE_RECORD_ABSENT(LIBCACHE_NODE_RECORD(node)))) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    // Note: new keys are checked before old ones are removed, the entry keeps its old keys if one is taken
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    uint32_t indexes = 0;
+    if (LIBCACHE_SUCCESS != libcache_extract_keys(libcache_ptr, entry, record->cache_data.entry_length, record,
+            &indexes)) {
+        return LIBCACHE_EXISTING;
+    }
+    libcache_t* owner = libcache_resize_owns(libcache_ptr, entry) ? libcache_ptr->resize_from : libcache_ptr;
+    libcache_unindex_record(owner, record);
+    libcache_index_record(libcache_ptr, owner, record, indexes);
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_lookup_batch   To look up many cache entries, same as calling libcache_lookup for every key.
+ *
+ *  @param libcache          cache object, cannot be NULL.
+ *  @param keys              keys, cannot be NULL.
+ *  @param count             number of keys.
+ *  @param dst_entries       count * entry_size bytes, entries are copied one by one. it could be NULL.
+ *  @param entries           result of every key: NULL if not found, otherwise the same as libcache_lookup.
+ *  @return                  number of entries found.
+ *  NOTE:  All keys are hashed and their hash nodes are prefetched before any key is compared,
+ *         so cache misses of different keys overlap. Every found entry is locked if dst_entries is NULL.
+ */
+int libcache_lookup_batch(void* libcache, const void* const keys[], int count, void* dst_entries, void* entries[])
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == keys || NULL == entries || count < 0)) {
+        DEBUG_ERROR("input parameter %s is invalid", "libcache or keys or entries or count");
+        return 0;
+    }
+
+    int found = 0;
+    int i;
+    if (libcache_is_compact(libcache_ptr)) {
+        size_t entry_size = libcache_compact_get_entry_size(libcache_ptr);
+        for (i = 0; i < count; i++) {
+            void* dst_entry = (NULL == dst_entries) ? NULL : (char*) dst_entries + i * entry_size;
+            entries[i] = libcache_compact_lookup(libcache_ptr, keys[i], dst_entry, NULL);
+            if (entries[i] != NULL) {
+                found++;
+            }
+        }
+        return found;
+    }
+
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return 0;
+    }
+
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        // Note: keys may be in either cache while resizing, look them up one by one
+        for (i = 0; i < count; i++) {
+            void* dst_entry = (NULL == dst_entries) ? NULL : (char*) dst_entries + i * libcache_ptr->entry_size;
+            entries[i] = libcache_lookup(libcache_ptr, keys[i], dst_entry);
+            if (entries[i] != NULL) {
+                found++;
+            }
+        }
+        return found;
+    }
+
+    hash_find_batch(libcache_ptr->hash_table, keys, count, entries);
+    // Note: lock state shares cache line with hash node, only the entry is prefetched
+    for (i = 0; i < count; i++) {
+        if (entries[i] != NULL) {
+            prefetch(LIBCACHE_HASH_NODE_RECORD(entries[i])->entry);
+        }
+    }
+    for (i = 0; i < count; i++) {
+        void* dst_entry = (NULL == dst_entries) ? NULL : (char*) dst_entries + i * libcache_ptr->entry_size;
+        // Note: an expired entry is left to libcache_expire, a later key of the batch may find its node again
+        if (unlikely(NULL != entries[i] && libcache_node_missing(libcache_ptr, (node_t*) entries[i]))) {
+            entries[i] = NULL;
+        }
+        entries[i] = libcache_lookup_node(libcache_ptr, (node_t*) entries[i], dst_entry);
+        if (entries[i] != NULL) {
+            found++;
+        }
+    }
+    if (LIBCACHE_STATS_ON(libcache_ptr)) {
+        libcache_ptr->stats.lookup_hits += found;
+        libcache_ptr->stats.lookup_misses += count - found;
+    }
+    return found;
+}
+
+int libcache_lookup_burst(void* libcache, const void* const keys[], uint32_t count, uint64_t* hit_mask,
+        void* entries[])
+{
+    if (unlikely(NULL == hit_mask || count > LIBCACHE_BURST_MAX)) {
+        DEBUG_ERROR("input parameter %s is invalid", "hit_mask or count");
+        return 0;
+    }
+    int found = libcache_lookup_batch(libcache, keys, (int) count, NULL, entries);
+    uint64_t mask = 0;
+    uint32_t i;
+    for (i = 0; i < count && found > 0; i++) {
+        mask |= (uint64_t) (entries[i] != NULL) << i;
+    }
+    *hit_mask = mask;
+    return found;
+}
+
+/*
+ *  @brief libcache_peek     copies out an entry with a given key, it never writes the cache.
+ *
+ *  @param libcache          cache object, cannot be NULL.
+ *  @param key               key, cannot be NULL.
+ *  @param dst_entry         a copy of entry that fetch by key, cannot be NULL.
+ *  @return NULL             didn't find out such entry with the key.
+ *          pointer          dst_entry.
+ *  NOTE:  Replacement policy isn't told about the hit. It can run while another thread is writing the cache,
+ *         it always returns, but then the result is valid only if no write happened meanwhile,
+ *         e.g. libcache_sharded_read validates it with a sequence counter.
+ */
+void* libcache_peek(void* libcache, const void* key, void* dst_entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == key || NULL == dst_entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or key or dst_entry");
+        return NULL;
+    }
+
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_peek(libcache_ptr, key, dst_entry);
+    }
+
+    node_t* hash_node = (node_t*) hash_find_optimistic(libcache_ptr->hash_table, key);
+    if (NULL == hash_node) {
+        return (NULL == libcache_ptr->resize_from) ? NULL : libcache_peek(libcache_ptr->resize_from, key, dst_entry);
+    }
+    if (unlikely(libcache_node_missing(libcache_ptr, hash_node))) {
+        return NULL;
+    }
+
+    // Note: load every field once, the entry may be swapped out meanwhile
+    libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+    void* entry = __atomic_load_n(&record->entry, __ATOMIC_RELAXED);
+    uint32_t entry_length = __atomic_load_n(&record->cache_data.entry_length, __ATOMIC_RELAXED);
+    if (unlikely(NULL == entry || entry_length > libcache_ptr->entry_size)) {
+        return NULL;
+    }
+    libcache_copy_entry(libcache_ptr, entry, entry_length, dst_entry);
+    return dst_entry;
+}
+
+/*
+ *  @brief libcache_attach      maps a cache created with LIBCACHE_PAGE_SHARED by another process, read only.
+ */
+void* libcache_attach(const char* shm_name, LIBCACHE_CMP_KEY* cmp_key, LIBCACHE_KEY_TO_NUMBER* key_to_number)
+{
+    if (unlikely(NULL == shm_name)) {
+        DEBUG_ERROR("input parameter %s is null", "shm_name");
+        return NULL;
+    }
+
+    // Note: map the header anywhere to know where the creator mapped the segment
+    size_t length = 0;
+    libcache_shm_t* shm = (libcache_shm_t*) libcache_memory_attach_shared(shm_name, NULL, &length);
+    if (NULL == shm) {
+        return NULL;
+    }
+    void* base = NULL;
+    if (length >= sizeof(libcache_shm_t) && __atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == LIBCACHE_SHM_MAGIC
+            && shm->handle_size == sizeof(libcache_t) && shm->length == length
+            && (NULL != key_to_number || libcache_hash_resolve(shm->cache.attr.hash, shm->cache.attr.key_to_number)
+                    != LIBCACHE_HASH_DEFAULT)
+            && (NULL != cmp_key || NULL == shm->cache.attr.cmp_key)) {
+        base = shm->base;
+    }
+    libcache_memory_unmap_shared(shm, length, NULL);
+    if (unlikely(NULL == base)) {
+        DEBUG_ERROR("shared memory %s isn't a cache, or cmp_key or key_to_number is missing", shm_name);
+        return NULL;
+    }
+
+    shm = (libcache_shm_t*) libcache_memory_attach_shared(shm_name, base, &length);
+    if (NULL == shm) {
+        return NULL;
+    }
+    libcache_page_e page_type;
+    libcache_attached_t* attached = (libcache_attached_t*) libcache_memory_map(sizeof(libcache_attached_t),
+            LIBCACHE_PAGE_NORMAL, 0, &page_type);
+    if (unlikely(NULL == attached)) {
+        DEBUG_ERROR("Memory malloc failed!")
+        libcache_memory_unmap_shared(shm, length, NULL);
+        return NULL;
+    }
+
+    // Note: the creator's handle never changes after it's created, except the count of hash_t
+    attached->cache = shm->cache;
+    attached->hash = *(const hash_t*) shm->cache.hash_table;
+    attached->hash.kcmp = cmp_key;
+    attached->hash.k2num = key_to_number;
+    attached->cache.hash_table = &attached->hash;
+    attached->cache.shm = shm;
+    return &attached->cache;
+}
+
+/*
+ *  @brief libcache_shm_read    copies out an entry of a shared memory cache, validated by a sequence counter.
+ */
+void* libcache_shm_read(void* libcache, const void* key, void* dst_entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == key || NULL == dst_entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or key or dst_entry");
+        return NULL;
+    }
+
+    libcache_shm_t* shm = libcache_is_compact(libcache_ptr) ? NULL : libcache_ptr->shm;
+    if (unlikely(NULL == shm)) {
+        DEBUG_ERROR("the cache isn't in shared memory");
+        return NULL;
+    }
+
+    uint32_t retry;
+    for (retry = 0; retry < LIBCACHE_SHM_READ_RETRY; retry++) {
+        uint32_t seq = __atomic_load_n(&shm->sequence, __ATOMIC_ACQUIRE);
+        if (unlikely(seq & 1)) {
+            libcache_cpu_relax();
+            continue;
+        }
+        if (__atomic_load_n(&shm->magic, __ATOMIC_RELAXED) != LIBCACHE_SHM_MAGIC) {
+            DEBUG_INFO("the cache was destroyed by its creator");
+            return NULL;
+        }
+        if (libcache_is_attached(libcache_ptr)) {
+            ((hash_t*) libcache_ptr->hash_table)->entry_count =
+                    __atomic_load_n(&((const hash_t*) shm->cache.hash_table)->entry_count, __ATOMIC_RELAXED);
+        }
+        void* return_value = libcache_peek(libcache_ptr, key, dst_entry);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (likely(__atomic_load_n(&shm->sequence, __ATOMIC_RELAXED) == seq)) {
+            return return_value;
+        }
+    }
+
+    // Note: there is no lock shared with the creator to wait on, take it as a miss
+    DEBUG_INFO("the creator keeps changing the cache");
+    return NULL;
+}
+
+/*
+ *  @brief libcache_add         attempts to add an entry with a given key.
+ *
+ *  @param libcache             cache object, cannot be NULL.
+ *  @param key                  key, cannot be NULL.
+ *  @param src_entry            entry with an expected value to add.
+ *  @return NULL                could not add the entry because an entry with the same key is existing.
+ *          pointer             points to an entry with the key, so user can write value to it.
+ *  NOTE:   The entry in cache will be locked if src_entry is NULL, one entry can be locked many times.
+ *          libcache_unlock_entry should be called to unlock the e ntry when the entry is not being used this time.
+ */
+void* libcache_add(void * libcache, const void* key, const void* src_entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return NULL;
+    }
+
+    size_t entry_size = libcache_is_compact(libcache_ptr) ? libcache_compact_get_entry_size(libcache_ptr)
+            : libcache_ptr->entry_size;
+    return libcache_add_sized(libcache, key, src_entry, entry_size);
+}
+
+/*
+ *  @brief libcache_add_sized  attempts to add an entry of entry_length bytes with a given key.
+ */
+void* libcache_add_sized(void * libcache, const void* key, const void* src_entry, size_t entry_length)
+{
+    void* entry = NULL;
+    libcache_add_ex(libcache, key, src_entry, entry_length, &entry);
+    return entry;
+}
+
+/*
+ *  @brief libcache_add_entry  adds an entry of entry_length bytes which expires in ttl ticks, 0 means never,
+ *                             see libcache_add_ex and libcache_add_ttl.
+ */
+static libcache_ret_t libcache_add_entry(libcache_t* libcache_ptr, const void* key, const void* src_entry,
+        size_t entry_length, uint32_t ttl, void** entry)
+{
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "key");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_add(libcache_ptr, key, src_entry, entry_length, entry);
+    }
+
+    if (unlikely(entry_length > libcache_ptr->entry_size)) {
+        DEBUG_ERROR("entry length %zu is larger than entry size %zu", entry_length, libcache_ptr->entry_size);
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+        node_t* hash_node = (NULL == libcache_ptr->resize_from) ? NULL
+                : (node_t*) hash_find(libcache_ptr->resize_from->hash_table, key);
+        if (NULL != hash_node && !libcache_try_expire(libcache_ptr->resize_from, hash_node, TRUE)) {
+            DEBUG_INFO("the key is existed in cache being resized");
+            return LIBCACHE_EXISTING;
+        }
+    }
+
+    uint64_t start = libcache_stats_begin(libcache_ptr);
+    void* added = NULL;
+    libcache_shm_write_begin(libcache_ptr);
+    libcache_ret_t return_value = libcache_add_record(libcache_ptr, key, src_entry, entry_length, &added);
+    libcache_shm_write_end(libcache_ptr);
+    if (return_value == LIBCACHE_SUCCESS) {
+        libcache_tier_forget(libcache_ptr, key);
+        // Note: the entry is added as usual, then its expiry is set, it's in the handle's cache even while resizing
+        if (0 != ttl) {
+            uint64_t expire_at = (uint64_t) libcache_ptr->ttl_wheel->clock + ttl;
+            libcache_ttl_set(libcache_ptr, added, (expire_at > UINT32_MAX) ? UINT32_MAX : (uint32_t) expire_at);
+        }
+        // Note: an entry filled in place is put into replication by libcache_replicate_entry
+        if (NULL != src_entry) {
+            libcache_replicate_add(libcache_ptr, key, src_entry, entry_length, ttl);
+        }
+    }
+    if (NULL != entry) {
+        *entry = added;
+    }
+    if (LIBCACHE_STATS_ON(libcache_ptr)) {
+        if (return_value == LIBCACHE_SUCCESS) {
+            libcache_ptr->stats.adds++;
+        } else if (return_value == LIBCACHE_EXISTING) {
+            libcache_ptr->stats.add_existing++;
+        } else if (return_value == LIBCACHE_FULL) {
+            libcache_ptr->stats.add_full++;
+        }
+        libcache_stats_end(libcache_ptr, libcache_ptr->stats.add_latency_ns, start);
+    }
+    return return_value;
+}
+
+/*
+ *  @brief libcache_add_ex     attempts to add an entry of entry_length bytes, tells why if it fails.
+ */
+libcache_ret_t libcache_add_ex(void * libcache, const void* key, const void* src_entry, size_t entry_length,
+        void** entry)
+{
+    return libcache_add_entry((libcache_t*) libcache, key, src_entry, entry_length, 0, entry);
+}
+
+/*
+ *  @brief libcache_lookup_or_add_record  locks the entry of a key, or adds a locked one after the same probe.
+ *
+ *  @param libcache_ptr     cache object, it isn't being resized.
+ */
+static inline libcache_ret_t libcache_lookup_or_add_record(libcache_t* libcache_ptr, const void* key, void** entry)
+{
+    hash_position_t position;
+    node_t* hash_node = (node_t*) hash_find_position(libcache_ptr->hash_table, key, &position);
+    if (NULL != hash_node) {
+        if (likely(!libcache_try_expire(libcache_ptr, hash_node, FALSE))) {
+            // Note: an expired or loading entry which is locked, or a negative one, can be neither found nor replaced
+            if (unlikely(libcache_node_missing(libcache_ptr, hash_node))) {
+                return LIBCACHE_LOCKED;
+            }
+            *entry = libcache_lookup_node(libcache_ptr, hash_node, NULL);
+            return LIBCACHE_EXISTING;
+        }
+        hash_find_position(libcache_ptr->hash_table, key, &position);
+    }
+    return libcache_insert_record(libcache_ptr, key, NULL, libcache_ptr->entry_size, entry, &position);
+}
+
+/*
+ *  @brief libcache_resize_holds  checks if a key libcache_find took as missing is still in either cache while
+ *                                resizing, its entry is being loaded, negative, or expired but locked.
+ *  NOTE:  such an entry can be neither found nor replaced, as by libcache_lookup_or_add_record.
+ */
+static inline int libcache_resize_holds(libcache_t* libcache_ptr, const void* key)
+{
+    libcache_t* cache = NULL;
+    for (cache = libcache_ptr; NULL != cache; cache = (cache == libcache_ptr) ? libcache_ptr->resize_from : NULL) {
+        if (NULL != hash_find(cache->hash_table, key)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+ *  @brief libcache_lookup_or_insert  same as libcache_lookup_or_add, the entry of an inserted key is kept
+ *                                    in cold_tier, see libcache_load_begin_ex.
+ */
+static void* libcache_lookup_or_insert(libcache_t* libcache_ptr, const void* key, int* inserted)
+{
+    if (unlikely(NULL == libcache_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or key");
+        return NULL;
+    }
+
+    void* entry = NULL;
+    libcache_ret_t return_value = LIBCACHE_FAILURE;
+    if (libcache_is_compact(libcache_ptr)) {
+        // Note: the compact engine probes its chain twice on a miss
+        entry = libcache_compact_lookup(libcache_ptr, key, NULL, NULL);
+        return_value = (NULL != entry) ? LIBCACHE_EXISTING : libcache_compact_add(libcache_ptr, key, NULL,
+                libcache_compact_get_entry_size(libcache_ptr), &entry);
+    } else if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return NULL;
+    } else {
+        uint64_t start = libcache_stats_begin(libcache_ptr);
+        libcache_shm_write_begin(libcache_ptr);
+        if (likely(NULL == libcache_ptr->resize_from)) {
+            return_value = libcache_lookup_or_add_record(libcache_ptr, key, &entry);
+        } else {
+            // Note: the key may be in either cache while resizing, a missing key is probed again to add it
+            libcache_resize_step(libcache_ptr);
+            libcache_t* owner = NULL;
+            node_t* hash_node = libcache_find(libcache_ptr, key, &owner);
+            entry = libcache_lookup_node(owner, hash_node, NULL);
+            if (NULL != entry) {
+                return_value = LIBCACHE_EXISTING;
+            } else if (libcache_resize_holds(libcache_ptr, key)) {
+                return_value = LIBCACHE_LOCKED;
+            } else {
+                return_value = libcache_add_record(libcache_ptr, key, NULL, libcache_ptr->entry_size, &entry);
+            }
+        }
+        libcache_shm_write_end(libcache_ptr);
+        if (LIBCACHE_STATS_ON(libcache_ptr)) {
+            if (return_value == LIBCACHE_EXISTING) {
+                libcache_ptr->stats.lookup_hits++;
+            } else {
+                libcache_ptr->stats.lookup_misses++;
+                if (return_value == LIBCACHE_SUCCESS) {
+                    libcache_ptr->stats.adds++;
+                } else if (return_value == LIBCACHE_FULL) {
+                    libcache_ptr->stats.add_full++;
+                }
+            }
+            libcache_stats_end(libcache_ptr, libcache_ptr->stats.lookup_latency_ns, start);
+        }
+    }
+
+    if (return_value != LIBCACHE_SUCCESS && return_value != LIBCACHE_EXISTING) {
+        return NULL;
+    }
+    if (NULL != inserted) {
+        *inserted = (return_value == LIBCACHE_SUCCESS);
+    }
+    return entry;
+}
+
+void* libcache_lookup_or_add(void* libcache, const void* key, int* inserted)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    int added = FALSE;
+    void* entry = libcache_lookup_or_insert(libcache_ptr, key, &added);
+    if (NULL == entry) {
+        return NULL;
+    }
+    if (added && !libcache_is_compact(libcache_ptr)) {
+        libcache_tier_forget(libcache_ptr, key);
+    }
+    if (NULL != inserted) {
+        *inserted = added;
+    }
+    return entry;
+}
+
+int libcache_lookup_or_add_batch(void* libcache, const void* const keys[], int count, void* entries[],
+        int inserted[])
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == keys || NULL == entries || count < 0)) {
+        DEBUG_ERROR("input parameter %s is invalid", "libcache or keys or entries or count");
+        return 0;
+    }
+
+    // Note: only warm up the index as libcache_add_batch, every key is still probed once by itself
+    if (!libcache_is_compact(libcache_ptr) && !libcache_is_attached(libcache_ptr)) {
+        hash_find_batch(libcache_ptr->hash_table, keys, count, entries);
+    }
+
+    int got = 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        entries[i] = libcache_lookup_or_add(libcache_ptr, keys[i], (NULL == inserted) ? NULL : &inserted[i]);
+        if (entries[i] != NULL) {
+            got++;
+        } else if (NULL != inserted) {
+            inserted[i] = FALSE;
+        }
+    }
+    return got;
+}
+
+/*
+ *  @brief libcache_find_loading  finds the entry of a key being loaded, or a negative one which hasn't expired,
+ *                                in the cache or the one being resized.
+ *
+ *  @param owner            output, cache object the entry is in.
+ *  @return NULL            the entry of the key is neither being loaded nor negative.
+ *          pointer         its cache node.
+ */
+static node_t* libcache_find_loading(libcache_t* libcache_ptr, const void* key, libcache_t** owner)
+{
+    libcache_t* cache = NULL;
+    for (cache = libcache_ptr; NULL != cache; cache = (cache == libcache_ptr) ? libcache_ptr->resize_from : NULL) {
+        node_t* hash_node = (node_t*) hash_find(cache->hash_table, key);
+        libcache_record_t* record = (NULL == hash_node) ? NULL : LIBCACHE_HASH_NODE_RECORD(hash_node);
+        if (NULL != record && (LIBCACHE_ENTRY_LOADING == record->cache_data.entry_length
+                || libcache_node_negative(cache, hash_node))) {
+            *owner = cache;
+            return &record->cache_node;
+        }
+    }
+    return NULL;
+}
+
+/*
+ *  @brief libcache_promote  ends the load of a placeholder by the entry of its key in cold_tier.
+ *
+ *  @param location         NULL: the file is read, otherwise where the entry is if it's in the file, it isn't read.
+ *  @return FALSE           the entry isn't promoted, the placeholder is still being loaded.
+ */
+static int libcache_promote(libcache_t* libcache_ptr, const void* key, void* entry, libcache_tier_location_t* location)
+{
+    void* tier = libcache_ptr->attr.cold_tier;
+    size_t entry_length = 0;
+    if (NULL == location) {
+        if (!libcache_tier_read(tier, key, libcache_ptr->key_size, entry, &entry_length)) {
+            return FALSE;
+        }
+    } else {
+        libcache_tier_location_t found;
+        if (!libcache_tier_locate(tier, key, libcache_ptr->key_size, entry, &found)) {
+            return FALSE;
+        }
+        if (found.offset >= 0) {
+            *location = found;
+            return FALSE;
+        }
+        entry_length = found.entry_length;
+    }
+    // Note: the entry is removed from the tier by the end of the load
+    libcache_load_end(libcache_ptr, entry, entry_length, TRUE);
+    LIBCACHE_STATS_INC(libcache_ptr, promotions);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_load_begin_ex  same as libcache_load_begin, the entry of a missing key is promoted from cold_tier.
+ *
+ *  @param location         same as libcache_promote's.
+ */
+static libcache_ret_t libcache_load_begin_ex(libcache_t* libcache_ptr, const void* key, void** entry,
+        libcache_tier_location_t* location)
+{
+    if (unlikely(NULL == libcache_ptr || NULL == key || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or key or entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("entries are loaded by the pool engine, and not by an attached cache");
+        return LIBCACHE_FAILURE;
+    }
+
+    int inserted = FALSE;
+    *entry = libcache_lookup_or_insert(libcache_ptr, key, &inserted);
+    if (NULL != *entry) {
+        if (inserted) {
+            libcache_shm_write_begin(libcache_ptr);
+            __atomic_store_n(&LIBCACHE_NODE_RECORD(libcache_entry_to_node(*entry))->cache_data.entry_length,
+                    LIBCACHE_ENTRY_LOADING, __ATOMIC_RELAXED);
+            libcache_shm_write_end(libcache_ptr);
+            if (unlikely(NULL != libcache_ptr->attr.cold_tier)
+                    && libcache_promote(libcache_ptr, key, *entry, location)) {
+                return LIBCACHE_SUCCESS;
+            }
+            LIBCACHE_STATS_INC(libcache_ptr, loads);
+            return LIBCACHE_NOT_FOUND;
+        }
+        return LIBCACHE_SUCCESS;
+    }
+
+    // Note: the key is missing but can't be added, it may be loaded by someone else
+    libcache_t* owner = NULL;
+    node_t* node = libcache_find_loading(libcache_ptr, key, &owner);
+    if (NULL == node) {
+        return LIBCACHE_FAILURE;
+    }
+    if (unlikely(LIBCACHE_ENTRY_NEGATIVE == LIBCACHE_NODE_RECORD(node)->cache_data.entry_length)) {
+        LIBCACHE_STATS_INC(libcache_ptr, negative_hits);
+        return LIBCACHE_FAILURE;
+    }
+    libcache_lock_node(owner, node);
+    *entry = LIBCACHE_NODE_RECORD(node)->entry;
+    LIBCACHE_STATS_INC(libcache_ptr, load_waits);
+    return LIBCACHE_LOCKED;
+}
+
+libcache_ret_t libcache_load_begin(void* libcache, const void* key, void** entry)
+{
+    return libcache_load_begin_ex((libcache_t*) libcache, key, entry, NULL);
+}
+
+libcache_ret_t libcache_load_end(void* libcache, void* entry, size_t entry_length, int loaded)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(libcache_is_compact(libcache_ptr))) {
+        return LIBCACHE_FAILURE;
+    }
+    node_t* node = libcache_entry_to_node(entry);
+    if (unlikely(NULL == node || LIBCACHE_ENTRY_LOADING != LIBCACHE_NODE_RECORD(node)->cache_data.entry_length)) {
+        DEBUG_ERROR("the entry isn't being loaded");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(loaded && entry_length > libcache_ptr->entry_size)) {
+        DEBUG_ERROR("entry length %zu is larger than entry size %zu", entry_length, libcache_ptr->entry_size);
+        loaded = FALSE;
+    }
+
+    // Note: waiters read the entry once they see its length, it's published by the release store
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    if (loaded) {
+        __atomic_store_n(&record->cache_data.entry_length, (uint32_t) entry_length, __ATOMIC_RELEASE);
+        libcache_tier_forget(libcache_ptr, record->hash_data.key);
+        // Note: a loaded entry whose secondary key is taken stays in the cache, it's found by its key only
+        uint32_t indexes = 0;
+        if (unlikely(0 != libcache_ptr->secondary_number)
+                && LIBCACHE_SUCCESS == libcache_extract_keys(libcache_ptr, entry, entry_length, record, &indexes)) {
+            libcache_index_record(libcache_ptr,
+                    libcache_resize_owns(libcache_ptr, entry) ? libcache_ptr->resize_from : libcache_ptr, record,
+                    indexes);
+        }
+        if (unlikely(NULL != libcache_ptr->attr.replication)) {
+            libcache_replicate_record(libcache_ptr, record);
+        }
+        return LIBCACHE_SUCCESS;
+    }
+    if (unlikely(0 != libcache_ptr->attr.negative_ttl)) {
+        // Note: the negative entry is armed in the wheel by its last unlock, it goes back to policy then
+        uint64_t expire_at = (uint64_t) libcache_ptr->ttl_wheel->clock + libcache_ptr->attr.negative_ttl;
+        LIBCACHE_RECORD_TTL(record)->expire_at = (expire_at > UINT32_MAX) ? UINT32_MAX : (uint32_t) expire_at;
+        __atomic_store_n(&record->cache_data.entry_length, LIBCACHE_ENTRY_NEGATIVE, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&record->cache_data.entry_length, LIBCACHE_ENTRY_LOAD_FAILED, __ATOMIC_RELEASE);
+    }
+    libcache_unlock_entry(libcache_ptr, entry);
+    return LIBCACHE_FAILURE;
+}
+
+libcache_ret_t libcache_load_wait(void* entry)
+{
+    if (unlikely(NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    node_t* node = libcache_entry_to_node(entry);
+    if (unlikely(NULL == node)) {
+        return LIBCACHE_FAILURE;
+    }
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(node);
+    uint32_t entry_length = 0;
+    uint32_t spin = 0;
+    while (LIBCACHE_ENTRY_LOADING == (entry_length = __atomic_load_n(&record->cache_data.entry_length,
+            __ATOMIC_ACQUIRE))) {
+        if (likely(++spin < LIBCACHE_SPIN_COUNT)) {
+            libcache_cpu_relax();
+        } else {
+            spin = 0;
+            sched_yield();
+        }
+    }
+    return (entry_length >= LIBCACHE_ENTRY_NEGATIVE) ? LIBCACHE_FAILURE : LIBCACHE_SUCCESS;
+}
+
+void* libcache_lookup_or_load(void* libcache, const void* key, int* loaded)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (NULL != loaded) {
+        *loaded = FALSE;
+    }
+    if (unlikely(NULL == libcache_ptr || libcache_is_compact(libcache_ptr) || NULL == libcache_ptr->attr.load_entry)) {
+        DEBUG_ERROR("the cache wasn't created with load_entry");
+        return NULL;
+    }
+
+    void* entry = NULL;
+    libcache_ret_t return_value = libcache_load_begin(libcache, key, &entry);
+    if (LIBCACHE_SUCCESS == return_value) {
+        return entry;
+    }
+    if (LIBCACHE_LOCKED == return_value) {
+        // Note: the load of another caller can't end while the cache is held by this one
+        libcache_unlock_entry(libcache, entry);
+        return NULL;
+    }
+    if (LIBCACHE_NOT_FOUND != return_value) {
+        return NULL;
+    }
+
+    size_t entry_length = libcache_ptr->entry_size;
+    int result = libcache_ptr->attr.load_entry(key, entry, &entry_length);
+    if (LIBCACHE_SUCCESS != libcache_load_end(libcache, entry, entry_length, result)) {
+        return NULL;
+    }
+    if (NULL != loaded) {
+        *loaded = TRUE;
+    }
+    return entry;
+}
+
+/*
+ *  @brief libcache_ttl_check   checks the parameters of the ttl functions.
+ */
+static inline int libcache_ttl_check(const libcache_t* libcache_ptr)
+{
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return FALSE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || NULL == libcache_ptr->ttl_wheel
+            || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("the cache wasn't created with ttl, or it's attached");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+libcache_ret_t libcache_add_ttl(void* libcache, const void* key, const void* src_entry, size_t entry_length,
+        uint32_t ttl, void** entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(!libcache_ttl_check(libcache_ptr))) {
+        return LIBCACHE_FAILURE;
+    }
+
+    return libcache_add_entry(libcache_ptr, key, src_entry, entry_length, ttl, entry);
+}
+
+/*
+ *  @brief libcache_expire_wheel  advances the clock of one cache, and reclaims up to budget entries by its wheel.
+ */
+static int libcache_expire_wheel(libcache_t* libcache_ptr, uint32_t now, int budget)
+{
+    libcache_ttl_wheel_t* wheel = libcache_ptr->ttl_wheel;
+    if (now > wheel->clock) {
+        wheel->clock = now;
+    }
+    int expired = 0;
+    node_t* wheel_node = NULL;
+    while (expired < budget && NULL != (wheel_node = libcache_ttl_advance(wheel))) {
+        libcache_record_t* record = (libcache_record_t*) wheel_node->usr_data;
+        // Note: a locked entry leaves the wheel, it's armed again once it's unlocked
+        libcache_ttl_disarm(wheel, LIBCACHE_RECORD_TTL(record));
+        if (0 == LOCK_COUNTER_LOAD(record->cache_data.lock_counter)) {
+            libcache_expire_record(libcache_ptr, record);
+            expired++;
+        }
+    }
+    return expired;
+}
+
+int libcache_expire(void* libcache, uint32_t now, int budget)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(!libcache_ttl_check(libcache_ptr))) {
+        return 0;
+    }
+
+    libcache_shm_write_begin(libcache_ptr);
+    int expired = libcache_expire_wheel(libcache_ptr, now, budget);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        expired += libcache_expire_wheel(libcache_ptr->resize_from, now, budget - expired);
+    }
+    libcache_shm_write_end(libcache_ptr);
+    return expired;
+}
+
+/*
+ *  @brief libcache_tag_check  checks if a cache tags its entries, and tag is one of them.
+ */
+static inline int libcache_tag_check(const libcache_t* libcache_ptr, uint32_t tag)
+{
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return FALSE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || NULL == libcache_ptr->tag_generations
+            || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("the cache wasn't created with tags, or it's attached");
+        return FALSE;
+    }
+    if (unlikely(tag >= libcache_ptr->attr.tags)) {
+        DEBUG_ERROR("argument %s is invalid.", "tag");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+libcache_ret_t libcache_invalidate_tag(void* libcache, uint32_t tag)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(!libcache_tag_check(libcache_ptr, tag))) {
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: entries of the tag are reclaimed lazily, by lookups and adds of their keys or by policy
+    libcache_shm_write_begin(libcache_ptr);
+    libcache_ptr->tag_generations[tag]++;
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_ptr->resize_from->tag_generations[tag]++;
+    }
+    libcache_shm_write_end(libcache_ptr);
+    libcache_replicate(libcache_ptr, LIBCACHE_REPLICATION_INVALIDATE_TAG, LIBCACHE_EVICT_DELETED, NULL, tag);
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_dirty_check  checks if a cache tracks dirty entries.
+ */
+static inline int libcache_dirty_check(const libcache_t* libcache_ptr)
+{
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return FALSE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || 0 == libcache_ptr->dirty_offset
+            || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("the cache wasn't created with flush_entries, or it's attached");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+libcache_ret_t libcache_mark_dirty(void* libcache, void* entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(!libcache_dirty_check(libcache_ptr))) {
+        return LIBCACHE_FAILURE;
+    }
+    if (unlikely(NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    node_t* node = libcache_entry_to_node(entry);
+    if (unlikely(NULL == node)) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    // Note: a locked entry may still be in the cache being resized, it's dirty there until it's moved
+    libcache_t* owner = libcache_resize_owns(libcache_ptr, entry) ? libcache_ptr->resize_from : libcache_ptr;
+    libcache_dirty_set(owner, LIBCACHE_NODE_RECORD(node));
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_replicate_entry(void* libcache, void* entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or entry");
+        return LIBCACHE_FAILURE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || NULL == libcache_ptr->attr.replication
+            || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("the cache wasn't created with replication, or it's attached");
+        return LIBCACHE_FAILURE;
+    }
+
+    node_t* node = libcache_entry_to_node(entry);
+    if (unlikely(NULL == node || LIBCACHE_RECORD_ABSENT(LIBCACHE_NODE_RECORD(node)))) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    // Note: the ttl is the one of the cache owning the entry, it may still be the cache being resized
+    libcache_t* owner = libcache_resize_owns(libcache_ptr, entry) ? libcache_ptr->resize_from : libcache_ptr;
+    libcache_replicate_record(owner, LIBCACHE_NODE_RECORD(node));
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_flush_key_smaller  orders keys of a flush batch by cmp_key, bytewise without one.
+ */
+static inline int libcache_flush_key_smaller(const libcache_t* libcache_ptr, const void* key1, const void* key2)
+{
+    if (NULL == libcache_ptr->attr.cmp_key) {
+        return memcmp(key1, key2, libcache_ptr->attr.key_size) < 0;
+    }
+    return LIBCACHE_SMALLER == libcache_ptr->attr.cmp_key(key1, key2);
+}
+
+/*
+ *  @brief libcache_flush_list  writes up to budget dirty entries of one cache, a batch at a time.
+ */
+static int libcache_flush_list(libcache_t* libcache_ptr, int budget)
+{
+    const void* keys[LIBCACHE_FLUSH_BATCH];
+    const void* entries[LIBCACHE_FLUSH_BATCH];
+    size_t entry_lengths[LIBCACHE_FLUSH_BATCH];
+    int flushed = 0;
+    while (flushed < budget && !list_empty(&libcache_ptr->dirty_list)) {
+        int count = 0;
+        node_t* dirty_node = NULL;
+        while (count < LIBCACHE_FLUSH_BATCH && flushed + count < budget
+                && NULL != (dirty_node = list_pop_front(&libcache_ptr->dirty_list))) {
+            libcache_record_t* record = (libcache_record_t*) dirty_node->usr_data;
+            dirty_node->usr_data = NULL;
+            // Note: an entry marked while it was being loaded has nothing to write if its load failed
+            if (unlikely(LIBCACHE_RECORD_ABSENT(record))) {
+                continue;
+            }
+            // Note: insertion by key, keys which compare equal stay in the order they became dirty
+            int i = count++;
+            while (i > 0 && libcache_flush_key_smaller(libcache_ptr, record->hash_data.key, keys[i - 1])) {
+                keys[i] = keys[i - 1];
+                entries[i] = entries[i - 1];
+                entry_lengths[i] = entry_lengths[i - 1];
+                i--;
+            }
+            keys[i] = record->hash_data.key;
+            entries[i] = record->entry;
+            entry_lengths[i] = record->cache_data.entry_length;
+        }
+        libcache_ptr->attr.flush_entries(keys, entries, entry_lengths, count);
+        flushed += count;
+    }
+    return flushed;
+}
+
+int libcache_flush(void* libcache, int budget)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(!libcache_dirty_check(libcache_ptr))) {
+        return 0;
+    }
+    if (budget <= 0) {
+        budget = INT_MAX;
+    }
 
-    libcache->list = (list_t*) pool_get_element(pools, POOL_TYPE_LIST_T);
-    list_init(libcache->list);
+    int flushed = 0;
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        flushed = libcache_flush_list(libcache_ptr->resize_from, budget);
+    }
+    flushed += libcache_flush_list(libcache_ptr, budget - flushed);
+    if (LIBCACHE_STATS_ON(libcache_ptr)) {
+        libcache_ptr->stats.flushes += flushed;
+    }
+    return flushed;
+}
 
-    libcache->entry_size = entry_size;
-    libcache->key_size = key_size;
-    libcache->max_entry_number = max_entry;
-    libcache->free_memory = free_memory;
-    libcache->free_entry = free_entry;
+int libcache_drain_evictions(void* libcache)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return 0;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || NULL == libcache_ptr->evicted_batch
+            || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("the cache wasn't created with evicted_entries, or it's attached");
+        return 0;
+    }
 
-    return libcache;
+    // Note: the cache being resized evicts into its own batch, it's delivered first, it's older
+    int delivered = 0;
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        delivered = libcache_deliver_evictions(libcache_ptr->resize_from);
+    }
+    return delivered + libcache_deliver_evictions(libcache_ptr);
 }
 
 /*
- *  @brief libcache_lookup   To look up an cache entry with a given key.
+ * A scan cursor is | memory epoch + 1 | record index |, 0 starts a scan and ends it.
+ */
+#define LIBCACHE_SCAN_WALK 10
+#define LIBCACHE_SCAN_CURSOR(epoch, index) ((((uint64_t) (epoch) + 1) << 32) | (uint32_t) (index))
+
+/*
+ *  @brief libcache_scan_records  copies out entries of one cache from the record of index on, in memory order.
  *
- *  @param libcache          cache object, cannot be NULL.
- *  @param key               key, cannot be NULL.
- *  @param dst_entry         a copy of entry that fetch by key. it could be NULL.
- *  @return NULL             didn't find out such entry with the key.
- *          pointer          points to an entry with the key.
- *  NOTE:  The entry in cache will be locked if dst_entry is NULL, one entry can be locked many times.
- *         libcache_unlock_entry should be called to unlock the entry when the entry is not being used this time.
+ *  @param index            input and output, the next record to walk.
+ *  @param walk             input and output, number of records left to walk.
+ *  @param count            input and output, number of entries in out.
+ *  @return FALSE           every record of the cache has been walked.
+ *          TRUE            more may be left.
  */
-void* libcache_lookup(void* libcache, const void* key, void* dst_entry)
+static int libcache_scan_records(libcache_t* libcache_ptr, uint32_t* index, uint64_t* walk, int batch,
+        libcache_scan_entry_t out[], int* count)
 {
-    libcache_t* libcache_ptr = (libcache_t*)libcache;
-    if (unlikely(NULL == libcache_ptr)) {
-        DEBUG_ERROR("input parameter %s is null", "libcache");
-        return NULL;
+    while (*walk > 0 && *count < batch) {
+        char* element = (char*) pool_get_element_at(libcache_ptr->pool, POOL_TYPE_DATA, *index);
+        if (NULL == element) {
+            return FALSE;
+        }
+        (*index)++;
+        (*walk)--;
+        // Note: a freed record has generation 0, one left by pool_reset is below the floor
+        libcache_record_t* record = (libcache_record_t*) (element + libcache_ptr->record_offset);
+        if (record->generation <= libcache_ptr->generation_floor
+                || libcache_node_missing(libcache_ptr, &record->hash_node)) {
+            continue;
+        }
+        out[*count].key = record->hash_data.key;
+        out[*count].entry = record->entry;
+        out[*count].entry_length = record->cache_data.entry_length;
+        (*count)++;
     }
+    return TRUE;
+}
 
-    if (unlikely(NULL == key)) {
-        DEBUG_ERROR("input parameter %s is null", "key");
-        return NULL;
+int libcache_scan(void* libcache, uint64_t* cursor, int batch, libcache_scan_entry_t out[])
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == cursor || NULL == out || batch <= 0)) {
+        DEBUG_ERROR("input parameter %s is invalid", "libcache or cursor or out or batch");
+        return 0;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr)
+            || NULL != libcache_ptr->compress_table)) {
+        DEBUG_ERROR("a compact, attached or compressing cache can't be scanned");
+        *cursor = 0;
+        return 0;
     }
 
-    void* return_value = NULL;
+    // Note: records only move by resize, into the memory of the next epoch, which is walked after the old one
+    uint32_t current = libcache_ptr->memory_epoch;
+    uint32_t oldest = (NULL != libcache_ptr->resize_from) ? current - 1 : current;
+    uint32_t epoch = (uint32_t) (*cursor >> 32) - 1;
+    uint32_t index = (uint32_t) *cursor;
+    if (0 == *cursor || epoch < oldest || epoch > current) {
+        // Note: the memory the cursor was in is gone, all its records moved on, the scan goes on from the oldest
+        epoch = oldest;
+        index = 0;
+    }
 
-    do {
-        // Note: find the entry according to key
-        node_t* hash_node = (node_t*)hash_find(libcache_ptr->hash_table, key);
-        if (unlikely(NULL == hash_node)) {
-            break;
+    uint64_t walk = (uint64_t) batch * LIBCACHE_SCAN_WALK;
+    int count = 0;
+    if (epoch != current) {
+        if (libcache_scan_records(libcache_ptr->resize_from, &index, &walk, batch, out, &count)) {
+            *cursor = LIBCACHE_SCAN_CURSOR(epoch, index);
+            return count;
         }
+        epoch = current;
+        index = 0;
+    }
+    *cursor = libcache_scan_records(libcache_ptr, &index, &walk, batch, out, &count)
+            ? LIBCACHE_SCAN_CURSOR(epoch, index) : 0;
+    return count;
+}
 
-        node_t* libcache_node = (node_t*)((hash_data_t*)hash_node->usr_data)->cache_node_ptr;
-        if (unlikely(NULL == libcache_node)) {
-            break;
-        }
+/*
+ *  @brief libcache_range_visit_t  a range over the ordered index of one cache, see libcache_range.
+ */
+typedef struct libcache_range_visit_t
+{
+    libcache_t* owner;  /* cache of the index being walked */
+    LIBCACHE_RANGE_ENTRY* callback;
+    void* arg;
+    int count;
+} libcache_range_visit_t;
 
-        if (NULL == dst_entry) {
-            // Note: lock should be added here
-            ((libcache_node_usr_data_t*)libcache_node->usr_data)->lock_counter++;
+static int libcache_range_record(const void* key, void* item, void* arg)
+{
+    libcache_range_visit_t* visit = (libcache_range_visit_t*) arg;
+    libcache_record_t* record = (libcache_record_t*) item;
+    // Note: expired and negative entries and entries being loaded are in the index too, they're skipped
+    if (libcache_node_missing(visit->owner, &record->hash_node)) {
+        return TRUE;
+    }
+    visit->count++;
+    return visit->callback(key, record->entry, record->cache_data.entry_length, visit->arg);
+}
 
-            return_value = ((libcache_node_usr_data_t*)libcache_node->usr_data)->pool_element_ptr;
-        } else {
-            // Note: copy into dst_entry and return NULL, no lock added too
-            memcpy(dst_entry, ((libcache_node_usr_data_t*)libcache_node->usr_data)->pool_element_ptr, libcache_ptr->entry_size);
-            return_value = dst_entry;
-        }
+int libcache_range(void* libcache, const void* lo, const void* hi, LIBCACHE_RANGE_ENTRY* callback, void* arg)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == callback)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or callback");
+        return -1;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr)
+            || NULL == libcache_ptr->ordered_index)) {
+        DEBUG_ERROR("a compact or attached cache, or one created without ordered, has no ordered index");
+        return -1;
+    }
 
-        // Note: put the newest found node in front of list
-       // list_remove(libcache_ptr->list, libcache_node);
-       // list_push_front(libcache_ptr->list, libcache_node);
+    // Note: entries of the cache being resized are visited first, the ones moved already are in the new index
+    libcache_range_visit_t visit = { libcache_ptr->resize_from, callback, arg, 0 };
+    if (unlikely(NULL != libcache_ptr->resize_from)
+            && !libcache_btree_range(libcache_ptr->resize_from->ordered_index, lo, hi, libcache_range_record, &visit)) {
+        return visit.count;
+    }
+    visit.owner = libcache_ptr;
+    libcache_btree_range(libcache_ptr->ordered_index, lo, hi, libcache_range_record, &visit);
+    return visit.count;
+}
+
+/*
+ *  @brief libcache_get_pool_stats  gets occupancy of a pool of the cache.
+ */
+libcache_ret_t libcache_get_pool_stats(void* libcache, int pool_type, struct pool_stats_t* stats)
+{
+    libcache_t* libcache_ptr = (libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == stats)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or stats");
+        return LIBCACHE_FAILURE;
+    }
 
-        list_swap_to_head(libcache_ptr->list, libcache_node);
+    if (unlikely(pool_type < 0 || pool_type >= POOL_TYPE_MAX)) {
+        DEBUG_ERROR("pool type %d is invalid", pool_type);
+        return LIBCACHE_FAILURE;
+    }
 
-    } while(0);
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_get_pool_stats(libcache_ptr, pool_type, stats);
+    }
 
-    return return_value;
+    return (pool_get_stats(libcache_ptr->pool, pool_type, stats) == OK) ? LIBCACHE_SUCCESS : LIBCACHE_FAILURE;
 }
 
 /*
- *  @brief libcache_get_unlock_node  find unlocked node in list.
- *
- *  @param node             node in list.
- *  @return 0: traversing over; 1: continue traversing
+ *  @brief libcache_get_stats  takes a snapshot of the counters of the cache.
  */
-static inline int libcache_get_unlock_node(node_t *node) {
-    return (((libcache_node_usr_data_t*)node->usr_data)->lock_counter) ? 1 : 0;
+libcache_ret_t libcache_get_stats(const void* libcache, libcache_stats_t* stats)
+{
+    const libcache_t* libcache_ptr = (const libcache_t*) libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == stats)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or stats");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (libcache_is_compact(libcache_ptr) || libcache_ptr->attr.stats == LIBCACHE_STATS_NONE) {
+        DEBUG_ERROR("the cache has no stats");
+        return LIBCACHE_FAILURE;
+    }
+
+    *stats = libcache_ptr->stats;
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_stats_merge(stats, &libcache_ptr->resize_from->stats);
+    }
+    stats->entry_number = libcache_get_entry_number(libcache_ptr);
+    return LIBCACHE_SUCCESS;
 }
 
 /*
- *  @brief libcache_add         attempts to add an entry with a given key.
+ *  @brief libcache_add_batch   attempts to add many entries, same as calling libcache_add for every key in order.
  *
  *  @param libcache             cache object, cannot be NULL.
- *  @param key                  key, cannot be NULL.
- *  @param src_entry            entry with an expected value to add.
- *  @return NULL                could not add the entry because an entry with the same key is existing.
- *          pointer             points to an entry with the key, so user can write value to it.
- *  NOTE:   The entry in cache will be locked if src_entry is NULL, one entry can be locked many times.
- *          libcache_unlock_entry should be called to unlock the e ntry when the entry is not being used this time.
+ *  @param keys                 keys, cannot be NULL.
+ *  @param count                number of keys.
+ *  @param src_entries          count * entry_size bytes, entries are added one by one. it could be NULL.
+ *  @param entries              result of every key, the same as libcache_add.
+ *  @return                     number of entries added.
  */
-void* libcache_add(void * libcache, const void* key, const void* src_entry)
+int libcache_add_batch(void* libcache, const void* const keys[], int count, const void* src_entries, void* entries[])
 {
-    libcache_t* libcache_ptr = (libcache_t*) libcache;
-    if (unlikely(NULL == libcache_ptr)) {
-        DEBUG_ERROR("input parameter %s is null", "libcache");
-        return NULL;
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == keys || NULL == entries || count < 0)) {
+        DEBUG_ERROR("input parameter %s is invalid", "libcache or keys or entries or count");
+        return 0;
     }
 
-    if (unlikely(NULL == key)) {
-        DEBUG_ERROR("input parameter %s is null", "key");
-        return NULL;
+    // Note: only warm up the index, an add may swap out an entry found in this batch,
+    //       or a key may appear twice in this batch, so every add still finds its key again
+    size_t entry_size = 0;
+    if (libcache_is_compact(libcache_ptr)) {
+        entry_size = libcache_compact_get_entry_size(libcache_ptr);
+    } else {
+        entry_size = libcache_ptr->entry_size;
+        hash_find_batch(libcache_ptr->hash_table, keys, count, entries);
     }
 
-    void* return_value = NULL;
-
-    // Note: find node, if node isn't existed and add it
-    do {
-        // Note: find node from hash by key, so not add the data
-        node_t* hash_node = (node_t*) hash_find(libcache_ptr->hash_table, key);
-        if (unlikely(NULL != hash_node)) {
-            DEBUG_INFO("the key is existed in cache");
-            break;
-        }
-
-        node_t* unlock_node = NULL;
-        libcache_node_usr_data_t* cache_data;
-
-        // Note: if cache pool is full, check unlocked node in libcache list back
-        if (unlikely(libcache_ptr->max_entry_number <= libcache_ptr->list->total_nodes)) {
-            // Note: if no unlocked node in libcache list, return directly
-            DEBUG_INFO("the cache is full, try to swap old data out");
-            unlock_node = list_reverse_foreach(libcache_ptr->list, libcache_get_unlock_node);
-            if (unlikely(NULL == unlock_node)) {
-                DEBUG_INFO("all data are in use, swap failed!");
-                break;
-            } else { // Note: if have unlocked node in libcache list
-                DEBUG_INFO("swap data successfully!");
-                list_swap_to_head(libcache_ptr->list, unlock_node);
-                cache_data = (libcache_node_usr_data_t*) unlock_node->usr_data;
-
-                hash_node = hash_del(libcache_ptr->hash_table, cache_data->key, cache_data->hash_node_ptr, libcache_ptr->pool);
-                memset(cache_data->key, 0, libcache_ptr->key_size);
-            }
-        } else { // Note: if cache pool is not full, create new node
-            unlock_node = (node_t*) pool_get_element(libcache_ptr->pool, POOL_TYPE_NODE_T);
-            unlock_node->usr_data = pool_get_element(libcache_ptr->pool, POOL_TYPE_LIBCACHE_NODE_USR_DATA_T);
-            cache_data = (libcache_node_usr_data_t*) unlock_node->usr_data;
-            cache_data->key = pool_get_element(libcache_ptr->pool, POOL_TYPE_KEY_SIZE);
-            cache_data->pool_element_ptr = pool_get_element(libcache_ptr->pool, POOL_TYPE_DATA);
-            cache_data->lock_counter = 0;
-
-            list_push_front(libcache_ptr->list, unlock_node);
-            pool_set_reserved_pointer(cache_data->pool_element_ptr, (void*) unlock_node);
-        }
-
-        if (NULL != src_entry) {
-            memcpy(cache_data->pool_element_ptr, src_entry, libcache_ptr->entry_size);
-        } else {
-            cache_data->lock_counter++;
+    int added = 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        const void* src_entry = (NULL == src_entries) ? NULL : (const char*) src_entries + i * entry_size;
+        entries[i] = libcache_add(libcache_ptr, keys[i], src_entry);
+        if (entries[i] != NULL) {
+            added++;
         }
-        memcpy(cache_data->key, key, libcache_ptr->key_size);
-        // Note: add node into hash
-        cache_data->hash_node_ptr = hash_add(libcache_ptr->hash_table, key, hash_node, unlock_node, libcache_ptr->pool);
-        return_value = cache_data->pool_element_ptr;
-    } while (0);
-
-return return_value;
+    }
+    return added;
 }
 
 /*
@@ -268,40 +3009,61 @@ libcache_ret_t  libcache_delete_by_key(void * libcache, const void* key)
         return LIBCACHE_FAILURE;
     }
 
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_delete_by_key(libcache_ptr, key);
+    }
+
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: a key demoted into cold_tier isn't in the cache, it's deleted from the tier only
+    int demoted = libcache_tier_forget(libcache_ptr, key);
     libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    libcache_shm_write_begin(libcache_ptr);
     do {
         node_t* hash_node = (node_t*)hash_find(libcache_ptr->hash_table, key);
         if (NULL == hash_node) {
-            return_value = LIBCACHE_NOT_FOUND;
+            return_value = (NULL == libcache_ptr->resize_from) ? LIBCACHE_NOT_FOUND
+                    : libcache_delete_by_key(libcache_ptr->resize_from, key);
+            if (demoted && LIBCACHE_NOT_FOUND == return_value) {
+                return_value = LIBCACHE_SUCCESS;
+            }
             break;
         }
 
         // Note: if the entry is locked, just return
-        node_t* libcache_node = (node_t*)((hash_data_t*)hash_node->usr_data)->cache_node_ptr;
-        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
-         if (libcache_node_usr_data->lock_counter > 0) {
+        libcache_record_t* record = LIBCACHE_HASH_NODE_RECORD(hash_node);
+        node_t* libcache_node = &record->cache_node;
+         if (LOCK_COUNTER_LOAD(record->cache_data.lock_counter) > 0) {
+             LIBCACHE_STATS_INC(libcache_ptr, delete_locked);
              return_value = LIBCACHE_LOCKED;
              break;
          }
 
-        // Note: delete node from hash
-        hash_del(libcache_ptr->hash_table, key, libcache_node_usr_data->hash_node_ptr, libcache_ptr->pool);
-        hash_free_node(hash_node, libcache_ptr->pool);
+        // Note: key may be the key in the record, it's used by hash_del after the entry is released
+        libcache_evict_record(libcache_ptr, record, LIBCACHE_EVICT_DELETED);
+        libcache_release_record(libcache_ptr, record);
 
-        // Note: delete node from pool
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_DATA, libcache_node_usr_data->pool_element_ptr);
+        // Note: delete node from hash, hash node is freed with the record
+        hash_del(libcache_ptr->hash_table, key, hash_node, libcache_ptr->pool);
 
-        // Note: delete node from list
-        list_remove(libcache_ptr->list, libcache_node);
+        // Note: delete node from policy
+        libcache_ptr->policy_ops->on_remove(libcache_ptr->policy_data, libcache_node);
 
         // Note: free node resource
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_LIBCACHE_NODE_USR_DATA_T, libcache_node_usr_data);
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_KEY_SIZE, ((libcache_node_usr_data_t*)libcache_node->usr_data)->key);
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_NODE_T, libcache_node);
+        libcache_free_node(libcache_ptr, libcache_node);
+        LIBCACHE_STATS_INC(libcache_ptr, deletes);
 
         return_value = LIBCACHE_SUCCESS;
     } while(0);
+    libcache_shm_write_end(libcache_ptr);
 
+    // Note: key may be in an entry, a step could swap it out, so it's done after the key is used
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+    }
     return return_value;
 }
 
@@ -323,73 +3085,351 @@ libcache_ret_t  libcache_delete_entry(void * libcache, void* entry)
         return LIBCACHE_FAILURE;
     }
 
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_delete_entry(libcache_ptr, entry);
+    }
+
     libcache_ret_t return_value = LIBCACHE_FAILURE;
 
     do {
         // Note: judge whether entry is existed in cache
-        node_t* libcache_node = pool_get_reserved_pointer(entry);
+        node_t* libcache_node = libcache_entry_to_node(entry);
         if (libcache_node == NULL) {
             return_value = LIBCACHE_NOT_FOUND;
             break;
         }
 
         // Note: judge whether entry is locked
-        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
-        if (libcache_node_usr_data->lock_counter > 0) {
+        libcache_record_t* record = LIBCACHE_NODE_RECORD(libcache_node);
+        if (LOCK_COUNTER_LOAD(record->cache_data.lock_counter) > 0) {
             return_value = LIBCACHE_LOCKED;
             break;
         }
 
-        hash_data_t* hash_data = (hash_data_t*) (libcache_node_usr_data->hash_node_ptr->usr_data);
-        return_value = libcache_delete_by_key(libcache_ptr, hash_data->key);
-    } while(0);
+        libcache_t* owner = libcache_resize_owns(libcache_ptr, entry) ? libcache_ptr->resize_from : libcache_ptr;
+        return_value = libcache_delete_by_key(owner, record->hash_data.key);
+    } while(0);
+
+    return return_value;
+}
+
+/*
+ *  @brief libcache_unlock_entry    attempts to unlock an entry.
+ *
+ *  @param libcache                 cache object, cannot be NULL.
+ *  @param entry                    entry (returned by libcache_lookup/libcache_add) in the cache.
+ *  @return
+ *          LIBCACHE_UNLOCKED       the entry is already unlocked,
+ *                                  this indicates unpaired locking & unlocking issue happened.
+ *          LIBCACHE_SUCCESS        the entry was unlocked successfully once.
+ */
+libcache_ret_t libcache_unlock_entry(void * libcache, void* entry)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(entry == NULL)) {
+        DEBUG_ERROR("input parameter %s is null", "entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_unlock_entry(libcache_ptr, entry);
+    }
+
+    // Note: entries locked in the cache being resized are unlocked there, then moved by later steps
+    if (unlikely(libcache_resize_owns(libcache_ptr, entry))) {
+        return libcache_unlock_entry(libcache_ptr->resize_from, entry);
+    }
+
+    libcache_ret_t return_value = LIBCACHE_FAILURE;
+
+    node_t* libcache_node = libcache_entry_to_node(entry);
+
+    if (NULL == libcache_node) {
+        return_value = LIBCACHE_NOT_FOUND;
+    } else {
+        // Note: unlock entry
+        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
+        if (LOCK_COUNTER_LOAD(libcache_node_usr_data->lock_counter) == 0) {
+            return_value = LIBCACHE_UNLOCKED;
+        } else {
+            libcache_unlock_node(libcache_ptr, libcache_node);
+            return_value = LIBCACHE_SUCCESS;
+        }
+    }
+
+    return return_value;
+}
+
+/*
+ *  @brief libcache_try_unlock_entry    attempts to unlock an entry which is locked more than once.
+ *
+ *  @param entry                        entry (returned by libcache_lookup/libcache_add) in a cache.
+ *  @return
+ *          LIBCACHE_SUCCESS            the entry was unlocked once, it's still locked by others.
+ *          LIBCACHE_FAILURE            it's the last lock or entry isn't locked, libcache_unlock_entry should be called.
+ *  NOTE:  It doesn't change the cache, so in LIBCACHE_CONCURRENT build it can be called by any thread
+ *         without locking the cache, this is what libcache_sharded_unlock_entry does.
+ */
+libcache_ret_t libcache_try_unlock_entry(void* entry)
+{
+    if (unlikely(entry == NULL)) {
+        DEBUG_ERROR("input parameter %s is null", "entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: the entry may be in a compact cache, it has no cache node
+    node_t* libcache_node = libcache_entry_to_node(entry);
+    if (NULL == libcache_node) {
+        return libcache_compact_try_unlock_entry(entry);
+    }
+
+    libcache_node_usr_data_t* cache_data = (libcache_node_usr_data_t*) libcache_node->usr_data;
+    uint32_t counter = LOCK_COUNTER_LOAD(cache_data->lock_counter);
+    while (counter > 1) {
+#ifdef LIBCACHE_CONCURRENT
+        if (__atomic_compare_exchange_n(&cache_data->lock_counter, &counter, counter - 1,
+                TRUE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return LIBCACHE_SUCCESS;
+        }
+#else
+        cache_data->lock_counter = counter - 1;
+        return LIBCACHE_SUCCESS;
+#endif
+    }
+    return LIBCACHE_FAILURE;
+}
+
+/*
+ *  @brief libcache_handle_owner   gets the cache the record of a handle is in, if the handle isn't stale.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param handle           handle filled by libcache_pin.
+ *  @return NULL            the entry of the handle left the cache, or moved by libcache_resize.
+ *          pointer         the cache object or the cache being resized.
+ *  NOTE:  The record is read only if it's in memory of either cache, so a handle of freed memory is safe.
+ */
+static inline libcache_t* libcache_handle_owner(libcache_t* libcache_ptr, const libcache_handle_t* handle)
+{
+    libcache_t* owner = libcache_ptr;
+    if (unlikely(libcache_resize_owns(libcache_ptr, handle->node))) {
+        owner = libcache_ptr->resize_from;
+    } else if (unlikely((const char*) handle->node < (const char*) libcache_ptr->pool
+            || (const char*) handle->node >= (const char*) libcache_ptr->pool + libcache_ptr->memory_length)) {
+        return NULL;
+    }
+    const libcache_record_t* record = (const libcache_record_t*) handle->node;
+    if (unlikely(record->generation != handle->generation || handle->generation <= owner->generation_floor)) {
+        return NULL;
+    }
+    return owner;
+}
+
+/*
+ *  @brief libcache_handle_check   checks the parameters of the handle functions.
+ */
+static inline int libcache_handle_check(const libcache_t* libcache_ptr, const void* handle)
+{
+    if (unlikely(NULL == libcache_ptr || NULL == handle)) {
+        DEBUG_ERROR("input parameter %s is null", (NULL == handle) ? "handle" : "libcache");
+        return FALSE;
+    }
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("handles are supported by the pool engine, and not by an attached cache");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_handle_set  fills a handle of a locked record.
+ */
+static inline void libcache_handle_set(libcache_handle_t* handle, libcache_record_t* record)
+{
+    handle->entry = record->entry;
+    handle->entry_length = record->cache_data.entry_length;
+    handle->node = record;
+    handle->generation = record->generation;
+}
+
+libcache_ret_t libcache_pin(void* libcache, const void* key, libcache_handle_t* handle)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(!libcache_handle_check(libcache_ptr, handle))) {
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "key");
+        return LIBCACHE_FAILURE;
+    }
+
+    uint64_t start = libcache_stats_begin(libcache_ptr);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_resize_step(libcache_ptr);
+    }
+
+    libcache_t* owner = NULL;
+    node_t* hash_node = libcache_find(libcache_ptr, key, &owner);
+    void* entry = libcache_lookup_node(owner, hash_node, NULL);
+    libcache_stats_lookup(libcache_ptr, entry, start);
+    if (NULL == entry) {
+        memset(handle, 0, sizeof(libcache_handle_t));
+        return LIBCACHE_NOT_FOUND;
+    }
+
+    libcache_handle_set(handle, LIBCACHE_HASH_NODE_RECORD(hash_node));
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_repin(void* libcache, libcache_handle_t* handle)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(!libcache_handle_check(libcache_ptr, handle))) {
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_t* owner = libcache_handle_owner(libcache_ptr, handle);
+    if (NULL == owner) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    libcache_record_t* record = (libcache_record_t*) handle->node;
+    libcache_lock_node(owner, &record->cache_node);
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_unpin(void* libcache, libcache_handle_t* handle)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(!libcache_handle_check(libcache_ptr, handle))) {
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: the record is the handle's, pool_get_reserved_pointer isn't needed to find it out
+    libcache_t* owner = libcache_handle_owner(libcache_ptr, handle);
+    if (unlikely(NULL == owner)) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    libcache_record_t* record = (libcache_record_t*) handle->node;
+    if (unlikely(LOCK_COUNTER_LOAD(record->cache_data.lock_counter) == 0)) {
+        return LIBCACHE_UNLOCKED;
+    }
+    libcache_unlock_node(owner, &record->cache_node);
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_lookup_async(void* libcache, const void* key, libcache_load_waiter_t* waiter)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr || NULL == waiter)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or waiter");
+        return LIBCACHE_FAILURE;
+    }
 
+    void* entry = NULL;
+    libcache_tier_location_t location = { -1, 0 };
+    libcache_ret_t return_value = libcache_load_begin_ex(libcache_ptr, key, &entry, &location);
+    memset(&waiter->handle, 0, sizeof(libcache_handle_t));
+    waiter->tier_offset = location.offset;
+    waiter->tier_length = location.entry_length;
+    waiter->result = return_value;
+    waiter->entry = NULL;
+    waiter->next = NULL;
+    if (LIBCACHE_LOCKED == return_value) {
+        // Note: the placeholder is locked for the waiter, it's handed over once the load ends
+        waiter->entry = entry;
+        waiter->next = libcache_ptr->load_waiters;
+        libcache_ptr->load_waiters = waiter;
+    } else if (LIBCACHE_FAILURE != return_value) {
+        libcache_handle_set(&waiter->handle, LIBCACHE_NODE_RECORD(libcache_entry_to_node(entry)));
+    }
     return return_value;
 }
 
-/*
- *  @brief libcache_unlock_entry    attempts to unlock an entry.
- *
- *  @param libcache                 cache object, cannot be NULL.
- *  @param entry                    entry (returned by libcache_lookup/libcache_add) in the cache.
- *  @return
- *          LIBCACHE_UNLOCKED       the entry is already unlocked,
- *                                  this indicates unpaired locking & unlocking issue happened.
- *          LIBCACHE_SUCCESS        the entry was unlocked successfully once.
- */
-libcache_ret_t libcache_unlock_entry(void * libcache, void* entry)
+libcache_ret_t libcache_load_complete(void* libcache, libcache_load_waiter_t* loader, size_t entry_length,
+        int loaded, libcache_load_waiter_t** waiters)
 {
     libcache_t* libcache_ptr = (libcache_t*)libcache;
-    if (unlikely(NULL == libcache_ptr)) {
-        DEBUG_ERROR("input parameter %s is null", "libcache");
+    if (unlikely(NULL == libcache_ptr || NULL == loader || NULL == loader->handle.entry)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or loader");
         return LIBCACHE_FAILURE;
     }
 
-    if (unlikely(entry == NULL)) {
-        DEBUG_ERROR("input parameter %s is null", "entry");
+    if (unlikely(libcache_is_compact(libcache_ptr))) {
+        return LIBCACHE_FAILURE;
+    }
+    void* entry = loader->handle.entry;
+    libcache_record_t* record = LIBCACHE_NODE_RECORD(libcache_entry_to_node(entry));
+    if (unlikely(LIBCACHE_ENTRY_LOADING != record->cache_data.entry_length)) {
+        DEBUG_ERROR("the entry isn't being loaded");
         return LIBCACHE_FAILURE;
     }
 
-    libcache_ret_t return_value = LIBCACHE_FAILURE;
-
-    node_t* libcache_node = pool_get_reserved_pointer(entry);
+    // Note: waiters of the entry leave the queue in the order they came, others stay
+    libcache_load_waiter_t* done = NULL;
+    libcache_load_waiter_t** link = &libcache_ptr->load_waiters;
+    while (NULL != *link) {
+        libcache_load_waiter_t* waiter = *link;
+        if (waiter->entry == entry) {
+            *link = waiter->next;
+            waiter->next = done;
+            done = waiter;
+        } else {
+            link = &waiter->next;
+        }
+    }
 
-    if (NULL == libcache_node) {
-        return_value = LIBCACHE_NOT_FOUND;
-    } else {
-        // Note: unlock entry
-        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
-        if (libcache_node_usr_data->lock_counter == 0) {
-            return_value = LIBCACHE_UNLOCKED;
+    // Note: waiters keep the lock of a failed placeholder until it's handed back, the last one frees it
+    libcache_ret_t return_value = libcache_load_end(libcache_ptr, entry, entry_length, loaded);
+    libcache_load_waiter_t* waiter = NULL;
+    for (waiter = done; NULL != waiter; waiter = waiter->next) {
+        waiter->entry = NULL;
+        waiter->result = return_value;
+        if (LIBCACHE_SUCCESS == return_value) {
+            libcache_handle_set(&waiter->handle, record);
         } else {
-            libcache_node_usr_data->lock_counter--;
-            return_value = LIBCACHE_SUCCESS;
+            libcache_unlock_entry(libcache_ptr, entry);
         }
     }
+    loader->result = return_value;
+    if (LIBCACHE_SUCCESS == return_value) {
+        libcache_handle_set(&loader->handle, record);
+    } else {
+        memset(&loader->handle, 0, sizeof(libcache_handle_t));
+    }
 
+    if (NULL != waiters) {
+        *waiters = done;
+    } else {
+        libcache_load_notify(done);
+    }
     return return_value;
 }
 
+void libcache_load_notify(libcache_load_waiter_t* waiters)
+{
+    while (NULL != waiters) {
+        // Note: done may reuse or free its waiter, nothing of it is read afterwards
+        libcache_load_waiter_t* next = waiters->next;
+        int eventfd = waiters->eventfd;
+        waiters->next = NULL;
+        if (NULL != waiters->done) {
+            waiters->done(waiters);
+        }
+        if (eventfd > 0) {
+            uint64_t one = 1;
+            if (unlikely(write(eventfd, &one, sizeof(one)) != (ssize_t) sizeof(one))) {
+                DEBUG_ERROR("failed to write eventfd %d", eventfd);
+            }
+        }
+        waiters = next;
+    }
+}
+
 /*
  *  @brief libcache_get_max_entry_number    gets a capacity of the maximum number of entries this cache can store.
  *
@@ -404,6 +3444,9 @@ libcache_scale_t libcache_get_max_entry_number(const void * libcache)
         DEBUG_ERROR("input parameter %s is null", "libcache");
         return LIBCACHE_FAILURE;
     }
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_get_max_entry_number(libcache_ptr);
+    }
     return libcache_ptr->max_entry_number -1;
 }
 
@@ -422,7 +3465,154 @@ libcache_scale_t libcache_get_entry_number(const void * libcache)
         return LIBCACHE_FAILURE;
     }
 
-    return hash_get_count(libcache_ptr->hash_table);
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_get_entry_number(libcache_ptr);
+    }
+
+    // Note: the copy of hash_t an attached cache has isn't updated by the creator
+    const void* hash_table = unlikely(libcache_is_attached(libcache_ptr)) ? libcache_ptr->shm->cache.hash_table
+            : libcache_ptr->hash_table;
+    libcache_scale_t count = hash_get_count(hash_table);
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        count += hash_get_count(libcache_ptr->resize_from->hash_table);
+    }
+    return count;
+}
+
+/*
+ *  @brief libcache_get_page_type            gets the page type cache memory is really on.
+ *
+ *  @param libcache                          cache object, cannot be NULL.
+ *  @return
+ *         LIBCACHE_PAGE_USER                memory is got from allocate_memory.
+ *         others                            memory is mapped with the page type.
+ */
+libcache_page_e libcache_get_page_type(const void * libcache)
+{
+    const libcache_t* libcache_ptr = (const libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return LIBCACHE_PAGE_USER;
+    }
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_get_page_type(libcache_ptr);
+    }
+    return libcache_ptr->page_type;
+}
+
+/*
+ *  @brief libcache_get_entry_key            gets the key of a locked entry.
+ *
+ *  @param entry                             entry returned by libcache_lookup/libcache_add, cannot be NULL.
+ *  @return NULL                             the entry isn't in any cache.
+ *          pointer                          points to the key, it's valid while the entry is locked.
+ */
+const void* libcache_get_entry_key(void* entry)
+{
+    if (unlikely(NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "entry");
+        return NULL;
+    }
+
+    node_t* libcache_node = libcache_entry_to_node(entry);
+    if (NULL == libcache_node) {
+        return libcache_compact_get_entry_key(entry);
+    }
+    return LIBCACHE_NODE_RECORD(libcache_node)->hash_data.key;
+}
+
+/*
+ *  @brief libcache_resize        changes the maximum entry number, entries are moved into new memory step by step.
+ */
+libcache_ret_t libcache_resize(void * libcache, libcache_scale_t max_entry_number)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == libcache_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(libcache_is_compact(libcache_ptr))) {
+        DEBUG_ERROR("a compact cache can't be resized");
+        return LIBCACHE_FAILURE;
+    }
+
+    if (unlikely(NULL != libcache_ptr->shm)) {
+        DEBUG_ERROR("a cache in shared memory can't be resized");
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: one resize at a time, the previous one is finished first
+    while (NULL != libcache_ptr->resize_from) {
+        libcache_scale_t count = hash_get_count(libcache_ptr->resize_from->hash_table);
+        libcache_resize_step(libcache_ptr);
+        if (NULL != libcache_ptr->resize_from && hash_get_count(libcache_ptr->resize_from->hash_table) == count) {
+            DEBUG_INFO("entries of the previous resize are locked");
+            return LIBCACHE_LOCKED;
+        }
+    }
+    if (max_entry_number == libcache_ptr->attr.max_entry_number) {
+        return LIBCACHE_SUCCESS;
+    }
+
+    libcache_attr_t attr = libcache_ptr->attr;
+    attr.max_entry_number = max_entry_number;
+    // Note: memory of variable size entries scales with the maximum entry number
+    if (libcache_ptr->attr.max_entry_number > 0) {
+        attr.entry_memory_size = (size_t) ((unsigned long long) attr.entry_memory_size * max_entry_number
+                / libcache_ptr->attr.max_entry_number);
+    }
+    libcache_t* new_cache = (libcache_t*) libcache_create_ex(&attr);
+    if (unlikely(NULL == new_cache)) {
+        DEBUG_ERROR("failed to create cache of %u entries", (unsigned) max_entry_number);
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: user keeps the handle, so the handle takes the new cache, and the old one moves to the new handle
+    libcache_t old_cache = *libcache_ptr;
+    *libcache_ptr = *new_cache;
+    *new_cache = old_cache;
+    libcache_ptr->resize_from = new_cache;
+    // Note: counters stay with the handle, the old cache counts only its own evictions from now on
+    libcache_ptr->stats = new_cache->stats;
+    memset(&new_cache->stats, 0, sizeof(libcache_stats_t));
+    // Note: generations go on in new memory, it may hold stale records of a cache freed at the same address
+    libcache_ptr->generation = new_cache->generation;
+    libcache_ptr->generation_floor = new_cache->generation;
+    libcache_ptr->memory_epoch = new_cache->memory_epoch + 1;
+    // Note: waiters are queued by the handle, their placeholders may be in either cache
+    libcache_ptr->load_waiters = new_cache->load_waiters;
+    new_cache->load_waiters = NULL;
+    // Note: both caches go on with the same clock, entries moved keep their expiry
+    if (NULL != libcache_ptr->ttl_wheel) {
+        libcache_ttl_init(libcache_ptr->ttl_wheel, new_cache->ttl_wheel->clock);
+    }
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ *  @brief libcache_release_all  walks all entries to call release_entry and free_entry, it empties the policy
+ *                               and lock_list, so the cache must be cleared or destroyed after it.
+ *
+ *  @param libcache_ptr     cache object.
+ *  @param free_entry       also called for every entry if it isn't NULL.
+ */
+static void libcache_release_all(libcache_t* libcache_ptr, LIBCACHE_FREE_ENTRY* free_entry)
+{
+    node_t* libcache_node = NULL;
+    while (1) {
+        libcache_node = libcache_ptr->policy_ops->select_victim(libcache_ptr->policy_data);
+        if (libcache_node != NULL) {
+            libcache_ptr->policy_ops->on_evict(libcache_ptr->policy_data, libcache_node);
+        } else if (NULL == (libcache_node = list_pop_front(libcache_ptr->lock_list))) {
+            break;
+        }
+        libcache_record_t* record = LIBCACHE_NODE_RECORD(libcache_node);
+        libcache_release_record(libcache_ptr, record);
+        if (NULL != free_entry && likely(!LIBCACHE_RECORD_ABSENT(record))) {
+            free_entry(record->hash_data.key, record->entry);
+        }
+    }
 }
 
 /*
@@ -442,15 +3632,55 @@ libcache_ret_t libcache_clean(void * libcache)
         return LIBCACHE_FAILURE;
     }
 
-    node_t* libcache_node = NULL;
-    while (NULL != (libcache_node = list_pop_front(libcache_ptr->list))) {
-        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_DATA, libcache_node_usr_data->pool_element_ptr);
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_LIBCACHE_NODE_USR_DATA_T, libcache_node_usr_data);
-        pool_free_element(libcache_ptr->pool, POOL_TYPE_NODE_T, libcache_node);
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_clean(libcache_ptr);
+    }
+
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("an attached cache is read only");
+        return LIBCACHE_FAILURE;
     }
 
-    hash_free(libcache_ptr->hash_table, libcache_ptr->pool);
+    // Note: the cache being resized is cleaned as well, there is nothing left to move
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_clean(libcache_ptr->resize_from);
+        libcache_destroy(libcache_ptr->resize_from);
+        libcache_ptr->resize_from = NULL;
+    }
+
+    // Note: records, entries and bucket lists are freed by rewinding their pools, no entry is walked
+    //       unless release_entry is set, lock_list is the first list got from its pool, so it's got again
+    //       at the same address
+    libcache_shm_write_begin(libcache_ptr);
+    if (unlikely(NULL != libcache_ptr->release_entry)) {
+        libcache_release_all(libcache_ptr, NULL);
+    }
+    hash_clear(libcache_ptr->hash_table);
+    int i;
+    for (i = 0; i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (NULL != libcache_ptr->secondary_tables[i]) {
+            hash_clear(libcache_ptr->secondary_tables[i]);
+        }
+    }
+    if (NULL != libcache_ptr->ordered_index) {
+        pool_reset(libcache_ptr->pool, POOL_TYPE_BTREE_NODE);
+        libcache_btree_clear(libcache_ptr->ordered_index);
+    }
+    libcache_ptr->generation_floor = libcache_ptr->generation;
+    pool_reset(libcache_ptr->pool, POOL_TYPE_DATA);
+    if (NULL != libcache_ptr->entry_slab) {
+        pool_slab_reset(libcache_ptr->entry_slab);
+    }
+    pool_reset(libcache_ptr->pool, POOL_TYPE_LIST_T);
+    libcache_ptr->lock_list = (list_t*) pool_get_element(libcache_ptr->pool, POOL_TYPE_LIST_T);
+    list_init(libcache_ptr->lock_list);
+    list_init(&libcache_ptr->dirty_list);
+    libcache_ptr->policy_ops->init(libcache_ptr->policy_data, libcache_ptr->max_entry_number);
+    if (NULL != libcache_ptr->ttl_wheel) {
+        libcache_ttl_init(libcache_ptr->ttl_wheel, libcache_ptr->ttl_wheel->clock);
+    }
+    libcache_shm_write_end(libcache_ptr);
+    libcache_replicate(libcache_ptr, LIBCACHE_REPLICATION_CLEAN, LIBCACHE_EVICT_DELETED, NULL, 0);
     return LIBCACHE_SUCCESS;
 }
 
@@ -470,17 +3700,382 @@ libcache_ret_t libcache_destroy(void * libcache)
         return LIBCACHE_FAILURE;
     }
 
-    node_t* libcache_node = NULL;
-    while (NULL != (libcache_node = list_pop_front(libcache_ptr->list))) {
-        libcache_node_usr_data_t* libcache_node_usr_data = (libcache_node_usr_data_t*)libcache_node->usr_data;
-        if (libcache_ptr->free_entry != NULL) {
-            hash_data_t* hash_data = (hash_data_t*) (libcache_node_usr_data->hash_node_ptr->usr_data);
-            libcache_ptr->free_entry(hash_data->key, libcache_node_usr_data->pool_element_ptr);
+    if (libcache_is_compact(libcache_ptr)) {
+        return libcache_compact_destroy(libcache_ptr);
+    }
+
+    // Note: an attached process only unmaps the segment, the creator owns the entries
+    if (unlikely(libcache_is_attached(libcache_ptr))) {
+        libcache_shm_t* shm = libcache_ptr->shm;
+        libcache_memory_unmap(libcache_ptr, sizeof(libcache_attached_t), LIBCACHE_PAGE_NORMAL);
+        libcache_memory_unmap_shared(shm, shm->length, NULL);
+        return LIBCACHE_SUCCESS;
+    }
+
+    if (unlikely(NULL != libcache_ptr->resize_from)) {
+        libcache_destroy(libcache_ptr->resize_from);
+        libcache_ptr->resize_from = NULL;
+    }
+
+    // Note: copies of entries evicted before are delivered, entries destroyed now aren't evicted
+    if (unlikely(NULL != libcache_ptr->evicted_batch)) {
+        libcache_deliver_evictions(libcache_ptr);
+    }
+
+    // Note: entries are walked only for free_entry and release_entry, all pools are released with the memory at once
+    if (libcache_ptr->free_entry != NULL || libcache_ptr->release_entry != NULL) {
+        libcache_release_all(libcache_ptr, libcache_ptr->free_entry);
+    }
+
+    if (libcache_ptr->page_type == LIBCACHE_PAGE_SHARED) {
+        // Note: the handle is in the segment, it's gone with the segment
+        libcache_shm_t* shm = libcache_ptr->shm;
+        __atomic_store_n(&shm->magic, 0, __ATOMIC_RELEASE);
+        libcache_memory_unmap_shared(shm, shm->length, shm->name);
+        return LIBCACHE_SUCCESS;
+    } else if (libcache_ptr->page_type == LIBCACHE_PAGE_USER) {
+        libcache_ptr->free_memory(libcache_ptr->pool);
+    } else {
+        libcache_memory_unmap(libcache_ptr->pool, libcache_ptr->memory_length, libcache_ptr->page_type);
+    }
+    libcache_free_handle(libcache_ptr);
+
+    return LIBCACHE_SUCCESS;
+}
+
+/*
+ * Image writer over a file descriptor, with a buffer allocated up front, so it neither allocates nor uses stdio
+ * while it writes, which a forked child of libcache_save_start must not do.
+ */
+#define LIBCACHE_IMAGE_BUFFER (1 << 20)
+
+typedef struct libcache_image_writer_t
+{
+    int fd;
+    int failed;
+    size_t used;
+    uint64_t written;   /* bytes given to the writer */
+    char buffer[LIBCACHE_IMAGE_BUFFER];
+} libcache_image_writer_t;
+
+/*
+ *  @brief libcache_image_flush  writes out the buffer, the writer fails for good once a write fails.
+ */
+static int libcache_image_flush(libcache_image_writer_t* writer)
+{
+    size_t done = 0;
+    while (!writer->failed && done < writer->used) {
+        ssize_t ret = write(writer->fd, writer->buffer + done, writer->used - done);
+        if (ret > 0) {
+            done += (size_t) ret;
+        } else if (ret < 0 && EINTR != errno) {
+            writer->failed = TRUE;
+        }
+    }
+    writer->used = 0;
+    return !writer->failed;
+}
+
+/*
+ *  @brief libcache_image_write  writes length bytes to the image, nothing if length is 0.
+ */
+static int libcache_image_write(libcache_image_writer_t* writer, const void* data, size_t length)
+{
+    const char* bytes = (const char*) data;
+    writer->written += length;
+    while (!writer->failed && length > 0) {
+        if (writer->used == LIBCACHE_IMAGE_BUFFER) {
+            libcache_image_flush(writer);
+            continue;
+        }
+        size_t part = LIBCACHE_IMAGE_BUFFER - writer->used;
+        part = (part < length) ? part : length;
+        memcpy(writer->buffer + writer->used, bytes, part);
+        writer->used += part;
+        bytes += part;
+        length -= part;
+    }
+    return !writer->failed;
+}
+
+/*
+ *  @brief libcache_save_record  writes the image entry of a record.
+ */
+static int libcache_save_record(const libcache_t* libcache_ptr, libcache_image_writer_t* writer,
+        libcache_record_t* record)
+{
+    static const char padding[8];
+    libcache_image_entry_t image_entry;
+    image_entry.entry_length = record->cache_data.entry_length;
+    image_entry.expire_at = (NULL != libcache_ptr->ttl_wheel) ? LIBCACHE_RECORD_TTL(record)->expire_at : 0;
+    size_t length = sizeof(image_entry) + libcache_ptr->key_size + image_entry.entry_length;
+    // Note: images are uncompressed, a cache loading one compresses its entries by its own attr
+    const void* entry = record->entry;
+    if (unlikely(libcache_entry_compressed(libcache_ptr, entry, image_entry.entry_length))) {
+        libcache_copy_entry(libcache_ptr, entry, image_entry.entry_length, libcache_ptr->compress_buffer);
+        entry = libcache_ptr->compress_buffer;
+    }
+    return libcache_image_write(writer, &image_entry, sizeof(image_entry))
+            && libcache_image_write(writer, record->hash_data.key, libcache_ptr->key_size)
+            && libcache_image_write(writer, entry, image_entry.entry_length)
+            && libcache_image_write(writer, padding,
+                    LIBCACHE_IMAGE_ENTRY_LENGTH(libcache_ptr->key_size, image_entry.entry_length) - length);
+}
+
+/*
+ *  @brief libcache_save_entries  writes every entry of one cache, coldest first.
+ *
+ *  @param count            output, entries written are counted.
+ *  @return                 FALSE if it failed to write.
+ *  NOTE:  Policy can't be walked, unlocked entries are taken out in the order it swaps them out, then given back
+ *         in the same order, so LRU and FIFO order are kept, other policies keep their entries but not their history.
+ */
+static int libcache_save_entries(libcache_t* libcache_ptr, libcache_image_writer_t* writer, uint64_t* count)
+{
+    list_t drained;
+    list_init(&drained);
+    node_t* node = NULL;
+    while (NULL != (node = libcache_ptr->policy_ops->select_victim(libcache_ptr->policy_data))) {
+        libcache_ptr->policy_ops->on_evict(libcache_ptr->policy_data, node);
+        list_push_back(&drained, node);
+    }
+
+    int result = TRUE;
+    for (node = drained.head_node; result && NULL != node; node = node->next_node) {
+        // Note: a negative entry has nothing to save, the key is loaded again after restore, a stale one is gone
+        if (likely(!LIBCACHE_RECORD_ABSENT(LIBCACHE_NODE_RECORD(node)))
+                && likely(!libcache_record_stale(libcache_ptr, LIBCACHE_NODE_RECORD(node)))) {
+            result = libcache_save_record(libcache_ptr, writer, LIBCACHE_NODE_RECORD(node));
+            (*count)++;
+        }
+    }
+    // Note: an entry is pushed to the front of lock_list when it's locked, the back is locked first
+    for (node = libcache_ptr->lock_list->tail_node; result && NULL != node; node = node->previous_node) {
+        // Note: an entry being loaded has nothing to save yet
+        if (likely(!LIBCACHE_RECORD_ABSENT(LIBCACHE_NODE_RECORD(node)))
+                && likely(!libcache_record_stale(libcache_ptr, LIBCACHE_NODE_RECORD(node)))) {
+            result = libcache_save_record(libcache_ptr, writer, LIBCACHE_NODE_RECORD(node));
+            (*count)++;
         }
     }
 
-    hash_destroy(libcache_ptr->hash_table, libcache_ptr->pool);
-    libcache_ptr->free_memory(libcache_ptr->pool);
+    while (!list_empty(&drained)) {
+        libcache_ptr->policy_ops->on_insert(libcache_ptr->policy_data, list_pop_front(&drained));
+    }
+    return result;
+}
+
+/*
+ *  @brief libcache_save_open    checks the cache, then creates the writer of path.tmp.
+ *
+ *  @param temp_path        output, path.tmp, freed by the caller.
+ *  @return NULL            invalid cache or failed to create the file.
+ *          pointer         the writer, freed by the caller.
+ */
+static libcache_image_writer_t* libcache_save_open(const libcache_t* libcache_ptr, const char* path,
+        char** temp_path)
+{
+    if (unlikely(NULL == libcache_ptr || NULL == path)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or path");
+        return NULL;
+    }
+
+    if (unlikely(libcache_is_compact(libcache_ptr) || libcache_is_attached(libcache_ptr))) {
+        DEBUG_ERROR("images are saved by the pool engine, and not by an attached cache");
+        return NULL;
+    }
+
+    // Note: the image is written aside, then renamed, so path never holds a partial image
+    *temp_path = (char*) malloc(strlen(path) + sizeof(".tmp"));
+    libcache_image_writer_t* writer = (libcache_image_writer_t*) malloc(sizeof(libcache_image_writer_t));
+    if (unlikely(NULL == *temp_path || NULL == writer)) {
+        DEBUG_ERROR("Memory malloc failed!")
+        free(*temp_path);
+        free(writer);
+        return NULL;
+    }
+    sprintf(*temp_path, "%s.tmp", path);
+    writer->fd = open(*temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        DEBUG_ERROR("failed to create %s", *temp_path);
+        free(*temp_path);
+        free(writer);
+        return NULL;
+    }
+    writer->failed = FALSE;
+    writer->used = 0;
+    writer->written = 0;
+    return writer;
+}
+
+/*
+ *  @brief libcache_save_image   writes the image of the cache, then renames path.tmp to path or removes it.
+ *
+ *  NOTE:  Only system calls are made, it's safe in a child forked from a multithreaded process.
+ */
+static libcache_ret_t libcache_save_image(libcache_t* libcache_ptr, libcache_image_writer_t* writer,
+        const char* temp_path, const char* path)
+{
+    libcache_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LIBCACHE_IMAGE_MAGIC;
+    header.version = LIBCACHE_IMAGE_VERSION;
+    header.header_size = sizeof(header);
+    header.entry_size = libcache_ptr->entry_size;
+    header.key_size = libcache_ptr->key_size;
+    header.ttl = (NULL != libcache_ptr->ttl_wheel);
+    header.clock = (NULL != libcache_ptr->ttl_wheel) ? libcache_ptr->ttl_wheel->clock : 0;
+
+    // Note: entries of the cache being resized are colder than the ones moved already
+    int result = libcache_image_write(writer, &header, sizeof(header));
+    if (result && NULL != libcache_ptr->resize_from) {
+        result = libcache_save_entries(libcache_ptr->resize_from, writer, &header.entry_number);
+    }
+    result = result && libcache_save_entries(libcache_ptr, writer, &header.entry_number)
+            && libcache_image_flush(writer);
+
+    // Note: the header is written again with the length and number of entries
+    header.length = writer->written;
+    writer->used = 0;
+    result = result && 0 == lseek(writer->fd, 0, SEEK_SET)
+            && libcache_image_write(writer, &header, sizeof(header)) && libcache_image_flush(writer)
+            && 0 == fsync(writer->fd);
+    result = (0 == close(writer->fd)) && result;
+    if (!result || 0 != rename(temp_path, path)) {
+        DEBUG_ERROR("failed to write %s", temp_path);
+        unlink(temp_path);
+        return LIBCACHE_FAILURE;
+    }
+    return LIBCACHE_SUCCESS;
+}
 
+libcache_ret_t libcache_save(void* libcache, const char* path)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    char* temp_path = NULL;
+    libcache_image_writer_t* writer = libcache_save_open(libcache_ptr, path, &temp_path);
+    if (NULL == writer) {
+        return LIBCACHE_FAILURE;
+    }
+    libcache_ret_t ret = libcache_save_image(libcache_ptr, writer, temp_path, path);
+    free(writer);
+    free(temp_path);
+    return ret;
+}
+
+libcache_ret_t libcache_save_start(void* libcache, const char* path, int* pid)
+{
+    libcache_t* libcache_ptr = (libcache_t*)libcache;
+    if (unlikely(NULL == pid)) {
+        DEBUG_ERROR("input parameter %s is null", "pid");
+        return LIBCACHE_FAILURE;
+    }
+    char* temp_path = NULL;
+    libcache_image_writer_t* writer = libcache_save_open(libcache_ptr, path, &temp_path);
+    if (NULL == writer) {
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: the child sees the cache as it is now, pages written by the parent later are copied on write
+    pid_t child = fork();
+    if (0 == child) {
+        _exit(LIBCACHE_SUCCESS == libcache_save_image(libcache_ptr, writer, temp_path, path) ? 0 : 1);
+    }
+    close(writer->fd);
+    if (child < 0) {
+        DEBUG_ERROR("failed to fork the writer of %s", temp_path);
+        unlink(temp_path);
+    }
+    free(writer);
+    free(temp_path);
+    if (child < 0) {
+        return LIBCACHE_FAILURE;
+    }
+    *pid = (int) child;
     return LIBCACHE_SUCCESS;
 }
+
+libcache_ret_t libcache_save_wait(int pid, int block)
+{
+    int status = 0;
+    pid_t ret = -1;
+    do {
+        ret = waitpid((pid_t) pid, &status, block ? 0 : WNOHANG);
+    } while (ret < 0 && EINTR == errno);
+    if (0 == ret) {
+        return LIBCACHE_LOCKED;
+    }
+    if (ret != (pid_t) pid) {
+        DEBUG_ERROR("failed to wait for the writer %d", pid);
+        return LIBCACHE_FAILURE;
+    }
+    return (WIFEXITED(status) && 0 == WEXITSTATUS(status)) ? LIBCACHE_SUCCESS : LIBCACHE_FAILURE;
+}
+
+void* libcache_load(const char* path, const libcache_attr_t* attr)
+{
+    if (unlikely(NULL == path || NULL == attr)) {
+        DEBUG_ERROR("input parameter %s is null", "path or attr");
+        return NULL;
+    }
+
+    if (unlikely(attr->engine == LIBCACHE_ENGINE_COMPACT)) {
+        DEBUG_ERROR("images are loaded by the pool engine");
+        return NULL;
+    }
+
+    size_t length = 0;
+    const char* image = (const char*) libcache_memory_map_file(path, &length);
+    if (NULL == image) {
+        return NULL;
+    }
+    const libcache_image_header_t* header = (const libcache_image_header_t*) image;
+    if (length < sizeof(libcache_image_header_t) || header->magic != LIBCACHE_IMAGE_MAGIC
+            || header->version != LIBCACHE_IMAGE_VERSION || header->header_size != sizeof(libcache_image_header_t)
+            || header->length != length || header->entry_size != attr->entry_size
+            || header->key_size != attr->key_size) {
+        DEBUG_ERROR("%s isn't an image of a cache of the same entry and key sizes", path);
+        libcache_memory_unmap_file(image, length);
+        return NULL;
+    }
+
+    libcache_t* libcache_ptr = (libcache_t*) libcache_create_ex(attr);
+    if (unlikely(NULL == libcache_ptr)) {
+        libcache_memory_unmap_file(image, length);
+        return NULL;
+    }
+    int ttl = header->ttl && NULL != libcache_ptr->ttl_wheel;
+    if (NULL != libcache_ptr->ttl_wheel) {
+        libcache_ttl_init(libcache_ptr->ttl_wheel, header->clock);
+    }
+
+    // Note: entries are added coldest first, a smaller cache swaps the coldest out, and keeps the order of the rest
+    size_t offset = sizeof(libcache_image_header_t);
+    uint64_t i;
+    for (i = 0; i < header->entry_number; i++) {
+        const libcache_image_entry_t* image_entry = (const libcache_image_entry_t*) (image + offset);
+        if (unlikely(length - offset < sizeof(libcache_image_entry_t) || image_entry->entry_length > attr->entry_size
+                || length - offset < LIBCACHE_IMAGE_ENTRY_LENGTH(attr->key_size, image_entry->entry_length))) {
+            DEBUG_ERROR("image %s is corrupted at %zu", path, offset);
+            libcache_memory_unmap_file(image, length);
+            libcache_destroy(libcache_ptr);
+            return NULL;
+        }
+        const char* key = image + offset + sizeof(libcache_image_entry_t);
+        offset += LIBCACHE_IMAGE_ENTRY_LENGTH(attr->key_size, image_entry->entry_length);
+        if (ttl && 0 != image_entry->expire_at && image_entry->expire_at <= header->clock) {
+            continue;
+        }
+        void* entry = NULL;
+        if (unlikely(LIBCACHE_SUCCESS != libcache_add_record(libcache_ptr, key, key + attr->key_size,
+                image_entry->entry_length, &entry))) {
+            continue;
+        }
+        libcache_tier_forget(libcache_ptr, key);
+        if (ttl && 0 != image_entry->expire_at) {
+            libcache_ttl_set(libcache_ptr, entry, image_entry->expire_at);
+        }
+    }
+    libcache_memory_unmap_file(image, length);
+    return libcache_ptr;
+}
@@ -0,0 +1,34 @@
+/*
+ * libcache_amalgam.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+/*
+ * The whole library as one translation unit, built by "make amalgamated=yes" instead of the separate
+ * sources. Pool, hash, list and policy functions are seen where libcache_lookup and libcache_add call them,
+ * so they're inlined into the API, which is the same as the one of the separate build.
+ * A program may compile this file along with its own instead of linking libcache.a, or include it into
+ * one of its sources, then the API itself can be inlined into that source too.
+ */
+
+// Note: what all sources need, the ones asking for less only define theirs if it isn't defined yet
+#define _GNU_SOURCE
+
+#include "list.c"
+#include "libpool.c"
+#include "hash.c"
+#include "libcache_policy.c"
+#include "libcache_memory.c"
+#include "libcache_hash.c"
+#include "libcache_ttl.c"
+#include "libcache_filter.c"
+#include "libcache_compress.c"
+#include "libcache_tier.c"
+#include "libcache_btree.c"
+#include "libcache_stats.c"
+#include "libcache_compact.c"
+#include "libcache.c"
+#include "libcache_sharded.c"
+#include "libcache_local.c"
+#include "libcache_replication.c"
@@ -0,0 +1,400 @@
+/*
+ * libcache_btree.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "libcache_btree.h"
+#include "libpool.h"
+
+/*
+ *  @brief libcache_btree_key_stride  keys of 1, 2, 4 or a multiple of 8 bytes are packed, others are padded
+ *                                    to 8 bytes, so cmp_key reads every key aligned.
+ */
+static inline size_t libcache_btree_key_stride(size_t key_size)
+{
+    return (key_size <= 4 && 3 != key_size) || 0 == key_size % 8 ? key_size : (key_size + 7) / 8 * 8;
+}
+
+static inline uint32_t libcache_btree_fanout(size_t node_size, size_t key_size)
+{
+    return (uint32_t) ((node_size - sizeof(libcache_btree_node_t) - sizeof(void*))
+            / (sizeof(void*) + libcache_btree_key_stride(key_size)));
+}
+
+size_t libcache_btree_caculate_node_size(size_t key_size)
+{
+    size_t node_size = LIBCACHE_BTREE_NODE_LINES * LIBCACHE_CACHE_LINE_SIZE;
+    while (libcache_btree_fanout(node_size, key_size) < LIBCACHE_BTREE_MIN_FANOUT) {
+        node_size += LIBCACHE_CACHE_LINE_SIZE;
+    }
+    return node_size;
+}
+
+size_t libcache_btree_caculate_node_count(size_t max_entry, size_t key_size)
+{
+    // Note: leaves other than the root are half full at least, inner nodes are fewer than leaves
+    uint32_t fanout = libcache_btree_fanout(libcache_btree_caculate_node_size(key_size), key_size);
+    size_t leaves = max_entry / (fanout / 2) + 1;
+    return leaves * 2 + 1;
+}
+
+void libcache_btree_init(libcache_btree_t* tree, void* pools, int pool_type, size_t key_size,
+        LIBCACHE_CMP_KEY* cmp_key)
+{
+    tree->pools = pools;
+    tree->pool_type = pool_type;
+    tree->cmp_key = cmp_key;
+    tree->key_size = key_size;
+    tree->key_stride = libcache_btree_key_stride(key_size);
+    tree->fanout = libcache_btree_fanout(libcache_btree_caculate_node_size(key_size), key_size);
+    tree->keys_offset = sizeof(libcache_btree_node_t) + sizeof(void*) * (tree->fanout + 1);
+    tree->height = 0;
+    tree->count = 0;
+    tree->root = NULL;
+}
+
+void libcache_btree_clear(libcache_btree_t* tree)
+{
+    tree->height = 0;
+    tree->count = 0;
+    tree->root = NULL;
+}
+
+static inline char* libcache_btree_key(const libcache_btree_t* tree, const libcache_btree_node_t* node, uint32_t i)
+{
+    return (char*) (uintptr_t) node + tree->keys_offset + (size_t) i * tree->key_stride;
+}
+
+static inline int libcache_btree_less(const libcache_btree_t* tree, const void* key1, const void* key2)
+{
+    return LIBCACHE_SMALLER == tree->cmp_key(key1, key2);
+}
+
+/*
+ *  @brief libcache_btree_lower_bound  gets the first key of a node which isn't smaller than key.
+ */
+static inline uint32_t libcache_btree_lower_bound(const libcache_btree_t* tree, const libcache_btree_node_t* node,
+        const void* key)
+{
+    uint32_t low = 0;
+    uint32_t high = node->count;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (libcache_btree_less(tree, libcache_btree_key(tree, node, middle), key)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*
+ *  @brief libcache_btree_child  gets the child of an inner node where key is, after the keys it isn't smaller than.
+ */
+static inline uint32_t libcache_btree_child(const libcache_btree_t* tree, const libcache_btree_node_t* node,
+        const void* key)
+{
+    uint32_t low = 0;
+    uint32_t high = node->count;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (libcache_btree_less(tree, key, libcache_btree_key(tree, node, middle))) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+static inline uint32_t libcache_btree_min(const libcache_btree_t* tree, const libcache_btree_node_t* node)
+{
+    return node->leaf ? tree->fanout / 2 : (tree->fanout - 1) / 2;
+}
+
+static libcache_btree_node_t* libcache_btree_new_node(libcache_btree_t* tree, int leaf)
+{
+    libcache_btree_node_t* node = (libcache_btree_node_t*) pool_get_element(tree->pools, tree->pool_type);
+    if (unlikely(NULL == node)) {
+        DEBUG_ERROR("no memory for %s", "btree node");
+        return NULL;
+    }
+    node->count = 0;
+    node->leaf = (uint16_t) leaf;
+    node->next = NULL;
+    return node;
+}
+
+static inline void libcache_btree_free_node(libcache_btree_t* tree, libcache_btree_node_t* node)
+{
+    pool_free_element(tree->pools, tree->pool_type, node);
+}
+
+/*
+ *  @brief libcache_btree_move_keys  moves count keys of a node to those from dst of another, or the same one.
+ */
+static inline void libcache_btree_move_keys(const libcache_btree_t* tree, libcache_btree_node_t* dst_node,
+        uint32_t dst, const libcache_btree_node_t* src_node, uint32_t src, uint32_t count)
+{
+    memmove(libcache_btree_key(tree, dst_node, dst), libcache_btree_key(tree, src_node, src),
+            (size_t) count * tree->key_stride);
+}
+
+static inline void libcache_btree_move_pointers(libcache_btree_node_t* dst_node, uint32_t dst,
+        const libcache_btree_node_t* src_node, uint32_t src, uint32_t count)
+{
+    memmove(&dst_node->pointers[dst], &src_node->pointers[src], (size_t) count * sizeof(void*));
+}
+
+/*
+ *  @brief libcache_btree_split  splits the full child i of a parent which isn't full, the upper half goes into
+ *                               a new node right of it.
+ *
+ *  @return FALSE           there's no free node.
+ */
+static int libcache_btree_split(libcache_btree_t* tree, libcache_btree_node_t* parent, uint32_t i)
+{
+    libcache_btree_node_t* child = (libcache_btree_node_t*) parent->pointers[i];
+    libcache_btree_node_t* right = libcache_btree_new_node(tree, child->leaf);
+    if (unlikely(NULL == right)) {
+        return FALSE;
+    }
+    uint32_t middle = tree->fanout / 2;
+    const char* separator;
+    if (child->leaf) {
+        // Note: the first key of the right leaf is also the separator
+        right->count = (uint16_t) (tree->fanout - middle);
+        libcache_btree_move_keys(tree, right, 0, child, middle, right->count);
+        libcache_btree_move_pointers(right, 0, child, middle, right->count);
+        right->next = child->next;
+        child->next = right;
+        separator = libcache_btree_key(tree, right, 0);
+    } else {
+        // Note: the middle key goes up, it's left where it is until it's copied
+        right->count = (uint16_t) (tree->fanout - middle - 1);
+        libcache_btree_move_keys(tree, right, 0, child, middle + 1, right->count);
+        libcache_btree_move_pointers(right, 0, child, middle + 1, right->count + 1);
+        separator = libcache_btree_key(tree, child, middle);
+    }
+    child->count = (uint16_t) middle;
+
+    libcache_btree_move_keys(tree, parent, i + 1, parent, i, parent->count - i);
+    libcache_btree_move_pointers(parent, i + 2, parent, i + 1, parent->count - i);
+    memcpy(libcache_btree_key(tree, parent, i), separator, tree->key_stride);
+    parent->pointers[i + 1] = right;
+    parent->count++;
+    return TRUE;
+}
+
+int libcache_btree_insert(libcache_btree_t* tree, const void* key, void* item)
+{
+    if (NULL == tree->root) {
+        tree->root = libcache_btree_new_node(tree, TRUE);
+        if (unlikely(NULL == tree->root)) {
+            return FALSE;
+        }
+        tree->height = 1;
+    }
+    // Note: full nodes are split on the way down, so a split never goes up
+    if (tree->root->count == tree->fanout) {
+        libcache_btree_node_t* root = libcache_btree_new_node(tree, FALSE);
+        if (unlikely(NULL == root)) {
+            return FALSE;
+        }
+        root->pointers[0] = tree->root;
+        if (unlikely(!libcache_btree_split(tree, root, 0))) {
+            libcache_btree_free_node(tree, root);
+            return FALSE;
+        }
+        tree->root = root;
+        tree->height++;
+    }
+
+    libcache_btree_node_t* node = tree->root;
+    while (!node->leaf) {
+        uint32_t i = libcache_btree_child(tree, node, key);
+        if (((libcache_btree_node_t*) node->pointers[i])->count == tree->fanout) {
+            if (unlikely(!libcache_btree_split(tree, node, i))) {
+                return FALSE;
+            }
+            if (!libcache_btree_less(tree, key, libcache_btree_key(tree, node, i))) {
+                i++;
+            }
+        }
+        node = (libcache_btree_node_t*) node->pointers[i];
+    }
+
+    uint32_t i = libcache_btree_lower_bound(tree, node, key);
+    if (i < node->count && LIBCACHE_EQU == tree->cmp_key(libcache_btree_key(tree, node, i), key)) {
+        return FALSE;
+    }
+    libcache_btree_move_keys(tree, node, i + 1, node, i, node->count - i);
+    libcache_btree_move_pointers(node, i + 1, node, i, node->count - i);
+    memcpy(libcache_btree_key(tree, node, i), key, tree->key_size);
+    node->pointers[i] = item;
+    node->count++;
+    tree->count++;
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_btree_merge  merges child i + 1 of a parent into child i, both are half full at most.
+ */
+static void libcache_btree_merge(libcache_btree_t* tree, libcache_btree_node_t* parent, uint32_t i)
+{
+    libcache_btree_node_t* left = (libcache_btree_node_t*) parent->pointers[i];
+    libcache_btree_node_t* right = (libcache_btree_node_t*) parent->pointers[i + 1];
+    if (left->leaf) {
+        libcache_btree_move_keys(tree, left, left->count, right, 0, right->count);
+        libcache_btree_move_pointers(left, left->count, right, 0, right->count);
+        left->count = (uint16_t) (left->count + right->count);
+        left->next = right->next;
+    } else {
+        // Note: the separator comes down between the keys of both
+        memcpy(libcache_btree_key(tree, left, left->count), libcache_btree_key(tree, parent, i), tree->key_stride);
+        libcache_btree_move_keys(tree, left, left->count + 1, right, 0, right->count);
+        libcache_btree_move_pointers(left, left->count + 1, right, 0, right->count + 1);
+        left->count = (uint16_t) (left->count + right->count + 1);
+    }
+    libcache_btree_move_keys(tree, parent, i, parent, i + 1, parent->count - i - 1);
+    libcache_btree_move_pointers(parent, i + 1, parent, i + 2, parent->count - i - 1);
+    parent->count--;
+    libcache_btree_free_node(tree, right);
+}
+
+static void libcache_btree_borrow_left(libcache_btree_t* tree, libcache_btree_node_t* parent, uint32_t i)
+{
+    libcache_btree_node_t* left = (libcache_btree_node_t*) parent->pointers[i - 1];
+    libcache_btree_node_t* child = (libcache_btree_node_t*) parent->pointers[i];
+    libcache_btree_move_keys(tree, child, 1, child, 0, child->count);
+    if (child->leaf) {
+        libcache_btree_move_pointers(child, 1, child, 0, child->count);
+        memcpy(libcache_btree_key(tree, child, 0), libcache_btree_key(tree, left, left->count - 1), tree->key_stride);
+        child->pointers[0] = left->pointers[left->count - 1];
+        memcpy(libcache_btree_key(tree, parent, i - 1), libcache_btree_key(tree, child, 0), tree->key_stride);
+    } else {
+        libcache_btree_move_pointers(child, 1, child, 0, child->count + 1);
+        memcpy(libcache_btree_key(tree, child, 0), libcache_btree_key(tree, parent, i - 1), tree->key_stride);
+        child->pointers[0] = left->pointers[left->count];
+        memcpy(libcache_btree_key(tree, parent, i - 1), libcache_btree_key(tree, left, left->count - 1),
+                tree->key_stride);
+    }
+    left->count--;
+    child->count++;
+}
+
+static void libcache_btree_borrow_right(libcache_btree_t* tree, libcache_btree_node_t* parent, uint32_t i)
+{
+    libcache_btree_node_t* child = (libcache_btree_node_t*) parent->pointers[i];
+    libcache_btree_node_t* right = (libcache_btree_node_t*) parent->pointers[i + 1];
+    if (child->leaf) {
+        memcpy(libcache_btree_key(tree, child, child->count), libcache_btree_key(tree, right, 0), tree->key_stride);
+        child->pointers[child->count] = right->pointers[0];
+        libcache_btree_move_keys(tree, right, 0, right, 1, right->count - 1);
+        libcache_btree_move_pointers(right, 0, right, 1, right->count - 1);
+        memcpy(libcache_btree_key(tree, parent, i), libcache_btree_key(tree, right, 0), tree->key_stride);
+    } else {
+        memcpy(libcache_btree_key(tree, child, child->count), libcache_btree_key(tree, parent, i), tree->key_stride);
+        child->pointers[child->count + 1] = right->pointers[0];
+        memcpy(libcache_btree_key(tree, parent, i), libcache_btree_key(tree, right, 0), tree->key_stride);
+        libcache_btree_move_keys(tree, right, 0, right, 1, right->count - 1);
+        libcache_btree_move_pointers(right, 0, right, 1, right->count);
+    }
+    right->count--;
+    child->count++;
+}
+
+/*
+ *  @brief libcache_btree_fill  gives child i of a parent a key more than half full, from a sibling, or by merging
+ *                              it with one, so a remove under it can't leave it below half.
+ *
+ *  @return                 the child where the keys of child i are now.
+ */
+static uint32_t libcache_btree_fill(libcache_btree_t* tree, libcache_btree_node_t* parent, uint32_t i)
+{
+    libcache_btree_node_t* left = (i > 0) ? (libcache_btree_node_t*) parent->pointers[i - 1] : NULL;
+    libcache_btree_node_t* right = (i < parent->count) ? (libcache_btree_node_t*) parent->pointers[i + 1] : NULL;
+    if (NULL != left && left->count > libcache_btree_min(tree, left)) {
+        libcache_btree_borrow_left(tree, parent, i);
+        return i;
+    }
+    if (NULL != right && right->count > libcache_btree_min(tree, right)) {
+        libcache_btree_borrow_right(tree, parent, i);
+        return i;
+    }
+    if (NULL != left) {
+        libcache_btree_merge(tree, parent, i - 1);
+        return i - 1;
+    }
+    libcache_btree_merge(tree, parent, i);
+    return i;
+}
+
+int libcache_btree_remove(libcache_btree_t* tree, const void* key, void* item)
+{
+    libcache_btree_node_t* node = tree->root;
+    if (NULL == node) {
+        return FALSE;
+    }
+    // Note: nodes on the way down are filled first, so a merge never goes up
+    while (!node->leaf) {
+        uint32_t i = libcache_btree_child(tree, node, key);
+        libcache_btree_node_t* child = (libcache_btree_node_t*) node->pointers[i];
+        if (child->count <= libcache_btree_min(tree, child)) {
+            i = libcache_btree_fill(tree, node, i);
+        }
+        libcache_btree_node_t* parent = node;
+        node = (libcache_btree_node_t*) parent->pointers[i];
+        // Note: a root whose last two children are merged gives its place to the merged one
+        if (parent == tree->root && 0 == parent->count) {
+            tree->root = node;
+            tree->height--;
+            libcache_btree_free_node(tree, parent);
+        }
+    }
+
+    uint32_t i = libcache_btree_lower_bound(tree, node, key);
+    if (i >= node->count || LIBCACHE_EQU != tree->cmp_key(libcache_btree_key(tree, node, i), key)
+            || node->pointers[i] != item) {
+        return FALSE;
+    }
+    libcache_btree_move_keys(tree, node, i, node, i + 1, node->count - i - 1);
+    libcache_btree_move_pointers(node, i, node, i + 1, node->count - i - 1);
+    node->count--;
+    tree->count--;
+    if (node == tree->root && 0 == node->count) {
+        libcache_btree_free_node(tree, node);
+        libcache_btree_clear(tree);
+    }
+    return TRUE;
+}
+
+int libcache_btree_range(const libcache_btree_t* tree, const void* lo, const void* hi, LIBCACHE_BTREE_VISIT* visit,
+        void* arg)
+{
+    const libcache_btree_node_t* node = tree->root;
+    if (NULL == node) {
+        return TRUE;
+    }
+    while (!node->leaf) {
+        node = (const libcache_btree_node_t*) node->pointers[(NULL == lo) ? 0 : libcache_btree_child(tree, node, lo)];
+    }
+    uint32_t i = (NULL == lo) ? 0 : libcache_btree_lower_bound(tree, node, lo);
+    for (; NULL != node; node = node->next, i = 0) {
+        for (; i < node->count; i++) {
+            const char* key = libcache_btree_key(tree, node, i);
+            if (NULL != hi && libcache_btree_less(tree, hi, key)) {
+                return TRUE;
+            }
+            if (!visit(key, node->pointers[i], arg)) {
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
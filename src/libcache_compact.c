@@ -0,0 +1,573 @@
+/*
+ * libcache_compact.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libcache.h"
+#include "libcache_def.h"
+#include "libcache_compact.h"
+#include "libcache_hash.h"
+#include "libcache_memory.h"
+#include "libpool.h"
+
+/*
+ * All memory of a compact cache is one block, entries are elements of one array linked by 32 bits index:
+ * | libcache_compact_t | bucket heads | element 0 | element 1 | ... |
+ * An element is | libcache_compact_entry_t | entry | key |, user gets the entry right after the header.
+ * Unlocked entries are in LRU list, locked ones aren't in any list, free ones are in free list.
+ * Elements from high_water on have never been used, they're touched the first time they're got.
+ */
+#define LIBCACHE_COMPACT_NONE 0xFFFFFFFFU
+#define LIBCACHE_COMPACT_IN_USE 0x636f6d70U  /* "comp" */
+#define LIBCACHE_COMPACT_PRIME_32 0x9e370001UL  /* same as hash's */
+#define LIBCACHE_COMPACT_MIN_BUCKET_BITS 4
+#define LIBCACHE_COMPACT_MAX_BUCKET_BITS 31
+
+typedef struct libcache_compact_entry_t
+{
+    uint32_t chain_next;    /* next element of the same bucket */
+    uint32_t lru_prev;
+    uint32_t lru_next;      /* links free list while it's free */
+    uint32_t tag;           /* mixed key number, it's compared before the key */
+    uint32_t lock_counter;  /* atomic in LIBCACHE_CONCURRENT build */
+    uint32_t entry_length;
+    uint32_t key_offset;    /* from entry to key */
+    uint32_t check_value;   /* LIBCACHE_COMPACT_IN_USE while in cache, must be the last member */
+} libcache_compact_entry_t;
+
+typedef struct libcache_compact_t
+{
+    libcache_engine_e engine;  /* must be the first member, same as libcache_t */
+    uint32_t bucket_bits;
+    uint32_t* buckets;         /* index of the first element of every bucket */
+    char* elements;
+    size_t element_size;
+    size_t entry_size;
+    size_t key_size;
+    uint32_t max_entry_number; /* one more than asked, same as libcache.c */
+    uint32_t entry_count;
+    uint32_t high_water;
+    uint32_t peak;             /* high water before the latest clean */
+    uint32_t free_head;
+    uint32_t lru_head;         /* most recently used */
+    uint32_t lru_tail;         /* the victim */
+    unsigned long long get_total;
+    unsigned long long free_total;
+    libcache_page_e page_type;
+    size_t memory_length;
+    LIBCACHE_CMP_KEY* cmp_key;
+    LIBCACHE_KEY_TO_NUMBER* key_to_number;
+    libcache_hash_e hasher;    /* LIBCACHE_HASH_DEFAULT: key_to_number */
+    libcache_key_cmp_e key_cmp; /* LIBCACHE_KEY_CMP_USER: cmp_key */
+    LIBCACHE_FREE_MEMORY* free_memory;
+    LIBCACHE_FREE_ENTRY* free_entry;
+} libcache_compact_t;
+
+/*
+ * Same as libcache.c's, lock_counter can be decreased by libcache_try_unlock_entry from any thread
+ * in LIBCACHE_CONCURRENT build, it never becomes 0 there.
+ */
+#ifdef LIBCACHE_CONCURRENT
+#define COMPACT_COUNTER_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_ACQUIRE)
+#define COMPACT_COUNTER_INC(counter) __atomic_add_fetch(&(counter), 1, __ATOMIC_ACQ_REL)
+#define COMPACT_COUNTER_DEC(counter) __atomic_sub_fetch(&(counter), 1, __ATOMIC_ACQ_REL)
+#else
+#define COMPACT_COUNTER_LOAD(counter) (counter)
+#define COMPACT_COUNTER_INC(counter) (++(counter))
+#define COMPACT_COUNTER_DEC(counter) (--(counter))
+#endif
+
+// Note: loads of libcache_compact_peek, links may be changed by a writer meanwhile
+#define COMPACT_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+#define COMPACT_ROUND(size) (((size) + 7) / 8 * 8)
+
+static inline libcache_compact_entry_t* libcache_compact_element(const libcache_compact_t* cache, uint32_t index)
+{
+    return (libcache_compact_entry_t*) (cache->elements + (size_t) index * cache->element_size);
+}
+
+static inline uint32_t libcache_compact_index(const libcache_compact_t* cache, const libcache_compact_entry_t* element)
+{
+    return (uint32_t) (((const char*) element - cache->elements) / cache->element_size);
+}
+
+static inline void* libcache_compact_entry(libcache_compact_entry_t* element)
+{
+    return element + 1;
+}
+
+static inline void* libcache_compact_key(libcache_compact_entry_t* element)
+{
+    return (char*) (element + 1) + element->key_offset;
+}
+
+static inline int libcache_compact_key_equal(const libcache_compact_t* cache, libcache_compact_entry_t* element,
+        const void* key)
+{
+    return libcache_key_equal(cache->key_cmp, cache->cmp_key, cache->key_size, libcache_compact_key(element), key);
+}
+
+static inline uint32_t libcache_compact_tag(const libcache_compact_t* cache, const void* key)
+{
+    if (cache->hasher != LIBCACHE_HASH_DEFAULT) {
+        return (uint32_t) (libcache_hash_number(cache->hasher, key, cache->key_size) * LIBCACHE_COMPACT_PRIME_32);
+    }
+    return (uint32_t) (cache->key_to_number(key) * LIBCACHE_COMPACT_PRIME_32);
+}
+
+static inline uint32_t libcache_compact_bucket(const libcache_compact_t* cache, uint32_t tag)
+{
+    return tag >> (32 - cache->bucket_bits);
+}
+
+/*
+ *  @brief libcache_compact_to_element  gets the element of an entry in a compact cache.
+ *  @return NULL                        the entry isn't in a compact cache.
+ */
+static inline libcache_compact_entry_t* libcache_compact_to_element(void* entry)
+{
+    libcache_compact_entry_t* element = (libcache_compact_entry_t*) entry - 1;
+    return (element->check_value == LIBCACHE_COMPACT_IN_USE) ? element : NULL;
+}
+
+static void libcache_compact_lru_push_front(libcache_compact_t* cache, libcache_compact_entry_t* element)
+{
+    uint32_t index = libcache_compact_index(cache, element);
+    element->lru_prev = LIBCACHE_COMPACT_NONE;
+    element->lru_next = cache->lru_head;
+    if (cache->lru_head != LIBCACHE_COMPACT_NONE) {
+        libcache_compact_element(cache, cache->lru_head)->lru_prev = index;
+    } else {
+        cache->lru_tail = index;
+    }
+    cache->lru_head = index;
+}
+
+static void libcache_compact_lru_remove(libcache_compact_t* cache, libcache_compact_entry_t* element)
+{
+    if (element->lru_prev != LIBCACHE_COMPACT_NONE) {
+        libcache_compact_element(cache, element->lru_prev)->lru_next = element->lru_next;
+    } else {
+        cache->lru_head = element->lru_next;
+    }
+    if (element->lru_next != LIBCACHE_COMPACT_NONE) {
+        libcache_compact_element(cache, element->lru_next)->lru_prev = element->lru_prev;
+    } else {
+        cache->lru_tail = element->lru_prev;
+    }
+}
+
+/*
+ *  @brief libcache_compact_find    finds the element of a key.
+ *
+ *  @param prev                     output, the element before it in its bucket, NULL if it's the first one.
+ */
+static libcache_compact_entry_t* libcache_compact_find(const libcache_compact_t* cache, const void* key,
+        libcache_compact_entry_t** prev)
+{
+    uint32_t tag = libcache_compact_tag(cache, key);
+    uint32_t index = cache->buckets[libcache_compact_bucket(cache, tag)];
+    libcache_compact_entry_t* previous = NULL;
+    while (index != LIBCACHE_COMPACT_NONE) {
+        libcache_compact_entry_t* element = libcache_compact_element(cache, index);
+        if (element->tag == tag && libcache_compact_key_equal(cache, element, key)) {
+            if (NULL != prev) {
+                *prev = previous;
+            }
+            return element;
+        }
+        previous = element;
+        index = element->chain_next;
+    }
+    return NULL;
+}
+
+/*
+ *  @brief libcache_compact_free    removes an unlocked element from its bucket and LRU list, then frees it.
+ */
+static void libcache_compact_free(libcache_compact_t* cache, libcache_compact_entry_t* element,
+        libcache_compact_entry_t* prev)
+{
+    if (NULL == prev) {
+        cache->buckets[libcache_compact_bucket(cache, element->tag)] = element->chain_next;
+    } else {
+        prev->chain_next = element->chain_next;
+    }
+    libcache_compact_lru_remove(cache, element);
+
+    element->check_value = 0;
+    element->lru_next = cache->free_head;
+    cache->free_head = libcache_compact_index(cache, element);
+    cache->entry_count--;
+    cache->free_total++;
+}
+
+/*
+ *  @brief libcache_compact_swap_out    frees the least recently used unlocked element.
+ *  @return FALSE                       all elements are locked.
+ */
+static int libcache_compact_swap_out(libcache_compact_t* cache)
+{
+    if (cache->lru_tail == LIBCACHE_COMPACT_NONE) {
+        return FALSE;
+    }
+
+    // Note: buckets are singly linked, the one before the victim is found from the head
+    libcache_compact_entry_t* victim = libcache_compact_element(cache, cache->lru_tail);
+    libcache_compact_entry_t* prev = NULL;
+    uint32_t index = cache->buckets[libcache_compact_bucket(cache, victim->tag)];
+    while (index != cache->lru_tail) {
+        prev = libcache_compact_element(cache, index);
+        index = prev->chain_next;
+    }
+    libcache_compact_free(cache, victim, prev);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_compact_has_secondary  checks if any secondary index is asked for.
+ */
+static int libcache_compact_has_secondary(const libcache_attr_t* attr)
+{
+    int i;
+    for (i = 0; i < LIBCACHE_SECONDARY_INDEXES; i++) {
+        if (NULL != attr->secondary[i].extract_key) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void* libcache_compact_create(const libcache_attr_t* attr)
+{
+    if (attr->entry_memory_size > 0 || attr->policy != LIBCACHE_POLICY_LRU || attr->policy_ops != NULL
+            || attr->page_type == LIBCACHE_PAGE_SHARED || attr->stats != LIBCACHE_STATS_NONE
+            || attr->release_entry != NULL || attr->ttl || attr->load_entry != NULL
+            || attr->flush_entries != NULL || attr->evicted_entries != NULL || attr->negative_filter
+            || attr->negative_ttl || libcache_compact_has_secondary(attr) || attr->compress_threshold > 0
+            || attr->cold_tier != NULL || attr->ordered || attr->tags || attr->replication != NULL) {
+        DEBUG_ERROR("compact engine supports fixed size entries, LRU policy and private memory only, "
+                "no stats, release_entry, ttl, load_entry, flush_entries, evicted_entries, negative caching, "
+                "secondary indexes, compression, cold tier, ordered index, tags or replication");
+        return NULL;
+    }
+    if (attr->page_type == LIBCACHE_PAGE_USER && (!libcache_memory_allocator(attr) || attr->free_memory == NULL)) {
+        DEBUG_ERROR("argument %s and %s can not be NULL.", "allocate_memory", "free_memory");
+        return NULL;
+    }
+    if (attr->max_entry_number >= LIBCACHE_COMPACT_NONE - 1) {
+        DEBUG_ERROR("argument %s is invalid.", "max_entry_number");
+        return NULL;
+    }
+
+    uint32_t max_entry = attr->max_entry_number + 1;
+    uint32_t bucket_bits = LIBCACHE_COMPACT_MIN_BUCKET_BITS;
+    while (bucket_bits < LIBCACHE_COMPACT_MAX_BUCKET_BITS && ((uint64_t) 1 << bucket_bits) < max_entry) {
+        bucket_bits++;
+    }
+    size_t buckets_offset = COMPACT_ROUND(sizeof(libcache_compact_t));
+    size_t elements_offset = buckets_offset + COMPACT_ROUND(sizeof(uint32_t) << bucket_bits);
+    size_t element_size = sizeof(libcache_compact_entry_t) + COMPACT_ROUND(attr->entry_size)
+            + COMPACT_ROUND(attr->key_size);
+    size_t memory_length = elements_offset + element_size * max_entry;
+
+    libcache_page_e page_type = LIBCACHE_PAGE_USER;
+    void* memory = NULL;
+    if (attr->page_type == LIBCACHE_PAGE_USER) {
+        memory = libcache_memory_allocate(attr, memory_length);
+    } else {
+        memory = libcache_memory_map(memory_length, attr->page_type, attr->numa_node_mask, &page_type);
+    }
+    if (unlikely(memory == NULL)) {
+        DEBUG_ERROR("Memory malloc failed!")
+        return NULL;
+    }
+
+    // Note: only the handle and buckets are written, elements are touched when they're used
+    libcache_compact_t* cache = (libcache_compact_t*) memory;
+    memset(cache, 0, sizeof(libcache_compact_t));
+    cache->engine = LIBCACHE_ENGINE_COMPACT;
+    cache->bucket_bits = bucket_bits;
+    cache->buckets = (uint32_t*) ((char*) memory + buckets_offset);
+    memset(cache->buckets, 0xFF, sizeof(uint32_t) << bucket_bits);
+    cache->elements = (char*) memory + elements_offset;
+    cache->element_size = element_size;
+    cache->entry_size = attr->entry_size;
+    cache->key_size = attr->key_size;
+    cache->max_entry_number = max_entry;
+    cache->free_head = LIBCACHE_COMPACT_NONE;
+    cache->lru_head = LIBCACHE_COMPACT_NONE;
+    cache->lru_tail = LIBCACHE_COMPACT_NONE;
+    cache->page_type = page_type;
+    cache->memory_length = memory_length;
+    cache->cmp_key = attr->cmp_key;
+    cache->key_cmp = libcache_key_cmp_select(attr->cmp_key, attr->key_size);
+    cache->key_to_number = attr->key_to_number;
+    cache->hasher = libcache_hash_resolve(attr->hash, attr->key_to_number);
+    cache->free_memory = attr->free_memory;
+    cache->free_entry = attr->free_entry;
+    return cache;
+}
+
+void* libcache_compact_lookup(void* libcache, const void* key, void* dst_entry, size_t* entry_length)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+    libcache_compact_entry_t* element = libcache_compact_find(cache, key, NULL);
+    if (NULL == element) {
+        return NULL;
+    }
+    if (NULL != entry_length) {
+        *entry_length = element->entry_length;
+    }
+
+    // Note: a locked element is out of LRU list until it's unlocked
+    if (NULL == dst_entry) {
+        if (0 == COMPACT_COUNTER_LOAD(element->lock_counter)) {
+            libcache_compact_lru_remove(cache, element);
+        }
+        COMPACT_COUNTER_INC(element->lock_counter);
+        return libcache_compact_entry(element);
+    }
+
+    memcpy(dst_entry, libcache_compact_entry(element), element->entry_length);
+    if (0 == COMPACT_COUNTER_LOAD(element->lock_counter) && cache->lru_head != libcache_compact_index(cache, element)) {
+        libcache_compact_lru_remove(cache, element);
+        libcache_compact_lru_push_front(cache, element);
+    }
+    return dst_entry;
+}
+
+void* libcache_compact_peek(void* libcache, const void* key, void* dst_entry)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+    uint32_t tag = libcache_compact_tag(cache, key);
+    uint32_t index = COMPACT_LOAD(cache->buckets[libcache_compact_bucket(cache, tag)]);
+
+    // Note: an element freed meanwhile may link to anywhere, steps and indexes are bounded
+    uint32_t max_steps = COMPACT_LOAD(cache->entry_count) + 1;
+    uint32_t steps;
+    for (steps = 0; index < cache->max_entry_number && steps < max_steps; steps++) {
+        libcache_compact_entry_t* element = libcache_compact_element(cache, index);
+        if (COMPACT_LOAD(element->tag) == tag && COMPACT_LOAD(element->check_value) == LIBCACHE_COMPACT_IN_USE
+                && libcache_compact_key_equal(cache, element, key)) {
+            uint32_t entry_length = COMPACT_LOAD(element->entry_length);
+            if (unlikely(entry_length > cache->entry_size)) {
+                return NULL;
+            }
+            memcpy(dst_entry, libcache_compact_entry(element), entry_length);
+            return dst_entry;
+        }
+        index = COMPACT_LOAD(element->chain_next);
+    }
+    return NULL;
+}
+
+libcache_ret_t libcache_compact_add(void* libcache, const void* key, const void* src_entry, size_t entry_length,
+        void** entry)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+    if (unlikely(entry_length > cache->entry_size)) {
+        DEBUG_ERROR("entry length %zu is larger than entry size %zu", entry_length, cache->entry_size);
+        return LIBCACHE_FAILURE;
+    }
+    if (NULL != libcache_compact_find(cache, key, NULL)) {
+        DEBUG_INFO("the key is existed");
+        return LIBCACHE_EXISTING;
+    }
+
+    // Note: a freed element first, then a never used one, the least recently used one is swapped out at last
+    if (cache->free_head == LIBCACHE_COMPACT_NONE && cache->high_water >= cache->max_entry_number
+            && !libcache_compact_swap_out(cache)) {
+        DEBUG_INFO("all entries are locked");
+        return LIBCACHE_FULL;
+    }
+    libcache_compact_entry_t* element;
+    if (cache->free_head != LIBCACHE_COMPACT_NONE) {
+        element = libcache_compact_element(cache, cache->free_head);
+        cache->free_head = element->lru_next;
+    } else {
+        element = libcache_compact_element(cache, cache->high_water++);
+    }
+
+    uint32_t tag = libcache_compact_tag(cache, key);
+    uint32_t bucket = libcache_compact_bucket(cache, tag);
+    element->tag = tag;
+    element->lock_counter = (NULL == src_entry) ? 1 : 0;
+    element->entry_length = (uint32_t) entry_length;
+    element->key_offset = (uint32_t) COMPACT_ROUND(cache->entry_size);
+    memcpy(libcache_compact_key(element), key, cache->key_size);
+    if (NULL != src_entry) {
+        memcpy(libcache_compact_entry(element), src_entry, entry_length);
+    }
+    element->check_value = LIBCACHE_COMPACT_IN_USE;
+
+    // Note: published at last, so libcache_compact_peek never sees a half written element of its bucket
+    element->chain_next = cache->buckets[bucket];
+    __atomic_store_n(&cache->buckets[bucket], libcache_compact_index(cache, element), __ATOMIC_RELEASE);
+    if (NULL != src_entry) {
+        libcache_compact_lru_push_front(cache, element);
+    }
+    cache->entry_count++;
+    cache->get_total++;
+
+    if (NULL != entry) {
+        *entry = libcache_compact_entry(element);
+    }
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_compact_delete_by_key(void* libcache, const void* key)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+    libcache_compact_entry_t* prev = NULL;
+    libcache_compact_entry_t* element = libcache_compact_find(cache, key, &prev);
+    if (NULL == element) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    if (COMPACT_COUNTER_LOAD(element->lock_counter) > 0) {
+        return LIBCACHE_LOCKED;
+    }
+    libcache_compact_free(cache, element, prev);
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_compact_delete_entry(void* libcache, void* entry)
+{
+    libcache_compact_entry_t* element = libcache_compact_to_element(entry);
+    if (NULL == element) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    if (COMPACT_COUNTER_LOAD(element->lock_counter) > 0) {
+        return LIBCACHE_LOCKED;
+    }
+    return libcache_compact_delete_by_key(libcache, libcache_compact_key(element));
+}
+
+libcache_ret_t libcache_compact_unlock_entry(void* libcache, void* entry)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+    libcache_compact_entry_t* element = libcache_compact_to_element(entry);
+    if (NULL == element) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    if (COMPACT_COUNTER_LOAD(element->lock_counter) == 0) {
+        return LIBCACHE_UNLOCKED;
+    }
+    if (0 == COMPACT_COUNTER_DEC(element->lock_counter)) {
+        libcache_compact_lru_push_front(cache, element);
+    }
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_compact_try_unlock_entry(void* entry)
+{
+    libcache_compact_entry_t* element = libcache_compact_to_element(entry);
+    if (NULL == element) {
+        return LIBCACHE_FAILURE;
+    }
+
+    uint32_t counter = COMPACT_COUNTER_LOAD(element->lock_counter);
+    while (counter > 1) {
+#ifdef LIBCACHE_CONCURRENT
+        if (__atomic_compare_exchange_n(&element->lock_counter, &counter, counter - 1,
+                TRUE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return LIBCACHE_SUCCESS;
+        }
+#else
+        element->lock_counter = counter - 1;
+        return LIBCACHE_SUCCESS;
+#endif
+    }
+    return LIBCACHE_FAILURE;
+}
+
+const void* libcache_compact_get_entry_key(void* entry)
+{
+    libcache_compact_entry_t* element = libcache_compact_to_element(entry);
+    return (NULL == element) ? NULL : libcache_compact_key(element);
+}
+
+size_t libcache_compact_get_entry_size(const void* libcache)
+{
+    return ((const libcache_compact_t*) libcache)->entry_size;
+}
+
+libcache_scale_t libcache_compact_get_max_entry_number(const void* libcache)
+{
+    return ((const libcache_compact_t*) libcache)->max_entry_number - 1;
+}
+
+libcache_scale_t libcache_compact_get_entry_number(const void* libcache)
+{
+    return ((const libcache_compact_t*) libcache)->entry_count;
+}
+
+libcache_page_e libcache_compact_get_page_type(const void* libcache)
+{
+    return ((const libcache_compact_t*) libcache)->page_type;
+}
+
+libcache_ret_t libcache_compact_get_pool_stats(void* libcache, int pool_type, pool_stats_t* stats)
+{
+    const libcache_compact_t* cache = (const libcache_compact_t*) libcache;
+    if (pool_type != POOL_TYPE_DATA) {
+        DEBUG_ERROR("compact engine has no pool %d", pool_type);
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: elements are the only pool, same counters as libpool's, a swap out always comes before
+    //       getting an element, so getting never fails
+    stats->element_size = cache->element_size;
+    stats->capacity = cache->max_entry_number;
+    stats->in_use = cache->entry_count;
+    stats->peak = (cache->high_water > cache->peak) ? cache->high_water : cache->peak;
+    stats->get_total = cache->get_total;
+    stats->free_total = cache->free_total;
+    stats->fail_total = 0;
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_compact_clean(void* libcache)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+
+    // Note: elements aren't walked, they're never used again from the view of high water
+    memset(cache->buckets, 0xFF, sizeof(uint32_t) << cache->bucket_bits);
+    if (cache->high_water > cache->peak) {
+        cache->peak = cache->high_water;
+    }
+    cache->free_total += cache->entry_count;
+    cache->entry_count = 0;
+    cache->high_water = 0;
+    cache->free_head = LIBCACHE_COMPACT_NONE;
+    cache->lru_head = LIBCACHE_COMPACT_NONE;
+    cache->lru_tail = LIBCACHE_COMPACT_NONE;
+    return LIBCACHE_SUCCESS;
+}
+
+libcache_ret_t libcache_compact_destroy(void* libcache)
+{
+    libcache_compact_t* cache = (libcache_compact_t*) libcache;
+
+    // Note: elements are walked only for free_entry, freed ones aren't in use
+    uint32_t index;
+    for (index = 0; cache->free_entry != NULL && index < cache->high_water; index++) {
+        libcache_compact_entry_t* element = libcache_compact_element(cache, index);
+        if (element->check_value == LIBCACHE_COMPACT_IN_USE) {
+            cache->free_entry(libcache_compact_key(element), libcache_compact_entry(element));
+        }
+    }
+
+    if (cache->page_type == LIBCACHE_PAGE_USER) {
+        cache->free_memory(cache);
+    } else {
+        libcache_memory_unmap(cache, cache->memory_length, cache->page_type);
+    }
+    return LIBCACHE_SUCCESS;
+}
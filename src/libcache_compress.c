@@ -0,0 +1,199 @@
+/*
+ * libcache_compress.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "libcache_compress.h"
+
+#define LIBCACHE_COMPRESS_MIN_MATCH 4
+#define LIBCACHE_COMPRESS_LAST_LITERALS 5   /* a block ends with 5 literals at least */
+#define LIBCACHE_COMPRESS_MATCH_START 12    /* a match starts 12 bytes before the end at least */
+#define LIBCACHE_COMPRESS_MAX_OFFSET 65535
+#define LIBCACHE_COMPRESS_TOKEN_MAX 15      /* a length of 15 or more goes on in bytes after the token */
+
+static inline uint32_t libcache_compress_read32(const uint8_t* bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static inline uint32_t libcache_compress_hash(uint32_t prefix)
+{
+    return (prefix * 2654435761U) >> (32 - LIBCACHE_COMPRESS_HASH_BITS);
+}
+
+/*
+ *  @brief libcache_compress_length_bytes  gets the bytes after the token a length takes.
+ */
+static inline size_t libcache_compress_length_bytes(size_t length)
+{
+    return (length < LIBCACHE_COMPRESS_TOKEN_MAX) ? 0 : (length - LIBCACHE_COMPRESS_TOKEN_MAX) / 255 + 1;
+}
+
+static inline uint8_t* libcache_compress_put_length(uint8_t* op, size_t length)
+{
+    length -= LIBCACHE_COMPRESS_TOKEN_MAX;
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t) length;
+    return op;
+}
+
+/*
+ *  @brief libcache_compress_sequence  writes a sequence of literals, then a match if match_length isn't 0.
+ *
+ *  @return NULL           it doesn't fit before end.
+ *          pointer        where the next sequence is written.
+ */
+static uint8_t* libcache_compress_sequence(uint8_t* op, const uint8_t* end, const uint8_t* literals,
+        size_t literal_length, size_t offset, size_t match_length)
+{
+    size_t need = 1 + libcache_compress_length_bytes(literal_length) + literal_length;
+    if (0 != match_length) {
+        need += 2 + libcache_compress_length_bytes(match_length - LIBCACHE_COMPRESS_MIN_MATCH);
+    }
+    if (unlikely((size_t) (end - op) < need)) {
+        return NULL;
+    }
+
+    uint8_t* token = op++;
+    *token = (uint8_t) (((literal_length < LIBCACHE_COMPRESS_TOKEN_MAX) ? literal_length
+            : LIBCACHE_COMPRESS_TOKEN_MAX) << 4);
+    if (literal_length >= LIBCACHE_COMPRESS_TOKEN_MAX) {
+        op = libcache_compress_put_length(op, literal_length);
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (0 != match_length) {
+        *op++ = (uint8_t) offset;
+        *op++ = (uint8_t) (offset >> 8);
+        size_t length = match_length - LIBCACHE_COMPRESS_MIN_MATCH;
+        *token |= (uint8_t) ((length < LIBCACHE_COMPRESS_TOKEN_MAX) ? length : LIBCACHE_COMPRESS_TOKEN_MAX);
+        if (length >= LIBCACHE_COMPRESS_TOKEN_MAX) {
+            op = libcache_compress_put_length(op, length);
+        }
+    }
+    return op;
+}
+
+size_t libcache_compress(const void* src, size_t length, void* dst, size_t capacity, uint32_t* table)
+{
+    const uint8_t* base = (const uint8_t*) src;
+    uint8_t* op = (uint8_t*) dst;
+    const uint8_t* end = op + capacity;
+    size_t anchor = 0;
+    size_t ip = 0;
+    if (length > LIBCACHE_COMPRESS_MATCH_START) {
+        size_t match_end = length - LIBCACHE_COMPRESS_LAST_LITERALS;
+        size_t start_end = length - LIBCACHE_COMPRESS_MATCH_START;
+        while (ip < start_end) {
+            uint32_t prefix = libcache_compress_read32(base + ip);
+            uint32_t* slot = &table[libcache_compress_hash(prefix)];
+            size_t candidate = *slot;
+            *slot = (uint32_t) ip;
+            // Note: a position left by another entry is either ahead or checked by its bytes
+            if (candidate >= ip || ip - candidate > LIBCACHE_COMPRESS_MAX_OFFSET
+                    || libcache_compress_read32(base + candidate) != prefix) {
+                ip++;
+                continue;
+            }
+
+            // Note: the match also takes the literals before it which are the same
+            while (ip > anchor && candidate > 0 && base[ip - 1] == base[candidate - 1]) {
+                ip--;
+                candidate--;
+            }
+            size_t match_length = LIBCACHE_COMPRESS_MIN_MATCH;
+            while (ip + match_length < match_end && base[ip + match_length] == base[candidate + match_length]) {
+                match_length++;
+            }
+            op = libcache_compress_sequence(op, end, base + anchor, ip - anchor, ip - candidate, match_length);
+            if (unlikely(NULL == op)) {
+                return 0;
+            }
+            ip += match_length;
+            anchor = ip;
+        }
+    }
+
+    op = libcache_compress_sequence(op, end, base + anchor, length - anchor, 0, 0);
+    return (NULL == op) ? 0 : (size_t) (op - (uint8_t*) dst);
+}
+
+/*
+ *  @brief libcache_decompress_length  adds the bytes after the token to a length of LIBCACHE_COMPRESS_TOKEN_MAX.
+ *
+ *  @return FALSE           src ends first.
+ */
+static inline int libcache_decompress_length(const uint8_t** ip, const uint8_t* ip_end, size_t* length)
+{
+    uint8_t byte;
+    do {
+        if (unlikely(*ip == ip_end)) {
+            return FALSE;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (255 == byte);
+    return TRUE;
+}
+
+int libcache_decompress(const void* src, size_t src_length, void* dst, size_t length)
+{
+    const uint8_t* ip = (const uint8_t*) src;
+    const uint8_t* ip_end = ip + src_length;
+    uint8_t* op = (uint8_t*) dst;
+    uint8_t* op_end = op + length;
+    while (ip < ip_end) {
+        uint8_t token = *ip++;
+        size_t literal_length = token >> 4;
+        if (LIBCACHE_COMPRESS_TOKEN_MAX == literal_length
+                && !libcache_decompress_length(&ip, ip_end, &literal_length)) {
+            return FALSE;
+        }
+        if (unlikely((size_t) (ip_end - ip) < literal_length || (size_t) (op_end - op) < literal_length)) {
+            return FALSE;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        // Note: the last sequence has no match, src may go on with padding of its element
+        if (op == op_end) {
+            return TRUE;
+        }
+
+        if (unlikely(ip_end - ip < 2)) {
+            return FALSE;
+        }
+        size_t offset = (size_t) ip[0] | ((size_t) ip[1] << 8);
+        ip += 2;
+        if (unlikely(0 == offset || offset > (size_t) (op - (uint8_t*) dst))) {
+            return FALSE;
+        }
+        size_t match_length = token & LIBCACHE_COMPRESS_TOKEN_MAX;
+        if (LIBCACHE_COMPRESS_TOKEN_MAX == match_length && !libcache_decompress_length(&ip, ip_end, &match_length)) {
+            return FALSE;
+        }
+        match_length += LIBCACHE_COMPRESS_MIN_MATCH;
+        if (unlikely((size_t) (op_end - op) < match_length)) {
+            return FALSE;
+        }
+        // Note: a match overlapping what it writes repeats offset bytes, what's behind doubles every copy
+        const uint8_t* match = op - offset;
+        while (match_length > (size_t) (op - match)) {
+            size_t step = (size_t) (op - match);
+            memcpy(op, match, step);
+            op += step;
+            match_length -= step;
+        }
+        memcpy(op, match, match_length);
+        op += match_length;
+    }
+    return FALSE;
+}
@@ -0,0 +1,113 @@
+/*
+ * libcache_filter.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "libcache_filter.h"
+
+/*
+ *  @brief libcache_filter_bucket_bits  gets the number of bits of bucket indexes, 2 slots a key at least.
+ */
+static uint32_t libcache_filter_bucket_bits(size_t max_entry)
+{
+    uint32_t bits = 0;
+    while (bits < 31 && ((size_t) LIBCACHE_FILTER_SLOTS << bits) < max_entry * 2) {
+        bits++;
+    }
+    return bits;
+}
+
+size_t libcache_filter_caculate_length(size_t max_entry)
+{
+    return sizeof(libcache_filter_t)
+            + ((size_t) 1 << libcache_filter_bucket_bits(max_entry)) * sizeof(uint16_t[LIBCACHE_FILTER_SLOTS]);
+}
+
+void libcache_filter_init(libcache_filter_t* filter, size_t max_entry)
+{
+    filter->bucket_mask = ((uint32_t) 1 << libcache_filter_bucket_bits(max_entry)) - 1;
+    libcache_filter_clear(filter);
+}
+
+void libcache_filter_clear(libcache_filter_t* filter)
+{
+    filter->count = 0;
+    filter->overflowed = FALSE;
+    filter->kick = 0;
+    memset(filter->buckets, 0, ((size_t) filter->bucket_mask + 1) * sizeof(uint16_t[LIBCACHE_FILTER_SLOTS]));
+}
+
+/*
+ *  @brief libcache_filter_put  puts a fingerprint into an empty slot of a bucket.
+ *
+ *  @return FALSE           the bucket is full.
+ */
+static inline int libcache_filter_put(libcache_filter_t* filter, uint32_t bucket, uint16_t fingerprint)
+{
+    uint16_t* slots = filter->buckets[bucket];
+    int i;
+    for (i = 0; i < LIBCACHE_FILTER_SLOTS; i++) {
+        if (0 == slots[i]) {
+            slots[i] = fingerprint;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+int libcache_filter_add(libcache_filter_t* filter, uint32_t tag)
+{
+    uint16_t fingerprint = libcache_filter_fingerprint(tag);
+    uint32_t bucket = libcache_filter_bucket(filter, tag);
+    filter->count++;
+    if (libcache_filter_put(filter, bucket, fingerprint)) {
+        return TRUE;
+    }
+    bucket = libcache_filter_alternate(filter, bucket, fingerprint);
+    if (libcache_filter_put(filter, bucket, fingerprint)) {
+        return TRUE;
+    }
+
+    // Note: both buckets are full, a fingerprint is kicked to its other bucket, and so on
+    int kicks;
+    for (kicks = 0; kicks < LIBCACHE_FILTER_MAX_KICKS; kicks++) {
+        uint16_t* slot = &filter->buckets[bucket][filter->kick];
+        filter->kick = (filter->kick + 1) % LIBCACHE_FILTER_SLOTS;
+        uint16_t kicked = *slot;
+        *slot = fingerprint;
+        fingerprint = kicked;
+        bucket = libcache_filter_alternate(filter, bucket, fingerprint);
+        if (libcache_filter_put(filter, bucket, fingerprint)) {
+            return TRUE;
+        }
+    }
+
+    // Note: the fingerprint left has no slot, its key would be found absent, so every key is present from now on
+    DEBUG_INFO("the filter overflowed with %u keys", filter->count);
+    filter->overflowed = TRUE;
+    return FALSE;
+}
+
+void libcache_filter_remove(libcache_filter_t* filter, uint32_t tag)
+{
+    uint16_t fingerprint = libcache_filter_fingerprint(tag);
+    uint32_t bucket = libcache_filter_bucket(filter, tag);
+    int round;
+    for (round = 0; round < 2; round++, bucket = libcache_filter_alternate(filter, bucket, fingerprint)) {
+        uint16_t* slots = filter->buckets[bucket];
+        int i;
+        for (i = 0; i < LIBCACHE_FILTER_SLOTS; i++) {
+            if (slots[i] == fingerprint) {
+                slots[i] = 0;
+                filter->count--;
+                return;
+            }
+        }
+    }
+    // Note: it's the fingerprint left without a slot when the filter overflowed
+    filter->count--;
+}
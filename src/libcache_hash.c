@@ -0,0 +1,57 @@
+/*
+ * libcache_hash.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "libcache_hash.h"
+
+#if !(defined(__SSE4_2__) && defined(__x86_64__) || defined(__ARM_FEATURE_CRC32) && defined(__aarch64__))
+// Note: CRC32C (reflected 0x82f63b78) of every nibble, 2 lookups a byte keep the table in one cache line
+static const uint32_t libcache_crc32c_nibble[16] = {
+    0x00000000, 0x105ec76f, 0x20bd8ede, 0x30e349b1, 0x417b1dbc, 0x5125dad3, 0x61c69362, 0x7198540d,
+    0x82f63b78, 0x92a8fc17, 0xa24bb5a6, 0xb21572c9, 0xc38d26c4, 0xd3d3e1ab, 0xe330a81a, 0xf36e6f75,
+};
+
+static uint32_t libcache_hash_crc32c_soft(const void* key, size_t length)
+{
+    const uint8_t* p = (const uint8_t*) key;
+    uint32_t crc = 0xffffffffU;
+    for (; length > 0; length--, p++) {
+        crc ^= *p;
+        crc = (crc >> 4) ^ libcache_crc32c_nibble[crc & 15];
+        crc = (crc >> 4) ^ libcache_crc32c_nibble[crc & 15];
+    }
+    return ~crc;
+}
+#endif
+
+#if defined(__x86_64__) && !defined(__SSE4_2__)
+__attribute__((target("sse4.2")))
+static uint32_t libcache_hash_crc32c_sse42(const void* key, size_t length)
+{
+    const uint8_t* p = (const uint8_t*) key;
+    unsigned long long crc = 0xffffffffU;
+    for (; length >= 8; length -= 8, p += 8) {
+        crc = __builtin_ia32_crc32di(crc, libcache_hash_read64(p));
+    }
+    for (; length > 0; length--, p++) {
+        crc = __builtin_ia32_crc32qi((unsigned int) crc, *p);
+    }
+    return ~(uint32_t) crc;
+}
+#endif
+
+uint32_t libcache_hash_crc32c_any(const void* key, size_t length)
+{
+#if defined(__SSE4_2__) && defined(__x86_64__) || defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    return libcache_hash_crc32c(key, length);
+#elif defined(__x86_64__)
+    if (likely(__builtin_cpu_supports("sse4.2"))) {
+        return libcache_hash_crc32c_sse42(key, length);
+    }
+    return libcache_hash_crc32c_soft(key, length);
+#else
+    return libcache_hash_crc32c_soft(key, length);
+#endif
+}
@@ -0,0 +1,96 @@
+/*
+ * libcache_local.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libcache_local.h"
+#include "libcache_memory.h"
+
+typedef struct libcache_local_t {
+    LIBCACHE_FREE_MEMORY* free_memory;
+    uint32_t workers;
+    void* caches[];     /* cache of every worker, NULL for a worker without one */
+} libcache_local_t;
+
+void* libcache_local_create(const libcache_attr_t* attr, uint32_t workers, LIBCACHE_WORKER_SOCKET* worker_socket)
+{
+    if (unlikely(NULL == attr || 0 == workers)) {
+        DEBUG_ERROR("input parameter %s is invalid", "attr or workers");
+        return NULL;
+    }
+    if (unlikely(!libcache_memory_allocator(attr) || NULL == attr->free_memory)) {
+        DEBUG_ERROR("input parameter %s is null", "attr function");
+        return NULL;
+    }
+    if (unlikely(NULL != attr->replication)) {
+        DEBUG_ERROR("argument %s isn't supported by a local cache set", "replication");
+        return NULL;
+    }
+
+    libcache_local_t* local_ptr = (libcache_local_t*) libcache_memory_allocate(attr,
+            sizeof(libcache_local_t) + sizeof(void*) * workers);
+    if (unlikely(NULL == local_ptr)) {
+        DEBUG_ERROR("failed to allocate %s", "local cache set");
+        return NULL;
+    }
+    local_ptr->free_memory = attr->free_memory;
+    local_ptr->workers = workers;
+    memset(local_ptr->caches, 0, sizeof(void*) * workers);
+
+    // Note: the memory of every cache is on the socket of its worker, so the worker's lookups stay local
+    libcache_attr_t worker_attr = *attr;
+    uint32_t i;
+    for (i = 0; i < workers; i++) {
+        if (NULL != worker_socket) {
+            int socket = worker_socket(i);
+            if (socket == LIBCACHE_WORKER_NONE) {
+                continue;
+            }
+            worker_attr.numa_node_mask = (socket >= 0 && socket < 64) ? (uint64_t) 1 << socket : 0;
+        }
+        local_ptr->caches[i] = libcache_create_ex(&worker_attr);
+        if (unlikely(NULL == local_ptr->caches[i])) {
+            DEBUG_ERROR("failed to create cache of worker %u", i);
+            libcache_local_destroy(local_ptr);
+            return NULL;
+        }
+    }
+    return local_ptr;
+}
+
+void* libcache_local_get(const void* local, uint32_t worker)
+{
+    const libcache_local_t* local_ptr = (const libcache_local_t*) local;
+    if (unlikely(NULL == local_ptr || worker >= local_ptr->workers)) {
+        return NULL;
+    }
+    return local_ptr->caches[worker];
+}
+
+uint32_t libcache_local_get_workers(const void* local)
+{
+    const libcache_local_t* local_ptr = (const libcache_local_t*) local;
+    return (NULL == local_ptr) ? 0 : local_ptr->workers;
+}
+
+libcache_ret_t libcache_local_destroy(void* local)
+{
+    libcache_local_t* local_ptr = (libcache_local_t*) local;
+    if (unlikely(NULL == local_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "local");
+        return LIBCACHE_FAILURE;
+    }
+
+    uint32_t i;
+    for (i = 0; i < local_ptr->workers; i++) {
+        if (local_ptr->caches[i] != NULL) {
+            libcache_destroy(local_ptr->caches[i]);
+        }
+    }
+    local_ptr->free_memory(local_ptr);
+    return LIBCACHE_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/*
+ * libcache_memory.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+// Note: MAP_ANONYMOUS, MAP_HUGETLB, madvise, shm_open and syscall are not in C99
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "libcache_memory.h"
+#include "libcache.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// Note: older kernels take it as a hint only, the mapped address is always checked
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define LIBCACHE_MPOL_BIND 2
+
+static size_t libcache_memory_page_size(libcache_page_e page_type)
+{
+    switch (page_type) {
+    case LIBCACHE_PAGE_HUGE_1G:
+        return (size_t) 1 << 30;
+    case LIBCACHE_PAGE_HUGE_2M:
+        return (size_t) 1 << 21;
+    default:
+        return (size_t) sysconf(_SC_PAGESIZE);
+    }
+}
+
+// Note: munmap of huge pages needs the length rounded up to page size
+static size_t libcache_memory_length(size_t length, libcache_page_e page_type)
+{
+    size_t page_size = libcache_memory_page_size(page_type);
+    return (length + page_size - 1) / page_size * page_size;
+}
+
+int libcache_memory_allocator(const libcache_attr_t* attr)
+{
+    return NULL != attr->allocate_memory || NULL != attr->allocate_memory_on;
+}
+
+void* libcache_memory_allocate(const libcache_attr_t* attr, size_t length)
+{
+    if (NULL == attr->allocate_memory_on) {
+        return attr->allocate_memory(length);
+    }
+    int socket = (attr->numa_node_mask != 0) ? __builtin_ctzll(attr->numa_node_mask) : -1;
+    return attr->allocate_memory_on(length, LIBCACHE_CACHE_LINE_SIZE, socket);
+}
+
+void* libcache_memory_map(size_t length, libcache_page_e page_type, uint64_t numa_node_mask,
+        libcache_page_e* mapped_page_type)
+{
+    if (unlikely(page_type == LIBCACHE_PAGE_USER || page_type > LIBCACHE_PAGE_HUGE_1G)) {
+        DEBUG_ERROR("page type %d is invalid", page_type);
+        return NULL;
+    }
+
+    void* memory = MAP_FAILED;
+    libcache_page_e type = page_type;
+
+    // Note: huge pages must be reserved by system, try smaller pages if there aren't free ones
+    for (; type >= LIBCACHE_PAGE_HUGE_2M && memory == MAP_FAILED; type--) {
+        int huge_flag = (type == LIBCACHE_PAGE_HUGE_1G) ? MAP_HUGE_1GB : MAP_HUGE_2MB;
+        memory = mmap(NULL, libcache_memory_length(length, type), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge_flag, -1, 0);
+    }
+    if (memory != MAP_FAILED) {
+        type++;
+    } else {
+        memory = mmap(NULL, libcache_memory_length(length, LIBCACHE_PAGE_NORMAL), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (unlikely(memory == MAP_FAILED)) {
+            DEBUG_ERROR("failed to map %zu bytes", length);
+            return NULL;
+        }
+        type = LIBCACHE_PAGE_NORMAL;
+        if (page_type >= LIBCACHE_PAGE_TRANSPARENT && 0 == madvise(memory, libcache_memory_length(length, LIBCACHE_PAGE_NORMAL), MADV_HUGEPAGE)) {
+            type = LIBCACHE_PAGE_TRANSPARENT;
+        }
+    }
+
+    // Note: bind before any page is touched, pages are allocated on the nodes when first written
+    if (numa_node_mask != 0) {
+        unsigned long node_mask = (unsigned long) numa_node_mask;
+        if (0 != syscall(SYS_mbind, memory, libcache_memory_length(length, type), LIBCACHE_MPOL_BIND,
+                &node_mask, sizeof(node_mask) * 8, 0)) {
+            DEBUG_ERROR("failed to bind memory to NUMA nodes 0x%llx", (unsigned long long) numa_node_mask);
+            munmap(memory, libcache_memory_length(length, type));
+            return NULL;
+        }
+    }
+
+    *mapped_page_type = type;
+    return memory;
+}
+
+void libcache_memory_unmap(void* memory, size_t length, libcache_page_e mapped_page_type)
+{
+    if (likely(memory != NULL)) {
+        munmap(memory, libcache_memory_length(length, mapped_page_type));
+    }
+}
+
+void* libcache_memory_map_shared(const char* name, size_t length)
+{
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        DEBUG_ERROR("failed to create shared memory %s", name);
+        return NULL;
+    }
+
+    void* memory = MAP_FAILED;
+    if (0 == ftruncate(fd, (off_t) length)) {
+        memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+        DEBUG_ERROR("failed to map shared memory %s of %zu bytes", name, length);
+        shm_unlink(name);
+        return NULL;
+    }
+    return memory;
+}
+
+void* libcache_memory_attach_shared(const char* name, void* address, size_t* length)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        DEBUG_ERROR("failed to open shared memory %s", name);
+        return NULL;
+    }
+
+    struct stat file_stat;
+    void* memory = MAP_FAILED;
+    if (0 == fstat(fd, &file_stat) && file_stat.st_size > 0) {
+        memory = mmap(address, (size_t) file_stat.st_size, PROT_READ,
+                MAP_SHARED | ((address != NULL) ? MAP_FIXED_NOREPLACE : 0), fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+        DEBUG_ERROR("failed to map shared memory %s", name);
+        return NULL;
+    }
+    if (address != NULL && memory != address) {
+        DEBUG_ERROR("address %p of shared memory %s is in use", address, name);
+        munmap(memory, (size_t) file_stat.st_size);
+        return NULL;
+    }
+
+    *length = (size_t) file_stat.st_size;
+    return memory;
+}
+
+void libcache_memory_unmap_shared(void* memory, size_t length, const char* name)
+{
+    // Note: name may be in the memory
+    if (name != NULL) {
+        shm_unlink(name);
+    }
+    if (likely(memory != NULL)) {
+        munmap(memory, length);
+    }
+}
+
+const void* libcache_memory_map_file(const char* path, size_t* length)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        DEBUG_ERROR("failed to open %s", path);
+        return NULL;
+    }
+
+    struct stat file_stat;
+    void* memory = MAP_FAILED;
+    if (0 == fstat(fd, &file_stat) && file_stat.st_size > 0) {
+        memory = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+        DEBUG_ERROR("failed to map %s", path);
+        return NULL;
+    }
+
+    // Note: the file is read once from its start, a hint lets the kernel read ahead further
+    madvise(memory, (size_t) file_stat.st_size, MADV_SEQUENTIAL);
+    *length = (size_t) file_stat.st_size;
+    return memory;
+}
+
+void libcache_memory_unmap_file(const void* memory, size_t length)
+{
+    if (likely(memory != NULL)) {
+        munmap((void*) (uintptr_t) memory, length);
+    }
+}
@@ -0,0 +1,479 @@
+/*
+ * libcache_policy.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "libcache_policy.h"
+
+#define POLICY_STATE(node) (LIBCACHE_POLICY_ENTRY(node)->state)
+
+/*
+ * LRU: move to front of list on every hit, swap out list back.
+ */
+typedef struct policy_lru_t {
+    list_t list;
+} policy_lru_t;
+
+static size_t policy_lru_data_size(libcache_scale_t max_entry_number)
+{
+    return sizeof(policy_lru_t);
+}
+
+static void policy_lru_init(void* data, libcache_scale_t max_entry_number)
+{
+    list_init(&((policy_lru_t*) data)->list);
+}
+
+static void policy_lru_on_insert(void* data, node_t* node)
+{
+    list_push_front(&((policy_lru_t*) data)->list, node);
+}
+
+static void policy_lru_on_hit(void* data, node_t* node)
+{
+    list_swap_to_head(&((policy_lru_t*) data)->list, node);
+}
+
+static void policy_lru_on_remove(void* data, node_t* node)
+{
+    list_remove(&((policy_lru_t*) data)->list, node);
+}
+
+static node_t* policy_lru_select_victim(void* data)
+{
+    return list_back(&((policy_lru_t*) data)->list);
+}
+
+/*
+ * FIFO: same as LRU, but hit doesn't change the order.
+ */
+static void policy_fifo_on_hit(void* data, node_t* node)
+{
+}
+
+/*
+ * CLOCK: set reference bit on hit, the clock hand moves from list back to front circularly,
+ * clears reference bits on the way and stops at an unreferenced entry.
+ */
+#define CLOCK_REFERENCED 1
+
+typedef struct policy_clock_t {
+    list_t list;
+    node_t* hand; /* next node to check, NULL means list back */
+} policy_clock_t;
+
+static size_t policy_clock_data_size(libcache_scale_t max_entry_number)
+{
+    return sizeof(policy_clock_t);
+}
+
+static void policy_clock_init(void* data, libcache_scale_t max_entry_number)
+{
+    policy_clock_t* clock = (policy_clock_t*) data;
+    list_init(&clock->list);
+    clock->hand = NULL;
+}
+
+static void policy_clock_on_insert(void* data, node_t* node)
+{
+    list_push_front(&((policy_clock_t*) data)->list, node);
+}
+
+static void policy_clock_on_hit(void* data, node_t* node)
+{
+    POLICY_STATE(node) |= CLOCK_REFERENCED;
+}
+
+static void policy_clock_on_remove(void* data, node_t* node)
+{
+    policy_clock_t* clock = (policy_clock_t*) data;
+    if (unlikely(clock->hand == node)) {
+        clock->hand = node->previous_node;
+    }
+    list_remove(&clock->list, node);
+}
+
+static node_t* policy_clock_select_victim(void* data)
+{
+    policy_clock_t* clock = (policy_clock_t*) data;
+    node_t* node = clock->hand ? clock->hand : list_back(&clock->list);
+    while (node) {
+        if (0 == (POLICY_STATE(node) & CLOCK_REFERENCED)) {
+            break;
+        }
+        POLICY_STATE(node) &= ~CLOCK_REFERENCED;
+        node = node->previous_node ? node->previous_node : list_back(&clock->list);
+    }
+
+    if (node) {
+        clock->hand = node->previous_node;
+    }
+    return node;
+}
+
+/*
+ * Segmented LRU: a new entry is put into probation segment, a hit in probation promotes
+ * the entry into protected segment (80% of entries), the protected list back is demoted
+ * to probation when protected segment is full. Swap out probation back firstly.
+ */
+#define SLRU_PROBATION 0
+#define SLRU_PROTECTED 1
+#define SLRU_PROTECTED_PERCENT 80
+
+typedef struct policy_slru_t {
+    list_t probation;
+    list_t protect;
+    libcache_scale_t protect_max;
+} policy_slru_t;
+
+static void policy_slru_push_protect(list_t* probation, list_t* protect, libcache_scale_t protect_max, node_t* node)
+{
+    POLICY_STATE(node) = SLRU_PROTECTED;
+    list_push_front(protect, node);
+    if (list_size(protect) > protect_max) {
+        node_t* demoted = list_pop_back(protect);
+        POLICY_STATE(demoted) = SLRU_PROBATION;
+        list_push_front(probation, demoted);
+    }
+}
+
+static size_t policy_slru_data_size(libcache_scale_t max_entry_number)
+{
+    return sizeof(policy_slru_t);
+}
+
+static void policy_slru_init(void* data, libcache_scale_t max_entry_number)
+{
+    policy_slru_t* slru = (policy_slru_t*) data;
+    list_init(&slru->probation);
+    list_init(&slru->protect);
+    slru->protect_max = (libcache_scale_t) ((uint64_t) max_entry_number * SLRU_PROTECTED_PERCENT / 100);
+    if (slru->protect_max == 0) {
+        slru->protect_max = 1;
+    }
+}
+
+static void policy_slru_on_insert(void* data, node_t* node)
+{
+    policy_slru_t* slru = (policy_slru_t*) data;
+    if (POLICY_STATE(node) == SLRU_PROTECTED) {
+        policy_slru_push_protect(&slru->probation, &slru->protect, slru->protect_max, node);
+    } else {
+        list_push_front(&slru->probation, node);
+    }
+}
+
+static void policy_slru_on_hit(void* data, node_t* node)
+{
+    policy_slru_t* slru = (policy_slru_t*) data;
+    if (POLICY_STATE(node) == SLRU_PROTECTED) {
+        list_swap_to_head(&slru->protect, node);
+    } else {
+        list_remove(&slru->probation, node);
+        policy_slru_push_protect(&slru->probation, &slru->protect, slru->protect_max, node);
+    }
+}
+
+static void policy_slru_on_remove(void* data, node_t* node)
+{
+    policy_slru_t* slru = (policy_slru_t*) data;
+    list_remove((POLICY_STATE(node) == SLRU_PROTECTED) ? &slru->protect : &slru->probation, node);
+}
+
+static node_t* policy_slru_select_victim(void* data)
+{
+    policy_slru_t* slru = (policy_slru_t*) data;
+    node_t* node = list_back(&slru->probation);
+    return node ? node : list_back(&slru->protect);
+}
+
+/*
+ * W-TinyLFU: a small LRU window (1%) admits new entries, and the main space is a segmented LRU.
+ * When the window is full, its back is a candidate of main space, it's admitted only if it's
+ * accessed more frequently than main space's victim according to a count-min sketch.
+ * The sketch has 4 rows of 4 bits counters, all counters are halved after every
+ * 10 * max_entry_number accesses, so old frequency fades out.
+ */
+#define TINYLFU_WINDOW      0
+#define TINYLFU_PROBATION   1
+#define TINYLFU_PROTECTED   2
+#define TINYLFU_WINDOW_PERCENT 1
+#define TINYLFU_SKETCH_DEPTH 4
+#define TINYLFU_SKETCH_MAX_COUNT 15
+#define TINYLFU_SAMPLE_FACTOR 10
+#define TINYLFU_MIN_WIDTH_BITS 4
+
+typedef struct policy_tinylfu_t {
+    list_t window;
+    list_t probation;
+    list_t protect;
+    libcache_scale_t window_max;
+    libcache_scale_t main_max;
+    libcache_scale_t protect_max;
+    uint32_t sample_count;
+    uint32_t sample_max;
+    int width_bits;
+    uint8_t sketch[]; /* TINYLFU_SKETCH_DEPTH rows of 2^width_bits 4 bits counters */
+} policy_tinylfu_t;
+
+static const uint32_t tinylfu_seeds[TINYLFU_SKETCH_DEPTH] = { 0x9e3779b1, 0x85ebca6b, 0xc2b2ae35, 0x27d4eb2f };
+
+static int policy_tinylfu_width_bits(libcache_scale_t max_entry_number)
+{
+    int bits = TINYLFU_MIN_WIDTH_BITS;
+    while (((uint64_t) 1 << bits) < max_entry_number) {
+        bits++;
+    }
+    return bits;
+}
+
+static inline size_t policy_tinylfu_sketch_length(int width_bits)
+{
+    // Note: 2 counters per byte
+    return (((size_t) TINYLFU_SKETCH_DEPTH) << width_bits) / 2;
+}
+
+static inline uint32_t policy_tinylfu_counter_index(const policy_tinylfu_t* lfu, uint32_t hash, int row)
+{
+    uint32_t column = ((hash ^ (hash >> 15)) * tinylfu_seeds[row]) >> (32 - lfu->width_bits);
+    return ((uint32_t) row << lfu->width_bits) + column;
+}
+
+static inline uint32_t policy_tinylfu_counter_get(const policy_tinylfu_t* lfu, uint32_t index)
+{
+    return (lfu->sketch[index >> 1] >> ((index & 1) << 2)) & 0xf;
+}
+
+static uint32_t policy_tinylfu_frequency(const policy_tinylfu_t* lfu, uint32_t hash)
+{
+    uint32_t frequency = TINYLFU_SKETCH_MAX_COUNT;
+    int row;
+    for (row = 0; row < TINYLFU_SKETCH_DEPTH; row++) {
+        uint32_t count = policy_tinylfu_counter_get(lfu, policy_tinylfu_counter_index(lfu, hash, row));
+        if (count < frequency) {
+            frequency = count;
+        }
+    }
+    return frequency;
+}
+
+static void policy_tinylfu_increment(policy_tinylfu_t* lfu, uint32_t hash)
+{
+    int row;
+    for (row = 0; row < TINYLFU_SKETCH_DEPTH; row++) {
+        uint32_t index = policy_tinylfu_counter_index(lfu, hash, row);
+        if (policy_tinylfu_counter_get(lfu, index) < TINYLFU_SKETCH_MAX_COUNT) {
+            lfu->sketch[index >> 1] += (uint8_t) (1 << ((index & 1) << 2));
+        }
+    }
+
+    if (unlikely(++lfu->sample_count >= lfu->sample_max)) {
+        // Note: halve all counters
+        size_t i;
+        size_t length = policy_tinylfu_sketch_length(lfu->width_bits);
+        for (i = 0; i < length; i++) {
+            lfu->sketch[i] = (lfu->sketch[i] >> 1) & 0x77;
+        }
+        lfu->sample_count /= 2;
+    }
+}
+
+static inline list_t* policy_tinylfu_list(policy_tinylfu_t* lfu, node_t* node)
+{
+    switch (POLICY_STATE(node)) {
+    case TINYLFU_PROBATION:
+        return &lfu->probation;
+    case TINYLFU_PROTECTED:
+        return &lfu->protect;
+    default:
+        return &lfu->window;
+    }
+}
+
+static size_t policy_tinylfu_data_size(libcache_scale_t max_entry_number)
+{
+    return sizeof(policy_tinylfu_t) + policy_tinylfu_sketch_length(policy_tinylfu_width_bits(max_entry_number));
+}
+
+static void policy_tinylfu_init(void* data, libcache_scale_t max_entry_number)
+{
+    policy_tinylfu_t* lfu = (policy_tinylfu_t*) data;
+    list_init(&lfu->window);
+    list_init(&lfu->probation);
+    list_init(&lfu->protect);
+    lfu->window_max = (libcache_scale_t) ((uint64_t) max_entry_number * TINYLFU_WINDOW_PERCENT / 100);
+    if (lfu->window_max == 0) {
+        lfu->window_max = 1;
+    }
+    lfu->main_max = (max_entry_number > lfu->window_max) ? max_entry_number - lfu->window_max : 1;
+    lfu->protect_max = (libcache_scale_t) ((uint64_t) lfu->main_max * SLRU_PROTECTED_PERCENT / 100);
+    if (lfu->protect_max == 0) {
+        lfu->protect_max = 1;
+    }
+    lfu->sample_count = 0;
+    lfu->sample_max = ((uint64_t) max_entry_number * TINYLFU_SAMPLE_FACTOR > UINT32_MAX) ?
+            UINT32_MAX : max_entry_number * TINYLFU_SAMPLE_FACTOR;
+    lfu->width_bits = policy_tinylfu_width_bits(max_entry_number);
+    memset(lfu->sketch, 0, policy_tinylfu_sketch_length(lfu->width_bits));
+}
+
+static void policy_tinylfu_push_protect(policy_tinylfu_t* lfu, node_t* node)
+{
+    POLICY_STATE(node) = TINYLFU_PROTECTED;
+    list_push_front(&lfu->protect, node);
+    if (list_size(&lfu->protect) > lfu->protect_max) {
+        node_t* demoted = list_pop_back(&lfu->protect);
+        POLICY_STATE(demoted) = TINYLFU_PROBATION;
+        list_push_front(&lfu->probation, demoted);
+    }
+}
+
+static void policy_tinylfu_on_insert(void* data, node_t* node)
+{
+    policy_tinylfu_t* lfu = (policy_tinylfu_t*) data;
+    policy_tinylfu_increment(lfu, LIBCACHE_POLICY_ENTRY(node)->hash);
+
+    if (POLICY_STATE(node) == TINYLFU_PROTECTED) {
+        policy_tinylfu_push_protect(lfu, node);
+        return;
+    }
+    list_push_front(policy_tinylfu_list(lfu, node), node);
+
+    // Note: window overflows into main space directly while main space isn't full
+    if (list_size(&lfu->window) > lfu->window_max
+            && list_size(&lfu->probation) + list_size(&lfu->protect) < lfu->main_max) {
+        node_t* candidate = list_pop_back(&lfu->window);
+        POLICY_STATE(candidate) = TINYLFU_PROBATION;
+        list_push_front(&lfu->probation, candidate);
+    }
+}
+
+static void policy_tinylfu_on_hit(void* data, node_t* node)
+{
+    policy_tinylfu_t* lfu = (policy_tinylfu_t*) data;
+    policy_tinylfu_increment(lfu, LIBCACHE_POLICY_ENTRY(node)->hash);
+
+    switch (POLICY_STATE(node)) {
+    case TINYLFU_PROBATION:
+        list_remove(&lfu->probation, node);
+        policy_tinylfu_push_protect(lfu, node);
+        break;
+    case TINYLFU_PROTECTED:
+        list_swap_to_head(&lfu->protect, node);
+        break;
+    default:
+        list_swap_to_head(&lfu->window, node);
+        break;
+    }
+}
+
+static void policy_tinylfu_on_remove(void* data, node_t* node)
+{
+    policy_tinylfu_t* lfu = (policy_tinylfu_t*) data;
+    list_remove(policy_tinylfu_list(lfu, node), node);
+}
+
+static node_t* policy_tinylfu_select_victim(void* data)
+{
+    policy_tinylfu_t* lfu = (policy_tinylfu_t*) data;
+    node_t* victim = list_back(&lfu->probation);
+    if (victim == NULL) {
+        victim = list_back(&lfu->protect);
+    }
+
+    node_t* candidate = list_back(&lfu->window);
+    if (candidate == NULL || (victim != NULL && list_size(&lfu->window) <= lfu->window_max)) {
+        return victim;
+    }
+    if (victim == NULL) {
+        return candidate;
+    }
+
+    // Note: the window candidate competes with main space victim, the loser is swapped out
+    if (policy_tinylfu_frequency(lfu, LIBCACHE_POLICY_ENTRY(candidate)->hash)
+            > policy_tinylfu_frequency(lfu, LIBCACHE_POLICY_ENTRY(victim)->hash)) {
+        list_remove(&lfu->window, candidate);
+        POLICY_STATE(candidate) = TINYLFU_PROBATION;
+        list_push_front(&lfu->probation, candidate);
+        return victim;
+    }
+    return candidate;
+}
+
+static const libcache_policy_ops_t policy_lru = {
+        "lru",
+        policy_lru_data_size,
+        policy_lru_init,
+        policy_lru_on_insert,
+        policy_lru_on_hit,
+        policy_lru_on_remove,
+        policy_lru_select_victim,
+        policy_lru_on_remove,
+};
+
+static const libcache_policy_ops_t policy_clock = {
+        "clock",
+        policy_clock_data_size,
+        policy_clock_init,
+        policy_clock_on_insert,
+        policy_clock_on_hit,
+        policy_clock_on_remove,
+        policy_clock_select_victim,
+        policy_clock_on_remove,
+};
+
+static const libcache_policy_ops_t policy_fifo = {
+        "fifo",
+        policy_lru_data_size,
+        policy_lru_init,
+        policy_lru_on_insert,
+        policy_fifo_on_hit,
+        policy_lru_on_remove,
+        policy_lru_select_victim,
+        policy_lru_on_remove,
+};
+
+static const libcache_policy_ops_t policy_slru = {
+        "slru",
+        policy_slru_data_size,
+        policy_slru_init,
+        policy_slru_on_insert,
+        policy_slru_on_hit,
+        policy_slru_on_remove,
+        policy_slru_select_victim,
+        policy_slru_on_remove,
+};
+
+static const libcache_policy_ops_t policy_tinylfu = {
+        "tinylfu",
+        policy_tinylfu_data_size,
+        policy_tinylfu_init,
+        policy_tinylfu_on_insert,
+        policy_tinylfu_on_hit,
+        policy_tinylfu_on_remove,
+        policy_tinylfu_select_victim,
+        policy_tinylfu_on_remove,
+};
+
+const libcache_policy_ops_t* libcache_policy_get(libcache_policy_e policy)
+{
+    switch (policy) {
+    case LIBCACHE_POLICY_LRU:
+        return &policy_lru;
+    case LIBCACHE_POLICY_CLOCK:
+        return &policy_clock;
+    case LIBCACHE_POLICY_FIFO:
+        return &policy_fifo;
+    case LIBCACHE_POLICY_SLRU:
+        return &policy_slru;
+    case LIBCACHE_POLICY_TINYLFU:
+        return &policy_tinylfu;
+    default:
+        DEBUG_ERROR("unknown policy %d", policy);
+        return NULL;
+    }
+}
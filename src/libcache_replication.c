@@ -0,0 +1,277 @@
+/*
+ * libcache_replication.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libcache_replication.h"
+#include "libcache.h"
+#include "libcache_memory.h"
+
+/*
+ *  @brief libcache_replication_t  | libcache_replication_t | slots |, mapped as a whole, every slot takes
+ *                                 the largest record. Fields of the producer and of the consumer are in lines
+ *                                 of their own, each one reads the other's index only when its copy runs out.
+ *
+ *  @field head             slots put, written by the producer.
+ *  @field tail_seen        tail the producer last read.
+ *  @field tail             slots consumed, written by the consumer.
+ */
+typedef struct libcache_replication_t
+{
+    uint64_t head __attribute__((aligned(LIBCACHE_CACHE_LINE_SIZE)));
+    uint64_t tail_seen;
+    uint64_t sequence;
+    uint64_t dropped;
+    uint64_t tail __attribute__((aligned(LIBCACHE_CACHE_LINE_SIZE)));
+    size_t memory_length __attribute__((aligned(LIBCACHE_CACHE_LINE_SIZE)));
+    libcache_page_e page_type;
+    uint64_t slot_mask;
+    size_t slot_size;
+    size_t key_size;
+    size_t entry_size;
+    char* slots;
+} libcache_replication_t;
+
+static inline size_t libcache_replication_align(size_t length)
+{
+    return (length + LIBCACHE_REPLICATION_ALIGN - 1) & ~((size_t) LIBCACHE_REPLICATION_ALIGN - 1);
+}
+
+static inline libcache_replication_record_t* libcache_replication_slot(const libcache_replication_t* ring,
+        uint64_t index)
+{
+    return (libcache_replication_record_t*) (ring->slots + (index & ring->slot_mask) * ring->slot_size);
+}
+
+void* libcache_replication_create(uint32_t capacity, size_t key_size, size_t entry_size)
+{
+    if (unlikely(0 == capacity || capacity > (1U << 31) || 0 == key_size || key_size > UINT16_MAX
+            || entry_size > UINT32_MAX)) {
+        DEBUG_ERROR("input parameter %s is invalid", "capacity or key_size or entry_size");
+        return NULL;
+    }
+
+    uint64_t slot_number = 1;
+    while (slot_number < capacity) {
+        slot_number <<= 1;
+    }
+    size_t slot_size = libcache_replication_align(sizeof(libcache_replication_record_t) + key_size + entry_size);
+    size_t slots_offset = libcache_replication_align(sizeof(libcache_replication_t));
+    size_t memory_length = slots_offset + (size_t) slot_number * slot_size;
+    libcache_page_e page_type = LIBCACHE_PAGE_NORMAL;
+    char* memory = (char*) libcache_memory_map(memory_length, LIBCACHE_PAGE_NORMAL, 0, &page_type);
+    if (unlikely(NULL == memory)) {
+        DEBUG_ERROR("failed to map %zu bytes for the replication ring", memory_length);
+        return NULL;
+    }
+
+    // Note: the memory is filled with 0, the ring is empty and the first sequence number is 0
+    libcache_replication_t* ring = (libcache_replication_t*) memory;
+    ring->memory_length = memory_length;
+    ring->page_type = page_type;
+    ring->slot_mask = slot_number - 1;
+    ring->slot_size = slot_size;
+    ring->key_size = key_size;
+    ring->entry_size = entry_size;
+    ring->slots = memory + slots_offset;
+    return ring;
+}
+
+void libcache_replication_destroy(void* ring)
+{
+    libcache_replication_t* ring_ptr = (libcache_replication_t*) ring;
+    if (unlikely(NULL == ring_ptr)) {
+        return;
+    }
+    libcache_memory_unmap(ring_ptr, ring_ptr->memory_length, ring_ptr->page_type);
+}
+
+size_t libcache_replication_get_key_size(const void* ring)
+{
+    return (NULL == ring) ? 0 : ((const libcache_replication_t*) ring)->key_size;
+}
+
+size_t libcache_replication_get_entry_size(const void* ring)
+{
+    return (NULL == ring) ? 0 : ((const libcache_replication_t*) ring)->entry_size;
+}
+
+uint64_t libcache_replication_get_sequence(const void* ring)
+{
+    return (NULL == ring) ? 0 : __atomic_load_n(&((const libcache_replication_t*) ring)->sequence, __ATOMIC_RELAXED);
+}
+
+uint64_t libcache_replication_get_dropped(const void* ring)
+{
+    return (NULL == ring) ? 0 : __atomic_load_n(&((const libcache_replication_t*) ring)->dropped, __ATOMIC_RELAXED);
+}
+
+size_t libcache_replication_get_record_size(const void* ring)
+{
+    return (NULL == ring) ? 0 : ((const libcache_replication_t*) ring)->slot_size;
+}
+
+void* libcache_replication_reserve(void* ring, libcache_replication_e type, libcache_evict_e reason,
+        const void* key, size_t entry_length, uint32_t argument)
+{
+    libcache_replication_t* ring_ptr = (libcache_replication_t*) ring;
+    uint64_t sequence = ring_ptr->sequence;
+    __atomic_store_n(&ring_ptr->sequence, sequence + 1, __ATOMIC_RELAXED);
+
+    // Note: the tail is read again only once the ring looks full by the copy, so the consumer's line stays put
+    uint64_t head = ring_ptr->head;
+    if (unlikely(head - ring_ptr->tail_seen > ring_ptr->slot_mask)) {
+        ring_ptr->tail_seen = __atomic_load_n(&ring_ptr->tail, __ATOMIC_ACQUIRE);
+    }
+    if (unlikely(head - ring_ptr->tail_seen > ring_ptr->slot_mask || entry_length > ring_ptr->entry_size)) {
+        __atomic_store_n(&ring_ptr->dropped, ring_ptr->dropped + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    libcache_replication_record_t* record = libcache_replication_slot(ring_ptr, head);
+    record->sequence = sequence;
+    record->type = (uint8_t) type;
+    record->reason = (uint8_t) reason;
+    record->key_size = (uint16_t) ring_ptr->key_size;
+    record->entry_length = (uint32_t) entry_length;
+    record->argument = argument;
+    record->length = (uint32_t) libcache_replication_align(sizeof(libcache_replication_record_t)
+            + ring_ptr->key_size + entry_length);
+    char* key_ptr = (char*) (record + 1);
+    if (NULL != key) {
+        memcpy(key_ptr, key, ring_ptr->key_size);
+    } else {
+        memset(key_ptr, 0, ring_ptr->key_size);
+    }
+    return key_ptr + ring_ptr->key_size;
+}
+
+void libcache_replication_commit(void* ring)
+{
+    libcache_replication_t* ring_ptr = (libcache_replication_t*) ring;
+    __atomic_store_n(&ring_ptr->head, ring_ptr->head + 1, __ATOMIC_RELEASE);
+}
+
+size_t libcache_replication_consume(void* ring, void* buffer, size_t length)
+{
+    libcache_replication_t* ring_ptr = (libcache_replication_t*) ring;
+    if (unlikely(NULL == ring_ptr || NULL == buffer)) {
+        DEBUG_ERROR("input parameter %s is null", "ring or buffer");
+        return 0;
+    }
+
+    uint64_t tail = ring_ptr->tail;
+    uint64_t head = __atomic_load_n(&ring_ptr->head, __ATOMIC_ACQUIRE);
+    size_t copied = 0;
+    while (tail != head) {
+        const libcache_replication_record_t* record = libcache_replication_slot(ring_ptr, tail);
+        if (record->length > length - copied) {
+            break;
+        }
+        memcpy((char*) buffer + copied, record, record->length);
+        copied += record->length;
+        tail++;
+    }
+    // Note: the slots copied are given back to the producer at once
+    __atomic_store_n(&ring_ptr->tail, tail, __ATOMIC_RELEASE);
+    return copied;
+}
+
+/*
+ *  @brief libcache_replication_add  adds the entry of a record, it replaces the entry of the same key.
+ */
+static libcache_ret_t libcache_replication_add(void* libcache, const libcache_replication_record_t* record,
+        const void* key, const void* entry)
+{
+    libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    int i;
+    for (i = 0; i < 2; i++) {
+        return_value = (0 != record->argument)
+                ? libcache_add_ttl(libcache, key, entry, record->entry_length, record->argument, NULL)
+                : libcache_add_ex(libcache, key, entry, record->entry_length, NULL);
+        if (LIBCACHE_EXISTING != return_value || 0 != i) {
+            break;
+        }
+        libcache_ret_t delete_value = libcache_delete_by_key(libcache, key);
+        if (LIBCACHE_SUCCESS != delete_value && LIBCACHE_NOT_FOUND != delete_value) {
+            return delete_value;
+        }
+    }
+    return return_value;
+}
+
+/*
+ *  @brief libcache_replication_apply_record  replays a record on the cache.
+ */
+static libcache_ret_t libcache_replication_apply_record(void* libcache, const libcache_replication_record_t* record,
+        const char* key)
+{
+    libcache_ret_t return_value = LIBCACHE_FAILURE;
+    switch (record->type) {
+    case LIBCACHE_REPLICATION_ADD:
+        return_value = libcache_replication_add(libcache, record, key, key + record->key_size);
+        break;
+    case LIBCACHE_REPLICATION_DELETE:
+        return_value = libcache_delete_by_key(libcache, key);
+        if (LIBCACHE_NOT_FOUND == return_value) {
+            return_value = LIBCACHE_SUCCESS;
+        }
+        break;
+    case LIBCACHE_REPLICATION_CLEAN:
+        return_value = libcache_clean(libcache);
+        break;
+    case LIBCACHE_REPLICATION_INVALIDATE_TAG:
+        return_value = libcache_invalidate_tag(libcache, record->argument);
+        break;
+    default:
+        DEBUG_ERROR("record %llu of unknown type %u", (unsigned long long) record->sequence, record->type);
+        break;
+    }
+    return return_value;
+}
+
+libcache_ret_t libcache_replication_apply(void* libcache, const void* batch, size_t length,
+        uint64_t* next_sequence)
+{
+    if (unlikely(NULL == libcache || (NULL == batch && 0 != length) || NULL == next_sequence)) {
+        DEBUG_ERROR("input parameter %s is null", "libcache or batch or next_sequence");
+        return LIBCACHE_FAILURE;
+    }
+
+    const char* position = (const char*) batch;
+    const char* end = position + length;
+    while (position != end) {
+        // Note: the header is copied out and checked before its key and entry are used
+        libcache_replication_record_t record;
+        if (unlikely((size_t) (end - position) < sizeof(record))) {
+            DEBUG_ERROR("batch ends inside a record");
+            return LIBCACHE_FAILURE;
+        }
+        memcpy(&record, position, sizeof(record));
+        size_t needed = sizeof(record) + record.key_size
+                + (LIBCACHE_REPLICATION_ADD == record.type ? record.entry_length : 0);
+        if (unlikely(record.length < needed || record.length > (size_t) (end - position))) {
+            DEBUG_ERROR("record %llu is corrupted", (unsigned long long) record.sequence);
+            return LIBCACHE_FAILURE;
+        }
+        if (record.sequence > *next_sequence) {
+            DEBUG_INFO("records from %llu are missing", (unsigned long long) *next_sequence);
+            return LIBCACHE_NOT_FOUND;
+        }
+        // Note: records before the expected one are in the image already, or were applied before
+        if (record.sequence == *next_sequence) {
+            libcache_ret_t return_value = libcache_replication_apply_record(libcache, &record,
+                    position + sizeof(record));
+            if (unlikely(LIBCACHE_SUCCESS != return_value)) {
+                return return_value;
+            }
+            (*next_sequence)++;
+        }
+        position += record.length;
+    }
+    return LIBCACHE_SUCCESS;
+}
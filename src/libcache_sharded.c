@@ -0,0 +1,1153 @@
+/*
+ * libcache_sharded.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+// Note: sched_getcpu is not in C99
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "libcache_sharded.h"
+#include "libcache_spinlock.h"
+#include "libcache_hash.h"
+#include "libcache_memory.h"
+
+#define LIBCACHE_SHARD_MAX_BITS 16
+#define LIBCACHE_SHARD_PRIME_32 0x85ebca6bUL /* differs from hash's, shard bits don't correlate with buckets */
+
+/*
+ * Every shard owns whole cache lines, so locks of different shards never share a line.
+ * seq is odd while a writer is changing hash or entries of the shard, see libcache_sharded_read.
+ */
+#define LIBCACHE_READ_RETRY 16
+
+typedef union libcache_shard_t {
+    struct {
+        libcache_spinlock_t lock;
+        uint32_t seq;
+        void* libcache;
+    } shard;
+    char padding[LIBCACHE_CACHE_LINE_SIZE];
+} libcache_shard_t;
+
+/*
+ * Hot keys, see libcache_attr_t.hot_keys. Lookups of every core are sampled 1 in LIBCACHE_HOT_SAMPLE into a
+ * space-saving sketch of key numbers, a key of 1/(2 * hot_keys) of the samples or more takes a slot of hot_keys,
+ * the one of the fewest samples. Every core has a table of replicas, replica i copies the entry of hot key i,
+ * tagged by its version. A change of a hot key bumps its version, so its replicas of every core are stale at once,
+ * only the lines of hot_keys are written by it. A hit reads hot_keys and the table of its core, it writes neither.
+ */
+#define LIBCACHE_HOT_SAMPLE 16      /* 1 in 16 lookups of a core is sampled */
+#define LIBCACHE_HOT_COUNTERS 64    /* counters of the sketch */
+#define LIBCACHE_HOT_WINDOW 4096    /* samples after which counts are halved, so keys cool down */
+#define LIBCACHE_HOT_MIN_COUNT 32   /* samples of a key at least to be hot */
+#define LIBCACHE_REPLICA_TABLE_MAX 1024
+#define LIBCACHE_LINE_ROUND(length) \
+        (((length) + LIBCACHE_CACHE_LINE_SIZE - 1) & ~((size_t) LIBCACHE_CACHE_LINE_SIZE - 1))
+
+/*
+ * Flat combining, see libcache_attr_t.combining. Every shard has a request slot per core, in lines of their own.
+ * A writer posts its request into the slot of its core and waits for it, the first writer taking the shard does
+ * every request posted to it meanwhile, under one lock and one change of seq, so the shard is written by one core
+ * in batches while its lock line stays there. A slot taken by another thread of the core isn't waited for,
+ * that writer locks the shard as usual.
+ */
+#define LIBCACHE_REQUEST_SLOTS_MAX 64
+
+typedef enum
+{
+    LIBCACHE_REQUEST_FREE = 0,
+    LIBCACHE_REQUEST_WRITING,   /* a writer is filling it */
+    LIBCACHE_REQUEST_POSTED,
+    LIBCACHE_REQUEST_DONE,
+}libcache_request_state_e;
+
+typedef enum
+{
+    LIBCACHE_REQUEST_ADD = 0,
+    LIBCACHE_REQUEST_DELETE_BY_KEY,
+    LIBCACHE_REQUEST_DELETE_ENTRY,
+    LIBCACHE_REQUEST_UNLOCK_ENTRY,
+}libcache_request_e;
+
+typedef struct libcache_request_data_t {
+    libcache_request_e op;
+    const void* key;
+    const void* src_entry;
+    void* entry;                /* of a delete or unlock, or the one added */
+    libcache_ret_t result;
+} libcache_request_data_t;
+
+typedef union libcache_request_t {
+    struct {
+        uint32_t state;         /* libcache_request_state_e */
+        libcache_request_data_t data;
+    } request;
+    char padding[LIBCACHE_CACHE_LINE_SIZE];
+} libcache_request_t;
+
+/*
+ *  @brief libcache_hot_key_t  a hot key, version is 0 if the slot is empty, odd while the key is replaced,
+ *                             it grows by 2 every time the entry of the key may change.
+ */
+typedef struct libcache_hot_key_t {
+    uint32_t version;
+    uint32_t number;
+} libcache_hot_key_t;
+
+typedef struct libcache_hot_counter_t {
+    uint32_t number;
+    uint32_t count;
+} libcache_hot_counter_t;
+
+/*
+ *  @brief libcache_hot_sketch_t  counters of sampled key numbers, a sample is skipped if the lock is taken.
+ */
+typedef struct libcache_hot_sketch_t {
+    libcache_spinlock_t lock;
+    uint32_t total;
+    uint32_t used;
+    libcache_hot_counter_t counters[LIBCACHE_HOT_COUNTERS];
+} libcache_hot_sketch_t;
+
+/*
+ *  @brief libcache_replica_table_t  | libcache_replica_table_t | replicas |, one per core, written by its threads.
+ */
+typedef union libcache_replica_table_t {
+    struct {
+        uint32_t lookups;
+        unsigned long long hits;
+    } table;
+    char padding[LIBCACHE_CACHE_LINE_SIZE];
+} libcache_replica_table_t;
+
+/*
+ *  @brief libcache_replica_t  | libcache_replica_t | key | entry |, seq is odd while it's written.
+ */
+typedef struct libcache_replica_t {
+    uint32_t seq;
+    uint32_t version;
+    uint32_t number;
+} libcache_replica_t;
+
+typedef struct libcache_sharded_t {
+    libcache_shard_t* shards;  /* cache line aligned */
+    void* memory;              /* memory of shards, to be freed */
+    uint32_t shard_number;
+    uint32_t shard_bits;
+    LIBCACHE_KEY_TO_NUMBER* key_to_number;
+    libcache_hash_e hasher;    /* LIBCACHE_HASH_DEFAULT: key_to_number */
+    size_t key_size;
+    size_t entry_size;
+    LIBCACHE_LOAD_ENTRY* load_entry;
+    LIBCACHE_FREE_MEMORY* free_memory;
+    LIBCACHE_CMP_KEY* cmp_key;
+    uint32_t hot_key_number;        /* attr.hot_keys, 0: no replicas */
+    uint32_t replica_table_number;  /* one per configured core */
+    size_t replica_size;            /* of a replica with its key and entry, cache line aligned */
+    size_t replica_table_size;
+    libcache_hot_key_t* hot_keys;   /* in lines of their own, read by every core */
+    libcache_hot_sketch_t* sketch;
+    char* replica_tables;
+    void* replica_memory;           /* | hot_keys | sketch | replica tables |, to be freed */
+    uint32_t request_slots;         /* request slots of a shard, 0: no combining */
+    libcache_request_t* requests;   /* slots of shard i are from i * request_slots, cache line aligned */
+    void* request_memory;           /* memory of requests, to be freed */
+    int lookup_reclaims;            /* lookups free expired or stale entries, by ttl or tags */
+} libcache_sharded_t;
+
+/*
+ *  @brief libcache_shard_write_begin    locks the shard to change its hash or entries.
+ */
+static inline void libcache_shard_write_begin(libcache_shard_t* shard)
+{
+    libcache_spin_lock(&shard->shard.lock);
+    __atomic_store_n(&shard->shard.seq, shard->shard.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void libcache_shard_write_end(libcache_shard_t* shard)
+{
+    __atomic_store_n(&shard->shard.seq, shard->shard.seq + 1, __ATOMIC_RELEASE);
+    libcache_spin_unlock(&shard->shard.lock);
+}
+
+/*
+ *  @brief libcache_shard_lookup    looks a key up with the shard locked, as a writer if the lookup may free
+ *                                  an expired or stale entry, which changes the hash.
+ */
+static inline void* libcache_shard_lookup(const libcache_sharded_t* sharded_ptr, libcache_shard_t* shard,
+        const void* key, void* dst_entry)
+{
+    if (unlikely(sharded_ptr->lookup_reclaims)) {
+        libcache_shard_write_begin(shard);
+        void* return_value = libcache_lookup(shard->shard.libcache, key, dst_entry);
+        libcache_shard_write_end(shard);
+        return return_value;
+    }
+    libcache_spin_lock(&shard->shard.lock);
+    void* return_value = libcache_lookup(shard->shard.libcache, key, dst_entry);
+    libcache_spin_unlock(&shard->shard.lock);
+    return return_value;
+}
+
+/*
+ *  @brief libcache_sharded_number    gets the mixed key number, equal keys have the same one.
+ */
+static inline uint32_t libcache_sharded_number(const libcache_sharded_t* sharded_ptr, const void* key)
+{
+    uint32_t number = (sharded_ptr->hasher != LIBCACHE_HASH_DEFAULT)
+            ? libcache_hash_number(sharded_ptr->hasher, key, sharded_ptr->key_size) : sharded_ptr->key_to_number(key);
+    return (uint32_t) (number * LIBCACHE_SHARD_PRIME_32);
+}
+
+static inline libcache_shard_t* libcache_sharded_shard(const libcache_sharded_t* sharded_ptr, uint32_t number)
+{
+    return (sharded_ptr->shard_bits == 0) ? sharded_ptr->shards
+            : sharded_ptr->shards + (number >> (32 - sharded_ptr->shard_bits));
+}
+
+/*
+ *  @brief libcache_sharded_select    selects the shard of a key by high bits of mixed key number.
+ */
+static inline libcache_shard_t* libcache_sharded_select(const libcache_sharded_t* sharded_ptr, const void* key)
+{
+    if (sharded_ptr->shard_bits == 0) {
+        return sharded_ptr->shards;
+    }
+    return libcache_sharded_shard(sharded_ptr, libcache_sharded_number(sharded_ptr, key));
+}
+
+/*
+ *  @brief libcache_hot_find  finds the slot of a hot key number.
+ *
+ *  @param version          output, version of the slot.
+ *  @return -1              the key isn't hot.
+ *          index           the slot.
+ */
+static inline int libcache_hot_find(const libcache_sharded_t* sharded_ptr, uint32_t number, uint32_t* version)
+{
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->hot_key_number; i++) {
+        libcache_hot_key_t* hot_key = sharded_ptr->hot_keys + i;
+        uint32_t seen = __atomic_load_n(&hot_key->version, __ATOMIC_ACQUIRE);
+        if (0 == seen || (seen & 1) || __atomic_load_n(&hot_key->number, __ATOMIC_RELAXED) != number) {
+            continue;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (likely(__atomic_load_n(&hot_key->version, __ATOMIC_RELAXED) == seen)) {
+            *version = seen;
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  @brief libcache_hot_invalidate_number  bumps the version of a key number if it's hot, after its entry may have
+ *                                         changed.
+ */
+static inline void libcache_hot_invalidate_number(libcache_sharded_t* sharded_ptr, uint32_t number)
+{
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->hot_key_number; i++) {
+        libcache_hot_key_t* hot_key = sharded_ptr->hot_keys + i;
+        if (0 != __atomic_load_n(&hot_key->version, __ATOMIC_RELAXED)
+                && __atomic_load_n(&hot_key->number, __ATOMIC_RELAXED) == number) {
+            __atomic_fetch_add(&hot_key->version, 2, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+static inline void libcache_hot_invalidate(libcache_sharded_t* sharded_ptr, const void* key)
+{
+    if (unlikely(0 != sharded_ptr->hot_key_number) && NULL != key) {
+        libcache_hot_invalidate_number(sharded_ptr, libcache_sharded_number(sharded_ptr, key));
+    }
+}
+
+/*
+ *  @brief libcache_hot_count  counts a sample of a key number, a missing one takes the counter of the fewest.
+ *
+ *  @return                 samples of the key.
+ */
+static uint32_t libcache_hot_count(libcache_hot_sketch_t* sketch, uint32_t number)
+{
+    uint32_t i;
+    if (unlikely(++sketch->total >= LIBCACHE_HOT_WINDOW)) {
+        sketch->total /= 2;
+        for (i = 0; i < sketch->used; i++) {
+            sketch->counters[i].count /= 2;
+        }
+    }
+    uint32_t fewest = 0;
+    for (i = 0; i < sketch->used; i++) {
+        if (sketch->counters[i].number == number) {
+            return ++sketch->counters[i].count;
+        }
+        if (sketch->counters[i].count < sketch->counters[fewest].count) {
+            fewest = i;
+        }
+    }
+    if (sketch->used < LIBCACHE_HOT_COUNTERS) {
+        fewest = sketch->used++;
+        sketch->counters[fewest].count = 0;
+    }
+    // Note: the count taken over is kept, the key may have had those samples
+    sketch->counters[fewest].number = number;
+    return ++sketch->counters[fewest].count;
+}
+
+static uint32_t libcache_hot_get_count(const libcache_hot_sketch_t* sketch, uint32_t number)
+{
+    uint32_t i;
+    for (i = 0; i < sketch->used; i++) {
+        if (sketch->counters[i].number == number) {
+            return sketch->counters[i].count;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  @brief libcache_hot_promote  makes a key hot in an empty slot, or in the one of fewer samples than count.
+ */
+static void libcache_hot_promote(libcache_sharded_t* sharded_ptr, uint32_t number, uint32_t count)
+{
+    uint32_t version = 0;
+    if (libcache_hot_find(sharded_ptr, number, &version) >= 0) {
+        return;
+    }
+    uint32_t victim = 0;
+    uint32_t victim_count = UINT32_MAX;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->hot_key_number && 0 != victim_count; i++) {
+        libcache_hot_key_t* hot_key = sharded_ptr->hot_keys + i;
+        uint32_t hot_count = (0 == __atomic_load_n(&hot_key->version, __ATOMIC_RELAXED)) ? 0
+                : libcache_hot_get_count(sharded_ptr->sketch, hot_key->number);
+        if (hot_count < victim_count) {
+            victim = i;
+            victim_count = hot_count;
+        }
+    }
+    if (victim_count >= count) {
+        return;
+    }
+
+    // Note: only the holder of the sketch lock makes a version odd, bumps meanwhile keep it odd
+    libcache_hot_key_t* hot_key = sharded_ptr->hot_keys + victim;
+    __atomic_fetch_add(&hot_key->version, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&hot_key->number, number, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hot_key->version, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ *  @brief libcache_replica_table  gets the replica table of the core the thread runs on.
+ */
+static inline libcache_replica_table_t* libcache_replica_table(const libcache_sharded_t* sharded_ptr)
+{
+    int cpu = sched_getcpu();
+    uint32_t index = (cpu < 0) ? 0 : (uint32_t) cpu % sharded_ptr->replica_table_number;
+    return (libcache_replica_table_t*) (sharded_ptr->replica_tables + index * sharded_ptr->replica_table_size);
+}
+
+static inline libcache_replica_t* libcache_replica_get(const libcache_sharded_t* sharded_ptr,
+        libcache_replica_table_t* table, int slot)
+{
+    return (libcache_replica_t*) ((char*) (table + 1) + (size_t) slot * sharded_ptr->replica_size);
+}
+
+/*
+ *  @brief libcache_hot_sample  counts 1 in LIBCACHE_HOT_SAMPLE lookups of a core, a key of enough samples is
+ *                              promoted.
+ */
+static inline void libcache_hot_sample(libcache_sharded_t* sharded_ptr, libcache_replica_table_t* table,
+        uint32_t number)
+{
+    uint32_t lookups = __atomic_load_n(&table->table.lookups, __ATOMIC_RELAXED) + 1;
+    __atomic_store_n(&table->table.lookups, lookups, __ATOMIC_RELAXED);
+    if (likely(0 != lookups % LIBCACHE_HOT_SAMPLE)) {
+        return;
+    }
+    libcache_hot_sketch_t* sketch = sharded_ptr->sketch;
+    if (!libcache_spin_trylock(&sketch->lock)) {
+        return;
+    }
+    uint32_t count = libcache_hot_count(sketch, number);
+    if (count >= LIBCACHE_HOT_MIN_COUNT && (uint64_t) count * 2 * sharded_ptr->hot_key_number >= sketch->total) {
+        libcache_hot_promote(sharded_ptr, number, count);
+    }
+    libcache_spin_unlock(&sketch->lock);
+}
+
+/*
+ *  @brief libcache_replica_read  copies the replica of a hot key of this core into dst_entry.
+ *
+ *  @param slot             output, slot of the key, -1 if it isn't hot.
+ *  @param version          output, version of the slot, a replica filled after a miss is tagged by it.
+ *  @return FALSE           the key isn't hot, or its replica is stale or being written.
+ */
+static inline int libcache_replica_read(libcache_sharded_t* sharded_ptr, libcache_replica_table_t* table,
+        uint32_t number, const void* key, void* dst_entry, int* slot, uint32_t* version)
+{
+    *slot = libcache_hot_find(sharded_ptr, number, version);
+    if (likely(*slot < 0)) {
+        return FALSE;
+    }
+    libcache_replica_t* replica = libcache_replica_get(sharded_ptr, table, *slot);
+    uint32_t seq = __atomic_load_n(&replica->seq, __ATOMIC_ACQUIRE);
+    if ((seq & 1) || __atomic_load_n(&replica->version, __ATOMIC_RELAXED) != *version
+            || __atomic_load_n(&replica->number, __ATOMIC_RELAXED) != number) {
+        return FALSE;
+    }
+    const char* replica_key = (const char*) (replica + 1);
+    if (NULL != sharded_ptr->cmp_key ? LIBCACHE_EQU != sharded_ptr->cmp_key(replica_key, key)
+            : 0 != memcmp(replica_key, key, sharded_ptr->key_size)) {
+        return FALSE;
+    }
+    memcpy(dst_entry, replica_key + (sharded_ptr->key_size + 7) / 8 * 8, sharded_ptr->entry_size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (unlikely(__atomic_load_n(&replica->seq, __ATOMIC_RELAXED) != seq
+            || __atomic_load_n(&sharded_ptr->hot_keys[*slot].version, __ATOMIC_RELAXED) != *version)) {
+        return FALSE;
+    }
+    __atomic_store_n(&table->table.hits, __atomic_load_n(&table->table.hits, __ATOMIC_RELAXED) + 1,
+            __ATOMIC_RELAXED);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_replica_fill  copies an entry read from its shard into the replica of this core, it's skipped
+ *                                if another thread is writing it.
+ */
+static inline void libcache_replica_fill(libcache_sharded_t* sharded_ptr, libcache_replica_table_t* table, int slot,
+        uint32_t version, uint32_t number, const void* key, const void* entry)
+{
+    libcache_replica_t* replica = libcache_replica_get(sharded_ptr, table, slot);
+    uint32_t seq = __atomic_load_n(&replica->seq, __ATOMIC_RELAXED);
+    if ((seq & 1) || !__atomic_compare_exchange_n(&replica->seq, &seq, seq + 1, FALSE, __ATOMIC_ACQUIRE,
+            __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&replica->version, version, __ATOMIC_RELAXED);
+    __atomic_store_n(&replica->number, number, __ATOMIC_RELAXED);
+    char* replica_key = (char*) (replica + 1);
+    memcpy(replica_key, key, sharded_ptr->key_size);
+    memcpy(replica_key + (sharded_ptr->key_size + 7) / 8 * 8, entry, sharded_ptr->entry_size);
+    __atomic_store_n(&replica->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ *  @brief libcache_request_apply  does a request in the shard, which is locked.
+ */
+static inline void libcache_request_apply(libcache_shard_t* shard, libcache_request_data_t* data)
+{
+    void* libcache = shard->shard.libcache;
+    switch (data->op) {
+    case LIBCACHE_REQUEST_ADD:
+        data->entry = libcache_add(libcache, data->key, data->src_entry);
+        break;
+    case LIBCACHE_REQUEST_DELETE_BY_KEY:
+        data->result = libcache_delete_by_key(libcache, data->key);
+        break;
+    case LIBCACHE_REQUEST_DELETE_ENTRY:
+        data->result = libcache_delete_entry(libcache, data->entry);
+        break;
+    default:
+        data->result = libcache_unlock_entry(libcache, data->entry);
+        break;
+    }
+}
+
+/*
+ *  @brief libcache_shard_combine  does every request posted to a shard, its lock is taken by the combiner.
+ */
+static void libcache_shard_combine(const libcache_sharded_t* sharded_ptr, libcache_shard_t* shard)
+{
+    __atomic_store_n(&shard->shard.seq, shard->shard.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    libcache_request_t* requests = sharded_ptr->requests
+            + (size_t) (shard - sharded_ptr->shards) * sharded_ptr->request_slots;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->request_slots; i++) {
+        libcache_request_t* request = requests + i;
+        if (LIBCACHE_REQUEST_POSTED == __atomic_load_n(&request->request.state, __ATOMIC_ACQUIRE)) {
+            libcache_request_apply(shard, &request->request.data);
+            __atomic_store_n(&request->request.state, LIBCACHE_REQUEST_DONE, __ATOMIC_RELEASE);
+        }
+    }
+    libcache_shard_write_end(shard);
+}
+
+/*
+ *  @brief libcache_shard_request  posts a request to the slot of the core in a shard, and waits until it's done,
+ *                                 by this thread if it takes the shard first.
+ *
+ *  @param data             the request, its result is copied back.
+ *  @return FALSE           no combining, or the slot is taken by another thread, nothing is done.
+ */
+static int libcache_shard_request(const libcache_sharded_t* sharded_ptr, libcache_shard_t* shard,
+        libcache_request_data_t* data)
+{
+    if (likely(0 == sharded_ptr->request_slots)) {
+        return FALSE;
+    }
+    int cpu = sched_getcpu();
+    uint32_t index = (cpu < 0) ? 0 : (uint32_t) cpu % sharded_ptr->request_slots;
+    libcache_request_t* request = sharded_ptr->requests
+            + (size_t) (shard - sharded_ptr->shards) * sharded_ptr->request_slots + index;
+    uint32_t state = LIBCACHE_REQUEST_FREE;
+    if (!__atomic_compare_exchange_n(&request->request.state, &state, LIBCACHE_REQUEST_WRITING, FALSE,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return FALSE;
+    }
+    request->request.data = *data;
+    __atomic_store_n(&request->request.state, LIBCACHE_REQUEST_POSTED, __ATOMIC_RELEASE);
+
+    uint32_t spin = 0;
+    while (LIBCACHE_REQUEST_POSTED == __atomic_load_n(&request->request.state, __ATOMIC_ACQUIRE)) {
+        if (libcache_spin_trylock(&shard->shard.lock)) {
+            libcache_shard_combine(sharded_ptr, shard);
+        } else if (likely(++spin < LIBCACHE_SPIN_COUNT)) {
+            libcache_cpu_relax();
+        } else {
+            spin = 0;
+            sched_yield();
+        }
+    }
+    *data = request->request.data;
+    __atomic_store_n(&request->request.state, LIBCACHE_REQUEST_FREE, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_sharded_create_requests  gets memory of request slots, one per core in every shard.
+ */
+static int libcache_sharded_create_requests(libcache_sharded_t* sharded_ptr, const libcache_attr_t* attr)
+{
+    long cores = sysconf(_SC_NPROCESSORS_CONF);
+    uint32_t slots = (cores < 1) ? 1
+            : (cores > LIBCACHE_REQUEST_SLOTS_MAX) ? LIBCACHE_REQUEST_SLOTS_MAX : (uint32_t) cores;
+    size_t length = sizeof(libcache_request_t) * slots * sharded_ptr->shard_number;
+    sharded_ptr->request_memory = libcache_memory_allocate(attr, length + LIBCACHE_CACHE_LINE_SIZE);
+    if (unlikely(NULL == sharded_ptr->request_memory)) {
+        return FALSE;
+    }
+    sharded_ptr->requests = (libcache_request_t*) LIBCACHE_LINE_ROUND((uintptr_t) sharded_ptr->request_memory);
+    memset(sharded_ptr->requests, 0, length);
+    sharded_ptr->request_slots = slots;
+    return TRUE;
+}
+
+/*
+ *  @brief libcache_sharded_create_replicas  gets memory of hot keys, the sketch and a replica table per core.
+ */
+static int libcache_sharded_create_replicas(libcache_sharded_t* sharded_ptr, const libcache_attr_t* attr)
+{
+    long cores = sysconf(_SC_NPROCESSORS_CONF);
+    sharded_ptr->replica_table_number = (cores < 1) ? 1
+            : (cores > LIBCACHE_REPLICA_TABLE_MAX) ? LIBCACHE_REPLICA_TABLE_MAX : (uint32_t) cores;
+    sharded_ptr->replica_size = LIBCACHE_LINE_ROUND(sizeof(libcache_replica_t) + (attr->key_size + 7) / 8 * 8
+            + attr->entry_size);
+    sharded_ptr->replica_table_size = sizeof(libcache_replica_table_t)
+            + sharded_ptr->replica_size * attr->hot_keys;
+    size_t hot_keys_length = LIBCACHE_LINE_ROUND(sizeof(libcache_hot_key_t) * attr->hot_keys);
+    size_t sketch_length = LIBCACHE_LINE_ROUND(sizeof(libcache_hot_sketch_t));
+    size_t length = hot_keys_length + sketch_length
+            + sharded_ptr->replica_table_size * sharded_ptr->replica_table_number;
+    sharded_ptr->replica_memory = libcache_memory_allocate(attr, length + LIBCACHE_CACHE_LINE_SIZE);
+    if (unlikely(NULL == sharded_ptr->replica_memory)) {
+        return FALSE;
+    }
+    char* memory = (char*) LIBCACHE_LINE_ROUND((uintptr_t) sharded_ptr->replica_memory);
+    memset(memory, 0, length);
+    sharded_ptr->hot_keys = (libcache_hot_key_t*) memory;
+    sharded_ptr->sketch = (libcache_hot_sketch_t*) (memory + hot_keys_length);
+    sharded_ptr->replica_tables = memory + hot_keys_length + sketch_length;
+    sharded_ptr->hot_key_number = attr->hot_keys;
+    return TRUE;
+}
+
+void* libcache_sharded_create(const libcache_attr_t* attr, uint32_t shard_number)
+{
+    if (unlikely(NULL == attr)) {
+        DEBUG_ERROR("input parameter %s is null", "attr");
+        return NULL;
+    }
+
+    if (unlikely(!libcache_memory_allocator(attr) || NULL == attr->free_memory)) {
+        DEBUG_ERROR("input parameter %s is null", "attr function");
+        return NULL;
+    }
+
+    if (unlikely(attr->hot_keys > LIBCACHE_HOT_KEYS_MAX || (0 != attr->hot_keys && 0 != attr->ttl))) {
+        DEBUG_ERROR("invalid hot_keys %u", attr->hot_keys);
+        return NULL;
+    }
+
+    // Note: a ring of replication has one producer, shards are written by several threads
+    if (unlikely(NULL != attr->replication)) {
+        DEBUG_ERROR("argument %s isn't supported by a sharded cache", "replication");
+        return NULL;
+    }
+
+    uint32_t shard_bits = 0;
+    while ((1U << shard_bits) < shard_number && shard_bits < LIBCACHE_SHARD_MAX_BITS) {
+        shard_bits++;
+    }
+    shard_number = 1U << shard_bits;
+
+    libcache_sharded_t* sharded_ptr =
+            (libcache_sharded_t*) libcache_memory_allocate(attr, sizeof(libcache_sharded_t));
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("failed to allocate %s", "sharded cache");
+        return NULL;
+    }
+
+    // Note: align shards to cache line
+    sharded_ptr->memory = libcache_memory_allocate(attr,
+            sizeof(libcache_shard_t) * shard_number + LIBCACHE_CACHE_LINE_SIZE);
+    if (unlikely(NULL == sharded_ptr->memory)) {
+        DEBUG_ERROR("failed to allocate %s", "shards");
+        attr->free_memory(sharded_ptr);
+        return NULL;
+    }
+    sharded_ptr->shards = (libcache_shard_t*) (((uintptr_t) sharded_ptr->memory + LIBCACHE_CACHE_LINE_SIZE - 1)
+            & ~((uintptr_t) LIBCACHE_CACHE_LINE_SIZE - 1));
+    memset(sharded_ptr->shards, 0, sizeof(libcache_shard_t) * shard_number);
+    sharded_ptr->shard_number = shard_number;
+    sharded_ptr->shard_bits = shard_bits;
+    sharded_ptr->key_to_number = attr->key_to_number;
+    sharded_ptr->hasher = libcache_hash_resolve(attr->hash, attr->key_to_number);
+    sharded_ptr->key_size = attr->key_size;
+    sharded_ptr->entry_size = attr->entry_size;
+    sharded_ptr->load_entry = attr->load_entry;
+    sharded_ptr->free_memory = attr->free_memory;
+    sharded_ptr->cmp_key = attr->cmp_key;
+    sharded_ptr->hot_key_number = 0;
+    sharded_ptr->replica_memory = NULL;
+    sharded_ptr->request_slots = 0;
+    sharded_ptr->request_memory = NULL;
+    sharded_ptr->lookup_reclaims = (0 != attr->ttl || 0 != attr->tags);
+    if (0 != attr->hot_keys && unlikely(!libcache_sharded_create_replicas(sharded_ptr, attr))) {
+        DEBUG_ERROR("failed to allocate %s", "replicas");
+        libcache_sharded_destroy(sharded_ptr);
+        return NULL;
+    }
+    if (attr->combining && unlikely(!libcache_sharded_create_requests(sharded_ptr, attr))) {
+        DEBUG_ERROR("failed to allocate %s", "requests");
+        libcache_sharded_destroy(sharded_ptr);
+        return NULL;
+    }
+
+    // Note: every shard is a cache with its own memory
+    libcache_attr_t shard_attr = *attr;
+    shard_attr.max_entry_number = (attr->max_entry_number + shard_number - 1) / shard_number;
+    uint32_t i;
+    for (i = 0; i < shard_number; i++) {
+        sharded_ptr->shards[i].shard.libcache = libcache_create_ex(&shard_attr);
+        if (unlikely(NULL == sharded_ptr->shards[i].shard.libcache)) {
+            DEBUG_ERROR("failed to create shard %u", i);
+            libcache_sharded_destroy(sharded_ptr);
+            return NULL;
+        }
+    }
+
+    return sharded_ptr;
+}
+
+void* libcache_sharded_lookup(void* sharded, const void* key, void* dst_entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key");
+        return NULL;
+    }
+
+    libcache_shard_t* shard;
+    if (unlikely(0 != sharded_ptr->hot_key_number)) {
+        uint32_t number = libcache_sharded_number(sharded_ptr, key);
+        libcache_hot_sample(sharded_ptr, libcache_replica_table(sharded_ptr), number);
+        shard = libcache_sharded_shard(sharded_ptr, number);
+    } else {
+        shard = libcache_sharded_select(sharded_ptr, key);
+    }
+    return libcache_shard_lookup(sharded_ptr, shard, key, dst_entry);
+}
+
+/*
+ *  @brief libcache_sharded_read_shard    reads a shard without its lock, or with it if writers keep changing it.
+ */
+static void* libcache_sharded_read_shard(const libcache_sharded_t* sharded_ptr, libcache_shard_t* shard,
+        const void* key, void* dst_entry)
+{
+    uint32_t retry;
+    for (retry = 0; retry < LIBCACHE_READ_RETRY; retry++) {
+        uint32_t seq = __atomic_load_n(&shard->shard.seq, __ATOMIC_ACQUIRE);
+        if (unlikely(seq & 1)) {
+            libcache_cpu_relax();
+            continue;
+        }
+        void* return_value = libcache_peek(shard->shard.libcache, key, dst_entry);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (likely(__atomic_load_n(&shard->shard.seq, __ATOMIC_RELAXED) == seq)) {
+            return return_value;
+        }
+    }
+
+    // Note: writers keep changing the shard, wait for them
+    return libcache_shard_lookup(sharded_ptr, shard, key, dst_entry);
+}
+
+void* libcache_sharded_read(void* sharded, const void* key, void* dst_entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key || NULL == dst_entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key or dst_entry");
+        return NULL;
+    }
+
+    if (likely(0 == sharded_ptr->hot_key_number)) {
+        return libcache_sharded_read_shard(sharded_ptr, libcache_sharded_select(sharded_ptr, key), key, dst_entry);
+    }
+
+    // Note: the version is got before the shard is read, a change meanwhile leaves the replica stale
+    uint32_t number = libcache_sharded_number(sharded_ptr, key);
+    libcache_replica_table_t* table = libcache_replica_table(sharded_ptr);
+    int slot = -1;
+    uint32_t version = 0;
+    if (libcache_replica_read(sharded_ptr, table, number, key, dst_entry, &slot, &version)) {
+        return dst_entry;
+    }
+    libcache_hot_sample(sharded_ptr, table, number);
+    void* return_value = libcache_sharded_read_shard(sharded_ptr, libcache_sharded_shard(sharded_ptr, number), key,
+            dst_entry);
+    if (slot >= 0 && NULL != return_value) {
+        libcache_replica_fill(sharded_ptr, table, slot, version, number, key, dst_entry);
+    }
+    return return_value;
+}
+
+void* libcache_sharded_add(void* sharded, const void* key, const void* src_entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key");
+        return NULL;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_select(sharded_ptr, key);
+    libcache_request_data_t data = { LIBCACHE_REQUEST_ADD, key, src_entry, NULL, LIBCACHE_SUCCESS };
+    if (!libcache_shard_request(sharded_ptr, shard, &data)) {
+        libcache_shard_write_begin(shard);
+        data.entry = libcache_add(shard->shard.libcache, key, src_entry);
+        libcache_shard_write_end(shard);
+    }
+    libcache_hot_invalidate(sharded_ptr, key);
+    return data.entry;
+}
+
+void* libcache_sharded_lookup_or_add(void* sharded, const void* key, int* inserted)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key");
+        return NULL;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_select(sharded_ptr, key);
+    libcache_shard_write_begin(shard);
+    void* return_value = libcache_lookup_or_add(shard->shard.libcache, key, inserted);
+    libcache_shard_write_end(shard);
+    libcache_hot_invalidate(sharded_ptr, key);
+    return return_value;
+}
+
+void* libcache_sharded_lookup_or_load(void* sharded, const void* key, int* loaded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key || NULL == sharded_ptr->load_entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key or load_entry");
+        return NULL;
+    }
+
+    if (NULL != loaded) {
+        *loaded = FALSE;
+    }
+    libcache_shard_t* shard = libcache_sharded_select(sharded_ptr, key);
+    void* entry = NULL;
+    libcache_shard_write_begin(shard);
+    libcache_ret_t return_value = libcache_load_begin(shard->shard.libcache, key, &entry);
+    libcache_shard_write_end(shard);
+    if (LIBCACHE_SUCCESS == return_value) {
+        return entry;
+    }
+    if (LIBCACHE_LOCKED == return_value) {
+        // Note: the placeholder locked for this thread stays until it's unlocked, even if the load fails
+        if (LIBCACHE_SUCCESS == libcache_load_wait(entry)) {
+            return entry;
+        }
+        libcache_sharded_unlock_entry(sharded, entry);
+        return NULL;
+    }
+    if (LIBCACHE_NOT_FOUND != return_value) {
+        return NULL;
+    }
+
+    // Note: the backend is asked without the shard lock, other keys of the shard go on meanwhile
+    size_t entry_length = sharded_ptr->entry_size;
+    int result = sharded_ptr->load_entry(key, entry, &entry_length);
+    libcache_shard_write_begin(shard);
+    return_value = libcache_load_end(shard->shard.libcache, entry, entry_length, result);
+    libcache_shard_write_end(shard);
+    if (LIBCACHE_SUCCESS != return_value) {
+        return NULL;
+    }
+    if (NULL != loaded) {
+        *loaded = TRUE;
+    }
+    return entry;
+}
+
+libcache_ret_t libcache_sharded_lookup_async(void* sharded, const void* key, libcache_load_waiter_t* waiter)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_select(sharded_ptr, key);
+    libcache_shard_write_begin(shard);
+    libcache_ret_t return_value = libcache_lookup_async(shard->shard.libcache, key, waiter);
+    libcache_shard_write_end(shard);
+    return return_value;
+}
+
+/*
+ *  @brief libcache_sharded_entry_shard    finds the shard of an entry by its key.
+ *  NOTE:  The key of a locked entry never changes, so it's read without lock.
+ */
+static inline libcache_shard_t* libcache_sharded_entry_shard(const libcache_sharded_t* sharded_ptr, void* entry)
+{
+    const void* key = libcache_get_entry_key(entry);
+    return (NULL == key) ? NULL : libcache_sharded_select(sharded_ptr, key);
+}
+
+libcache_ret_t libcache_sharded_load_complete(void* sharded, libcache_load_waiter_t* loader, size_t entry_length,
+        int loaded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == loader || NULL == loader->handle.entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or loader");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_entry_shard(sharded_ptr, loader->handle.entry);
+    if (NULL == shard) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    // Note: done of a waiter may call the cache, it's called once the shard is unlocked
+    libcache_load_waiter_t* waiters = NULL;
+    libcache_shard_write_begin(shard);
+    libcache_ret_t return_value = libcache_load_complete(shard->shard.libcache, loader, entry_length, loaded,
+            &waiters);
+    libcache_shard_write_end(shard);
+    libcache_load_notify(waiters);
+    return return_value;
+}
+
+libcache_ret_t libcache_sharded_delete_by_key(void* sharded, const void* key)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or key");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_select(sharded_ptr, key);
+    libcache_request_data_t data = { LIBCACHE_REQUEST_DELETE_BY_KEY, key, NULL, NULL, LIBCACHE_SUCCESS };
+    if (!libcache_shard_request(sharded_ptr, shard, &data)) {
+        libcache_shard_write_begin(shard);
+        data.result = libcache_delete_by_key(shard->shard.libcache, key);
+        libcache_shard_write_end(shard);
+    }
+    libcache_hot_invalidate(sharded_ptr, key);
+    return data.result;
+}
+
+libcache_ret_t libcache_sharded_delete_entry(void* sharded, void* entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_entry_shard(sharded_ptr, entry);
+    if (NULL == shard) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    // Note: the key is gone once the entry is deleted, its version is bumped after it
+    uint32_t number = (0 == sharded_ptr->hot_key_number) ? 0
+            : libcache_sharded_number(sharded_ptr, libcache_get_entry_key(entry));
+    libcache_request_data_t data = { LIBCACHE_REQUEST_DELETE_ENTRY, NULL, NULL, entry, LIBCACHE_SUCCESS };
+    if (!libcache_shard_request(sharded_ptr, shard, &data)) {
+        libcache_shard_write_begin(shard);
+        data.result = libcache_delete_entry(shard->shard.libcache, entry);
+        libcache_shard_write_end(shard);
+    }
+    if (unlikely(0 != sharded_ptr->hot_key_number)) {
+        libcache_hot_invalidate_number(sharded_ptr, number);
+    }
+    return data.result;
+}
+
+libcache_ret_t libcache_sharded_unlock_entry(void* sharded, void* entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    // Note: the holder may have written the entry, its key is valid until it's unlocked
+    libcache_hot_invalidate(sharded_ptr, libcache_get_entry_key(entry));
+
+#ifdef LIBCACHE_CONCURRENT
+    // Note: only the last unlock changes the shard, the others just decrease lock counter
+    if (LIBCACHE_SUCCESS == libcache_try_unlock_entry(entry)) {
+        return LIBCACHE_SUCCESS;
+    }
+#endif
+
+    libcache_shard_t* shard = libcache_sharded_entry_shard(sharded_ptr, entry);
+    if (NULL == shard) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    libcache_request_data_t data = { LIBCACHE_REQUEST_UNLOCK_ENTRY, NULL, NULL, entry, LIBCACHE_SUCCESS };
+    // Note: the last unlock of a placeholder whose load failed frees it, it changes the hash
+    if (!libcache_shard_request(sharded_ptr, shard, &data)) {
+        libcache_shard_write_begin(shard);
+        data.result = libcache_unlock_entry(shard->shard.libcache, entry);
+        libcache_shard_write_end(shard);
+    }
+    return data.result;
+}
+
+libcache_ret_t libcache_sharded_mark_dirty(void* sharded, void* entry)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == entry)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or entry");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_shard_t* shard = libcache_sharded_entry_shard(sharded_ptr, entry);
+    if (NULL == shard) {
+        return LIBCACHE_NOT_FOUND;
+    }
+    libcache_spin_lock(&shard->shard.lock);
+    libcache_ret_t return_value = libcache_mark_dirty(shard->shard.libcache, entry);
+    libcache_spin_unlock(&shard->shard.lock);
+    return return_value;
+}
+
+int libcache_sharded_flush(void* sharded, int budget)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return 0;
+    }
+
+    // Note: shards are flushed one by one, a batch never mixes entries of different shards
+    int flushed = 0;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number && (budget <= 0 || flushed < budget); i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_spin_lock(&shard->shard.lock);
+        flushed += libcache_flush(shard->shard.libcache, (budget <= 0) ? 0 : budget - flushed);
+        libcache_spin_unlock(&shard->shard.lock);
+    }
+    return flushed;
+}
+
+int libcache_sharded_drain_evictions(void* sharded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return 0;
+    }
+
+    int delivered = 0;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number; i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_spin_lock(&shard->shard.lock);
+        delivered += libcache_drain_evictions(shard->shard.libcache);
+        libcache_spin_unlock(&shard->shard.lock);
+    }
+    return delivered;
+}
+
+uint32_t libcache_sharded_get_shard_number(const void* sharded)
+{
+    const libcache_sharded_t* sharded_ptr = (const libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return 0;
+    }
+    return sharded_ptr->shard_number;
+}
+
+libcache_scale_t libcache_sharded_get_max_entry_number(void* sharded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return 0;
+    }
+
+    libcache_scale_t number = 0;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number; i++) {
+        number += libcache_get_max_entry_number(sharded_ptr->shards[i].shard.libcache);
+    }
+    return number;
+}
+
+libcache_scale_t libcache_sharded_get_entry_number(void* sharded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return 0;
+    }
+
+    libcache_scale_t number = 0;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number; i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_spin_lock(&shard->shard.lock);
+        number += libcache_get_entry_number(shard->shard.libcache);
+        libcache_spin_unlock(&shard->shard.lock);
+    }
+    return number;
+}
+
+libcache_ret_t libcache_sharded_get_stats(void* sharded, libcache_stats_t* stats)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr || NULL == stats)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded or stats");
+        return LIBCACHE_FAILURE;
+    }
+
+    memset(stats, 0, sizeof(libcache_stats_t));
+    libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number && return_value == LIBCACHE_SUCCESS; i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_stats_t shard_stats;
+        libcache_spin_lock(&shard->shard.lock);
+        return_value = libcache_get_stats(shard->shard.libcache, &shard_stats);
+        libcache_spin_unlock(&shard->shard.lock);
+        if (return_value == LIBCACHE_SUCCESS) {
+            libcache_stats_merge(stats, &shard_stats);
+        }
+    }
+    for (i = 0; i < sharded_ptr->replica_table_number && 0 != sharded_ptr->hot_key_number; i++) {
+        libcache_replica_table_t* table = (libcache_replica_table_t*) (sharded_ptr->replica_tables
+                + i * sharded_ptr->replica_table_size);
+        stats->replica_hits += __atomic_load_n(&table->table.hits, __ATOMIC_RELAXED);
+    }
+    return return_value;
+}
+
+libcache_ret_t libcache_sharded_clean(void* sharded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number; i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_shard_write_begin(shard);
+        libcache_ret_t ret = libcache_clean(shard->shard.libcache);
+        libcache_shard_write_end(shard);
+        if (ret != LIBCACHE_SUCCESS) {
+            return_value = ret;
+        }
+    }
+    for (i = 0; i < sharded_ptr->hot_key_number; i++) {
+        if (0 != __atomic_load_n(&sharded_ptr->hot_keys[i].version, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&sharded_ptr->hot_keys[i].version, 2, __ATOMIC_RELEASE);
+        }
+    }
+    return return_value;
+}
+
+libcache_ret_t libcache_sharded_invalidate_tag(void* sharded, uint32_t tag)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return LIBCACHE_FAILURE;
+    }
+
+    libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number && return_value == LIBCACHE_SUCCESS; i++) {
+        libcache_shard_t* shard = sharded_ptr->shards + i;
+        libcache_shard_write_begin(shard);
+        return_value = libcache_invalidate_tag(shard->shard.libcache, tag);
+        libcache_shard_write_end(shard);
+    }
+    // Note: the tags of hot keys aren't known here, all their replicas are stale
+    for (i = 0; i < sharded_ptr->hot_key_number; i++) {
+        if (0 != __atomic_load_n(&sharded_ptr->hot_keys[i].version, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&sharded_ptr->hot_keys[i].version, 2, __ATOMIC_RELEASE);
+        }
+    }
+    return return_value;
+}
+
+libcache_ret_t libcache_sharded_destroy(void* sharded)
+{
+    libcache_sharded_t* sharded_ptr = (libcache_sharded_t*) sharded;
+    if (unlikely(NULL == sharded_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "sharded");
+        return LIBCACHE_FAILURE;
+    }
+
+    uint32_t i;
+    for (i = 0; i < sharded_ptr->shard_number; i++) {
+        if (sharded_ptr->shards[i].shard.libcache != NULL) {
+            libcache_destroy(sharded_ptr->shards[i].shard.libcache);
+        }
+    }
+
+    LIBCACHE_FREE_MEMORY* free_memory = sharded_ptr->free_memory;
+    if (NULL != sharded_ptr->replica_memory) {
+        free_memory(sharded_ptr->replica_memory);
+    }
+    if (NULL != sharded_ptr->request_memory) {
+        free_memory(sharded_ptr->request_memory);
+    }
+    free_memory(sharded_ptr->memory);
+    free_memory(sharded_ptr);
+    return LIBCACHE_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*
+ * libcache_stats.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libcache.h"
+
+void libcache_stats_merge(libcache_stats_t* dst, const libcache_stats_t* src)
+{
+    dst->lookup_hits += src->lookup_hits;
+    dst->lookup_misses += src->lookup_misses;
+    dst->adds += src->adds;
+    dst->add_existing += src->add_existing;
+    dst->add_full += src->add_full;
+    dst->evictions += src->evictions;
+    dst->deletes += src->deletes;
+    dst->delete_locked += src->delete_locked;
+    dst->expirations += src->expirations;
+    dst->loads += src->loads;
+    dst->load_waits += src->load_waits;
+    dst->flushes += src->flushes;
+    dst->negative_hits += src->negative_hits;
+    dst->demotions += src->demotions;
+    dst->promotions += src->promotions;
+    dst->replica_hits += src->replica_hits;
+    int i;
+    for (i = 0; i < LIBCACHE_STATS_PROBE_BUCKETS; i++) {
+        dst->probe_histogram[i] += src->probe_histogram[i];
+    }
+    for (i = 0; i < LIBCACHE_STATS_LATENCY_BUCKETS; i++) {
+        dst->lookup_latency_ns[i] += src->lookup_latency_ns[i];
+        dst->add_latency_ns[i] += src->add_latency_ns[i];
+    }
+    dst->entry_number += src->entry_number;
+}
+
+/*
+ *  @brief libcache_stats_printf    appends to buffer like snprintf, written counts what the whole text needs.
+ */
+#define libcache_stats_printf(buffer, length, written, ...) \
+    do { \
+        size_t offset = ((written) < (length)) ? (written) : (length); \
+        int n = snprintf((buffer) + offset, (length) - offset, __VA_ARGS__); \
+        if (n > 0) { \
+            (written) += (size_t) n; \
+        } \
+    } while (0)
+
+// Note: bucket i of a histogram has the upper bound 2^(i+1) - 1 or 2^(i+1) ns, the last one is +Inf
+static size_t libcache_stats_histogram(const unsigned long long histogram[], int bucket_count, double scale,
+        const char* name, const char* series, char* buffer, size_t length, size_t written)
+{
+    unsigned long long cumulative = 0;
+    double sum = 0;
+    int i;
+    libcache_stats_printf(buffer, length, written, "# TYPE %s_%s histogram\n", name, series);
+    for (i = 0; i < bucket_count; i++) {
+        cumulative += histogram[i];
+        if (i < bucket_count - 1) {
+            libcache_stats_printf(buffer, length, written, "%s_%s_bucket{le=\"%g\"} %llu\n", name, series,
+                    (double) ((1ULL << (i + 1)) - 1) * scale, cumulative);
+        }
+        sum += histogram[i] * (double) (1ULL << i) * scale;
+    }
+    libcache_stats_printf(buffer, length, written, "%s_%s_bucket{le=\"+Inf\"} %llu\n", name, series, cumulative);
+    libcache_stats_printf(buffer, length, written, "%s_%s_sum %g\n", name, series, sum);
+    libcache_stats_printf(buffer, length, written, "%s_%s_count %llu\n", name, series, cumulative);
+    return written;
+}
+
+int libcache_stats_format(const libcache_stats_t* stats, const char* name, char* buffer, size_t length)
+{
+    if (NULL == stats || NULL == name || (NULL == buffer && length > 0)) {
+        DEBUG_ERROR("input parameter %s is null", "stats or name or buffer");
+        return -1;
+    }
+    if (length > 0) {
+        buffer[0] = '\0';
+    }
+
+    const struct {
+        const char* series;
+        unsigned long long value;
+    } counters[] = {
+        { "lookup_hits_total", stats->lookup_hits },
+        { "lookup_misses_total", stats->lookup_misses },
+        { "adds_total", stats->adds },
+        { "add_existing_total", stats->add_existing },
+        { "add_full_total", stats->add_full },
+        { "evictions_total", stats->evictions },
+        { "deletes_total", stats->deletes },
+        { "delete_locked_total", stats->delete_locked },
+        { "expirations_total", stats->expirations },
+        { "loads_total", stats->loads },
+        { "load_waits_total", stats->load_waits },
+        { "flushes_total", stats->flushes },
+        { "negative_hits_total", stats->negative_hits },
+        { "demotions_total", stats->demotions },
+        { "promotions_total", stats->promotions },
+        { "replica_hits_total", stats->replica_hits },
+    };
+    size_t written = 0;
+    size_t i;
+    for (i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        libcache_stats_printf(buffer, length, written, "# TYPE %s_%s counter\n%s_%s %llu\n",
+                name, counters[i].series, name, counters[i].series, counters[i].value);
+    }
+    libcache_stats_printf(buffer, length, written, "# TYPE %s_entries gauge\n%s_entries %u\n",
+            name, name, (unsigned) stats->entry_number);
+
+    // Note: probe n is counted as n, not as a power of 2
+    unsigned long long cumulative = 0;
+    unsigned long long probes = 0;
+    libcache_stats_printf(buffer, length, written, "# TYPE %s_probes histogram\n", name);
+    for (i = 0; i < LIBCACHE_STATS_PROBE_BUCKETS; i++) {
+        cumulative += stats->probe_histogram[i];
+        probes += stats->probe_histogram[i] * i;
+        if (i < LIBCACHE_STATS_PROBE_BUCKETS - 1) {
+            libcache_stats_printf(buffer, length, written, "%s_probes_bucket{le=\"%zu\"} %llu\n", name, i, cumulative);
+        }
+    }
+    libcache_stats_printf(buffer, length, written, "%s_probes_bucket{le=\"+Inf\"} %llu\n", name, cumulative);
+    libcache_stats_printf(buffer, length, written, "%s_probes_sum %llu\n%s_probes_count %llu\n",
+            name, probes, name, cumulative);
+
+    written = libcache_stats_histogram(stats->lookup_latency_ns, LIBCACHE_STATS_LATENCY_BUCKETS, 1e-9, name,
+            "lookup_latency_seconds", buffer, length, written);
+    written = libcache_stats_histogram(stats->add_latency_ns, LIBCACHE_STATS_LATENCY_BUCKETS, 1e-9, name,
+            "add_latency_seconds", buffer, length, written);
+    return (int) written;
+}
@@ -0,0 +1,403 @@
+/*
+ * libcache_tier.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+// Note: pread, pwrite and ftruncate are not in C99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libcache_tier.h"
+#include "libcache_memory.h"
+#include "libcache_hash.h"
+#include "libcache_spinlock.h"
+
+#define LIBCACHE_TIER_ALIGN 8
+#define LIBCACHE_TIER_SWEEP 2       /* slots checked for stale positions by every put */
+#define LIBCACHE_TIER_FULL_SWEEP 64 /* slots checked more by a put into a full index */
+
+/*
+ *  @brief libcache_tier_slot_t  a slot of the index, fingerprint 0 means it's empty.
+ *
+ *  @field position         log position of the entry, the file offset is position % file_size.
+ */
+typedef struct libcache_tier_slot_t
+{
+    uint64_t fingerprint;
+    uint64_t position;
+    uint32_t entry_length;
+} libcache_tier_slot_t;
+
+/*
+ *  @brief libcache_tier_t  | libcache_tier_t | slots | segment |, mapped as a whole.
+ *
+ *  @field segment_start    log position of the segment in memory, positions before it are in the file.
+ *  @field segment_fill     bytes of the segment taken.
+ *  @field sweep            next slot checked for a stale position.
+ */
+typedef struct libcache_tier_t
+{
+    libcache_spinlock_t lock;
+    int fd;
+    size_t memory_length;
+    libcache_page_e page_type;
+    uint64_t file_size;
+    size_t segment_size;
+    size_t entry_size;
+    libcache_scale_t max_entry_number;
+    libcache_scale_t count;
+    uint64_t slot_mask;
+    uint64_t sweep;
+    uint64_t segment_start;
+    size_t segment_fill;
+    libcache_tier_slot_t* slots;
+    char* segment;
+} libcache_tier_t;
+
+static inline size_t libcache_tier_align(size_t length)
+{
+    return (length + LIBCACHE_TIER_ALIGN - 1) & ~((size_t) LIBCACHE_TIER_ALIGN - 1);
+}
+
+static inline uint64_t libcache_tier_fingerprint(const void* key, size_t key_size)
+{
+    uint64_t fingerprint = libcache_hash_wy(key, key_size, 0);
+    return (0 == fingerprint) ? 1 : fingerprint;
+}
+
+/*
+ *  @brief libcache_tier_stale  tells whether an entry in the file is overwritten once the segment is written.
+ */
+static inline int libcache_tier_stale(const libcache_tier_t* tier, uint64_t position)
+{
+    return position + tier->file_size < tier->segment_start + tier->segment_size;
+}
+
+/*
+ *  @brief libcache_tier_delete  empties a slot, the slots after it are shifted back so probes needn't tombstones.
+ */
+static void libcache_tier_delete(libcache_tier_t* tier, uint64_t index)
+{
+    uint64_t hole = index;
+    uint64_t next = (index + 1) & tier->slot_mask;
+    while (0 != tier->slots[next].fingerprint) {
+        // Note: a slot moves into the hole unless its home is between the hole and it
+        uint64_t home = tier->slots[next].fingerprint & tier->slot_mask;
+        if (((next - home) & tier->slot_mask) >= ((next - hole) & tier->slot_mask)) {
+            tier->slots[hole] = tier->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & tier->slot_mask;
+    }
+    tier->slots[hole].fingerprint = 0;
+    tier->count--;
+}
+
+/*
+ *  @brief libcache_tier_find  finds the slot of a fingerprint, a stale one is deleted.
+ *
+ *  @return NULL            not found, index is the empty slot the probe ended at.
+ *          pointer         the slot.
+ */
+static libcache_tier_slot_t* libcache_tier_find(libcache_tier_t* tier, uint64_t fingerprint, uint64_t* index)
+{
+    uint64_t i = fingerprint & tier->slot_mask;
+    while (0 != tier->slots[i].fingerprint) {
+        if (tier->slots[i].fingerprint == fingerprint) {
+            if (unlikely(libcache_tier_stale(tier, tier->slots[i].position))) {
+                libcache_tier_delete(tier, i);
+                break;
+            }
+            *index = i;
+            return &tier->slots[i];
+        }
+        i = (i + 1) & tier->slot_mask;
+    }
+
+    // Note: the deletion may have shifted slots into the probe, it's done again to get the empty slot
+    i = fingerprint & tier->slot_mask;
+    while (0 != tier->slots[i].fingerprint) {
+        i = (i + 1) & tier->slot_mask;
+    }
+    *index = i;
+    return NULL;
+}
+
+static void libcache_tier_sweep(libcache_tier_t* tier, uint64_t slots)
+{
+    uint64_t i;
+    for (i = 0; i < slots && tier->count > 0; i++) {
+        uint64_t index = tier->sweep;
+        if (0 != tier->slots[index].fingerprint && libcache_tier_stale(tier, tier->slots[index].position)) {
+            // Note: the slot is checked again, another one may be shifted into it
+            libcache_tier_delete(tier, index);
+            continue;
+        }
+        tier->sweep = (index + 1) & tier->slot_mask;
+    }
+}
+
+static void libcache_tier_clear_slots(libcache_tier_t* tier)
+{
+    memset(tier->slots, 0, (size_t) (tier->slot_mask + 1) * sizeof(libcache_tier_slot_t));
+    tier->count = 0;
+    tier->sweep = 0;
+}
+
+/*
+ *  @brief libcache_tier_seal  writes the segment into the file, the next one starts empty.
+ */
+static void libcache_tier_seal(libcache_tier_t* tier)
+{
+    off_t offset = (off_t) (tier->segment_start % tier->file_size);
+    if (unlikely(pwrite(tier->fd, tier->segment, tier->segment_size, offset) != (ssize_t) tier->segment_size)) {
+        // Note: entries of the segment are lost, and what was there may be partly overwritten
+        DEBUG_ERROR("failed to write the segment at %lld of the cold tier", (long long) offset);
+        libcache_tier_clear_slots(tier);
+    }
+    tier->segment_start += tier->segment_size;
+    tier->segment_fill = 0;
+}
+
+void* libcache_tier_create(const char* path, size_t file_size, libcache_scale_t max_entry_number,
+        size_t entry_size)
+{
+    if (unlikely(NULL == path || 0 == max_entry_number || 0 == entry_size || entry_size > UINT32_MAX)) {
+        DEBUG_ERROR("input parameter %s is invalid", "path or max_entry_number or entry_size");
+        return NULL;
+    }
+
+    size_t segment_size = libcache_tier_align(entry_size);
+    if (segment_size < LIBCACHE_TIER_SEGMENT_SIZE) {
+        segment_size = LIBCACHE_TIER_SEGMENT_SIZE;
+    }
+    file_size -= file_size % segment_size;
+    if (unlikely(file_size < segment_size * 2)) {
+        DEBUG_ERROR("file size %zu is less than 2 segments of %zu bytes", file_size, segment_size);
+        return NULL;
+    }
+
+    uint64_t slot_number = 1;
+    while (slot_number < (uint64_t) max_entry_number * 2) {
+        slot_number <<= 1;
+    }
+    size_t slots_offset = libcache_tier_align(sizeof(libcache_tier_t));
+    size_t segment_offset = slots_offset + (size_t) slot_number * sizeof(libcache_tier_slot_t);
+    size_t memory_length = segment_offset + segment_size;
+    libcache_page_e page_type = LIBCACHE_PAGE_NORMAL;
+    char* memory = (char*) libcache_memory_map(memory_length, LIBCACHE_PAGE_NORMAL, 0, &page_type);
+    if (unlikely(NULL == memory)) {
+        DEBUG_ERROR("failed to map %zu bytes for the cold tier", memory_length);
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (unlikely(fd < 0)) {
+        DEBUG_ERROR("failed to open %s", path);
+        libcache_memory_unmap(memory, memory_length, page_type);
+        return NULL;
+    }
+    if (unlikely(0 != ftruncate(fd, (off_t) file_size))) {
+        DEBUG_ERROR("failed to size %s to %zu bytes", path, file_size);
+        close(fd);
+        libcache_memory_unmap(memory, memory_length, page_type);
+        return NULL;
+    }
+
+    // Note: the memory is filled with 0, every slot is empty
+    libcache_tier_t* tier = (libcache_tier_t*) memory;
+    tier->fd = fd;
+    tier->memory_length = memory_length;
+    tier->page_type = page_type;
+    tier->file_size = file_size;
+    tier->segment_size = segment_size;
+    tier->entry_size = entry_size;
+    tier->max_entry_number = max_entry_number;
+    tier->slot_mask = slot_number - 1;
+    tier->slots = (libcache_tier_slot_t*) (memory + slots_offset);
+    tier->segment = memory + segment_offset;
+    return tier;
+}
+
+void libcache_tier_destroy(void* tier)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr)) {
+        return;
+    }
+    close(tier_ptr->fd);
+    libcache_memory_unmap(tier_ptr, tier_ptr->memory_length, tier_ptr->page_type);
+}
+
+int libcache_tier_get_fd(const void* tier)
+{
+    return (NULL == tier) ? -1 : ((const libcache_tier_t*) tier)->fd;
+}
+
+size_t libcache_tier_get_entry_size(const void* tier)
+{
+    return (NULL == tier) ? 0 : ((const libcache_tier_t*) tier)->entry_size;
+}
+
+libcache_scale_t libcache_tier_get_entry_number(void* tier)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr)) {
+        return 0;
+    }
+    libcache_spin_lock(&tier_ptr->lock);
+    libcache_scale_t count = tier_ptr->count;
+    libcache_spin_unlock(&tier_ptr->lock);
+    return count;
+}
+
+void* libcache_tier_reserve(void* tier, const void* key, size_t key_size, size_t entry_length)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr || NULL == key || entry_length > tier_ptr->entry_size)) {
+        DEBUG_ERROR("input parameter %s is invalid", "tier or key or entry_length");
+        return NULL;
+    }
+
+    uint64_t fingerprint = libcache_tier_fingerprint(key, key_size);
+    size_t record_length = libcache_tier_align(entry_length);
+    void* entry = NULL;
+    libcache_spin_lock(&tier_ptr->lock);
+    do {
+        libcache_tier_sweep(tier_ptr, LIBCACHE_TIER_SWEEP);
+        uint64_t index = 0;
+        libcache_tier_slot_t* slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+        if (NULL == slot && tier_ptr->count >= tier_ptr->max_entry_number) {
+            libcache_tier_sweep(tier_ptr, LIBCACHE_TIER_FULL_SWEEP);
+            if (tier_ptr->count >= tier_ptr->max_entry_number) {
+                break;
+            }
+            slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+        }
+
+        if (tier_ptr->segment_fill + record_length > tier_ptr->segment_size) {
+            // Note: sealing makes positions stale, the slot found may be one of them
+            libcache_tier_seal(tier_ptr);
+            slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+        }
+        if (NULL == slot) {
+            slot = &tier_ptr->slots[index];
+            slot->fingerprint = fingerprint;
+            tier_ptr->count++;
+        }
+        slot->position = tier_ptr->segment_start + tier_ptr->segment_fill;
+        slot->entry_length = (uint32_t) entry_length;
+        entry = tier_ptr->segment + tier_ptr->segment_fill;
+        tier_ptr->segment_fill += record_length;
+    } while (0);
+    libcache_spin_unlock(&tier_ptr->lock);
+    return entry;
+}
+
+int libcache_tier_put(void* tier, const void* key, size_t key_size, const void* entry, size_t entry_length)
+{
+    void* reserved = libcache_tier_reserve(tier, key, key_size, entry_length);
+    if (NULL == reserved) {
+        return FALSE;
+    }
+    memcpy(reserved, entry, entry_length);
+    return TRUE;
+}
+
+int libcache_tier_locate(void* tier, const void* key, size_t key_size, void* entry,
+        libcache_tier_location_t* location)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr || NULL == key || NULL == entry || NULL == location)) {
+        DEBUG_ERROR("input parameter %s is null", "tier or key or entry or location");
+        return FALSE;
+    }
+
+    uint64_t fingerprint = libcache_tier_fingerprint(key, key_size);
+    uint64_t index = 0;
+    libcache_spin_lock(&tier_ptr->lock);
+    libcache_tier_slot_t* slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+    if (NULL != slot) {
+        location->entry_length = slot->entry_length;
+        if (slot->position >= tier_ptr->segment_start) {
+            location->offset = -1;
+            memcpy(entry, tier_ptr->segment + (slot->position - tier_ptr->segment_start), slot->entry_length);
+        } else {
+            location->offset = (int64_t) (slot->position % tier_ptr->file_size);
+        }
+    }
+    libcache_spin_unlock(&tier_ptr->lock);
+    return NULL != slot;
+}
+
+int libcache_tier_read(void* tier, const void* key, size_t key_size, void* entry, size_t* entry_length)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == entry_length)) {
+        DEBUG_ERROR("input parameter %s is null", "entry_length");
+        return FALSE;
+    }
+
+    libcache_tier_location_t location;
+    if (!libcache_tier_locate(tier_ptr, key, key_size, entry, &location)) {
+        return FALSE;
+    }
+    *entry_length = location.entry_length;
+    if (location.offset < 0) {
+        return TRUE;
+    }
+
+    if (unlikely(pread(tier_ptr->fd, entry, location.entry_length, (off_t) location.offset)
+            != (ssize_t) location.entry_length)) {
+        DEBUG_ERROR("failed to read %zu bytes at %lld of the cold tier", location.entry_length,
+                (long long) location.offset);
+        return FALSE;
+    }
+
+    // Note: the log may have wrapped onto the entry while it was read, then the copy is lost
+    uint64_t fingerprint = libcache_tier_fingerprint(key, key_size);
+    uint64_t index = 0;
+    libcache_spin_lock(&tier_ptr->lock);
+    libcache_tier_slot_t* slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+    int valid = (NULL != slot && slot->position % tier_ptr->file_size == (uint64_t) location.offset
+            && slot->position < tier_ptr->segment_start);
+    libcache_spin_unlock(&tier_ptr->lock);
+    return valid;
+}
+
+int libcache_tier_remove(void* tier, const void* key, size_t key_size)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr || NULL == key)) {
+        DEBUG_ERROR("input parameter %s is null", "tier or key");
+        return FALSE;
+    }
+
+    uint64_t fingerprint = libcache_tier_fingerprint(key, key_size);
+    uint64_t index = 0;
+    libcache_spin_lock(&tier_ptr->lock);
+    libcache_tier_slot_t* slot = libcache_tier_find(tier_ptr, fingerprint, &index);
+    if (NULL != slot) {
+        libcache_tier_delete(tier_ptr, index);
+    }
+    libcache_spin_unlock(&tier_ptr->lock);
+    return NULL != slot;
+}
+
+void libcache_tier_clear(void* tier)
+{
+    libcache_tier_t* tier_ptr = (libcache_tier_t*) tier;
+    if (unlikely(NULL == tier_ptr)) {
+        return;
+    }
+    libcache_spin_lock(&tier_ptr->lock);
+    libcache_tier_clear_slots(tier_ptr);
+    libcache_spin_unlock(&tier_ptr->lock);
+}
@@ -0,0 +1,146 @@
+/*
+ * libcache_ttl.c
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "libcache_ttl.h"
+
+#define LIBCACHE_TTL_MASK (LIBCACHE_TTL_SLOTS - 1)
+#define LIBCACHE_TTL_SHIFT(level) (LIBCACHE_TTL_SLOT_BITS * (level))
+
+void libcache_ttl_init(libcache_ttl_wheel_t* wheel, uint32_t clock)
+{
+    uint32_t i;
+    wheel->clock = clock;
+    wheel->now = clock;
+    wheel->count = 0;
+    memset(wheel->occupied, 0, sizeof(wheel->occupied));
+    for (i = 0; i < LIBCACHE_TTL_LEVELS * LIBCACHE_TTL_SLOTS; i++) {
+        list_init(&wheel->slots[i]);
+    }
+}
+
+/*
+ *  @brief libcache_ttl_place    links an entry into the slot of its expiry, relative to the time of the wheel.
+ */
+static void libcache_ttl_place(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t* entry)
+{
+    // Note: an expired entry is due now, one beyond the range waits in the farthest slot of the top level
+    uint64_t expire = (entry->expire_at > wheel->now) ? entry->expire_at : wheel->now;
+    uint64_t delta = expire - wheel->now;
+    if (unlikely(delta >= LIBCACHE_TTL_RANGE)) {
+        delta = LIBCACHE_TTL_RANGE - 1;
+        expire = (uint64_t) wheel->now + delta;
+    }
+    uint32_t level = 0;
+    while (level < LIBCACHE_TTL_LEVELS - 1 && delta >= (1ULL << LIBCACHE_TTL_SHIFT(level + 1))) {
+        level++;
+    }
+    uint32_t index = (uint32_t) (expire >> LIBCACHE_TTL_SHIFT(level)) & LIBCACHE_TTL_MASK;
+    entry->slot = (uint16_t) (level * LIBCACHE_TTL_SLOTS + index);
+    list_push_back(&wheel->slots[entry->slot], &entry->wheel_node);
+    wheel->occupied[level] |= 1ULL << index;
+}
+
+void libcache_ttl_arm(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t* entry)
+{
+    libcache_ttl_place(wheel, entry);
+    wheel->count++;
+}
+
+void libcache_ttl_disarm(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t* entry)
+{
+    if (LIBCACHE_TTL_UNLINKED == entry->slot) {
+        return;
+    }
+    list_t* slot = &wheel->slots[entry->slot];
+    list_remove(slot, &entry->wheel_node);
+    if (list_empty(slot)) {
+        wheel->occupied[entry->slot / LIBCACHE_TTL_SLOTS] &= ~(1ULL << (entry->slot & LIBCACHE_TTL_MASK));
+    }
+    entry->slot = LIBCACHE_TTL_UNLINKED;
+    wheel->count--;
+}
+
+/*
+ *  @brief libcache_ttl_next_event  gets the earliest time after now a slot holding entries is reached.
+ *
+ *  NOTE:  Slot i of level L is reached when time enters it, at a multiple of 64^L. Slots up to the one
+ *         of now are reached in the next turn of the level, there's no slot of the current turn left there.
+ */
+static uint64_t libcache_ttl_next_event(const libcache_ttl_wheel_t* wheel)
+{
+    uint64_t next = UINT64_MAX;
+    uint32_t level;
+    for (level = 0; level < LIBCACHE_TTL_LEVELS; level++) {
+        uint64_t bitmap = wheel->occupied[level];
+        if (0 == bitmap) {
+            continue;
+        }
+        uint32_t shift = LIBCACHE_TTL_SHIFT(level);
+        uint32_t index = (wheel->now >> shift) & LIBCACHE_TTL_MASK;
+        uint64_t ahead = (LIBCACHE_TTL_MASK == index) ? 0 : bitmap & (~0ULL << (index + 1));
+        uint64_t turn = (uint64_t) wheel->now >> (shift + LIBCACHE_TTL_SLOT_BITS) << (shift + LIBCACHE_TTL_SLOT_BITS);
+        uint64_t time = (0 != ahead) ? turn + ((uint64_t) __builtin_ctzll(ahead) << shift)
+                : turn + ((uint64_t) (LIBCACHE_TTL_SLOTS + __builtin_ctzll(bitmap)) << shift);
+        if (time < next) {
+            next = time;
+        }
+    }
+    return next;
+}
+
+/*
+ *  @brief libcache_ttl_cascade  places every entry of the slots reached at now again, one level down or more.
+ */
+static void libcache_ttl_cascade(libcache_ttl_wheel_t* wheel)
+{
+    uint32_t level;
+    for (level = 1; level < LIBCACHE_TTL_LEVELS; level++) {
+        uint32_t shift = LIBCACHE_TTL_SHIFT(level);
+        if (0 != (wheel->now & ((1U << shift) - 1))) {
+            break;
+        }
+        uint32_t index = (wheel->now >> shift) & LIBCACHE_TTL_MASK;
+        if (0 == (wheel->occupied[level] & (1ULL << index))) {
+            continue;
+        }
+
+        // Note: entries leave the slot before any is placed, an entry parked at the top level may come back
+        list_t pending = wheel->slots[level * LIBCACHE_TTL_SLOTS + index];
+        list_init(&wheel->slots[level * LIBCACHE_TTL_SLOTS + index]);
+        wheel->occupied[level] &= ~(1ULL << index);
+        while (!list_empty(&pending)) {
+            libcache_ttl_place(wheel, (libcache_ttl_entry_t*) list_pop_front(&pending));
+        }
+    }
+}
+
+node_t* libcache_ttl_advance(libcache_ttl_wheel_t* wheel)
+{
+    while (1) {
+        list_t* slot = &wheel->slots[wheel->now & LIBCACHE_TTL_MASK];
+        if (!list_empty(slot)) {
+            return list_front(slot);
+        }
+        if (wheel->now >= wheel->clock) {
+            return NULL;
+        }
+        if (0 == wheel->count) {
+            wheel->now = wheel->clock;
+            return NULL;
+        }
+
+        // Note: nothing happens before the next event, time jumps to it, or to the clock if it's later
+        uint64_t next = libcache_ttl_next_event(wheel);
+        if (next > wheel->clock) {
+            wheel->now = wheel->clock;
+            return NULL;
+        }
+        wheel->now = (uint32_t) next;
+        libcache_ttl_cascade(wheel);
+    }
+}
@@ -1,37 +1,42 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include "list.h"
 #include "libpool.h"
+#include "libcache_spinlock.h"
 
 #define MAGIC_CHECK_VALUE (89757)
 #define POOL_HEAD_LENGTH  (sizeof(element_pool_t))
 
-static inline size_t pool_caculate_nodes_length(int entry_acount)
-{
-    return sizeof(node_t) * entry_acount;
-}
-
-static inline size_t pool_caculate_element_length(size_t entry_size)
+static inline size_t pool_caculate_element_length(size_t entry_size, size_t entry_align)
 {
     while ((entry_size) % 8 != 0) {
         entry_size += 1;
     }
-    return sizeof(element_usr_data_t) + entry_size;
+    size_t element_length = sizeof(element_usr_data_t) + entry_size;
+    // Note: element stride is a multiple of alignment, so all elements are aligned as the first one
+    if (entry_align > 1) {
+        element_length = (element_length + entry_align - 1) / entry_align * entry_align;
+    }
+    return element_length;
 }
 
-static inline size_t pool_caculate_elements_length(size_t entry_size, int entry_acount)
+static inline size_t pool_caculate_elements_length(size_t entry_size, int entry_acount, size_t entry_align)
 {
-    return pool_caculate_element_length(entry_size) * entry_acount;
+    return pool_caculate_element_length(entry_size, entry_align) * entry_acount;
 }
 
-static size_t pool_caculate_length(size_t entry_size, int entry_acount)
+static size_t pool_caculate_length(size_t entry_size, int entry_acount, size_t entry_align)
 {
     size_t pool_head_length = POOL_HEAD_LENGTH;
-    size_t nodes_length = pool_caculate_nodes_length(entry_acount);
-    size_t elements_length = pool_caculate_elements_length(entry_size, entry_acount);
+    size_t elements_length = pool_caculate_elements_length(entry_size, entry_acount, entry_align);
 
-    return pool_head_length + nodes_length + elements_length;
+    // Note: reserve room to align the first element
+    size_t align_length = (entry_align > 1) ? entry_align : 0;
+    return pool_head_length + elements_length + align_length;
 }
 
 size_t pool_caculate_total_length(int pool_acount, pool_attr_t pool_attr[])
@@ -40,29 +45,28 @@ size_t pool_caculate_total_length(int pool_acount, pool_attr_t pool_attr[])
     int i;
     size_t pools_length = 0;
     for (i = 0; i < pool_acount; i++) {
-        size_t pool_length = pool_caculate_length(pool_attr[i].entry_size, pool_attr[i].entry_acount);
+        size_t pool_length = pool_caculate_length(pool_attr[i].entry_size, pool_attr[i].entry_acount,
+                pool_attr[i].entry_align);
         pools_length = pools_length + pool_length;
     }
 
     return pools_head_size + pools_length;
 }
-static node_t* pool_get_node_addr(element_pool_t* pool, int j)
+static inline element_usr_data_t* pool_get_element_addr(element_pool_t* pool, uint32_t j)
 {
-    node_t* nodes_start_mem = (node_t*)((char*) pool + POOL_HEAD_LENGTH);
-    return nodes_start_mem + j;
+    element_usr_data_t* elements_start_mem = (element_usr_data_t*) ((char*) pool + pool->elements_offset);
+
+    return (element_usr_data_t*) ((char*) elements_start_mem + pool->element_size * j);
 }
 
-static element_usr_data_t* pool_get_element_addr(element_pool_t* pool, int j)
+static inline uint32_t pool_get_element_index(element_pool_t* pool, element_usr_data_t* element_user_data)
 {
-    element_usr_data_t* elements_start_mem = (element_usr_data_t*) ((char*) pool + POOL_HEAD_LENGTH
-            + pool_caculate_nodes_length(pool->element_acount));
-
-    return (element_usr_data_t*) ((char*) elements_start_mem + pool->element_size * j);
+    return (uint32_t) (((char*) element_user_data - ((char*) pool + pool->elements_offset)) / pool->element_size);
 }
 
 // | element_pool_t* pools[ 0, 1, ... ] |
-// | element_pool_t pools 0 | + | node_t 0.0 | node 0.1 | ... | + | element_usr_data_t 0.0 | entry_0.0 | ... |
-// | element_pool_t pools 1 | + | node_t 1.0 | node 1.1 | ... | + | element_usr_data_t 1.0 | entry_1.0 | ... |
+// | element_pool_t pools 0 | + | element_usr_data_t 0.0 | entry_0.0 | ... |
+// | element_pool_t pools 1 | + | element_usr_data_t 1.0 | entry_1.0 | ... |
 // | ... |
 void* pools_init(void* large_memory, size_t large_mem_size, int pool_acount, pool_attr_t pool_attr[])
 {
@@ -79,26 +83,26 @@ void* pools_init(void* large_memory, size_t large_mem_size, int pool_acount, poo
 
         memset(pool, '\0', sizeof(element_pool_t));
 
-        list_init(&pool->free_list);
+        pool->free_head = POOL_INDEX_NONE;
+        pool->free_count = 0;
 
-        pool->element_size = pool_caculate_element_length(pool_attr[i].entry_size);
+        pool->element_size = pool_caculate_element_length(pool_attr[i].entry_size, pool_attr[i].entry_align);
         pool->element_acount = pool_attr[i].entry_acount;
-
-        int j;
-        for (j = 0; j < pool->element_acount; j++) {
-            node_t* node = pool_get_node_addr(pool, j);
-            element_usr_data_t* elements_addr = pool_get_element_addr(pool, j);
-
-            elements_addr->check_value = MAGIC_CHECK_VALUE;
-            elements_addr->reserved_pointer = NULL;
-            elements_addr->to_node = node;
-
-            node->usr_data = (void*) (elements_addr + 1);
-
-            list_push_back(&pool->free_list, node);
+        pool->elements_offset = POOL_HEAD_LENGTH;
+        if (pool_attr[i].entry_align > 1) {
+            // Note: it's the memory after element_usr_data_t which is returned to user and aligned
+            size_t first_element = (size_t) ((char*) pool + pool->elements_offset + sizeof(element_usr_data_t));
+            size_t misalign = first_element % pool_attr[i].entry_align;
+            if (misalign != 0) {
+                pool->elements_offset += pool_attr[i].entry_align - misalign;
+            }
         }
 
-        size_t pool_length = pool_caculate_length(pool_attr[i].entry_size, pool_attr[i].entry_acount);
+        // Note: elements are initialized when they're handed out the first time, see pool_get_element
+        pool->high_water = 0;
+
+        size_t pool_length = pool_caculate_length(pool_attr[i].entry_size, pool_attr[i].entry_acount,
+                pool_attr[i].entry_align);
         pool = (element_pool_t*) ((char*) pool + pool_length);
     }
 
@@ -110,9 +114,29 @@ inline void* pool_get_element(void* pools, int pool_type)
 {
     element_pool_t *pool = ((element_pool_t**) pools)[pool_type];
 
-    node_t *node = list_pop_back(&pool->free_list);
+    element_usr_data_t* elements_addr;
+    // Note: the last freed element first, its memory is the most likely in CPU cache
+    if (likely(pool->free_head != POOL_INDEX_NONE)) {
+        elements_addr = pool_get_element_addr(pool, pool->free_head);
+        pool->free_head = elements_addr->next_free;
+        pool->free_count--;
+        pool->get_total++;
+        return (void*) (elements_addr + 1);
+    }
 
-    return (node == NULL) ? NULL : node->usr_data;
+    // Note: no recycled element, hand out a never used one, its memory is touched the first time here
+    if (unlikely(pool->high_water >= pool->element_acount)) {
+        pool->fail_total++;
+        return NULL;
+    }
+    elements_addr = pool_get_element_addr(pool, (uint32_t) pool->high_water);
+    pool->high_water++;
+    pool->get_total++;
+
+    elements_addr->check_value = MAGIC_CHECK_VALUE;
+    elements_addr->reserved_pointer = NULL;
+    elements_addr->next_free = POOL_INDEX_NONE;
+    return (void*) (elements_addr + 1);
 }
 
 static inline void* pool_get_element_head(void* element)
@@ -136,8 +160,54 @@ inline void pool_free_element(void *pools, int pool_type, void* element)
 
     element_user_data->reserved_pointer = NULL;
 
+    // Note: only the header is written, contents of a freed element are kept
     element_pool_t *pool = ((element_pool_t**) pools)[pool_type];
-    list_push_front(&pool->free_list, element_user_data->to_node);
+    element_user_data->next_free = pool->free_head;
+    pool->free_head = pool_get_element_index(pool, element_user_data);
+    pool->free_count++;
+    pool->free_total++;
+}
+
+void* pool_get_element_at(void* pools, int pool_type, uint32_t index)
+{
+    element_pool_t *pool = ((element_pool_t**) pools)[pool_type];
+    if (unlikely((long long) index >= pool->high_water)) {
+        return NULL;
+    }
+    return (void*) (pool_get_element_addr(pool, index) + 1);
+}
+
+return_t pool_get_stats(void* pools, int pool_type, pool_stats_t* stats)
+{
+    if (unlikely(pools == NULL || stats == NULL)) {
+        DEBUG_ERROR("input parameter %s is null", "pools or stats");
+        return ERR;
+    }
+
+    const element_pool_t *pool = ((element_pool_t**) pools)[pool_type];
+    stats->element_size = (size_t) pool->element_size;
+    stats->capacity = (unsigned long long) pool->element_acount;
+    stats->in_use = (unsigned long long) pool->high_water - pool->free_count;
+    // Note: free elements are reused before a never used one, so high water is the peak of in use
+    stats->peak = (unsigned long long) ((pool->high_water > pool->peak) ? pool->high_water : pool->peak);
+    stats->get_total = pool->get_total;
+    stats->free_total = pool->free_total;
+    stats->fail_total = pool->fail_total;
+    return OK;
+}
+
+void pool_reset(void* pools, int pool_type)
+{
+    element_pool_t *pool = ((element_pool_t**) pools)[pool_type];
+    if (pool->high_water > pool->peak) {
+        pool->peak = pool->high_water;
+    }
+
+    // Note: every element is never used again, headers are written when they're handed out next time
+    pool->free_total += (unsigned long long) (pool->high_water - pool->free_count);
+    pool->high_water = 0;
+    pool->free_head = POOL_INDEX_NONE;
+    pool->free_count = 0;
 }
 
 return_t pool_set_reserved_pointer(void* element, void* to_set)
@@ -161,3 +231,371 @@ void* pool_get_reserved_pointer(void* element)
     return (element_user_data == NULL) ? NULL : element_user_data->reserved_pointer;
 }
 
+/*
+ * | pool_slab_t | class of every slab | slab 0 | slab 1 | ... |
+ * A free element links to the next one of its class by 8 bytes offset from the first slab,
+ * so slab memory can be up to 32G.
+ */
+#define POOL_SLAB_UNIT 8
+#define POOL_SLAB_MAX_MEMORY ((size_t) POOL_SLAB_UNIT * POOL_INDEX_NONE)
+
+typedef struct pool_slab_class_t {
+    long long element_size;  /* with element_usr_data_t */
+    long long carve_offset;  /* never used elements of its current slab are from here to carve_end */
+    long long carve_end;
+    uint32_t free_head;
+    uint32_t free_count;
+} pool_slab_class_t;
+
+typedef struct pool_slab_t {
+    long long slabs_offset;  /* from pool_slab_t to slab 0 */
+    long long slab_size;
+    uint32_t slab_count;
+    uint32_t slab_used;      /* slabs from it on have never been given to a class */
+    uint32_t class_count;
+    pool_slab_class_t classes[POOL_SLAB_MAX_CLASSES];
+} pool_slab_t;
+
+static inline size_t pool_slab_round(size_t size)
+{
+    return (size + POOL_SLAB_UNIT - 1) / POOL_SLAB_UNIT * POOL_SLAB_UNIT;
+}
+
+static size_t pool_slab_caculate_slab_size(size_t max_element_size)
+{
+    size_t largest = sizeof(element_usr_data_t) + pool_slab_round(max_element_size);
+    return (largest > POOL_SLAB_SIZE) ? largest : POOL_SLAB_SIZE;
+}
+
+static inline size_t pool_slab_caculate_slab_count(size_t memory_size, size_t max_element_size)
+{
+    return memory_size / pool_slab_caculate_slab_size(max_element_size);
+}
+
+size_t pool_slab_caculate_length(size_t memory_size, size_t max_element_size)
+{
+    size_t slab_count = pool_slab_caculate_slab_count(memory_size, max_element_size);
+    return pool_slab_round(sizeof(pool_slab_t) + slab_count)
+            + slab_count * pool_slab_caculate_slab_size(max_element_size);
+}
+
+void* pool_slab_init(void* memory, size_t memory_size, size_t max_element_size)
+{
+    if (unlikely(NULL == memory || max_element_size == 0 || memory_size > POOL_SLAB_MAX_MEMORY)) {
+        DEBUG_ERROR("input parameter %s is invalid", "memory or memory_size or max_element_size");
+        return NULL;
+    }
+
+    pool_slab_t* slab = (pool_slab_t*) memory;
+    memset(slab, 0, sizeof(pool_slab_t));
+    slab->slab_size = pool_slab_caculate_slab_size(max_element_size);
+    slab->slab_count = pool_slab_caculate_slab_count(memory_size, max_element_size);
+    slab->slabs_offset = pool_slab_round(sizeof(pool_slab_t) + slab->slab_count);
+    slab->slab_used = 0;
+
+    // Note: class sizes grow by factor, the last one is max_element_size
+    size_t size = POOL_SLAB_MIN_SIZE;
+    size_t max_size = pool_slab_round(max_element_size);
+    uint32_t i = 0;
+    while (1) {
+        if (size >= max_size || i == POOL_SLAB_MAX_CLASSES - 1) {
+            size = max_size;
+        }
+        pool_slab_class_t* slab_class = &slab->classes[i++];
+        slab_class->element_size = sizeof(element_usr_data_t) + size;
+        slab_class->carve_offset = 0;
+        slab_class->carve_end = 0;
+        slab_class->free_head = POOL_INDEX_NONE;
+        slab_class->free_count = 0;
+        if (size == max_size) {
+            break;
+        }
+        size_t next = pool_slab_round((size_t) (size * POOL_SLAB_GROWTH_FACTOR));
+        size = (next > size) ? next : size + POOL_SLAB_UNIT;
+    }
+    slab->class_count = i;
+    return slab;
+}
+
+static inline uint8_t* pool_slab_get_classes_of_slabs(pool_slab_t* slab)
+{
+    return (uint8_t*) (slab + 1);
+}
+
+static inline char* pool_slab_get_memory(pool_slab_t* slab)
+{
+    return (char*) slab + slab->slabs_offset;
+}
+
+void* pool_slab_get_element(void* slab_handle, size_t size)
+{
+    pool_slab_t* slab = (pool_slab_t*) slab_handle;
+    uint32_t i;
+    for (i = 0; i < slab->class_count; i++) {
+        if (slab->classes[i].element_size - sizeof(element_usr_data_t) >= size) {
+            break;
+        }
+    }
+    if (unlikely(i == slab->class_count)) {
+        DEBUG_ERROR("element size %zu is too large", size);
+        return NULL;
+    }
+
+    pool_slab_class_t* slab_class = &slab->classes[i];
+    element_usr_data_t* element_user_data;
+    if (likely(slab_class->free_head != POOL_INDEX_NONE)) {
+        element_user_data = (element_usr_data_t*) (pool_slab_get_memory(slab)
+                + (size_t) slab_class->free_head * POOL_SLAB_UNIT);
+        slab_class->free_head = element_user_data->next_free;
+        slab_class->free_count--;
+        return (void*) (element_user_data + 1);
+    }
+
+    // Note: carve a never used element, the class takes a new slab when its current one is used up
+    if (slab_class->carve_end - slab_class->carve_offset < slab_class->element_size) {
+        if (unlikely(slab->slab_used >= slab->slab_count)) {
+            return NULL;
+        }
+        pool_slab_get_classes_of_slabs(slab)[slab->slab_used] = (uint8_t) i;
+        slab_class->carve_offset = (long long) slab->slab_used * slab->slab_size;
+        slab_class->carve_end = slab_class->carve_offset + slab->slab_size;
+        slab->slab_used++;
+    }
+    element_user_data = (element_usr_data_t*) (pool_slab_get_memory(slab) + slab_class->carve_offset);
+    slab_class->carve_offset += slab_class->element_size;
+
+    element_user_data->check_value = MAGIC_CHECK_VALUE;
+    element_user_data->reserved_pointer = NULL;
+    element_user_data->next_free = POOL_INDEX_NONE;
+    return (void*) (element_user_data + 1);
+}
+
+static inline uint8_t pool_slab_get_class_index(const pool_slab_t* slab, const element_usr_data_t* element_user_data)
+{
+    size_t offset = (size_t) ((const char*) element_user_data - ((const char*) slab + slab->slabs_offset));
+    return ((const uint8_t*) (slab + 1))[offset / slab->slab_size];
+}
+
+void pool_slab_free_element(void* slab_handle, void* element)
+{
+    if (unlikely(element == NULL)) {
+        return;
+    }
+
+    pool_slab_t* slab = (pool_slab_t*) slab_handle;
+    element_usr_data_t *element_user_data = ((element_usr_data_t*) element - 1);
+    element_user_data->reserved_pointer = NULL;
+
+    pool_slab_class_t* slab_class = &slab->classes[pool_slab_get_class_index(slab, element_user_data)];
+    element_user_data->next_free = slab_class->free_head;
+    slab_class->free_head = (uint32_t) (((char*) element_user_data - pool_slab_get_memory(slab)) / POOL_SLAB_UNIT);
+    slab_class->free_count++;
+}
+
+void pool_slab_reset(void* slab_handle)
+{
+    pool_slab_t* slab = (pool_slab_t*) slab_handle;
+    uint32_t i;
+    for (i = 0; i < slab->class_count; i++) {
+        slab->classes[i].carve_offset = 0;
+        slab->classes[i].carve_end = 0;
+        slab->classes[i].free_head = POOL_INDEX_NONE;
+        slab->classes[i].free_count = 0;
+    }
+    slab->slab_used = 0;
+}
+
+size_t pool_slab_get_element_size(const void* slab_handle, const void* element)
+{
+    const pool_slab_t* slab = (const pool_slab_t*) slab_handle;
+    const element_usr_data_t *element_user_data = ((const element_usr_data_t*) element - 1);
+    return slab->classes[pool_slab_get_class_index(slab, element_user_data)].element_size - sizeof(element_usr_data_t);
+}
+
+/*
+ * Depot locks of different pool types don't share cache line.
+ */
+typedef union pool_depot_lock_t {
+    libcache_spinlock_t lock;
+    char padding[LIBCACHE_CACHE_LINE_SIZE];
+} pool_depot_lock_t;
+
+typedef struct pool_depot_t {
+    void* pools;
+    int pool_count;
+    LIBCACHE_ALLOCATE_MEMORY* allocate_memory;
+    LIBCACHE_FREE_MEMORY* free_memory;
+    void* memory;              /* memory of locks, to be freed */
+    pool_depot_lock_t* locks;  /* one for every pool type, cache line aligned */
+} pool_depot_t;
+
+typedef struct pool_magazine_stack_t {
+    int rounds;
+    void* elements[POOL_MAGAZINE_SIZE];
+} pool_magazine_stack_t;
+
+/* loaded is used first, previous makes a thread alternating get and free never go to depot */
+typedef struct pool_magazine_pair_t {
+    pool_magazine_stack_t* loaded;
+    pool_magazine_stack_t* previous;
+    pool_magazine_stack_t stacks[2];
+} pool_magazine_pair_t;
+
+typedef struct pool_magazine_t {
+    pool_depot_t* depot;
+    pool_magazine_pair_t pairs[];  /* one for every pool type */
+} pool_magazine_t;
+
+void* pool_depot_create(void* pools, int pool_count, LIBCACHE_ALLOCATE_MEMORY* allocate_memory,
+        LIBCACHE_FREE_MEMORY* free_memory)
+{
+    if (unlikely(NULL == pools || pool_count <= 0 || NULL == allocate_memory || NULL == free_memory)) {
+        DEBUG_ERROR("input parameter %s is invalid", "pools or pool_count or allocate_memory or free_memory");
+        return NULL;
+    }
+
+    pool_depot_t* depot = (pool_depot_t*) allocate_memory(sizeof(pool_depot_t));
+    if (unlikely(NULL == depot)) {
+        return NULL;
+    }
+    depot->memory = allocate_memory(sizeof(pool_depot_lock_t) * pool_count + LIBCACHE_CACHE_LINE_SIZE);
+    if (unlikely(NULL == depot->memory)) {
+        free_memory(depot);
+        return NULL;
+    }
+    size_t misalign = (size_t) depot->memory % LIBCACHE_CACHE_LINE_SIZE;
+    depot->locks = (pool_depot_lock_t*) ((char*) depot->memory + ((misalign == 0) ? 0 : LIBCACHE_CACHE_LINE_SIZE - misalign));
+    memset(depot->locks, 0, sizeof(pool_depot_lock_t) * pool_count);
+
+    depot->pools = pools;
+    depot->pool_count = pool_count;
+    depot->allocate_memory = allocate_memory;
+    depot->free_memory = free_memory;
+    return depot;
+}
+
+void pool_depot_destroy(void* depot)
+{
+    pool_depot_t* depot_ptr = (pool_depot_t*) depot;
+    if (unlikely(NULL == depot_ptr)) {
+        return;
+    }
+    LIBCACHE_FREE_MEMORY* free_memory = depot_ptr->free_memory;
+    free_memory(depot_ptr->memory);
+    free_memory(depot_ptr);
+}
+
+void* pool_magazine_create(void* depot)
+{
+    pool_depot_t* depot_ptr = (pool_depot_t*) depot;
+    if (unlikely(NULL == depot_ptr)) {
+        DEBUG_ERROR("input parameter %s is null", "depot");
+        return NULL;
+    }
+
+    pool_magazine_t* magazine = (pool_magazine_t*) depot_ptr->allocate_memory(sizeof(pool_magazine_t)
+            + sizeof(pool_magazine_pair_t) * depot_ptr->pool_count);
+    if (unlikely(NULL == magazine)) {
+        return NULL;
+    }
+    magazine->depot = depot_ptr;
+    int i;
+    for (i = 0; i < depot_ptr->pool_count; i++) {
+        pool_magazine_pair_t* pair = &magazine->pairs[i];
+        pair->stacks[0].rounds = 0;
+        pair->stacks[1].rounds = 0;
+        pair->loaded = &pair->stacks[0];
+        pair->previous = &pair->stacks[1];
+    }
+    return magazine;
+}
+
+/*
+ *  @brief pool_magazine_fill  fills an empty magazine stack with free elements of depot.
+ */
+static void pool_magazine_fill(pool_depot_t* depot, int pool_type, pool_magazine_stack_t* stack)
+{
+    libcache_spin_lock(&depot->locks[pool_type].lock);
+    while (stack->rounds < POOL_MAGAZINE_SIZE) {
+        void* element = pool_get_element(depot->pools, pool_type);
+        if (NULL == element) {
+            break;
+        }
+        stack->elements[stack->rounds++] = element;
+    }
+    libcache_spin_unlock(&depot->locks[pool_type].lock);
+}
+
+/*
+ *  @brief pool_magazine_flush  gives all elements of a magazine stack back to depot.
+ */
+static void pool_magazine_flush(pool_depot_t* depot, int pool_type, pool_magazine_stack_t* stack)
+{
+    libcache_spin_lock(&depot->locks[pool_type].lock);
+    while (stack->rounds > 0) {
+        pool_free_element(depot->pools, pool_type, stack->elements[--stack->rounds]);
+    }
+    libcache_spin_unlock(&depot->locks[pool_type].lock);
+}
+
+void pool_magazine_destroy(void* magazine)
+{
+    pool_magazine_t* magazine_ptr = (pool_magazine_t*) magazine;
+    if (unlikely(NULL == magazine_ptr)) {
+        return;
+    }
+    int i;
+    for (i = 0; i < magazine_ptr->depot->pool_count; i++) {
+        pool_magazine_flush(magazine_ptr->depot, i, magazine_ptr->pairs[i].loaded);
+        pool_magazine_flush(magazine_ptr->depot, i, magazine_ptr->pairs[i].previous);
+    }
+    magazine_ptr->depot->free_memory(magazine_ptr);
+}
+
+static inline void pool_magazine_swap(pool_magazine_pair_t* pair)
+{
+    pool_magazine_stack_t* stack = pair->loaded;
+    pair->loaded = pair->previous;
+    pair->previous = stack;
+}
+
+void* pool_magazine_get_element(void* magazine, int pool_type)
+{
+    pool_magazine_t* magazine_ptr = (pool_magazine_t*) magazine;
+    pool_magazine_pair_t* pair = &magazine_ptr->pairs[pool_type];
+    if (likely(pair->loaded->rounds > 0)) {
+        return pair->loaded->elements[--pair->loaded->rounds];
+    }
+
+    if (pair->previous->rounds > 0) {
+        pool_magazine_swap(pair);
+    } else {
+        // Note: both are empty, fill one from depot
+        pool_magazine_fill(magazine_ptr->depot, pool_type, pair->loaded);
+        if (unlikely(pair->loaded->rounds == 0)) {
+            return NULL;
+        }
+    }
+    return pair->loaded->elements[--pair->loaded->rounds];
+}
+
+void pool_magazine_free_element(void* magazine, int pool_type, void* element)
+{
+    if (unlikely(element == NULL)) {
+        return;
+    }
+
+    // Note: same as pool_free_element, a free element has no reserved pointer
+    ((element_usr_data_t*) element - 1)->reserved_pointer = NULL;
+
+    pool_magazine_t* magazine_ptr = (pool_magazine_t*) magazine;
+    pool_magazine_pair_t* pair = &magazine_ptr->pairs[pool_type];
+    if (unlikely(pair->loaded->rounds == POOL_MAGAZINE_SIZE)) {
+        // Note: both are full, give the previous one back to depot
+        if (pair->previous->rounds == POOL_MAGAZINE_SIZE) {
+            pool_magazine_flush(magazine_ptr->depot, pool_type, pair->previous);
+        }
+        pool_magazine_swap(pair);
+    }
+    pair->loaded->elements[pair->loaded->rounds++] = element;
+}
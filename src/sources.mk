@@ -0,0 +1,7 @@
+# sources of the library, included by src, ut and bench Makefiles, names are relative to src
+LIBCACHE_SRC=libcache.c libpool.c list.c hash.c libcache_policy.c libcache_sharded.c libcache_memory.c libcache_compact.c libcache_stats.c libcache_hash.c libcache_ttl.c libcache_filter.c libcache_compress.c libcache_tier.c libcache_btree.c libcache_local.c libcache_replication.c
+
+# the library as one translation unit, hot paths inline across modules, e.g. make amalgamated=yes
+ifeq ($(amalgamated), yes)
+LIBCACHE_SRC=libcache_amalgam.c
+endif
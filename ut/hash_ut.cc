@@ -22,8 +22,17 @@ static uint32_t test_key_to_int(const void* key)
     return *value;
 }
 
+static uint32_t test_key_to_zero(const void* key)
+{
+    (void) key;
+    return 0;
+}
+
+static int g_key_cmp_count = 0;
+
 static libcache_cmp_ret_t test_key_com(const void* key1, const void* key2)
 {
+    g_key_cmp_count++;
     uint32_t* a = (uint32_t*) key1;
     uint32_t* b = (uint32_t*) key2;
 
@@ -152,6 +161,26 @@ TEST_FIXTURE(HashFixture, TestFindHash)
     hash_free(g_hash, pools);
 }
 
+TEST_FIXTURE(HashFixture, TestFindHashCompareByTag)
+{
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+
+    // Note: key_to_number is a bijection here, so only the matched key is compared
+    g_key_cmp_count = 0;
+    int value = 2000;
+    node_t* node = (node_t*) hash_find(g_hash, &value);
+    CHECK(node != NULL);
+    CHECK_EQUAL(1, g_key_cmp_count);
+
+    g_key_cmp_count = 0;
+    int value2 = 655360;
+    node = (node_t*) hash_find(g_hash, &value2);
+    CHECK(node == NULL);
+    CHECK_EQUAL(0, g_key_cmp_count);
+    hash_free(g_hash, pools);
+}
+
 TEST_FIXTURE(HashFixture, TestDelHash)
 {
     int ret = init_hash_table();
@@ -178,3 +207,518 @@ TEST_FIXTURE(HashFixture, TestDelHash)
     hash_destroy(g_hash, pools);
 }
 
+
+// Note: slot array indexes, LIBCACHE_INDEX_OPEN, LIBCACHE_INDEX_GROUP and LIBCACHE_INDEX_GROUP_COMPACT
+template <libcache_index_e index_type>
+struct SlotHashFixture {
+    hash_t* g_hash;
+    void * pools;
+    node_t* cache_nodes;
+    static const int max_entry = 65535;
+
+    SlotHashFixture()
+    {
+        pool_attr_t pool_attr[] = {
+                { 1, 1 },
+                { 1, 1 },
+                { 1, 1 },
+                { sizeof(node_t), max_entry},
+                { 1, 1 },
+                { sizeof(int), max_entry },
+                { sizeof(hash_t), 1 }, // POOL_TYPE_HASH_T
+                { hash_caculate_buckets_length(index_type, max_entry), 1 }, // POOL_TYPE_BUCKET_T
+                { sizeof(hash_data_t), max_entry },
+                };
+
+        const int pool_count = sizeof(pool_attr) / sizeof(pool_attr_t);
+        size_t large_mem_size = pool_caculate_total_length(pool_count, pool_attr);
+
+        void *large_memory = malloc(large_mem_size);
+        assert(large_memory != NULL);
+        pools = pools_init(large_memory, large_mem_size, pool_count, pool_attr);
+        assert(pools != NULL);
+        g_hash = (hash_t*) hash_init_ex(sizeof(int), test_key_com, test_key_to_int,
+                index_type, max_entry, pools);
+        cache_nodes = (node_t*) malloc(sizeof(node_t) * max_entry);
+    }
+    ~SlotHashFixture()
+    {
+        free(cache_nodes);
+        free(pools);
+    }
+
+    int init_hash_table()
+    {
+        int i = 0;
+        for (i = 0; i < max_entry; i++) {
+            if (hash_add(g_hash, &i, NULL, &cache_nodes[i], pools) == NULL) {
+                printf("insert to hash failed!\n");
+                return -1;
+            }
+        }
+        return 0;
+    }
+};
+
+typedef SlotHashFixture<LIBCACHE_INDEX_OPEN> OpenHashFixture;
+typedef SlotHashFixture<LIBCACHE_INDEX_GROUP> GroupHashFixture;
+typedef SlotHashFixture<LIBCACHE_INDEX_GROUP_COMPACT> GroupCompactHashFixture;
+
+TEST_FIXTURE(OpenHashFixture, TestOpenAddFindHash)
+{
+    CHECK(g_hash->slot_list != NULL);
+    CHECK(g_hash->bucket_list == NULL);
+    CHECK((1 << g_hash->slot_bits) * 3 >= max_entry * 4);
+
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+    CHECK(hash_get_count(g_hash) == max_entry);
+
+    int i = 0;
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(node != NULL);
+        hash_data_t* hd = (hash_data_t*) node->usr_data;
+        CHECK(*(int*) hd->key == i);
+        CHECK(hd->cache_node_ptr == (char*) &cache_nodes[i]);
+    }
+
+    int value = max_entry;
+    CHECK(hash_find(g_hash, &value) == NULL);
+
+    hash_free(g_hash, pools);
+    CHECK(g_hash->entry_count == 0);
+    CHECK(g_hash->slot_list[0].node == NULL);
+}
+
+TEST(TestOpenFullHash)
+{
+    // Note: the table is filled up, the probe of a missing key still stops at the slot left empty
+    const int max_entry = 8;
+    const int slots = 1 << hash_caculate_slot_bits(max_entry);
+    pool_attr_t pool_attr[] = {
+            { 1, 1 },
+            { 1, 1 },
+            { 1, 1 },
+            { sizeof(node_t), (libcache_scale_t) slots },
+            { 1, 1 },
+            { sizeof(int), (libcache_scale_t) slots },
+            { sizeof(hash_t), 1 }, // POOL_TYPE_HASH_T
+            { hash_caculate_buckets_length(LIBCACHE_INDEX_OPEN, max_entry), 1 }, // POOL_TYPE_BUCKET_T
+            { sizeof(hash_data_t), (libcache_scale_t) slots },
+            };
+    const int pool_count = sizeof(pool_attr) / sizeof(pool_attr_t);
+    size_t large_mem_size = pool_caculate_total_length(pool_count, pool_attr);
+    void* pools = pools_init(malloc(large_mem_size), large_mem_size, pool_count, pool_attr);
+    CHECK(pools != NULL);
+    hash_t* hash = (hash_t*) hash_init_ex(sizeof(int), test_key_com, test_key_to_int, LIBCACHE_INDEX_OPEN,
+            max_entry, pools);
+    node_t* cache_nodes = (node_t*) malloc(sizeof(node_t) * slots);
+
+    int i;
+    for (i = 0; i < slots; i++) {
+        if (hash_add(hash, &i, NULL, &cache_nodes[i], pools) == NULL) {
+            break;
+        }
+    }
+    CHECK_EQUAL(slots - 1, i);
+    CHECK(hash_get_count(hash) == (u32) (slots - 1));
+    int value = slots * 2;
+    CHECK(hash_find(hash, &value) == NULL);
+    hash_position_t position;
+    CHECK(hash_find_position(hash, &value, &position) == NULL);
+    CHECK(hash_add_at(hash, &position, &value, NULL, &cache_nodes[0], pools) == NULL);
+    value = slots - 2;
+    CHECK(hash_find(hash, &value) != NULL);
+
+    free(cache_nodes);
+    free(pools);
+}
+
+TEST_FIXTURE(OpenHashFixture, TestOpenDelHash)
+{
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+
+    // Note: delete every other key, the remaining keys must be still reachable after backward shift
+    int i = 0;
+    for (i = 0; i < max_entry; i += 2) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(node != NULL);
+        CHECK(hash_del(g_hash, &i, node, pools) == node);
+        hash_free_node(node, pools);
+    }
+    CHECK(hash_get_count(g_hash) == max_entry / 2);
+
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK((i % 2 == 0) ? (node == NULL) : (node != NULL));
+    }
+
+    // Note: deleted slots can be reused
+    for (i = 0; i < max_entry; i += 2) {
+        CHECK(hash_add(g_hash, &i, NULL, &cache_nodes[i], pools) != NULL);
+    }
+    CHECK(hash_get_count(g_hash) == max_entry);
+    int value = 2000;
+    node_t* node = (node_t*) hash_find(g_hash, &value);
+    CHECK(node != NULL);
+    CHECK(((hash_data_t*) node->usr_data)->cache_node_ptr == (char*) &cache_nodes[2000]);
+
+    hash_destroy(g_hash, pools);
+}
+
+static void check_find_batch(hash_t* hash, int max_key)
+{
+    // Note: a batch longer than HASH_BATCH_MAX, half of keys aren't in hash
+    const int count = HASH_BATCH_MAX * 2 + 3;
+    int keys[count];
+    const void* key_ptrs[count];
+    void* nodes[count];
+    int i = 0;
+    for (i = 0; i < count; i++) {
+        keys[i] = (i % 2) ? (i * 997) % max_key : max_key + i;
+        key_ptrs[i] = &keys[i];
+    }
+    hash_find_batch(hash, key_ptrs, count, nodes);
+    for (i = 0; i < count; i++) {
+        CHECK(nodes[i] == hash_find(hash, &keys[i]));
+        CHECK((i % 2) ? (nodes[i] != NULL) : (nodes[i] == NULL));
+    }
+}
+
+TEST_FIXTURE(HashFixture, TestFindHashBatch)
+{
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+    check_find_batch(g_hash, 655350);
+    hash_free(g_hash, pools);
+}
+
+TEST_FIXTURE(OpenHashFixture, TestOpenFindHashBatch)
+{
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+    check_find_batch(g_hash, max_entry);
+    hash_free(g_hash, pools);
+}
+
+// Note: keys are added where hash_find_position stopped, also after deletes shifted or emptied slots
+static void check_find_position(hash_t* hash, void* pools, int max_key)
+{
+    const int count = 4096;
+    node_t* cache_nodes = (node_t*) malloc(sizeof(node_t) * count);
+    hash_position_t position;
+    int i = 0;
+    for (i = 0; i < count; i++) {
+        int key = (i * 7919) % max_key;
+        CHECK(hash_find_position(hash, &key, &position) == NULL);
+        CHECK(hash_add_at(hash, &position, &key, NULL, &cache_nodes[i], pools) != NULL);
+        CHECK(hash_find_position(hash, &key, &position) == hash_find(hash, &key));
+    }
+    CHECK_EQUAL(count, hash_get_count(hash));
+
+    int key = max_key + 1;
+    CHECK(hash_find_position(hash, &key, &position) == NULL);
+    for (i = 0; i < count; i += 2) {
+        int deleted = (i * 7919) % max_key;
+        CHECK(hash_del(hash, &deleted, hash_find(hash, &deleted), pools) != NULL);
+    }
+    CHECK(hash_add_at(hash, &position, &key, NULL, &cache_nodes[0], pools) != NULL);
+    CHECK(hash_find(hash, &key) != NULL);
+    for (i = 1; i < count; i += 2) {
+        int kept = (i * 7919) % max_key;
+        node_t* node = (node_t*) hash_find(hash, &kept);
+        CHECK(node != NULL);
+        CHECK(node != NULL && ((hash_data_t*) node->usr_data)->cache_node_ptr == (char*) &cache_nodes[i]);
+    }
+    CHECK_EQUAL(count / 2 + 1, hash_get_count(hash));
+    free(cache_nodes);
+}
+
+TEST_FIXTURE(HashFixture, TestFindPositionHash)
+{
+    check_find_position(g_hash, pools, 655350);
+    hash_free(g_hash, pools);
+}
+
+TEST_FIXTURE(OpenHashFixture, TestOpenFindPositionHash)
+{
+    check_find_position(g_hash, pools, max_entry);
+    hash_free(g_hash, pools);
+}
+
+TEST_FIXTURE(GroupHashFixture, TestGroupFindPositionHash)
+{
+    check_find_position(g_hash, pools, max_entry);
+    hash_free(g_hash, pools);
+}
+
+TEST_FIXTURE(GroupHashFixture, TestGroupAddFindHash)
+{
+    CHECK(g_hash->group_list != NULL);
+    CHECK(g_hash->slot_list == NULL && g_hash->bucket_list == NULL);
+    CHECK(((size_t) HASH_GROUP_SLOTS << g_hash->group_bits) * 7 >= (size_t) max_entry * 8);
+
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+    CHECK(hash_get_count(g_hash) == max_entry);
+
+    int i = 0;
+    u32 probes = 0;
+    u32 total_probes = 0;
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find_probed(g_hash, &i, &probes);
+        CHECK(node != NULL);
+        CHECK(node == hash_find_optimistic(g_hash, &i));
+        hash_data_t* hd = (hash_data_t*) node->usr_data;
+        CHECK(*(int*) hd->key == i);
+        CHECK(hd->cache_node_ptr == (char*) &cache_nodes[i]);
+        total_probes += probes;
+    }
+    // Note: almost every key is in its home group
+    CHECK(total_probes < (u32) max_entry * 11 / 10);
+
+    int value = max_entry;
+    CHECK(hash_find(g_hash, &value) == NULL);
+    CHECK(hash_find_optimistic(g_hash, &value) == NULL);
+    check_find_batch(g_hash, max_entry);
+
+    hash_free(g_hash, pools);
+    CHECK(g_hash->entry_count == 0);
+    CHECK(g_hash->group_list[0].control[0] == 0);
+    CHECK(g_hash->group_list[0].nodes[0] == NULL);
+}
+
+TEST_FIXTURE(GroupHashFixture, TestGroupDelHash)
+{
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+
+    int i = 0;
+    for (i = 0; i < max_entry; i += 2) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(node != NULL);
+        CHECK(hash_del(g_hash, &i, node, pools) == node);
+        hash_free_node(node, pools);
+    }
+    CHECK(hash_get_count(g_hash) == max_entry / 2);
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK((i % 2 == 0) ? (node == NULL) : (node != NULL));
+    }
+    for (i = 0; i < max_entry; i += 2) {
+        CHECK(hash_add(g_hash, &i, NULL, &cache_nodes[i], pools) != NULL);
+    }
+    CHECK(hash_get_count(g_hash) == max_entry);
+
+    // Note: deleting every key leaves no overflow count behind
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(hash_del(g_hash, &i, node, pools) == node);
+        hash_free_node(node, pools);
+    }
+    u32 g;
+    for (g = 0; g <= g_hash->group_mask; g++) {
+        CHECK_EQUAL(g_hash->group_list[g].control[HASH_GROUP_OVERFLOW], 0);
+    }
+    hash_destroy(g_hash, pools);
+}
+
+TEST_FIXTURE(GroupCompactHashFixture, TestGroupCompactHash)
+{
+    CHECK_EQUAL((size_t) LIBCACHE_CACHE_LINE_SIZE, sizeof(hash_group_compact_t));
+    CHECK(g_hash->link_base == (char*) pools);
+    CHECK_EQUAL((u32) HASH_GROUP_COMPACT_SLOTS, g_hash->group_slots);
+    CHECK(((size_t) HASH_GROUP_COMPACT_SLOTS << g_hash->group_bits) * 7 >= (size_t) max_entry * 8);
+
+    int ret = init_hash_table();
+    CHECK(ret == 0);
+    CHECK(hash_get_count(g_hash) == max_entry);
+    int i = 0;
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(node != NULL);
+        CHECK(node == hash_find_optimistic(g_hash, &i));
+        hash_data_t* hd = (hash_data_t*) node->usr_data;
+        CHECK(*(int*) hd->key == i);
+        CHECK(hd->cache_node_ptr == (char*) &cache_nodes[i]);
+    }
+    int value = max_entry;
+    CHECK(hash_find(g_hash, &value) == NULL);
+    CHECK(hash_find_optimistic(g_hash, &value) == NULL);
+    check_find_batch(g_hash, max_entry);
+
+    // Note: a deleted node's link is emptied, the rest still link their nodes
+    for (i = 0; i < max_entry; i += 2) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK(hash_del(g_hash, &i, node, pools) == node);
+        hash_free_node(node, pools);
+    }
+    for (i = 0; i < max_entry; i++) {
+        node_t* node = (node_t*) hash_find(g_hash, &i);
+        CHECK((i % 2 == 0) ? (node == NULL) : (node != NULL));
+    }
+    hash_free(g_hash, pools);
+    CHECK(g_hash->entry_count == 0);
+    hash_group_compact_t* groups = (hash_group_compact_t*) g_hash->group_list;
+    u32 g;
+    for (g = 0; g <= g_hash->group_mask; g++) {
+        CHECK_EQUAL(groups[g].control[HASH_GROUP_OVERFLOW], 0);
+        CHECK_EQUAL(groups[g].links[0], 0u);
+    }
+    check_find_position(g_hash, pools, max_entry);
+    hash_destroy(g_hash, pools);
+}
+
+struct SmallGroupHashFixture {
+    hash_t* g_hash;
+    void* pools;
+    node_t cache_nodes[2 * HASH_GROUP_SLOTS];
+
+    SmallGroupHashFixture()
+    {
+        // Note: every key is hashed to group 0, the other group takes the overflow
+        const int max_entry = 2 * HASH_GROUP_SLOTS;
+        pool_attr_t pool_attr[] = {
+                { 1, 1 },
+                { 1, 1 },
+                { 1, 1 },
+                { sizeof(node_t), max_entry},
+                { 1, 1 },
+                { sizeof(int), max_entry },
+                { sizeof(hash_t), 1 }, // POOL_TYPE_HASH_T
+                { hash_caculate_buckets_length(LIBCACHE_INDEX_GROUP, HASH_GROUP_SLOTS), 1 }, // POOL_TYPE_BUCKET_T
+                { sizeof(hash_data_t), max_entry },
+                };
+        const int pool_count = sizeof(pool_attr) / sizeof(pool_attr_t);
+        size_t large_mem_size = pool_caculate_total_length(pool_count, pool_attr);
+        void *large_memory = malloc(large_mem_size);
+        assert(large_memory != NULL);
+        pools = pools_init(large_memory, large_mem_size, pool_count, pool_attr);
+        assert(pools != NULL);
+        g_hash = (hash_t*) hash_init_ex(sizeof(int), test_key_com, test_key_to_zero,
+                LIBCACHE_INDEX_GROUP, HASH_GROUP_SLOTS, pools);
+    }
+    ~SmallGroupHashFixture()
+    {
+        free(pools);
+    }
+};
+
+TEST_FIXTURE(SmallGroupHashFixture, TestGroupOverflow)
+{
+    CHECK_EQUAL(g_hash->group_mask, 1U);
+    int i = 0;
+    for (i = 0; i < 2 * HASH_GROUP_SLOTS; i++) {
+        CHECK(hash_add(g_hash, &i, NULL, &cache_nodes[i], pools) != NULL);
+    }
+    CHECK(hash_add(g_hash, &i, NULL, &cache_nodes[0], pools) == NULL);
+    CHECK_EQUAL(g_hash->group_list[0].control[HASH_GROUP_OVERFLOW], HASH_GROUP_SLOTS);
+
+    u32 probes = 0;
+    for (i = 0; i < 2 * HASH_GROUP_SLOTS; i++) {
+        node_t* node = (node_t*) hash_find_probed(g_hash, &i, &probes);
+        CHECK(node != NULL && *(int*) ((hash_data_t*) node->usr_data)->key == i);
+        CHECK_EQUAL(probes, (i < HASH_GROUP_SLOTS) ? 1U : 2U);
+        CHECK(node == hash_find_optimistic(g_hash, &i));
+    }
+    // Note: a freed slot of group 0 is taken first, keys in group 1 are still reachable
+    i = 3;
+    node_t* node = (node_t*) hash_find(g_hash, &i);
+    CHECK(hash_del(g_hash, &i, node, pools) == node);
+    CHECK(hash_find(g_hash, &i) == NULL);
+    CHECK(hash_add(g_hash, &i, node, &cache_nodes[3], pools) == node);
+    CHECK(hash_find_probed(g_hash, &i, &probes) == node);
+    CHECK_EQUAL(probes, 1U);
+
+    for (i = 2 * HASH_GROUP_SLOTS - 1; i >= 0; i--) {
+        node = (node_t*) hash_find(g_hash, &i);
+        CHECK(hash_del(g_hash, &i, node, pools) == node);
+    }
+    CHECK_EQUAL(g_hash->group_list[0].control[HASH_GROUP_OVERFLOW], 0);
+    i = 1;
+    CHECK(hash_find(g_hash, &i) == NULL);
+    hash_destroy(g_hash, pools);
+}
+
+TEST(TestBuiltinHashers)
+{
+    CHECK_EQUAL(libcache_hash_crc32c("123456789", 9), 0xe3069283U);
+    CHECK_EQUAL(libcache_hash_crc32c_any("123456789", 9), 0xe3069283U);
+    CHECK_EQUAL(libcache_hash_crc32c("", 0), 0U);
+
+    // Note: every length takes a different path of wyhash, a key and its one-bit neighbour never collide
+    unsigned char key[40];
+    size_t length;
+    for (length = 1; length <= sizeof(key); length++) {
+        memset(key, 0x5a, sizeof(key));
+        uint64_t h = libcache_hash_wy(key, length, 0);
+        CHECK_EQUAL(h, libcache_hash_wy(key, length, 0));
+        CHECK(h != libcache_hash_wy(key, length, 1));
+        key[length - 1] ^= 1;
+        CHECK(h != libcache_hash_wy(key, length, 0));
+        key[0] ^= 0x80;
+        CHECK(h != libcache_hash_wy(key, length, 0));
+    }
+
+    // Note: IMSIs share the MCC/MNC prefix, their top 16 bits of tag still spread over all buckets
+    libcache_hash_e hashers[] = { LIBCACHE_HASH_WY, LIBCACHE_HASH_CRC32C };
+    const int keys = 100000;
+    const int buckets = 1 << 16;
+    static unsigned short counts[1 << 16];
+    size_t h;
+    for (h = 0; h < sizeof(hashers) / sizeof(hashers[0]); h++) {
+        memset(counts, 0, sizeof(counts));
+        int i;
+        int max_count = 0;
+        int used = 0;
+        for (i = 0; i < keys; i++) {
+            uint64_t imsi = 460001000000000ULL + (uint64_t) i * 7;
+            u32 tag = libcache_hash_number(hashers[h], &imsi, sizeof(imsi)) * GOLDEN_RATIO_PRIME_32;
+            unsigned short* count = &counts[tag >> 16];
+            used += (*count == 0);
+            if (++*count > max_count) {
+                max_count = *count;
+            }
+        }
+        // Note: 100000 balls in 65536 bins, random hashing hits about 78% of bins, the fullest has under 10
+        CHECK(used > buckets * 3 / 4);
+        CHECK(max_count < 12);
+    }
+}
+
+TEST(TestBuiltinKeyCompare)
+{
+    CHECK(libcache_key_cmp_select(test_key_com, 8) == LIBCACHE_KEY_CMP_USER);
+    CHECK(libcache_key_cmp_select(NULL, 8) == LIBCACHE_KEY_CMP_8);
+    CHECK(libcache_key_cmp_select(NULL, 16) == LIBCACHE_KEY_CMP_16);
+    CHECK(libcache_key_cmp_select(NULL, 32) == LIBCACHE_KEY_CMP_32);
+    CHECK(libcache_key_cmp_select(NULL, 12) == LIBCACHE_KEY_CMP_BYTES);
+
+    // Note: unaligned keys, every byte of every size is checked
+    size_t sizes[] = { 4, 8, 12, 16, 32, 40 };
+    unsigned char key1[48];
+    unsigned char key2[48];
+    size_t s;
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        libcache_key_cmp_e cmp = libcache_key_cmp_select(NULL, sizes[s]);
+        size_t i;
+        for (i = 0; i < sizeof(key1); i++) {
+            key1[i] = (unsigned char) (i * 13);
+        }
+        memcpy(key2, key1, sizeof(key2));
+        CHECK(libcache_key_equal(cmp, NULL, sizes[s], key1 + 1, key2 + 1));
+        for (i = 0; i < sizes[s]; i++) {
+            key2[1 + i] ^= 0x40;
+            CHECK(!libcache_key_equal(cmp, NULL, sizes[s], key1 + 1, key2 + 1));
+            key2[1 + i] ^= 0x40;
+        }
+        // Note: bytes beyond key size don't matter
+        key2[1 + sizes[s]] ^= 0xff;
+        CHECK(libcache_key_equal(cmp, NULL, sizes[s], key1 + 1, key2 + 1));
+    }
+    uint32_t a = 1;
+    uint32_t b = 1;
+    CHECK(libcache_key_equal(LIBCACHE_KEY_CMP_USER, test_key_com, sizeof(a), &a, &b));
+}
@@ -0,0 +1,132 @@
+/*
+ * libcache_btree_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UnitTest++.h"
+#include "libpool.h"
+#include "libcache_btree.h"
+
+#define BTREE_UT_KEYS 5000
+
+static libcache_cmp_ret_t btree_ut_cmp(const void* key1, const void* key2)
+{
+    uint32_t a = *(const uint32_t*) key1;
+    uint32_t b = *(const uint32_t*) key2;
+    return (a == b) ? LIBCACHE_EQU : (a < b) ? LIBCACHE_SMALLER : LIBCACHE_BIGER;
+}
+
+typedef struct btree_ut_visit_t {
+    uint32_t last;
+    int count;
+    int ordered;
+    int stop_after;
+} btree_ut_visit_t;
+
+static int btree_ut_visit(const void* key, void* item, void* arg)
+{
+    btree_ut_visit_t* visit = (btree_ut_visit_t*) arg;
+    uint32_t k = *(const uint32_t*) key;
+    if ((visit->count > 0 && k <= visit->last) || item != (void*) ((uintptr_t) k + 1)) {
+        visit->ordered = FALSE;
+    }
+    visit->last = k;
+    return ++visit->count != visit->stop_after;
+}
+
+static int btree_ut_range(const libcache_btree_t* tree, const uint32_t* lo, const uint32_t* hi, int stop_after,
+        btree_ut_visit_t* visit)
+{
+    memset(visit, 0, sizeof(*visit));
+    visit->ordered = TRUE;
+    visit->stop_after = stop_after;
+    return libcache_btree_range(tree, lo, hi, btree_ut_visit, visit);
+}
+
+// Note: a fixed permutation of keys, an odd step modulo a power of 2 visits all of them
+static uint32_t btree_ut_key(uint32_t i, uint32_t step)
+{
+    return (i * step) % 8192;
+}
+
+TEST(TestBtreeInsertRemove)
+{
+    size_t node_size = libcache_btree_caculate_node_size(sizeof(uint32_t));
+    CHECK(0 == node_size % LIBCACHE_CACHE_LINE_SIZE);
+    pool_attr_t pool_attr[] = {
+            { node_size, (libcache_scale_t) libcache_btree_caculate_node_count(BTREE_UT_KEYS, sizeof(uint32_t)),
+                    LIBCACHE_CACHE_LINE_SIZE } };
+    size_t length = pool_caculate_total_length(1, pool_attr);
+    void* memory = malloc(length);
+    void* pools = pools_init(memory, length, 1, pool_attr);
+    CHECK(pools != NULL);
+    libcache_btree_t tree;
+    libcache_btree_init(&tree, pools, 0, sizeof(uint32_t), btree_ut_cmp);
+    CHECK(tree.fanout >= LIBCACHE_BTREE_MIN_FANOUT);
+
+    // Note: keys are added out of order, each is found by a range, a key is added once
+    uint32_t i;
+    for (i = 0; i < BTREE_UT_KEYS; i++) {
+        uint32_t key = btree_ut_key(i, 4099);
+        CHECK(libcache_btree_insert(&tree, &key, (void*) ((uintptr_t) key + 1)));
+    }
+    uint32_t key = btree_ut_key(7, 4099);
+    CHECK(!libcache_btree_insert(&tree, &key, (void*) ((uintptr_t) key + 1)));
+    CHECK_EQUAL((size_t) BTREE_UT_KEYS, tree.count);
+    CHECK(tree.height > 1);
+    btree_ut_visit_t visit;
+    CHECK(btree_ut_range(&tree, NULL, NULL, 0, &visit));
+    CHECK(visit.ordered);
+    CHECK_EQUAL(BTREE_UT_KEYS, visit.count);
+
+    // Note: bounds are included, they needn't be keys of the tree, a visit can stop the range
+    uint32_t lo = 100;
+    uint32_t hi = 200;
+    int expected = 0;
+    for (i = 0; i < BTREE_UT_KEYS; i++) {
+        key = btree_ut_key(i, 4099);
+        expected += (key >= lo && key <= hi) ? 1 : 0;
+    }
+    CHECK(btree_ut_range(&tree, &lo, &hi, 0, &visit));
+    CHECK(visit.ordered);
+    CHECK_EQUAL(expected, visit.count);
+    CHECK(!btree_ut_range(&tree, &lo, NULL, 3, &visit));
+    CHECK_EQUAL(3, visit.count);
+    hi = lo - 1;
+    CHECK(btree_ut_range(&tree, &lo, &hi, 0, &visit));
+    CHECK_EQUAL(0, visit.count);
+
+    // Note: removes in another order merge and refill nodes, the rest stays ordered and complete
+    key = btree_ut_key(11, 4099);
+    CHECK(!libcache_btree_remove(&tree, &key, NULL));
+    for (i = 0; i < BTREE_UT_KEYS; i += 2) {
+        key = btree_ut_key(i, 4099);
+        CHECK(libcache_btree_remove(&tree, &key, (void*) ((uintptr_t) key + 1)));
+        CHECK(!libcache_btree_remove(&tree, &key, (void*) ((uintptr_t) key + 1)));
+    }
+    CHECK(btree_ut_range(&tree, NULL, NULL, 0, &visit));
+    CHECK(visit.ordered);
+    CHECK_EQUAL(BTREE_UT_KEYS / 2, visit.count);
+
+    // Note: adds and removes go on in the nodes left, the pool is never short of nodes
+    for (i = 0; i < BTREE_UT_KEYS; i += 2) {
+        key = btree_ut_key(i, 4099);
+        CHECK(libcache_btree_insert(&tree, &key, (void*) ((uintptr_t) key + 1)));
+    }
+    for (i = 0; i < BTREE_UT_KEYS; i++) {
+        key = btree_ut_key(i, 4099);
+        CHECK(libcache_btree_remove(&tree, &key, (void*) ((uintptr_t) key + 1)));
+    }
+    CHECK_EQUAL(0u, tree.count);
+    CHECK_EQUAL(0u, tree.height);
+    CHECK(btree_ut_range(&tree, NULL, NULL, 0, &visit));
+    CHECK_EQUAL(0, visit.count);
+    CHECK(pool_get_element(pools, 0) != NULL);
+
+    free(memory);
+}
@@ -0,0 +1,89 @@
+/*
+ * libcache_compress_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UnitTest++.h"
+#include "libcache_compress.h"
+
+#define COMPRESS_UT_LENGTH 4096
+
+static uint32_t g_compress_table[LIBCACHE_COMPRESS_TABLE_LENGTH / sizeof(uint32_t)];
+
+static int compress_ut_round_trip(const char* src, size_t length, size_t* compressed_length)
+{
+    static char compressed[COMPRESS_UT_LENGTH * 2];
+    static char decompressed[COMPRESS_UT_LENGTH];
+    *compressed_length = libcache_compress(src, length, compressed, sizeof(compressed), g_compress_table);
+    if (0 == *compressed_length) {
+        return FALSE;
+    }
+    memset(decompressed, 0, sizeof(decompressed));
+    return libcache_decompress(compressed, *compressed_length, decompressed, length)
+            && 0 == memcmp(src, decompressed, length);
+}
+
+TEST(TestCompressRoundTrip)
+{
+    static char src[COMPRESS_UT_LENGTH];
+    size_t compressed_length = 0;
+
+    // Note: repeated text like APN strings shrinks a lot
+    size_t i;
+    for (i = 0; i < sizeof(src); i++) {
+        src[i] = "internet.mnc001.mcc460.gprs"[i % 27];
+    }
+    CHECK(compress_ut_round_trip(src, sizeof(src), &compressed_length));
+    CHECK(compressed_length < sizeof(src) / 10);
+
+    // Note: a run of one byte, every match overlaps itself
+    memset(src, 'a', sizeof(src));
+    CHECK(compress_ut_round_trip(src, sizeof(src), &compressed_length));
+    CHECK(compressed_length < 32);
+
+    // Note: random bytes only get longer, short inputs are all literals
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (i = 0; i < sizeof(src); i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        src[i] = (char) state;
+    }
+    CHECK(compress_ut_round_trip(src, sizeof(src), &compressed_length));
+    CHECK(compressed_length > sizeof(src));
+    size_t length;
+    for (length = 0; length < 32; length++) {
+        CHECK(compress_ut_round_trip(src, length, &compressed_length));
+        CHECK_EQUAL(length + ((length < 15) ? 1 : 2), compressed_length);
+    }
+}
+
+TEST(TestCompressBounds)
+{
+    static char src[COMPRESS_UT_LENGTH];
+    static char compressed[COMPRESS_UT_LENGTH];
+    static char decompressed[COMPRESS_UT_LENGTH];
+    size_t i;
+    for (i = 0; i < sizeof(src); i++) {
+        src[i] = (char) ((i / 64) * 7);
+    }
+    size_t compressed_length = libcache_compress(src, sizeof(src), compressed, sizeof(compressed), g_compress_table);
+    CHECK(0 != compressed_length);
+
+    // Note: it stops once capacity is taken
+    CHECK_EQUAL(0u, libcache_compress(src, sizeof(src), compressed, compressed_length - 1, g_compress_table));
+    CHECK_EQUAL(compressed_length,
+            libcache_compress(src, sizeof(src), compressed, compressed_length, g_compress_table));
+
+    // Note: a truncated block, or one of another length, isn't decompressed out of bounds
+    CHECK(!libcache_decompress(compressed, compressed_length - 1, decompressed, sizeof(src)));
+    CHECK(!libcache_decompress(compressed, compressed_length, decompressed, sizeof(src) - 1));
+    CHECK(!libcache_decompress(compressed, compressed_length, decompressed, 16));
+    CHECK(libcache_decompress(compressed, compressed_length, decompressed, sizeof(src)));
+    CHECK(0 == memcmp(src, decompressed, sizeof(src)));
+}
@@ -0,0 +1,196 @@
+/*
+ * libcache_cpp_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "UnitTest++.h"
+
+#include "libcache.hpp"
+
+namespace {
+
+/* value with an owned buffer, live counts constructed and not yet destroyed objects */
+struct TrackedValue
+{
+    static int live;
+    std::string text;
+
+    explicit TrackedValue(const std::string& value) : text(value) { live++; }
+    TrackedValue(const TrackedValue& other) : text(other.text) { live++; }
+    TrackedValue(TrackedValue&& other) noexcept : text(std::move(other.text)) { live++; }
+    ~TrackedValue() { live--; }
+};
+
+int TrackedValue::live = 0;
+
+struct FlowKey
+{
+    uint32_t address;
+    uint16_t port;          /* 2 bytes of padding follow, so the bytes of a key can't be hashed */
+};
+
+static int g_flow_hashes = 0;
+
+struct FlowHash
+{
+    size_t operator()(const FlowKey& key) const
+    {
+        g_flow_hashes++;
+        return ((size_t) key.address << 16) ^ key.port;
+    }
+};
+
+struct FlowEqual
+{
+    bool operator()(const FlowKey& key1, const FlowKey& key2) const
+    {
+        return key1.address == key2.address && key1.port == key2.port;
+    }
+};
+
+struct Counter
+{
+    uint64_t hits;
+    uint64_t bytes;
+};
+
+}
+
+TEST(TestCppValueLifetime)
+{
+    TrackedValue::live = 0;
+    {
+        libcache::Cache<uint32_t, TrackedValue> cache(8);
+        CHECK(cache.handle() != NULL);
+        uint32_t key = 0;
+
+        // Note: adding beyond capacity swaps out and destroys the oldest values
+        for (key = 0; key < 100; key++) {
+            CHECK_EQUAL(LIBCACHE_SUCCESS, cache.insert(key, TrackedValue(std::to_string(key))));
+            CHECK_EQUAL((int) cache.size(), TrackedValue::live);
+        }
+        CHECK(cache.size() < 100u);
+        key = 99;
+        CHECK_EQUAL(LIBCACHE_EXISTING, cache.insert(key, TrackedValue("again")));
+        CHECK_EQUAL((int) cache.size(), TrackedValue::live);
+
+        std::optional<TrackedValue> value = cache.get(key);
+        CHECK(value.has_value());
+        CHECK(value->text == "99");
+        value.reset();
+        CHECK(!cache.get(0).has_value());
+
+        CHECK_EQUAL(LIBCACHE_SUCCESS, cache.erase(key));
+        CHECK_EQUAL(LIBCACHE_NOT_FOUND, cache.erase(key));
+        CHECK_EQUAL((int) cache.size(), TrackedValue::live);
+
+        CHECK_EQUAL(LIBCACHE_SUCCESS, cache.clear());
+        CHECK_EQUAL(0, TrackedValue::live);
+        CHECK_EQUAL(0u, cache.size());
+
+        // Note: the values left are destroyed with the cache
+        for (key = 0; key < 5; key++) {
+            CHECK(cache.emplace(key, std::string(64, 'a' + key)).get() != NULL);
+        }
+        CHECK_EQUAL(5, TrackedValue::live);
+    }
+    CHECK_EQUAL(0, TrackedValue::live);
+}
+
+TEST(TestCppPin)
+{
+    TrackedValue::live = 0;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.index_type = LIBCACHE_INDEX_GROUP;
+    libcache::Cache<uint64_t, TrackedValue> cache(4, attr);
+    CHECK(cache.handle() != NULL);
+    uint64_t key = 0x1234567890ULL;
+
+    libcache::Pin<TrackedValue> pin = cache.emplace(key, "first");
+    CHECK(pin.get() != NULL);
+    CHECK(pin->text == "first");
+    CHECK(!cache.emplace(key, "second"));
+    CHECK_EQUAL(1, TrackedValue::live);
+
+    // Note: a pinned value is neither deleted nor swapped out
+    CHECK_EQUAL(LIBCACHE_LOCKED, cache.erase(key));
+    for (uint64_t other = 0; other < 20; other++) {
+        cache.insert(other, TrackedValue("other"));
+    }
+    libcache::Pin<TrackedValue> found = cache.find(key);
+    CHECK(found.get() != NULL);
+    CHECK_EQUAL(pin.get(), found.get());
+    found->text = "changed";
+
+    libcache::Pin<TrackedValue> moved(std::move(found));
+    CHECK(!found);
+    CHECK(moved.get() != NULL);
+    pin.reset();
+    CHECK_EQUAL(LIBCACHE_LOCKED, cache.erase(key));
+    moved.reset();
+    CHECK(!moved);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, cache.erase(key));
+    CHECK(!cache.find(key));
+    CHECK_EQUAL((int) cache.size(), TrackedValue::live);
+}
+
+TEST(TestCppCustomHash)
+{
+    g_flow_hashes = 0;
+    libcache::Cache<FlowKey, Counter, FlowHash, FlowEqual> cache(64);
+    CHECK(cache.handle() != NULL);
+    FlowKey key;
+    memset(&key, 0xff, sizeof(key));
+    key.address = 0x0a000001;
+    key.port = 80;
+
+    Counter counter = { 1, 1500 };
+    CHECK_EQUAL(LIBCACHE_SUCCESS, cache.insert(key, counter));
+    CHECK(g_flow_hashes > 0);
+
+    // Note: padding of an equal key differs, FlowHash and FlowEqual ignore it
+    FlowKey same;
+    memset(&same, 0, sizeof(same));
+    same.address = key.address;
+    same.port = key.port;
+    std::optional<Counter> got = cache.get(same);
+    CHECK(got.has_value());
+    CHECK_EQUAL(1500u, got->bytes);
+
+    if (libcache::Pin<Counter> pin = cache.find(same)) {
+        pin->hits++;
+    }
+    CHECK_EQUAL(2u, cache.get(key)->hits);
+    same.port = 443;
+    CHECK(!cache.get(same).has_value());
+}
+
+TEST(TestCppBytesKey)
+{
+    libcache::Cache<uint32_t, Counter> cache(16);
+    CHECK(cache.handle() != NULL);
+    libcache::Cache<uint32_t, Counter> other(std::move(cache));
+    CHECK(!cache);
+    CHECK(other.handle() != NULL);
+
+    uint32_t key = 0;
+    for (key = 0; key < 16; key++) {
+        Counter counter = { key, key * 100 };
+        CHECK_EQUAL(LIBCACHE_SUCCESS, other.insert(key, counter));
+    }
+    CHECK_EQUAL(libcache::BytesHash<uint32_t>()(key), libcache::BytesHash<uint32_t>()(key));
+    CHECK(libcache::BytesEqual<uint32_t>()(key, key));
+    for (key = 0; key < 16; key++) {
+        std::optional<Counter> got = other.get(key);
+        CHECK(got.has_value());
+        CHECK_EQUAL(key * 100u, got->bytes);
+    }
+    CHECK_EQUAL(16u, other.size());
+}
@@ -0,0 +1,96 @@
+/*
+ * libcache_filter_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UnitTest++.h"
+#include "libcache_filter.h"
+
+#define FILTER_UT_KEYS 10000
+
+static uint64_t filter_ut_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+TEST(TestFilterAddRemove)
+{
+    size_t length = libcache_filter_caculate_length(FILTER_UT_KEYS);
+    CHECK(length >= sizeof(libcache_filter_t) + FILTER_UT_KEYS * 2 * sizeof(uint16_t));
+    libcache_filter_t* filter = (libcache_filter_t*) malloc(length);
+    CHECK(filter != NULL);
+    libcache_filter_init(filter, FILTER_UT_KEYS);
+
+    // Note: tags are multiplicative hashes like the ones of the index
+    static uint32_t tags[FILTER_UT_KEYS];
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    int i;
+    for (i = 0; i < FILTER_UT_KEYS; i++) {
+        tags[i] = (uint32_t) (filter_ut_random(&state) >> 32);
+        CHECK(libcache_filter_add(filter, tags[i]));
+    }
+    CHECK(!filter->overflowed);
+    CHECK_EQUAL((uint32_t) FILTER_UT_KEYS, filter->count);
+    for (i = 0; i < FILTER_UT_KEYS; i++) {
+        CHECK(libcache_filter_contains(filter, tags[i]));
+    }
+
+    // Note: other tags are mostly absent
+    int false_positives = 0;
+    for (i = 0; i < FILTER_UT_KEYS; i++) {
+        false_positives += libcache_filter_contains(filter, (uint32_t) (filter_ut_random(&state) >> 32)) ? 1 : 0;
+    }
+    CHECK(false_positives < FILTER_UT_KEYS / 100);
+
+    // Note: removing half keeps the other half present
+    for (i = 0; i < FILTER_UT_KEYS; i += 2) {
+        libcache_filter_remove(filter, tags[i]);
+    }
+    CHECK_EQUAL((uint32_t) FILTER_UT_KEYS / 2, filter->count);
+    int removed_present = 0;
+    for (i = 0; i < FILTER_UT_KEYS; i++) {
+        if (i % 2) {
+            CHECK(libcache_filter_contains(filter, tags[i]));
+        } else {
+            removed_present += libcache_filter_contains(filter, tags[i]) ? 1 : 0;
+        }
+    }
+    CHECK(removed_present < FILTER_UT_KEYS / 100);
+
+    libcache_filter_clear(filter);
+    CHECK_EQUAL(0u, filter->count);
+    for (i = 1; i < FILTER_UT_KEYS; i += 2) {
+        CHECK(!libcache_filter_contains(filter, tags[i]));
+    }
+    free(filter);
+}
+
+TEST(TestFilterOverflow)
+{
+    libcache_filter_t* filter = (libcache_filter_t*) malloc(libcache_filter_caculate_length(16));
+    CHECK(filter != NULL);
+    libcache_filter_init(filter, 16);
+    CHECK_EQUAL(7u, filter->bucket_mask);
+
+    // Note: the same tag fits twice in its 2 buckets, then every key is present until the filter is cleared
+    int i;
+    for (i = 0; i < 2 * LIBCACHE_FILTER_SLOTS; i++) {
+        CHECK(libcache_filter_add(filter, 0x12345678));
+    }
+    CHECK(!libcache_filter_contains(filter, 0x87654321));
+    CHECK(!libcache_filter_add(filter, 0x12345678));
+    CHECK(filter->overflowed);
+    CHECK(libcache_filter_contains(filter, 0x87654321));
+    libcache_filter_clear(filter);
+    CHECK(!filter->overflowed);
+    CHECK(!libcache_filter_contains(filter, 0x12345678));
+    free(filter);
+}
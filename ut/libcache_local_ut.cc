@@ -0,0 +1,133 @@
+/*
+ * libcache_local_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "UnitTest++.h"
+
+extern "C" {
+
+#include "libcache_local.h"
+
+#define LOCAL_UT_WORKERS 4
+
+static int local_ut_allocations;
+static int local_ut_sockets[2];
+
+static void* local_ut_allocate(size_t size, size_t align, int socket)
+{
+    void* memory = NULL;
+    if (0 != posix_memalign(&memory, align, size)) {
+        return NULL;
+    }
+    local_ut_allocations++;
+    if (socket >= 0 && socket < 2) {
+        local_ut_sockets[socket]++;
+    }
+    return memory;
+}
+
+// Note: worker 2 has no cache, others alternate between 2 sockets
+static int local_ut_worker_socket(uint32_t worker)
+{
+    return (worker == 2) ? LIBCACHE_WORKER_NONE : (int) (worker % 2);
+}
+
+static uint32_t local_ut_key_to_int(const void* key)
+{
+    return *(const uint32_t*) key;
+}
+
+static libcache_cmp_ret_t local_ut_key_cmp(const void* key1, const void* key2)
+{
+    return (*(const uint32_t*) key1 == *(const uint32_t*) key2) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+}
+
+}
+
+TEST(TestLocalCreate)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 100;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.cmp_key = local_ut_key_cmp;
+    attr.key_to_number = local_ut_key_to_int;
+    CHECK(libcache_local_create(&attr, LOCAL_UT_WORKERS, local_ut_worker_socket) == NULL);
+    attr.allocate_memory_on = local_ut_allocate;
+    attr.free_memory = free;
+    CHECK(libcache_local_create(&attr, 0, local_ut_worker_socket) == NULL);
+
+    // Note: every cache is got on the socket of its worker, workers 1 and 3 are on socket 1, the set on any socket
+    local_ut_allocations = 0;
+    memset(local_ut_sockets, 0, sizeof(local_ut_sockets));
+    void* local = libcache_local_create(&attr, LOCAL_UT_WORKERS, local_ut_worker_socket);
+    CHECK(local != NULL);
+    CHECK_EQUAL((uint32_t) LOCAL_UT_WORKERS, libcache_local_get_workers(local));
+    CHECK(libcache_local_get(local, 2) == NULL);
+    CHECK(libcache_local_get(local, LOCAL_UT_WORKERS) == NULL);
+    CHECK(local_ut_sockets[0] > 0);
+    CHECK_EQUAL(2 * local_ut_sockets[0], local_ut_sockets[1]);
+    CHECK_EQUAL(local_ut_allocations, 1 + local_ut_sockets[0] + local_ut_sockets[1]);
+
+    // Note: caches of workers are apart, a key added by one isn't in another's
+    uint32_t key = 7;
+    uint32_t value = 70;
+    void* cache0 = libcache_local_get(local, 0);
+    void* cache1 = libcache_local_get(local, 1);
+    CHECK(cache0 != NULL && cache1 != NULL && cache0 != cache1);
+    CHECK(libcache_add(cache0, &key, &value) != NULL);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_unlock_entry(cache0, libcache_lookup(cache0, &key, NULL)));
+    CHECK(libcache_lookup(cache1, &key, NULL) == NULL);
+    CHECK_EQUAL(1u, libcache_get_entry_number(cache0));
+    CHECK_EQUAL(0u, libcache_get_entry_number(cache1));
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_local_destroy(local));
+}
+
+TEST(TestLocalBurst)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = local_ut_key_cmp;
+    attr.key_to_number = local_ut_key_to_int;
+    void* local = libcache_local_create(&attr, 2, NULL);
+    CHECK(local != NULL);
+
+    // Note: a worker looks a burst up in its cache, odd keys are found
+    void* cache = libcache_local_get(local, 1);
+    uint32_t keys[LIBCACHE_BURST_MAX];
+    const void* key_ptrs[LIBCACHE_BURST_MAX];
+    void* entries[LIBCACHE_BURST_MAX];
+    uint32_t i;
+    for (i = 0; i < LIBCACHE_BURST_MAX; i++) {
+        keys[i] = i;
+        key_ptrs[i] = &keys[i];
+        if (i % 2) {
+            CHECK(libcache_add(cache, &keys[i], &keys[i]) != NULL);
+        }
+    }
+    uint64_t hit_mask = 0;
+    CHECK_EQUAL(LIBCACHE_BURST_MAX / 2, libcache_lookup_burst(cache, key_ptrs, LIBCACHE_BURST_MAX, &hit_mask,
+            entries));
+    CHECK(hit_mask == 0xaaaaaaaaaaaaaaaaULL);
+    for (i = 1; i < LIBCACHE_BURST_MAX; i += 2) {
+        CHECK_EQUAL(i, *(uint32_t*) entries[i]);
+        CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_unlock_entry(cache, entries[i]));
+    }
+    CHECK_EQUAL(0, libcache_lookup_burst(libcache_local_get(local, 0), key_ptrs, LIBCACHE_BURST_MAX, &hit_mask,
+            entries));
+    CHECK(hit_mask == 0);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_local_destroy(local));
+}
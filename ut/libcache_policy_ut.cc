@@ -0,0 +1,235 @@
+/*
+ * libcache_policy_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UnitTest++.h"
+
+extern "C" {
+
+#include "libcache.h"
+#include "libcache_def.h"
+#include "libcache_policy.h"
+
+static uint32_t policy_key_to_int(const void* key)
+{
+    return *(const uint32_t*) key;
+}
+
+static libcache_cmp_ret_t policy_key_cmp(const void* key1, const void* key2)
+{
+    uint32_t a = *(const uint32_t*) key1;
+    uint32_t b = *(const uint32_t*) key2;
+
+    if (a == b) {
+        return LIBCACHE_EQU;
+    } else if (a < b) {
+        return LIBCACHE_SMALLER;
+    } else {
+        return LIBCACHE_BIGER;
+    }
+}
+
+static void* policy_create_cache(libcache_scale_t max_entry_number, libcache_policy_e policy,
+        const libcache_policy_ops_t* policy_ops)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = policy_key_cmp;
+    attr.key_to_number = policy_key_to_int;
+    attr.policy = policy;
+    attr.policy_ops = policy_ops;
+    return libcache_create_ex(&attr);
+}
+
+// Note: counts victims selected by a customized policy, which wraps built-in LRU
+static int g_policy_victim_count = 0;
+
+static node_t* policy_counting_select_victim(void* data)
+{
+    g_policy_victim_count++;
+    return libcache_policy_get(LIBCACHE_POLICY_LRU)->select_victim(data);
+}
+
+}
+
+TEST(TestPolicyGet)
+{
+    CHECK(libcache_policy_get(LIBCACHE_POLICY_LRU) != NULL);
+    CHECK(libcache_policy_get(LIBCACHE_POLICY_CLOCK) != NULL);
+    CHECK(libcache_policy_get(LIBCACHE_POLICY_FIFO) != NULL);
+    CHECK(libcache_policy_get(LIBCACHE_POLICY_SLRU) != NULL);
+    CHECK(libcache_policy_get(LIBCACHE_POLICY_TINYLFU) != NULL);
+    CHECK(libcache_policy_get((libcache_policy_e) 100) == NULL);
+    CHECK(policy_create_cache(10, (libcache_policy_e) 100, NULL) == NULL);
+}
+
+TEST(TestPolicyLockSwap)
+{
+    libcache_policy_e policies[] = { LIBCACHE_POLICY_LRU, LIBCACHE_POLICY_CLOCK, LIBCACHE_POLICY_FIFO,
+            LIBCACHE_POLICY_SLRU, LIBCACHE_POLICY_TINYLFU };
+    size_t p;
+    for (p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        void* cache = policy_create_cache(199, policies[p], NULL);
+        CHECK(cache != NULL);
+
+        // Note: locked entries are never swapped out, whatever the policy is
+        int key = 0;
+        int dst = 0;
+        int* locked = (int*) libcache_add(cache, &key, NULL);
+        CHECK(locked != NULL);
+        *locked = key;
+
+        int i;
+        for (i = 1; i < 1000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+            libcache_lookup(cache, &i, &dst);
+        }
+        CHECK_EQUAL(libcache_get_entry_number(cache), 200);
+        CHECK(libcache_lookup(cache, &key, &dst) != NULL);
+        CHECK_EQUAL(dst, 0);
+
+        // Note: once unlocked, the entry is given back to policy and can be swapped out
+        CHECK_EQUAL(libcache_unlock_entry(cache, locked), LIBCACHE_SUCCESS);
+        for (i = 1000; i < 2000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 200);
+
+        // Note: the newest entry is always kept by policy
+        key = 1999;
+        CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+        CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_NOT_FOUND);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 199);
+
+        CHECK_EQUAL(libcache_clean(cache), LIBCACHE_SUCCESS);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 0);
+        for (i = 0; i < 300; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK_EQUAL(libcache_get_entry_number(cache), 200);
+        CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+    }
+}
+
+TEST(TestFifoPolicySwap)
+{
+    void* cache = policy_create_cache(99, LIBCACHE_POLICY_FIFO, NULL);
+    CHECK(cache != NULL);
+
+    int i;
+    int dst = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+
+    // Note: hits don't matter, the oldest added entries are swapped out
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    }
+    for (i = 100; i < 150; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    for (i = 0; i < 150; i++) {
+        CHECK((i < 50) == (libcache_lookup(cache, &i, &dst) == NULL));
+    }
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST(TestSlruPolicyScan)
+{
+    void* cache = policy_create_cache(99, LIBCACHE_POLICY_SLRU, NULL);
+    CHECK(cache != NULL);
+
+    int i;
+    int dst = 0;
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    }
+
+    // Note: entries hit once are protected, a scan of new keys only flushes probation segment
+    for (i = 1000; i < 2000; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(dst, i);
+    }
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST(TestTinyLfuPolicyScan)
+{
+    void* cache = policy_create_cache(999, LIBCACHE_POLICY_TINYLFU, NULL);
+    CHECK(cache != NULL);
+
+    int i;
+    int round;
+    int dst = 0;
+    for (i = 0; i < 500; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < 500; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+        }
+    }
+
+    // Note: keys of a scan are seen only once, they can't be admitted against frequent keys
+    for (i = 10000; i < 20000; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    int hit = 0;
+    for (i = 0; i < 500; i++) {
+        if (libcache_lookup(cache, &i, &dst) != NULL && dst == i) {
+            hit++;
+        }
+    }
+    CHECK(hit >= 490);
+    CHECK_EQUAL(libcache_get_entry_number(cache), 1000);
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST(TestCustomizedPolicy)
+{
+    libcache_policy_ops_t ops = *libcache_policy_get(LIBCACHE_POLICY_LRU);
+    ops.name = "counting";
+    ops.select_victim = policy_counting_select_victim;
+
+    // Note: policy_ops overrides policy
+    void* cache = policy_create_cache(99, LIBCACHE_POLICY_FIFO, &ops);
+    CHECK(cache != NULL);
+
+    g_policy_victim_count = 0;
+    int i;
+    int dst = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK_EQUAL(g_policy_victim_count, 0);
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    for (i = 100; i < 110; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK_EQUAL(g_policy_victim_count, 10);
+
+    // Note: it's LRU, the hit entry survives
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    i = 1;
+    CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+}
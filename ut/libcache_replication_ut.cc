@@ -0,0 +1,200 @@
+/*
+ * libcache_replication_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "UnitTest++.h"
+
+extern "C" {
+
+#include "libcache.h"
+#include "libcache_sharded.h"
+#include "libcache_replication.h"
+
+#define REPLICATION_UT_PATH "/tmp/libcache_replication_ut.image"
+#define REPLICATION_UT_BUFFER 4096
+
+static uint32_t replication_ut_key_to_int(const void* key)
+{
+    return *(const uint32_t*) key;
+}
+
+static libcache_cmp_ret_t replication_ut_key_cmp(const void* key1, const void* key2)
+{
+    return (*(const uint32_t*) key1 == *(const uint32_t*) key2) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+}
+
+static void replication_ut_attr(libcache_attr_t* attr, libcache_scale_t max_entry_number, void* ring)
+{
+    memset(attr, 0, sizeof(*attr));
+    attr->max_entry_number = max_entry_number;
+    attr->entry_size = sizeof(uint32_t);
+    attr->key_size = sizeof(uint32_t);
+    attr->allocate_memory = malloc;
+    attr->free_memory = free;
+    attr->cmp_key = replication_ut_key_cmp;
+    attr->key_to_number = replication_ut_key_to_int;
+    attr->replication = ring;
+}
+
+// Note: ships every record of the ring to the standby
+static libcache_ret_t replication_ut_ship(void* ring, void* standby, uint64_t* next_sequence)
+{
+    uint64_t buffer[REPLICATION_UT_BUFFER / sizeof(uint64_t)];
+    libcache_ret_t return_value = LIBCACHE_SUCCESS;
+    size_t length;
+    while (LIBCACHE_SUCCESS == return_value && 0 != (length = libcache_replication_consume(ring, buffer,
+            sizeof(buffer)))) {
+        return_value = libcache_replication_apply(standby, buffer, length, next_sequence);
+    }
+    return return_value;
+}
+
+// Note: the standby has the same keys and entries as the primary
+static int replication_ut_same(void* primary, void* standby, uint32_t keys)
+{
+    uint32_t key;
+    for (key = 0; key < keys; key++) {
+        uint32_t primary_entry = 0;
+        uint32_t standby_entry = 0;
+        int found = (NULL != libcache_lookup(primary, &key, &primary_entry));
+        if (found != (NULL != libcache_lookup(standby, &key, &standby_entry)) || primary_entry != standby_entry) {
+            return FALSE;
+        }
+    }
+    return libcache_get_entry_number(primary) == libcache_get_entry_number(standby);
+}
+
+}
+
+TEST(TestReplicationCreate)
+{
+    CHECK(libcache_replication_create(0, sizeof(uint32_t), sizeof(uint32_t)) == NULL);
+    CHECK(libcache_replication_create(16, 0, sizeof(uint32_t)) == NULL);
+    void* ring = libcache_replication_create(10, sizeof(uint32_t), sizeof(uint32_t));
+    CHECK(ring != NULL);
+    CHECK_EQUAL(0u, (unsigned) libcache_replication_get_sequence(ring));
+    CHECK_EQUAL(sizeof(libcache_replication_record_t) + 8, libcache_replication_get_record_size(ring));
+
+    // Note: a ring is written by one cache, of its key and entry sizes
+    libcache_attr_t attr;
+    replication_ut_attr(&attr, 10, ring);
+    CHECK(libcache_sharded_create(&attr, 4) == NULL);
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    replication_ut_attr(&attr, 10, ring);
+    attr.entry_size = 8;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    libcache_replication_destroy(ring);
+}
+
+TEST(TestReplicationStream)
+{
+    void* ring = libcache_replication_create(64, sizeof(uint32_t), sizeof(uint32_t));
+    libcache_attr_t attr;
+    replication_ut_attr(&attr, 7, ring);
+    void* primary = libcache_create_ex(&attr);
+    replication_ut_attr(&attr, 7, NULL);
+    void* standby = libcache_create_ex(&attr);
+    CHECK(primary != NULL && standby != NULL);
+
+    // Note: keys 0 and 1 are swapped out and key 5 is deleted, the standby drops them as well
+    uint32_t key;
+    for (key = 0; key < 10; key++) {
+        uint32_t entry = key * 10;
+        CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_add_ex(primary, &key, &entry, sizeof(entry), NULL));
+    }
+    key = 5;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_delete_by_key(primary, &key));
+    uint64_t next_sequence = 0;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, replication_ut_ship(ring, standby, &next_sequence));
+    CHECK_EQUAL(13u, (unsigned) next_sequence);
+    CHECK_EQUAL(next_sequence, libcache_replication_get_sequence(ring));
+    CHECK(replication_ut_same(primary, standby, 10));
+
+    // Note: an entry filled in place is put by libcache_replicate_entry, it replaces the standby's one
+    key = 3;
+    uint32_t* entry = (uint32_t*) libcache_lookup(primary, &key, NULL);
+    CHECK(entry != NULL);
+    *entry = 33;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_replicate_entry(primary, entry));
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_unlock_entry(primary, entry));
+    key = 20;
+    entry = (uint32_t*) libcache_add(primary, &key, NULL);
+    CHECK(entry != NULL);
+    *entry = 200;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_replicate_entry(primary, entry));
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_unlock_entry(primary, entry));
+    CHECK_EQUAL(LIBCACHE_SUCCESS, replication_ut_ship(ring, standby, &next_sequence));
+    CHECK(replication_ut_same(primary, standby, 21));
+
+    // Note: a batch applied again is skipped, a clean empties the standby
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_clean(primary));
+    uint64_t buffer[REPLICATION_UT_BUFFER / sizeof(uint64_t)];
+    size_t length = libcache_replication_consume(ring, buffer, sizeof(buffer));
+    CHECK(length > 0);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_replication_apply(standby, buffer, length, &next_sequence));
+    CHECK_EQUAL(0u, libcache_get_entry_number(standby));
+    key = 7;
+    uint32_t value = 70;
+    CHECK(libcache_add(standby, &key, &value) != NULL);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_replication_apply(standby, buffer, length, &next_sequence));
+    CHECK_EQUAL(1u, libcache_get_entry_number(standby));
+    CHECK_EQUAL(LIBCACHE_FAILURE, libcache_replication_apply(standby, buffer, length - 1, &next_sequence));
+    CHECK_EQUAL(0u, (unsigned) libcache_replication_get_dropped(ring));
+
+    libcache_destroy(primary);
+    libcache_destroy(standby);
+    libcache_replication_destroy(ring);
+}
+
+TEST(TestReplicationGap)
+{
+    void* ring = libcache_replication_create(4, sizeof(uint32_t), sizeof(uint32_t));
+    libcache_attr_t attr;
+    replication_ut_attr(&attr, 100, ring);
+    void* primary = libcache_create_ex(&attr);
+    replication_ut_attr(&attr, 100, NULL);
+    void* standby = libcache_create_ex(&attr);
+    CHECK(primary != NULL && standby != NULL);
+
+    // Note: the ring holds 4 records, the other 6 adds are dropped, their sequence numbers are skipped
+    uint32_t key;
+    for (key = 0; key < 10; key++) {
+        CHECK(libcache_add(primary, &key, &key) != NULL);
+    }
+    CHECK_EQUAL(6u, (unsigned) libcache_replication_get_dropped(ring));
+    uint64_t next_sequence = 0;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, replication_ut_ship(ring, standby, &next_sequence));
+    CHECK_EQUAL(4u, (unsigned) next_sequence);
+    CHECK_EQUAL(4u, libcache_get_entry_number(standby));
+    key = 10;
+    CHECK(libcache_add(primary, &key, &key) != NULL);
+    CHECK_EQUAL(LIBCACHE_NOT_FOUND, replication_ut_ship(ring, standby, &next_sequence));
+    CHECK_EQUAL(4u, (unsigned) next_sequence);
+
+    // Note: the standby loads an image, records after its sequence number are applied on it
+    next_sequence = libcache_replication_get_sequence(ring);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_save(primary, REPLICATION_UT_PATH));
+    libcache_destroy(standby);
+    standby = libcache_load(REPLICATION_UT_PATH, &attr);
+    unlink(REPLICATION_UT_PATH);
+    CHECK(standby != NULL);
+    key = 3;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_delete_by_key(primary, &key));
+    key = 11;
+    CHECK(libcache_add(primary, &key, &key) != NULL);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, replication_ut_ship(ring, standby, &next_sequence));
+    CHECK(replication_ut_same(primary, standby, 12));
+
+    libcache_destroy(primary);
+    libcache_destroy(standby);
+    libcache_replication_destroy(ring);
+}
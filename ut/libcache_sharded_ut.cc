@@ -0,0 +1,647 @@
+/*
+ * libcache_sharded_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include "UnitTest++.h"
+
+extern "C" {
+
+#include "libcache_sharded.h"
+
+static uint32_t sharded_key_to_int(const void* key)
+{
+    return *(const uint32_t*) key;
+}
+
+static libcache_cmp_ret_t sharded_key_cmp(const void* key1, const void* key2)
+{
+    return (*(const uint32_t*) key1 == *(const uint32_t*) key2) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+}
+
+static void* sharded_create_cache(libcache_scale_t max_entry_number, uint32_t shard_number)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    return libcache_sharded_create(&attr, shard_number);
+}
+
+#define SHARDED_THREADS 8
+#define SHARDED_KEYS_PER_THREAD 20000
+
+typedef struct sharded_worker_t {
+    void* cache;
+    uint32_t first_key;
+    int errors;
+    uint32_t* pinned[SHARDED_KEYS_PER_THREAD];  /* pinned entries, unlocked by another thread */
+} sharded_worker_t;
+
+static void* sharded_add_worker(void* arg)
+{
+    sharded_worker_t* worker = (sharded_worker_t*) arg;
+    uint32_t i;
+    for (i = 0; i < SHARDED_KEYS_PER_THREAD; i++) {
+        uint32_t key = worker->first_key + i;
+        uint32_t value = ~key;
+        if (libcache_sharded_add(worker->cache, &key, &value) == NULL) {
+            worker->errors++;
+        }
+        uint32_t dst = 0;
+        if (libcache_sharded_lookup(worker->cache, &key, &dst) == NULL || dst != ~key) {
+            worker->errors++;
+        }
+        worker->pinned[i] = (uint32_t*) libcache_sharded_lookup(worker->cache, &key, NULL);
+        if (worker->pinned[i] == NULL || *worker->pinned[i] != ~key) {
+            worker->errors++;
+        }
+    }
+    return NULL;
+}
+
+static void* sharded_delete_worker(void* arg)
+{
+    sharded_worker_t* worker = (sharded_worker_t*) arg;
+    uint32_t i;
+    for (i = 0; i < SHARDED_KEYS_PER_THREAD; i++) {
+        uint32_t key = worker->first_key + i;
+        uint32_t* entry = (uint32_t*) libcache_sharded_lookup(worker->cache, &key, NULL);
+        if (entry == NULL || libcache_sharded_unlock_entry(worker->cache, entry) != LIBCACHE_SUCCESS) {
+            worker->errors++;
+        }
+        libcache_ret_t ret = (i % 2) ? libcache_sharded_delete_by_key(worker->cache, &key)
+                : libcache_sharded_delete_entry(worker->cache, entry);
+        if (ret != LIBCACHE_SUCCESS || libcache_sharded_delete_by_key(worker->cache, &key) != LIBCACHE_NOT_FOUND) {
+            worker->errors++;
+        }
+    }
+    return NULL;
+}
+
+static void* sharded_unlock_worker(void* arg)
+{
+    sharded_worker_t* worker = (sharded_worker_t*) arg;
+    uint32_t i;
+    for (i = 0; i < SHARDED_KEYS_PER_THREAD; i++) {
+        if (worker->pinned[i] != NULL
+                && libcache_sharded_unlock_entry(worker->cache, worker->pinned[i]) != LIBCACHE_SUCCESS) {
+            worker->errors++;
+        }
+    }
+    return NULL;
+}
+
+
+#define SHARDED_LOAD_KEYS 64
+
+static int sharded_load_calls[SHARDED_LOAD_KEYS];
+
+static int sharded_load_entry(const void* key, void* entry, size_t* entry_length)
+{
+    uint32_t k = *(const uint32_t*) key;
+    __atomic_add_fetch(&sharded_load_calls[k], 1, __ATOMIC_RELAXED);
+    // Note: a slow backend, so that other threads miss the key meanwhile
+    struct timespec delay = { 0, 1000000 };
+    nanosleep(&delay, NULL);
+    if (k % 8 == 7) {
+        return FALSE;
+    }
+    *(uint32_t*) entry = ~k;
+    *entry_length = sizeof(uint32_t);
+    return TRUE;
+}
+
+static void* sharded_load_worker(void* arg)
+{
+    sharded_worker_t* worker = (sharded_worker_t*) arg;
+    uint32_t k;
+    for (k = 0; k < SHARDED_LOAD_KEYS; k++) {
+        uint32_t* entry = (uint32_t*) libcache_sharded_lookup_or_load(worker->cache, &k, NULL);
+        if (k % 8 == 7) {
+            worker->errors += (entry != NULL);
+            continue;
+        }
+        if (entry == NULL || *entry != ~k || libcache_sharded_unlock_entry(worker->cache, entry) != LIBCACHE_SUCCESS) {
+            worker->errors++;
+        }
+    }
+    return NULL;
+}
+
+typedef struct sharded_completer_t {
+    void* cache;
+    libcache_load_waiter_t* loader;
+    uint32_t key;
+    int errors;
+} sharded_completer_t;
+
+static void* sharded_complete_worker(void* arg)
+{
+    sharded_completer_t* completer = (sharded_completer_t*) arg;
+    struct timespec delay = { 0, 10000000 };
+    nanosleep(&delay, NULL);
+    *(uint32_t*) completer->loader->handle.entry = ~completer->key;
+    if (libcache_sharded_load_complete(completer->cache, completer->loader, sizeof(uint32_t), TRUE)
+            != LIBCACHE_SUCCESS) {
+        completer->errors++;
+    }
+    return NULL;
+}
+}
+
+TEST(TestShardedBasic)
+{
+    void* cache = sharded_create_cache(1000, 3);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(libcache_sharded_get_shard_number(cache), 4U);
+    CHECK(libcache_sharded_get_max_entry_number(cache) >= 1000);
+
+    uint32_t i;
+    uint32_t dst = 0;
+    for (i = 0; i < 500; i++) {
+        CHECK(libcache_sharded_add(cache, &i, &i) != NULL);
+    }
+    CHECK(libcache_sharded_add(cache, &i, NULL) != NULL);
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), 501U);
+
+    i = 7;
+    CHECK(libcache_sharded_lookup(cache, &i, &dst) != NULL);
+    CHECK_EQUAL(dst, 7U);
+    uint32_t* entry = (uint32_t*) libcache_sharded_lookup(cache, &i, NULL);
+    CHECK(entry != NULL);
+    CHECK(libcache_get_entry_key(entry) != NULL);
+    CHECK_EQUAL(*(const uint32_t*) libcache_get_entry_key(entry), 7U);
+    CHECK(libcache_sharded_delete_by_key(cache, &i) == LIBCACHE_LOCKED);
+    CHECK(libcache_sharded_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_unlock_entry(cache, entry) == LIBCACHE_UNLOCKED);
+    CHECK(libcache_sharded_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_lookup(cache, &i, &dst) == NULL);
+
+    i = 500;
+    entry = (uint32_t*) libcache_sharded_lookup(cache, &i, NULL);
+    CHECK(libcache_sharded_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_delete_entry(cache, entry) == LIBCACHE_LOCKED);
+    CHECK(libcache_sharded_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_delete_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_clean(cache) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), 0U);
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_create(NULL, 4) == NULL);
+}
+
+static uint32_t sharded_key_to_tag(const void* key)
+{
+    return *(const uint32_t*) key % 2;
+}
+
+TEST(TestShardedInvalidateTag)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    attr.tags = 2;
+    attr.key_to_tag = sharded_key_to_tag;
+    void* cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+    uint32_t i;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_sharded_add(cache, &i, &i) != NULL);
+    }
+
+    // Note: the tag is invalidated in every shard, lock free reads miss its entries as well
+    CHECK(libcache_sharded_invalidate_tag(cache, 1) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_invalidate_tag(cache, 2) == LIBCACHE_FAILURE);
+    uint32_t dst = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK_EQUAL(0 == i % 2, libcache_sharded_read(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(0 == i % 2, libcache_sharded_lookup(cache, &i, &dst) != NULL);
+    }
+    CHECK_EQUAL(50U, libcache_sharded_get_entry_number(cache));
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedLookupOrAdd)
+{
+    void* cache = sharded_create_cache(1000, 4);
+    CHECK(cache != NULL);
+    uint32_t key;
+    int inserted = FALSE;
+    for (key = 0; key < 100; key++) {
+        uint32_t* entry = (uint32_t*) libcache_sharded_lookup_or_add(cache, &key, &inserted);
+        CHECK(entry != NULL);
+        CHECK(inserted);
+        *entry = ~key;
+        CHECK_EQUAL(libcache_sharded_unlock_entry(cache, entry), LIBCACHE_SUCCESS);
+    }
+    for (key = 0; key < 100; key++) {
+        uint32_t* entry = (uint32_t*) libcache_sharded_lookup_or_add(cache, &key, &inserted);
+        CHECK(entry != NULL);
+        CHECK(!inserted);
+        CHECK_EQUAL(~key, *entry);
+        CHECK_EQUAL(libcache_sharded_unlock_entry(cache, entry), LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), 100U);
+    CHECK_EQUAL(libcache_sharded_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedStats)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    void* cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+
+    uint32_t i;
+    uint32_t dst = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_sharded_add(cache, &i, &i) != NULL);
+    }
+    for (i = 0; i < 200; i++) {
+        libcache_sharded_lookup(cache, &i, &dst);
+    }
+
+    // Note: counters of all shards are summed up
+    libcache_stats_t stats;
+    CHECK(libcache_sharded_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(stats.adds, 100ULL);
+    CHECK_EQUAL(stats.lookup_hits, 100ULL);
+    CHECK_EQUAL(stats.lookup_misses, 100ULL);
+    CHECK_EQUAL(stats.entry_number, 100U);
+    CHECK(libcache_sharded_get_stats(cache, NULL) == LIBCACHE_FAILURE);
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+
+    // Note: keys of a built-in hasher pick their shard by the same hash
+    attr.key_to_number = NULL;
+    attr.hash = LIBCACHE_HASH_CRC32C;
+    cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_sharded_add(cache, &i, &i) != NULL);
+    }
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_sharded_lookup(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(dst, i);
+    }
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = sharded_create_cache(1000, 4);
+    CHECK(libcache_sharded_get_stats(cache, &stats) == LIBCACHE_FAILURE);
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedThreads)
+{
+    // Note: capacity is split evenly into shards, leave room for uneven key distribution
+    void* cache = sharded_create_cache(2 * SHARDED_THREADS * SHARDED_KEYS_PER_THREAD, 16);
+    CHECK(cache != NULL);
+
+    static sharded_worker_t workers[SHARDED_THREADS];
+    pthread_t threads[SHARDED_THREADS];
+    int t;
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].cache = cache;
+        workers[t].first_key = t * SHARDED_KEYS_PER_THREAD;
+        pthread_create(&threads[t], NULL, sharded_add_worker, &workers[t]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), (libcache_scale_t) SHARDED_THREADS * SHARDED_KEYS_PER_THREAD);
+
+    // Note: entries pinned by one thread are unlocked by another one
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_create(&threads[t], NULL, sharded_unlock_worker, &workers[(t + 1) % SHARDED_THREADS]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        CHECK_EQUAL(workers[t].errors, 0);
+    }
+
+    CHECK(libcache_sharded_clean(cache) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedCombining)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 2 * SHARDED_THREADS * SHARDED_KEYS_PER_THREAD;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    attr.combining = TRUE;
+    // Note: few shards, so that writers of every thread meet in them
+    void* cache = libcache_sharded_create(&attr, 2);
+    CHECK(cache != NULL);
+
+    static sharded_worker_t workers[SHARDED_THREADS];
+    pthread_t threads[SHARDED_THREADS];
+    int t;
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].cache = cache;
+        workers[t].first_key = t * SHARDED_KEYS_PER_THREAD;
+        pthread_create(&threads[t], NULL, sharded_add_worker, &workers[t]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), (libcache_scale_t) SHARDED_THREADS * SHARDED_KEYS_PER_THREAD);
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_create(&threads[t], NULL, sharded_unlock_worker, &workers[(t + 1) % SHARDED_THREADS]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // Note: a key is pinned and unlocked, then deleted, by its entry or by its key
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_create(&threads[t], NULL, sharded_delete_worker, &workers[t]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        CHECK_EQUAL(workers[t].errors, 0);
+    }
+    CHECK_EQUAL(libcache_sharded_get_entry_number(cache), 0U);
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+extern "C" {
+
+typedef struct sharded_pair_t {
+    uint32_t key;
+    uint32_t check;
+    uint32_t padding[6];
+} sharded_pair_t;
+
+#define SHARDED_READ_KEYS 4096
+#define SHARDED_READ_ROUNDS 200000
+
+typedef struct sharded_read_worker_t {
+    void* cache;
+    volatile int* stop;
+    int errors;
+    int hits;
+} sharded_read_worker_t;
+
+static void* sharded_write_worker(void* arg)
+{
+    sharded_read_worker_t* worker = (sharded_read_worker_t*) arg;
+    uint32_t i;
+    for (i = 0; i < SHARDED_READ_ROUNDS; i++) {
+        uint32_t key = (i * 2654435761U) % SHARDED_READ_KEYS;
+        sharded_pair_t pair;
+        memset(&pair, 0, sizeof(pair));
+        pair.key = key;
+        pair.check = ~key;
+        if (libcache_sharded_add(worker->cache, &key, &pair) == NULL) {
+            libcache_sharded_delete_by_key(worker->cache, &key);
+        }
+    }
+    *worker->stop = 1;
+    return NULL;
+}
+
+static void* sharded_read_worker(void* arg)
+{
+    sharded_read_worker_t* worker = (sharded_read_worker_t*) arg;
+    uint32_t key = 0;
+    while (!*worker->stop) {
+        sharded_pair_t pair;
+        key = (key + 7) % SHARDED_READ_KEYS;
+        if (libcache_sharded_read(worker->cache, &key, &pair) != NULL) {
+            worker->hits++;
+            if (pair.key != key || pair.check != ~key) {
+                worker->errors++;
+            }
+        }
+    }
+    return NULL;
+}
+
+}
+
+TEST(TestShardedRead)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = SHARDED_READ_KEYS / 2;
+    attr.entry_size = sizeof(sharded_pair_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    void* cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+
+    uint32_t key = 1;
+    sharded_pair_t pair;
+    CHECK(libcache_sharded_read(cache, &key, &pair) == NULL);
+    pair.key = key;
+    pair.check = ~key;
+    CHECK(libcache_sharded_add(cache, &key, &pair) != NULL);
+    memset(&pair, 0, sizeof(pair));
+    CHECK(libcache_sharded_read(cache, &key, &pair) == &pair);
+    CHECK_EQUAL(pair.key, key);
+    CHECK(libcache_sharded_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    CHECK(libcache_sharded_read(cache, &key, &pair) == NULL);
+
+    // Note: readers never see a torn entry or an entry of another key while a writer adds, swaps and deletes
+    volatile int stop = 0;
+    sharded_read_worker_t workers[3];
+    pthread_t threads[3];
+    int t;
+    for (t = 0; t < 3; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].cache = cache;
+        workers[t].stop = &stop;
+        pthread_create(&threads[t], NULL, (t == 0) ? sharded_write_worker : sharded_read_worker, &workers[t]);
+    }
+    int hits = 0;
+    for (t = 0; t < 3; t++) {
+        pthread_join(threads[t], NULL);
+        CHECK_EQUAL(workers[t].errors, 0);
+        hits += workers[t].hits;
+    }
+    CHECK(hits > 0);
+
+    CHECK(libcache_sharded_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedHotKeys)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.hot_keys = LIBCACHE_HOT_KEYS_MAX + 1;
+    CHECK(libcache_sharded_create(&attr, 4) == NULL);
+    attr.hot_keys = 2;
+    attr.ttl = 10;
+    CHECK(libcache_sharded_create(&attr, 4) == NULL);
+    attr.ttl = 0;
+    void* cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+
+    uint32_t key;
+    for (key = 0; key < 100; key++) {
+        CHECK(libcache_sharded_add(cache, &key, &key) != NULL);
+    }
+
+    // Note: a key taking most reads gets replicas, reads of it are then served by them
+    key = 7;
+    uint32_t value = 0;
+    int i;
+    for (i = 0; i < 4000; i++) {
+        value = 0;
+        CHECK(libcache_sharded_read(cache, &key, &value) == &value);
+        CHECK_EQUAL(7u, value);
+    }
+    libcache_stats_t stats;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_get_stats(cache, &stats));
+    CHECK(stats.replica_hits > 0);
+
+    // Note: a write through a locked entry, an add and a delete make the replicas stale
+    uint32_t* entry = (uint32_t*) libcache_sharded_lookup(cache, &key, NULL);
+    CHECK(entry != NULL);
+    *entry = 1007;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_unlock_entry(cache, entry));
+    CHECK(libcache_sharded_read(cache, &key, &value) == &value);
+    CHECK_EQUAL(1007u, value);
+    CHECK(libcache_sharded_read(cache, &key, &value) == &value);
+    CHECK_EQUAL(1007u, value);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_delete_by_key(cache, &key));
+    value = 2007;
+    CHECK(libcache_sharded_add(cache, &key, &value) != NULL);
+    CHECK(libcache_sharded_read(cache, &key, &value) == &value);
+    CHECK_EQUAL(2007u, value);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_delete_by_key(cache, &key));
+    CHECK(libcache_sharded_read(cache, &key, &value) == NULL);
+    CHECK(libcache_sharded_add(cache, &key, &key) != NULL);
+    CHECK(libcache_sharded_read(cache, &key, &value) == &value);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_clean(cache));
+    CHECK(libcache_sharded_read(cache, &key, &value) == NULL);
+
+    unsigned long long replica_hits = stats.replica_hits;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_get_stats(cache, &stats));
+    CHECK(stats.replica_hits >= replica_hits);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_destroy(cache));
+}
+
+TEST(TestShardedLookupOrLoad)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(uint32_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = sharded_key_cmp;
+    attr.key_to_number = sharded_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.load_entry = sharded_load_entry;
+    void* cache = libcache_sharded_create(&attr, 4);
+    CHECK(cache != NULL);
+
+    // Note: every thread misses every key at about the same time, a key is loaded once unless its load failed
+    static sharded_worker_t workers[SHARDED_THREADS];
+    pthread_t threads[SHARDED_THREADS];
+    memset(sharded_load_calls, 0, sizeof(sharded_load_calls));
+    int t;
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        workers[t].cache = cache;
+        workers[t].errors = 0;
+        pthread_create(&threads[t], NULL, sharded_load_worker, &workers[t]);
+    }
+    for (t = 0; t < SHARDED_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        CHECK_EQUAL(0, workers[t].errors);
+    }
+    uint32_t k;
+    for (k = 0; k < SHARDED_LOAD_KEYS; k++) {
+        if (k % 8 != 7) {
+            CHECK_EQUAL(1, sharded_load_calls[k]);
+        }
+    }
+    CHECK_EQUAL(SHARDED_LOAD_KEYS / 8 * 7, (int) libcache_sharded_get_entry_number(cache));
+
+    libcache_stats_t stats;
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_get_stats(cache, &stats));
+    unsigned long long calls = 0;
+    for (k = 0; k < SHARDED_LOAD_KEYS; k++) {
+        calls += sharded_load_calls[k];
+    }
+    CHECK_EQUAL(calls, stats.loads);
+    CHECK_EQUAL(libcache_sharded_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST(TestShardedLookupAsync)
+{
+    void* cache = sharded_create_cache(1000, 4);
+    CHECK(cache != NULL);
+    libcache_load_waiter_t loader, waiter;
+    memset(&loader, 0, sizeof(loader));
+    memset(&waiter, 0, sizeof(waiter));
+    waiter.eventfd = eventfd(0, 0);
+    CHECK(waiter.eventfd > 0);
+    uint32_t key = 42;
+    CHECK_EQUAL(LIBCACHE_NOT_FOUND, libcache_sharded_lookup_async(cache, &key, &loader));
+    CHECK_EQUAL(LIBCACHE_LOCKED, libcache_sharded_lookup_async(cache, &key, &waiter));
+
+    // Note: another thread ends the load, the waiting one is woken by its eventfd
+    sharded_completer_t completer = { cache, &loader, key, 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, sharded_complete_worker, &completer);
+    struct pollfd event = { waiter.eventfd, POLLIN, 0 };
+    CHECK_EQUAL(1, poll(&event, 1, 10000));
+    pthread_join(thread, NULL);
+    CHECK_EQUAL(0, completer.errors);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, waiter.result);
+    CHECK_EQUAL(~key, *(uint32_t*) waiter.handle.entry);
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_unlock_entry(cache, waiter.handle.entry));
+    CHECK_EQUAL(LIBCACHE_SUCCESS, libcache_sharded_unlock_entry(cache, loader.handle.entry));
+    close(waiter.eventfd);
+    CHECK_EQUAL(libcache_sharded_destroy(cache), LIBCACHE_SUCCESS);
+}
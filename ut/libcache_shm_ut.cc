@@ -0,0 +1,186 @@
+/*
+ * libcache_shm_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "UnitTest++.h"
+
+extern "C" {
+
+#include "libcache.h"
+
+typedef struct shm_pair_t {
+    uint32_t key;
+    uint32_t check;
+} shm_pair_t;
+
+static uint32_t shm_key_to_int(const void* key)
+{
+    return *(const uint32_t*) key;
+}
+
+static libcache_cmp_ret_t shm_key_cmp(const void* key1, const void* key2)
+{
+    return (*(const uint32_t*) key1 == *(const uint32_t*) key2) ? LIBCACHE_EQU : LIBCACHE_NOT_EQU;
+}
+
+static void* shm_create_cache(const char* name, libcache_index_e index_type)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 200;
+    attr.entry_size = sizeof(shm_pair_t);
+    attr.key_size = sizeof(uint32_t);
+    attr.cmp_key = shm_key_cmp;
+    attr.key_to_number = shm_key_to_int;
+    attr.index_type = index_type;
+    attr.page_type = LIBCACHE_PAGE_SHARED;
+    attr.shm_name = name;
+    return libcache_create_ex(&attr);
+}
+
+static int shm_add_range(void* cache, uint32_t first, uint32_t last)
+{
+    uint32_t key;
+    for (key = first; key < last; key++) {
+        shm_pair_t pair = { key, ~key };
+        if (libcache_add(cache, &key, &pair) == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Note: the number of keys in [first, last) read back correctly
+static uint32_t shm_read_range(void* cache, uint32_t first, uint32_t last)
+{
+    uint32_t key;
+    uint32_t hits = 0;
+    for (key = first; key < last; key++) {
+        shm_pair_t pair;
+        if (libcache_shm_read(cache, &key, &pair) != NULL && pair.key == key && pair.check == ~key) {
+            hits++;
+        }
+    }
+    return hits;
+}
+
+// Note: the creator runs in a child process, every step waits for a byte from the parent
+static int shm_creator(const char* name, libcache_index_e index_type, int to_parent, int from_parent)
+{
+    char step = 0;
+    void* cache = shm_create_cache(name, index_type);
+    if (cache == NULL || shm_add_range(cache, 0, 100) != 0 || write(to_parent, &step, 1) != 1
+            || read(from_parent, &step, 1) != 1) {
+        return 1;
+    }
+    uint32_t key;
+    for (key = 0; key < 50; key++) {
+        if (libcache_delete_by_key(cache, &key) != LIBCACHE_SUCCESS) {
+            return 2;
+        }
+    }
+    if (shm_add_range(cache, 100, 150) != 0 || write(to_parent, &step, 1) != 1
+            || read(from_parent, &step, 1) != 1) {
+        return 3;
+    }
+    return (libcache_destroy(cache) == LIBCACHE_SUCCESS) ? 0 : 4;
+}
+
+}
+
+TEST(TestSharedMemoryCreator)
+{
+    char name[LIBCACHE_SHM_NAME_MAX];
+    snprintf(name, sizeof(name), "/libcache_ut_%d", (int) getpid());
+    void* cache = shm_create_cache(name, LIBCACHE_INDEX_CHAINED);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(libcache_get_page_type(cache), LIBCACHE_PAGE_SHARED);
+
+    // Note: a name can't be taken twice, and the creator's process has the address in use already
+    CHECK(shm_create_cache(name, LIBCACHE_INDEX_CHAINED) == NULL);
+    CHECK(libcache_attach(name, shm_key_cmp, shm_key_to_int) == NULL);
+    CHECK(libcache_resize(cache, 400) == LIBCACHE_FAILURE);
+
+    CHECK_EQUAL(shm_add_range(cache, 0, 300), 0);
+    CHECK_EQUAL(libcache_get_entry_number(cache), 201U);
+    CHECK_EQUAL(shm_read_range(cache, 0, 300), 201U);
+    CHECK_EQUAL(libcache_clean(cache), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(shm_read_range(cache, 0, 300), 0U);
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+
+    CHECK(libcache_attach(name, shm_key_cmp, shm_key_to_int) == NULL);
+    CHECK(shm_create_cache(NULL, LIBCACHE_INDEX_CHAINED) == NULL);
+}
+
+TEST(TestSharedMemoryAttach)
+{
+    libcache_index_e index_types[] = { LIBCACHE_INDEX_CHAINED, LIBCACHE_INDEX_OPEN, LIBCACHE_INDEX_GROUP,
+            LIBCACHE_INDEX_GROUP_COMPACT };
+    size_t t;
+    for (t = 0; t < sizeof(index_types) / sizeof(index_types[0]); t++) {
+        char name[LIBCACHE_SHM_NAME_MAX];
+        snprintf(name, sizeof(name), "/libcache_ut_%d_%d", (int) getpid(), (int) t);
+        int to_parent[2];
+        int from_parent[2];
+        CHECK(pipe(to_parent) == 0 && pipe(from_parent) == 0);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(shm_creator(name, index_types[t], to_parent[1], from_parent[0]));
+        }
+        CHECK(pid > 0);
+
+        char step = 0;
+        CHECK_EQUAL(read(to_parent[0], &step, 1), 1);
+        void* cache = libcache_attach(name, shm_key_cmp, shm_key_to_int);
+        CHECK(cache != NULL);
+        if (cache != NULL) {
+            CHECK_EQUAL(libcache_get_entry_number(cache), 100U);
+            CHECK_EQUAL(libcache_get_max_entry_number(cache), 200U);
+            CHECK_EQUAL(shm_read_range(cache, 0, 100), 100U);
+            CHECK_EQUAL(shm_read_range(cache, 100, 150), 0U);
+
+            // Note: only the creator writes the cache
+            uint32_t key = 1000;
+            shm_pair_t pair = { key, ~key };
+            CHECK(libcache_add(cache, &key, &pair) == NULL);
+            key = 0;
+            CHECK(libcache_lookup(cache, &key, &pair) == NULL);
+            CHECK_EQUAL(libcache_delete_by_key(cache, &key), LIBCACHE_FAILURE);
+            CHECK_EQUAL(libcache_clean(cache), LIBCACHE_FAILURE);
+        }
+
+        // Note: changes of the creator are seen at once
+        CHECK_EQUAL(write(from_parent[1], &step, 1), 1);
+        CHECK_EQUAL(read(to_parent[0], &step, 1), 1);
+        if (cache != NULL) {
+            CHECK_EQUAL(libcache_get_entry_number(cache), 100U);
+            CHECK_EQUAL(shm_read_range(cache, 0, 50), 0U);
+            CHECK_EQUAL(shm_read_range(cache, 50, 150), 100U);
+        }
+
+        // Note: the segment is unlinked by the creator, an attached process keeps its mapping
+        CHECK_EQUAL(write(from_parent[1], &step, 1), 1);
+        int status = -1;
+        CHECK_EQUAL(waitpid(pid, &status, 0), pid);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK(libcache_attach(name, shm_key_cmp, shm_key_to_int) == NULL);
+        if (cache != NULL) {
+            CHECK_EQUAL(shm_read_range(cache, 50, 150), 0U);
+            CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+        }
+
+        close(to_parent[0]);
+        close(to_parent[1]);
+        close(from_parent[0]);
+        close(from_parent[1]);
+    }
+}
@@ -10,6 +10,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <math.h>
+#include <string.h>
 #include "UnitTest++.h"
 #include "TestReporter.h"
 #include "TestDetails.h"
@@ -18,6 +20,7 @@
 extern "C" {
 #endif
 #include "libcache.h"
+#include "libcache_policy.h"
 
 
 #ifdef __cplusplus
@@ -228,3 +231,262 @@ TEST(libcache_unit_test)
     CHECK(libcache_get_entry_number(libcache) == 0);
     libcache_test_destroy(libcache);
  }
+
+#define POLICY_BENCH_KEYS       100000
+#define POLICY_BENCH_CACHE      2000
+#define POLICY_BENCH_OPS        1000000
+#define POLICY_BENCH_SCAN_EVERY 50000   /* a scan of new keys every 50000 requests */
+#define POLICY_BENCH_SCAN_LEN   5000
+#define POLICY_BENCH_ZIPF_S     0.9
+
+static uint64_t policy_bench_random(uint64_t* state)
+{
+    // Note: xorshift64*, fixed seed makes every policy see the same requests
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static void policy_bench_trace(uint64_t* trace, int length)
+{
+    double* cdf = (double*) malloc(sizeof(double) * POLICY_BENCH_KEYS);
+    double sum = 0;
+    int i;
+    for (i = 0; i < POLICY_BENCH_KEYS; i++) {
+        sum += 1.0 / pow(i + 1, POLICY_BENCH_ZIPF_S);
+        cdf[i] = sum;
+    }
+
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    uint64_t scan_key = POLICY_BENCH_KEYS;
+    for (i = 0; i < length; i++) {
+        if (i % POLICY_BENCH_SCAN_EVERY < POLICY_BENCH_SCAN_LEN) {
+            trace[i] = scan_key++;
+            continue;
+        }
+        double u = (policy_bench_random(&state) >> 11) * (1.0 / 9007199254740992.0) * sum;
+        int low = 0;
+        int high = POLICY_BENCH_KEYS - 1;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (cdf[middle] < u) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        trace[i] = low;
+    }
+    free(cdf);
+}
+
+static double policy_bench_run(libcache_policy_e policy, const uint64_t* trace, int length)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = POLICY_BENCH_CACHE;
+    attr.entry_size = sizeof(liblb_cache_entry_t);
+    attr.key_size = sizeof(cache_key_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = cmp_key_imp;
+    attr.key_to_number = key_to_number_imp;
+    attr.policy = policy;
+    void* libcache = libcache_create_ex(&attr);
+
+    cache_key_t key;
+    memset(&key, 0, sizeof(key));
+    liblb_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    int hit = 0;
+    int i;
+    struct timeval t0, t1, td;
+    gettimeofday(&t0, 0);
+    for (i = 0; i < length; i++) {
+        key.imsi.val.imsi64bit = trace[i];
+        if (libcache_lookup(libcache, &key, &entry) != NULL) {
+            hit++;
+        } else {
+            entry.value = trace[i];
+            libcache_add(libcache, &key, &entry);
+        }
+    }
+    gettimeofday(&t1, 0);
+    int64_t usec = timeval_subtract(&td, &t0, &t1);
+
+    double hit_ratio = (double) hit / length;
+    printf("policy %-8s hit ratio = %.4f ns/op = %.1f\n", libcache_policy_get(policy)->name,
+            hit_ratio, usec * 1000.0 / length);
+    libcache_destroy(libcache);
+    return hit_ratio;
+}
+
+TEST(libcache_policy_bench)
+{
+    uint64_t* trace = (uint64_t*) malloc(sizeof(uint64_t) * POLICY_BENCH_OPS);
+    policy_bench_trace(trace, POLICY_BENCH_OPS);
+
+    double lru = policy_bench_run(LIBCACHE_POLICY_LRU, trace, POLICY_BENCH_OPS);
+    policy_bench_run(LIBCACHE_POLICY_CLOCK, trace, POLICY_BENCH_OPS);
+    policy_bench_run(LIBCACHE_POLICY_FIFO, trace, POLICY_BENCH_OPS);
+    double slru = policy_bench_run(LIBCACHE_POLICY_SLRU, trace, POLICY_BENCH_OPS);
+    double tinylfu = policy_bench_run(LIBCACHE_POLICY_TINYLFU, trace, POLICY_BENCH_OPS);
+
+    // Note: zipf with scans, frequency based admission should be better than recency only
+    CHECK(slru > lru);
+    CHECK(tinylfu > lru);
+    free(trace);
+}
+
+#define BATCH_BENCH_ENTRIES 1000000
+#define BATCH_BENCH_BURST 32
+#define BATCH_BENCH_ROUNDS 20000
+
+static void batch_bench_run(const char* name, libcache_index_e index_type)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = BATCH_BENCH_ENTRIES;
+    attr.entry_size = sizeof(liblb_cache_entry_t);
+    attr.key_size = sizeof(cache_key_t);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = cmp_key_imp;
+    attr.key_to_number = key_to_number_imp;
+    attr.index_type = index_type;
+    void* libcache = libcache_create_ex(&attr);
+    CHECK(libcache != NULL);
+
+    cache_key_t* keys = (cache_key_t*) calloc(BATCH_BENCH_ENTRIES, sizeof(cache_key_t));
+    liblb_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    int i;
+    for (i = 0; i < BATCH_BENCH_ENTRIES; i++) {
+        keys[i].imsi.val.imsi64bit = i;
+        libcache_add(libcache, &keys[i], &entry);
+    }
+
+    // Note: random bursts of keys, same keys for both APIs
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    const void** burst_keys = (const void**) malloc(sizeof(void*) * BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS);
+    for (i = 0; i < BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS; i++) {
+        burst_keys[i] = &keys[policy_bench_random(&state) % BATCH_BENCH_ENTRIES];
+    }
+
+    liblb_cache_entry_t dst[BATCH_BENCH_BURST];
+    void* entries[BATCH_BENCH_BURST];
+    int found_single = 0;
+    int found_batch = 0;
+    struct timeval t0, t1, td;
+    gettimeofday(&t0, 0);
+    for (i = 0; i < BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS; i++) {
+        if (libcache_lookup(libcache, burst_keys[i], &dst[i % BATCH_BENCH_BURST]) != NULL) {
+            found_single++;
+        }
+    }
+    gettimeofday(&t1, 0);
+    int64_t single_usec = timeval_subtract(&td, &t0, &t1);
+
+    gettimeofday(&t0, 0);
+    for (i = 0; i < BATCH_BENCH_ROUNDS; i++) {
+        found_batch += libcache_lookup_batch(libcache, burst_keys + i * BATCH_BENCH_BURST, BATCH_BENCH_BURST, dst, entries);
+    }
+    gettimeofday(&t1, 0);
+    int64_t batch_usec = timeval_subtract(&td, &t0, &t1);
+
+    printf("index %-6s lookup ns/op = %.1f, lookup_batch(%d) ns/op = %.1f\n", name,
+            single_usec * 1000.0 / (BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS), BATCH_BENCH_BURST,
+            batch_usec * 1000.0 / (BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS));
+    CHECK_EQUAL(found_single, BATCH_BENCH_BURST * BATCH_BENCH_ROUNDS);
+    CHECK_EQUAL(found_batch, found_single);
+
+    free(burst_keys);
+    free(keys);
+    libcache_destroy(libcache);
+}
+
+TEST(libcache_batch_bench)
+{
+    batch_bench_run("open", LIBCACHE_INDEX_OPEN);
+    batch_bench_run("group", LIBCACHE_INDEX_GROUP);
+    batch_bench_run("compact", LIBCACHE_INDEX_GROUP_COMPACT);
+}
+
+
+#define ENGINE_BENCH_ENTRIES 1000000
+#define ENGINE_BENCH_OPS 4000000
+
+static size_t engine_bench_allocated = 0;
+
+static void* engine_bench_allocate(size_t size)
+{
+    engine_bench_allocated += size;
+    return malloc(size);
+}
+
+static void engine_bench_run(const char* name, libcache_engine_e engine, const uint64_t* trace)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = ENGINE_BENCH_ENTRIES;
+    attr.entry_size = sizeof(liblb_cache_entry_t);
+    attr.key_size = sizeof(cache_key_t);
+    attr.allocate_memory = engine_bench_allocate;
+    attr.free_memory = free;
+    attr.cmp_key = cmp_key_imp;
+    attr.key_to_number = key_to_number_imp;
+    attr.engine = engine;
+    engine_bench_allocated = 0;
+    void* libcache = libcache_create_ex(&attr);
+    CHECK(libcache != NULL);
+
+    cache_key_t key;
+    memset(&key, 0, sizeof(key));
+    liblb_cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    int i;
+    struct timeval t0, t1, td;
+    gettimeofday(&t0, 0);
+    for (i = 0; i < ENGINE_BENCH_ENTRIES; i++) {
+        key.imsi.val.imsi64bit = i;
+        libcache_add(libcache, &key, &entry);
+    }
+    gettimeofday(&t1, 0);
+    int64_t add_usec = timeval_subtract(&td, &t0, &t1);
+
+    // Note: half of the keys are missed, a miss adds the key, so entries are swapped out too
+    int hit = 0;
+    gettimeofday(&t0, 0);
+    for (i = 0; i < ENGINE_BENCH_OPS; i++) {
+        key.imsi.val.imsi64bit = trace[i];
+        if (libcache_lookup(libcache, &key, &entry) != NULL) {
+            hit++;
+        } else {
+            libcache_add(libcache, &key, &entry);
+        }
+    }
+    gettimeofday(&t1, 0);
+    int64_t mixed_usec = timeval_subtract(&td, &t0, &t1);
+
+    printf("engine %-8s add ns/op = %.1f, lookup/add ns/op = %.1f, hit ratio = %.4f, bytes/entry = %.1f\n",
+            name, add_usec * 1000.0 / ENGINE_BENCH_ENTRIES, mixed_usec * 1000.0 / ENGINE_BENCH_OPS,
+            (double) hit / ENGINE_BENCH_OPS, (double) engine_bench_allocated / ENGINE_BENCH_ENTRIES);
+    CHECK_EQUAL(libcache_get_entry_number(libcache), (libcache_scale_t) ENGINE_BENCH_ENTRIES + 1);
+    libcache_destroy(libcache);
+}
+
+TEST(libcache_engine_bench)
+{
+    uint64_t* trace = (uint64_t*) malloc(sizeof(uint64_t) * ENGINE_BENCH_OPS);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    int i;
+    for (i = 0; i < ENGINE_BENCH_OPS; i++) {
+        trace[i] = policy_bench_random(&state) % (ENGINE_BENCH_ENTRIES * 2);
+    }
+
+    // Note: same keys and requests for both engines
+    engine_bench_run("pool", LIBCACHE_ENGINE_POOL, trace);
+    engine_bench_run("compact", LIBCACHE_ENGINE_COMPACT, trace);
+    free(trace);
+}
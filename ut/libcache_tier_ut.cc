@@ -0,0 +1,127 @@
+/*
+ * libcache_tier_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "UnitTest++.h"
+#include "libcache_tier.h"
+
+#define TIER_UT_PATH "/tmp/libcache_tier_ut.log"
+#define TIER_UT_ENTRY_SIZE 4096
+
+static void tier_ut_entry(char* entry, size_t length, int key)
+{
+    size_t i;
+    for (i = 0; i < length; i++) {
+        entry[i] = (char) (key * 31 + i);
+    }
+}
+
+TEST(TestTierPutRead)
+{
+    CHECK(libcache_tier_create(TIER_UT_PATH, LIBCACHE_TIER_SEGMENT_SIZE, 1000, TIER_UT_ENTRY_SIZE) == NULL);
+    void* tier = libcache_tier_create(TIER_UT_PATH, LIBCACHE_TIER_SEGMENT_SIZE * 3 + 100, 1000, TIER_UT_ENTRY_SIZE);
+    CHECK(tier != NULL);
+    CHECK(libcache_tier_get_fd(tier) > 0);
+    CHECK_EQUAL((size_t) TIER_UT_ENTRY_SIZE, libcache_tier_get_entry_size(tier));
+
+    static char entry[TIER_UT_ENTRY_SIZE];
+    static char expected[TIER_UT_ENTRY_SIZE];
+    size_t length = 0;
+    int key = 0;
+    tier_ut_entry(entry, 100, key);
+    CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, 100));
+    CHECK(!libcache_tier_put(tier, &key, sizeof(key), entry, TIER_UT_ENTRY_SIZE + 1));
+    memset(entry, 0, sizeof(entry));
+    CHECK(libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    CHECK_EQUAL(100u, length);
+    tier_ut_entry(expected, 100, key);
+    CHECK(0 == memcmp(entry, expected, 100));
+
+    // Note: a put of the same key replaces its entry, a removed one is gone
+    tier_ut_entry(entry, 200, key + 1);
+    CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, 200));
+    CHECK_EQUAL(1u, libcache_tier_get_entry_number(tier));
+    CHECK(libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    CHECK_EQUAL(200u, length);
+    CHECK(libcache_tier_remove(tier, &key, sizeof(key)));
+    CHECK(!libcache_tier_remove(tier, &key, sizeof(key)));
+    CHECK(!libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+
+    // Note: once its segment is full, an entry is read from the file, or by the caller where it's located
+    int entries_per_segment = LIBCACHE_TIER_SEGMENT_SIZE / TIER_UT_ENTRY_SIZE;
+    for (key = 0; key < entries_per_segment + 1; key++) {
+        tier_ut_entry(entry, TIER_UT_ENTRY_SIZE, key);
+        CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, TIER_UT_ENTRY_SIZE));
+    }
+    key = 1;
+    libcache_tier_location_t location;
+    CHECK(libcache_tier_locate(tier, &key, sizeof(key), entry, &location));
+    CHECK(location.offset >= 0);
+    CHECK_EQUAL((size_t) TIER_UT_ENTRY_SIZE, location.entry_length);
+    tier_ut_entry(expected, TIER_UT_ENTRY_SIZE, key);
+    CHECK(pread(libcache_tier_get_fd(tier), entry, location.entry_length, location.offset) == TIER_UT_ENTRY_SIZE);
+    CHECK(0 == memcmp(entry, expected, TIER_UT_ENTRY_SIZE));
+    memset(entry, 0, sizeof(entry));
+    CHECK(libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    CHECK(0 == memcmp(entry, expected, TIER_UT_ENTRY_SIZE));
+    key = entries_per_segment;
+    CHECK(libcache_tier_locate(tier, &key, sizeof(key), entry, &location));
+    CHECK_EQUAL(-1, location.offset);
+    tier_ut_entry(expected, TIER_UT_ENTRY_SIZE, key);
+    CHECK(0 == memcmp(entry, expected, TIER_UT_ENTRY_SIZE));
+
+    // Note: the log of 3 segments wraps, the oldest entries are overwritten
+    for (key = entries_per_segment + 1; key < entries_per_segment * 3 + 1; key++) {
+        tier_ut_entry(entry, TIER_UT_ENTRY_SIZE, key);
+        CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, TIER_UT_ENTRY_SIZE));
+    }
+    key = 1;
+    CHECK(!libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    key = entries_per_segment * 2;
+    CHECK(libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    tier_ut_entry(expected, TIER_UT_ENTRY_SIZE, key);
+    CHECK(0 == memcmp(entry, expected, TIER_UT_ENTRY_SIZE));
+
+    libcache_tier_clear(tier);
+    CHECK_EQUAL(0u, libcache_tier_get_entry_number(tier));
+    CHECK(!libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    libcache_tier_destroy(tier);
+    unlink(TIER_UT_PATH);
+}
+
+TEST(TestTierFull)
+{
+    void* tier = libcache_tier_create(TIER_UT_PATH, LIBCACHE_TIER_SEGMENT_SIZE * 2, 4, 64);
+    CHECK(tier != NULL);
+    char entry[64];
+    memset(entry, 1, sizeof(entry));
+    int key;
+    for (key = 0; key < 4; key++) {
+        CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, sizeof(entry)));
+    }
+
+    // Note: a full index takes no more keys, the ones in it are still replaced
+    CHECK(!libcache_tier_put(tier, &key, sizeof(key), entry, sizeof(entry)));
+    CHECK(libcache_tier_reserve(tier, &key, sizeof(key), sizeof(entry)) == NULL);
+    key = 0;
+    CHECK(libcache_tier_put(tier, &key, sizeof(key), entry, sizeof(entry)));
+    CHECK(libcache_tier_remove(tier, &key, sizeof(key)));
+    key = 4;
+    char* reserved = (char*) libcache_tier_reserve(tier, &key, sizeof(key), 10);
+    CHECK(reserved != NULL);
+    memcpy(reserved, "0123456789", 10);
+    size_t length = 0;
+    CHECK(libcache_tier_read(tier, &key, sizeof(key), entry, &length));
+    CHECK_EQUAL(10u, length);
+    CHECK(0 == memcmp(entry, "0123456789", 10));
+    CHECK_EQUAL(4u, libcache_tier_get_entry_number(tier));
+    libcache_tier_destroy(tier);
+    unlink(TIER_UT_PATH);
+}
@@ -0,0 +1,110 @@
+/*
+ * libcache_ttl_ut.cc
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UnitTest++.h"
+#include "libcache_ttl.h"
+
+#define TTL_UT_ENTRIES 2000
+
+static uint64_t ttl_ut_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/*
+ * Pops every due entry, each one must be expired by the clock, none expired may be left armed.
+ */
+static int ttl_ut_drain(libcache_ttl_wheel_t* wheel, libcache_ttl_entry_t entries[], int count)
+{
+    int result = TRUE;
+    node_t* node = NULL;
+    while (NULL != (node = libcache_ttl_advance(wheel))) {
+        libcache_ttl_entry_t* entry = (libcache_ttl_entry_t*) node->usr_data;
+        result = result && libcache_ttl_expired(wheel, entry);
+        libcache_ttl_disarm(wheel, entry);
+    }
+    int i;
+    for (i = 0; i < count; i++) {
+        result = result && !(LIBCACHE_TTL_UNLINKED != entries[i].slot && libcache_ttl_expired(wheel, &entries[i]));
+    }
+    return result;
+}
+
+TEST(TestTtlWheelOrder)
+{
+    static libcache_ttl_wheel_t wheel;
+    static libcache_ttl_entry_t entries[TTL_UT_ENTRIES];
+    libcache_ttl_init(&wheel, 1000);
+    CHECK(libcache_ttl_advance(&wheel) == NULL);
+
+    // Note: expiries spread over every level, and some beyond the range of the wheel
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    int i;
+    for (i = 0; i < TTL_UT_ENTRIES; i++) {
+        uint32_t bits = 1 + (uint32_t) (ttl_ut_random(&state) % 26);
+        entries[i].wheel_node.usr_data = &entries[i];
+        entries[i].expire_at = 1000 + 1 + (uint32_t) (ttl_ut_random(&state) & ((1U << bits) - 1));
+        entries[i].slot = LIBCACHE_TTL_UNLINKED;
+        libcache_ttl_arm(&wheel, &entries[i]);
+    }
+    CHECK_EQUAL((uint32_t) TTL_UT_ENTRIES, wheel.count);
+
+    // Note: some are disarmed before they expire
+    for (i = 0; i < TTL_UT_ENTRIES; i += 7) {
+        libcache_ttl_disarm(&wheel, &entries[i]);
+    }
+    libcache_ttl_disarm(&wheel, &entries[0]);
+
+    // Note: steps of the clock from one tick to millions
+    while (wheel.count > 0) {
+        uint32_t bits = (uint32_t) (ttl_ut_random(&state) % 24);
+        wheel.clock += 1 + (uint32_t) (ttl_ut_random(&state) & ((1U << bits) - 1));
+        CHECK(ttl_ut_drain(&wheel, entries, TTL_UT_ENTRIES));
+    }
+    CHECK(wheel.clock >= (1U << 26));
+    for (i = 0; i < TTL_UT_ENTRIES; i++) {
+        CHECK_EQUAL(LIBCACHE_TTL_UNLINKED, entries[i].slot);
+    }
+}
+
+TEST(TestTtlWheelExpired)
+{
+    static libcache_ttl_wheel_t wheel;
+    libcache_ttl_entry_t late, due;
+    libcache_ttl_init(&wheel, 100);
+    late.wheel_node.usr_data = &late;
+    late.slot = LIBCACHE_TTL_UNLINKED;
+    late.expire_at = 50;
+    due.wheel_node.usr_data = &due;
+    due.slot = LIBCACHE_TTL_UNLINKED;
+    due.expire_at = 164;
+
+    // Note: an entry armed after its expiry is due at once
+    libcache_ttl_arm(&wheel, &late);
+    CHECK(libcache_ttl_expired(&wheel, &late));
+    CHECK(libcache_ttl_advance(&wheel) == &late.wheel_node);
+    libcache_ttl_disarm(&wheel, &late);
+    CHECK(libcache_ttl_advance(&wheel) == NULL);
+
+    // Note: the clock stops the wheel, 164 is in level 1
+    libcache_ttl_arm(&wheel, &due);
+    wheel.clock = 163;
+    CHECK(libcache_ttl_advance(&wheel) == NULL);
+    CHECK_EQUAL(163u, wheel.now);
+    wheel.clock = 1000;
+    CHECK(libcache_ttl_advance(&wheel) == &due.wheel_node);
+    CHECK_EQUAL(164u, wheel.now);
+    libcache_ttl_disarm(&wheel, &due);
+    CHECK(libcache_ttl_advance(&wheel) == NULL);
+    CHECK_EQUAL(1000u, wheel.now);
+}
@@ -1,13 +1,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 #include "UnitTest++.h"
 
 extern "C" {
 
 #include "libcache.h"
+#include "libcache_tier.h"
 #include "libcache_def.h"
+#include "libpool.h"
 
 static uint32_t test_key_to_int(const void* key)
 {
@@ -36,28 +40,66 @@ typedef struct test_data_t {
     void* entry;
 } test_data_t;
 
+static size_t g_allocated_size = 0;
+
+static void* test_counting_allocate(size_t size)
+{
+    g_allocated_size += size;
+    return malloc(size);
+}
+
+static int g_freed_entry_count = 0;
+
+// Note: every entry is added with value same as its key
+static void test_check_free_entry(void* key, void* entry)
+{
+    if (*(int*) key == *(int*) entry) {
+        g_freed_entry_count++;
+    }
 }
 
-struct LibCacheFixture {
+static void* test_create_cache(libcache_scale_t max_entry_number, libcache_engine_e engine)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.engine = engine;
+    return libcache_create_ex(&attr);
+}
+
+}
+
+template <libcache_engine_e engine>
+struct LibCacheEngineFixture {
     void* g_cache;
-    LibCacheFixture()
+    libcache_engine_e g_engine;
+    LibCacheEngineFixture() : g_engine(engine)
     {
-        g_cache = libcache_create(g_max_entry_number,
-                                  sizeof(int),
-                                  sizeof(int),
-                                  malloc,
-                                  free,
-                                  NULL,
-                                  test_key_com,
-                                  test_key_to_int);
-    }
-    ~LibCacheFixture()
+        g_cache = test_create_cache(g_max_entry_number, engine);
+    }
+    ~LibCacheEngineFixture()
     {
         libcache_destroy(g_cache);
     }
 };
 
-TEST_FIXTURE(LibCacheFixture, TestAdd)
+typedef LibCacheEngineFixture<LIBCACHE_ENGINE_POOL> LibCacheFixture;
+typedef LibCacheEngineFixture<LIBCACHE_ENGINE_COMPACT> LibCacheCompactFixture;
+
+// Note: the test runs once with every engine, the compact one is Name##Compact
+#define TEST_ENGINES(Name) \
+    static void Name##Run(void*& g_cache, libcache_engine_e g_engine); \
+    TEST_FIXTURE(LibCacheFixture, Name) { Name##Run(g_cache, g_engine); } \
+    TEST_FIXTURE(LibCacheCompactFixture, Name##Compact) { Name##Run(g_cache, g_engine); } \
+    static void Name##Run(void*& g_cache, libcache_engine_e g_engine)
+
+TEST_ENGINES(TestAdd)
 {
     int key = 100;
     int entry = 1000;
@@ -105,7 +147,7 @@ TEST_FIXTURE(LibCacheFixture, TestAdd)
 
 }
 
-TEST_FIXTURE(LibCacheFixture, TestLookup)
+TEST_ENGINES(TestLookup)
 {
     int i = 0;
     int* key = NULL;
@@ -158,7 +200,7 @@ TEST_FIXTURE(LibCacheFixture, TestLookup)
     CHECK_EQUAL(ret, LIBCACHE_SUCCESS);
 }
 
-TEST_FIXTURE(LibCacheFixture, TestDelete)
+TEST_ENGINES(TestDelete)
 {
     int key = 1;
     int entry = 100;
@@ -220,7 +262,7 @@ TEST_FIXTURE(LibCacheFixture, TestDelete)
     CHECK_EQUAL(ret, LIBCACHE_SUCCESS);
 }
 
-TEST_FIXTURE(LibCacheFixture, TestSwap)
+TEST_ENGINES(TestSwap)
 {
     int* key = NULL;
     int* entry = NULL;
@@ -251,14 +293,7 @@ TEST_FIXTURE(LibCacheFixture, TestSwap)
 
     const libcache_scale_t max_entry_number = 65535;
 
-    g_cache = libcache_create(max_entry_number,
-                              sizeof(int),
-                              sizeof(int),
-                              malloc,
-                              free,
-                              NULL,
-                              test_key_com,
-                              test_key_to_int);
+    g_cache = test_create_cache(max_entry_number, g_engine);
 
     for (i = 0; i < max_entry_number * 10; i++) {
         int* value4 = (int*) libcache_add(g_cache, &i, &i);
@@ -273,3 +308,2375 @@ TEST_FIXTURE(LibCacheFixture, TestSwap)
         CHECK(value5 == NULL);
     }
 }
+
+TEST_ENGINES(TestSwapSkipLocked)
+{
+    int i = 0;
+    int* entryList[g_max_entry_number + 1] = { 0 };
+
+    // Note: the oldest half is locked, the newer half is unlocked
+    for (i = 0; i <= (int) g_max_entry_number; i++) {
+        int entry = 100 * i;
+        entryList[i] = (int*) libcache_add(g_cache, &i, (i < 50) ? NULL : &entry);
+        CHECK(entryList[i] != NULL);
+    }
+
+    // Note: the least recently used unlocked entry is swapped out, locked ones are kept
+    int key = 200;
+    int entry = 2000;
+    CHECK(libcache_add(g_cache, &key, &entry) != NULL);
+    int dst = 0;
+    key = 50;
+    CHECK(libcache_lookup(g_cache, &key, &dst) == NULL);
+    key = 0;
+    CHECK(libcache_lookup(g_cache, &key, &dst) != NULL);
+    CHECK_EQUAL(libcache_get_entry_number(g_cache), g_max_entry_number + 1);
+
+    // Note: an unlocked entry goes back to the front of list
+    CHECK_EQUAL(libcache_unlock_entry(g_cache, entryList[0]), LIBCACHE_SUCCESS);
+    for (i = 300; i < 300 + 50; i++) {
+        CHECK(libcache_add(g_cache, &i, &i) != NULL);
+    }
+    key = 100;
+    CHECK(libcache_lookup(g_cache, &key, &dst) == NULL);
+    key = 200;
+    CHECK(libcache_lookup(g_cache, &key, &dst) != NULL);
+    key = 0;
+    CHECK(libcache_lookup(g_cache, &key, &dst) != NULL);
+
+    CHECK_EQUAL(libcache_delete_entry(g_cache, entryList[1]), LIBCACHE_LOCKED);
+    for (i = 1; i < 50; i++) {
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, entryList[i]), LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(libcache_delete_entry(g_cache, entryList[1]), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(g_cache), g_max_entry_number);
+
+    CHECK_EQUAL(libcache_clean(g_cache), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(g_cache), 0);
+}
+
+TEST(TestOpenIndexSwap)
+{
+    const libcache_scale_t max_entry_number = 1000;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.index_type = LIBCACHE_INDEX_OPEN;
+
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    int i = 0;
+    for (i = 0; i < (int) max_entry_number * 10; i++) {
+        int* value = (int*) libcache_add(cache, &i, &i);
+        CHECK(value != NULL && *value == i);
+    }
+    CHECK_EQUAL(libcache_get_entry_number(cache), max_entry_number + 1);
+
+    for (i = 0; i < (int) max_entry_number * 10; i++) {
+        int entry = -1;
+        int* value = (int*) libcache_lookup(cache, &i, &entry);
+        if (i < (int) (max_entry_number * 9 - 1)) {
+            CHECK(value == NULL);
+        } else {
+            CHECK(value != NULL && entry == i);
+        }
+    }
+
+    int key = max_entry_number * 10 - 1;
+    CHECK_EQUAL(libcache_delete_by_key(cache, &key), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(cache), max_entry_number);
+
+    CHECK_EQUAL(libcache_clean(cache), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(cache), 0);
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+    CHECK(libcache_create_ex(NULL) == NULL);
+}
+
+TEST(TestClockPolicySwap)
+{
+    const libcache_scale_t max_entry_number = 99;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.policy = LIBCACHE_POLICY_CLOCK;
+
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    int i = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+
+    // Note: referenced entries get a second chance, the others are swapped out in insertion order
+    int dst = 0;
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    }
+    for (i = 100; i < 150; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    for (i = 0; i < 150; i++) {
+        int* value = (int*) libcache_lookup(cache, &i, &dst);
+        CHECK((i >= 50 && i < 100) ? (value == NULL) : (value != NULL && dst == i));
+    }
+
+    // Note: all reference bits are set now, the hand goes around once and swaps out at its position
+    int key = 200;
+    CHECK(libcache_add(cache, &key, &key) != NULL);
+    CHECK_EQUAL(libcache_get_entry_number(cache), 100);
+
+    // Note: locked entries are never swapped out
+    int* locked = (int*) libcache_lookup(cache, &key, NULL);
+    CHECK(locked != NULL);
+    for (i = 300; i < 500; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK(libcache_lookup(cache, &key, &dst) != NULL);
+    CHECK_EQUAL(libcache_unlock_entry(cache, locked), LIBCACHE_SUCCESS);
+
+    CHECK_EQUAL(libcache_clean(cache), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_destroy(cache), LIBCACHE_SUCCESS);
+}
+
+TEST_ENGINES(TestPeek)
+{
+    void* libcache = g_cache;
+
+    int i;
+    for (i = 0; i <= (int) g_max_entry_number; i++) {
+        CHECK(libcache_add(libcache, &i, &i) != NULL);
+    }
+
+    // Note: peek doesn't refresh the entry, it's still the least recently used one
+    int dst = -1;
+    i = 0;
+    CHECK(libcache_peek(libcache, &i, &dst) == &dst);
+    CHECK_EQUAL(dst, 0);
+    CHECK(libcache_peek(libcache, &i, NULL) == NULL);
+    i = g_max_entry_number + 1;
+    CHECK(libcache_peek(libcache, &i, &dst) == NULL);
+    CHECK(libcache_add(libcache, &i, &i) != NULL);
+    i = 0;
+    CHECK(libcache_peek(libcache, &i, &dst) == NULL);
+}
+
+
+TEST_ENGINES(TestTryUnlock)
+{
+    int key = 1;
+    int* entry = (int*) libcache_add(g_cache, &key, NULL);
+    CHECK(entry != NULL);
+
+    // Note: only an entry locked more than once can be unlocked without the cache
+    CHECK_EQUAL(libcache_try_unlock_entry(entry), LIBCACHE_FAILURE);
+    CHECK(libcache_lookup(g_cache, &key, NULL) == entry);
+    CHECK_EQUAL(libcache_try_unlock_entry(entry), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_try_unlock_entry(entry), LIBCACHE_FAILURE);
+    CHECK_EQUAL(libcache_delete_by_key(g_cache, &key), LIBCACHE_LOCKED);
+    CHECK_EQUAL(libcache_unlock_entry(g_cache, entry), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_try_unlock_entry(entry), LIBCACHE_FAILURE);
+    CHECK_EQUAL(libcache_unlock_entry(g_cache, entry), LIBCACHE_UNLOCKED);
+    CHECK_EQUAL(libcache_delete_by_key(g_cache, &key), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_try_unlock_entry(NULL), LIBCACHE_FAILURE);
+}
+
+TEST_ENGINES(TestBatch)
+{
+    const int count = 50;
+    int keys[count];
+    int values[count];
+    const void* key_ptrs[count];
+    void* entries[count];
+    int i;
+    for (i = 0; i < count; i++) {
+        // Note: key 0 appears twice, the second one can't be added
+        keys[i] = (i == count - 1) ? 0 : i;
+        values[i] = i * 10;
+        key_ptrs[i] = &keys[i];
+    }
+
+    CHECK_EQUAL(libcache_add_batch(g_cache, key_ptrs, count, values, entries), count - 1);
+    CHECK(entries[count - 1] == NULL);
+    CHECK_EQUAL(libcache_get_entry_number(g_cache), (libcache_scale_t) count - 1);
+
+    // Note: copy out
+    int dst[count];
+    keys[count - 1] = 1000;
+    CHECK_EQUAL(libcache_lookup_batch(g_cache, key_ptrs, count, dst, entries), count - 1);
+    for (i = 0; i < count - 1; i++) {
+        CHECK(entries[i] == &dst[i]);
+        CHECK_EQUAL(dst[i], i * 10);
+    }
+    CHECK(entries[count - 1] == NULL);
+
+    // Note: lock all found entries
+    CHECK_EQUAL(libcache_lookup_batch(g_cache, key_ptrs, count, NULL, entries), count - 1);
+    for (i = 0; i < count - 1; i++) {
+        CHECK(entries[i] != NULL);
+        CHECK_EQUAL(*(int*) entries[i], i * 10);
+        CHECK_EQUAL(libcache_delete_by_key(g_cache, &keys[i]), LIBCACHE_LOCKED);
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, entries[i]), LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(libcache_lookup_batch(g_cache, key_ptrs, 0, NULL, entries), 0);
+
+    // Note: a burst sets the bit of every key found in hit_mask, found entries are locked too
+    uint64_t hit_mask = 0;
+    CHECK_EQUAL(libcache_lookup_burst(g_cache, key_ptrs, count, &hit_mask, entries), count - 1);
+    CHECK(hit_mask == (1ULL << (count - 1)) - 1);
+    for (i = 0; i < count - 1; i++) {
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, entries[i]), LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(libcache_lookup_burst(g_cache, key_ptrs, LIBCACHE_BURST_MAX + 1, &hit_mask, entries), 0);
+}
+
+TEST_ENGINES(TestLookupOrAdd)
+{
+    int i;
+    int inserted = FALSE;
+    for (i = 0; i < 10; i++) {
+        int* entry = (int*) libcache_lookup_or_add(g_cache, &i, &inserted);
+        CHECK(entry != NULL);
+        CHECK(inserted);
+        *entry = i * 3;
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, entry), LIBCACHE_SUCCESS);
+    }
+    i = 5;
+    int* entry = (int*) libcache_lookup_or_add(g_cache, &i, &inserted);
+    CHECK(entry != NULL);
+    CHECK(!inserted);
+    CHECK_EQUAL(15, *entry);
+    CHECK_EQUAL(libcache_delete_by_key(g_cache, &i), LIBCACHE_LOCKED);
+    CHECK_EQUAL(libcache_unlock_entry(g_cache, entry), LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(g_cache), 10U);
+
+    // Note: found and added entries of a batch are all locked
+    const int count = 20;
+    int keys[count];
+    const void* key_ptrs[count];
+    void* entries[count];
+    int inserted_list[count];
+    for (i = 0; i < count; i++) {
+        keys[i] = i + 5;
+        key_ptrs[i] = &keys[i];
+    }
+    CHECK_EQUAL(libcache_lookup_or_add_batch(g_cache, key_ptrs, count, entries, inserted_list), count);
+    for (i = 0; i < count; i++) {
+        CHECK(entries[i] != NULL);
+        CHECK_EQUAL(inserted_list[i], keys[i] >= 10);
+        if (!inserted_list[i]) {
+            CHECK_EQUAL(*(int*) entries[i], keys[i] * 3);
+        }
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, entries[i]), LIBCACHE_SUCCESS);
+    }
+
+    // Note: once all entries are locked, a missing key can't be added
+    int* locked[2 * g_max_entry_number];
+    int locked_count = 0;
+    for (i = 0; i < 2 * (int) g_max_entry_number; i++) {
+        locked[locked_count] = (int*) libcache_lookup_or_add(g_cache, &i, &inserted);
+        if (locked[locked_count] == NULL) {
+            break;
+        }
+        locked_count++;
+    }
+    CHECK(locked_count >= (int) g_max_entry_number);
+    CHECK(locked_count < 2 * (int) g_max_entry_number);
+    for (i = 0; i < locked_count; i++) {
+        CHECK_EQUAL(libcache_unlock_entry(g_cache, locked[i]), LIBCACHE_SUCCESS);
+    }
+    (void) g_engine;
+}
+
+TEST(TestCompactRecord)
+{
+    const libcache_scale_t max_entry_number = 10000;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = test_counting_allocate;
+    attr.free_memory = free;
+    attr.free_entry = test_check_free_entry;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.index_type = LIBCACHE_INDEX_OPEN;
+
+    g_allocated_size = 0;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    // Note: node, key, entry and index data of an entry are in one record
+    CHECK(g_allocated_size / max_entry_number < 300);
+
+    int i;
+    char* entries[3];
+    for (i = 0; i < 3; i++) {
+        entries[i] = (char*) libcache_add(cache, &i, &i);
+        CHECK(entries[i] != NULL);
+        CHECK_EQUAL(*(const int*) libcache_get_entry_key(entries[i]), i);
+    }
+    // Note: records are cache line aligned
+    CHECK((entries[0] - entries[1]) % 64 == 0);
+    CHECK((entries[1] - entries[2]) % 64 == 0);
+
+    // Note: swapped out records are reused by new keys
+    for (i = 3; i < (int) max_entry_number * 2; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    i = max_entry_number * 2 - 1;
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    CHECK(libcache_get_entry_key(entries[0]) != NULL);
+    CHECK(*(const int*) libcache_get_entry_key(entries[0]) == *(int*) entries[0]);
+
+    g_freed_entry_count = 0;
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(g_freed_entry_count, (int) max_entry_number);
+}
+
+TEST_ENGINES(TestAddResult)
+{
+    int key = 0;
+    int value = 0;
+    void* entry = NULL;
+    CHECK(libcache_add_ex(NULL, &key, &value, sizeof(int), &entry) == LIBCACHE_FAILURE);
+    CHECK(libcache_add_ex(g_cache, &key, &value, sizeof(int) + 1, &entry) == LIBCACHE_FAILURE);
+    CHECK(libcache_add_ex(g_cache, &key, NULL, sizeof(int), &entry) == LIBCACHE_SUCCESS);
+    CHECK(entry != NULL);
+    CHECK(libcache_add_ex(g_cache, &key, &value, sizeof(int), NULL) == LIBCACHE_EXISTING);
+
+    // Note: a cache full of locked entries can't swap any out, it holds one more than max entry number
+    for (key = 1; key <= (int) libcache_get_max_entry_number(g_cache); key++) {
+        CHECK(libcache_add_ex(g_cache, &key, NULL, sizeof(int), NULL) == LIBCACHE_SUCCESS);
+    }
+    CHECK(libcache_add_ex(g_cache, &key, NULL, sizeof(int), NULL) == LIBCACHE_FULL);
+    CHECK(libcache_add(g_cache, &key, NULL) == NULL);
+
+    pool_stats_t stats;
+    CHECK(libcache_get_pool_stats(g_cache, POOL_TYPE_MAX, &stats) == LIBCACHE_FAILURE);
+    CHECK(libcache_get_pool_stats(g_cache, POOL_TYPE_DATA, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(stats.in_use, (unsigned long long) libcache_get_entry_number(g_cache));
+    CHECK_EQUAL(stats.peak, stats.in_use);
+    CHECK(stats.capacity >= stats.peak);
+    CHECK_EQUAL(stats.fail_total, 0ULL);
+
+    // Note: deleted records go back to pool, the peak stays
+    CHECK(libcache_unlock_entry(g_cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_entry(g_cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_get_pool_stats(g_cache, POOL_TYPE_DATA, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(stats.in_use + 1, stats.peak);
+    CHECK(libcache_add_ex(g_cache, &key, &value, sizeof(int), NULL) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestFastClean)
+{
+    size_t entry_memory_sizes[] = { 0, 4 * 64 * 1024 };
+    libcache_index_e index_types[] = { LIBCACHE_INDEX_CHAINED, LIBCACHE_INDEX_OPEN, LIBCACHE_INDEX_GROUP,
+            LIBCACHE_INDEX_GROUP_COMPACT };
+    size_t t;
+    for (t = 0; t < 8; t++) {
+        libcache_attr_t attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.max_entry_number = 999;
+        attr.entry_size = sizeof(int);
+        attr.key_size = sizeof(int);
+        attr.allocate_memory = malloc;
+        attr.free_memory = free;
+        attr.free_entry = test_check_free_entry;
+        attr.cmp_key = test_key_com;
+        attr.key_to_number = test_key_to_int;
+        attr.index_type = index_types[t % 4];
+        attr.entry_memory_size = entry_memory_sizes[t / 4];
+        void* cache = libcache_create_ex(&attr);
+        CHECK(cache != NULL);
+
+        int i;
+        int dst = 0;
+        for (i = 0; i < 2000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK(libcache_lookup(cache, &i, NULL) == NULL);
+        i = 1999;
+        CHECK(libcache_lookup(cache, &i, NULL) != NULL);
+
+        // Note: locked entries are cleaned as well, free_entry isn't called by clean
+        g_freed_entry_count = 0;
+        CHECK_EQUAL(libcache_clean(cache), LIBCACHE_SUCCESS);
+        CHECK_EQUAL(g_freed_entry_count, 0);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 0);
+        pool_stats_t stats;
+        CHECK(libcache_get_pool_stats(cache, POOL_TYPE_DATA, &stats) == LIBCACHE_SUCCESS);
+        CHECK_EQUAL(stats.in_use, 0ULL);
+        CHECK_EQUAL(stats.peak, 1000ULL);
+        for (i = 0; i < 2000; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+        }
+
+        // Note: the cache is as fresh as just created, it holds as many entries as before
+        for (i = 3000; i < 4000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK_EQUAL(libcache_get_entry_number(cache), 1000);
+        for (i = 3000; i < 4000; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            CHECK_EQUAL(dst, i);
+        }
+        i = 3000;
+        CHECK(libcache_lookup(cache, &i, NULL) != NULL);
+        CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_LOCKED);
+        CHECK(libcache_add(cache, &i, &i) == NULL);
+
+        // Note: destroy walks entries only to call free_entry
+        CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+        CHECK_EQUAL(g_freed_entry_count, 1000);
+    }
+}
+
+TEST(TestSmallCacheFootprint)
+{
+    libcache_index_e index_types[] = { LIBCACHE_INDEX_CHAINED, LIBCACHE_INDEX_OPEN, LIBCACHE_INDEX_GROUP,
+            LIBCACHE_INDEX_GROUP_COMPACT };
+    size_t t;
+    for (t = 0; t < sizeof(index_types) / sizeof(index_types[0]); t++) {
+        libcache_attr_t attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.max_entry_number = 100;
+        attr.entry_size = sizeof(int);
+        attr.key_size = sizeof(int);
+        attr.allocate_memory = test_counting_allocate;
+        attr.free_memory = free;
+        attr.cmp_key = test_key_com;
+        attr.key_to_number = test_key_to_int;
+        attr.index_type = index_types[t];
+
+        // Note: index is sized from max entry number, a small cache costs kilobytes
+        g_allocated_size = 0;
+        void* cache = libcache_create_ex(&attr);
+        CHECK(cache != NULL);
+        CHECK(g_allocated_size < 32 * 1024);
+
+        int i;
+        int dst = 0;
+        for (i = 0; i < 1000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        for (i = 900; i < 1000; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            CHECK_EQUAL(dst, i);
+        }
+        CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    }
+}
+
+TEST(TestResize)
+{
+    libcache_index_e index_types[] = { LIBCACHE_INDEX_CHAINED, LIBCACHE_INDEX_OPEN, LIBCACHE_INDEX_GROUP,
+            LIBCACHE_INDEX_GROUP_COMPACT };
+    size_t t;
+    for (t = 0; t < sizeof(index_types) / sizeof(index_types[0]); t++) {
+        libcache_attr_t attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.max_entry_number = 1000;
+        attr.entry_size = sizeof(int);
+        attr.key_size = sizeof(int);
+        attr.allocate_memory = malloc;
+        attr.free_memory = free;
+        attr.cmp_key = test_key_com;
+        attr.key_to_number = test_key_to_int;
+        attr.index_type = index_types[t];
+        void* cache = libcache_create_ex(&attr);
+        CHECK(cache != NULL);
+
+        int i;
+        int dst = 0;
+        for (i = 0; i < 1000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        i = 0;
+        int* locked = (int*) libcache_lookup(cache, &i, NULL);
+        CHECK(locked != NULL);
+
+        // Note: grow, entries are found in either memory while they're moved
+        CHECK(libcache_resize(cache, 4000) == LIBCACHE_SUCCESS);
+        CHECK_EQUAL(libcache_get_max_entry_number(cache), 4000U);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 1000U);
+        i = 999;
+        CHECK(libcache_add(cache, &i, &i) == NULL);
+        for (i = 999; i >= 500; i--) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            CHECK_EQUAL(dst, i);
+        }
+        CHECK(libcache_peek(cache, &i, &dst) != NULL);
+        for (i = 1000; i < 3000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK_EQUAL(libcache_get_entry_number(cache), 3000U);
+
+        // Note: the locked entry stays in old memory until it's unlocked
+        CHECK(libcache_resize(cache, 4000) == LIBCACHE_LOCKED);
+        CHECK(libcache_unlock_entry(cache, locked) == LIBCACHE_SUCCESS);
+        CHECK(libcache_unlock_entry(cache, locked) == LIBCACHE_UNLOCKED);
+        CHECK(libcache_resize(cache, 4000) == LIBCACHE_SUCCESS);
+        for (i = 0; i < 3000; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            CHECK_EQUAL(dst, i);
+        }
+
+        // Note: shrink, keys hit meanwhile survive, old memory is freed after enough operations
+        CHECK(libcache_resize(cache, 100) == LIBCACHE_SUCCESS);
+        int round;
+        for (round = 0; round < 10; round++) {
+            for (i = 2900; i < 3000; i++) {
+                CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            }
+        }
+        CHECK(libcache_get_entry_number(cache) <= 101U);
+        i = 2950;
+        CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+        CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_NOT_FOUND);
+        CHECK(libcache_resize(cache, 100) == LIBCACHE_SUCCESS);
+
+        // Note: a cache being resized can be cleaned and destroyed
+        CHECK(libcache_resize(cache, 200) == LIBCACHE_SUCCESS);
+        CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+        CHECK_EQUAL(libcache_get_entry_number(cache), 0U);
+        for (i = 0; i < 300; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        CHECK(libcache_resize(cache, 1000) == LIBCACHE_SUCCESS);
+        CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    }
+}
+
+static int g_released_entry_count = 0;
+
+static void test_count_release_entry(void* key, void* entry)
+{
+    (void) key;
+    (void) entry;
+    g_released_entry_count++;
+}
+
+TEST(TestResizeRelease)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 400;
+    attr.entry_size = 256;
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.entry_memory_size = 2 * 64 * 1024;
+    attr.release_entry = test_count_release_entry;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    char entry[256];
+    memset(entry, 0, sizeof(entry));
+    void* locked[401];
+    int i;
+    for (i = 0; i < 401; i++) {
+        CHECK(libcache_add_sized(cache, &i, entry, sizeof(entry)) != NULL);
+        locked[i] = libcache_lookup(cache, &i, NULL);
+        CHECK(locked[i] != NULL);
+    }
+
+    // Note: the new memory holds fewer entries than the new maximum, an entry unlocked moves at once as it's
+    //       found, once the new memory is full of locked entries the others are dropped as they're found
+    g_released_entry_count = 0;
+    CHECK(libcache_resize(cache, 300) == LIBCACHE_SUCCESS);
+    int moved = 0;
+    for (i = 0; i < 401; i++) {
+        CHECK(libcache_unlock_entry(cache, locked[i]) == LIBCACHE_SUCCESS);
+        locked[i] = libcache_lookup(cache, &i, NULL);
+        if (NULL != locked[i]) {
+            moved++;
+        }
+    }
+    CHECK(moved < 401);
+    CHECK_EQUAL(401 - moved, g_released_entry_count);
+    for (i = 0; i < 401; i++) {
+        if (NULL != locked[i]) {
+            CHECK(libcache_unlock_entry(cache, locked[i]) == LIBCACHE_SUCCESS);
+        }
+    }
+    CHECK(libcache_resize(cache, 300) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(401 - (int) libcache_get_entry_number(cache), g_released_entry_count);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestPinHandle)
+{
+    void* cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    int i;
+    for (i = 0; i < 10; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+
+    // Note: the pinned entry is read in place, unpinned and pinned again without a lookup
+    libcache_handle_t handle;
+    i = 3;
+    CHECK(libcache_pin(cache, &i, &handle) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(3, *(int*) handle.entry);
+    CHECK_EQUAL(sizeof(int), handle.entry_length);
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_LOCKED);
+    CHECK(libcache_unpin(cache, &handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &handle) == LIBCACHE_UNLOCKED);
+    CHECK(libcache_repin(cache, &handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, handle.entry) == LIBCACHE_SUCCESS);
+    i = 100;
+    CHECK(libcache_pin(cache, &i, &handle) == LIBCACHE_NOT_FOUND);
+    CHECK(handle.entry == NULL);
+
+    // Note: deleted, swapped out and cleaned entries make their handles stale, even if the record is reused
+    libcache_handle_t deleted, swapped, cleaned;
+    i = 4;
+    CHECK(libcache_pin(cache, &i, &deleted) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &deleted) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    CHECK(libcache_repin(cache, &deleted) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_unpin(cache, &deleted) == LIBCACHE_NOT_FOUND);
+    i = 0;
+    CHECK(libcache_pin(cache, &i, &swapped) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &swapped) == LIBCACHE_SUCCESS);
+    for (i = 10; i < 40; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK(libcache_repin(cache, &swapped) == LIBCACHE_NOT_FOUND);
+    i = 39;
+    CHECK(libcache_pin(cache, &i, &cleaned) == LIBCACHE_SUCCESS);
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &cleaned) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_repin(cache, &cleaned) == LIBCACHE_NOT_FOUND);
+
+    // Note: an entry pinned while the cache is resized is unpinned in old memory, a moved one is stale
+    libcache_handle_t moved;
+    for (i = 0; i < 10; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    i = 1;
+    CHECK(libcache_pin(cache, &i, &handle) == LIBCACHE_SUCCESS);
+    i = 2;
+    CHECK(libcache_pin(cache, &i, &moved) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &moved) == LIBCACHE_SUCCESS);
+    CHECK(libcache_resize(cache, 100) == LIBCACHE_SUCCESS);
+    int dst = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    CHECK(libcache_repin(cache, &moved) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_unpin(cache, &handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &handle) == LIBCACHE_UNLOCKED);
+    CHECK(libcache_resize(cache, 100) == LIBCACHE_SUCCESS);
+    CHECK(libcache_repin(cache, &handle) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_COMPACT);
+    CHECK(cache != NULL);
+    i = 1;
+    CHECK(libcache_add(cache, &i, &i) != NULL);
+    CHECK(libcache_pin(cache, &i, &handle) == LIBCACHE_FAILURE);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+static void* test_create_ttl_cache(libcache_scale_t max_entry_number)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.ttl = TRUE;
+    return libcache_create_ex(&attr);
+}
+
+TEST(TestTtl)
+{
+    void* cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    int i = 1;
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 10, NULL) == LIBCACHE_FAILURE);
+    CHECK_EQUAL(0, libcache_expire(cache, 100, 10));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_ttl_cache(10);
+    CHECK(cache != NULL);
+    for (i = 0; i < 5; i++) {
+        CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 10, NULL) == LIBCACHE_SUCCESS);
+    }
+    i = 5;
+    CHECK(libcache_add(cache, &i, &i) != NULL);
+    i = 6;
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 100, NULL) == LIBCACHE_SUCCESS);
+
+    // Note: entries are reclaimed once the clock reaches their expiry, up to budget a call
+    CHECK_EQUAL(0, libcache_expire(cache, 9, 100));
+    CHECK_EQUAL(2, libcache_expire(cache, 10, 2));
+    CHECK_EQUAL(3, libcache_expire(cache, 10, 100));
+    CHECK_EQUAL(2u, libcache_get_entry_number(cache));
+    int dst = -1;
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+    i = 5;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+
+    // Note: an expired entry isn't found even before it's reclaimed, the lookup frees it
+    i = 7;
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 5, NULL) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, libcache_expire(cache, 15, 0));
+    CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+    CHECK(libcache_peek(cache, &i, &dst) == NULL);
+    CHECK_EQUAL(2u, libcache_get_entry_number(cache));
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 5, NULL) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, libcache_expire(cache, 20, 0));
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 5, NULL) == LIBCACHE_SUCCESS);
+
+    // Note: a locked entry outlives its expiry, it's reclaimed after it's unlocked
+    void* entry = NULL;
+    i = 8;
+    CHECK(libcache_add_ttl(cache, &i, NULL, sizeof(int), 1, &entry) == LIBCACHE_SUCCESS);
+    *(int*) entry = i;
+    CHECK_EQUAL(1, libcache_expire(cache, 25, 100));
+    CHECK(libcache_lookup(cache, &i, NULL) == NULL);
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 1, NULL) == LIBCACHE_EXISTING);
+    CHECK(libcache_lookup_or_add(cache, &i, NULL) == NULL);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(1, libcache_expire(cache, 25, 100));
+    CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+
+    // Note: when the cache is full, an expired entry is swapped out before the LRU one
+    libcache_stats_t stats;
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    i = 100;
+    CHECK(libcache_add(cache, &i, &i) != NULL);
+    i = 110;
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 1, NULL) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, libcache_expire(cache, 26, 0));
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    unsigned long long expirations = stats.expirations;
+    libcache_scale_t count = 0;
+    for (i = 101; count != libcache_get_entry_number(cache); i++) {
+        count = libcache_get_entry_number(cache);
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(expirations + 1, stats.expirations);
+    CHECK_EQUAL(0ULL, stats.evictions);
+    i = 100;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+
+    // Note: long ttls, even beyond the wheel, expire at their tick, the clock is kept by clean
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    const uint32_t ttls[] = { 5000, 300000, 20000000 };
+    for (i = 0; i < 3; i++) {
+        CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), ttls[i], NULL) == LIBCACHE_SUCCESS);
+    }
+    for (i = 0; i < 3; i++) {
+        CHECK_EQUAL(0, libcache_expire(cache, 26 + ttls[i] - 1, 100));
+        CHECK_EQUAL(1, libcache_expire(cache, 26 + ttls[i], 100));
+        CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+    }
+
+    // Note: moved entries keep their expiry
+    uint32_t now = 26 + ttls[2];
+    for (i = 0; i < 5; i++) {
+        CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 10 + i, NULL) == LIBCACHE_SUCCESS);
+    }
+    CHECK(libcache_resize(cache, 100) == LIBCACHE_SUCCESS);
+    i = 9;
+    CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 11, NULL) == LIBCACHE_SUCCESS);
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    CHECK_EQUAL(1, libcache_expire(cache, now + 10, 100));
+    CHECK_EQUAL(2, libcache_expire(cache, now + 11, 100));
+    CHECK_EQUAL(3, libcache_expire(cache, now + 100, 100));
+    CHECK_EQUAL(0u, libcache_get_entry_number(cache));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 10;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    attr.ttl = TRUE;
+    CHECK(libcache_create_ex(&attr) == NULL);
+}
+
+TEST(TestSaveLoad)
+{
+    const char* path = "/tmp/libcache_ut.image";
+    void* cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    int i;
+    for (i = 0; i < 10; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    int dst = -1;
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    i = 5;
+    void* locked = libcache_lookup(cache, &i, NULL);
+    CHECK(locked != NULL);
+    CHECK(libcache_save(cache, path) == LIBCACHE_SUCCESS);
+
+    // Note: the saved cache keeps its LRU order, 1 is the coldest
+    CHECK(libcache_unlock_entry(cache, locked) == LIBCACHE_SUCCESS);
+    int key = 10;
+    i = 1;
+    while (NULL != libcache_peek(cache, &i, &dst)) {
+        CHECK(libcache_add(cache, &key, &key) != NULL);
+        key++;
+    }
+    i = 2;
+    CHECK(libcache_peek(cache, &i, &dst) != NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 10;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    cache = libcache_load(path, &attr);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(10u, libcache_get_entry_number(cache));
+    for (i = 0; i < 10; i++) {
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(i, dst);
+    }
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    // Note: a smaller cache keeps the hottest entries, the locked one was the hottest
+    attr.max_entry_number = 4;
+    cache = libcache_load(path, &attr);
+    CHECK(cache != NULL);
+    const int hottest[] = { 5, 0, 9, 8 };
+    for (i = 0; i < 4; i++) {
+        CHECK(libcache_peek(cache, &hottest[i], &dst) != NULL);
+    }
+    for (i = 1; i < 4; i++) {
+        CHECK(libcache_peek(cache, &i, &dst) == NULL);
+    }
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    attr.key_size = 8;
+    CHECK(libcache_load(path, &attr) == NULL);
+    attr.key_size = sizeof(int);
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    CHECK(libcache_load(path, &attr) == NULL);
+    attr.engine = LIBCACHE_ENGINE_POOL;
+    CHECK(libcache_load("/tmp/libcache_ut.missing", &attr) == NULL);
+    CHECK(truncate(path, 100) == 0);
+    CHECK(libcache_load(path, &attr) == NULL);
+
+    // Note: expiry and the clock are saved, expired entries aren't loaded
+    cache = test_create_ttl_cache(10);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(0, libcache_expire(cache, 1000, 10));
+    for (i = 0; i < 3; i++) {
+        CHECK(libcache_add_ttl(cache, &i, &i, sizeof(int), 10 * i, NULL) == LIBCACHE_SUCCESS);
+    }
+    CHECK(libcache_save(cache, path) == LIBCACHE_SUCCESS);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    attr.max_entry_number = 10;
+    attr.ttl = TRUE;
+    cache = libcache_load(path, &attr);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(3u, libcache_get_entry_number(cache));
+    CHECK_EQUAL(1, libcache_expire(cache, 1010, 10));
+    CHECK_EQUAL(1, libcache_expire(cache, 1020, 10));
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    remove(path);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_COMPACT);
+    CHECK(libcache_save(cache, path) == LIBCACHE_FAILURE);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestSaveStart)
+{
+    const char* path = "/tmp/libcache_ut_start.image";
+    void* cache = test_create_cache(100, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    int i;
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    int pid = -1;
+    CHECK(libcache_save_start(cache, path, &pid) == LIBCACHE_SUCCESS);
+    CHECK(pid > 0);
+
+    // Note: writes after the start aren't in the image
+    for (i = 0; i < 50; i += 2) {
+        CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    }
+    for (i = 50; i < 100; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    libcache_ret_t ret = LIBCACHE_LOCKED;
+    while (LIBCACHE_LOCKED == (ret = libcache_save_wait(pid, FALSE))) {
+        usleep(1000);
+    }
+    CHECK(ret == LIBCACHE_SUCCESS);
+    CHECK(libcache_save_wait(pid, TRUE) == LIBCACHE_FAILURE);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 100;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    cache = libcache_load(path, &attr);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(50u, libcache_get_entry_number(cache));
+    int dst = -1;
+    for (i = 0; i < 50; i++) {
+        CHECK(libcache_peek(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(i, dst);
+    }
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    remove(path);
+
+    CHECK(libcache_save_start(NULL, path, &pid) == LIBCACHE_FAILURE);
+}
+
+static int test_load_calls = 0;
+
+static int test_load_entry(const void* key, void* entry, size_t* entry_length)
+{
+    test_load_calls++;
+    int k = *(const int*) key;
+    if (k < 0) {
+        return FALSE;
+    }
+    *(int*) entry = k * 10;
+    *entry_length = sizeof(int);
+    return TRUE;
+}
+
+TEST(TestLookupOrLoad)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 10;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.load_entry = test_load_entry;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    // Note: a miss is loaded once, then it's a hit
+    test_load_calls = 0;
+    int key = 3;
+    int loaded = FALSE;
+    int* entry = (int*) libcache_lookup_or_load(cache, &key, &loaded);
+    CHECK(entry != NULL && loaded && *entry == 30);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    entry = (int*) libcache_lookup_or_load(cache, &key, &loaded);
+    CHECK(entry != NULL && !loaded && *entry == 30);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(1, test_load_calls);
+
+    // Note: a failed load leaves nothing
+    key = -1;
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK(!loaded);
+    CHECK_EQUAL(1u, libcache_get_entry_number(cache));
+
+    // Note: a second miss of a key being loaded waits for it, the placeholder is missing meanwhile
+    key = 4;
+    void* placeholder = NULL;
+    void* waiter = NULL;
+    int dst = 0;
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_load_begin(cache, &key, &waiter) == LIBCACHE_LOCKED);
+    CHECK(placeholder == waiter);
+    CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+    CHECK(libcache_peek(cache, &key, &dst) == NULL);
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK(libcache_add(cache, &key, &dst) == NULL);
+    CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_LOCKED);
+    *(int*) placeholder = 44;
+    CHECK(libcache_load_end(cache, placeholder, sizeof(int), TRUE) == LIBCACHE_SUCCESS);
+    CHECK(libcache_load_end(cache, placeholder, sizeof(int), TRUE) == LIBCACHE_FAILURE);
+    CHECK(libcache_load_wait(waiter) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, waiter) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, placeholder) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &key, &dst) != NULL);
+    CHECK_EQUAL(44, dst);
+
+    // Note: a failed load is freed by the last waiter
+    key = 5;
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_load_begin(cache, &key, &waiter) == LIBCACHE_LOCKED);
+    CHECK(libcache_load_end(cache, placeholder, 0, FALSE) == LIBCACHE_FAILURE);
+    CHECK_EQUAL(3u, libcache_get_entry_number(cache));
+    CHECK(libcache_load_wait(waiter) == LIBCACHE_FAILURE);
+    CHECK(libcache_unlock_entry(cache, waiter) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(2u, libcache_get_entry_number(cache));
+    test_load_calls = 0;
+    entry = (int*) libcache_lookup_or_load(cache, &key, &loaded);
+    CHECK(entry != NULL && loaded && *entry == 50);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(1, test_load_calls);
+
+    libcache_stats_t stats;
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(5u, stats.loads);
+    CHECK_EQUAL(3u, stats.load_waits);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    attr.stats = LIBCACHE_STATS_NONE;
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    CHECK(libcache_create_ex(&attr) == NULL);
+}
+
+TEST(TestLoadWhileResizing)
+{
+    void* cache = test_create_cache(64, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+
+    // Note: the placeholder is locked, it stays in the cache being resized, a second miss still waits for it
+    int key = 9;
+    void* placeholder = NULL;
+    void* waiter = NULL;
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_resize(cache, 128) == LIBCACHE_SUCCESS);
+    CHECK(libcache_load_begin(cache, &key, &waiter) == LIBCACHE_LOCKED);
+    CHECK(placeholder == waiter);
+    int loaded = FALSE;
+    CHECK(libcache_lookup_or_add(cache, &key, &loaded) == NULL);
+    CHECK_EQUAL(1u, libcache_get_entry_number(cache));
+    *(int*) placeholder = 90;
+    CHECK(libcache_load_end(cache, placeholder, sizeof(int), TRUE) == LIBCACHE_SUCCESS);
+    CHECK(libcache_load_wait(waiter) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, waiter) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, placeholder) == LIBCACHE_SUCCESS);
+    int dst = 0;
+    CHECK(libcache_lookup(cache, &key, &dst) != NULL);
+    CHECK_EQUAL(90, dst);
+    CHECK_EQUAL(1u, libcache_get_entry_number(cache));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+static void test_load_done(libcache_load_waiter_t* waiter)
+{
+    (*(int*) waiter->data)++;
+}
+
+TEST(TestLookupAsync)
+{
+    void* cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    int fd = eventfd(0, EFD_NONBLOCK);
+    CHECK(fd > 0);
+    int calls = 0;
+    libcache_load_waiter_t loader, first, second;
+    memset(&loader, 0, sizeof(loader));
+    memset(&first, 0, sizeof(first));
+    first.done = test_load_done;
+    first.data = &calls;
+    first.eventfd = fd;
+    second = first;
+
+    // Note: the first miss loads, the next ones are queued without blocking
+    int key = 7;
+    CHECK(libcache_lookup_async(cache, &key, &loader) == LIBCACHE_NOT_FOUND);
+    CHECK(loader.handle.entry != NULL);
+    CHECK(libcache_lookup_async(cache, &key, &first) == LIBCACHE_LOCKED);
+    CHECK(libcache_lookup_async(cache, &key, &second) == LIBCACHE_LOCKED);
+    uint64_t count = 0;
+    CHECK(read(fd, &count, sizeof(count)) < 0);
+    CHECK_EQUAL(0, calls);
+
+    *(int*) loader.handle.entry = 70;
+    CHECK(libcache_load_complete(cache, &loader, sizeof(int), TRUE, NULL) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(2, calls);
+    CHECK(read(fd, &count, sizeof(count)) == (ssize_t) sizeof(count));
+    CHECK_EQUAL(2u, count);
+    CHECK(loader.result == LIBCACHE_SUCCESS && first.result == LIBCACHE_SUCCESS && second.result == LIBCACHE_SUCCESS);
+    CHECK(first.handle.entry == loader.handle.entry && second.handle.entry == loader.handle.entry);
+    CHECK_EQUAL((size_t) sizeof(int), first.handle.entry_length);
+    CHECK_EQUAL(70, *(int*) second.handle.entry);
+    CHECK(libcache_unpin(cache, &first.handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &second.handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &loader.handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unpin(cache, &loader.handle) == LIBCACHE_UNLOCKED);
+
+    // Note: a hit is pinned at once
+    CHECK(libcache_lookup_async(cache, &key, &first) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(70, *(int*) first.handle.entry);
+    CHECK(libcache_unpin(cache, &first.handle) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(2, calls);
+
+    // Note: waiters of a failed load get nothing, the placeholder is gone with them
+    key = 8;
+    libcache_load_waiter_t* waiters = NULL;
+    CHECK(libcache_lookup_async(cache, &key, &loader) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_lookup_async(cache, &key, &first) == LIBCACHE_LOCKED);
+    CHECK(libcache_load_complete(cache, &loader, 0, FALSE, &waiters) == LIBCACHE_FAILURE);
+    CHECK(waiters == &first && first.next == NULL);
+    CHECK(first.result == LIBCACHE_FAILURE && first.handle.entry == NULL && loader.handle.entry == NULL);
+    CHECK_EQUAL(1u, libcache_get_entry_number(cache));
+    CHECK_EQUAL(2, calls);
+    libcache_load_notify(waiters);
+    CHECK_EQUAL(3, calls);
+    CHECK(read(fd, &count, sizeof(count)) == (ssize_t) sizeof(count));
+    CHECK_EQUAL(1u, count);
+    CHECK(libcache_load_complete(cache, &loader, 0, FALSE, NULL) == LIBCACHE_FAILURE);
+    close(fd);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+static int test_flush_calls = 0;
+static int test_flushed_count = 0;
+static int test_flushed_keys[64];
+static int test_flushed_entries[64];
+
+static void test_flush_entries(const void* const keys[], const void* const entries[],
+        const size_t entry_lengths[], int count)
+{
+    test_flush_calls++;
+    int i;
+    for (i = 0; i < count && test_flushed_count < 64; i++) {
+        CHECK_EQUAL(sizeof(int), entry_lengths[i]);
+        test_flushed_keys[test_flushed_count] = *(const int*) keys[i];
+        test_flushed_entries[test_flushed_count] = *(const int*) entries[i];
+        test_flushed_count++;
+    }
+}
+
+TEST(TestFlushDirty)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 4;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    int key = 1;
+    int value = 10;
+    CHECK(libcache_add(cache, &key, &value) != NULL);
+    int* entry = (int*) libcache_lookup(cache, &key, NULL);
+    CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_FAILURE);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, libcache_flush(cache, 0));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    attr.flush_entries = test_flush_entries;
+    cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    test_flush_calls = 0;
+    test_flushed_count = 0;
+    for (key = 1; key <= 4; key++) {
+        value = key * 10;
+        CHECK(libcache_add(cache, &key, &value) != NULL);
+    }
+
+    // Note: entries changed many times are written once, a batch is sorted by key
+    int keys[] = { 4, 2, 3, 2 };
+    int i;
+    for (i = 0; i < 4; i++) {
+        entry = (int*) libcache_lookup(cache, &keys[i], NULL);
+        CHECK(entry != NULL);
+        (*entry)++;
+        CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+        CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+        CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(3, libcache_flush(cache, 0));
+    CHECK_EQUAL(1, test_flush_calls);
+    CHECK_EQUAL(3, test_flushed_count);
+    CHECK_EQUAL(2, test_flushed_keys[0]);
+    CHECK_EQUAL(22, test_flushed_entries[0]);
+    CHECK_EQUAL(3, test_flushed_keys[1]);
+    CHECK_EQUAL(31, test_flushed_entries[1]);
+    CHECK_EQUAL(4, test_flushed_keys[2]);
+    CHECK_EQUAL(41, test_flushed_entries[2]);
+    CHECK_EQUAL(0, libcache_flush(cache, 0));
+
+    // Note: budget limits a flush, the rest is left dirty
+    for (key = 1; key <= 3; key++) {
+        entry = (int*) libcache_lookup(cache, &key, NULL);
+        CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+        CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    }
+    test_flushed_count = 0;
+    CHECK_EQUAL(2, libcache_flush(cache, 2));
+    CHECK_EQUAL(1, test_flushed_keys[0]);
+    CHECK_EQUAL(2, test_flushed_keys[1]);
+
+    // Note: a deleted dirty entry is discarded, a swapped out one is written alone before it leaves
+    key = 4;
+    entry = (int*) libcache_lookup(cache, &key, NULL);
+    CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    test_flush_calls = 0;
+    test_flushed_count = 0;
+    for (key = 100; key < 120; key++) {
+        value = key;
+        CHECK(libcache_add(cache, &key, &value) != NULL);
+    }
+    key = 3;
+    CHECK(libcache_peek(cache, &key, &value) == NULL);
+    CHECK_EQUAL(1, test_flush_calls);
+    CHECK_EQUAL(1, test_flushed_count);
+    CHECK_EQUAL(3, test_flushed_keys[0]);
+    CHECK_EQUAL(31, test_flushed_entries[0]);
+    CHECK_EQUAL(0, libcache_flush(cache, 0));
+
+    libcache_stats_t stats;
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK(stats.flushes == 6);
+
+    // Note: a dirty entry moved by resize is still dirty
+    key = 119;
+    entry = (int*) libcache_lookup(cache, &key, NULL);
+    CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_resize(cache, 8) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &key, &value) != NULL);
+    test_flushed_count = 0;
+    CHECK_EQUAL(1, libcache_flush(cache, 0));
+    CHECK_EQUAL(119, test_flushed_keys[0]);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestFlushDirtyBytewise)
+{
+    // Note: a cache without cmp_key sorts a batch by the bytes of keys, small ints are in their order
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 4;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.flush_entries = test_flush_entries;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    test_flush_calls = 0;
+    test_flushed_count = 0;
+    int keys[] = { 4, 2, 3, 1 };
+    int i;
+    for (i = 0; i < 4; i++) {
+        int value = keys[i] * 10;
+        CHECK(libcache_add(cache, &keys[i], &value) != NULL);
+        int* entry = (int*) libcache_lookup(cache, &keys[i], NULL);
+        CHECK(entry != NULL);
+        CHECK(libcache_mark_dirty(cache, entry) == LIBCACHE_SUCCESS);
+        CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    }
+    CHECK_EQUAL(4, libcache_flush(cache, 0));
+    CHECK_EQUAL(1, test_flush_calls);
+    CHECK_EQUAL(4, test_flushed_count);
+    for (i = 0; i < 4; i++) {
+        CHECK_EQUAL(i + 1, test_flushed_keys[i]);
+        CHECK_EQUAL((i + 1) * 10, test_flushed_entries[i]);
+    }
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+static int test_evicted_calls = 0;
+static int test_evicted_count = 0;
+static int test_evicted_keys[64];
+static int test_evicted_entries[64];
+static libcache_evict_e test_evicted_reasons[64];
+
+static void test_evicted_entries_cb(const void* const keys[], const void* const entries[],
+        const size_t entry_lengths[], const libcache_evict_e reasons[], int count)
+{
+    test_evicted_calls++;
+    CHECK(count > 0 && count <= 4);
+    int i;
+    for (i = 0; i < count && test_evicted_count < 64; i++) {
+        CHECK_EQUAL(sizeof(int), entry_lengths[i]);
+        test_evicted_keys[test_evicted_count] = *(const int*) keys[i];
+        test_evicted_entries[test_evicted_count] = *(const int*) entries[i];
+        test_evicted_reasons[test_evicted_count] = reasons[i];
+        test_evicted_count++;
+    }
+}
+
+TEST(TestEvictedEntries)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 4;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.evicted_entries = test_evicted_entries_cb;
+    attr.eviction_batch = 4;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    test_evicted_calls = 0;
+    test_evicted_count = 0;
+    int key = 0;
+    int value = 0;
+    for (key = 1; key <= 4; key++) {
+        value = key * 10;
+        CHECK(libcache_add(cache, &key, &value) != NULL);
+    }
+
+    // Note: a delete is queued, it's delivered by a drain
+    key = 2;
+    CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, test_evicted_calls);
+    CHECK_EQUAL(1, libcache_drain_evictions(cache));
+    CHECK_EQUAL(1, test_evicted_calls);
+    CHECK_EQUAL(2, test_evicted_keys[0]);
+    CHECK_EQUAL(20, test_evicted_entries[0]);
+    CHECK(LIBCACHE_EVICT_DELETED == test_evicted_reasons[0]);
+    CHECK_EQUAL(0, libcache_drain_evictions(cache));
+
+    // Note: swapped out entries are copied before their records are reused, a full batch is delivered at once
+    test_evicted_calls = 0;
+    test_evicted_count = 0;
+    for (key = 100; key < 120; key++) {
+        value = key;
+        CHECK(libcache_add(cache, &key, &value) != NULL);
+    }
+    int evicted = 3 + 20 - (int) libcache_get_entry_number(cache);
+    CHECK_EQUAL(evicted / 4 - (evicted % 4 == 0 ? 1 : 0), test_evicted_calls);
+    int drained = libcache_drain_evictions(cache);
+    CHECK_EQUAL(evicted, test_evicted_count);
+    CHECK(drained > 0 && drained <= 4);
+    CHECK_EQUAL(1, test_evicted_keys[0]);
+    CHECK_EQUAL(10, test_evicted_entries[0]);
+    CHECK_EQUAL(3, test_evicted_keys[1]);
+    CHECK_EQUAL(30, test_evicted_entries[1]);
+    int i;
+    for (i = 0; i < test_evicted_count; i++) {
+        CHECK(LIBCACHE_EVICT_SWAPPED == test_evicted_reasons[i]);
+        if (test_evicted_keys[i] >= 100) {
+            CHECK_EQUAL(test_evicted_keys[i], test_evicted_entries[i]);
+        }
+    }
+
+    // Note: destroy delivers what's left, entries destroyed aren't evicted
+    key = 120;
+    CHECK(libcache_add(cache, &key, &value) != NULL);
+    test_evicted_count = 0;
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(1, test_evicted_count);
+}
+
+TEST(TestNegativeCaching)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 64;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.negative_filter = TRUE;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    // Note: the filter follows adds, deletes, swap outs and resize, lookups see the same entries
+    int key = 0;
+    int value = 0;
+    for (key = 0; key < 100; key++) {
+        value = key;
+        CHECK(libcache_add(cache, &key, &value) != NULL);
+    }
+    for (key = 0; key < 100; key += 3) {
+        libcache_delete_by_key(cache, &key);
+    }
+    CHECK(libcache_resize(cache, 32) == LIBCACHE_SUCCESS);
+    for (key = 0; key < 100; key++) {
+        value = key;
+        if (0 == key % 5) {
+            libcache_add(cache, &key, &value);
+        }
+    }
+    int found = 0;
+    for (key = 0; key < 200; key++) {
+        if (NULL != libcache_peek(cache, &key, &value)) {
+            CHECK_EQUAL(key, value);
+            found++;
+        }
+    }
+    CHECK(found > 0);
+    CHECK_EQUAL((int) libcache_get_entry_number(cache), found);
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    key = 5;
+    CHECK(libcache_peek(cache, &key, &value) == NULL);
+    CHECK(libcache_add(cache, &key, &value) != NULL);
+    CHECK(libcache_peek(cache, &key, &value) != NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    // Note: a failed load is remembered for negative_ttl ticks
+    attr.negative_ttl = 10;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.ttl = TRUE;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.load_entry = test_load_entry;
+    cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    test_load_calls = 0;
+    key = -1;
+    int loaded = FALSE;
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK_EQUAL(1, test_load_calls);
+    CHECK(libcache_lookup(cache, &key, &value) == NULL);
+    void* placeholder = NULL;
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_FAILURE);
+    libcache_stats_t stats;
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK(stats.negative_hits == 2);
+    CHECK(stats.loads == 1);
+
+    // Note: it's loaded again once it expires
+    libcache_expire(cache, 10, 0);
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK_EQUAL(2, test_load_calls);
+    CHECK(libcache_expire(cache, 20, 100) == 1);
+    CHECK(libcache_lookup_or_load(cache, &key, &loaded) == NULL);
+    CHECK_EQUAL(3, test_load_calls);
+
+    // Note: an add of the key replaces its negative entry
+    value = 7;
+    CHECK(libcache_add(cache, &key, &value) != NULL);
+    int* entry = (int*) libcache_lookup_or_load(cache, &key, &loaded);
+    CHECK(entry != NULL && !loaded && 7 == *entry);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(3, test_load_calls);
+
+    // Note: a waiter of a load which fails gets the failure, the negative entry stays after it
+    key = -2;
+    void* waiter = NULL;
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_NOT_FOUND);
+    CHECK(libcache_load_begin(cache, &key, &waiter) == LIBCACHE_LOCKED);
+    CHECK(libcache_load_end(cache, placeholder, 0, FALSE) == LIBCACHE_FAILURE);
+    CHECK(libcache_load_wait(waiter) == LIBCACHE_FAILURE);
+    CHECK(libcache_unlock_entry(cache, waiter) == LIBCACHE_SUCCESS);
+    CHECK(libcache_load_begin(cache, &key, &placeholder) == LIBCACHE_FAILURE);
+    CHECK_EQUAL(2u, libcache_get_entry_number(cache));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+/*
+ * Scans the whole cache by batches of 3, every entry returned is counted in seen[key].
+ */
+static int test_scan_all(void* cache, int seen[], int keys, int add_from)
+{
+    libcache_scan_entry_t out[3];
+    uint64_t cursor = 0;
+    int calls = 0;
+    int add = add_from;
+    do {
+        int count = libcache_scan(cache, &cursor, 3, out);
+        int i;
+        for (i = 0; i < count; i++) {
+            int key = *(const int*) out[i].key;
+            if (key >= 0 && key < keys && *(const int*) out[i].entry == key && out[i].entry_length == sizeof(int)) {
+                seen[key]++;
+            }
+        }
+        // Note: entries are added and deleted between calls, and the cache is resized in the middle
+        if (add_from > 0 && add < keys) {
+            libcache_add(cache, &add, &add);
+            int deleted = add - add_from + 1;
+            if (deleted < 20) {
+                libcache_delete_by_key(cache, &deleted);
+            }
+            add++;
+        }
+        if (add_from > 0 && 5 == calls) {
+            libcache_resize(cache, 80);
+        }
+        calls++;
+    } while (0 != cursor);
+    return calls;
+}
+
+TEST(TestScan)
+{
+    void* cache = test_create_cache(64, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    uint64_t cursor = 0;
+    libcache_scan_entry_t out[3];
+    CHECK_EQUAL(0, libcache_scan(cache, &cursor, 3, out));
+    CHECK(0 == cursor);
+    CHECK_EQUAL(0, libcache_scan(cache, &cursor, 0, out));
+
+    int key = 0;
+    for (key = 0; key < 50; key++) {
+        CHECK(libcache_add(cache, &key, &key) != NULL);
+    }
+    for (key = 0; key < 50; key += 5) {
+        CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    }
+    // Note: a quiet cache is returned exactly once, locked entries too
+    static int seen[200];
+    memset(seen, 0, sizeof(seen));
+    key = 1;
+    int* locked = (int*) libcache_lookup(cache, &key, NULL);
+    CHECK(locked != NULL);
+    CHECK(test_scan_all(cache, seen, 200, 0) > 1);
+    for (key = 0; key < 50; key++) {
+        CHECK_EQUAL((0 == key % 5) ? 0 : 1, seen[key]);
+    }
+    CHECK(libcache_unlock_entry(cache, locked) == LIBCACHE_SUCCESS);
+
+    // Note: entries kept from the start to the end are returned at least once whatever changes meanwhile
+    memset(seen, 0, sizeof(seen));
+    test_scan_all(cache, seen, 200, 100);
+    for (key = 40; key < 50; key++) {
+        CHECK((0 == key % 5) ? 0 == seen[key] : seen[key] >= 1);
+    }
+    for (key = 0; key < 200; key++) {
+        CHECK(seen[key] <= 2);
+    }
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_COMPACT);
+    CHECK(cache != NULL);
+    cursor = 1;
+    CHECK_EQUAL(0, libcache_scan(cache, &cursor, 3, out));
+    CHECK(0 == cursor);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+typedef struct test_range_t {
+    int count;
+    int last;
+    int ordered;
+    int stop_after;
+} test_range_t;
+
+static int test_range_entry(const void* key, const void* entry, size_t entry_length, void* arg)
+{
+    test_range_t* range = (test_range_t*) arg;
+    int k = *(const int*) key;
+    if ((range->count > 0 && k <= range->last) || *(const int*) entry != k || sizeof(int) != entry_length) {
+        range->ordered = FALSE;
+    }
+    range->last = k;
+    return ++range->count != range->stop_after;
+}
+
+static int test_range(void* cache, const int* lo, const int* hi, int stop_after, test_range_t* range)
+{
+    memset(range, 0, sizeof(*range));
+    range->ordered = TRUE;
+    range->stop_after = stop_after;
+    return libcache_range(cache, lo, hi, test_range_entry, range);
+}
+
+TEST(TestRange)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 100;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.key_to_number = test_key_to_int;
+    attr.ordered = TRUE;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.cmp_key = test_key_com;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    test_range_t range;
+    CHECK_EQUAL(0, test_range(cache, NULL, NULL, 0, &range));
+
+    // Note: swapped out entries leave the tree along with the hash index
+    int key;
+    for (key = 299; key >= 0; key--) {
+        CHECK(libcache_add(cache, &key, &key) != NULL);
+    }
+    int count = (int) libcache_get_entry_number(cache);
+    CHECK_EQUAL(count, test_range(cache, NULL, NULL, 0, &range));
+    CHECK(range.ordered);
+    CHECK_EQUAL(count - 1, range.last);
+    int lo = 20;
+    int hi = 30;
+    CHECK_EQUAL(11, test_range(cache, &lo, &hi, 0, &range));
+    CHECK(range.ordered && 30 == range.last);
+    key = 25;
+    CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(10, test_range(cache, &lo, &hi, 0, &range));
+    CHECK_EQUAL(3, test_range(cache, &lo, NULL, 3, &range));
+    CHECK_EQUAL(22, range.last);
+
+    // Note: while it's resized, entries of both caches are given, each part in order
+    CHECK(libcache_resize(cache, 200) == LIBCACHE_SUCCESS);
+    for (key = 1000; key < 1010; key++) {
+        CHECK(libcache_add(cache, &key, &key) != NULL);
+    }
+    count = (int) libcache_get_entry_number(cache);
+    CHECK_EQUAL(count, test_range(cache, NULL, NULL, 0, &range));
+    lo = 1000;
+    CHECK_EQUAL(10, test_range(cache, &lo, NULL, 0, &range));
+    CHECK(range.ordered);
+
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(0, test_range(cache, NULL, NULL, 0, &range));
+    key = 5;
+    CHECK(libcache_add(cache, &key, &key) != NULL);
+    CHECK_EQUAL(1, test_range(cache, NULL, NULL, 0, &range));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(cache != NULL);
+    CHECK_EQUAL(-1, test_range(cache, NULL, NULL, 0, &range));
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+static uint32_t test_key_to_tag(const void* key)
+{
+    return *(const uint32_t*) key % 4;
+}
+
+TEST(TestInvalidateTag)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 100;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.tags = 4;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.key_to_tag = test_key_to_tag;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    CHECK(libcache_invalidate_tag(cache, 4) == LIBCACHE_FAILURE);
+    int key;
+    for (key = 0; key < 40; key++) {
+        CHECK(libcache_add(cache, &key, &key) != NULL);
+    }
+
+    // Note: entries of the tag are missing at once, they're reclaimed by the lookups finding them
+    CHECK(libcache_invalidate_tag(cache, 1) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(40u, libcache_get_entry_number(cache));
+    int dst = -1;
+    for (key = 0; key < 40; key++) {
+        CHECK_EQUAL(1 != key % 4, libcache_lookup(cache, &key, &dst) != NULL);
+    }
+    CHECK_EQUAL(30u, libcache_get_entry_number(cache));
+    libcache_stats_t stats;
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(10u, stats.expirations);
+
+    // Note: an entry added after the invalidation is valid, a locked stale one stays until it's unlocked
+    key = 1;
+    CHECK(libcache_add(cache, &key, &key) != NULL);
+    CHECK(libcache_lookup(cache, &key, &dst) != NULL && 1 == dst);
+    key = 3;
+    void* entry = libcache_lookup(cache, &key, NULL);
+    CHECK(entry != NULL);
+    CHECK(libcache_invalidate_tag(cache, 3) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+    CHECK(libcache_add(cache, &key, &key) == NULL);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_add(cache, &key, &key) != NULL);
+
+    // Note: while it's resized, the tag is invalidated in both caches
+    CHECK(libcache_resize(cache, 200) == LIBCACHE_SUCCESS);
+    CHECK(libcache_invalidate_tag(cache, 0) == LIBCACHE_SUCCESS);
+    for (key = 0; key < 40; key += 4) {
+        CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+    }
+    key = 2;
+    CHECK(libcache_lookup(cache, &key, &dst) != NULL && 2 == dst);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    cache = test_create_cache(10, LIBCACHE_ENGINE_POOL);
+    CHECK(libcache_invalidate_tag(cache, 0) == LIBCACHE_FAILURE);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+typedef struct test_session_t {
+    int teid;
+    int value;
+} test_session_t;
+
+static int test_extract_teid(const void* entry, size_t entry_length, void* key)
+{
+    const test_session_t* session = (const test_session_t*) entry;
+    if (entry_length < sizeof(test_session_t) || 0 == session->teid) {
+        return FALSE;
+    }
+    *(int*) key = session->teid;
+    return TRUE;
+}
+
+TEST(TestSecondaryIndex)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 4;
+    attr.entry_size = sizeof(test_session_t);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.secondary[1].key_size = sizeof(int);
+    attr.secondary[1].extract_key = test_extract_teid;
+    attr.secondary[1].cmp_key = test_key_com;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    // Note: an entry is found by its key and its teid, a teid is unique
+    int key = 0;
+    test_session_t session;
+    for (key = 1; key <= 3; key++) {
+        session.teid = key * 100;
+        session.value = key;
+        CHECK(libcache_add(cache, &key, &session) != NULL);
+    }
+    int teid = 200;
+    CHECK(libcache_lookup_by_index(cache, 1, &teid, &session) != NULL);
+    CHECK_EQUAL(2, session.value);
+    CHECK(libcache_lookup_by_index(cache, 0, &teid, &session) == NULL);
+    CHECK(libcache_lookup_by_index(cache, LIBCACHE_SECONDARY_INDEXES, &teid, &session) == NULL);
+    key = 9;
+    session.teid = 300;
+    CHECK(libcache_add(cache, &key, &session) == NULL);
+    CHECK_EQUAL(3u, libcache_get_entry_number(cache));
+    key = 2;
+    CHECK(libcache_delete_by_key(cache, &key) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup_by_index(cache, 1, &teid, &session) == NULL);
+
+    // Note: an entry written in place is reindexed, it keeps its teid if the new one is taken
+    key = 4;
+    int inserted = FALSE;
+    test_session_t* entry = (test_session_t*) libcache_lookup_or_add(cache, &key, &inserted);
+    CHECK(entry != NULL && inserted);
+    entry->teid = 400;
+    entry->value = 4;
+    teid = 400;
+    CHECK(libcache_lookup_by_index(cache, 1, &teid, &session) == NULL);
+    CHECK(libcache_reindex_entry(cache, entry) == LIBCACHE_SUCCESS);
+    entry->teid = 100;
+    CHECK(libcache_reindex_entry(cache, entry) == LIBCACHE_EXISTING);
+    entry->teid = 400;
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    test_session_t* locked = (test_session_t*) libcache_lookup_by_index(cache, 1, &teid, NULL);
+    CHECK(locked == entry);
+    CHECK(libcache_unlock_entry(cache, locked) == LIBCACHE_SUCCESS);
+
+    // Note: swapped out entries leave the secondary index, moved ones are in the new one
+    for (key = 10; key < 20; key++) {
+        session.teid = key * 100;
+        session.value = key;
+        CHECK(libcache_add(cache, &key, &session) != NULL);
+    }
+    CHECK(libcache_resize(cache, 8) == LIBCACHE_SUCCESS);
+    for (key = 20; key < 22; key++) {
+        session.teid = key * 100;
+        session.value = key;
+        CHECK(libcache_add(cache, &key, &session) != NULL);
+    }
+    int found = 0;
+    for (key = 1; key < 22; key++) {
+        teid = key * 100;
+        test_session_t by_key;
+        if (NULL != libcache_lookup_by_index(cache, 1, &teid, &session)) {
+            found++;
+            CHECK_EQUAL(key, session.value);
+            CHECK(libcache_peek(cache, &key, &by_key) != NULL);
+        } else {
+            CHECK(libcache_peek(cache, &key, &by_key) == NULL);
+        }
+    }
+    CHECK_EQUAL((int) libcache_get_entry_number(cache), found);
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    teid = 2100;
+    CHECK(libcache_lookup_by_index(cache, 1, &teid, &session) == NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.engine = LIBCACHE_ENGINE_POOL;
+    attr.secondary[1].key_size = 0;
+    CHECK(libcache_create_ex(&attr) == NULL);
+}
+
+TEST(TestVariableSizeEntry)
+{
+    const libcache_scale_t max_entry_number = 10000;
+    const size_t max_entry_size = 512;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = max_entry_number;
+    attr.entry_size = max_entry_size;
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = test_counting_allocate;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.index_type = LIBCACHE_INDEX_OPEN;
+
+    g_allocated_size = 0;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    size_t fixed_size = g_allocated_size;
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+
+    // Note: most entries are small, slab memory is sized for them
+    attr.entry_memory_size = max_entry_number * 64 + 64 * 1024 * 4;
+    g_allocated_size = 0;
+    cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    CHECK(g_allocated_size * 2 < fixed_size);
+
+    char src[512];
+    char dst[512];
+    size_t length = 0;
+    int i;
+    for (i = 0; i < 100; i++) {
+        size_t entry_length = (i % 10 == 0) ? max_entry_size : 48;
+        memset(src, i, sizeof(src));
+        char* entry = (char*) libcache_add_sized(cache, &i, src, entry_length);
+        CHECK(entry != NULL);
+        CHECK_EQUAL(*(const int*) libcache_get_entry_key(entry), i);
+    }
+    CHECK(libcache_add_sized(cache, &i, src, max_entry_size + 1) == NULL);
+    for (i = 0; i < 100; i++) {
+        memset(dst, 0xFF, sizeof(dst));
+        CHECK(libcache_lookup_sized(cache, &i, dst, &length) == dst);
+        CHECK_EQUAL(length, (i % 10 == 0) ? max_entry_size : 48);
+        CHECK(dst[0] == (char) i && dst[length - 1] == (char) i);
+        CHECK(length == max_entry_size || dst[length] == (char) 0xFF);
+    }
+
+    // Note: locked entries can be deleted by entry, their memory is reused
+    i = 1000;
+    char* entry = (char*) libcache_add_sized(cache, &i, NULL, 48);
+    CHECK(entry != NULL);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_add_sized(cache, &i, src, 48) == entry);
+
+    // Note: large entries swap small ones out when slab memory is used up
+    for (i = 2000; i < 12000; i++) {
+        CHECK(libcache_add_sized(cache, &i, src, max_entry_size) != NULL);
+    }
+    CHECK(libcache_get_entry_number(cache) < 2000);
+    i = 11999;
+    CHECK(libcache_lookup_sized(cache, &i, dst, &length) != NULL);
+    CHECK_EQUAL(length, max_entry_size);
+    CHECK(libcache_add(cache, &i, src) == NULL);
+    i = 12000;
+    CHECK(libcache_add(cache, &i, src) != NULL);
+    CHECK(libcache_lookup_sized(cache, &i, dst, &length) != NULL);
+    CHECK_EQUAL(length, max_entry_size);
+
+    CHECK(libcache_clean(cache) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(libcache_get_entry_number(cache), 0);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+/*
+ *  @brief test_session_blob  fills a session-like entry, an APN string and repeated IEs.
+ */
+static void test_session_blob(char* entry, size_t length, int id)
+{
+    size_t i;
+    for (i = 0; i < length; i++) {
+        entry[i] = "internet.mnc001.mcc460.gprs"[i % 27];
+    }
+    memcpy(entry, &id, sizeof(id));
+    memcpy(entry + length - sizeof(id), &id, sizeof(id));
+}
+
+/*
+ *  @brief test_compressed_count  adds compressible entries of 512 bytes until the slabs are full.
+ */
+static int test_compressed_count(size_t compress_threshold)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 20000;
+    attr.entry_size = 512;
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.entry_memory_size = 64 * 1024 * 16;
+    attr.compress_threshold = compress_threshold;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    char src[512];
+    int i;
+    for (i = 0; i < 20000; i++) {
+        test_session_blob(src, sizeof(src), i);
+        CHECK(libcache_add_sized(cache, &i, src, sizeof(src)) != NULL);
+    }
+    int count = (int) libcache_get_entry_number(cache);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    return count;
+}
+
+static int g_compressed_evicted;
+
+static void test_compressed_evicted(const void* const keys[], const void* const entries[],
+        const size_t entry_lengths[], const libcache_evict_e reasons[], int count)
+{
+    char expected[512];
+    int i;
+    for (i = 0; i < count; i++) {
+        test_session_blob(expected, sizeof(expected), *(const int*) keys[i]);
+        CHECK(0 == memcmp(expected, entries[i], entry_lengths[i]));
+        g_compressed_evicted++;
+    }
+    (void) reasons;
+}
+
+TEST(TestCompressedEntry)
+{
+    // Note: the same memory holds several times as many compressed entries
+    int raw_count = test_compressed_count(0);
+    int compressed_count = test_compressed_count(256);
+    CHECK(compressed_count > 3 * raw_count);
+
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = 512;
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.compress_threshold = 256;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.entry_memory_size = 64 * 1024 * 8;
+    attr.release_entry = test_check_free_entry;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.release_entry = NULL;
+    attr.evicted_entries = test_compressed_evicted;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    char src[512];
+    char dst[512];
+    size_t length = 0;
+    int i;
+    for (i = 0; i < 100; i++) {
+        test_session_blob(src, sizeof(src), i);
+        CHECK(libcache_add_sized(cache, &i, src, (i % 2) ? sizeof(src) : 128) != NULL);
+    }
+    for (i = 0; i < 100; i++) {
+        test_session_blob(src, sizeof(src), i);
+        memset(dst, 0, sizeof(dst));
+        CHECK(libcache_lookup_sized(cache, &i, dst, &length) == dst);
+        CHECK_EQUAL((i % 2) ? sizeof(src) : 128, length);
+        CHECK(0 == memcmp(src, dst, length));
+        memset(dst, 0, sizeof(dst));
+        CHECK(libcache_peek(cache, &i, dst) == dst);
+        CHECK(0 == memcmp(src, dst, length));
+    }
+
+    // Note: an entry below the threshold, or one which isn't compressible, is stored as it is
+    i = 100;
+    test_session_blob(src, sizeof(src), i);
+    char* entry = (char*) libcache_add_sized(cache, &i, src, 128);
+    CHECK(entry != NULL && 0 == memcmp(entry, src, 128));
+    i = 101;
+    int j;
+    for (j = 0; j < (int) sizeof(src); j++) {
+        src[j] = (char) (j * 131 + (j >> 3) * 71 + (j * j >> 5));
+    }
+    entry = (char*) libcache_add_sized(cache, &i, src, sizeof(src));
+    CHECK(entry != NULL && 0 == memcmp(entry, src, sizeof(src)));
+
+    // Note: an entry used by pointer is decompressed in place, it stays so
+    i = 1;
+    test_session_blob(src, sizeof(src), i);
+    entry = (char*) libcache_lookup(cache, &i, NULL);
+    CHECK(entry != NULL && 0 == memcmp(entry, src, sizeof(src)));
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &i, NULL) == entry);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+
+    // Note: resized and evicted entries are decompressed
+    uint64_t cursor = 0;
+    libcache_scan_entry_t out[4];
+    CHECK_EQUAL(0, libcache_scan(cache, &cursor, 4, out));
+    CHECK(libcache_resize(cache, 2000) == LIBCACHE_SUCCESS);
+    for (i = 0; i < 100; i++) {
+        test_session_blob(src, sizeof(src), i);
+        CHECK(libcache_lookup_sized(cache, &i, dst, &length) == dst);
+        CHECK(0 == memcmp(src, dst, length));
+    }
+    g_compressed_evicted = 0;
+    for (i = 0; i < 100; i++) {
+        CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    }
+    CHECK(libcache_drain_evictions(cache) >= 0);
+    CHECK_EQUAL(100, g_compressed_evicted);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+#define TEST_TIER_PATH "/tmp/libcache_tier_cache_ut.log"
+#define TEST_TIER_ENTRY_SIZE 4096
+
+TEST(TestColdTier)
+{
+    void* tier = libcache_tier_create(TEST_TIER_PATH, LIBCACHE_TIER_SEGMENT_SIZE * 4, 1000, TEST_TIER_ENTRY_SIZE);
+    CHECK(tier != NULL);
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 16;
+    attr.entry_size = TEST_TIER_ENTRY_SIZE / 2;
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    attr.cold_tier = tier;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.entry_size = TEST_TIER_ENTRY_SIZE;
+    attr.release_entry = test_check_free_entry;
+    CHECK(libcache_create_ex(&attr) == NULL);
+    attr.release_entry = NULL;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    // Note: entries swapped out are demoted, the first segment of them is in the file
+    static char src[TEST_TIER_ENTRY_SIZE];
+    int entries_per_segment = LIBCACHE_TIER_SEGMENT_SIZE / TEST_TIER_ENTRY_SIZE;
+    int count = entries_per_segment + 32;
+    int i;
+    for (i = 0; i < count; i++) {
+        test_session_blob(src, sizeof(src), i);
+        CHECK(libcache_add(cache, &i, src) != NULL);
+    }
+    libcache_scale_t demoted = (libcache_scale_t) count - libcache_get_entry_number(cache);
+    libcache_stats_t stats;
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(demoted, (libcache_scale_t) stats.demotions);
+    CHECK_EQUAL(demoted, libcache_tier_get_entry_number(tier));
+
+    // Note: a lookup misses, a load promotes the entry instead of loading it
+    i = 0;
+    void* entry = NULL;
+    CHECK(libcache_lookup(cache, &i, NULL) == NULL);
+    CHECK(libcache_load_begin(cache, &i, &entry) == LIBCACHE_SUCCESS);
+    test_session_blob(src, sizeof(src), i);
+    CHECK(0 == memcmp(entry, src, sizeof(src)));
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &i, NULL) == entry);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    size_t length = 0;
+    CHECK(!libcache_tier_read(tier, &i, sizeof(i), src, &length));
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK(1 == stats.promotions && 0 == stats.loads);
+
+    // Note: an asynchronous lookup is told where the entry is in the file, it's removed once it's loaded
+    libcache_load_waiter_t loader;
+    memset(&loader, 0, sizeof(loader));
+    i = 1;
+    CHECK(libcache_lookup_async(cache, &i, &loader) == LIBCACHE_NOT_FOUND);
+    CHECK(loader.tier_offset >= 0);
+    CHECK_EQUAL((size_t) TEST_TIER_ENTRY_SIZE, loader.tier_length);
+    CHECK(pread(libcache_tier_get_fd(tier), loader.handle.entry, loader.tier_length, loader.tier_offset)
+            == (ssize_t) loader.tier_length);
+    CHECK(libcache_load_complete(cache, &loader, loader.tier_length, TRUE, NULL) == LIBCACHE_SUCCESS);
+    test_session_blob(src, sizeof(src), i);
+    CHECK(0 == memcmp(loader.handle.entry, src, sizeof(src)));
+    CHECK(libcache_unpin(cache, &loader.handle) == LIBCACHE_SUCCESS);
+    CHECK(!libcache_tier_read(tier, &i, sizeof(i), src, &length));
+    i = (int) demoted - 1;
+    CHECK(libcache_lookup_async(cache, &i, &loader) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(-1, loader.tier_offset);
+    test_session_blob(src, sizeof(src), i);
+    CHECK(0 == memcmp(loader.handle.entry, src, sizeof(src)));
+    CHECK(libcache_unpin(cache, &loader.handle) == LIBCACHE_SUCCESS);
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK(2 == stats.promotions && 1 == stats.loads);
+
+    // Note: a delete or an add of a demoted key removes its entry
+    i = 2;
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_NOT_FOUND);
+    i = 3;
+    CHECK(libcache_add(cache, &i, src) != NULL);
+    CHECK(!libcache_tier_read(tier, &i, sizeof(i), src, &length));
+    i = 4;
+    CHECK(libcache_tier_read(tier, &i, sizeof(i), src, &length));
+
+    libcache_destroy(cache);
+    libcache_tier_destroy(tier);
+    unlink(TEST_TIER_PATH);
+}
+
+TEST(TestMappedMemory)
+{
+    libcache_page_e page_types[] = { LIBCACHE_PAGE_NORMAL, LIBCACHE_PAGE_TRANSPARENT,
+            LIBCACHE_PAGE_HUGE_2M, LIBCACHE_PAGE_HUGE_1G };
+    size_t p;
+    for (p = 0; p < sizeof(page_types) / sizeof(page_types[0]); p++) {
+        libcache_attr_t attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.max_entry_number = 10000;
+        attr.entry_size = sizeof(int);
+        attr.key_size = sizeof(int);
+        attr.cmp_key = test_key_com;
+        attr.key_to_number = test_key_to_int;
+        attr.page_type = page_types[p];
+        // Note: every system has NUMA node 0
+        attr.numa_node_mask = (p % 2 == 0) ? 0 : 1;
+
+        // Note: memory is mapped by cache, no allocate_memory / free_memory is needed
+        void* cache = libcache_create_ex(&attr);
+        CHECK(cache != NULL);
+        if (cache == NULL) {
+            continue;
+        }
+        // Note: huge pages may be unavailable, page type falls back, but never to user memory
+        CHECK(libcache_get_page_type(cache) != LIBCACHE_PAGE_USER);
+        CHECK(libcache_get_page_type(cache) <= page_types[p]);
+
+        int i;
+        int dst = 0;
+        for (i = 0; i < 20000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        i = 19999;
+        CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+        CHECK_EQUAL(dst, 19999);
+        CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    }
+
+    void* cache = libcache_create(10, sizeof(int), sizeof(int), malloc, free, NULL, test_key_com, test_key_to_int);
+    CHECK(libcache_get_page_type(cache) == LIBCACHE_PAGE_USER);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST(TestStats)
+{
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 4;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(int);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.cmp_key = test_key_com;
+    attr.key_to_number = test_key_to_int;
+
+    libcache_stats_t stats;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_FAILURE);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    attr.engine = LIBCACHE_ENGINE_COMPACT;
+    attr.stats = LIBCACHE_STATS_COUNTERS;
+    CHECK(libcache_create_ex(&attr) == NULL);
+
+    attr.engine = LIBCACHE_ENGINE_POOL;
+    attr.stats = LIBCACHE_STATS_LATENCY;
+    cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+    CHECK(libcache_get_stats(NULL, &stats) == LIBCACHE_FAILURE);
+    CHECK(libcache_get_stats(cache, NULL) == LIBCACHE_FAILURE);
+
+    // Note: 5 entries fit, the 6th and 7th swap out the coldest ones
+    int i;
+    int dst = 0;
+    for (i = 0; i < 7; i++) {
+        CHECK(libcache_add(cache, &i, &i) != NULL);
+    }
+    CHECK(libcache_add_ex(cache, &i, &i, sizeof(int), NULL) == LIBCACHE_SUCCESS);
+    CHECK(libcache_add_ex(cache, &i, &i, sizeof(int), NULL) == LIBCACHE_EXISTING);
+    i = 0;
+    CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+    i = 7;
+    CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+    void* entry = libcache_lookup(cache, &i, NULL);
+    CHECK(entry != NULL);
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_LOCKED);
+    CHECK(libcache_unlock_entry(cache, entry) == LIBCACHE_SUCCESS);
+    CHECK(libcache_delete_by_key(cache, &i) == LIBCACHE_SUCCESS);
+
+    CHECK(libcache_get_stats(cache, &stats) == LIBCACHE_SUCCESS);
+    CHECK_EQUAL(stats.lookup_hits, 2ULL);
+    CHECK_EQUAL(stats.lookup_misses, 1ULL);
+    CHECK_EQUAL(stats.adds, 8ULL);
+    CHECK_EQUAL(stats.add_existing, 1ULL);
+    CHECK_EQUAL(stats.add_full, 0ULL);
+    CHECK_EQUAL(stats.evictions, 3ULL);
+    CHECK_EQUAL(stats.deletes, 1ULL);
+    CHECK_EQUAL(stats.delete_locked, 1ULL);
+    CHECK_EQUAL(stats.entry_number, (libcache_scale_t) libcache_get_entry_number(cache));
+
+    // Note: adds and deletes probe the hash too, so there are at least as many probes as lookups
+    unsigned long long probes = 0;
+    unsigned long long lookup_latency = 0;
+    unsigned long long add_latency = 0;
+    for (i = 0; i < LIBCACHE_STATS_PROBE_BUCKETS; i++) {
+        probes += stats.probe_histogram[i];
+    }
+    for (i = 0; i < LIBCACHE_STATS_LATENCY_BUCKETS; i++) {
+        lookup_latency += stats.lookup_latency_ns[i];
+        add_latency += stats.add_latency_ns[i];
+    }
+    CHECK(probes >= stats.lookup_hits + stats.lookup_misses);
+    CHECK_EQUAL(lookup_latency, stats.lookup_hits + stats.lookup_misses);
+    CHECK_EQUAL(add_latency, stats.adds + stats.add_existing + stats.add_full);
+
+    char text[8192];
+    int length = libcache_stats_format(&stats, "imsi_cache", text, sizeof(text));
+    CHECK(length > 0 && length < (int) sizeof(text));
+    CHECK(strstr(text, "imsi_cache_lookup_hits_total 2\n") != NULL);
+    CHECK(strstr(text, "imsi_cache_evictions_total 3\n") != NULL);
+    CHECK(strstr(text, "imsi_cache_probes_bucket{le=\"+Inf\"}") != NULL);
+    CHECK(strstr(text, "imsi_cache_lookup_latency_seconds_count 3\n") != NULL);
+    // Note: a short buffer is cut, the length of the whole text is still returned
+    char short_text[16];
+    CHECK_EQUAL(libcache_stats_format(&stats, "imsi_cache", short_text, sizeof(short_text)), length);
+    CHECK_EQUAL(strlen(short_text), sizeof(short_text) - 1);
+    CHECK_EQUAL(libcache_stats_format(&stats, "imsi_cache", NULL, 0), length);
+
+    libcache_stats_t total;
+    memset(&total, 0, sizeof(total));
+    libcache_stats_merge(&total, &stats);
+    libcache_stats_merge(&total, &stats);
+    CHECK_EQUAL(total.adds, 2 * stats.adds);
+    CHECK_EQUAL(total.probe_histogram[1], 2 * stats.probe_histogram[1]);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
+
+TEST_ENGINES(TestBuiltinHash)
+{
+    libcache_hash_e hashers[] = { LIBCACHE_HASH_DEFAULT, LIBCACHE_HASH_WY, LIBCACHE_HASH_CRC32C };
+    size_t h;
+    for (h = 0; h < sizeof(hashers) / sizeof(hashers[0]); h++) {
+        libcache_attr_t attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.max_entry_number = 1000;
+        attr.entry_size = sizeof(int);
+        attr.key_size = sizeof(int);
+        attr.allocate_memory = malloc;
+        attr.free_memory = free;
+        attr.cmp_key = test_key_com;
+        attr.engine = g_engine;
+        attr.hash = hashers[h];
+        // Note: no key_to_number, the built-in hasher reads key_size bytes
+        void* cache = libcache_create_ex(&attr);
+        CHECK(cache != NULL);
+
+        int i;
+        int dst = 0;
+        for (i = 0; i < 1000; i++) {
+            CHECK(libcache_add(cache, &i, &i) != NULL);
+        }
+        for (i = 0; i < 1000; i++) {
+            CHECK(libcache_lookup(cache, &i, &dst) != NULL);
+            CHECK_EQUAL(dst, i);
+        }
+        i = 1000;
+        CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+        CHECK_EQUAL(libcache_delete_by_key(cache, &i), LIBCACHE_NOT_FOUND);
+        i = 500;
+        CHECK_EQUAL(libcache_delete_by_key(cache, &i), LIBCACHE_SUCCESS);
+        CHECK(libcache_lookup(cache, &i, &dst) == NULL);
+        CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+    }
+}
+
+TEST_ENGINES(TestBytewiseKey)
+{
+    // Note: 16-byte POD key without cmp_key and key_to_number, e.g. an IMSI and a session id
+    struct bytewise_key_t {
+        uint64_t imsi;
+        uint32_t session;
+        uint32_t padding;
+    } key;
+    libcache_attr_t attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.max_entry_number = 1000;
+    attr.entry_size = sizeof(int);
+    attr.key_size = sizeof(key);
+    attr.allocate_memory = malloc;
+    attr.free_memory = free;
+    attr.engine = g_engine;
+    void* cache = libcache_create_ex(&attr);
+    CHECK(cache != NULL);
+
+    memset(&key, 0, sizeof(key));
+    int i;
+    int dst = 0;
+    for (i = 0; i < 1000; i++) {
+        key.imsi = 460001000000000ULL + i;
+        key.session = (uint32_t) i;
+        CHECK(libcache_add(cache, &key, &i) != NULL);
+    }
+    for (i = 0; i < 1000; i++) {
+        key.imsi = 460001000000000ULL + i;
+        key.session = (uint32_t) i;
+        CHECK(libcache_lookup(cache, &key, &dst) != NULL);
+        CHECK_EQUAL(dst, i);
+        key.session++;
+        CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+    }
+    key.imsi = 460001000000007ULL;
+    key.session = 7;
+    CHECK_EQUAL(libcache_delete_by_key(cache, &key), LIBCACHE_SUCCESS);
+    CHECK(libcache_lookup(cache, &key, &dst) == NULL);
+    CHECK(libcache_destroy(cache) == LIBCACHE_SUCCESS);
+}
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #include "UnitTest++.h"
 #include "list.h"
@@ -86,6 +87,318 @@ TEST(libpool_ut_get_element)
         pool_free_element(pools, TEST_POOL_TYPE_DATA, entry_stack[i]);
     }
 
+    // Note: free elements are a stack, the last freed one is got first
+    for (i = entry_count - 1; i >= 0; i--) {
+        entry = pool_get_element(pools, TEST_POOL_TYPE_DATA);
+        CHECK(entry == entry_stack[i]);
+        CHECK_EQUAL((size_t) entry % 8, 0U);
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == NULL);
+
+    free(pools);
+}
+
+
+TEST(libpool_ut_aligned_element)
+{
+    const int entry_count = 25;
+
+    // Note: the 2nd pool starts after a pool of odd length
+    pool_attr_t pool_attr[] = {{4, 3}, {100, entry_count, 64}};
+    size_t large_mem_size = pool_caculate_total_length(TEST_POOL_TYPE_MAX, pool_attr);
+    void* large_mem = malloc(large_mem_size);
+    CHECK(large_mem != NULL);
+
+    void *pools = pools_init(large_mem, large_mem_size, TEST_POOL_TYPE_MAX, pool_attr);
+    CHECK(pools != NULL);
+
+    int i;
+    for (i = 0; i < entry_count; i++) {
+        char* entry = (char*) pool_get_element(pools, TEST_POOL_TYPE_2ND);
+        CHECK(entry != NULL);
+        CHECK_EQUAL((size_t) entry % 64, 0U);
+        CHECK(entry + 100 <= (char*) large_mem + large_mem_size);
+        CHECK(pool_set_reserved_pointer(entry, entry) == OK);
+        CHECK(pool_get_reserved_pointer(entry) == entry);
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_2ND) == NULL);
+
+    free(pools);
+}
+
+TEST(libpool_ut_lazy_element)
+{
+    const int entry_count = 1000;
+
+    pool_attr_t pool_attr[] = {{64, entry_count}};
+    const int pool_count = sizeof(pool_attr) / sizeof(pool_attr_t);
+    size_t large_mem_size = pool_caculate_total_length(pool_count, pool_attr);
+    unsigned char* large_mem = (unsigned char*) malloc(large_mem_size);
+    CHECK(large_mem != NULL);
+    memset(large_mem, 0xAB, large_mem_size);
+
+    void *pools = pools_init(large_mem, large_mem_size, pool_count, pool_attr);
+    CHECK(pools != NULL);
+
+    // Note: nothing after pool head is written before elements are got
+    size_t untouched = large_mem_size / 2;
+    size_t i;
+    int touched = 0;
+    for (i = large_mem_size - untouched; i < large_mem_size; i++) {
+        touched += (large_mem[i] != 0xAB);
+    }
+    CHECK_EQUAL(touched, 0);
+
+    // Note: a freed element is got again before a never used one
+    char* first = (char*) pool_get_element(pools, TEST_POOL_TYPE_DATA);
+    char* second = (char*) pool_get_element(pools, TEST_POOL_TYPE_DATA);
+    CHECK(first != NULL && second != NULL && first != second);
+    pool_free_element(pools, TEST_POOL_TYPE_DATA, first);
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == first);
+
+    int j;
+    for (j = 2; j < entry_count; j++) {
+        char* entry = (char*) pool_get_element(pools, TEST_POOL_TYPE_DATA);
+        CHECK(entry != NULL);
+        CHECK(pool_get_reserved_pointer(entry) == NULL);
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == NULL);
+    pool_free_element(pools, TEST_POOL_TYPE_DATA, second);
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == second);
+
+    free(pools);
+}
+
+TEST(libpool_ut_stats)
+{
+    const int entry_count = 10;
+
+    pool_attr_t pool_attr[] = {{20, entry_count}};
+    const int pool_count = sizeof(pool_attr) / sizeof(pool_attr_t);
+    size_t large_mem_size = pool_caculate_total_length(pool_count, pool_attr);
+    void* large_mem = malloc(large_mem_size);
+    void *pools = pools_init(large_mem, large_mem_size, pool_count, pool_attr);
+    CHECK(pools != NULL);
+
+    pool_stats_t stats;
+    CHECK(pool_get_stats(pools, TEST_POOL_TYPE_DATA, NULL) == ERR);
+    CHECK(pool_get_stats(pools, TEST_POOL_TYPE_DATA, &stats) == OK);
+    CHECK_EQUAL(stats.capacity, 10ULL);
+    CHECK_EQUAL(stats.in_use, 0ULL);
+    CHECK_EQUAL(stats.element_size, 24 + sizeof(element_usr_data_t));
+
+    void* entries[entry_count];
+    int i;
+    for (i = 0; i < 6; i++) {
+        entries[i] = pool_get_element(pools, TEST_POOL_TYPE_DATA);
+    }
+    for (i = 0; i < 4; i++) {
+        pool_free_element(pools, TEST_POOL_TYPE_DATA, entries[i]);
+    }
+    for (i = 0; i < 2; i++) {
+        entries[i] = pool_get_element(pools, TEST_POOL_TYPE_DATA);
+    }
+    CHECK(pool_get_stats(pools, TEST_POOL_TYPE_DATA, &stats) == OK);
+    CHECK_EQUAL(stats.in_use, 4ULL);
+    CHECK_EQUAL(stats.peak, 6ULL);
+    CHECK_EQUAL(stats.get_total, 8ULL);
+    CHECK_EQUAL(stats.free_total, 4ULL);
+    CHECK_EQUAL(stats.fail_total, 0ULL);
+
+    // Note: failures are counted when the pool is used up
+    while (pool_get_element(pools, TEST_POOL_TYPE_DATA) != NULL) {
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == NULL);
+    CHECK(pool_get_stats(pools, TEST_POOL_TYPE_DATA, &stats) == OK);
+    CHECK_EQUAL(stats.in_use, 10ULL);
+    CHECK_EQUAL(stats.peak, 10ULL);
+    CHECK_EQUAL(stats.fail_total, 2ULL);
+
+    // Note: a reset frees every element at once, the peak stays
+    pool_reset(pools, TEST_POOL_TYPE_DATA);
+    CHECK(pool_get_stats(pools, TEST_POOL_TYPE_DATA, &stats) == OK);
+    CHECK_EQUAL(stats.in_use, 0ULL);
+    CHECK_EQUAL(stats.peak, 10ULL);
+    CHECK_EQUAL(stats.get_total, stats.free_total);
+    for (i = 0; i < entry_count; i++) {
+        CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) != NULL);
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_DATA) == NULL);
+
+    free(pools);
+}
+
+TEST(libpool_ut_slab)
+{
+    const size_t max_element_size = 1000;
+    const size_t memory_size = 4 * POOL_SLAB_SIZE;
+    size_t length = pool_slab_caculate_length(memory_size, max_element_size);
+    void* memory = malloc(length);
+    CHECK(memory != NULL);
+    CHECK(pool_slab_init(memory, memory_size, 0) == NULL);
+    void* slab = pool_slab_init(memory, memory_size, max_element_size);
+    CHECK(slab != NULL);
+
+    // Note: an element is of the smallest class which holds it, classes grow by about 1.25
+    char* small = (char*) pool_slab_get_element(slab, 10);
+    CHECK(small != NULL);
+    CHECK_EQUAL(pool_slab_get_element_size(slab, small), (size_t) POOL_SLAB_MIN_SIZE);
+    char* medium = (char*) pool_slab_get_element(slab, 100);
+    CHECK(medium != NULL);
+    CHECK(pool_slab_get_element_size(slab, medium) >= 100);
+    CHECK(pool_slab_get_element_size(slab, medium) <= 125);
+    char* large = (char*) pool_slab_get_element(slab, max_element_size);
+    CHECK(large != NULL);
+    CHECK(pool_slab_get_element_size(slab, large) >= max_element_size);
+    CHECK(pool_slab_get_element(slab, max_element_size + 1) == NULL);
+    CHECK(((size_t) small | (size_t) medium | (size_t) large) % 8 == 0);
+
+    // Note: reserved pointer works on slab elements, and freed elements are reused first
+    CHECK(pool_set_reserved_pointer(medium, &slab) == OK);
+    CHECK(pool_get_reserved_pointer(medium) == &slab);
+    pool_slab_free_element(slab, medium);
+    CHECK(pool_slab_get_element(slab, 99) == medium);
+    CHECK(pool_get_reserved_pointer(medium) == NULL);
+    CHECK(pool_set_reserved_pointer(medium, &slab) == OK);
+    memset(medium, 0xAB, 100);
+    CHECK(pool_get_reserved_pointer(medium) == &slab);
+
+    // Note: the 4th slab is the last one, no other class can get memory once it's used up
+    int count = 0;
+    while (pool_slab_get_element(slab, 10) != NULL) {
+        count++;
+    }
+    CHECK(count >= (int) (POOL_SLAB_SIZE / (POOL_SLAB_MIN_SIZE + 16)) - 1);
+    CHECK(pool_slab_get_element(slab, 20) == NULL);
+    CHECK(pool_slab_get_element(slab, 100) != NULL);
+    pool_slab_free_element(slab, small);
+    CHECK(pool_slab_get_element(slab, 1) == small);
+
+    // Note: after a reset any class can take any slab again
+    pool_slab_reset(slab);
+    CHECK(pool_slab_get_element(slab, 20) != NULL);
+    CHECK(pool_slab_get_element(slab, max_element_size) != NULL);
+
+    free(memory);
+}
+
+TEST(libpool_ut_magazine)
+{
+    const int entry_count = 100;
+
+    pool_attr_t pool_attr[] = {{8, entry_count}, {8, entry_count}};
+    size_t large_mem_size = pool_caculate_total_length(TEST_POOL_TYPE_MAX, pool_attr);
+    void* large_mem = malloc(large_mem_size);
+    void *pools = pools_init(large_mem, large_mem_size, TEST_POOL_TYPE_MAX, pool_attr);
+    CHECK(pools != NULL);
+
+    void* depot = pool_depot_create(pools, TEST_POOL_TYPE_MAX, malloc, free);
+    CHECK(depot != NULL);
+    void* magazine = pool_magazine_create(depot);
+    CHECK(magazine != NULL);
+
+    void* entries[entry_count];
+    int i;
+    for (i = 0; i < entry_count; i++) {
+        entries[i] = pool_magazine_get_element(magazine, TEST_POOL_TYPE_2ND);
+        CHECK(entries[i] != NULL);
+        CHECK(pool_set_reserved_pointer(entries[i], entries[i]) == OK);
+    }
+    CHECK(pool_magazine_get_element(magazine, TEST_POOL_TYPE_2ND) == NULL);
+
+    // Note: an element freed into magazine is got again at once
+    pool_magazine_free_element(magazine, TEST_POOL_TYPE_2ND, entries[0]);
+    CHECK(pool_get_reserved_pointer(entries[0]) == NULL);
+    CHECK(pool_magazine_get_element(magazine, TEST_POOL_TYPE_2ND) == entries[0]);
+    for (i = 0; i < entry_count; i++) {
+        pool_magazine_free_element(magazine, TEST_POOL_TYPE_2ND, entries[i]);
+    }
+
+    // Note: destroyed magazines give all elements back to pool
+    pool_magazine_destroy(magazine);
+    pool_depot_destroy(depot);
+    for (i = 0; i < entry_count; i++) {
+        CHECK(pool_get_element(pools, TEST_POOL_TYPE_2ND) != NULL);
+    }
+    CHECK(pool_get_element(pools, TEST_POOL_TYPE_2ND) == NULL);
+    CHECK(pool_depot_create(NULL, TEST_POOL_TYPE_MAX, malloc, free) == NULL);
+
     free(pools);
 }
 
+#define TEST_MAGAZINE_THREADS 4
+#define TEST_MAGAZINE_ROUNDS 20000
+#define TEST_MAGAZINE_HOLD 50
+
+typedef struct magazine_worker_t {
+    void* depot;
+    int id;
+    int errors;
+} magazine_worker_t;
+
+static void* magazine_worker(void* arg)
+{
+    magazine_worker_t* worker = (magazine_worker_t*) arg;
+    void* magazine = pool_magazine_create(worker->depot);
+    int* held[TEST_MAGAZINE_HOLD];
+    int round;
+    int i;
+    for (round = 0; round < TEST_MAGAZINE_ROUNDS; round++) {
+        for (i = 0; i < TEST_MAGAZINE_HOLD; i++) {
+            held[i] = (int*) pool_magazine_get_element(magazine, TEST_POOL_TYPE_DATA);
+            if (held[i] == NULL) {
+                worker->errors++;
+                continue;
+            }
+            held[i][0] = worker->id;
+            held[i][1] = round;
+        }
+        // Note: an element held by this thread is never given to another one
+        for (i = 0; i < TEST_MAGAZINE_HOLD; i++) {
+            if (held[i] != NULL) {
+                if (held[i][0] != worker->id || held[i][1] != round) {
+                    worker->errors++;
+                }
+                pool_magazine_free_element(magazine, TEST_POOL_TYPE_DATA, held[i]);
+            }
+        }
+    }
+    pool_magazine_destroy(magazine);
+    return NULL;
+}
+
+TEST(libpool_ut_magazine_threads)
+{
+    // Note: magazines may cache up to 2 * POOL_MAGAZINE_SIZE free elements each
+    const int entry_count = TEST_MAGAZINE_THREADS * (TEST_MAGAZINE_HOLD + 2 * POOL_MAGAZINE_SIZE);
+
+    pool_attr_t pool_attr[] = {{2 * sizeof(int), entry_count}};
+    size_t large_mem_size = pool_caculate_total_length(1, pool_attr);
+    void* large_mem = malloc(large_mem_size);
+    void *pools = pools_init(large_mem, large_mem_size, 1, pool_attr);
+    void* depot = pool_depot_create(pools, 1, malloc, free);
+    CHECK(depot != NULL);
+
+    magazine_worker_t workers[TEST_MAGAZINE_THREADS];
+    pthread_t threads[TEST_MAGAZINE_THREADS];
+    int t;
+    for (t = 0; t < TEST_MAGAZINE_THREADS; t++) {
+        workers[t].depot = depot;
+        workers[t].id = t;
+        workers[t].errors = 0;
+        pthread_create(&threads[t], NULL, magazine_worker, &workers[t]);
+    }
+    for (t = 0; t < TEST_MAGAZINE_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        CHECK_EQUAL(workers[t].errors, 0);
+    }
+
+    int count = 0;
+    while (pool_get_element(pools, TEST_POOL_TYPE_DATA) != NULL) {
+        count++;
+    }
+    CHECK_EQUAL(count, entry_count);
+
+    pool_depot_destroy(depot);
+    free(pools);
+}